@@ -29,7 +29,7 @@ function(add_tng_io_library NAME)
     tng_generate_version_h()
 
     set(_tng_compression_sources
-        bwlzh.c bwt.c coder.c dict.c fixpoint.c huffman.c huffmem.c
+        bitstream.c bwlzh.c bwt.c coder.c dict.c fixpoint.c huffman.c huffmem.c
         lz77.c merge_sort.c mtf.c rle.c tng_compress.c vals16.c
         warnmalloc.c widemuldiv.c xtc2.c xtc3.c)
     set(_tng_io_sources tng_io.c md5.c)
@@ -103,6 +103,27 @@ function(add_tng_io_library NAME)
         set_property(SOURCE ${TNG_ROOT_SOURCE_DIR}/src/lib/tng_io.c
                      APPEND PROPERTY COMPILE_DEFINITIONS USE_STD_INTTYPES_H)
     endif()
+    if (TNG_USE_OPENMP)
+        # tng_io.c is compiled as C++, so it uses the C++ OpenMP target. The objects
+        # of an object library are compiled with OpenMP too, not only its users.
+        find_package(OpenMP COMPONENTS CXX)
+        if (OpenMP_CXX_FOUND)
+            if (ARG_OBJECT)
+                target_link_libraries(${NAME} PUBLIC OpenMP::OpenMP_CXX)
+            else()
+                target_link_libraries(${NAME} PRIVATE OpenMP::OpenMP_CXX)
+            endif()
+        endif()
+    endif()
+    if (TNG_USE_PTHREADS)
+        set(THREADS_PREFER_PTHREAD_FLAG ON)
+        find_package(Threads)
+        if (CMAKE_USE_PTHREADS_INIT)
+            set_property(SOURCE ${TNG_ROOT_SOURCE_DIR}/src/lib/tng_io.c
+                         APPEND PROPERTY COMPILE_DEFINITIONS TNG_USE_PTHREADS)
+            target_link_libraries(${NAME} ${_link_type} Threads::Threads)
+        endif()
+    endif()
     if (TNG_INTEGER_BIG_ENDIAN)
         set_property(SOURCE ${TNG_ROOT_SOURCE_DIR}/src/lib/md5.c
                      APPEND PROPERTY COMPILE_DEFINITIONS TNG_INTEGER_BIG_ENDIAN)
@@ -180,6 +180,10 @@ relevant block sections.
 6.  64 bit version of the block ^[[b]](#cmnt2)^(allows addition of more
     fields in the future to existing blocks, although old fields should
     never be removed, to allow older readers read new files)
+7.  64 bit alternative hash type (optional, 3 for XXH64)
+8.  64 bit length of the alternative hash (optional)
+9.  alternative hash (optional, written instead of the MD5 hash, which
+    is then left empty)
 
 4.  Description of blocks (each with a unique 64 bit identifier and a matching "name"):
     ===================================================================================
@@ -207,7 +211,10 @@ relevant block sections.
 2.  trajectory frames, velocities, block (10002) "VELOCITIES" (optional)
 3.  trajectory frames, forces, block (10003) "FORCES" (optional)
 
-6.  ...other specified blocks, both non-trajectory and trajectory
+6.  frame set index block "FRAME SET INDEX" (optional, after the
+    last frame set)
+
+7.  ...other specified blocks, both non-trajectory and trajectory
     blocks, each with unique id & name
 
 Data blocks can be used to store whatever data is needed. Data blocks
@@ -469,6 +476,23 @@ within a frame set, e.g. when faster parallel writes or memory
 considerations are needed. In that case a separate particle mapping
 block is needed for each of the trajectory/velocities etc. blocks.
 
+BLOCK: frame set index block
+----------------------------
+
+Optional. Written after the last frame set of the file (e.g. when the
+file is closed) to allow jumping directly to any frame set. An index
+that does not end at the last frame set of the file (e.g. if frame sets
+were appended after it was written) is ignored.
+
+1.  64 bit number of frame sets in the index (N)
+2.  For each frame set (N entries):
+
+1.  64 bit number of the frame set (zero based numbering)
+2.  64 bit number of first frame of the frame set
+3.  64 bit number of frames in the frame set
+4.  64 bit pointer to the “trajectory frame set block”
+5.  double (64 bit) time stamp of the first frame of the frame set
+
 Relation between trajectory blocks:
 ===================================
 
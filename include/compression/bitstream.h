@@ -0,0 +1,74 @@
+/*
+ * This code is part of the tng binary trajectory format.
+ *
+ * Copyright (c) 2020, by the GROMACS development team.
+ * TNG was orginally written by Magnus Lundborg, Daniel Spångberg and
+ * Rossen Apostolov. The API is implemented mainly by Magnus Lundborg,
+ * Daniel Spångberg and Anders Gärdenäs.
+ *
+ * Please see the AUTHORS file for more information.
+ *
+ * The TNG library is free software; you can redistribute it and/or
+ * modify it under the terms of the Revised BSD License.
+ *
+ * To help us fund future development, we humbly ask that you cite
+ * the research papers on the package.
+ *
+ * Check out http://www.gromacs.org for more information.
+ */
+
+/* This code is part of the tng compression routines
+ * Written by Daniel Spangberg
+ */
+
+#ifndef BITSTREAM_H
+#define BITSTREAM_H
+
+#include "my64bit.h"
+
+#ifndef DECLSPECDLLEXPORT
+#    ifdef USE_WINDOWS
+#        define DECLSPECDLLEXPORT __declspec(dllexport)
+#    else /* USE_WINDOWS */
+#        define DECLSPECDLLEXPORT
+#    endif /* USE_WINDOWS */
+#endif     /* DECLSPECDLLEXPORT */
+
+/* Reads a MSB first bitstream, such as the ones written by the coder,
+   a word at a time. Bytes are only loaded when the bits in them are
+   requested, so the reader never reads past the end of the stream. */
+struct bitreader
+{
+    unsigned char* ptr;    /* Next byte to load into the buffer. */
+    unsigned char* end;    /* Zeros are loaded from here on. NULL if the length is unknown. */
+    my_uint64_t    buffer; /* Loaded bits, the lowest nbits are valid. */
+    int            nbits;
+};
+
+void DECLSPECDLLEXPORT Ptngc_bitreader_init(struct bitreader* reader, unsigned char* input);
+
+/* Initialize a reader of a stream of known length. Peeking past the
+   end of the stream is allowed and returns zero bits. */
+void DECLSPECDLLEXPORT Ptngc_bitreader_init_bounded(struct bitreader* reader,
+                                                    unsigned char*    input,
+                                                    int               length);
+
+/* Make sure at least nbits (up to 32) bits are loaded. */
+void DECLSPECDLLEXPORT Ptngc_bitreader_refill(struct bitreader* reader, int nbits);
+
+/* Return the next nbits (up to 32) bits without consuming them. */
+unsigned int DECLSPECDLLEXPORT Ptngc_bitreader_peek(struct bitreader* reader, int nbits);
+
+/* Skip nbits bits. They must already have been loaded by peek or refill. */
+void DECLSPECDLLEXPORT Ptngc_bitreader_consume(struct bitreader* reader, int nbits);
+
+/* Read up to 32 bits. */
+unsigned int DECLSPECDLLEXPORT Ptngc_bitreader_read(struct bitreader* reader, int nbits);
+
+/* Read "arbitrary" number of bits into a byte buffer. The last byte
+   gets the remaining bits right aligned. */
+void DECLSPECDLLEXPORT Ptngc_bitreader_readmany(struct bitreader* reader,
+                                                int               nbits,
+                                                unsigned char*    buffer);
+
+#endif
@@ -29,10 +29,11 @@
    using bwlzh compression.  The unsigned char *output should be
    allocated to be able to hold worst case. You can obtain this length
    conveniently by calling comp_get_buflen()
+   Returns 0 on success and 1 on failure.
 */
-void DECLSPECDLLEXPORT bwlzh_compress(unsigned int* vals, int nvals, unsigned char* output, int* output_len);
+int DECLSPECDLLEXPORT bwlzh_compress(unsigned int* vals, int nvals, unsigned char* output, int* output_len);
 
-void DECLSPECDLLEXPORT bwlzh_compress_no_lz77(unsigned int* vals, int nvals, unsigned char* output, int* output_len);
+int DECLSPECDLLEXPORT bwlzh_compress_no_lz77(unsigned int* vals, int nvals, unsigned char* output, int* output_len);
 
 int DECLSPECDLLEXPORT bwlzh_get_buflen(int nvals);
 
@@ -42,12 +43,12 @@ void DECLSPECDLLEXPORT bwlzh_decompress(unsigned char* input, int nvals, unsigne
 /* The routines below are mostly useful for testing, and for internal
    use by the library. */
 
-void DECLSPECDLLEXPORT bwlzh_compress_verbose(unsigned int* vals, int nvals, unsigned char* output, int* output_len);
+int DECLSPECDLLEXPORT bwlzh_compress_verbose(unsigned int* vals, int nvals, unsigned char* output, int* output_len);
 
-void DECLSPECDLLEXPORT bwlzh_compress_no_lz77_verbose(unsigned int*  vals,
-                                                      int            nvals,
-                                                      unsigned char* output,
-                                                      int*           output_len);
+int DECLSPECDLLEXPORT bwlzh_compress_no_lz77_verbose(unsigned int*  vals,
+                                                     int            nvals,
+                                                     unsigned char* output,
+                                                     int*           output_len);
 
 void DECLSPECDLLEXPORT bwlzh_decompress_verbose(unsigned char* input, int nvals, unsigned int* vals);
 
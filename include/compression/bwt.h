@@ -25,16 +25,9 @@
 #ifndef BWT_H
 #define BWT_H
 
-void Ptngc_comp_to_bwt(unsigned int* vals, int nvals, unsigned int* output, int* index);
+/* Returns 0 on success and 1 if there are too many values. */
+int Ptngc_comp_to_bwt(unsigned int* vals, int nvals, unsigned int* output, int* index);
 
 void Ptngc_comp_from_bwt(const unsigned int* input, int nvals, int index, unsigned int* vals);
 
-void Ptngc_bwt_merge_sort_inner(int*          indices,
-                                int           nvals,
-                                unsigned int* vals,
-                                int           start,
-                                int           end,
-                                unsigned int* nrepeat,
-                                int*          workarray);
-
 #endif
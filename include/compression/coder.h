@@ -33,12 +33,14 @@
 #    endif /* USE_WINDOWS */
 #endif     /* DECLSPECDLLEXPORT */
 
+#include "my64bit.h"
+
 struct coder
 {
-    unsigned int pack_temporary;
-    int          pack_temporary_bits;
-    int          stat_overflow;
-    int          stat_numval;
+    my_uint64_t pack_temporary; /* Holds the pending bits, at most 7 between writes. */
+    int         pack_temporary_bits;
+    int         stat_overflow;
+    int         stat_numval;
 };
 
 struct coder DECLSPECDLLEXPORT* Ptngc_coder_init(void);
@@ -69,6 +71,7 @@ void DECLSPECDLLEXPORT Ptngc_write_pattern(struct coder*   coder,
                                            int             nbits,
                                            unsigned char** output);
 
+/* Write up to 32 bits */
 void DECLSPECDLLEXPORT Ptngc_writebits(struct coder* coder, unsigned int value, int nbits, unsigned char** output_ptr);
 void DECLSPECDLLEXPORT Ptngc_write32bits(struct coder*   coder,
                                          unsigned int    value,
@@ -38,6 +38,7 @@ void Ptngc_comp_conv_to_huffman(const unsigned int* vals,
                                 int*                huffman_dict_unpackedlen);
 
 void Ptngc_comp_conv_from_huffman(unsigned char*      huffman,
+                                  int                 huffman_len,
                                   unsigned int*       vals,
                                   int                 nvals,
                                   int                 ndict,
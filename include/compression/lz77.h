@@ -34,6 +34,21 @@ void Ptngc_comp_to_lz77(unsigned int* vals,
                         unsigned int* offsets,
                         int*          noffsets);
 
+/* Number of ints of workspace Ptngc_comp_to_lz77_work needs for nvals values. */
+int Ptngc_comp_lz77_work_len(int nvals);
+
+/* As Ptngc_comp_to_lz77, but uses the supplied workspace, which can be
+   reused between calls, instead of allocating its own. */
+void Ptngc_comp_to_lz77_work(unsigned int* vals,
+                             int           nvals,
+                             unsigned int* data,
+                             int*          ndata,
+                             unsigned int* len,
+                             int*          nlens,
+                             unsigned int* offsets,
+                             int*          noffsets,
+                             int*          work);
+
 void Ptngc_comp_from_lz77(const unsigned int* data,
                           int                 ndata,
                           const unsigned int* len,
@@ -391,6 +391,8 @@ typedef unsigned __int64 uint64_t;
 #define TNG_MAX_DATE_STR_LEN 24
 /** The length of an MD5 hash */
 #define TNG_MD5_HASH_LEN 16
+/** The length of an XXH64 hash */
+#define TNG_XXH64_HASH_LEN 8
 /** The maximum allowed length of a string */
 #define TNG_MAX_STR_LEN 1024
 
@@ -444,7 +446,8 @@ typedef enum
 {
     TNG_NO_HASH,
     TNG_MD5,
-    TNG_SHA256
+    TNG_SHA256,
+    TNG_XXH64
 } tng_hash_type;
 
 /** Non trajectory blocks come before the first frame set block */
@@ -462,6 +465,7 @@ typedef enum
 #define TNG_MOLECULES 0x0000000000000001LL
 #define TNG_TRAJECTORY_FRAME_SET 0x0000000000000002LL
 #define TNG_PARTICLE_MAPPING 0x0000000000000003LL
+#define TNG_FRAME_SET_INDEX 0x0000000000000004LL
 /** @} */
 
 /** @defgroup def2 Standard trajectory blocks
@@ -592,6 +596,24 @@ typedef enum
     TNG_VARIABLE_N_ATOMS
 } tng_variable_n_atoms_flag;
 
+/** The names of particles that can be retrieved for a range of particles. */
+typedef enum
+{
+    TNG_MOLECULE_NAME,
+    TNG_CHAIN_NAME,
+    TNG_RESIDUE_NAME,
+    TNG_ATOM_NAME,
+    TNG_ATOM_TYPE
+} tng_particle_name_type;
+
+/** The IDs of particles that can be retrieved for a range of particles. */
+typedef enum
+{
+    TNG_MOLECULE_ID,
+    TNG_RESIDUE_ID,
+    TNG_GLOBAL_RESIDUE_ID
+} tng_particle_id_type;
+
 /** Return values of API functions. TNG_SUCCESS means that the operation
  *  was successful. TNG_FAILURE means that the operation failed for some
  *  reason, but it is possible to try to continue anyhow. TNG_CRITICAL
@@ -612,6 +634,13 @@ typedef enum
     TNG_USE_HASH
 } tng_hash_mode;
 
+/** A function called for each block with contents not matching its hash, when
+ *  the hashes are verified in the background (see
+ *  tng_deferred_hash_verification_set()). block_id is the ID of the block,
+ *  file_pos is the file position of the block and user_data is the pointer
+ *  passed to tng_hash_mismatch_callback_set(). */
+typedef void (*tng_hash_mismatch_callback)(int64_t block_id, int64_t file_pos, void* user_data);
+
 /** Possible formats of data block contents */
 typedef enum
 {
@@ -736,6 +765,31 @@ extern "C"
     tng_function_status DECLSPECDLLEXPORT tng_trajectory_init_from_src(tng_trajectory_t  src,
                                                                        tng_trajectory_t* dest_p);
 
+    /**
+     * @brief Set up a cursor for reading the input file of a trajectory from
+     * another thread.
+     * @details A cursor is a trajectory container with its own current frame
+     * set and file position. It shares the molecules, the general information
+     * and the open input file of the reader instead of copying them, and it
+     * reads the file using positioned reads (or the memory mapping of the
+     * reader), so several cursors can read different frame sets of the same
+     * file concurrently without locking. The reader must not be modified, e.g.
+     * by reading the file headers again, and must not be destroyed while there
+     * are cursors using it. A cursor is freed using tng_trajectory_destroy or
+     * tng_util_trajectory_close.
+     * @param reader is a trajectory with the file headers read from its input
+     * file.
+     * @param cursor_p a pointer to memory to initialise as a cursor.
+     * @pre \code reader != 0 \endcode The trajectory container (reader)
+     * must be initialised before using it.
+     * @pre cursor_p must not be pointing at a reserved memory block.
+     * @return TNG_SUCCESS (0) if successful, TNG_FAILURE (1) if the reader has
+     * no input file that can be shared or TNG_CRITICAL (2) if a major error
+     * has occured.
+     */
+    tng_function_status DECLSPECDLLEXPORT tng_trajectory_cursor_init(tng_trajectory_t  reader,
+                                                                     tng_trajectory_t* cursor_p);
+
     /**
      * @brief Get the name of the input file.
      * @param tng_data the trajectory of which to get the input file name.
@@ -845,6 +899,38 @@ extern "C"
     tng_function_status DECLSPECDLLEXPORT tng_output_file_endianness_set(tng_trajectory_t tng_data,
                                                                          tng_file_endianness endianness);
 
+    /**
+     * @brief Get the type of hash written to the blocks of the output file.
+     * @param tng_data the trajectory of which to get the hash type.
+     * @param type will contain the enumeration of the hash type.
+     * @pre \code tng_data != 0 \endcode The trajectory container (tng_data)
+     * must be initialised before using it.
+     * @pre \code type != 0 \endcode The pointer to the hash type container
+     * must not be a NULL pointer.
+     * @return TNG_SUCCESS (0) if successful.
+     */
+    tng_function_status DECLSPECDLLEXPORT tng_output_hash_type_get(tng_trajectory_t tng_data,
+                                                                   tng_hash_type*   type);
+
+    /**
+     * @brief Set the type of hash written to the blocks of the output file,
+     * when they are written with TNG_USE_HASH.
+     * @param tng_data the trajectory of which to set the hash type.
+     * @param type the enumeration of the hash type, can be either TNG_MD5
+     * (the default) or TNG_XXH64.
+     * @pre \code tng_data != 0 \endcode The trajectory container (tng_data)
+     * must be initialised before using it.
+     * @details TNG_XXH64 hashes are much faster to generate and verify than
+     * MD5 hashes. They are stored after the block version in the block header
+     * and the MD5 hash of the block is left empty, so that readers not
+     * supporting them skip the verification. Blocks are always verified using
+     * the hash they were written with.
+     * @return TNG_SUCCESS (0) if successful or TNG_FAILURE (1) if the hash type
+     * is not supported for writing.
+     */
+    tng_function_status DECLSPECDLLEXPORT tng_output_hash_type_set(tng_trajectory_t tng_data,
+                                                                   tng_hash_type    type);
+
     /**
      * @brief Get the name of the program used when creating the trajectory.
      * @param tng_data the trajectory of which to get the program name.
@@ -1216,6 +1302,8 @@ extern "C"
 
     /**
      * @brief Get the number of frames in the trajectory
+     * @details The result is cached until the input file changes, so repeated
+     * calls do not read the file again.
      * @param tng_data is the trajectory of which to get the number of frames.
      * @param n is pointing to a value set to the number of frames.
      * @pre \code tng_data != 0 \endcode The trajectory container (tng_data)
@@ -1256,6 +1344,287 @@ extern "C"
     tng_function_status DECLSPECDLLEXPORT tng_compression_precision_set(tng_trajectory_t tng_data,
                                                                         double           precision);
 
+    /**
+     * @brief Get the number of threads used for reading frame sets.
+     * @param tng_data is the trajectory of which to get the number of threads.
+     * @param n_threads will be pointing to the number of threads.
+     * @pre \code tng_data != 0 \endcode The trajectory container (tng_data)
+     * must be initialised before using it.
+     * @pre \code n_threads != 0 \endcode The pointer to n_threads must not be a
+     * NULL pointer.
+     * @return TNG_SUCCESS (0) if successful.
+     */
+    tng_function_status DECLSPECDLLEXPORT tng_num_read_threads_get(tng_trajectory_t tng_data,
+                                                                   int64_t*         n_threads);
+
+    /**
+     * @brief Set the number of threads used for reading frame sets.
+     * @param tng_data is the trajectory of which to set the number of threads.
+     * @param n_threads is the number of threads to use. The default is 1.
+     * @pre \code tng_data != 0 \endcode The trajectory container (tng_data)
+     * must be initialised before using it.
+     * @details When reading an interval of frames spanning several frame sets, e.g. using
+     * tng_particle_data_vector_interval_get() or tng_util_pos_read_range(), the frame sets
+     * are read and decompressed by n_threads threads, each using a cursor (see
+     * tng_trajectory_cursor_init()). This requires that the TNG library is built with
+     * OpenMP support (TNG_USE_OPENMP).
+     * @return TNG_SUCCESS (0) if successful or TNG_FAILURE (1) if n_threads is
+     * less than 1 or if more than one thread is requested and the library is built
+     * without OpenMP support.
+     */
+    tng_function_status DECLSPECDLLEXPORT tng_num_read_threads_set(tng_trajectory_t tng_data,
+                                                                   const int64_t    n_threads);
+
+    /**
+     * @brief Get the number of threads used for compressing frame sets when
+     * writing them.
+     * @param tng_data is the trajectory of which to get the number of threads.
+     * @param n_threads will be pointing to the number of threads.
+     * @pre \code tng_data != 0 \endcode The trajectory container (tng_data)
+     * must be initialised before using it.
+     * @pre \code n_threads != 0 \endcode The pointer to n_threads must not be a
+     * NULL pointer.
+     * @return TNG_SUCCESS (0) if successful.
+     */
+    tng_function_status DECLSPECDLLEXPORT tng_num_write_threads_get(tng_trajectory_t tng_data,
+                                                                    int64_t*         n_threads);
+
+    /**
+     * @brief Set the number of threads used for compressing frame sets when
+     * writing them.
+     * @param tng_data is the trajectory of which to set the number of threads.
+     * @param n_threads is the number of threads to use. The default is 1.
+     * @pre \code tng_data != 0 \endcode The trajectory container (tng_data)
+     * must be initialised before using it.
+     * @details When writing a frame set, e.g. using tng_frame_set_write(), its data
+     * blocks, e.g. positions and velocities, are compressed by n_threads threads.
+     * The blocks are still written in the same order, so the written file does
+     * not depend on the number of threads. Frame sets with particle mapping blocks
+     * are compressed by one thread. This requires that the TNG library is built
+     * with OpenMP support (TNG_USE_OPENMP).
+     * @return TNG_SUCCESS (0) if successful or TNG_FAILURE (1) if n_threads is
+     * less than 1 or if more than one thread is requested and the library is built
+     * without OpenMP support.
+     */
+    tng_function_status DECLSPECDLLEXPORT tng_num_write_threads_set(tng_trajectory_t tng_data,
+                                                                    const int64_t    n_threads);
+
+    /**
+     * @brief Get whether full frame sets are written to the output file in the
+     * background.
+     * @param tng_data is the trajectory of which to get the setting.
+     * @param flag will be pointing to TNG_TRUE if frame sets are written in the
+     * background and TNG_FALSE otherwise.
+     * @pre \code tng_data != 0 \endcode The trajectory container (tng_data)
+     * must be initialised before using it.
+     * @pre \code flag != 0 \endcode The pointer to flag must not be a
+     * NULL pointer.
+     * @return TNG_SUCCESS (0) if successful.
+     */
+    tng_function_status DECLSPECDLLEXPORT tng_write_behind_get(tng_trajectory_t tng_data, char* flag);
+
+    /**
+     * @brief Set whether full frame sets are written to the output file in the
+     * background.
+     * @param tng_data is the trajectory of which to set the setting.
+     * @param flag is TNG_TRUE to write frame sets in the background and TNG_FALSE
+     * to write them directly. The default is TNG_FALSE.
+     * @pre \code tng_data != 0 \endcode The trajectory container (tng_data)
+     * must be initialised before using it.
+     * @details When the tng_util_*_write functions (e.g. tng_util_pos_write())
+     * receive the first frame after the current frame set, the full frame set is
+     * handed over to a background thread, which compresses it, calculates the
+     * hashes and writes it to the output file, while the following frames are
+     * stored in a second frame set. The writing only waits if the previous
+     * frame set is still being written when the second frame set is full.
+     * Errors from writing a frame set in the background are returned when the
+     * next frame set is handed over or when the writing is finished.
+     * The frame sets are written in the same way as without this setting.
+     * The frame sets still being written are finished before the output file is
+     * used by other functions, e.g. tng_frame_set_write(),
+     * tng_util_trajectory_close() or when setting flag to TNG_FALSE.
+     * Frame sets with particle mappings or a variable number of atoms are always
+     * written directly.
+     * This requires that the TNG library is built with POSIX threads support
+     * (TNG_USE_PTHREADS).
+     * @return TNG_SUCCESS (0) if successful, TNG_FAILURE (1) if flag is TNG_TRUE
+     * and the library is built without POSIX threads support or the error
+     * status of writing frame sets in the background when setting flag to
+     * TNG_FALSE.
+     */
+    tng_function_status DECLSPECDLLEXPORT tng_write_behind_set(tng_trajectory_t tng_data, const char flag);
+
+    /**
+     * @brief Get whether the hashes of the blocks read with TNG_USE_HASH are
+     * verified in the background.
+     * @param tng_data is the trajectory of which to get the setting.
+     * @param flag is set to TNG_TRUE if the hashes are verified in the background
+     * and TNG_FALSE if they are verified when reading the blocks.
+     * @pre \code tng_data != 0 \endcode The trajectory container (tng_data)
+     * must be initialised before using it.
+     * @pre \code flag != 0 \endcode The pointer to flag must not be a
+     * NULL pointer.
+     * @return TNG_SUCCESS (0) if successful.
+     */
+    tng_function_status DECLSPECDLLEXPORT tng_deferred_hash_verification_get(tng_trajectory_t tng_data,
+                                                                             char*            flag);
+
+    /**
+     * @brief Set whether the hashes of the blocks read with TNG_USE_HASH are
+     * verified in the background.
+     * @param tng_data is the trajectory of which to set the setting. Its input
+     * file must be set.
+     * @param flag is TNG_TRUE to verify the hashes in the background and TNG_FALSE
+     * to verify them when reading the blocks. The default is TNG_FALSE.
+     * @pre \code tng_data != 0 \endcode The trajectory container (tng_data)
+     * must be initialised before using it.
+     * @details When enabled, the contents of blocks read with TNG_USE_HASH (e.g.
+     * by tng_util_pos_read_range()) are returned without waiting for their hashes
+     * to be verified. A background thread reads the blocks again, using a
+     * separate handle of the input file, and verifies their hashes. Blocks with
+     * contents not matching their hashes are added to the list returned by
+     * tng_hash_mismatches_get() and reported to the function set by
+     * tng_hash_mismatch_callback_set(), or to stderr if no function is set.
+     * Cursors (see tng_trajectory_cursor_init()) hand over their blocks to the
+     * background thread of their reader.
+     * The remaining blocks are verified before the thread is stopped, when
+     * setting flag to TNG_FALSE, when changing the input file and when
+     * destroying the trajectory.
+     * This requires that the TNG library is built with POSIX threads support
+     * (TNG_USE_PTHREADS).
+     * @return TNG_SUCCESS (0) if successful, TNG_FAILURE (1) if flag is TNG_TRUE
+     * and the library is built without POSIX threads support, the input file is
+     * not set or tng_data is a cursor, or TNG_CRITICAL (2) if a major error
+     * has occured.
+     */
+    tng_function_status DECLSPECDLLEXPORT tng_deferred_hash_verification_set(tng_trajectory_t tng_data,
+                                                                             const char       flag);
+
+    /**
+     * @brief Wait until the hashes of the blocks read so far have been verified
+     * in the background.
+     * @param tng_data is the trajectory of which to wait for the verification.
+     * @pre \code tng_data != 0 \endcode The trajectory container (tng_data)
+     * must be initialised before using it.
+     * @return TNG_SUCCESS (0) if successful.
+     */
+    tng_function_status DECLSPECDLLEXPORT tng_deferred_hash_verification_wait(tng_trajectory_t tng_data);
+
+    /**
+     * @brief Set the function called for each block with contents not matching
+     * its hash, when the hashes are verified in the background.
+     * @param tng_data is the trajectory of which to set the function.
+     * @param callback is the function to call, or 0 to print the mismatches to
+     * stderr. It is called from the background thread.
+     * @param user_data is passed to callback.
+     * @pre \code tng_data != 0 \endcode The trajectory container (tng_data)
+     * must be initialised before using it.
+     * @return TNG_SUCCESS (0) if successful.
+     */
+    tng_function_status DECLSPECDLLEXPORT tng_hash_mismatch_callback_set(tng_trajectory_t tng_data,
+                                                                         tng_hash_mismatch_callback callback,
+                                                                         void* user_data);
+
+    /**
+     * @brief Get the blocks found so far with contents not matching their hashes,
+     * when the hashes are verified in the background.
+     * @param tng_data is the trajectory of which to get the blocks.
+     * @param n_mismatches is set to the number of blocks.
+     * @param file_positions is set to a list of the file positions of the blocks,
+     * which must be freed by the caller, or to 0 if there are no such blocks.
+     * @pre \code tng_data != 0 \endcode The trajectory container (tng_data)
+     * must be initialised before using it.
+     * @pre \code n_mismatches != 0 \endcode The pointer to the number of
+     * blocks must not be a NULL pointer.
+     * @pre \code file_positions != 0 \endcode The pointer to the list of file
+     * positions must not be a NULL pointer.
+     * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
+     * error has occured.
+     */
+    tng_function_status DECLSPECDLLEXPORT tng_hash_mismatches_get(tng_trajectory_t tng_data,
+                                                                  int64_t*         n_mismatches,
+                                                                  int64_t**        file_positions);
+
+    /**
+     * @brief Get the number of frame sets read ahead in the background.
+     * @param tng_data is the trajectory of which to get the setting.
+     * @param n_frame_sets is set to the maximum number of frame sets read ahead,
+     * or 0 if frame sets are only read when they are requested.
+     * @pre \code tng_data != 0 \endcode The trajectory container (tng_data)
+     * must be initialised before using it.
+     * @pre \code n_frame_sets != 0 \endcode The pointer to n_frame_sets must
+     * not be a NULL pointer.
+     * @return TNG_SUCCESS (0) if successful.
+     */
+    tng_function_status DECLSPECDLLEXPORT tng_frame_set_prefetch_get(tng_trajectory_t tng_data,
+                                                                     int64_t*         n_frame_sets);
+
+    /**
+     * @brief Set the number of frame sets read ahead in the background.
+     * @param tng_data is the trajectory of which to set the setting. Its input
+     * file must be set and must not be its output file.
+     * @param n_frame_sets is the maximum number of frame sets read ahead, or 0
+     * to only read frame sets when they are requested. The default is 0.
+     * @pre \code tng_data != 0 \endcode The trajectory container (tng_data)
+     * must be initialised before using it.
+     * @details When enabled, a background thread reads and decompresses the
+     * frame sets following the current frame set, using separate cursors (see
+     * tng_trajectory_cursor_init()), while the caller works on the current one.
+     * tng_frame_set_read_next() and
+     * tng_frame_set_read_next_only_data_from_block_id(), and thereby e.g.
+     * tng_util_particle_data_next_frame_read(), take over the next frame set
+     * from the background thread if it has been read ahead with at least the
+     * requested hash mode. Any other frame set is read directly and the frame
+     * sets read ahead are discarded. The operating system is advised to read the
+     * frame set after the last one read ahead into its cache as well.
+     * Frame sets are read ahead with the hash mode of the last request, or with
+     * TNG_USE_HASH before the first one.
+     * This requires the library to be built with POSIX threads support
+     * (TNG_USE_PTHREADS).
+     * @return TNG_SUCCESS (0) if successful, TNG_FAILURE (1) if n_frame_sets > 0
+     * and the library is built without POSIX threads support, the input file
+     * cannot be read by cursors or tng_data is a cursor, or TNG_CRITICAL (2) if
+     * a major error has occured.
+     */
+    tng_function_status DECLSPECDLLEXPORT tng_frame_set_prefetch_set(tng_trajectory_t tng_data,
+                                                                     const int64_t    n_frame_sets);
+
+    /**
+     * @brief Get the size of the cache of decoded frame set data blocks.
+     * @param tng_data is the trajectory of which to get the setting.
+     * @param max_size is set to the maximum size of the cache in bytes, or 0
+     * if data blocks are not cached.
+     * @pre \code tng_data != 0 \endcode The trajectory container (tng_data)
+     * must be initialised before using it.
+     * @pre \code max_size != 0 \endcode The pointer to max_size must not be a
+     * NULL pointer.
+     * @return TNG_SUCCESS (0) if successful.
+     */
+    tng_function_status DECLSPECDLLEXPORT tng_frame_set_cache_size_get(tng_trajectory_t tng_data,
+                                                                       int64_t*         max_size);
+
+    /**
+     * @brief Set the size of the cache of decoded frame set data blocks.
+     * @param tng_data is the trajectory of which to set the setting.
+     * @param max_size is the maximum size of the cache in bytes, or 0 to not
+     * cache data blocks. The default is 0.
+     * @pre \code tng_data != 0 \endcode The trajectory container (tng_data)
+     * must be initialised before using it.
+     * @details When enabled, the decoded values of the numerical data blocks
+     * read from frame sets are kept, keyed by the file position and ID of each
+     * block. Reading a cached block again, e.g. after going back with
+     * tng_frame_set_nr_find(), copies its values from the cache instead of
+     * reading and decompressing the block contents. The least recently used
+     * blocks are removed when the cache grows beyond max_size. Blocks cached
+     * without verifying their hashes are read again when they are requested
+     * with TNG_USE_HASH. Blocks are not cached while the input file is also
+     * the output file.
+     * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
+     * error has occured.
+     */
+    tng_function_status DECLSPECDLLEXPORT tng_frame_set_cache_size_set(tng_trajectory_t tng_data,
+                                                                       const int64_t    max_size);
+
     /**
      * @brief Set the number of particles, in the case no molecular system is used.
      * @param tng_data is the trajectory of which to get the number of particles.
@@ -1393,6 +1762,8 @@ extern "C"
     /**
      * @brief Get the number of frame sets.
      * @details This updates tng_data->n_trajectory_frame_sets before returning it.
+     * The number of frame sets in the input file is cached (or taken from the
+     * frame set index block), so only the first call walks the frame sets.
      * @param tng_data is the trajectory from which to get the number of frame sets.
      * @param n is pointing to a value set to the number of frame sets.
      * @pre \code tng_data != 0 \endcode The trajectory container (tng_data)
@@ -1424,6 +1795,8 @@ extern "C"
      * @pre \code nr >= 0 \endcode The frame set number (nr) must be >= 0.
      * @details tng_data->current_trajectory_frame_set will contain the
      * found trajectory if successful.
+     * @details If the input file contains a frame set index block the frame set
+     * is read directly, otherwise the frame set pointers are followed.
      * @return TNG_SUCCESS (0) if successful, TNG_FAILURE (1) if a minor error
      * has occurred or TNG_CRITICAL (2) if a major error has occured.
      */
@@ -1438,6 +1811,8 @@ extern "C"
      * @pre \code frame >= 0 \endcode The frame number must be >= 0.
      * @details tng_data->current_trajectory_frame_set will contain the
      * found trajectory if successful.
+     * @details If the input file contains a frame set index block the frame set
+     * is read directly, otherwise the frame set pointers are followed.
      * @return TNG_SUCCESS (0) if successful, TNG_FAILURE (1) if a minor error
      * has occurred or TNG_CRITICAL (2) if a major error has occured.
      */
@@ -2382,6 +2757,67 @@ extern "C"
                                                                            char*            type,
                                                                            int max_len);
 
+    /**
+     * @brief Get a name of each particle in a range of real particle numbers
+     * (numbers in mol system).
+     * @details The molecule of the first particle is found with a binary search
+     * of the particle counts of the molecule types and the other particles
+     * follow in order, so this is much faster than getting the name of each
+     * particle separately.
+     * @param tng_data is the trajectory data container containing the atoms.
+     * @param first_nr is the real number of the first particle.
+     * @param n_particles is the number of particles.
+     * @param name_type specifies which name to get, TNG_MOLECULE_NAME,
+     * TNG_CHAIN_NAME, TNG_RESIDUE_NAME, TNG_ATOM_NAME or TNG_ATOM_TYPE.
+     * @param names is a list of n_particles strings of max_len characters each,
+     * i.e. n_particles * max_len characters. The name of particle first_nr + i
+     * is set at names + i * max_len. Memory must be reserved beforehand.
+     * @param max_len is the maximum length of each name.
+     * @pre \code tng_data != 0 \endcode The trajectory container (tng_data)
+     * must be initialised before using it.
+     * @pre \code names != 0 \endcode The pointer to the names must not be a
+     * NULL pointer.
+     * @return TNG_SUCCESS (0) if successful, TNG_FAILURE (1) if a particle is
+     * not in the molecular system, a name is missing (the name is then set to
+     * an empty string) or a name is truncated, or TNG_CRITICAL (2) if a major
+     * error has occured.
+     */
+    tng_function_status DECLSPECDLLEXPORT tng_particle_names_of_particle_range_get(tng_trajectory_t tng_data,
+                                                                                   int64_t first_nr,
+                                                                                   int64_t n_particles,
+                                                                                   tng_particle_name_type name_type,
+                                                                                   char* names,
+                                                                                   int   max_len);
+
+    /**
+     * @brief Get an ID of each particle in a range of real particle numbers
+     * (numbers in mol system).
+     * @details The molecule of the first particle is found with a binary search
+     * of the particle counts of the molecule types and the other particles
+     * follow in order, so this is much faster than getting the ID of each
+     * particle separately.
+     * @param tng_data is the trajectory data container containing the atoms.
+     * @param first_nr is the real number of the first particle.
+     * @param n_particles is the number of particles.
+     * @param id_type specifies which ID to get, TNG_MOLECULE_ID, TNG_RESIDUE_ID
+     * (local to the molecule) or TNG_GLOBAL_RESIDUE_ID (based on other
+     * molecules and molecule counts).
+     * @param ids is a list of n_particles IDs, which is set to the ID of each
+     * particle. Memory must be reserved beforehand.
+     * @pre \code tng_data != 0 \endcode The trajectory container (tng_data)
+     * must be initialised before using it.
+     * @pre \code ids != 0 \endcode The pointer to the IDs must not be a NULL
+     * pointer.
+     * @return TNG_SUCCESS (0) if successful, TNG_FAILURE (1) if a particle is
+     * not in the molecular system or a residue ID is missing (the ID is then
+     * set to -1), or TNG_CRITICAL (2) if a major error has occured.
+     */
+    tng_function_status DECLSPECDLLEXPORT tng_particle_ids_of_particle_range_get(tng_trajectory_t tng_data,
+                                                                                 int64_t first_nr,
+                                                                                 int64_t n_particles,
+                                                                                 tng_particle_id_type id_type,
+                                                                                 int64_t* ids);
+
     /**
      * @brief Add a particle mapping table.
      * @details Each particle mapping table will be written as a separate block,
@@ -2420,6 +2856,50 @@ extern "C"
      */
     tng_function_status DECLSPECDLLEXPORT tng_frame_set_particle_mapping_free(tng_trajectory_t tng_data);
 
+    /**
+     * @brief Translate a particle number used in the current frame set to the
+     * real particle number, i.e. the number used in the molecular system.
+     * @details The particle mapping blocks of the frame set are indexed when
+     * they are added or read, so the translation does not scan all mapping
+     * blocks. If the frame set has no particle mappings the particle numbers
+     * are the same.
+     * @param tng_data is the trajectory, with the frame set whose particle
+     * mappings to use.
+     * @param local is the particle number in the frame set.
+     * @param real is set to the real particle number.
+     * @pre \code tng_data != 0 \endcode The trajectory container (tng_data)
+     * must be initialised before using it.
+     * @pre \code real != 0 \endcode The pointer to the real particle number
+     * must not be a NULL pointer.
+     * @return TNG_SUCCESS (0) if successful or TNG_FAILURE (1) if the particle
+     * is not in any particle mapping block of the frame set.
+     */
+    tng_function_status DECLSPECDLLEXPORT tng_particle_mapping_real_particle_get(tng_trajectory_t tng_data,
+                                                                                int64_t          local,
+                                                                                int64_t*         real);
+
+    /**
+     * @brief Translate a real particle number, i.e. the number used in the
+     * molecular system, to the particle number used in the current frame set.
+     * @details The particle mapping blocks of the frame set are indexed when
+     * they are added or read, so the translation does not scan all mapping
+     * blocks. If the frame set has no particle mappings the particle numbers
+     * are the same.
+     * @param tng_data is the trajectory, with the frame set whose particle
+     * mappings to use.
+     * @param real is the real particle number.
+     * @param local is set to the particle number in the frame set.
+     * @pre \code tng_data != 0 \endcode The trajectory container (tng_data)
+     * must be initialised before using it.
+     * @pre \code local != 0 \endcode The pointer to the local particle number
+     * must not be a NULL pointer.
+     * @return TNG_SUCCESS (0) if successful or TNG_FAILURE (1) if the particle
+     * is not mapped in the frame set.
+     */
+    tng_function_status DECLSPECDLLEXPORT tng_particle_mapping_local_particle_get(tng_trajectory_t tng_data,
+                                                                                 int64_t          real,
+                                                                                 int64_t*         local);
+
     /**
      * @brief Read the header blocks from the input_file of tng_data.
      * @details The trajectory blocks must be read separately and iteratively in chunks
@@ -2479,9 +2959,54 @@ extern "C"
                                                               tng_gen_block_t  block_data,
                                                               char             hash_mode);
 
+    /**
+     * @brief Get the IDs of the data blocks read by tng_frame_set_read() and
+     * tng_frame_set_read_next().
+     * @param tng_data is a trajectory data container.
+     * @param n_block_ids will be pointing to the number of block IDs, 0 if all
+     * data blocks are read.
+     * @param block_ids will be pointing to the list of block IDs. The list is
+     * owned by tng_data.
+     * @pre \code tng_data != 0 \endcode The trajectory container (tng_data)
+     * must be initialised before using it.
+     * @pre \code n_block_ids != 0 \endcode The pointer to n_block_ids must not be a
+     * NULL pointer.
+     * @pre \code block_ids != 0 \endcode The pointer to block_ids must not be a
+     * NULL pointer.
+     * @return TNG_SUCCESS (0) if successful.
+     */
+    tng_function_status DECLSPECDLLEXPORT tng_frame_set_read_block_ids_get(tng_trajectory_t tng_data,
+                                                                           int64_t*         n_block_ids,
+                                                                           const int64_t**  block_ids);
+
+    /**
+     * @brief Set the IDs of the data blocks read by tng_frame_set_read() and
+     * tng_frame_set_read_next().
+     * @param tng_data is a trajectory data container.
+     * @param n_block_ids is the number of block IDs. If 0 all data blocks are
+     * read, which is the default.
+     * @param block_ids is the list of block IDs, e.g. TNG_TRAJ_BOX_SHAPE. It is
+     * copied.
+     * @pre \code tng_data != 0 \endcode The trajectory container (tng_data)
+     * must be initialised before using it.
+     * @pre \code n_block_ids <= 0 || block_ids != 0 \endcode The pointer to
+     * block_ids must not be a NULL pointer if there are any block IDs.
+     * @details Only the headers of other data blocks are read and their contents
+     * are skipped, without being read, hashed or decompressed. Their data, if
+     * any, from an earlier frame set is not updated. The frame set block and
+     * particle mapping blocks are always read.
+     * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major error
+     * has occured.
+     */
+    tng_function_status DECLSPECDLLEXPORT tng_frame_set_read_block_ids_set(tng_trajectory_t tng_data,
+                                                                           int64_t          n_block_ids,
+                                                                           const int64_t*   block_ids);
+
     /**
      * @brief Read one frame set, including all particle mapping blocks and data
      * blocks, starting from the current file position.
+     * If data block IDs are set by tng_frame_set_read_block_ids_set() only those
+     * data blocks are read.
      * @param tng_data is a trajectory data container.
      * @param hash_mode is an option to decide whether to use the md5 hash or not.
      * If hash_mode == TNG_USE_HASH the written md5 hash in the file will be
@@ -2586,6 +3111,27 @@ extern "C"
     tng_function_status DECLSPECDLLEXPORT tng_frame_set_premature_write(tng_trajectory_t tng_data,
                                                                         char             hash_mode);
 
+    /**
+     * @brief Write an index of all frame sets written to the output_file of
+     * tng_data. The index block is appended to the end of the file.
+     * @details The index lists the number, first frame, number of frames, file
+     * position and first frame time of each frame set. When reading the file
+     * it is used by tng_frame_set_nr_find() and tng_frame_set_of_frame_find()
+     * to jump directly to a frame set instead of following the frame set
+     * pointers. tng_util_trajectory_close() writes the index automatically.
+     * No index is written if not all frame sets of the file are known, e.g. when
+     * appending to a file that has no valid index.
+     * @param tng_data is a trajectory data container.
+     * @param hash_mode is an option to decide whether to use the md5 hash or not.
+     * If hash_mode == TNG_USE_HASH an md5 hash of the block will be generated.
+     * @pre \code tng_data != 0 \endcode The trajectory container (tng_data)
+     * must be initialised before using it.
+     * @return TNG_SUCCESS (0) if successful, TNG_FAILURE (1) if no index could
+     * be written or TNG_CRITICAL (2) if a major error has occured.
+     */
+    tng_function_status DECLSPECDLLEXPORT tng_frame_set_index_write(tng_trajectory_t tng_data,
+                                                                    char             hash_mode);
+
     /**
      * @brief Create and initialise a frame set.
      * @details Particle mappings are retained from previous frame set (if any).
@@ -2903,7 +3449,8 @@ extern "C"
      * @param block_id is the id number of the particle data block to read.
      * @param values is a pointer to a 2-dimensional array (memory unallocated), which
      * will be filled with data. The array will be sized
-     * (n_frames * n_values_per_frame).
+     * (n_frames * n_values_per_frame). All values are stored contiguously
+     * from (*values)[0].
      * Since ***values is allocated in this function it is the callers
      * responsibility to free the memory.
      * @param n_frames is set to the number of frames in the returned data. This is
@@ -2983,7 +3530,8 @@ extern "C"
      * compared to the md5 hash of the read contents to ensure valid data.
      * @param values is a pointer to a 2-dimensional array (memory unallocated), which
      * will be filled with data. The array will be sized
-     * (n_frames * n_values_per_frame).
+     * (n_frames * n_values_per_frame). All values are stored contiguously
+     * from (*values)[0].
      * Since ***values is allocated in this function it is the callers
      * responsibility to free the memory.
      * @param n_values_per_frame is set to the number of values per frame in the data.
@@ -3068,7 +3616,8 @@ extern "C"
      * @param block_id is the id number of the particle data block to read.
      * @param values is a pointer to a 3-dimensional array (memory unallocated), which
      * will be filled with data. The array will be sized
-     * (n_frames * n_particles * n_values_per_frame).
+     * (n_frames * n_particles * n_values_per_frame). All values are stored
+     * contiguously from (*values)[0][0].
      * Since ****values is allocated in this function it is the callers
      * responsibility to free the memory.
      * @param n_frames is set to the number of frames in the returned data. This is
@@ -3162,7 +3711,8 @@ extern "C"
      * compared to the md5 hash of the read contents to ensure valid data.
      * @param values is a pointer to a 3-dimensional array (memory unallocated), which
      * will be filled with data. The array will be sized
-     * (n_frames * n_particles * n_values_per_frame).
+     * (n_frames * n_particles * n_values_per_frame). All values are stored
+     * contiguously from (*values)[0][0].
      * Since ****values is allocated in this function it is the callers
      * responsibility to free the memory.
      * @param n_particles is set to the number of particles in the returned data. This is
@@ -3251,6 +3801,65 @@ extern "C"
                                                                                 int64_t* n_values_per_frame,
                                                                                 char* type);
 
+    /**
+     * @brief Read and retrieve a vector (1D array) of particle data, in a
+     * specific interval, into an array owned by the caller.
+     * @param tng_data is a trajectory data container. tng_data->input_file_path specifies
+     * which file to read from. If the file (input_file) is not open it will be
+     * opened.
+     * @param block_id is the id number of the particle data block to read.
+     * @param start_frame_nr is the index number of the first frame to read.
+     * @param end_frame_nr is the index number of the last frame to read.
+     * @param hash_mode is an option to decide whether to use the md5 hash or not.
+     * If hash_mode == TNG_USE_HASH the md5 hash in the file will be
+     * compared to the md5 hash of the read contents to ensure valid data.
+     * @param values is the array, which will be filled with data. Each frame
+     * with data (see stride_length) contains n_particles * n_values_per_frame
+     * values.
+     * @param values_len is the size (in bytes) of values.
+     * @param frame_stride is the distance (in bytes) between the starts of two
+     * frames in values, or 0 if the frames are stored consecutively.
+     * @param n_particles is set to the number of particles in the returned data.
+     * @param stride_length is set to the stride length (writing interval) of
+     * the data.
+     * @param n_values_per_frame is set to the number of values per frame in the data.
+     * @param type is set to the data type of the data in the array.
+     * @pre \code tng_data != 0 \endcode The trajectory container (tng_data)
+     * must be initialised before using it.
+     * @pre \code start_frame_nr <= end_frame_nr \endcode The first frame must be before
+     * the last frame.
+     * @pre \code values != 0 \endcode The array must not be a NULL pointer.
+     * @pre \code n_particles != 0 \endcode The pointer to the number of particles must
+     * not be a NULL pointer.
+     * @pre \code stride_length != 0 \endcode The pointer to the stride length
+     * must not be a NULL pointer.
+     * @pre \code n_values_per_frame != 0 \endcode The pointer to the number of
+     * values per frame must not be a NULL pointer.
+     * @pre \code type != 0 \endcode The pointer to the data type must not
+     * be a NULL pointer.
+     * @details This does only work for numerical (int, float, double) data.
+     * Unlike tng_particle_data_vector_interval_get() no memory is allocated for
+     * the values, which are copied directly from the read data blocks. If the
+     * data does not fit in values TNG_FAILURE is returned, but n_particles,
+     * stride_length, n_values_per_frame and type are still set.
+     * @return TNG_SUCCESS (0) if successful, TNG_FAILURE (1) if a minor error
+     * has occurred (such as the data not fitting in values) or TNG_CRITICAL (2)
+     * if a major error has occured.
+     */
+    tng_function_status DECLSPECDLLEXPORT
+            tng_particle_data_vector_interval_get_into(tng_trajectory_t tng_data,
+                                                       int64_t          block_id,
+                                                       int64_t          start_frame_nr,
+                                                       int64_t          end_frame_nr,
+                                                       char             hash_mode,
+                                                       void*            values,
+                                                       int64_t          values_len,
+                                                       int64_t          frame_stride,
+                                                       int64_t*         n_particles,
+                                                       int64_t*         stride_length,
+                                                       int64_t*         n_values_per_frame,
+                                                       char*            type);
+
     /**
      * @brief Get the stride length of a specific data (particle dependency does not matter)
      * block, either in the current frame set or of a specific frame.
@@ -3294,7 +3903,10 @@ extern "C"
      * @brief High-level function for opening and initializing a TNG trajectory.
      * @param filename is a string containing the name of the trajectory to open.
      * @param mode specifies the file mode of the trajectory. Can be set to 'r',
-     * 'w' or 'a' for reading, writing or appending respectively.
+     * 'w' or 'a' for reading, writing or appending respectively. 'm' opens the
+     * file for reading through a read-only memory mapping instead of stdio
+     * calls, which is faster when the same parts of a file are read many times.
+     * If the file cannot be mapped, 'm' is handled like 'r'.
      * @param tng_data_p is a pointer to the opened trajectory. This will be
      * allocated by the TNG library. The trajectory must be
      * closed by the user, whereby memory is freed.
@@ -3597,6 +4209,236 @@ extern "C"
                                                                     float**          forces,
                                                                     int64_t*         stride_length);
 
+    /**
+     * @brief High-level function for reading the positions of all particles
+     * from a specific range of frames into an array owned by the caller.
+     * @param tng_data is the trajectory to read from.
+     * @param first_frame is the first frame to return position data from.
+     * @param last_frame is the last frame to return position data from.
+     * @param positions is the array, which will contain the positions. For
+     * each frame with data the positions (in x, y and z) of all particles are
+     * stored. The array can be reused for reading other ranges.
+     * @param n_values is the number of floats that fit in positions.
+     * @param frame_stride is the number of floats between the starts of two
+     * frames in positions, or 0 if the frames are stored consecutively.
+     * @param stride_length will be set to the writing interval of the stored data.
+     * @pre \code tng_data != 0 \endcode The trajectory container (tng_data)
+     * must be initialised before using it.
+     * @pre \code start_frame_nr <= end_frame_nr \endcode The first frame must be before
+     * the last frame.
+     * @pre \code positions != 0 \endcode The pointer to the positions array
+     * must not be a NULL pointer.
+     * @pre \code stride_length != 0 \endcode The pointer to the stride length
+     * must not be a NULL pointer.
+     * @details Unlike tng_util_pos_read_range() no memory is allocated for
+     * the positions, which are copied directly from the read data blocks.
+     * @return TNG_SUCCESS (0) if successful, TNG_FAILURE (1) if a minor error
+     * has occured (such as not finding a position block, the datatype not
+     * being float or the positions not fitting in the array) or TNG_CRITICAL (2)
+     * if a major error has occured.
+     */
+    tng_function_status DECLSPECDLLEXPORT tng_util_pos_read_range_into(tng_trajectory_t tng_data,
+                                                                       int64_t          first_frame,
+                                                                       int64_t          last_frame,
+                                                                       float*           positions,
+                                                                       int64_t          n_values,
+                                                                       int64_t          frame_stride,
+                                                                       int64_t*         stride_length);
+
+    /**
+     * @brief High-level function for reading the velocities of all particles
+     * from a specific range of frames into an array owned by the caller.
+     * @param tng_data is the trajectory to read from.
+     * @param first_frame is the first frame to return velocity data from.
+     * @param last_frame is the last frame to return velocity data from.
+     * @param velocities is the array, which will contain the velocities. For
+     * each frame with data the velocities (in x, y and z) of all particles are
+     * stored. The array can be reused for reading other ranges.
+     * @param n_values is the number of floats that fit in velocities.
+     * @param frame_stride is the number of floats between the starts of two
+     * frames in velocities, or 0 if the frames are stored consecutively.
+     * @param stride_length will be set to the writing interval of the stored data.
+     * @pre \code tng_data != 0 \endcode The trajectory container (tng_data)
+     * must be initialised before using it.
+     * @pre \code start_frame_nr <= end_frame_nr \endcode The first frame must be before
+     * the last frame.
+     * @pre \code velocities != 0 \endcode The pointer to the velocities array
+     * must not be a NULL pointer.
+     * @pre \code stride_length != 0 \endcode The pointer to the stride length
+     * must not be a NULL pointer.
+     * @return TNG_SUCCESS (0) if successful, TNG_FAILURE (1) if a minor error
+     * has occured (such as not finding a velocity block, the datatype not
+     * being float or the velocities not fitting in the array) or TNG_CRITICAL (2)
+     * if a major error has occured.
+     */
+    tng_function_status DECLSPECDLLEXPORT tng_util_vel_read_range_into(tng_trajectory_t tng_data,
+                                                                       int64_t          first_frame,
+                                                                       int64_t          last_frame,
+                                                                       float*           velocities,
+                                                                       int64_t          n_values,
+                                                                       int64_t          frame_stride,
+                                                                       int64_t*         stride_length);
+
+    /**
+     * @brief High-level function for reading the forces of all particles
+     * from a specific range of frames into an array owned by the caller.
+     * @param tng_data is the trajectory to read from.
+     * @param first_frame is the first frame to return force data from.
+     * @param last_frame is the last frame to return force data from.
+     * @param forces is the array, which will contain the forces. For each
+     * frame with data the forces (in x, y and z) of all particles are stored.
+     * The array can be reused for reading other ranges.
+     * @param n_values is the number of floats that fit in forces.
+     * @param frame_stride is the number of floats between the starts of two
+     * frames in forces, or 0 if the frames are stored consecutively.
+     * @param stride_length will be set to the writing interval of the stored data.
+     * @pre \code tng_data != 0 \endcode The trajectory container (tng_data)
+     * must be initialised before using it.
+     * @pre \code start_frame_nr <= end_frame_nr \endcode The first frame must be before
+     * the last frame.
+     * @pre \code forces != 0 \endcode The pointer to the forces array
+     * must not be a NULL pointer.
+     * @pre \code stride_length != 0 \endcode The pointer to the stride length
+     * must not be a NULL pointer.
+     * @return TNG_SUCCESS (0) if successful, TNG_FAILURE (1) if a minor error
+     * has occured (such as not finding a force block, the datatype not
+     * being float or the forces not fitting in the array) or TNG_CRITICAL (2)
+     * if a major error has occured.
+     */
+    tng_function_status DECLSPECDLLEXPORT tng_util_force_read_range_into(tng_trajectory_t tng_data,
+                                                                         int64_t          first_frame,
+                                                                         int64_t          last_frame,
+                                                                         float*           forces,
+                                                                         int64_t          n_values,
+                                                                         int64_t          frame_stride,
+                                                                         int64_t*         stride_length);
+
+    /**
+     * @brief High-level function for reading the positions of a selection of
+     * particles from a specific range of frames.
+     * @param tng_data is the trajectory to read from.
+     * @param first_frame is the first frame to return position data from.
+     * @param last_frame is the last frame to return position data from.
+     * @param particles is the list of selected particles, sorted in
+     * increasing order.
+     * @param n_selected is the number of selected particles.
+     * @param positions will be set to point at a 1-dimensional array of floats,
+     * which will contain the positions. For each frame with data the positions
+     * (in x, y and z) of the selected particles are stored, in the order of
+     * particles. The variable may point at already allocated memory or be a
+     * NULL pointer. The memory must be freed afterwards.
+     * @param stride_length will be set to the writing interval of the stored data.
+     * @details Data blocks, which do not contain any of the selected particles
+     * (according to the particle mapping blocks of each frame set), are skipped
+     * without being read or decompressed.
+     * @pre \code tng_data != 0 \endcode The trajectory container (tng_data)
+     * must be initialised before using it.
+     * @pre \code particles != 0 \endcode The pointer to the particles array
+     * must not be a NULL pointer.
+     * @pre \code start_frame_nr <= end_frame_nr \endcode The first frame must be before
+     * the last frame.
+     * @pre \code positions != 0 \endcode The pointer to the positions array
+     * must not be a NULL pointer.
+     * @pre \code stride_length != 0 \endcode The pointer to the stride length
+     * must not be a NULL pointer.
+     * @return TNG_SUCCESS (0) if successful, TNG_FAILURE (1) if a minor error
+     * has occured (such as not finding a position block containing the
+     * selected particles, the particles not being sorted or the datatype not
+     * being float) or
+     * TNG_CRITICAL (2) if a major error has occured.
+     */
+    tng_function_status DECLSPECDLLEXPORT tng_util_pos_subset_read_range(tng_trajectory_t tng_data,
+                                                                         int64_t          first_frame,
+                                                                         int64_t          last_frame,
+                                                                         const int64_t*   particles,
+                                                                         int64_t          n_selected,
+                                                                         float**          positions,
+                                                                         int64_t*         stride_length);
+
+    /**
+     * @brief High-level function for reading the velocities of a selection of
+     * particles from a specific range of frames.
+     * @param tng_data is the trajectory to read from.
+     * @param first_frame is the first frame to return velocity data from.
+     * @param last_frame is the last frame to return velocity data from.
+     * @param particles is the list of selected particles, sorted in
+     * increasing order.
+     * @param n_selected is the number of selected particles.
+     * @param velocities will be set to point at a 1-dimensional array of floats,
+     * which will contain the velocities. For each frame with data the velocities
+     * (in x, y and z) of the selected particles are stored, in the order of
+     * particles. The variable may point at already allocated memory or be a
+     * NULL pointer. The memory must be freed afterwards.
+     * @param stride_length will be set to the writing interval of the stored data.
+     * @details Data blocks, which do not contain any of the selected particles
+     * (according to the particle mapping blocks of each frame set), are skipped
+     * without being read or decompressed.
+     * @pre \code tng_data != 0 \endcode The trajectory container (tng_data)
+     * must be initialised before using it.
+     * @pre \code particles != 0 \endcode The pointer to the particles array
+     * must not be a NULL pointer.
+     * @pre \code start_frame_nr <= end_frame_nr \endcode The first frame must be before
+     * the last frame.
+     * @pre \code velocities != 0 \endcode The pointer to the velocities array
+     * must not be a NULL pointer.
+     * @pre \code stride_length != 0 \endcode The pointer to the stride length
+     * must not be a NULL pointer.
+     * @return TNG_SUCCESS (0) if successful, TNG_FAILURE (1) if a minor error
+     * has occured (such as not finding a velocity block containing the
+     * selected particles, the particles not being sorted or the datatype not
+     * being float) or
+     * TNG_CRITICAL (2) if a major error has occured.
+     */
+    tng_function_status DECLSPECDLLEXPORT tng_util_vel_subset_read_range(tng_trajectory_t tng_data,
+                                                                         int64_t          first_frame,
+                                                                         int64_t          last_frame,
+                                                                         const int64_t*   particles,
+                                                                         int64_t          n_selected,
+                                                                         float**          velocities,
+                                                                         int64_t*         stride_length);
+
+    /**
+     * @brief High-level function for reading the forces of a selection of
+     * particles from a specific range of frames.
+     * @param tng_data is the trajectory to read from.
+     * @param first_frame is the first frame to return force data from.
+     * @param last_frame is the last frame to return force data from.
+     * @param particles is the list of selected particles, sorted in
+     * increasing order.
+     * @param n_selected is the number of selected particles.
+     * @param forces will be set to point at a 1-dimensional array of floats,
+     * which will contain the forces. For each frame with data the forces
+     * (in x, y and z) of the selected particles are stored, in the order of
+     * particles. The variable may point at already allocated memory or be a
+     * NULL pointer. The memory must be freed afterwards.
+     * @param stride_length will be set to the writing interval of the stored data.
+     * @details Data blocks, which do not contain any of the selected particles
+     * (according to the particle mapping blocks of each frame set), are skipped
+     * without being read or decompressed.
+     * @pre \code tng_data != 0 \endcode The trajectory container (tng_data)
+     * must be initialised before using it.
+     * @pre \code particles != 0 \endcode The pointer to the particles array
+     * must not be a NULL pointer.
+     * @pre \code start_frame_nr <= end_frame_nr \endcode The first frame must be before
+     * the last frame.
+     * @pre \code forces != 0 \endcode The pointer to the forces array
+     * must not be a NULL pointer.
+     * @pre \code stride_length != 0 \endcode The pointer to the stride length
+     * must not be a NULL pointer.
+     * @return TNG_SUCCESS (0) if successful, TNG_FAILURE (1) if a minor error
+     * has occured (such as not finding a force block containing the
+     * selected particles, the particles not being sorted or the datatype not
+     * being float) or
+     * TNG_CRITICAL (2) if a major error has occured.
+     */
+    tng_function_status DECLSPECDLLEXPORT tng_util_force_subset_read_range(tng_trajectory_t tng_data,
+                                                                           int64_t          first_frame,
+                                                                           int64_t          last_frame,
+                                                                           const int64_t*   particles,
+                                                                           int64_t          n_selected,
+                                                                           float**          forces,
+                                                                           int64_t*         stride_length);
+
     /**
      * @brief High-level function for reading the box shape
      * from a specific range of frames.
@@ -0,0 +1,112 @@
+/*
+ * This code is part of the tng binary trajectory format.
+ *
+ * Copyright (c) 2020, by the GROMACS development team.
+ * TNG was orginally written by Magnus Lundborg, Daniel Spångberg and
+ * Rossen Apostolov. The API is implemented mainly by Magnus Lundborg,
+ * Daniel Spångberg and Anders Gärdenäs.
+ *
+ * Please see the AUTHORS file for more information.
+ *
+ * The TNG library is free software; you can redistribute it and/or
+ * modify it under the terms of the Revised BSD License.
+ *
+ * To help us fund future development, we humbly ask that you cite
+ * the research papers on the package.
+ *
+ * Check out http://www.gromacs.org for more information.
+ */
+
+/* This code is part of the tng compression routines
+ * Written by Daniel Spangberg
+ */
+
+#include <stdlib.h>
+#include "../../include/compression/bitstream.h"
+
+#ifndef USE_WINDOWS
+#    if defined(WIN32) || defined(_WIN32) || defined(WIN64) || defined(_WIN64)
+#        define USE_WINDOWS
+#    endif /* win32... */
+#endif     /* not defined USE_WINDOWS */
+
+#ifdef USE_WINDOWS
+#    define TNG_INLINE __inline
+#else
+#    define TNG_INLINE inline
+#endif
+
+void DECLSPECDLLEXPORT Ptngc_bitreader_init(struct bitreader* reader, unsigned char* input)
+{
+    reader->ptr    = input;
+    reader->end    = NULL;
+    reader->buffer = 0;
+    reader->nbits  = 0;
+}
+
+void DECLSPECDLLEXPORT Ptngc_bitreader_init_bounded(struct bitreader* reader,
+                                                    unsigned char*    input,
+                                                    const int         length)
+{
+    Ptngc_bitreader_init(reader, input);
+    reader->end = input + length;
+}
+
+TNG_INLINE void DECLSPECDLLEXPORT Ptngc_bitreader_refill(struct bitreader* reader, const int nbits)
+{
+    /* At most 7 bits are left over before loading enough bytes for 32 bits,
+       so the buffer never holds more than 39 valid bits. */
+    while (reader->nbits < nbits)
+    {
+        reader->buffer <<= 8;
+        if (reader->ptr != reader->end)
+        {
+            reader->buffer |= (my_uint64_t)*reader->ptr++;
+        }
+        reader->nbits += 8;
+    }
+}
+
+TNG_INLINE unsigned int DECLSPECDLLEXPORT Ptngc_bitreader_peek(struct bitreader* reader, const int nbits)
+{
+    if (nbits == 0)
+    {
+        return 0U;
+    }
+    Ptngc_bitreader_refill(reader, nbits);
+    return (unsigned int)((reader->buffer >> (reader->nbits - nbits)) & (0xFFFFFFFFU >> (32 - nbits)));
+}
+
+TNG_INLINE void DECLSPECDLLEXPORT Ptngc_bitreader_consume(struct bitreader* reader, const int nbits)
+{
+    reader->nbits -= nbits;
+}
+
+TNG_INLINE unsigned int DECLSPECDLLEXPORT Ptngc_bitreader_read(struct bitreader* reader, const int nbits)
+{
+    unsigned int val = Ptngc_bitreader_peek(reader, nbits);
+    Ptngc_bitreader_consume(reader, nbits);
+    return val;
+}
+
+void DECLSPECDLLEXPORT Ptngc_bitreader_readmany(struct bitreader* reader, int nbits, unsigned char* buffer)
+{
+    while (nbits >= 32)
+    {
+        unsigned int val = Ptngc_bitreader_read(reader, 32);
+        *buffer++        = (unsigned char)(val >> 24);
+        *buffer++        = (unsigned char)(val >> 16);
+        *buffer++        = (unsigned char)(val >> 8);
+        *buffer++        = (unsigned char)val;
+        nbits -= 32;
+    }
+    while (nbits >= 8)
+    {
+        *buffer++ = (unsigned char)Ptngc_bitreader_read(reader, 8);
+        nbits -= 8;
+    }
+    if (nbits)
+    {
+        *buffer++ = (unsigned char)Ptngc_bitreader_read(reader, nbits);
+    }
+}
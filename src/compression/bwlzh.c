@@ -81,12 +81,12 @@ static void printvals(const char* name, unsigned int* vals, const int nvals)
 #endif
 
 
-static void bwlzh_compress_gen(unsigned int*  vals,
-                               const int      nvals,
-                               unsigned char* output,
-                               int*           output_len,
-                               const int      enable_lz77,
-                               const int      verbose)
+static int bwlzh_compress_gen(unsigned int*  vals,
+                              const int      nvals,
+                              unsigned char* output,
+                              int*           output_len,
+                              const int      enable_lz77,
+                              const int      verbose)
 {
     unsigned int* vals16;
     int           nvals16;
@@ -114,7 +114,8 @@ static void bwlzh_compress_gen(unsigned int*  vals,
     int            valsleft;
     int            thisvals;
     int            valstart;
-    int            outdata = 0;
+    int            outdata  = 0;
+    int*           lz77work = NULL;
 
     unsigned int* tmpmem = warnmalloc(max_vals_per_block * 18 * sizeof *tmpmem);
 
@@ -134,6 +135,10 @@ static void bwlzh_compress_gen(unsigned int*  vals,
                       * sizeof *mtf3); /* 3 due to expansion of 32 bit to 16 bit, 3 due to up to 3
                                           bytes per 16 value. */
 #endif
+    if (enable_lz77)
+    {
+        lz77work = warnmalloc(Ptngc_comp_lz77_work_len(max_vals_per_block * 3) * sizeof *lz77work);
+    }
     if (verbose)
     {
         fprintf(stderr, "Number of input values: %d\n", nvals);
@@ -188,7 +193,18 @@ static void bwlzh_compress_gen(unsigned int*  vals,
         {
             fprintf(stderr, "BWT\n");
         }
-        Ptngc_comp_to_bwt(vals16, nvals16, bwt, &bwt_index);
+        if (Ptngc_comp_to_bwt(vals16, nvals16, bwt, &bwt_index))
+        {
+            free(hist);
+            free(dict);
+            free(bwlzhhuff);
+#ifdef PARTIAL_MTF3
+            free(mtf3);
+#endif
+            free(tmpmem);
+            free(lz77work);
+            return 1;
+        }
 
 #ifdef SHOWIT
         printvals("bwt", bwt, nvals16);
@@ -252,7 +268,8 @@ static void bwlzh_compress_gen(unsigned int*  vals,
                     fprintf(stderr, "LZ77\n");
                 }
                 reducealgo = 1;
-                Ptngc_comp_to_lz77(mtf, nvals16, rle, &nrle, lens, &nlens, offsets, &noffsets);
+                Ptngc_comp_to_lz77_work(mtf, nvals16, rle, &nrle, lens, &nlens, offsets, &noffsets,
+                                        lz77work);
 
                 if (verbose)
                 {
@@ -513,37 +530,39 @@ static void bwlzh_compress_gen(unsigned int*  vals,
     free(mtf3);
 #endif
     free(tmpmem);
+    free(lz77work);
+    return 0;
 }
 
 
-void DECLSPECDLLEXPORT bwlzh_compress(unsigned int* vals, const int nvals, unsigned char* output, int* output_len)
+int DECLSPECDLLEXPORT bwlzh_compress(unsigned int* vals, const int nvals, unsigned char* output, int* output_len)
 {
-    bwlzh_compress_gen(vals, nvals, output, output_len, 1, 0);
+    return bwlzh_compress_gen(vals, nvals, output, output_len, 1, 0);
 }
 
-void DECLSPECDLLEXPORT bwlzh_compress_verbose(unsigned int*  vals,
-                                              const int      nvals,
-                                              unsigned char* output,
-                                              int*           output_len)
+int DECLSPECDLLEXPORT bwlzh_compress_verbose(unsigned int*  vals,
+                                             const int      nvals,
+                                             unsigned char* output,
+                                             int*           output_len)
 {
-    bwlzh_compress_gen(vals, nvals, output, output_len, 1, 1);
+    return bwlzh_compress_gen(vals, nvals, output, output_len, 1, 1);
 }
 
 
-void DECLSPECDLLEXPORT bwlzh_compress_no_lz77(unsigned int*  vals,
-                                              const int      nvals,
-                                              unsigned char* output,
-                                              int*           output_len)
+int DECLSPECDLLEXPORT bwlzh_compress_no_lz77(unsigned int*  vals,
+                                             const int      nvals,
+                                             unsigned char* output,
+                                             int*           output_len)
 {
-    bwlzh_compress_gen(vals, nvals, output, output_len, 0, 0);
+    return bwlzh_compress_gen(vals, nvals, output, output_len, 0, 0);
 }
 
-void DECLSPECDLLEXPORT bwlzh_compress_no_lz77_verbose(unsigned int*  vals,
-                                                      const int      nvals,
-                                                      unsigned char* output,
-                                                      int*           output_len)
+int DECLSPECDLLEXPORT bwlzh_compress_no_lz77_verbose(unsigned int*  vals,
+                                                     const int      nvals,
+                                                     unsigned char* output,
+                                                     int*           output_len)
 {
-    bwlzh_compress_gen(vals, nvals, output, output_len, 0, 1);
+    return bwlzh_compress_gen(vals, nvals, output, output_len, 0, 1);
 }
 
 
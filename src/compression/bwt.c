@@ -28,327 +28,345 @@
 #include "../../include/compression/warnmalloc.h"
 #include "../../include/compression/bwt.h"
 
-#if 0
-#    define SHOWIT
-#endif
-#if 0
-#    define SHOWIT2
-#endif
+/* Suffix array construction by induced sorting (SA-IS), see Nong, Zhang
+   and Chan, "Two Efficient Algorithms for Linear Time Suffix Array
+   Construction", IEEE Transactions on Computers 60 (2011). The string s
+   of length n must end with a unique 0, the smallest of the k symbols. */
 
-static int compare_index(int i1, int i2, const int nvals, const unsigned int* vals, const unsigned int* nrepeat)
+/* Is position i the leftmost S type position of a run? */
+#define IS_LMS(t, i) (((i) > 0) && (t)[i] && !(t)[(i)-1])
+
+static void sais_buckets(const int* s, const int n, const int k, int* bkt, const int end)
 {
-    int i, j;
-    for (i = 0; i < nvals; i++)
+    int i, sum = 0;
+    memset(bkt, 0, k * sizeof *bkt);
+    for (i = 0; i < n; i++)
     {
-        /* If we have repeating patterns, we might be able to start the
-           comparison later in the string. */
-        /* Do we have a repeating pattern? If so are
-           the repeating patterns the same length? */
-        int repeat1 = (int)(nrepeat[i1] >> 8);
-        int k1      = (int)(nrepeat[i1] & 0xFFU);
-        int repeat2 = (int)(nrepeat[i2] >> 8);
-        int k2      = (int)(nrepeat[i2] & 0xFFU);
-
-        if ((repeat1 > 1) && (repeat2 > 1) && (k1 == k2))
-        {
-            int maxskip = 0;
-            /* Yes. Compare the repeating patterns. */
-            for (j = 0; j < k1; j++)
-            {
-                unsigned int v1 = vals[(i1 + j) % nvals];
-                unsigned int v2 = vals[(i2 + j) % nvals];
-                if (v1 < v2)
-                {
-                    return -1;
-                }
-                else if (v1 > v2)
-                {
-                    return 1;
-                }
-            }
-            /* The repeating patterns are equal. Skip as far as we can
-               before continuing. */
-            maxskip = repeat1;
-            if (repeat2 < repeat1)
-            {
-                maxskip = repeat2;
-            }
-            i1 = (i1 + maxskip) % nvals;
-            i2 = (i2 + maxskip) % nvals;
-            i += maxskip - 1;
-        }
-        else
-        {
-            if (vals[i1] < vals[i2])
-            {
-                return -1;
-            }
-            else if (vals[i1] > vals[i2])
-            {
-                return 1;
-            }
-            i1++;
-            if (i1 >= nvals)
-            {
-                i1 = 0;
-            }
-            i2++;
-            if (i2 >= nvals)
-            {
-                i2 = 0;
-            }
-        }
+        bkt[s[i]]++;
+    }
+    for (i = 0; i < k; i++)
+    {
+        sum += bkt[i];
+        bkt[i] = end ? sum : sum - bkt[i];
     }
-    return 0;
 }
 
-void Ptngc_bwt_merge_sort_inner(int*          indices,
-                                const int     nvals,
-                                unsigned int* vals,
-                                const int     start,
-                                const int     end,
-                                unsigned int* nrepeat,
-                                int*          workarray)
+static void sais_induce(const int*           s,
+                        const unsigned char* t,
+                        int*                 sa,
+                        const int            n,
+                        const int            k,
+                        int*                 bkt)
 {
-    int middle;
-    if ((end - start) > 1)
-    {
-        middle = start + (end - start) / 2;
-#if 0
-      printf("For start %d end %d obtained new middle: %d\n",start,end,middle);
-#endif
-        Ptngc_bwt_merge_sort_inner(indices, nvals, vals, start, middle, nrepeat, workarray);
-        Ptngc_bwt_merge_sort_inner(indices, nvals, vals, middle, end, nrepeat, workarray);
-#if 0
-      printf("For start %d end %d Before merge: Comparing element %d with %d\n",start,end,middle-1,middle);
-#endif
-        if (compare_index(indices[middle - 1], indices[middle], nvals, vals, nrepeat) > 0)
+    int i, j;
+    /* Induce the L type suffixes from the start of their buckets... */
+    sais_buckets(s, n, k, bkt, 0);
+    for (i = 0; i < n; i++)
+    {
+        j = sa[i] - 1;
+        if ((sa[i] > 0) && !t[j])
         {
-            /* Merge to work array. */
-            int i, n = end - start;
-            int ileft  = start;
-            int iright = middle;
-            for (i = 0; i < n; i++)
-            {
-                if (ileft == middle)
-                {
-                    workarray[i] = indices[iright];
-                    iright++;
-                }
-                else if (iright == end)
-                {
-                    workarray[i] = indices[ileft];
-                    ileft++;
-                }
-                else
-                {
-#if 0
-                  printf("For start %d end %d In merge: Comparing element %d with %d\n",start,end,ileft,iright);
-#endif
-                    if (compare_index(indices[ileft], indices[iright], nvals, vals, nrepeat) > 0)
-                    {
-                        workarray[i] = indices[iright];
-                        iright++;
-                    }
-                    else
-                    {
-                        workarray[i] = indices[ileft];
-                        ileft++;
-                    }
-                }
-            }
-            /* Copy result back. */
-            memcpy(indices + start, workarray, (end - start) * sizeof(int));
+            sa[bkt[s[j]]++] = j;
+        }
+    }
+    /* ... and then the S type suffixes from the ends. */
+    sais_buckets(s, n, k, bkt, 1);
+    for (i = n - 1; i >= 0; i--)
+    {
+        j = sa[i] - 1;
+        if ((sa[i] > 0) && t[j])
+        {
+            sa[--bkt[s[j]]] = j;
         }
     }
 }
 
-/* Burrows-Wheeler transform. */
-void Ptngc_comp_to_bwt(unsigned int* vals, const int nvals, unsigned int* output, int* index)
+static void sais(const int* s, int* sa, const int n, const int k)
 {
-    int           i;
-    int*          indices = warnmalloc(2 * nvals * sizeof *indices);
-    unsigned int* nrepeat = warnmalloc(nvals * sizeof *nrepeat);
-    int*          warr    = indices + nvals;
+    unsigned char* t   = warnmalloc(n * sizeof *t); /* 1 for S type and 0 for L type. */
+    int*           bkt = warnmalloc(k * sizeof *bkt);
+    int*           s1;
+    int            i, j, n1, name, prev;
 
-    if (nvals > 0xFFFFFF)
+    t[n - 1] = 1;
+    if (n > 1)
     {
-        fprintf(stderr, "BWT cannot pack more than %d values.\n", 0xFFFFFF);
-        exit(1);
+        t[n - 2] = 0;
     }
-
-    /* Also note that repeat pattern k (kmax) cannot be larger than 255. */
-#if 0
-  printf("Size of arrays is %.2f M\n",4*nvals*sizeof *indices/1024./1024.);
-#endif
-    for (i = 0; i < nvals; i++)
+    for (i = n - 3; i >= 0; i--)
     {
-        indices[i] = i;
+        t[i] = (unsigned char)((s[i] < s[i + 1]) || ((s[i] == s[i + 1]) && t[i + 1]));
     }
-    /* Find the length of the initial repeating pattern for the strings. */
-    /* First mark that the index does not have a found repeating string. */
 
-    memset(nrepeat, 0U, sizeof(unsigned int) * nvals);
+    /* Sort the LMS substrings. */
+    sais_buckets(s, n, k, bkt, 1);
+    for (i = 0; i < n; i++)
+    {
+        sa[i] = -1;
+    }
+    for (i = 1; i < n; i++)
+    {
+        if (IS_LMS(t, i))
+        {
+            sa[--bkt[s[i]]] = i;
+        }
+    }
+    sais_induce(s, t, sa, n, k, bkt);
 
-#ifdef SHOWIT
-    printf("nvals is %d\n", nvals);
-#endif
-    for (i = 0; i < nvals; i++)
+    /* Move the sorted LMS substrings to the start of sa and name them.
+       There are at most n/2 of them, and they are at least two positions
+       apart, so the names can be stored at n1 + position/2. */
+    n1 = 0;
+    for (i = 0; i < n; i++)
     {
-        /* If we have not already found a repeating string we must find
-           it. */
-        if (!nrepeat[i])
+        if (IS_LMS(t, sa[i]))
         {
-            int maxrepeat = nvals * 2;
-            int j, k, m;
-            int good_j = -1, good_k = 0;
-            int kmax = 16;
-            /* Track repeating patterns.
-               k=1 corresponds to AAAAA...
-               k=2 corresponds to ABABAB...
-               k=3 corresponds to ABCABCABCABC...
-               k=4 corresponds to ABCDABCDABCD...
-               etc. */
-            for (k = kmax; k >= 1; k--)
-            {
-            try_next_k:
-                if (k >= 1)
-                {
-#ifdef SHOWIT
-                    printf("Trying k=%d at i=%d\n", k, i);
-#endif
-                    for (j = k; j < maxrepeat; j += k)
-                    {
-                        int is_equal = 1;
-#ifdef SHOWIT
-                        printf("Trying j=%d at i=%d for k %d\n", j, i, k);
-#endif
-                        for (m = 0; m < k; m++)
-                        {
-                            if (vals[(i + m) % nvals] != vals[(i + j + m) % nvals])
-                            {
-                                is_equal = 0;
-                                break;
-                            }
-                        }
-                        if (is_equal)
-                        {
-                            int new_j = j + k;
-                            if (new_j > maxrepeat)
-                            {
-                                new_j = j;
-                            }
-                            if ((new_j > good_j) || ((new_j == good_j) && (k < good_k)))
-                            {
-                                good_j = new_j; /* We have found that
-                                                 the strings repeat
-                                                 for this length... */
-                                good_k = k;     /* ...and with this
-                                                   length of the
-                                                   repeating
-                                                   pattern. */
-#ifdef SHOWIT
-                                printf("Best j and k is now %d and %d\n", good_j, good_k);
-#endif
-                            }
-                        }
-                        else
-                        {
-                            /* We know that it is no point in trying
-                               with more than m */
-                            if (j == 0)
-                            {
-                                k = m;
-#ifdef SHOWIT
-                                printf("Setting new k to m: %d\n", k);
-#endif
-                            }
-                            else
-                            {
-                                k--;
-                            }
-#ifdef SHOWIT
-                            printf("Trying next k\n");
-#endif
-                            goto try_next_k;
-                        }
-                    }
-                }
-            }
-            /* From good_j and good_k we know the repeat for a large
-               number of strings. The very last repeat length should not
-               be assigned, since it can be much longer if a new test is
-               done. */
-            for (m = 0; (m + good_k < good_j) && (i + m < nvals); m += good_k)
+            sa[n1++] = sa[i];
+        }
+    }
+    for (i = n1; i < n; i++)
+    {
+        sa[i] = -1;
+    }
+    name = 0;
+    prev = -1;
+    for (i = 0; i < n1; i++)
+    {
+        int pos  = sa[i];
+        int diff = 0;
+        int d;
+        for (d = 0; d < n; d++)
+        {
+            if ((prev == -1) || (s[pos + d] != s[prev + d]) || (t[pos + d] != t[prev + d]))
             {
-                int repeat = good_j - m;
-                if (repeat > nvals)
-                {
-                    repeat = nvals;
-                }
-                nrepeat[i + m] = ((unsigned int)(good_k)) | (((unsigned int)(repeat)) << 8);
+                diff = 1;
+                break;
             }
-            /* If no repetition was found for this value signal that here. */
-            if (!nrepeat[i])
+            else if ((d > 0) && (IS_LMS(t, pos + d) || IS_LMS(t, prev + d)))
             {
-                nrepeat[i + m] = 257U; /* This is 1<<8 | 1 */
+                break;
             }
         }
+        if (diff)
+        {
+            name++;
+            prev = pos;
+        }
+        sa[n1 + pos / 2] = name - 1;
     }
-#ifdef SHOWIT
-    for (i = 0; i < nvals; i++)
+    for (i = n - 1, j = n - 1; i >= n1; i--)
+    {
+        if (sa[i] >= 0)
+        {
+            sa[j--] = sa[i];
+        }
+    }
+
+    /* Sort the reduced string. If all names are unique it is already sorted. */
+    s1 = sa + n - n1;
+    if (name < n1)
+    {
+        sais(s1, sa, n1, name);
+    }
+    else
     {
-        if ((nrepeat[i] >> 8) != 1)
+        for (i = 0; i < n1; i++)
         {
-            printf("String repeats at %d: %d %d\n", i, nrepeat[i] >> 8, nrepeat[i] & 0xFFU);
+            sa[s1[i]] = i;
         }
     }
-#endif
 
-    /* Sort cyclic shift matrix. */
-    Ptngc_bwt_merge_sort_inner(indices, nvals, vals, 0, nvals, nrepeat, warr);
+    /* Put the sorted LMS suffixes at the ends of their buckets and induce the rest. */
+    for (i = 1, j = 0; i < n; i++)
+    {
+        if (IS_LMS(t, i))
+        {
+            s1[j++] = i;
+        }
+    }
+    for (i = 0; i < n1; i++)
+    {
+        sa[i] = s1[sa[i]];
+    }
+    for (i = n1; i < n; i++)
+    {
+        sa[i] = -1;
+    }
+    sais_buckets(s, n, k, bkt, 1);
+    for (i = n1 - 1; i >= 0; i--)
+    {
+        j               = sa[i];
+        sa[i]           = -1;
+        sa[--bkt[s[j]]] = j;
+    }
+    sais_induce(s, t, sa, n, k, bkt);
+    free(bkt);
+    free(t);
+}
 
-#if 0
-  /* Test that it really is sorted. */
-  for (i=0; i<nvals-1; i++)
-    if (compare_index(indices[i],indices[i+1],nvals,vals,nrepeat)!=-1)
-      fprintf(stderr,"SORTING NOT COMPLETED AT %d. Index %d against %d\n",i,indices[i],indices[i+1]);
+static int comp_uint(const void* v1, const void* v2)
+{
+    const unsigned int* i1 = (const unsigned int*)v1;
+    const unsigned int* i2 = (const unsigned int*)v2;
+    if (*i1 < *i2)
+    {
+        return -1;
+    }
+    else if (*i1 > *i2)
+    {
+        return 1;
+    }
+    return 0;
+}
 
-#endif
+/* Burrows-Wheeler transform. The cyclic shifts are sorted in the same
+   order as a stable sort of the shifts would give, i.e. equal shifts
+   (only possible if the input is a repeated pattern) are ordered by
+   their position. Returns 0 on success and 1 if nvals is too large. */
+int Ptngc_comp_to_bwt(unsigned int* vals, const int nvals, unsigned int* output, int* index)
+{
+    int          i, j, n, nsymbols;
+    int*         s;
+    int*         sa;
+    int*         next;
+    unsigned int maxval;
 
+    if (nvals > (0x7FFFFFFF - 1) / 2)
+    {
+        fprintf(stderr, "BWT cannot pack more than %d values.\n", (0x7FFFFFFF - 1) / 2);
+        return 1;
+    }
+    if (nvals <= 0)
+    {
+        *index = 0;
+        return 0;
+    }
 
-#ifdef SHOWIT2
-    for (i = 0; i < nvals; i++)
+    /* Find the shortest pattern that the input is a repeat of (using the
+       prefix function of the Knuth-Morris-Pratt algorithm). The shifts of
+       the input are then the shifts of the pattern, each repeated nvals/n
+       times. */
+    next    = warnmalloc(nvals * sizeof *next);
+    next[0] = 0;
+    for (i = 1; i < nvals; i++)
     {
-        int j;
-        for (j = 0; j < nvals; j++)
+        j = next[i - 1];
+        while ((j > 0) && (vals[i] != vals[j]))
+        {
+            j = next[j - 1];
+        }
+        if (vals[i] == vals[j])
         {
-            printf("%c", vals[(indices[i] + j) % nvals]);
+            j++;
         }
-        printf("\n");
+        next[i] = j;
     }
-#endif
-    /* Which one is the original string? */
-    for (i = 0; i < nvals; i++)
+    n = nvals - next[nvals - 1];
+    if (nvals % n)
+    {
+        n = nvals;
+    }
+
+    /* The shifts of the pattern are in the same order as the suffixes of
+       the pattern repeated twice that start in the first copy. All the
+       shifts are different, so they differ in the first n symbols. The
+       symbols are ranked so that the alphabet is dense, and 0 is reserved
+       for the end of the string. */
+    s  = warnmalloc((2 * n + 1) * sizeof *s);
+    sa = warnmalloc((2 * n + 1) * sizeof *sa);
+    free(next);
+    maxval = 0;
+    for (i = 0; i < n; i++)
     {
-        if (indices[i] == 0)
+        if (vals[i] > maxval)
         {
-            break;
+            maxval = vals[i];
         }
     }
-    *index = i;
+    if ((maxval < 0x20000U) || (maxval / 2 < (unsigned int)n))
+    {
+        /* Small alphabet (always the case for bwlzh). Rank by table lookup. */
+        int* rank = warnmalloc((maxval + 1) * sizeof *rank);
+        memset(rank, 0, (maxval + 1) * sizeof *rank);
+        for (i = 0; i < n; i++)
+        {
+            rank[vals[i]] = 1;
+        }
+        nsymbols = 0;
+        for (i = 0; i <= (int)maxval; i++)
+        {
+            if (rank[i])
+            {
+                rank[i] = ++nsymbols;
+            }
+        }
+        for (i = 0; i < n; i++)
+        {
+            s[i] = rank[vals[i]];
+        }
+        free(rank);
+    }
+    else
+    {
+        /* Rank by binary search in the sorted symbols. */
+        unsigned int* symbols = warnmalloc(n * sizeof *symbols);
+        memcpy(symbols, vals, n * sizeof *symbols);
+        qsort(symbols, n, sizeof *symbols, comp_uint);
+        nsymbols = 0;
+        for (i = 0; i < n; i++)
+        {
+            if ((i == 0) || (symbols[i] != symbols[nsymbols - 1]))
+            {
+                symbols[nsymbols++] = symbols[i];
+            }
+        }
+        for (i = 0; i < n; i++)
+        {
+            int low = 0, high = nsymbols - 1;
+            while (low < high)
+            {
+                int middle = low + (high - low) / 2;
+                if (symbols[middle] < vals[i])
+                {
+                    low = middle + 1;
+                }
+                else
+                {
+                    high = middle;
+                }
+            }
+            s[i] = low + 1;
+        }
+        free(symbols);
+    }
+    for (i = 0; i < n; i++)
+    {
+        s[i + n] = s[i];
+    }
+    s[2 * n] = 0;
+    sais(s, sa, 2 * n + 1, nsymbols + 1);
+    free(s);
+
     /* Form output. */
-    for (i = 0; i < nvals; i++)
+    j = 0;
+    for (i = 0; i < 2 * n + 1; i++)
     {
-        int lastchar = indices[i] - 1;
-        if (lastchar < 0)
+        if (sa[i] < n)
         {
-            lastchar = nvals - 1;
+            int shift;
+            for (shift = sa[i]; shift < nvals; shift += n)
+            {
+                if (shift == 0)
+                {
+                    /* This is the original string. */
+                    *index = j;
+                }
+                output[j++] = vals[shift ? shift - 1 : nvals - 1];
+            }
         }
-        output[i] = vals[lastchar];
     }
-    free(nrepeat);
-    free(indices);
+    free(sa);
+    return 0;
 }
 
 /* Burrows-Wheeler inverse transform. */
@@ -25,6 +25,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include "../../include/compression/tng_compress.h"
+#include "../../include/compression/bitstream.h"
 #include "../../include/compression/bwlzh.h"
 #include "../../include/compression/coder.h"
 #include "../../include/compression/warnmalloc.h"
@@ -59,15 +60,12 @@ TNG_INLINE void DECLSPECDLLEXPORT Ptngc_out8bits(struct coder* coder_inst, unsig
 {
     while (coder_inst->pack_temporary_bits >= 8)
     {
-        unsigned int  mask;
-        unsigned char out;
         coder_inst->pack_temporary_bits -= 8;
-        mask     = ~(0xFFU << (coder_inst->pack_temporary_bits));
-        out      = (unsigned char)(coder_inst->pack_temporary >> (coder_inst->pack_temporary_bits));
-        **output = out;
+        **output = (unsigned char)(coder_inst->pack_temporary >> (coder_inst->pack_temporary_bits));
         (*output)++;
-        coder_inst->pack_temporary &= mask;
     }
+    /* Only keep the bits that have not been written. */
+    coder_inst->pack_temporary &= ~(((my_uint64_t)0xFFU) << (coder_inst->pack_temporary_bits));
 }
 
 void DECLSPECDLLEXPORT Ptngc_write_pattern(struct coder*   coder_inst,
@@ -75,66 +73,46 @@ void DECLSPECDLLEXPORT Ptngc_write_pattern(struct coder*   coder_inst,
                                            int             nbits,
                                            unsigned char** output)
 {
-    unsigned int mask1, mask2;
-    mask1 = 1;
-    mask2 = 1 << (nbits - 1);
-    coder_inst->pack_temporary <<= nbits; /* Make room for new data. */
-    coder_inst->pack_temporary_bits += nbits;
-    while (nbits)
+    if (!nbits)
     {
-        if (pattern & mask1)
-        {
-            coder_inst->pack_temporary |= mask2;
-        }
-        nbits--;
-        mask1 <<= 1;
-        mask2 >>= 1;
+        return;
     }
+    /* The pattern is written starting with its lowest bit, i.e. reversed. */
+    pattern = ((pattern >> 1) & 0x55555555U) | ((pattern & 0x55555555U) << 1);
+    pattern = ((pattern >> 2) & 0x33333333U) | ((pattern & 0x33333333U) << 2);
+    pattern = ((pattern >> 4) & 0x0F0F0F0FU) | ((pattern & 0x0F0F0F0FU) << 4);
+    pattern = ((pattern >> 8) & 0x00FF00FFU) | ((pattern & 0x00FF00FFU) << 8);
+    pattern = (pattern >> 16) | (pattern << 16);
+    coder_inst->pack_temporary <<= nbits; /* Make room for new data. */
+    coder_inst->pack_temporary_bits += nbits;
+    coder_inst->pack_temporary |= pattern >> (32 - nbits);
     Ptngc_out8bits(coder_inst, output);
 }
 
-/* Write up to 24 bits */
+/* Write up to 32 bits */
 TNG_INLINE void DECLSPECDLLEXPORT Ptngc_writebits(struct coder*   coder_inst,
                                                   unsigned int    value,
                                                   const int       nbits,
                                                   unsigned char** output_ptr)
 {
-    /* Make room for the bits. */
+    /* Make room for the bits. At most 7 bits are pending, so they fit in the 64 bit buffer. */
     coder_inst->pack_temporary <<= nbits;
     coder_inst->pack_temporary_bits += nbits;
     coder_inst->pack_temporary |= value;
     Ptngc_out8bits(coder_inst, output_ptr);
 }
 
-/* Write up to 32 bits */
+/* Write up to 32 bits, ignoring bits of value above nbits */
 void DECLSPECDLLEXPORT Ptngc_write32bits(struct coder*   coder_inst,
                                          unsigned int    value,
                                          int             nbits,
                                          unsigned char** output_ptr)
 {
-    unsigned int mask;
-    if (nbits >= 8)
+    if (nbits < 32)
     {
-        mask = 0xFFU << (nbits - 8);
-    }
-    else
-    {
-        mask = 0xFFU >> (8 - nbits);
-    }
-    while (nbits > 8)
-    {
-        /* Make room for the bits. */
-        nbits -= 8;
-        coder_inst->pack_temporary <<= 8;
-        coder_inst->pack_temporary_bits += 8;
-        coder_inst->pack_temporary |= (value & mask) >> (nbits);
-        Ptngc_out8bits(coder_inst, output_ptr);
-        mask >>= 8;
-    }
-    if (nbits)
-    {
-        Ptngc_writebits(coder_inst, value & mask, nbits, output_ptr);
+        value &= ~(0xFFFFFFFFU << nbits);
     }
+    Ptngc_writebits(coder_inst, value, nbits, output_ptr);
 }
 
 /* Write "arbitrary" number of bits */
@@ -144,13 +122,13 @@ void DECLSPECDLLEXPORT Ptngc_writemanybits(struct coder*   coder_inst,
                                            unsigned char** output_ptr)
 {
     int vptr = 0;
-    while (nbits >= 24)
+    while (nbits >= 32)
     {
-        unsigned int v = ((((unsigned int)value[vptr]) << 16) | (((unsigned int)value[vptr + 1]) << 8)
-                          | (((unsigned int)value[vptr + 2])));
-        Ptngc_writebits(coder_inst, v, 24, output_ptr);
-        vptr += 3;
-        nbits -= 24;
+        unsigned int v = ((((unsigned int)value[vptr]) << 24) | (((unsigned int)value[vptr + 1]) << 16)
+                          | (((unsigned int)value[vptr + 2]) << 8) | (((unsigned int)value[vptr + 3])));
+        Ptngc_writebits(coder_inst, v, 32, output_ptr);
+        vptr += 4;
+        nbits -= 32;
     }
     while (nbits >= 8)
     {
@@ -279,6 +257,7 @@ unsigned char DECLSPECDLLEXPORT* Ptngc_pack_array(struct coder* coder_inst,
         int            nframes       = n / natoms / 3;
         int            cnt           = 0;
         int            most_negative = 2147483647;
+        int            error;
         for (i = 0; i < n; i++)
         {
             if (input[i] < most_negative)
@@ -304,11 +283,17 @@ unsigned char DECLSPECDLLEXPORT* Ptngc_pack_array(struct coder* coder_inst,
         }
         if (speed >= 5)
         {
-            bwlzh_compress(pval, n, output + 4, length);
+            error = bwlzh_compress(pval, n, output + 4, length);
         }
         else
         {
-            bwlzh_compress_no_lz77(pval, n, output + 4, length);
+            error = bwlzh_compress_no_lz77(pval, n, output + 4, length);
+        }
+        if (error)
+        {
+            free(pval);
+            free(output);
+            return NULL;
         }
         (*length) += 4;
         free(pval);
@@ -418,43 +403,30 @@ static int unpack_array_stop_bits(struct coder*  coder_inst,
                                   const int      length,
                                   const int      coding_parameter)
 {
-    int            i, j;
-    unsigned int   extract_mask = 0x80;
-    unsigned char* ptr          = packed;
+    int              i;
+    struct bitreader reader;
     (void)coder_inst;
+    Ptngc_bitreader_init(&reader, packed);
     for (i = 0; i < length; i++)
     {
-        unsigned int pattern = 0;
-        int          numbits = coding_parameter;
+        unsigned int pattern       = 0;
+        int          numbits       = coding_parameter;
+        int          inserted_bits = 0;
         unsigned int bit;
         int          s;
-        unsigned int insert_mask   = 1U << (numbits - 1);
-        int          inserted_bits = numbits;
         do
         {
-            for (j = 0; j < numbits; j++)
+            /* The low bits come first, each chunk is followed by a stop bit. */
+            if (inserted_bits < 32)
             {
-                bit = *ptr & extract_mask;
-                if (bit)
-                {
-                    pattern |= insert_mask;
-                }
-                insert_mask >>= 1;
-                extract_mask >>= 1;
-                if (!extract_mask)
-                {
-                    extract_mask = 0x80;
-                    ptr++;
-                }
+                pattern |= Ptngc_bitreader_read(&reader, numbits) << inserted_bits;
             }
-            /* Check stop bit */
-            bit = *ptr & extract_mask;
-            extract_mask >>= 1;
-            if (!extract_mask)
+            else
             {
-                extract_mask = 0x80;
-                ptr++;
+                Ptngc_bitreader_read(&reader, numbits);
             }
+            inserted_bits += numbits;
+            bit = Ptngc_bitreader_read(&reader, 1);
             if (bit)
             {
                 numbits >>= 1;
@@ -462,8 +434,6 @@ static int unpack_array_stop_bits(struct coder*  coder_inst,
                 {
                     numbits = 1;
                 }
-                inserted_bits += numbits;
-                insert_mask = 1U << (inserted_bits - 1);
             }
         } while (bit);
         s = (pattern + 1) / 2;
@@ -482,18 +452,17 @@ static int unpack_array_triplet(struct coder*  coder_inst,
                                 int            length,
                                 const int      coding_parameter)
 {
-    int            i, j;
-    unsigned int   extract_mask = 0x80;
-    unsigned char* ptr          = packed;
+    int              i, j;
+    struct bitreader reader;
     /* Determine max base and maxbits */
     unsigned int max_base = 1U << coding_parameter;
     unsigned int maxbits  = coding_parameter;
     unsigned int intmax;
     /* Get intmax */
     (void)coder_inst;
-    intmax = ((unsigned int)ptr[0]) << 24 | ((unsigned int)ptr[1]) << 16
-             | ((unsigned int)ptr[2]) << 8 | ((unsigned int)ptr[3]);
-    ptr += 4;
+    intmax = ((unsigned int)packed[0]) << 24 | ((unsigned int)packed[1]) << 16
+             | ((unsigned int)packed[2]) << 8 | ((unsigned int)packed[3]);
+    Ptngc_bitreader_init(&reader, packed + 4);
     while (intmax >= max_base)
     {
         max_base *= 2;
@@ -503,24 +472,8 @@ static int unpack_array_triplet(struct coder*  coder_inst,
     for (i = 0; i < length; i++)
     {
         /* Find base */
-        unsigned int jbase = 0;
+        unsigned int jbase = Ptngc_bitreader_read(&reader, 2);
         unsigned int numbits;
-        unsigned int bit;
-        for (j = 0; j < 2; j++)
-        {
-            bit = *ptr & extract_mask;
-            jbase <<= 1;
-            if (bit)
-            {
-                jbase |= 1U;
-            }
-            extract_mask >>= 1;
-            if (!extract_mask)
-            {
-                extract_mask = 0x80;
-                ptr++;
-            }
-        }
         if (jbase == 3)
         {
             numbits = maxbits;
@@ -532,24 +485,8 @@ static int unpack_array_triplet(struct coder*  coder_inst,
         for (j = 0; j < 3; j++)
         {
             int          s;
-            unsigned int jbit;
-            unsigned int pattern = 0;
-            for (jbit = 0; jbit < numbits; jbit++)
-            {
-                bit = *ptr & extract_mask;
-                pattern <<= 1;
-                if (bit)
-                {
-                    pattern |= 1U;
-                }
-                extract_mask >>= 1;
-                if (!extract_mask)
-                {
-                    extract_mask = 0x80;
-                    ptr++;
-                }
-            }
-            s = (pattern + 1) / 2;
+            unsigned int pattern = Ptngc_bitreader_read(&reader, (int)numbits);
+            s                    = (pattern + 1) / 2;
             if ((pattern % 2) == 0)
             {
                 s = -s;
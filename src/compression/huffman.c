@@ -25,12 +25,17 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include "../../include/compression/bitstream.h"
 #include "../../include/compression/warnmalloc.h"
 #include "../../include/compression/merge_sort.h"
 #include "../../include/compression/huffman.h"
 
 #define MAX_HUFFMAN_LEN 31
 
+/* Number of bits resolved by the first lookup when decoding. Longer
+   codes continue in a subtable. */
+#define HUFFMAN_TABLE_BITS 10
+
 enum htree_type
 {
     htree_leaf,
@@ -68,6 +73,12 @@ struct codelength
     unsigned int prob;
 };
 
+struct huffman_table_entry
+{
+    unsigned int value;  /* The symbol, or the offset of a subtable. */
+    int          length; /* Bits used by the symbol, or minus the bits of a subtable. */
+};
+
 static int comp_htree(const void* leafptr1, const void* leafptr2, const void* private)
 {
     const union htree_nodeleaf* leaf1 = (union htree_nodeleaf*)leafptr1;
@@ -188,28 +199,6 @@ static void writebits(unsigned int value, int length, unsigned char** output, in
     **output = (unsigned char)combine;
 }
 
-static unsigned int readbits(int length, unsigned char** input, int* bitptr)
-{
-    unsigned int  val          = 0U;
-    unsigned int  extract_mask = 0x80U >> *bitptr;
-    unsigned char thisval      = **input;
-    while (length--)
-    {
-        val <<= 1;
-        val |= ((extract_mask & thisval) != 0);
-        *bitptr = (*bitptr) + 1;
-        extract_mask >>= 1;
-        if (!extract_mask)
-        {
-            extract_mask = 0x80U;
-            *input       = (*input) + 1;
-            *bitptr      = 0;
-            thisval      = **input;
-        }
-    }
-    return val;
-}
-
 static int comp_codes(const void* codeptr1, const void* codeptr2, const void* private)
 {
     const struct codelength* code1 = (struct codelength*)codeptr1;
@@ -220,11 +209,11 @@ static int comp_codes(const void* codeptr1, const void* codeptr2, const void* pr
     {
         rval = 1;
     }
-    if (code1->length < code2->length)
+    else if (code1->length < code2->length)
     {
         rval = -1;
     }
-    if (code1->dict > code2->dict)
+    else if (code1->dict > code2->dict)
     {
         rval = 1;
     }
@@ -529,7 +518,92 @@ void Ptngc_comp_conv_to_huffman(const unsigned int* vals,
     free(codelength);
 }
 
+/* Build a lookup table for decoding the canonical codes in codelength,
+   which must be sorted wrt length/value. Codes of up to table_bits bits
+   are resolved by one lookup, longer codes by one more lookup in a
+   subtable holding all codes that share the same table_bits prefix. */
+static struct huffman_table_entry* huffman_decode_table(const struct codelength* codelength,
+                                                       const int                ndict,
+                                                       int*                     table_bits)
+{
+    struct huffman_table_entry* table;
+    int                         nbits = codelength[ndict - 1].length;
+    int                         ntable;
+    int                         i, j;
+    if (nbits > HUFFMAN_TABLE_BITS)
+    {
+        nbits = HUFFMAN_TABLE_BITS;
+    }
+    /* Find the size of the table including subtables. Codes sharing a
+       prefix are consecutive and the last of them is the longest. */
+    ntable = 1 << nbits;
+    for (i = 0; i < ndict; i = j)
+    {
+        j = i + 1;
+        if (codelength[i].length > nbits)
+        {
+            unsigned int prefix = codelength[i].code >> (codelength[i].length - nbits);
+            while ((j < ndict) && ((codelength[j].code >> (codelength[j].length - nbits)) == prefix))
+            {
+                j++;
+            }
+            ntable += 1 << (codelength[j - 1].length - nbits);
+        }
+    }
+    table = warnmalloc(ntable * sizeof *table);
+    /* Unused entries (only for broken dictionaries) decode to symbol 0 without using any bits. */
+    memset(table, 0, ntable * sizeof *table);
+    ntable = 1 << nbits;
+    for (i = 0; i < ndict; i = j)
+    {
+        j = i + 1;
+        if (codelength[i].length <= nbits)
+        {
+            int          fill  = 1 << (nbits - codelength[i].length);
+            unsigned int first = codelength[i].code << (nbits - codelength[i].length);
+            int          k;
+            for (k = 0; k < fill; k++)
+            {
+                table[first + k].value  = codelength[i].dict;
+                table[first + k].length = codelength[i].length;
+            }
+        }
+        else
+        {
+            unsigned int                prefix = codelength[i].code >> (codelength[i].length - nbits);
+            struct huffman_table_entry* subtable;
+            int                         subbits;
+            int                         m;
+            while ((j < ndict) && ((codelength[j].code >> (codelength[j].length - nbits)) == prefix))
+            {
+                j++;
+            }
+            subbits              = codelength[j - 1].length - nbits;
+            table[prefix].value  = ntable;
+            table[prefix].length = -subbits;
+            subtable             = table + ntable;
+            ntable += 1 << subbits;
+            for (m = i; m < j; m++)
+            {
+                int          sublength = codelength[m].length - nbits;
+                int          fill      = 1 << (subbits - sublength);
+                unsigned int first     = codelength[m].code & ~(0xFFFFFFFFU << sublength);
+                int          k;
+                first <<= subbits - sublength;
+                for (k = 0; k < fill; k++)
+                {
+                    subtable[first + k].value  = codelength[m].dict;
+                    subtable[first + k].length = sublength;
+                }
+            }
+        }
+    }
+    *table_bits = nbits;
+    return table;
+}
+
 void Ptngc_comp_conv_from_huffman(unsigned char*      huffman,
+                                  const int           huffman_len,
                                   unsigned int*       vals,
                                   const int           nvals,
                                   const int           ndict,
@@ -538,13 +612,13 @@ void Ptngc_comp_conv_from_huffman(unsigned char*      huffman,
                                   const unsigned int* huffman_dict_unpacked,
                                   const int           huffman_dict_unpackedlen)
 {
-    struct codelength* codelength = warnmalloc(ndict * sizeof *codelength);
-    int                i, j;
-    int                maxdict;
-    int                code;
-    unsigned char*     huffman_ptr;
-    int                bitptr;
-    (void)huffman_dictlen;
+    struct codelength*          codelength = warnmalloc(ndict * sizeof *codelength);
+    struct huffman_table_entry* table;
+    int                         table_bits;
+    int                         i, j;
+    int                         maxdict;
+    int                         code;
+    struct bitreader            reader;
     (void)huffman_dict_unpackedlen;
     if (huffman_dict_unpacked)
     {
@@ -568,18 +642,15 @@ void Ptngc_comp_conv_from_huffman(unsigned char*      huffman,
     }
     else
     {
-        huffman_ptr = huffman_dict;
-        maxdict     = ((unsigned int)huffman_ptr[0]) | (((unsigned int)huffman_ptr[1]) << 8)
-                  | (((unsigned int)huffman_ptr[2]) << 16);
-        huffman_ptr += 3;
-        bitptr = 0;
-        j      = 0;
+        maxdict = ((unsigned int)huffman_dict[0]) | (((unsigned int)huffman_dict[1]) << 8)
+                  | (((unsigned int)huffman_dict[2]) << 16);
+        Ptngc_bitreader_init_bounded(&reader, huffman_dict + 3, huffman_dictlen - 3);
+        j = 0;
         for (i = 0; i <= maxdict; i++)
         {
-            int bit = readbits(1, &huffman_ptr, &bitptr);
-            if (bit)
+            if (Ptngc_bitreader_read(&reader, 1))
             {
-                codelength[j].length = readbits(5, &huffman_ptr, &bitptr);
+                codelength[j].length = Ptngc_bitreader_read(&reader, 5);
                 codelength[j].dict   = i;
 #if 0
               printf("%d %d\n",
@@ -625,29 +696,21 @@ void Ptngc_comp_conv_from_huffman(unsigned char*      huffman,
       }
   }
 #endif
+    table = huffman_decode_table(codelength, ndict, &table_bits);
+    /* Free info about codes and length. */
+    free(codelength);
     /* Decompress data. */
-    huffman_ptr = huffman;
-    bitptr      = 0;
+    Ptngc_bitreader_init_bounded(&reader, huffman, huffman_len);
     for (i = 0; i < nvals; i++)
     {
-        unsigned int symbol;
-        int          len = codelength[0].length;
-        symbol           = readbits(len, &huffman_ptr, &bitptr);
-        j                = 0;
-        while (symbol != codelength[j].code)
+        const struct huffman_table_entry* entry = table + Ptngc_bitreader_peek(&reader, table_bits);
+        if (entry->length < 0)
         {
-            int newlen;
-            j++;
-            newlen = codelength[j].length;
-            if (newlen != len)
-            {
-                symbol <<= (newlen - len);
-                symbol |= readbits(newlen - len, &huffman_ptr, &bitptr);
-                len = newlen;
-            }
+            Ptngc_bitreader_consume(&reader, table_bits);
+            entry = table + entry->value + Ptngc_bitreader_peek(&reader, -entry->length);
         }
-        vals[i] = codelength[j].dict;
+        Ptngc_bitreader_consume(&reader, entry->length);
+        vals[i] = entry->value;
     }
-    /* Free info about codes and length. */
-    free(codelength);
+    free(table);
 }
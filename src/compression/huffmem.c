@@ -284,8 +284,8 @@ void Ptngc_comp_huff_decompress(unsigned char* huffman, const int huffman_len, u
         int nhuffdict =
                 (int)((unsigned int)huffman[14 + nhuff] | (((unsigned int)huffman[15 + nhuff]) << 8)
                       | (((unsigned int)huffman[16 + nhuff]) << 16));
-        Ptngc_comp_conv_from_huffman(huffman + 14, vals16, nvals16, ndict, huffman + 20 + nhuff,
-                                     nhuffdict, NULL, 0);
+        Ptngc_comp_conv_from_huffman(huffman + 14, nhuff, vals16, nvals16, ndict,
+                                     huffman + 20 + nhuff, nhuffdict, NULL, 0);
     }
     else if (algo == 1)
     {
@@ -301,11 +301,11 @@ void Ptngc_comp_huff_decompress(unsigned char* huffman, const int huffman_len, u
                       | (((unsigned int)huffman[25 + nhuff]) << 16));
         int ndict1 = (int)((unsigned int)huffman[26 + nhuff] | (((unsigned int)huffman[27 + nhuff]) << 8)
                            | (((unsigned int)huffman[28 + nhuff]) << 16));
-        Ptngc_comp_conv_from_huffman(huffman + 29 + nhuff, huffdictunpack, nhuffdictunpack, ndict1,
-                                     huffman + 29 + nhuff + nhuff1, nhuffdict1, NULL, 0);
+        Ptngc_comp_conv_from_huffman(huffman + 29 + nhuff, nhuff1, huffdictunpack, nhuffdictunpack,
+                                     ndict1, huffman + 29 + nhuff + nhuff1, nhuffdict1, NULL, 0);
         /* Then decompress the "real" data. */
-        Ptngc_comp_conv_from_huffman(huffman + 14, vals16, nvals16, ndict, NULL, 0, huffdictunpack,
-                                     nhuffdictunpack);
+        Ptngc_comp_conv_from_huffman(huffman + 14, nhuff, vals16, nvals16, ndict, NULL, 0,
+                                     huffdictunpack, nhuffdictunpack);
         free(huffdictunpack);
     }
     else if (algo == 2)
@@ -325,13 +325,13 @@ void Ptngc_comp_huff_decompress(unsigned char* huffman, const int huffman_len, u
                       | (((unsigned int)huffman[28 + nhuff]) << 16));
         int ndict2 = (int)((unsigned int)huffman[29 + nhuff] | (((unsigned int)huffman[30 + nhuff]) << 8)
                            | (((unsigned int)huffman[31 + nhuff]) << 16));
-        Ptngc_comp_conv_from_huffman(huffman + 32 + nhuff, huffdictrle, nhuffrle, ndict2,
+        Ptngc_comp_conv_from_huffman(huffman + 32 + nhuff, nhuff2, huffdictrle, nhuffrle, ndict2,
                                      huffman + 32 + nhuff + nhuff2, nhuffdict2, NULL, 0);
         /* Then uncompress the rle data */
         Ptngc_comp_conv_from_rle(huffdictrle, huffdictunpack, nhuffdictunpack);
         /* Then decompress the "real" data. */
-        Ptngc_comp_conv_from_huffman(huffman + 14, vals16, nvals16, ndict, NULL, 0, huffdictunpack,
-                                     nhuffdictunpack);
+        Ptngc_comp_conv_from_huffman(huffman + 14, nhuff, vals16, nvals16, ndict, NULL, 0,
+                                     huffdictunpack, nhuffdictunpack);
         free(huffdictrle);
         free(huffdictunpack);
     }
@@ -43,196 +43,135 @@
 
 #define MAX_FVAL 2147483647.
 
-static int verify_input_data(const double* x, const int natoms, const int nframes, const double precision)
+/* Quantize the values. All values are checked to fit in an int before any is
+   converted, so that the conversion can round down by truncating. Neither loop
+   exits early, so both can be vectorised.
+   Returns 1 if a value is too large, in which case quant is not set. */
+static int quantize(double* x, const int natoms, const int nframes, const double precision, int* quant)
 {
-    int iframe, i, j;
-    for (iframe = 0; iframe < nframes; iframe++)
+    int       i, too_large = 0;
+    const int n = natoms * nframes * 3;
+    for (i = 0; i < n; i++)
     {
-        for (i = 0; i < natoms; i++)
+        if (fabs(x[i] / precision + 0.5) >= MAX_FVAL)
         {
-            for (j = 0; j < 3; j++)
-            {
-                if (fabs(x[iframe * natoms * 3 + i * 3 + j] / precision + 0.5) >= MAX_FVAL)
-                {
-                    goto error;
-                }
-            }
+            too_large = 1;
         }
     }
-    return 0;
-error:
-#if 0
-  for (iframe=0; iframe<nframes; iframe++)
-    for (i=0; i<natoms; i++)
-      for (j=0; j<3; j++)
-        if (fabs(x[iframe*natoms*3+i*3+j]/precision+0.5)>=MAX_FVAL)
-          printf("ERROR. Too large value: %d %d %d: %g %g %g\n",iframe,i,j,x[iframe*natoms*3+i*3+j],precision,x[iframe*natoms*3+i*3+j]/precision/MAX_FVAL);
-#endif
-    return 1;
-}
-
-static int verify_input_data_float(const float* x, const int natoms, const int nframes, const float precision)
-{
-    int iframe, i, j;
-    for (iframe = 0; iframe < nframes; iframe++)
+    if (too_large)
     {
-        for (i = 0; i < natoms; i++)
-        {
-            for (j = 0; j < 3; j++)
-            {
-                if (fabs(x[iframe * natoms * 3 + i * 3 + j] / precision + 0.5) >= MAX_FVAL)
-                {
-                    goto error;
-                }
-            }
-        }
+        return 1;
     }
-    return 0;
-error:
-#if 0
-  for (iframe=0; iframe<nframes; iframe++)
-    for (i=0; i<natoms; i++)
-      for (j=0; j<3; j++)
-        if (fabs(x[iframe*natoms*3+i*3+j]/precision+0.5)>=MAX_FVAL)
-          printf("ERROR. Too large value: %d %d %d: %g %g %g\n",iframe,i,j,x[iframe*natoms*3+i*3+j],precision,x[iframe*natoms*3+i*3+j]/precision/MAX_FVAL);
-#endif
-    return 1;
-}
-
-static int quantize(double* x, const int natoms, const int nframes, const double precision, int* quant)
-{
-    int iframe, i, j;
-    for (iframe = 0; iframe < nframes; iframe++)
+    for (i = 0; i < n; i++)
     {
-        for (i = 0; i < natoms; i++)
-        {
-            for (j = 0; j < 3; j++)
-            {
-                quant[iframe * natoms * 3 + i * 3 + j] =
-                        (int)floor((x[iframe * natoms * 3 + i * 3 + j] / precision) + 0.5);
-            }
-        }
+        const double v = x[i] / precision + 0.5;
+        const int    t = (int)v;
+        /* floor(v), since truncating rounds negative values up. */
+        quant[i] = (v < (double)t) ? t - 1 : t;
     }
-    return verify_input_data(x, natoms, nframes, precision);
+    return 0;
 }
 
 static int quantize_float(float* x, int natoms, const int nframes, const float precision, int* quant)
 {
-    int iframe, i, j;
-    for (iframe = 0; iframe < nframes; iframe++)
+    int       i, too_large = 0;
+    const int n = natoms * nframes * 3;
+    for (i = 0; i < n; i++)
     {
-        for (i = 0; i < natoms; i++)
+        if (fabs(x[i] / precision + 0.5) >= MAX_FVAL)
         {
-            for (j = 0; j < 3; j++)
-            {
-                quant[iframe * natoms * 3 + i * 3 + j] =
-                        (int)floor((x[iframe * natoms * 3 + i * 3 + j] / precision) + 0.5);
-            }
+            too_large = 1;
         }
     }
-    return verify_input_data_float(x, natoms, nframes, precision);
+    if (too_large)
+    {
+        return 1;
+    }
+    for (i = 0; i < n; i++)
+    {
+        const double v = x[i] / precision + 0.5;
+        const int    t = (int)v;
+        /* floor(v), since truncating rounds negative values up. */
+        quant[i] = (v < (double)t) ? t - 1 : t;
+    }
+    return 0;
 }
 
 static void quant_inter_differences(const int* quant, const int natoms, const int nframes, int* quant_inter)
 {
-    int iframe, i, j;
+    int       i;
+    const int n = natoms * 3;
     /* The first frame is used for absolute positions. */
-    for (i = 0; i < natoms; i++)
+    for (i = 0; i < n; i++)
     {
-        for (j = 0; j < 3; j++)
-        {
-            quant_inter[i * 3 + j] = quant[i * 3 + j];
-        }
+        quant_inter[i] = quant[i];
     }
     /* For all other frames, the difference to the previous frame is used. */
-    for (iframe = 1; iframe < nframes; iframe++)
+    for (i = n; i < n * nframes; i++)
     {
-        for (i = 0; i < natoms; i++)
-        {
-            for (j = 0; j < 3; j++)
-            {
-                quant_inter[iframe * natoms * 3 + i * 3 + j] =
-                        quant[iframe * natoms * 3 + i * 3 + j]
-                        - quant[(iframe - 1) * natoms * 3 + i * 3 + j];
-            }
-        }
+        quant_inter[i] = quant[i] - quant[i - n];
     }
 }
 
 static void quant_intra_differences(const int* quant, const int natoms, const int nframes, int* quant_intra)
 {
-    int iframe, i, j;
+    int       iframe, i;
+    const int n = natoms * 3;
     for (iframe = 0; iframe < nframes; iframe++)
     {
+        const int* q  = quant + iframe * n;
+        int*       qi = quant_intra + iframe * n;
         /* The first atom is used with its absolute position. */
-        for (j = 0; j < 3; j++)
+        for (i = 0; i < 3; i++)
         {
-            quant_intra[iframe * natoms * 3 + j] = quant[iframe * natoms * 3 + j];
+            qi[i] = q[i];
         }
         /* For all other atoms the intraframe differences are computed. */
-        for (i = 1; i < natoms; i++)
+        for (i = 3; i < n; i++)
         {
-            for (j = 0; j < 3; j++)
-            {
-                quant_intra[iframe * natoms * 3 + i * 3 + j] =
-                        quant[iframe * natoms * 3 + i * 3 + j]
-                        - quant[iframe * natoms * 3 + (i - 1) * 3 + j];
-            }
+            qi[i] = q[i] - q[i - 3];
         }
     }
 }
 
 static void unquantize(double* x, int natoms, const int nframes, const double precision, const int* quant)
 {
-    int iframe, i, j;
-    for (iframe = 0; iframe < nframes; iframe++)
+    int       i;
+    const int n = natoms * nframes * 3;
+    for (i = 0; i < n; i++)
     {
-        for (i = 0; i < natoms; i++)
-        {
-            for (j = 0; j < 3; j++)
-            {
-                x[iframe * natoms * 3 + i * 3 + j] =
-                        (double)quant[iframe * natoms * 3 + i * 3 + j] * precision;
-            }
-        }
+        x[i] = (double)quant[i] * precision;
     }
 }
 
 static void unquantize_float(float* x, const int natoms, const int nframes, const float precision, const int* quant)
 {
-    int iframe, i, j;
-    for (iframe = 0; iframe < nframes; iframe++)
+    int       i;
+    const int n = natoms * nframes * 3;
+    for (i = 0; i < n; i++)
     {
-        for (i = 0; i < natoms; i++)
-        {
-            for (j = 0; j < 3; j++)
-            {
-                x[iframe * natoms * 3 + i * 3 + j] =
-                        (float)quant[iframe * natoms * 3 + i * 3 + j] * precision;
-            }
-        }
+        x[i] = (float)quant[i] * precision;
     }
 }
 
+/* The differences in quant are summed in place, one frame at a time, so
+   that all accesses are sequential. */
 static void unquantize_inter_differences(double*      x,
                                          int          natoms,
                                          const int    nframes,
                                          const double precision,
-                                         const int*   quant)
+                                         int*         quant)
 {
-    int iframe, i, j;
-    for (i = 0; i < natoms; i++)
+    int       i;
+    const int n = natoms * 3;
+    for (i = 0; i < n; i++)
     {
-        for (j = 0; j < 3; j++)
-        {
-            int q        = quant[i * 3 + j]; /* First value. */
-            x[i * 3 + j] = (double)q * precision;
-            for (iframe = 1; iframe < nframes; iframe++)
-            {
-                q += quant[iframe * natoms * 3 + i * 3 + j];
-                x[iframe * natoms * 3 + i * 3 + j] = (double)q * precision;
-            }
-        }
+        x[i] = (double)quant[i] * precision; /* First frame. */
+    }
+    for (i = n; i < n * nframes; i++)
+    {
+        quant[i] += quant[i - n];
+        x[i] = (double)quant[i] * precision;
     }
 }
 
@@ -240,39 +179,32 @@ static void unquantize_inter_differences_float(float*      x,
                                                const int   natoms,
                                                const int   nframes,
                                                const float precision,
-                                               const int*  quant)
+                                               int*        quant)
 {
-    int iframe, i, j;
-    for (i = 0; i < natoms; i++)
+    int       i;
+    const int n = natoms * 3;
+    for (i = 0; i < n; i++)
     {
-        for (j = 0; j < 3; j++)
-        {
-            int q        = quant[i * 3 + j]; /* First value. */
-            x[i * 3 + j] = (float)q * precision;
-            for (iframe = 1; iframe < nframes; iframe++)
-            {
-                q += quant[iframe * natoms * 3 + i * 3 + j];
-                x[iframe * natoms * 3 + i * 3 + j] = (float)q * precision;
-            }
-        }
+        x[i] = (float)quant[i] * precision; /* First frame. */
+    }
+    for (i = n; i < n * nframes; i++)
+    {
+        quant[i] += quant[i - n];
+        x[i] = (float)quant[i] * precision;
     }
 }
 
 static void unquantize_inter_differences_int(int* x, const int natoms, const int nframes, const int* quant)
 {
-    int iframe, i, j;
-    for (i = 0; i < natoms; i++)
+    int       i;
+    const int n = natoms * 3;
+    for (i = 0; i < n; i++)
     {
-        for (j = 0; j < 3; j++)
-        {
-            int q        = quant[i * 3 + j]; /* First value. */
-            x[i * 3 + j] = q;
-            for (iframe = 1; iframe < nframes; iframe++)
-            {
-                q += quant[iframe * natoms * 3 + i * 3 + j];
-                x[iframe * natoms * 3 + i * 3 + j] = q;
-            }
-        }
+        x[i] = quant[i]; /* First frame. */
+    }
+    for (i = n; i < n * nframes; i++)
+    {
+        x[i] = x[i - n] + quant[i];
     }
 }
 
@@ -280,23 +212,11 @@ static void unquantize_inter_differences_int(int* x, const int natoms, const int
    compression was used. */
 static void unquant_intra_differences_first_frame(int* quant, const int natoms)
 {
-    int i, j;
-    for (j = 0; j < 3; j++)
+    int i;
+    for (i = 3; i < natoms * 3; i++)
     {
-        int q = quant[j];
-        for (i = 1; i < natoms; i++)
-        {
-            q += quant[i * 3 + j];
-            quant[i * 3 + j] = q;
-        }
+        quant[i] += quant[i - 3];
     }
-#if 0
-  for (j=0; j<3; j++)
-    for (i=0; i<natoms; i++)
-      {
-        printf("UQ: %d %d %d: %d\n",0,j,i,quant[i*3+j]);
-      }
-#endif
 }
 
 static void unquantize_intra_differences(double*      x,
@@ -305,20 +225,27 @@ static void unquantize_intra_differences(double*      x,
                                          const double precision,
                                          const int*   quant)
 {
-    int iframe, i, j;
+    int       iframe, i, j;
+    const int n = natoms * 3;
 #if 0
   printf("UQ precision=%g\n",precision);
 #endif
     for (iframe = 0; iframe < nframes; iframe++)
     {
+        const int* qf = quant + iframe * n;
+        double*    xf = x + iframe * n;
+        int        q[3];
         for (j = 0; j < 3; j++)
         {
-            int q                      = quant[iframe * natoms * 3 + j];
-            x[iframe * natoms * 3 + j] = (double)q * precision;
-            for (i = 1; i < natoms; i++)
+            q[j]  = qf[j];
+            xf[j] = (double)q[j] * precision;
+        }
+        for (i = 3; i < n; i += 3)
+        {
+            for (j = 0; j < 3; j++)
             {
-                q += quant[iframe * natoms * 3 + i * 3 + j];
-                x[iframe * natoms * 3 + i * 3 + j] = (double)q * precision;
+                q[j] += qf[i + j];
+                xf[i + j] = (double)q[j] * precision;
             }
         }
     }
@@ -330,17 +257,24 @@ static void unquantize_intra_differences_float(float*      x,
                                                const float precision,
                                                const int*  quant)
 {
-    int iframe, i, j;
+    int       iframe, i, j;
+    const int n = natoms * 3;
     for (iframe = 0; iframe < nframes; iframe++)
     {
+        const int* qf = quant + iframe * n;
+        float*     xf = x + iframe * n;
+        int        q[3];
         for (j = 0; j < 3; j++)
         {
-            int q                      = quant[iframe * natoms * 3 + j];
-            x[iframe * natoms * 3 + j] = (float)q * precision;
-            for (i = 1; i < natoms; i++)
+            q[j]  = qf[j];
+            xf[j] = (float)q[j] * precision;
+        }
+        for (i = 3; i < n; i += 3)
+        {
+            for (j = 0; j < 3; j++)
             {
-                q += quant[iframe * natoms * 3 + i * 3 + j];
-                x[iframe * natoms * 3 + i * 3 + j] = (float)q * precision;
+                q[j] += qf[i + j];
+                xf[i + j] = (float)q[j] * precision;
             }
         }
     }
@@ -348,18 +282,19 @@ static void unquantize_intra_differences_float(float*      x,
 
 static void unquantize_intra_differences_int(int* x, const int natoms, const int nframes, const int* quant)
 {
-    int iframe, i, j;
+    int       iframe, i;
+    const int n = natoms * 3;
     for (iframe = 0; iframe < nframes; iframe++)
     {
-        for (j = 0; j < 3; j++)
+        const int* qf = quant + iframe * n;
+        int*       xf = x + iframe * n;
+        for (i = 0; i < 3; i++)
         {
-            int q                      = quant[iframe * natoms * 3 + j];
-            x[iframe * natoms * 3 + j] = q;
-            for (i = 1; i < natoms; i++)
-            {
-                q += quant[iframe * natoms * 3 + i * 3 + j];
-                x[iframe * natoms * 3 + i * 3 + j] = q;
-            }
+            xf[i] = qf[i];
+        }
+        for (i = 3; i < n; i++)
+        {
+            xf[i] = xf[i - 3] + qf[i];
         }
     }
 }
@@ -393,21 +328,22 @@ static fix_t readbufferfix(const unsigned char* buf, int num)
     return f;
 }
 
-/* Perform position compression from the quantized data. */
-static void compress_quantized_pos(int*        quant,
-                                   int*        quant_inter,
-                                   int*        quant_intra,
-                                   const int   natoms,
-                                   const int   nframes,
-                                   const int   speed,
-                                   const int   initial_coding,
-                                   const int   initial_coding_parameter,
-                                   const int   coding,
-                                   const int   coding_parameter,
-                                   const fix_t prec_hi,
-                                   const fix_t prec_lo,
-                                   int*        nitems,
-                                   char*       data)
+/* Perform position compression from the quantized data. Returns 1 if a block
+   could not be compressed, 0 otherwise. */
+static int compress_quantized_pos(int*        quant,
+                                  int*        quant_inter,
+                                  int*        quant_intra,
+                                  const int   natoms,
+                                  const int   nframes,
+                                  const int   speed,
+                                  const int   initial_coding,
+                                  const int   initial_coding_parameter,
+                                  const int   coding,
+                                  const int   coding_parameter,
+                                  const fix_t prec_hi,
+                                  const fix_t prec_lo,
+                                  int*        nitems,
+                                  char*       data)
 {
     int   bufloc    = 0;
     char* datablock = NULL;
@@ -485,6 +421,10 @@ static void compress_quantized_pos(int*        quant,
                                             initial_coding_parameter, natoms, speed);
         Ptngc_coder_deinit(coder);
     }
+    if (!datablock)
+    {
+        return 1;
+    }
     /* Block length. */
     if (data)
     {
@@ -532,39 +472,42 @@ static void compress_quantized_pos(int*        quant,
                                                 coding_parameter, natoms, speed);
             Ptngc_coder_deinit(coder);
         }
+        if (!datablock)
+        {
+            return 1;
+        }
         /* Block length. */
         if (data)
         {
             bufferfix((unsigned char*)data + bufloc, (fix_t)length, 4);
         }
         bufloc += 4;
-        if (datablock)
+        if (data)
         {
-            if (data)
-            {
-                memcpy(data + bufloc, datablock, length);
-            }
-            free(datablock);
+            memcpy(data + bufloc, datablock, length);
         }
+        free(datablock);
         bufloc += length;
     }
     *nitems = bufloc;
+    return 0;
 }
 
-/* Perform velocity compression from vel into the data block */
-static void compress_quantized_vel(int*        quant,
-                                   int*        quant_inter,
-                                   const int   natoms,
-                                   const int   nframes,
-                                   const int   speed,
-                                   const int   initial_coding,
-                                   const int   initial_coding_parameter,
-                                   const int   coding,
-                                   const int   coding_parameter,
-                                   const fix_t prec_hi,
-                                   const fix_t prec_lo,
-                                   int*        nitems,
-                                   char*       data)
+/* Perform velocity compression from vel into the data block. Returns 1 if a
+   block could not be compressed, 0 otherwise. */
+static int compress_quantized_vel(int*        quant,
+                                  int*        quant_inter,
+                                  const int   natoms,
+                                  const int   nframes,
+                                  const int   speed,
+                                  const int   initial_coding,
+                                  const int   initial_coding_parameter,
+                                  const int   coding,
+                                  const int   coding_parameter,
+                                  const fix_t prec_hi,
+                                  const fix_t prec_lo,
+                                  int*        nitems,
+                                  char*       data)
 {
     int   bufloc    = 0;
     char* datablock = NULL;
@@ -634,6 +577,10 @@ static void compress_quantized_vel(int*        quant,
                                             initial_coding_parameter, natoms, speed);
         Ptngc_coder_deinit(coder);
     }
+    if (!datablock)
+    {
+        return 1;
+    }
     /* Block length. */
     if (data)
     {
@@ -641,12 +588,12 @@ static void compress_quantized_vel(int*        quant,
     }
     bufloc += 4;
     /* The actual data block. */
-    if (data && datablock)
+    if (data)
     {
         memcpy(data + bufloc, datablock, length);
-        free(datablock);
         bufloc += length;
     }
+    free(datablock);
     /* The remaining frames */
     if (nframes > 1)
     {
@@ -672,6 +619,10 @@ static void compress_quantized_vel(int*        quant,
                                                 coding_parameter, natoms, speed);
             Ptngc_coder_deinit(coder);
         }
+        if (!datablock)
+        {
+            return 1;
+        }
         /* Block length. */
         if (data)
         {
@@ -686,6 +637,7 @@ static void compress_quantized_vel(int*        quant,
         bufloc += length;
     }
     *nitems = bufloc;
+    return 0;
 }
 
 static int determine_best_coding_stop_bits(struct coder* coder,
@@ -823,14 +775,16 @@ static void determine_best_pos_initial_coding(int*        quant,
         {
             current_coding           = TNG_COMPRESS_ALGO_POS_XTC3;
             current_coding_parameter = 0;
-            compress_quantized_pos(quant, NULL, quant_intra, natoms, 1, speed, current_coding,
-                                   current_coding_parameter, 0, 0, prec_hi, prec_lo,
-                                   &current_code_size, NULL);
-            if (current_code_size < best_code_size)
+            if (!compress_quantized_pos(quant, NULL, quant_intra, natoms, 1, speed, current_coding,
+                                        current_coding_parameter, 0, 0, prec_hi, prec_lo,
+                                        &current_code_size, NULL))
             {
-                best_coding           = current_coding;
-                best_coding_parameter = current_coding_parameter;
-                best_code_size        = current_code_size;
+                if (current_code_size < best_code_size)
+                {
+                    best_coding           = current_coding;
+                    best_coding_parameter = current_coding_parameter;
+                    best_code_size        = current_code_size;
+                }
             }
         }
         /* Test BWLZH intra */
@@ -838,13 +792,15 @@ static void determine_best_pos_initial_coding(int*        quant,
         {
             current_coding           = TNG_COMPRESS_ALGO_POS_BWLZH_INTRA;
             current_coding_parameter = 0;
-            compress_quantized_pos(quant, NULL, quant_intra, natoms, 1, speed, current_coding,
-                                   current_coding_parameter, 0, 0, prec_hi, prec_lo,
-                                   &current_code_size, NULL);
-            if (current_code_size < best_code_size)
+            if (!compress_quantized_pos(quant, NULL, quant_intra, natoms, 1, speed, current_coding,
+                                        current_coding_parameter, 0, 0, prec_hi, prec_lo,
+                                        &current_code_size, NULL))
             {
-                best_coding           = current_coding;
-                best_coding_parameter = current_coding_parameter;
+                if (current_code_size < best_code_size)
+                {
+                    best_coding           = current_coding;
+                    best_coding_parameter = current_coding_parameter;
+                }
             }
         }
         *initial_coding           = best_coding;
@@ -989,15 +945,18 @@ static void determine_best_pos_coding(int*        quant,
         {
             current_coding           = TNG_COMPRESS_ALGO_POS_BWLZH_INTER;
             current_coding_parameter = 0;
-            compress_quantized_pos(quant, quant_inter, quant_intra, natoms, nframes, speed,
-                                   TNG_COMPRESS_ALGO_POS_XTC2, 0, current_coding,
-                                   current_coding_parameter, prec_hi, prec_lo, &current_code_size, NULL);
-            current_code_size -= initial_code_size; /* Correct for the use of XTC2 for the first frame. */
-            if (current_code_size < best_code_size)
+            if (!compress_quantized_pos(quant, quant_inter, quant_intra, natoms, nframes, speed,
+                                        TNG_COMPRESS_ALGO_POS_XTC2, 0, current_coding,
+                                        current_coding_parameter, prec_hi, prec_lo,
+                                        &current_code_size, NULL))
             {
-                best_coding           = current_coding;
-                best_coding_parameter = current_coding_parameter;
-                best_code_size        = current_code_size;
+                current_code_size -= initial_code_size; /* Correct for the use of XTC2 for the first frame. */
+                if (current_code_size < best_code_size)
+                {
+                    best_coding           = current_coding;
+                    best_coding_parameter = current_coding_parameter;
+                    best_code_size        = current_code_size;
+                }
             }
         }
 
@@ -1006,14 +965,17 @@ static void determine_best_pos_coding(int*        quant,
         {
             current_coding           = TNG_COMPRESS_ALGO_POS_BWLZH_INTRA;
             current_coding_parameter = 0;
-            compress_quantized_pos(quant, quant_inter, quant_intra, natoms, nframes, speed,
-                                   TNG_COMPRESS_ALGO_POS_XTC2, 0, current_coding,
-                                   current_coding_parameter, prec_hi, prec_lo, &current_code_size, NULL);
-            current_code_size -= initial_code_size; /* Correct for the use of XTC2 for the first frame. */
-            if (current_code_size < best_code_size)
+            if (!compress_quantized_pos(quant, quant_inter, quant_intra, natoms, nframes, speed,
+                                        TNG_COMPRESS_ALGO_POS_XTC2, 0, current_coding,
+                                        current_coding_parameter, prec_hi, prec_lo,
+                                        &current_code_size, NULL))
             {
-                best_coding           = current_coding;
-                best_coding_parameter = current_coding_parameter;
+                current_code_size -= initial_code_size; /* Correct for the use of XTC2 for the first frame. */
+                if (current_code_size < best_code_size)
+                {
+                    best_coding           = current_coding;
+                    best_coding_parameter = current_coding_parameter;
+                }
             }
         }
         *coding           = best_coding;
@@ -1115,12 +1077,15 @@ static void determine_best_vel_initial_coding(int*        quant,
         {
             current_coding           = TNG_COMPRESS_ALGO_VEL_BWLZH_ONETOONE;
             current_coding_parameter = 0;
-            compress_quantized_vel(quant, NULL, natoms, 1, speed, current_coding, current_coding_parameter,
-                                   0, 0, prec_hi, prec_lo, &current_code_size, NULL);
-            if ((best_coding == -1) || (current_code_size < best_code_size))
+            if (!compress_quantized_vel(quant, NULL, natoms, 1, speed, current_coding,
+                                        current_coding_parameter, 0, 0, prec_hi, prec_lo,
+                                        &current_code_size, NULL))
             {
-                best_coding           = current_coding;
-                best_coding_parameter = current_coding_parameter;
+                if ((best_coding == -1) || (current_code_size < best_code_size))
+                {
+                    best_coding           = current_coding;
+                    best_coding_parameter = current_coding_parameter;
+                }
             }
         }
         *initial_coding           = best_coding;
@@ -1244,30 +1209,34 @@ static void determine_best_vel_coding(int*        quant,
             /* Test BWLZH inter */
             current_coding           = TNG_COMPRESS_ALGO_VEL_BWLZH_INTER;
             current_coding_parameter = 0;
-            compress_quantized_vel(quant, quant_inter, natoms, nframes, speed,
-                                   TNG_COMPRESS_ALGO_VEL_STOPBIT_ONETOONE, initial_numbits,
-                                   current_coding, current_coding_parameter, prec_hi, prec_lo,
-                                   &current_code_size, NULL);
-            current_code_size -= initial_code_size; /* Correct for the initial frame */
-            if (current_code_size < best_code_size)
+            if (!compress_quantized_vel(quant, quant_inter, natoms, nframes, speed,
+                                        TNG_COMPRESS_ALGO_VEL_STOPBIT_ONETOONE, initial_numbits,
+                                        current_coding, current_coding_parameter, prec_hi, prec_lo,
+                                        &current_code_size, NULL))
             {
-                best_coding           = current_coding;
-                best_code_size        = current_code_size;
-                best_coding_parameter = current_coding_parameter;
+                current_code_size -= initial_code_size; /* Correct for the initial frame */
+                if (current_code_size < best_code_size)
+                {
+                    best_coding           = current_coding;
+                    best_code_size        = current_code_size;
+                    best_coding_parameter = current_coding_parameter;
+                }
             }
 
             /* Test BWLZH one-to-one */
             current_coding           = TNG_COMPRESS_ALGO_VEL_BWLZH_ONETOONE;
             current_coding_parameter = 0;
-            compress_quantized_vel(quant, quant_inter, natoms, nframes, speed,
-                                   TNG_COMPRESS_ALGO_VEL_STOPBIT_ONETOONE, initial_numbits,
-                                   current_coding, current_coding_parameter, prec_hi, prec_lo,
-                                   &current_code_size, NULL);
-            current_code_size -= initial_code_size; /* Correct for the initial frame */
-            if (current_code_size < best_code_size)
+            if (!compress_quantized_vel(quant, quant_inter, natoms, nframes, speed,
+                                        TNG_COMPRESS_ALGO_VEL_STOPBIT_ONETOONE, initial_numbits,
+                                        current_coding, current_coding_parameter, prec_hi, prec_lo,
+                                        &current_code_size, NULL))
             {
-                best_coding           = current_coding;
-                best_coding_parameter = current_coding_parameter;
+                current_code_size -= initial_code_size; /* Correct for the initial frame */
+                if (current_code_size < best_code_size)
+                {
+                    best_coding           = current_coding;
+                    best_coding_parameter = current_coding_parameter;
+                }
             }
         }
         *coding           = best_coding;
@@ -1389,9 +1358,13 @@ char DECLSPECDLLEXPORT* tng_compress_pos_int(int*                pos,
         }
     }
 
-    compress_quantized_pos(quant, quant_inter, quant_intra, natoms, nframes, speed, initial_coding,
-                           initial_coding_parameter, coding, coding_parameter, prec_hi, prec_lo,
-                           nitems, data);
+    if (compress_quantized_pos(quant, quant_inter, quant_intra, natoms, nframes, speed,
+                               initial_coding, initial_coding_parameter, coding, coding_parameter,
+                               prec_hi, prec_lo, nitems, data))
+    {
+        free(data);
+        data = NULL; /* Error occured. A block could not be compressed. */
+    }
     free(quant_inter);
     free(quant_intra);
     if (algo[0] == -1)
@@ -1592,9 +1565,13 @@ char DECLSPECDLLEXPORT* tng_compress_vel_int(int*                vel,
         }
     }
 
-    compress_quantized_vel(quant, quant_inter, natoms, nframes, speed, initial_coding,
-                           initial_coding_parameter, coding, coding_parameter, prec_hi, prec_lo,
-                           nitems, data);
+    if (compress_quantized_vel(quant, quant_inter, natoms, nframes, speed, initial_coding,
+                               initial_coding_parameter, coding, coding_parameter, prec_hi, prec_lo,
+                               nitems, data))
+    {
+        free(data);
+        data = NULL; /* Error occured. A block could not be compressed. */
+    }
     free(quant_inter);
     if (algo[0] == -1)
     {
@@ -33,6 +33,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#include "../../include/compression/bitstream.h"
 #include "../../include/compression/coder.h"
 #include "../../include/compression/widemuldiv.h"
 #include "../../include/compression/warnmalloc.h"
@@ -1104,74 +1105,24 @@ static void write_instruction(struct coder* coder, const int instr, unsigned cha
 #endif
 }
 
-static unsigned int readbits(unsigned char** ptr, int* bitptr, int nbits)
-{
-    unsigned int  val          = 0U;
-    unsigned int  extract_mask = 0x80U >> *bitptr;
-    unsigned char thisval      = **ptr;
-#ifdef SHOWIT
-    fprintf(stderr, "Read nbits=%d val=", nbits);
-#endif
-    while (nbits--)
-    {
-        val <<= 1;
-        val |= ((extract_mask & thisval) != 0);
-        *bitptr = (*bitptr) + 1;
-        extract_mask >>= 1;
-        if (!extract_mask)
-        {
-            extract_mask = 0x80U;
-            *ptr         = (*ptr) + 1;
-            *bitptr      = 0;
-            if (nbits)
-            {
-                thisval = **ptr;
-            }
-        }
-    }
-#ifdef SHOWIT
-    fprintf(stderr, "%x\n", val);
-#endif
-    return val;
-}
-
-static void readmanybits(unsigned char** ptr, int* bitptr, int nbits, unsigned char* buffer)
-{
-    while (nbits >= 8)
-    {
-        *buffer++ = readbits(ptr, bitptr, 8);
-        nbits -= 8;
-#ifdef SHOWIT
-        fprintf(stderr, "Read value %02x\n", buffer[-1]);
-#endif
-    }
-    if (nbits)
-    {
-        *buffer++ = readbits(ptr, bitptr, nbits);
-#ifdef SHOWIT
-        fprintf(stderr, "Read value %02x\n", buffer[-1]);
-#endif
-    }
-}
-
-static int read_instruction(unsigned char** ptr, int* bitptr)
+static int read_instruction(struct bitreader* reader)
 {
     int          instr = -1;
-    unsigned int bits  = readbits(ptr, bitptr, 1);
+    unsigned int bits  = Ptngc_bitreader_read(reader, 1);
     if (bits)
     {
         instr = INSTR_DEFAULT;
     }
     else
     {
-        bits = readbits(ptr, bitptr, 1);
+        bits = Ptngc_bitreader_read(reader, 1);
         if (!bits)
         {
             instr = INSTR_BASE_RUNLENGTH;
         }
         else
         {
-            bits = readbits(ptr, bitptr, 2);
+            bits = Ptngc_bitreader_read(reader, 2);
             if (bits == 0)
             {
                 instr = INSTR_ONLY_LARGE;
@@ -1186,7 +1137,7 @@ static int read_instruction(unsigned char** ptr, int* bitptr)
             }
             else if (bits == 3)
             {
-                bits = readbits(ptr, bitptr, 1);
+                bits = Ptngc_bitreader_read(reader, 1);
                 if (bits == 0)
                 {
                     instr = INSTR_FLIP;
@@ -2295,30 +2246,30 @@ unsigned char* Ptngc_pack_array_xtc2(struct coder* coder, int* input, int* lengt
 
 int Ptngc_unpack_array_xtc2(struct coder* coder, unsigned char* packed, int* output, const int length)
 {
-    unsigned char* ptr    = packed;
-    int            bitptr = 0;
-    int            minint[3];
-    int            large_index[3];
-    int            small_index;
-    int            prevcoord[3];
-    int            ntriplets_left = length / 3;
-    int            swapatoms      = 0;
-    int            runlength      = 0;
-    int            large_nbits;
-    unsigned char  compress_buffer[18 * 4]; /* Holds compressed result for 3 large ints or up to 18 small ints. */
-    int            encode_ints[21]; /* Up to 3 large + 18 small ints can be encoded at once */
+    struct bitreader reader;
+    int              minint[3];
+    int              large_index[3];
+    int              small_index;
+    int              prevcoord[3];
+    int              ntriplets_left = length / 3;
+    int              swapatoms      = 0;
+    int              runlength      = 0;
+    int              large_nbits;
+    unsigned char    compress_buffer[18 * 4]; /* Holds compressed result for 3 large ints or up to 18 small ints. */
+    int              encode_ints[21]; /* Up to 3 large + 18 small ints can be encoded at once */
     (void)coder;
 
+    Ptngc_bitreader_init(&reader, packed);
     /* Read min integers. */
-    minint[0] = unpositive_int(readbits(&ptr, &bitptr, 32));
-    minint[1] = unpositive_int(readbits(&ptr, &bitptr, 32));
-    minint[2] = unpositive_int(readbits(&ptr, &bitptr, 32));
+    minint[0] = unpositive_int(Ptngc_bitreader_read(&reader, 32));
+    minint[1] = unpositive_int(Ptngc_bitreader_read(&reader, 32));
+    minint[2] = unpositive_int(Ptngc_bitreader_read(&reader, 32));
     /* Read large indices */
-    large_index[0] = readbits(&ptr, &bitptr, 8);
-    large_index[1] = readbits(&ptr, &bitptr, 8);
-    large_index[2] = readbits(&ptr, &bitptr, 8);
+    large_index[0] = Ptngc_bitreader_read(&reader, 8);
+    large_index[1] = Ptngc_bitreader_read(&reader, 8);
+    large_index[2] = Ptngc_bitreader_read(&reader, 8);
     /* Read small index */
-    small_index = readbits(&ptr, &bitptr, 8);
+    small_index = Ptngc_bitreader_read(&reader, 8);
 
     large_nbits = compute_magic_bits(large_index);
 
@@ -2334,7 +2285,7 @@ int Ptngc_unpack_array_xtc2(struct coder* coder, unsigned char* packed, int* out
 
     while (ntriplets_left)
     {
-        int instr = read_instruction(&ptr, &bitptr);
+        int instr = read_instruction(&reader);
 #ifdef SHOWIT
         if ((instr >= 0) && (instr < MAXINSTR))
             fprintf(stderr, "Decoded instruction %s\n", instrnames[instr]);
@@ -2353,7 +2304,7 @@ int Ptngc_unpack_array_xtc2(struct coder* coder, unsigned char* packed, int* out
                     compress_buffer[i] = 0;
                 }
                 /* Get the large value. */
-                readmanybits(&ptr, &bitptr, large_nbits, compress_buffer);
+                Ptngc_bitreader_readmany(&reader, large_nbits, compress_buffer);
                 trajcoder_base_decompress(compress_buffer, 3, large_index, encode_ints);
                 memcpy(large_ints, encode_ints, 3 * sizeof *large_ints);
 #ifdef SHOWIT
@@ -2374,7 +2325,7 @@ int Ptngc_unpack_array_xtc2(struct coder* coder, unsigned char* packed, int* out
                     compress_buffer[i] = 0;
                 }
                 /* Get the small values. */
-                readmanybits(&ptr, &bitptr, magic_bits[small_index][runlength - 1], compress_buffer);
+                Ptngc_bitreader_readmany(&reader, magic_bits[small_index][runlength - 1], compress_buffer);
                 trajcoder_base_decompress(compress_buffer, 3 * runlength, small_idx, encode_ints);
 #ifdef SHOWIT
                 for (i = 0; i < runlength; i++)
@@ -2458,7 +2409,7 @@ int Ptngc_unpack_array_xtc2(struct coder* coder, unsigned char* packed, int* out
             int i, j;
             int large_ints[3];
             /* How many large atoms in this sequence? */
-            int n = (int)readbits(&ptr, &bitptr, 4) + 3; /* 3-18 large atoms */
+            int n = (int)Ptngc_bitreader_read(&reader, 4) + 3; /* 3-18 large atoms */
             for (i = 0; i < n; i++)
             {
                 /* Clear the compress buffer. */
@@ -2467,7 +2418,7 @@ int Ptngc_unpack_array_xtc2(struct coder* coder, unsigned char* packed, int* out
                     compress_buffer[j] = 0;
                 }
                 /* Get the large value. */
-                readmanybits(&ptr, &bitptr, large_nbits, compress_buffer);
+                Ptngc_bitreader_readmany(&reader, large_nbits, compress_buffer);
                 trajcoder_base_decompress(compress_buffer, 3, large_index, encode_ints);
                 memcpy(large_ints, encode_ints, 3 * sizeof *large_ints);
                 /* Output large value */
@@ -2480,7 +2431,7 @@ int Ptngc_unpack_array_xtc2(struct coder* coder, unsigned char* packed, int* out
         }
         else if (instr == INSTR_BASE_RUNLENGTH)
         {
-            unsigned int code = readbits(&ptr, &bitptr, 4);
+            unsigned int code = Ptngc_bitreader_read(&reader, 4);
             int          change;
             if (code == 15)
             {
@@ -2501,7 +2452,7 @@ int Ptngc_unpack_array_xtc2(struct coder* coder, unsigned char* packed, int* out
         }
         else if (instr == INSTR_LARGE_BASE_CHANGE)
         {
-            unsigned int ichange = readbits(&ptr, &bitptr, 2);
+            unsigned int ichange = Ptngc_bitreader_read(&reader, 2);
             int          change  = (int)(ichange & 0x1U) + 1;
             if (ichange & 0x2U)
             {
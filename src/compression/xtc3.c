@@ -915,6 +915,7 @@ unsigned char* Ptngc_pack_array_xtc3(int* input, int* length, const int natoms,
     int            refused        = 0;
     unsigned char* bwlzh_buf      = NULL;
     int            bwlzh_buf_len;
+    int            bwlzh_error;
     unsigned char* base_buf = NULL;
     int            base_buf_len;
 
@@ -1620,11 +1621,20 @@ unsigned char* Ptngc_pack_array_xtc3(int* input, int* length, const int natoms,
         bwlzh_buf = warnmalloc(bwlzh_get_buflen(xtc3_context.ninstr));
         if (speed >= 5)
         {
-            bwlzh_compress(xtc3_context.instructions, xtc3_context.ninstr, bwlzh_buf, &bwlzh_buf_len);
+            bwlzh_error = bwlzh_compress(xtc3_context.instructions, xtc3_context.ninstr, bwlzh_buf,
+                                         &bwlzh_buf_len);
         }
         else
         {
-            bwlzh_compress_no_lz77(xtc3_context.instructions, xtc3_context.ninstr, bwlzh_buf, &bwlzh_buf_len);
+            bwlzh_error = bwlzh_compress_no_lz77(xtc3_context.instructions, xtc3_context.ninstr,
+                                                 bwlzh_buf, &bwlzh_buf_len);
+        }
+        if (bwlzh_error)
+        {
+            free(bwlzh_buf);
+            free(output);
+            free_xtc3_context(&xtc3_context);
+            return NULL;
         }
         output_int(output, &outdata, (unsigned int)bwlzh_buf_len);
         memcpy(output + outdata, bwlzh_buf, bwlzh_buf_len);
@@ -1642,11 +1652,20 @@ unsigned char* Ptngc_pack_array_xtc3(int* input, int* length, const int natoms,
         bwlzh_buf = warnmalloc(bwlzh_get_buflen(xtc3_context.nrle));
         if (speed >= 5)
         {
-            bwlzh_compress(xtc3_context.rle, xtc3_context.nrle, bwlzh_buf, &bwlzh_buf_len);
+            bwlzh_error = bwlzh_compress(xtc3_context.rle, xtc3_context.nrle, bwlzh_buf,
+                                         &bwlzh_buf_len);
         }
         else
         {
-            bwlzh_compress_no_lz77(xtc3_context.rle, xtc3_context.nrle, bwlzh_buf, &bwlzh_buf_len);
+            bwlzh_error = bwlzh_compress_no_lz77(xtc3_context.rle, xtc3_context.nrle, bwlzh_buf,
+                                                 &bwlzh_buf_len);
+        }
+        if (bwlzh_error)
+        {
+            free(bwlzh_buf);
+            free(output);
+            free_xtc3_context(&xtc3_context);
+            return NULL;
         }
         output_int(output, &outdata, (unsigned int)bwlzh_buf_len);
         memcpy(output + outdata, bwlzh_buf, bwlzh_buf_len);
@@ -1672,12 +1691,19 @@ unsigned char* Ptngc_pack_array_xtc3(int* input, int* length, const int natoms,
             bwlzh_buf = warnmalloc(bwlzh_get_buflen(xtc3_context.nlargedir));
             if (speed >= 5)
             {
-                bwlzh_compress(xtc3_context.large_direct, xtc3_context.nlargedir, bwlzh_buf, &bwlzh_buf_len);
+                bwlzh_error = bwlzh_compress(xtc3_context.large_direct, xtc3_context.nlargedir,
+                                             bwlzh_buf, &bwlzh_buf_len);
             }
             else
             {
-                bwlzh_compress_no_lz77(xtc3_context.large_direct, xtc3_context.nlargedir, bwlzh_buf,
-                                       &bwlzh_buf_len);
+                bwlzh_error = bwlzh_compress_no_lz77(xtc3_context.large_direct,
+                                                     xtc3_context.nlargedir, bwlzh_buf,
+                                                     &bwlzh_buf_len);
+            }
+            if (bwlzh_error)
+            {
+                /* Use base compression instead. */
+                bwlzh_buf_len = INT_MAX;
             }
         }
         /* If this can be written smaller using base compression we should do that. */
@@ -1722,13 +1748,19 @@ unsigned char* Ptngc_pack_array_xtc3(int* input, int* length, const int natoms,
             bwlzh_buf = warnmalloc(bwlzh_get_buflen(xtc3_context.nlargeintra));
             if (speed >= 5)
             {
-                bwlzh_compress(xtc3_context.large_intra_delta, xtc3_context.nlargeintra, bwlzh_buf,
-                               &bwlzh_buf_len);
+                bwlzh_error = bwlzh_compress(xtc3_context.large_intra_delta,
+                                             xtc3_context.nlargeintra, bwlzh_buf, &bwlzh_buf_len);
             }
             else
             {
-                bwlzh_compress_no_lz77(xtc3_context.large_intra_delta, xtc3_context.nlargeintra,
-                                       bwlzh_buf, &bwlzh_buf_len);
+                bwlzh_error = bwlzh_compress_no_lz77(xtc3_context.large_intra_delta,
+                                                     xtc3_context.nlargeintra, bwlzh_buf,
+                                                     &bwlzh_buf_len);
+            }
+            if (bwlzh_error)
+            {
+                /* Use base compression instead. */
+                bwlzh_buf_len = INT_MAX;
             }
         }
         /* If this can be written smaller using base compression we should do that. */
@@ -1773,13 +1805,19 @@ unsigned char* Ptngc_pack_array_xtc3(int* input, int* length, const int natoms,
             bwlzh_buf = warnmalloc(bwlzh_get_buflen(xtc3_context.nlargeinter));
             if (speed >= 5)
             {
-                bwlzh_compress(xtc3_context.large_inter_delta, xtc3_context.nlargeinter, bwlzh_buf,
-                               &bwlzh_buf_len);
+                bwlzh_error = bwlzh_compress(xtc3_context.large_inter_delta,
+                                             xtc3_context.nlargeinter, bwlzh_buf, &bwlzh_buf_len);
             }
             else
             {
-                bwlzh_compress_no_lz77(xtc3_context.large_inter_delta, xtc3_context.nlargeinter,
-                                       bwlzh_buf, &bwlzh_buf_len);
+                bwlzh_error = bwlzh_compress_no_lz77(xtc3_context.large_inter_delta,
+                                                     xtc3_context.nlargeinter, bwlzh_buf,
+                                                     &bwlzh_buf_len);
+            }
+            if (bwlzh_error)
+            {
+                /* Use base compression instead. */
+                bwlzh_buf_len = INT_MAX;
             }
         }
         /* If this can be written smaller using base compression we should do that. */
@@ -1824,12 +1862,19 @@ unsigned char* Ptngc_pack_array_xtc3(int* input, int* length, const int natoms,
             bwlzh_buf = warnmalloc(bwlzh_get_buflen(xtc3_context.nsmallintra));
             if (speed >= 5)
             {
-                bwlzh_compress(xtc3_context.smallintra, xtc3_context.nsmallintra, bwlzh_buf, &bwlzh_buf_len);
+                bwlzh_error = bwlzh_compress(xtc3_context.smallintra, xtc3_context.nsmallintra,
+                                             bwlzh_buf, &bwlzh_buf_len);
             }
             else
             {
-                bwlzh_compress_no_lz77(xtc3_context.smallintra, xtc3_context.nsmallintra, bwlzh_buf,
-                                       &bwlzh_buf_len);
+                bwlzh_error = bwlzh_compress_no_lz77(xtc3_context.smallintra,
+                                                     xtc3_context.nsmallintra, bwlzh_buf,
+                                                     &bwlzh_buf_len);
+            }
+            if (bwlzh_error)
+            {
+                /* Use base compression instead. */
+                bwlzh_buf_len = INT_MAX;
             }
         }
         /* If this can be written smaller using base compression we should do that. */
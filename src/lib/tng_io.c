@@ -43,6 +43,13 @@
 #include "compression/tng_compress.h"
 #include "tng/version.h"
 
+#ifdef _OPENMP
+#    include <omp.h>
+#endif
+#ifdef TNG_USE_PTHREADS
+#    include <pthread.h>
+#endif
+
 #if defined(_WIN32) || defined(_WIN64)
 #    ifndef fseeko
 #        define fseeko _fseeki64
@@ -54,6 +61,12 @@
 #            define ftello _ftelli64
 #        endif
 #    endif
+#else
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+#    define TNG_USE_POSIX_IO
 #endif
 
 struct tng_bond
@@ -161,6 +174,30 @@ struct tng_gen_block
     char* block_contents;
 };
 
+/** The state of an XXH64 hash, while data is appended to it */
+struct tng_xxh64_state
+{
+    /** The total number of bytes appended */
+    uint64_t total_len;
+    /** The four accumulators, each processing 8 bytes of every 32 byte stripe */
+    uint64_t acc[4];
+    /** Appended bytes that do not yet fill a stripe */
+    unsigned char buffer[32];
+    /** The number of bytes in buffer */
+    int buffer_len;
+};
+
+/** The state of the hash of a block, while the block is read or written */
+struct tng_hash_state
+{
+    /** The type of the hash (TNG_MD5, TNG_XXH64 or TNG_NO_HASH) */
+    int64_t type;
+    /** The state if the type is TNG_MD5 */
+    md5_state_t md5;
+    /** The state if the type is TNG_XXH64 */
+    struct tng_xxh64_state xxh64;
+};
+
 struct tng_particle_mapping
 {
     /** The index number of the first particle in this mapping block */
@@ -174,12 +211,40 @@ struct tng_particle_mapping
     int64_t* real_particle_numbers;
 };
 
+/** An index of the particle mapping blocks of a frame set, for translating
+ *  between local and real particle numbers without scanning all blocks */
+struct tng_particle_mapping_index
+{
+    /** The number of mapping blocks in the index */
+    int64_t n_ranges;
+    /** The numbers of the mapping blocks, sorted by their first particle */
+    int64_t* ranges;
+    /** The length of local_particles, one more than the highest real particle
+     *  number */
+    int64_t n_real_particles;
+    /** The local particle number of each real particle number, -1 if the
+     *  particle is not mapped */
+    int64_t* local_particles;
+};
+
+/** An open addressing hash table mapping block IDs to positions in a list of
+ *  data blocks */
+struct tng_data_block_index
+{
+    /** The number of slots in the table, zero or a power of two */
+    int n_slots;
+    /** The position in the list of data blocks of each slot, -1 if empty */
+    int* slots;
+};
+
 struct tng_trajectory_frame_set
 {
     /** The number of different particle mapping blocks present. */
     int64_t n_mapping_blocks;
     /** The atom mappings of this frame set */
     struct tng_particle_mapping* mappings;
+    /** The index of the atom mappings */
+    struct tng_particle_mapping_index mapping_index;
     /** The first frame of this frame set */
     int64_t first_frame;
     /** The number of frames in this frame set */
@@ -218,10 +283,14 @@ struct tng_trajectory_frame_set
     int n_particle_data_blocks;
     /** A list of data blocks containing particle dependent data */
     struct tng_data* tr_particle_data;
+    /** The index of tr_particle_data by block ID */
+    struct tng_data_block_index tr_particle_data_index;
     /** The number of trajectory data blocks independent of particles */
     int n_data_blocks;
     /** A list of data blocks containing particle indepdendent data */
     struct tng_data* tr_data;
+    /** The index of tr_data by block ID */
+    struct tng_data_block_index tr_data_index;
 };
 
 /* FIXME: Should there be a pointer to a tng_gen_block from each data block? */
@@ -260,6 +329,138 @@ struct tng_data
     char**** strings;
 };
 
+/* The contents of a data block compressed before it is written. */
+struct tng_data_block_contents
+{
+    /** The compressed contents. 0 if they are not compressed yet. */
+    char* contents;
+    /** The length of the compressed contents */
+    int64_t len;
+};
+
+struct tng_frame_set_index_entry
+{
+    /** The number of the frame set, counted from the start of the file */
+    int64_t nr;
+    /** The first frame of the frame set */
+    int64_t first_frame;
+    /** The number of frames in the frame set */
+    int64_t n_frames;
+    /** The position of the frame set block in the file */
+    int64_t file_pos;
+    /** The time stamp of the first frame of the frame set */
+    double first_frame_time;
+};
+
+/** A read-only memory mapping of the input file. Cursors use it without data
+ * to read the file of their reader with positioned reads. */
+struct tng_input_map
+{
+    /** The file that is mapped */
+    FILE* file;
+    /** The file descriptor of file, used for positioned reads if data == 0 */
+    int fd;
+    /** The start of the mapped file contents. 0 if the file is not mapped. */
+    char* data;
+    /** TNG_TRUE if the mapping is removed when this struct is destroyed */
+    char owns_data;
+    /** The length of the mapping (or file) */
+    int64_t len;
+    /** The current read position in the mapping (or file) */
+    int64_t pos;
+};
+
+struct tng_frame_set_index
+{
+    /** TNG_TRUE if the index lists all frame sets of the file, in order */
+    char valid;
+    /** TNG_TRUE if the input file has been searched for an index block */
+    char searched;
+    /** The number of entries in the index */
+    int64_t n_entries;
+    /** The number of entries that memory has been allocated for */
+    int64_t n_allocated_entries;
+    /** A list of the frame sets of the file */
+    struct tng_frame_set_index_entry* entries;
+};
+
+/** The decoded values of a data block of a frame set, kept in the frame set
+ *  cache */
+struct tng_frame_set_cache_entry
+{
+    /** The file position of the block contents */
+    int64_t file_pos;
+    /** The ID of the block */
+    int64_t block_id;
+    /** The hash mode used when reading the block */
+    char hash_mode;
+    /** The type of data stored */
+    char datatype;
+    /** The number of values stored per frame */
+    int64_t n_values;
+    /** ID of the CODEC used for compression */
+    int64_t codec_id;
+    /** The frame number of the first data value */
+    int64_t first_frame_with_data;
+    /** The number of frames between each data point */
+    int64_t stride_length;
+    /** The number of frames in the block */
+    int64_t n_frames;
+    /** The number of the first particle in the block */
+    int64_t num_first_particle;
+    /** The number of particles in the block, 0 if the data is not particle
+     * dependent */
+    int64_t n_particles;
+    /** The multiplier used for getting integer values for compression */
+    double multiplier;
+    /** The decoded values of the block */
+    char* values;
+    /** The length of values in bytes */
+    int64_t values_len;
+    /** The next entry in the same hash table bucket */
+    struct tng_frame_set_cache_entry* bucket_next;
+    /** The entry used just before this one */
+    struct tng_frame_set_cache_entry* more_recent;
+    /** The entry used just after this one */
+    struct tng_frame_set_cache_entry* less_recent;
+};
+
+struct tng_frame_set_cache
+{
+    /** The maximum total size of the entries in bytes */
+    int64_t max_size;
+    /** The total size of the entries in bytes */
+    int64_t size;
+    /** The number of entries */
+    int64_t n_entries;
+    /** The number of hash table buckets, a power of two */
+    int64_t n_buckets;
+    /** The hash table of the entries, by file position */
+    struct tng_frame_set_cache_entry** buckets;
+    /** The most recently used entry */
+    struct tng_frame_set_cache_entry* most_recent;
+    /** The least recently used entry, the first to be evicted */
+    struct tng_frame_set_cache_entry* least_recent;
+};
+
+/** Cumulative particle and residue counts of the molecule types, for finding
+ *  the molecule of a particle number with a binary search */
+struct tng_molecule_index
+{
+    /** TNG_TRUE if the index matches the molecules and molecule counts */
+    char valid;
+    /** The number of molecule types in the index */
+    int64_t n_molecules;
+    /** The number of molecule types that memory has been allocated for */
+    int64_t n_allocated_molecules;
+    /** The number of the first particle of each molecule type, followed by
+     *  the total number of particles */
+    int64_t* first_particles;
+    /** The number of the first residue of each molecule type, followed by
+     *  the total number of residues */
+    int64_t* first_residues;
+};
+
 
 struct tng_trajectory
 {
@@ -269,6 +470,13 @@ struct tng_trajectory
     FILE* input_file;
     /** The length of the input file */
     int64_t input_file_len;
+    /** TNG_TRUE if the input file should be memory mapped when it is opened */
+    char input_file_map_flag;
+    /** The memory mapping of the input file. 0 if the file is not mapped. */
+    struct tng_input_map* input_map;
+    /** The trajectory that owns the topology, general information and input
+     * file used by this cursor. 0 if this trajectory is not a cursor. */
+    struct tng_trajectory* reader;
     /** The path of the output trajectory file */
     char* output_file_path;
     /** A handle to the output file */
@@ -338,6 +546,8 @@ struct tng_trajectory
     /** A list of the count of each molecule - if using variable number of
      *  particles this will be specified in each frame set */
     int64_t* molecule_cnt_list;
+    /** The index of the particles of the molecules */
+    struct tng_molecule_index molecule_index;
     /** The total number of particles/atoms. If using variable number of
      *  particles this will be specified in each frame set */
     int64_t n_particles;
@@ -359,17 +569,30 @@ struct tng_trajectory
     /** The number of frame sets in the trajectory N.B. Not saved in file and
      *  cannot be trusted to be up-to-date */
     int64_t n_trajectory_frame_sets;
+    /** The number of frame sets in the src file. -1 if not yet known. */
+    int64_t n_input_frame_sets;
+    /** The number of frames in the src file. -1 if not yet known. */
+    int64_t n_input_frames;
+    /** The frame set index block read from the src file, if any */
+    struct tng_frame_set_index input_frame_set_index;
+    /** The frame sets written to the dest file, written as an index block
+     *  when closing the file */
+    struct tng_frame_set_index output_frame_set_index;
 
     /* These data blocks are non-trajectory data blocks */
     /** The number of non-frame dependent particle dependent data blocks */
     int n_particle_data_blocks;
     /** A list of data blocks containing particle dependent data */
     struct tng_data* non_tr_particle_data;
+    /** The index of non_tr_particle_data by block ID */
+    struct tng_data_block_index non_tr_particle_data_index;
 
     /** The number of frame and particle independent data blocks */
     int n_data_blocks;
     /** A list of frame and particle indepdendent data blocks */
     struct tng_data* non_tr_data;
+    /** The index of non_tr_data by block ID */
+    struct tng_data_block_index non_tr_data_index;
 
     /** TNG compression algorithm for compressing positions */
     int* compress_algo_pos;
@@ -377,7 +600,168 @@ struct tng_trajectory
     int* compress_algo_vel;
     /** The precision used for lossy compression */
     double compression_precision;
+
+    /** The number of threads used for reading frame sets */
+    int64_t n_read_threads;
+    /** The number of data block IDs read by tng_frame_set_read(). If 0 all
+     * data blocks are read. */
+    int64_t n_read_block_ids;
+    /** The data block IDs read by tng_frame_set_read() */
+    int64_t* read_block_ids;
+    /** The number of threads used for compressing the data blocks of a frame
+     * set when writing it */
+    int64_t n_write_threads;
+    /** The type of hash written to the headers of blocks written with
+     * TNG_USE_HASH, TNG_MD5 or TNG_XXH64 */
+    int64_t output_hash_type;
+
+    /** TNG_TRUE if full frame sets are written to the output file in the
+     * background */
+    char write_behind_flag;
+    /** The frame set writing in the background. 0 if no frame set has been
+     * handed over since the output file was last used directly. */
+    struct tng_write_behind* write_behind;
+
+    /** The thread verifying the hashes of blocks read with TNG_USE_HASH in the
+     * background. 0 if the hashes are verified when reading the blocks. */
+    struct tng_hash_verifier* hash_verifier;
+    /** Called for each block with contents not matching its hash, found when
+     * verifying the hashes in the background */
+    tng_hash_mismatch_callback hash_mismatch_callback;
+    /** Passed to hash_mismatch_callback */
+    void* hash_mismatch_user_data;
+    /** The number of blocks with contents not matching their hashes, found when
+     * verifying the hashes in the background */
+    int64_t n_hash_mismatches;
+    /** The file positions of the blocks with contents not matching their hashes */
+    int64_t* hash_mismatches;
+
+    /** The thread reading frame sets ahead of tng_frame_set_read_next(). 0 if
+     * frame sets are only read when they are requested. */
+    struct tng_prefetch* prefetch;
+
+    /** The decoded data blocks of recently read frame sets. 0 if data blocks
+     * are always read from the input file. */
+    struct tng_frame_set_cache* frame_set_cache;
+};
+
+#ifdef TNG_USE_PTHREADS
+struct tng_write_behind
+{
+    /** The trajectory used by the background thread to write frame sets. It
+     * shares the output file and the topology of the writing trajectory. */
+    struct tng_trajectory* writer;
+    /** The background thread */
+    pthread_t thread;
+    /** Protects the members below */
+    pthread_mutex_t mutex;
+    /** Signalled when a frame set is handed over, when it is written and when
+     * the thread should finish */
+    pthread_cond_t cond;
+    /** TNG_TRUE while a frame set is handed over and not yet written */
+    char busy;
+    /** TNG_TRUE if the thread should finish after writing the current frame
+     * set */
+    char quit;
+    /** TNG_TRUE if the file pointers of the handed over frame set are
+     * already set up by tng_frame_set_new() */
+    char prepared;
+    /** The status of the first failed frame set writing */
+    tng_function_status stat;
+};
+
+/** A block of which the hash is verified in the background */
+struct tng_hash_check
+{
+    /** The ID of the block */
+    int64_t block_id;
+    /** The file position of the block header */
+    int64_t header_pos;
+    /** The file position of the block contents */
+    int64_t contents_pos;
+    /** The size of the block contents in bytes */
+    int64_t contents_size;
+    /** The type of the hash, TNG_MD5 or TNG_XXH64 */
+    int64_t hash_type;
+    /** The length of the hash in bytes */
+    int64_t hash_len;
+    /** The hash stored in the block header */
+    char hash[TNG_MD5_HASH_LEN];
+};
+
+struct tng_hash_verifier
+{
+    /** The trajectory of which the blocks are verified. Mismatches are added
+     * to its list of hash mismatches. */
+    struct tng_trajectory* tng_data;
+    /** A separate handle of the input file, used for reading the blocks again */
+    FILE* file;
+    /** The background thread */
+    pthread_t thread;
+    /** Protects the members below, as well as the hash mismatch list and
+     * callback of tng_data */
+    pthread_mutex_t mutex;
+    /** Signalled when a block is added, when a block has been verified and
+     * when the thread should finish */
+    pthread_cond_t cond;
+    /** The blocks to verify. The blocks before next_check have been verified. */
+    struct tng_hash_check* checks;
+    /** The number of blocks in checks */
+    int64_t n_checks;
+    /** The number of blocks that memory has been allocated for in checks */
+    int64_t n_allocated_checks;
+    /** The next block to verify */
+    int64_t next_check;
+    /** TNG_TRUE if the thread should finish after verifying the remaining
+     * blocks */
+    char quit;
+};
+
+/** A frame set read ahead by the prefetching thread */
+struct tng_prefetch_slot
+{
+    /** The cursor the frame set is read into */
+    struct tng_trajectory* cursor;
+    /** The file position of the frame set */
+    int64_t file_pos;
+    /** The file position following the frame set */
+    int64_t end_pos;
+    /** The hash mode used when reading the frame set */
+    char hash_mode;
+};
+
+struct tng_prefetch
+{
+    /** The background thread */
+    pthread_t thread;
+    /** Protects the members below */
+    pthread_mutex_t mutex;
+    /** Signalled when a frame set has been read ahead, when one has been taken
+     * over, when the read ahead frame sets are discarded and when the thread
+     * should finish */
+    pthread_cond_t cond;
+    /** The frame sets read ahead, in file order starting at first_slot */
+    struct tng_prefetch_slot* slots;
+    /** The maximum number of frame sets read ahead */
+    int64_t n_slots;
+    /** The slot of the next frame set to take over */
+    int64_t first_slot;
+    /** The number of frame sets read ahead and not yet taken over */
+    int64_t n_ready;
+    /** The file position of the next frame set to read ahead, or -1 if there
+     * is none */
+    int64_t next_file_pos;
+    /** The file position of the frame set being read ahead, or -1 */
+    int64_t reading_file_pos;
+    /** The hash mode used for reading ahead, the one last requested */
+    char hash_mode;
+    /** Incremented when the frame sets read ahead are discarded, so that a
+     * frame set being read at the time is discarded as well */
+    int64_t generation;
+    /** TNG_TRUE if the thread should finish */
+    char quit;
 };
+#endif
 
 #ifndef USE_WINDOWS
 #    if defined(WIN32) || defined(_WIN32) || defined(WIN64) || defined(_WIN64)
@@ -408,6 +792,236 @@ static TNG_INLINE int64_t tng_max_i64(const int64_t a, const int64_t b)
     return (a > b ? a : b);
 }
 
+/**
+ * @brief Check if reads from the input file are served from its memory mapping
+ * (or, for a cursor, by positioned reads of the file of its reader).
+ * @details The write functions temporarily use the output file as input file,
+ * in which case the mapping is not used.
+ * @param tng_data is a trajectory data container.
+ * @return TNG_TRUE if the current input file is mapped, otherwise TNG_FALSE.
+ */
+static TNG_INLINE tng_bool tng_input_file_is_mapped(const struct tng_trajectory* tng_data)
+{
+    if (tng_data->input_map && tng_data->input_map->file == tng_data->input_file)
+    {
+        return (TNG_TRUE);
+    }
+    return (TNG_FALSE);
+}
+
+/**
+ * @brief Get the current position in the input file.
+ * @param tng_data is a trajectory data container.
+ * @return The current position in the input file or -1 if it cannot be determined.
+ */
+static TNG_INLINE int64_t tng_input_file_tell(const struct tng_trajectory* tng_data)
+{
+    if (tng_input_file_is_mapped(tng_data))
+    {
+        return (tng_data->input_map->pos);
+    }
+    return (ftello(tng_data->input_file));
+}
+
+/**
+ * @brief Set the position in the input file.
+ * @param tng_data is a trajectory data container.
+ * @param offset is the offset relative to origin.
+ * @param origin is SEEK_SET, SEEK_CUR or SEEK_END, as for fseeko().
+ * @return 0 if successful, otherwise non-zero.
+ */
+static TNG_INLINE int tng_input_file_seek(const struct tng_trajectory* tng_data, const int64_t offset, const int origin)
+{
+    struct tng_input_map* map;
+    int64_t               pos;
+
+    if (!tng_input_file_is_mapped(tng_data))
+    {
+        return (fseeko(tng_data->input_file, offset, origin));
+    }
+
+    map = tng_data->input_map;
+    switch (origin)
+    {
+        case SEEK_SET: pos = offset; break;
+        case SEEK_CUR: pos = map->pos + offset; break;
+        default: pos = map->len + offset; break;
+    }
+    if (pos < 0)
+    {
+        return (-1);
+    }
+    map->pos = pos;
+
+    return (0);
+}
+
+/**
+ * @brief Read data from a given position of a file without using or moving
+ * the file position, so that several threads can read the same file.
+ * @param map is the input map containing the file descriptor of the file.
+ * @param dest is a pointer to where to store the read data.
+ * @param len is the number of bytes to read.
+ * @param pos is the position in the file to read from.
+ * @return The number of bytes read.
+ */
+static int64_t tng_input_file_pread(const struct tng_input_map* map, char* dest, const int64_t len, const int64_t pos)
+{
+#ifdef TNG_USE_POSIX_IO
+    int64_t n_read = 0;
+    ssize_t n;
+
+    while (n_read < len)
+    {
+        n = pread(map->fd, dest + n_read, len - n_read, pos + n_read);
+        if (n <= 0)
+        {
+            break;
+        }
+        n_read += n;
+    }
+
+    return (n_read);
+#else
+    (void)map;
+    (void)dest;
+    (void)len;
+    (void)pos;
+    return (0);
+#endif
+}
+
+/**
+ * @brief Read data from the current position in the input file.
+ * @param tng_data is a trajectory data container.
+ * @param dest is a pointer to where to store the read data.
+ * @param len is the number of bytes to read.
+ * @return 1 if len bytes were read, otherwise 0 (as fread() with one item).
+ */
+static TNG_INLINE size_t tng_input_file_read(const struct tng_trajectory* tng_data, void* dest, const int64_t len)
+{
+    struct tng_input_map* map;
+
+    if (!tng_input_file_is_mapped(tng_data))
+    {
+        return (fread(dest, len, 1, tng_data->input_file));
+    }
+
+    map = tng_data->input_map;
+    if (len > map->len - map->pos)
+    {
+        map->pos = tng_max_i64(map->pos, map->len);
+        return (0);
+    }
+    if (map->data)
+    {
+        memcpy(dest, map->data + map->pos, len);
+    }
+    else if (tng_input_file_pread(map, (char*)dest, len, map->pos) != len)
+    {
+        return (0);
+    }
+    map->pos += len;
+
+    return (1);
+}
+
+/**
+ * @brief Get a pointer to data at the current position in the memory mapped
+ * input file and move past the data.
+ * @param tng_data is a trajectory data container.
+ * @param len is the number of bytes that will be accessed.
+ * @return A pointer into the mapping, which stays valid until the input file
+ * is closed, or 0 if the input file is not mapped or too short.
+ */
+static TNG_INLINE const char* tng_input_file_view(const struct tng_trajectory* tng_data, const int64_t len)
+{
+    struct tng_input_map* map;
+    const char*           view;
+
+    if (!tng_input_file_is_mapped(tng_data))
+    {
+        return (0);
+    }
+
+    map = tng_data->input_map;
+    if (!map->data || len > map->len - map->pos)
+    {
+        return (0);
+    }
+    view = map->data + map->pos;
+    map->pos += len;
+
+    return (view);
+}
+
+/**
+ * @brief Map the opened input file into memory. If the file cannot be mapped
+ * it is read using the stdio functions instead.
+ * @param tng_data is a trajectory data container.
+ * @return TNG_SUCCESS (0) if successful or TNG_FAILURE (1) if the file
+ * could not be mapped.
+ */
+static tng_function_status tng_input_map_create(struct tng_trajectory* tng_data)
+{
+#ifdef TNG_USE_POSIX_IO
+    struct tng_input_map* map;
+    struct stat           file_stat;
+    void*                 data;
+
+    if (fstat(fileno(tng_data->input_file), &file_stat) != 0 || file_stat.st_size <= 0)
+    {
+        return (TNG_FAILURE);
+    }
+    data = mmap(0, file_stat.st_size, PROT_READ, MAP_PRIVATE, fileno(tng_data->input_file), 0);
+    if (data == MAP_FAILED)
+    {
+        return (TNG_FAILURE);
+    }
+
+    map = (struct tng_input_map*)malloc(sizeof(struct tng_input_map));
+    if (!map)
+    {
+        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+        munmap(data, file_stat.st_size);
+        return (TNG_FAILURE);
+    }
+    map->file      = tng_data->input_file;
+    map->fd        = fileno(tng_data->input_file);
+    map->data      = (char*)data;
+    map->owns_data = TNG_TRUE;
+    map->len       = file_stat.st_size;
+    map->pos       = ftello(tng_data->input_file);
+
+    tng_data->input_map = map;
+
+    return (TNG_SUCCESS);
+#else
+    (void)tng_data;
+    return (TNG_FAILURE);
+#endif
+}
+
+/**
+ * @brief Remove the memory mapping of the input file, if there is one.
+ * @param tng_data is a trajectory data container.
+ */
+static void tng_input_map_destroy(struct tng_trajectory* tng_data)
+{
+    if (!tng_data->input_map)
+    {
+        return;
+    }
+#ifdef TNG_USE_POSIX_IO
+    if (tng_data->input_map->owns_data)
+    {
+        munmap(tng_data->input_map->data, tng_data->input_map->len);
+    }
+#endif
+    free(tng_data->input_map);
+    tng_data->input_map = 0;
+}
+
 /**
  * @brief This function swaps the byte order of a 32 bit numerical variable
  * to big endian.
@@ -580,1362 +1194,1370 @@ static tng_function_status tng_swap_byte_order_little_endian_64(const struct tng
 }
 
 /**
- * @brief Read a NULL terminated string from a file.
- * @param tng_data is a trajectory data container
- * @param str is a pointer to the character string that will
- * contain the read string. *str is reallocated in the function
- * and must be NULL or pointing at already allocated memory.
- * @param hash_mode is an option to decide whether to use the md5 hash or not.
- * @param md5_state is a pointer to the current md5 storage, which will be
- * appended with str if hash_mode == TNG_USE_HASH.
- * @param line_nr is the line number where this function was called, to be
- * able to give more useful error messages.
+ * @brief Reverse the byte order of an array of 32 bit values while copying them.
+ * @param dest is where the swapped values are written. It may be the same as src.
+ * @param src is the values to swap. Neither src nor dest need to be aligned.
+ * @param n is the number of values.
+ * @details The loop works on bytes, without branches or function calls, so that
+ * it can be vectorised by the compiler.
  */
-static tng_function_status tng_freadstr(const struct tng_trajectory* tng_data,
-                                        char**                       str,
-                                        const char                   hash_mode,
-                                        md5_state_t*                 md5_state,
-                                        const int                    line_nr)
+static void tng_bytes_reverse_copy_32(char* dest, const char* src, const int64_t n)
 {
-    char temp[TNG_MAX_STR_LEN], *temp_alloc;
-    int  c, count = 0;
+    const unsigned char* s = (const unsigned char*)src;
+    unsigned char*       d = (unsigned char*)dest;
+    unsigned char        b0, b1, b2, b3;
+    int64_t              i;
 
-    do
+    for (i = 0; i < n; i++, s += 4, d += 4)
     {
-        c = fgetc(tng_data->input_file);
+        b0   = s[0];
+        b1   = s[1];
+        b2   = s[2];
+        b3   = s[3];
+        d[0] = b3;
+        d[1] = b2;
+        d[2] = b1;
+        d[3] = b0;
+    }
+}
 
-        if (c == EOF)
-        {
-            /* Clear file error flag and return -1 if EOF is read.*/
-            clearerr(tng_data->input_file);
-            return TNG_FAILURE;
-        }
-        else
+/**
+ * @brief Reverse the byte order of an array of 64 bit values while copying them.
+ * @param dest is where the swapped values are written. It may be the same as src.
+ * @param src is the values to swap. Neither src nor dest need to be aligned.
+ * @param n is the number of values.
+ * @details The loop works on bytes, without branches or function calls, so that
+ * it can be vectorised by the compiler.
+ */
+static void tng_bytes_reverse_copy_64(char* dest, const char* src, const int64_t n)
+{
+    const unsigned char* s = (const unsigned char*)src;
+    unsigned char*       d = (unsigned char*)dest;
+    unsigned char        b0, b1, b2, b3, b4, b5, b6, b7;
+    int64_t              i;
+
+    for (i = 0; i < n; i++, s += 8, d += 8)
+    {
+        b0   = s[0];
+        b1   = s[1];
+        b2   = s[2];
+        b3   = s[3];
+        b4   = s[4];
+        b5   = s[5];
+        b6   = s[6];
+        b7   = s[7];
+        d[0] = b7;
+        d[1] = b6;
+        d[2] = b5;
+        d[3] = b4;
+        d[4] = b3;
+        d[5] = b2;
+        d[6] = b1;
+        d[7] = b0;
+    }
+}
+
+/**
+ * @brief Copy an array of 32 bit values, swapping their byte order with swap_func.
+ * @param tng_data is a trajectory data container.
+ * @param swap_func is the byte order swapping function, e.g.
+ * tng_data->input_endianness_swap_func_32. If it is NULL the values are only copied.
+ * @param dest is where the values are written. It may be the same as src.
+ * @param src is the values to copy. Neither src nor dest need to be aligned.
+ * @param n is the number of values.
+ * @details When the byte order only needs to be reversed, which is the case
+ * when converting between big and little endian, the whole array is swapped in
+ * one pass. Other byte orders are swapped one value at a time.
+ * @return TNG_SUCCESS (0) if successful or TNG_FAILURE (1) if the byte order
+ * could not be swapped.
+ */
+static tng_function_status tng_swap_byte_order_copy_32(
+        const struct tng_trajectory* tng_data,
+        tng_function_status (*swap_func)(const struct tng_trajectory*, uint32_t*),
+        char*         dest,
+        const char*   src,
+        const int64_t n)
+{
+    uint32_t v;
+    int64_t  i;
+
+    if (!swap_func)
+    {
+        if (dest != src)
         {
-            /* Cast c to char */
-            temp[count++] = (char)c;
+            memcpy(dest, src, n * sizeof(uint32_t));
         }
-    } while ((temp[count - 1] != '\0') && (count < TNG_MAX_STR_LEN));
+        return (TNG_SUCCESS);
+    }
 
-    temp_alloc = (char*)realloc(*str, count);
-    if (!temp_alloc)
+    if ((swap_func == tng_swap_byte_order_big_endian_32
+         && tng_data->endianness_32 == TNG_LITTLE_ENDIAN_32)
+        || (swap_func == tng_swap_byte_order_little_endian_32
+            && tng_data->endianness_32 == TNG_BIG_ENDIAN_32))
     {
-        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, line_nr);
-        free(*str);
-        *str = 0;
-        return TNG_FAILURE;
+        tng_bytes_reverse_copy_32(dest, src, n);
+        return (TNG_SUCCESS);
     }
-    *str = temp_alloc;
-
-    strncpy(*str, temp, count);
 
-    if (hash_mode == TNG_USE_HASH)
+    for (i = 0; i < n; i++)
     {
-        md5_append(md5_state, (md5_byte_t*)*str, count);
+        memcpy(&v, src + i * sizeof(uint32_t), sizeof(uint32_t));
+        if (swap_func(tng_data, &v) != TNG_SUCCESS)
+        {
+            return (TNG_FAILURE);
+        }
+        memcpy(dest + i * sizeof(uint32_t), &v, sizeof(uint32_t));
     }
 
-    return TNG_SUCCESS;
+    return (TNG_SUCCESS);
 }
 
 /**
- * @brief Write a NULL terminated string to a file.
- * @param tng_data is a trajectory data container
- * @param str is a pointer to the character string should be written.
- * @param hash_mode is an option to decide whether to use the md5 hash or not.
- * @param md5_state is a pointer to the current md5 storage, which will be
- * appended with str if hash_mode == TNG_USE_HASH.
- * @param line_nr is the line number where this function was called, to be
- * able to give more useful error messages.
+ * @brief Copy an array of 64 bit values, swapping their byte order with swap_func.
+ * @param tng_data is a trajectory data container.
+ * @param swap_func is the byte order swapping function, e.g.
+ * tng_data->input_endianness_swap_func_64. If it is NULL the values are only copied.
+ * @param dest is where the values are written. It may be the same as src.
+ * @param src is the values to copy. Neither src nor dest need to be aligned.
+ * @param n is the number of values.
+ * @details When the byte order only needs to be reversed, which is the case
+ * when converting between big and little endian, the whole array is swapped in
+ * one pass. Other byte orders are swapped one value at a time.
+ * @return TNG_SUCCESS (0) if successful or TNG_FAILURE (1) if the byte order
+ * could not be swapped.
  */
-static TNG_INLINE tng_function_status tng_fwritestr(tng_trajectory_t tng_data,
-                                                    const char*      str,
-                                                    const char       hash_mode,
-                                                    md5_state_t*     md5_state,
-                                                    const int        line_nr)
+static tng_function_status tng_swap_byte_order_copy_64(
+        const struct tng_trajectory* tng_data,
+        tng_function_status (*swap_func)(const struct tng_trajectory*, uint64_t*),
+        char*         dest,
+        const char*   src,
+        const int64_t n)
 {
-    size_t len;
+    uint64_t v;
+    int64_t  i;
 
-    len = tng_min_size(strlen(str) + 1, TNG_MAX_STR_LEN);
+    if (!swap_func)
+    {
+        if (dest != src)
+        {
+            memcpy(dest, src, n * sizeof(uint64_t));
+        }
+        return (TNG_SUCCESS);
+    }
 
-    if (fwrite(str, len, 1, tng_data->output_file) != 1)
+    if ((swap_func == tng_swap_byte_order_big_endian_64
+         && tng_data->endianness_64 == TNG_LITTLE_ENDIAN_64)
+        || (swap_func == tng_swap_byte_order_little_endian_64
+            && tng_data->endianness_64 == TNG_BIG_ENDIAN_64))
     {
-        fprintf(stderr, "TNG library: Could not write block data. %s: %d\n", __FILE__, line_nr);
-        return (TNG_CRITICAL);
+        tng_bytes_reverse_copy_64(dest, src, n);
+        return (TNG_SUCCESS);
     }
 
-    if (hash_mode == TNG_USE_HASH)
+    for (i = 0; i < n; i++)
     {
-        md5_append(md5_state, (md5_byte_t*)str, len);
+        memcpy(&v, src + i * sizeof(uint64_t), sizeof(uint64_t));
+        if (swap_func(tng_data, &v) != TNG_SUCCESS)
+        {
+            return (TNG_FAILURE);
+        }
+        memcpy(dest + i * sizeof(uint64_t), &v, sizeof(uint64_t));
     }
 
     return (TNG_SUCCESS);
 }
 
-/**
- * @brief Read a numerical value from file.
- * The byte order will be swapped if need be.
- * @param tng_data is a trajectory data container
- * @param dest is a pointer to where to store the read data.
- * @param len is the length (in bytes) of the numerical data type. Should
- * be 8 for 64 bit, 4 for 32 bit or 1 for a single byte flag.
- * @param hash_mode is an option to decide whether to use the md5 hash or not.
- * @param md5_state is a pointer to the current md5 storage, which will be
- * appended with str if hash_mode == TNG_USE_HASH.
- * @param line_nr is the line number where this function was called, to be
- * able to give more useful error messages.
- */
-static TNG_INLINE tng_function_status tng_file_input_numerical(const struct tng_trajectory* tng_data,
-                                                               void*                        dest,
-                                                               const size_t                 len,
-                                                               const char   hash_mode,
-                                                               md5_state_t* md5_state,
-                                                               const int    line_nr)
+#define TNG_XXH64_PRIME_1 0x9E3779B185EBCA87ULL
+#define TNG_XXH64_PRIME_2 0xC2B2AE3D27D4EB4FULL
+#define TNG_XXH64_PRIME_3 0x165667B19E3779F9ULL
+#define TNG_XXH64_PRIME_4 0x85EBCA77C2B2AE63ULL
+#define TNG_XXH64_PRIME_5 0x27D4EB2F165667C5ULL
+
+static TNG_INLINE uint64_t tng_xxh64_rotl(const uint64_t x, const int r)
 {
-    if (fread(dest, len, 1, tng_data->input_file) == 0)
-    {
-        fprintf(stderr, "TNG library: Cannot read block. %s: %d\n", __FILE__, line_nr);
-        return (TNG_CRITICAL);
-    }
-    if (hash_mode == TNG_USE_HASH)
-    {
-        md5_append(md5_state, (md5_byte_t*)dest, len);
-    }
-    switch (len)
-    {
-        case 8:
-            if (tng_data->input_endianness_swap_func_64
-                && tng_data->input_endianness_swap_func_64(tng_data, (uint64_t*)dest) != TNG_SUCCESS)
-            {
-                fprintf(stderr, "TNG library: Cannot swap byte order. %s: %d\n", __FILE__, line_nr);
-            }
-            break;
-        case 4:
-            if (tng_data->input_endianness_swap_func_32
-                && tng_data->input_endianness_swap_func_32(tng_data, (uint32_t*)dest) != TNG_SUCCESS)
-            {
-                fprintf(stderr, "TNG library: Cannot swap byte order. %s: %d\n", __FILE__, line_nr);
-            }
-            break;
-        default: break;
-    }
+    return ((x << r) | (x >> (64 - r)));
+}
 
-    return (TNG_SUCCESS);
+/** Read 8 bytes as a little endian 64 bit value, regardless of the architecture. */
+static TNG_INLINE uint64_t tng_xxh64_read_64(const unsigned char* p)
+{
+    return ((uint64_t)p[0] | ((uint64_t)p[1] << 8) | ((uint64_t)p[2] << 16) | ((uint64_t)p[3] << 24)
+            | ((uint64_t)p[4] << 32) | ((uint64_t)p[5] << 40) | ((uint64_t)p[6] << 48)
+            | ((uint64_t)p[7] << 56));
 }
 
-/**
- * @brief Write a numerical value to file.
- * The byte order will be swapped if need be.
- * @param tng_data is a trajectory data container
- * @param src is a pointer to the data to write.
- * @param len is the length (in bytes) of the numerical data type. Should
- * be 8 for 64 bit, 4 for 32 bit or 1 for a single byte flag.
- * @param hash_mode is an option to decide whether to use the md5 hash or not.
- * @param md5_state is a pointer to the current md5 storage, which will be
- * appended with str if hash_mode == TNG_USE_HASH.
- * @param line_nr is the line number where this function was called, to be
- * able to give more useful error messages.
- */
-static TNG_INLINE tng_function_status tng_file_output_numerical(const struct tng_trajectory* tng_data,
-                                                                const void*                  src,
-                                                                const size_t                 len,
-                                                                const char   hash_mode,
-                                                                md5_state_t* md5_state,
-                                                                const int    line_nr)
+/** Read 4 bytes as a little endian 32 bit value, regardless of the architecture. */
+static TNG_INLINE uint64_t tng_xxh64_read_32(const unsigned char* p)
 {
-    uint32_t temp_i32;
-    uint64_t temp_i64;
+    return ((uint64_t)p[0] | ((uint64_t)p[1] << 8) | ((uint64_t)p[2] << 16)
+            | ((uint64_t)p[3] << 24));
+}
 
-    switch (len)
-    {
-        case 8:
-            temp_i64 = *((uint64_t*)src);
-            if (tng_data->output_endianness_swap_func_64
-                && tng_data->output_endianness_swap_func_64(tng_data, &temp_i64) != TNG_SUCCESS)
-            {
-                fprintf(stderr, "TNG library: Cannot swap byte order. %s: %d\n", __FILE__, line_nr);
-            }
-            if (fwrite(&temp_i64, len, 1, tng_data->output_file) != 1)
-            {
-                fprintf(stderr, "TNG library: Could not write data. %s: %d\n", __FILE__, line_nr);
-                return (TNG_CRITICAL);
-            }
-            if (hash_mode == TNG_USE_HASH)
-            {
-                md5_append(md5_state, (md5_byte_t*)&temp_i64, len);
-            }
-            break;
-        case 4:
-            temp_i32 = *((uint32_t*)src);
-            if (tng_data->output_endianness_swap_func_32
-                && tng_data->output_endianness_swap_func_32(tng_data, &temp_i32) != TNG_SUCCESS)
-            {
-                fprintf(stderr, "TNG library: Cannot swap byte order. %s: %d\n", __FILE__, line_nr);
-            }
-            if (fwrite(&temp_i32, len, 1, tng_data->output_file) != 1)
-            {
-                fprintf(stderr, "TNG library: Could not write data. %s: %d\n", __FILE__, line_nr);
-                return (TNG_CRITICAL);
-            }
-            if (hash_mode == TNG_USE_HASH)
-            {
-                md5_append(md5_state, (md5_byte_t*)&temp_i32, len);
-            }
-            break;
-        default:
-            if (fwrite(src, len, 1, tng_data->output_file) != 1)
-            {
-                fprintf(stderr, "TNG library: Could not write data. %s: %d\n", __FILE__, line_nr);
-                return (TNG_CRITICAL);
-            }
-            if (hash_mode == TNG_USE_HASH)
-            {
-                md5_append(md5_state, (md5_byte_t*)src, len);
-            }
-            break;
-    }
+static TNG_INLINE uint64_t tng_xxh64_round(uint64_t acc, const uint64_t input)
+{
+    acc += input * TNG_XXH64_PRIME_2;
+    acc = tng_xxh64_rotl(acc, 31);
+    return (acc * TNG_XXH64_PRIME_1);
+}
 
-    return (TNG_SUCCESS);
+static TNG_INLINE uint64_t tng_xxh64_merge_round(uint64_t acc, const uint64_t val)
+{
+    acc ^= tng_xxh64_round(0, val);
+    return (acc * TNG_XXH64_PRIME_1 + TNG_XXH64_PRIME_4);
 }
 
 /**
- * @brief Generate the md5 hash of a block.
- * The hash is created based on the actual block contents.
- * @param block is a general block container.
- * @return TNG_SUCCESS (0) if successful.
+ * @brief Start an XXH64 hash, with seed 0.
+ * @param state is the hash state to initialise.
  */
-static tng_function_status tng_block_md5_hash_generate(const struct tng_gen_block* block)
+static void tng_xxh64_init(struct tng_xxh64_state* state)
 {
-    md5_state_t md5_state;
-
-    md5_init(&md5_state);
-    md5_append(&md5_state, (md5_byte_t*)block->block_contents, (int)block->block_contents_size);
-    md5_finish(&md5_state, (md5_byte_t*)block->md5_hash);
-
-    return (TNG_SUCCESS);
+    state->total_len  = 0;
+    state->acc[0]     = TNG_XXH64_PRIME_1 + TNG_XXH64_PRIME_2;
+    state->acc[1]     = TNG_XXH64_PRIME_2;
+    state->acc[2]     = 0;
+    state->acc[3]     = 0 - TNG_XXH64_PRIME_1;
+    state->buffer_len = 0;
 }
 
 /**
- * @brief If there is data left in the block read that to append that to the MD5 hash.
- * @param tng_data is a trajectory data container.
- * @param block is the data block that is being read.
- * @param start_pos is the file position where the block started.
- * @param md5_state is the md5 to which the md5 of the remaining block
- * will be appended.
- * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
- * error has occured.
+ * @brief Append data to an XXH64 hash.
+ * @param state is the hash state.
+ * @param data is the data to append.
+ * @param len is the number of bytes to append.
  */
-static tng_function_status tng_md5_remaining_append(const struct tng_trajectory* tng_data,
-                                                    const struct tng_gen_block*  block,
-                                                    const int64_t                start_pos,
-                                                    md5_state_t*                 md5_state)
+static void tng_xxh64_append(struct tng_xxh64_state* state, const void* data, int64_t len)
 {
-    int64_t curr_file_pos;
-    char*   temp_data;
+    const unsigned char* p = (const unsigned char*)data;
+    uint64_t             acc0, acc1, acc2, acc3;
+    int64_t              n;
 
-    curr_file_pos = ftello(tng_data->input_file);
-    if (curr_file_pos < start_pos + block->block_contents_size)
+    state->total_len += len;
+
+    if (state->buffer_len > 0)
     {
-        temp_data = (char*)malloc(start_pos + block->block_contents_size - curr_file_pos);
-        if (!temp_data)
-        {
-            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
-            return (TNG_CRITICAL);
-        }
-        if (fread(temp_data, start_pos + block->block_contents_size - curr_file_pos, 1, tng_data->input_file)
-            == 0)
+        n = tng_min_i64(len, 32 - state->buffer_len);
+        memcpy(state->buffer + state->buffer_len, p, n);
+        state->buffer_len += (int)n;
+        p += n;
+        len -= n;
+        if (state->buffer_len < 32)
         {
-            fprintf(stderr,
-                    "TNG library: Cannot read remaining part of block to generate MD5 sum. %s: "
-                    "%d\n",
-                    __FILE__, __LINE__);
-            free(temp_data);
-            return (TNG_CRITICAL);
+            return;
         }
-        md5_append(md5_state, (md5_byte_t*)temp_data, start_pos + block->block_contents_size - curr_file_pos);
-        free(temp_data);
+        state->acc[0]     = tng_xxh64_round(state->acc[0], tng_xxh64_read_64(state->buffer));
+        state->acc[1]     = tng_xxh64_round(state->acc[1], tng_xxh64_read_64(state->buffer + 8));
+        state->acc[2]     = tng_xxh64_round(state->acc[2], tng_xxh64_read_64(state->buffer + 16));
+        state->acc[3]     = tng_xxh64_round(state->acc[3], tng_xxh64_read_64(state->buffer + 24));
+        state->buffer_len = 0;
     }
 
-    return (TNG_SUCCESS);
+    acc0 = state->acc[0];
+    acc1 = state->acc[1];
+    acc2 = state->acc[2];
+    acc3 = state->acc[3];
+    for (; len >= 32; len -= 32, p += 32)
+    {
+        acc0 = tng_xxh64_round(acc0, tng_xxh64_read_64(p));
+        acc1 = tng_xxh64_round(acc1, tng_xxh64_read_64(p + 8));
+        acc2 = tng_xxh64_round(acc2, tng_xxh64_read_64(p + 16));
+        acc3 = tng_xxh64_round(acc3, tng_xxh64_read_64(p + 24));
+    }
+    state->acc[0] = acc0;
+    state->acc[1] = acc1;
+    state->acc[2] = acc2;
+    state->acc[3] = acc3;
+
+    if (len > 0)
+    {
+        memcpy(state->buffer, p, len);
+        state->buffer_len = (int)len;
+    }
 }
 
 /**
- * @brief Open the input file if it is not already opened.
- * @param tng_data is a trajectory data container.
- * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
- * error has occured.
+ * @brief Finish an XXH64 hash.
+ * @param state is the hash state.
+ * @param hash is where the TNG_XXH64_HASH_LEN bytes of the hash are stored,
+ * most significant byte first.
  */
-static tng_function_status tng_input_file_init(struct tng_trajectory* tng_data)
+static void tng_xxh64_finish(const struct tng_xxh64_state* state, char* hash)
 {
-    int64_t file_pos;
+    const unsigned char* p   = state->buffer;
+    const unsigned char* end = state->buffer + state->buffer_len;
+    uint64_t             h;
+    int                  i;
 
-    if (!tng_data->input_file)
+    if (state->total_len >= 32)
     {
-        if (!tng_data->input_file_path)
-        {
-            fprintf(stderr, "TNG library: No file specified for reading. %s: %d\n", __FILE__, __LINE__);
-            return (TNG_CRITICAL);
-        }
-        tng_data->input_file = fopen(tng_data->input_file_path, "rb");
-        if (!tng_data->input_file)
+        h = tng_xxh64_rotl(state->acc[0], 1) + tng_xxh64_rotl(state->acc[1], 7)
+            + tng_xxh64_rotl(state->acc[2], 12) + tng_xxh64_rotl(state->acc[3], 18);
+        for (i = 0; i < 4; i++)
         {
-            fprintf(stderr, "TNG library: Cannot open file %s. %s: %d\n", tng_data->input_file_path,
-                    __FILE__, __LINE__);
-            return (TNG_CRITICAL);
+            h = tng_xxh64_merge_round(h, state->acc[i]);
         }
     }
+    else
+    {
+        h = state->acc[2] + TNG_XXH64_PRIME_5;
+    }
+    h += state->total_len;
 
-    if (!tng_data->input_file_len)
+    for (; p + 8 <= end; p += 8)
+    {
+        h ^= tng_xxh64_round(0, tng_xxh64_read_64(p));
+        h = tng_xxh64_rotl(h, 27) * TNG_XXH64_PRIME_1 + TNG_XXH64_PRIME_4;
+    }
+    if (p + 4 <= end)
     {
-        file_pos = ftello(tng_data->input_file);
-        fseeko(tng_data->input_file, 0, SEEK_END);
-        tng_data->input_file_len = ftello(tng_data->input_file);
-        fseeko(tng_data->input_file, file_pos, SEEK_SET);
+        h ^= tng_xxh64_read_32(p) * TNG_XXH64_PRIME_1;
+        h = tng_xxh64_rotl(h, 23) * TNG_XXH64_PRIME_2 + TNG_XXH64_PRIME_3;
+        p += 4;
+    }
+    for (; p < end; p++)
+    {
+        h ^= (*p) * TNG_XXH64_PRIME_5;
+        h = tng_xxh64_rotl(h, 11) * TNG_XXH64_PRIME_1;
     }
 
-    return (TNG_SUCCESS);
+    h ^= h >> 33;
+    h *= TNG_XXH64_PRIME_2;
+    h ^= h >> 29;
+    h *= TNG_XXH64_PRIME_3;
+    h ^= h >> 32;
+
+    for (i = 0; i < TNG_XXH64_HASH_LEN; i++)
+    {
+        hash[i] = (char)(h >> (56 - 8 * i));
+    }
 }
 
 /**
- * @brief Open the output file if it is not already opened
- * @param tng_data is a trajectory data container.
- * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
- * error has occured.
+ * @brief Start generating a hash.
+ * @param hash_state is the hash state to initialise.
+ * @param type is the type of hash, TNG_MD5 or TNG_XXH64. Other types of hashes
+ * are not generated.
  */
-static tng_function_status tng_output_file_init(struct tng_trajectory* tng_data)
+static void tng_hash_init(struct tng_hash_state* hash_state, const int64_t type)
 {
-    if (!tng_data->output_file)
+    switch (type)
     {
-        if (!tng_data->output_file_path)
-        {
-            fprintf(stderr, "TNG library: No file specified for writing. %s: %d\n", __FILE__, __LINE__);
-            return (TNG_CRITICAL);
-        }
-
-        tng_data->output_file = fopen(tng_data->output_file_path, "wb+");
-
-        if (!tng_data->output_file)
-        {
-            fprintf(stderr, "TNG library: Cannot open file %s. %s: %d\n",
-                    tng_data->output_file_path, __FILE__, __LINE__);
-            return (TNG_CRITICAL);
-        }
+        case TNG_MD5:
+            md5_init(&hash_state->md5);
+            hash_state->type = TNG_MD5;
+            break;
+        case TNG_XXH64:
+            tng_xxh64_init(&hash_state->xxh64);
+            hash_state->type = TNG_XXH64;
+            break;
+        default: hash_state->type = TNG_NO_HASH;
     }
-    return (TNG_SUCCESS);
 }
 
 /**
- * @brief Setup a file block container.
- * @param block_p a pointer to memory to initialise as a file block container.
- * @details Memory is allocated during initialisation.
- * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
- * error has occured.
+ * @brief Append data to a hash.
+ * @param hash_state is the hash state.
+ * @param data is the data to append.
+ * @param len is the number of bytes to append.
  */
-static tng_function_status tng_block_init(struct tng_gen_block** block_p)
+static void tng_hash_append(struct tng_hash_state* hash_state, const void* data, const int64_t len)
 {
-    tng_gen_block_t block;
-
-    *block_p = (struct tng_gen_block*)malloc(sizeof(struct tng_gen_block));
-    if (!*block_p)
+    switch (hash_state->type)
     {
-        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
-        return (TNG_CRITICAL);
+        case TNG_MD5: md5_append(&hash_state->md5, (const md5_byte_t*)data, (int)len); break;
+        case TNG_XXH64: tng_xxh64_append(&hash_state->xxh64, data, len); break;
+        default: break;
     }
-
-    block = *block_p;
-
-    block->id = -1;
-    /* Reset the md5_hash */
-    memset(block->md5_hash, '\0', TNG_MD5_HASH_LEN);
-    block->name                 = 0;
-    block->block_version        = TNG_API_VERSION;
-    block->header_contents      = 0;
-    block->header_contents_size = 0;
-    block->block_contents       = 0;
-    block->block_contents_size  = 0;
-
-    return (TNG_SUCCESS);
 }
 
 /**
- * @brief Clean up a file block container.
- * @param block_p a pointer to the file block container to destroy.
- * @details All allocated memory in the data structure is freed, as well as
- * block_p itself.
- * @return TNG_SUCCESS (0) if successful.
+ * @brief Finish a hash.
+ * @param hash_state is the hash state.
+ * @param hash is where the hash is stored. It must fit TNG_MD5_HASH_LEN bytes
+ * for TNG_MD5 hashes and TNG_XXH64_HASH_LEN bytes for TNG_XXH64 hashes.
  */
-static tng_function_status tng_block_destroy(struct tng_gen_block** block_p)
+static void tng_hash_finish(struct tng_hash_state* hash_state, char* hash)
 {
-    tng_gen_block_t block = *block_p;
-
-    if (!*block_p)
+    switch (hash_state->type)
     {
-        return (TNG_SUCCESS);
+        case TNG_MD5: md5_finish(&hash_state->md5, (md5_byte_t*)hash); break;
+        case TNG_XXH64: tng_xxh64_finish(&hash_state->xxh64, hash); break;
+        default: break;
     }
+}
 
-    /*     fprintf(stderr, "TNG library: Destroying block\n"); */
-    if (block->name)
-    {
-        free(block->name);
-        block->name = 0;
-    }
-    if (block->header_contents)
+/**
+ * @brief Start generating the hash of the contents of a block.
+ * @param block is the block. If it has an alternative hash type that type
+ * of hash is generated, otherwise an MD5 hash is generated.
+ * @param hash_state is the hash state to initialise.
+ */
+static void tng_block_hash_init(const struct tng_gen_block* block,
+                                struct tng_hash_state*      hash_state)
+{
+    if (block->alt_hash_type != TNG_NO_HASH)
     {
-        free(block->header_contents);
-        block->header_contents = 0;
+        tng_hash_init(hash_state, block->alt_hash_type);
     }
-    if (block->block_contents)
+    else
     {
-        free(block->block_contents);
-        block->block_contents = 0;
+        tng_hash_init(hash_state, TNG_MD5);
     }
-
-    free(*block_p);
-    *block_p = 0;
-
-    return (TNG_SUCCESS);
 }
 
 /**
- * @brief Read the header of a data block, regardless of its type
- * @param tng_data is a trajectory data container.
- * @param block is a general block container.
- * @return TNG_SUCCESS (0) if successful, TNG_FAILURE(1) if a minor
- * error has occured (not able to read the header size, thus skipping
- * the block) or TNG_CRITICAL (2) if a major error has occured.
+ * @brief Finish the hash of the contents of a block and compare it to the hash
+ * stored in the block header.
+ * @param block is the block that has been read.
+ * @param hash_state is the hash of the block contents.
+ * @details Empty stored hashes and hash types that cannot be generated are
+ * always accepted.
+ * @return TNG_SUCCESS (0) if the hashes match or TNG_FAILURE (1) if they
+ * do not.
  */
-static tng_function_status tng_block_header_read(struct tng_trajectory* tng_data, struct tng_gen_block* block)
+static tng_function_status tng_block_hash_match_verify(const struct tng_gen_block* block,
+                                                       struct tng_hash_state*      hash_state)
 {
-    int64_t start_pos;
-
-    TNG_ASSERT(block != 0, "TNG library: Trying to read to uninitialized block (NULL pointer).");
-
-    if (tng_input_file_init(tng_data) != TNG_SUCCESS)
-    {
-        return (TNG_CRITICAL);
-    }
-
-    start_pos = ftello(tng_data->input_file);
+    char        hash[TNG_MD5_HASH_LEN];
+    const char* expected;
+    int64_t     len, i;
 
-    /* First read the header size to be able to read the whole header. */
-    if (fread(&block->header_contents_size, sizeof(block->header_contents_size), 1, tng_data->input_file) == 0)
+    if (hash_state->type == TNG_NO_HASH)
     {
-        fprintf(stderr, "TNG library: Cannot read header size. %s: %d\n", __FILE__, __LINE__);
-        return (TNG_CRITICAL);
+        return (TNG_SUCCESS);
     }
-
-    if (block->header_contents_size == 0)
+    if (hash_state->type == TNG_MD5)
     {
-        block->id = -1;
-        return (TNG_FAILURE);
+        expected = block->md5_hash;
+        len      = TNG_MD5_HASH_LEN;
     }
-
-    /* If this was the size of the general info block check the endianness */
-    if (ftello(tng_data->input_file) < 9)
+    else
     {
-        /* File is little endian */
-        if (*((const char*)&block->header_contents_size) != 0x00
-            && *((const char*)(&block->header_contents_size) + 7) == 0x00)
-        {
-            /* If the architecture endianness is little endian no byte swap
-             * will be needed. Otherwise use the functions to swap to little
-             * endian */
-            if (tng_data->endianness_32 == TNG_LITTLE_ENDIAN_32)
-            {
-                tng_data->input_endianness_swap_func_32 = 0;
-            }
-            else
-            {
-                tng_data->input_endianness_swap_func_32 = &tng_swap_byte_order_little_endian_32;
-            }
-            if (tng_data->endianness_64 == TNG_LITTLE_ENDIAN_64)
-            {
-                tng_data->input_endianness_swap_func_64 = 0;
-            }
-            else
-            {
-                tng_data->input_endianness_swap_func_64 = &tng_swap_byte_order_little_endian_64;
-            }
-        }
-        /* File is big endian */
-        else
+        expected = block->alt_hash;
+        len      = block->alt_hash_len;
+        if (len != TNG_XXH64_HASH_LEN)
         {
-            /* If the architecture endianness is big endian no byte swap
-             * will be needed. Otherwise use the functions to swap to big
-             * endian */
-            if (tng_data->endianness_32 == TNG_BIG_ENDIAN_32)
-            {
-                tng_data->input_endianness_swap_func_32 = 0;
-            }
-            else
-            {
-                tng_data->input_endianness_swap_func_32 = &tng_swap_byte_order_big_endian_32;
-            }
-            if (tng_data->endianness_64 == TNG_BIG_ENDIAN_64)
-            {
-                tng_data->input_endianness_swap_func_64 = 0;
-            }
-            else
-            {
-                tng_data->input_endianness_swap_func_64 = &tng_swap_byte_order_big_endian_64;
-            }
+            return (TNG_SUCCESS);
         }
     }
 
-    if (tng_data->input_endianness_swap_func_64
-        && tng_data->input_endianness_swap_func_64(tng_data, (uint64_t*)&block->header_contents_size)
-                   != TNG_SUCCESS)
+    for (i = 0; i < len && expected[i] == '\0'; i++) {}
+    if (i == len)
     {
-        fprintf(stderr, "TNG library: Cannot swap byte order. %s: %d\n", __FILE__, __LINE__);
+        return (TNG_SUCCESS);
     }
 
-    if (tng_file_input_numerical(tng_data, &block->block_contents_size,
-                                 sizeof(block->block_contents_size), TNG_SKIP_HASH, 0, __LINE__)
-        == TNG_CRITICAL)
+    tng_hash_finish(hash_state, hash);
+
+    return (memcmp(expected, hash, len) == 0 ? TNG_SUCCESS : TNG_FAILURE);
+}
+
+/**
+ * @brief Finish the hash of the contents of a block that has just been
+ * written and store it in the block header in the output file.
+ * @param tng_data is a trajectory data container.
+ * @param block is the block that has been written.
+ * @param header_file_pos is the file position where the block header starts.
+ * @param hash_state is the hash of the block contents.
+ * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
+ * error has occured.
+ */
+static tng_function_status tng_block_hash_write(const struct tng_trajectory* tng_data,
+                                                struct tng_gen_block*        block,
+                                                const int64_t                header_file_pos,
+                                                struct tng_hash_state*       hash_state)
+{
+    int64_t curr_file_pos, hash_pos, hash_len;
+    char*   hash;
+
+    if (hash_state->type == TNG_MD5)
     {
-        return (TNG_CRITICAL);
+        hash     = block->md5_hash;
+        hash_len = TNG_MD5_HASH_LEN;
+        hash_pos = header_file_pos + 3 * sizeof(int64_t);
     }
-
-    if (tng_file_input_numerical(tng_data, &block->id, sizeof(block->id), TNG_SKIP_HASH, 0, __LINE__)
-        == TNG_CRITICAL)
+    else if (hash_state->type != TNG_NO_HASH && block->alt_hash)
     {
-        return (TNG_CRITICAL);
+        hash     = block->alt_hash;
+        hash_len = block->alt_hash_len;
+        hash_pos = header_file_pos + block->header_contents_size - hash_len;
     }
-
-    if (fread(block->md5_hash, TNG_MD5_HASH_LEN, 1, tng_data->input_file) == 0)
+    else
     {
-        fprintf(stderr, "TNG library: Cannot read block header. %s: %d\n", __FILE__, __LINE__);
-        return (TNG_CRITICAL);
+        return (TNG_SUCCESS);
     }
 
-    tng_freadstr(tng_data, &block->name, TNG_SKIP_HASH, 0, __LINE__);
+    tng_hash_finish(hash_state, hash);
 
-    if (tng_file_input_numerical(tng_data, &block->block_version, sizeof(block->block_version),
-                                 TNG_SKIP_HASH, 0, __LINE__)
-        == TNG_CRITICAL)
+    curr_file_pos = ftello(tng_data->output_file);
+    fseeko(tng_data->output_file, hash_pos, SEEK_SET);
+    if (fwrite(hash, hash_len, 1, tng_data->output_file) != 1)
     {
+        fprintf(stderr, "TNG library: Could not write block hash. %s: %d\n", __FILE__, __LINE__);
         return (TNG_CRITICAL);
     }
-
-    fseeko(tng_data->input_file, start_pos + block->header_contents_size, SEEK_SET);
+    fseeko(tng_data->output_file, curr_file_pos, SEEK_SET);
 
     return (TNG_SUCCESS);
 }
 
 /**
- * @brief Write a whole block, both header and contents, regardless of it type
- * @param tng_data is a trajectory data container.
- * @param block is a general block container.
- * @return TNG_SUCCESS (0) if successful, TNG_FAILURE (1) if a minor error
- * has occurred or TNG_CRITICAL (2) if a major error has occured.
- */
-/* Disabled until it is used.*/
-/*
-// static tng_function_status tng_block_verbatim_write(tng_trajectory_t tng_data,
-//                                                     tng_gen_block_t block)
-// {
-//     if(!block->header_contents)
-//     {
-//         fprintf(stderr, "TNG library: No contents to write. %s: %d\n", __FILE__, __LINE__);
-//         return(TNG_FAILURE);
-//     }
-//     if(fwrite(block->header_contents, block->header_contents_size, 1,
-//                 tng_data->output_file) != 1)
-//     {
-//         fprintf(stderr, "TNG library: Could not write all header data. %s: %d\n",
-//                 __FILE__, __LINE__);
-//         return(TNG_CRITICAL);
-//     }
-//
-//     if(!block->block_contents)
-//     {
-//         fprintf(stderr, "TNG library: No block data to write. %s: %d\n",
-//                 __FILE__, __LINE__);
-//         return(TNG_FAILURE);
-//     }
-//     if(fwrite(block->block_contents, block->block_contents_size, 1,
-//                 tng_data->output_file) != 1)
-//     {
-//         fprintf(stderr, "TNG library: Could not write all block data. %s: %d\n",
-//                 __FILE__, __LINE__);
-//         return(TNG_CRITICAL);
-//     }
-//     return(TNG_SUCCESS);
-// }
-*/
-
-/**
- * @brief Update the md5 hash of a block already written to the file
- * @param tng_data is a trajectory data container.
- * @param block is the block, of which to update the md5 hash.
- * @param header_start_pos is the file position where the block header starts.
- * @param contents_start_pos is the file position where the block contents
- * start.
- * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
- * error has occured.
+ * @brief Read a NULL terminated string from a file.
+ * @param tng_data is a trajectory data container
+ * @param str is a pointer to the character string that will
+ * contain the read string. *str is reallocated in the function
+ * and must be NULL or pointing at already allocated memory.
+ * @param hash_mode is an option to decide whether to use the md5 hash or not.
+ * @param hash_state is a pointer to the current md5 storage, which will be
+ * appended with str if hash_mode == TNG_USE_HASH.
+ * @param line_nr is the line number where this function was called, to be
+ * able to give more useful error messages.
  */
-static tng_function_status tng_md5_hash_update(const struct tng_trajectory* tng_data,
-                                               struct tng_gen_block*        block,
-                                               const int64_t                header_start_pos,
-                                               const int64_t                contents_start_pos)
+static tng_function_status tng_freadstr(const struct tng_trajectory* tng_data,
+                                        char**                       str,
+                                        const char                   hash_mode,
+                                        struct tng_hash_state*       hash_state,
+                                        const int                    line_nr)
 {
-    if (block->block_contents)
+    char        temp[TNG_MAX_STR_LEN], *temp_alloc;
+    int         c, count = 0;
+    int64_t     max_len;
+    const char *view, *end;
+
+    if (tng_input_file_is_mapped(tng_data))
     {
-        free(block->block_contents);
+        /* Find the end of the string in the mapping instead of reading it byte by byte. */
+        max_len = tng_min_i64(tng_data->input_map->len - tng_data->input_map->pos, TNG_MAX_STR_LEN);
+        if (max_len <= 0)
+        {
+            return TNG_FAILURE;
+        }
+        if (tng_data->input_map->data)
+        {
+            view = tng_data->input_map->data + tng_data->input_map->pos;
+        }
+        else
+        {
+            max_len = tng_input_file_pread(tng_data->input_map, temp, max_len, tng_data->input_map->pos);
+            view    = temp;
+        }
+        end = (const char*)memchr(view, '\0', max_len);
+        if (end)
+        {
+            count = (int)(end - view) + 1;
+        }
+        else if (max_len == TNG_MAX_STR_LEN)
+        {
+            count = TNG_MAX_STR_LEN;
+        }
+        else
+        {
+            tng_data->input_map->pos += max_len;
+            return TNG_FAILURE;
+        }
+        if (view != temp)
+        {
+            memcpy(temp, view, count);
+        }
+        tng_data->input_map->pos += count;
     }
-
-    block->block_contents = (char*)malloc(block->block_contents_size);
-    if (!block->block_contents)
+    else
     {
-        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
-        return (TNG_CRITICAL);
+        do
+        {
+            c = fgetc(tng_data->input_file);
+
+            if (c == EOF)
+            {
+                /* Clear file error flag and return -1 if EOF is read.*/
+                clearerr(tng_data->input_file);
+                return TNG_FAILURE;
+            }
+            else
+            {
+                /* Cast c to char */
+                temp[count++] = (char)c;
+            }
+        } while ((temp[count - 1] != '\0') && (count < TNG_MAX_STR_LEN));
     }
 
-    fseeko(tng_data->output_file, contents_start_pos, SEEK_SET);
-    if (fread(block->block_contents, block->block_contents_size, 1, tng_data->output_file) == 0)
+    temp_alloc = (char*)realloc(*str, count);
+    if (!temp_alloc)
     {
-        fprintf(stderr, "TNG library: Cannot read block. %s: %d\n", __FILE__, __LINE__);
-        return (TNG_CRITICAL);
+        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, line_nr);
+        free(*str);
+        *str = 0;
+        return TNG_FAILURE;
     }
+    *str = temp_alloc;
 
-    tng_block_md5_hash_generate(block);
+    strncpy(*str, temp, count);
 
-    fseeko(tng_data->output_file, header_start_pos + 3 * sizeof(int64_t), SEEK_SET);
-    fwrite(block->md5_hash, TNG_MD5_HASH_LEN, 1, tng_data->output_file);
+    if (hash_mode == TNG_USE_HASH)
+    {
+        tng_hash_append(hash_state, *str, count);
+    }
 
-    return (TNG_SUCCESS);
+    return TNG_SUCCESS;
 }
 
 /**
- * @brief Update the frame set pointers in the file header (general info block),
- * already written to disk
- * @param tng_data is a trajectory data container.
- * @param hash_mode specifies whether to update the block md5 hash when
- * updating the pointers.
- * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
- * error has occured.
+ * @brief Write a NULL terminated string to a file.
+ * @param tng_data is a trajectory data container
+ * @param str is a pointer to the character string should be written.
+ * @param hash_mode is an option to decide whether to use the md5 hash or not.
+ * @param hash_state is a pointer to the current md5 storage, which will be
+ * appended with str if hash_mode == TNG_USE_HASH.
+ * @param line_nr is the line number where this function was called, to be
+ * able to give more useful error messages.
  */
-static tng_function_status tng_header_pointers_update(struct tng_trajectory* tng_data, const char hash_mode)
+static TNG_INLINE tng_function_status tng_fwritestr(tng_trajectory_t       tng_data,
+                                                    const char*            str,
+                                                    const char             hash_mode,
+                                                    struct tng_hash_state* hash_state,
+                                                    const int              line_nr)
 {
-    tng_gen_block_t block;
-    FILE*           temp = tng_data->input_file;
-    uint64_t        output_file_pos, pos, contents_start_pos;
+    size_t len;
 
-    if (tng_output_file_init(tng_data) != TNG_SUCCESS)
+    len = tng_min_size(strlen(str) + 1, TNG_MAX_STR_LEN);
+
+    if (fwrite(str, len, 1, tng_data->output_file) != 1)
     {
-        fprintf(stderr, "TNG library: Cannot initialise destination file. %s: %d\n", __FILE__, __LINE__);
+        fprintf(stderr, "TNG library: Could not write block data. %s: %d\n", __FILE__, line_nr);
         return (TNG_CRITICAL);
     }
 
-    tng_data->input_file = tng_data->output_file;
-
-    tng_block_init(&block);
-
-    output_file_pos = ftello(tng_data->output_file);
-    fseeko(tng_data->output_file, 0, SEEK_SET);
-
-    if (tng_block_header_read(tng_data, block) != TNG_SUCCESS)
+    if (hash_mode == TNG_USE_HASH)
     {
-        fprintf(stderr, "TNG library: Cannot read general info header. %s: %d\n", __FILE__, __LINE__);
-        tng_data->input_file = temp;
-        tng_block_destroy(&block);
-        return (TNG_CRITICAL);
+        tng_hash_append(hash_state, str, len);
     }
 
-    contents_start_pos = ftello(tng_data->output_file);
-
-    fseeko(tng_data->output_file, block->block_contents_size - 5 * sizeof(int64_t), SEEK_CUR);
-
-    tng_data->input_file = temp;
-
-    pos = tng_data->first_trajectory_frame_set_output_file_pos;
+    return (TNG_SUCCESS);
+}
 
-    if (tng_data->input_endianness_swap_func_64)
+/**
+ * @brief Read a numerical value from file.
+ * The byte order will be swapped if need be.
+ * @param tng_data is a trajectory data container
+ * @param dest is a pointer to where to store the read data.
+ * @param len is the length (in bytes) of the numerical data type. Should
+ * be 8 for 64 bit, 4 for 32 bit or 1 for a single byte flag.
+ * @param hash_mode is an option to decide whether to use the md5 hash or not.
+ * @param hash_state is a pointer to the current md5 storage, which will be
+ * appended with str if hash_mode == TNG_USE_HASH.
+ * @param line_nr is the line number where this function was called, to be
+ * able to give more useful error messages.
+ */
+static TNG_INLINE tng_function_status tng_file_input_numerical(const struct tng_trajectory* tng_data,
+                                                               void*                        dest,
+                                                               const size_t                 len,
+                                                               const char             hash_mode,
+                                                               struct tng_hash_state* hash_state,
+                                                               const int              line_nr)
+{
+    if (tng_input_file_read(tng_data, dest, len) == 0)
     {
-        if (tng_data->input_endianness_swap_func_64(tng_data, &pos) != TNG_SUCCESS)
-        {
-            fprintf(stderr, "TNG library: Cannot swap byte order. %s: %d\n", __FILE__, __LINE__);
-        }
+        fprintf(stderr, "TNG library: Cannot read block. %s: %d\n", __FILE__, line_nr);
+        return (TNG_CRITICAL);
     }
-
-    if (fwrite(&pos, sizeof(int64_t), 1, tng_data->output_file) != 1)
+    if (hash_mode == TNG_USE_HASH)
     {
-        tng_block_destroy(&block);
-        return (TNG_CRITICAL);
+        tng_hash_append(hash_state, dest, len);
+    }
+    switch (len)
+    {
+        case 8:
+            if (tng_data->input_endianness_swap_func_64
+                && tng_data->input_endianness_swap_func_64(tng_data, (uint64_t*)dest) != TNG_SUCCESS)
+            {
+                fprintf(stderr, "TNG library: Cannot swap byte order. %s: %d\n", __FILE__, line_nr);
+            }
+            break;
+        case 4:
+            if (tng_data->input_endianness_swap_func_32
+                && tng_data->input_endianness_swap_func_32(tng_data, (uint32_t*)dest) != TNG_SUCCESS)
+            {
+                fprintf(stderr, "TNG library: Cannot swap byte order. %s: %d\n", __FILE__, line_nr);
+            }
+            break;
+        default: break;
     }
 
-    pos = tng_data->last_trajectory_frame_set_output_file_pos;
+    return (TNG_SUCCESS);
+}
 
-    if (tng_data->input_endianness_swap_func_64)
+/**
+ * @brief Swap the byte order of consecutive 64 bit values read from file, if
+ * need be, in one pass.
+ * @param tng_data is a trajectory data container
+ * @param values is a pointer to the values.
+ * @param n is the number of values.
+ * @param line_nr is the line number where this function was called, to be
+ * able to give more useful error messages.
+ */
+static TNG_INLINE void tng_input_values_swap_64(const struct tng_trajectory* tng_data,
+                                                uint64_t*                    values,
+                                                const int64_t                n,
+                                                const int                    line_nr)
+{
+    int64_t i;
+
+    if (!tng_data->input_endianness_swap_func_64)
     {
-        if (tng_data->input_endianness_swap_func_64(tng_data, &pos) != TNG_SUCCESS)
+        return;
+    }
+    for (i = 0; i < n; i++)
+    {
+        if (tng_data->input_endianness_swap_func_64(tng_data, values + i) != TNG_SUCCESS)
         {
-            fprintf(stderr, "TNG library: Cannot swap byte order. %s: %d\n", __FILE__, __LINE__);
+            fprintf(stderr, "TNG library: Cannot swap byte order. %s: %d\n", __FILE__, line_nr);
         }
     }
+}
 
-    if (fwrite(&pos, sizeof(int64_t), 1, tng_data->output_file) != 1)
+/**
+ * @brief Read a number of bytes from file with one read, e.g. several
+ * fields of a block, which are then decoded from memory.
+ * @param tng_data is a trajectory data container
+ * @param dest is a pointer to where to store the read data.
+ * @param len is the number of bytes to read.
+ * @param hash_mode is an option to decide whether to use the md5 hash or not.
+ * @param hash_state is a pointer to the current md5 storage, which will be
+ * appended with the read data if hash_mode == TNG_USE_HASH.
+ * @param line_nr is the line number where this function was called, to be
+ * able to give more useful error messages.
+ */
+static TNG_INLINE tng_function_status tng_file_input_buffer(const struct tng_trajectory* tng_data,
+                                                            void*                        dest,
+                                                            const size_t                 len,
+                                                            const char                   hash_mode,
+                                                            struct tng_hash_state*       hash_state,
+                                                            const int                    line_nr)
+{
+    if (len == 0)
     {
-        tng_block_destroy(&block);
+        return (TNG_SUCCESS);
+    }
+    if (tng_input_file_read(tng_data, dest, len) == 0)
+    {
+        fprintf(stderr, "TNG library: Cannot read block. %s: %d\n", __FILE__, line_nr);
         return (TNG_CRITICAL);
     }
-
     if (hash_mode == TNG_USE_HASH)
     {
-        tng_md5_hash_update(tng_data, block, 0, contents_start_pos);
+        tng_hash_append(hash_state, dest, len);
     }
 
-    tng_block_destroy(&block);
-
-    fseeko(tng_data->output_file, output_file_pos, SEEK_SET);
-
     return (TNG_SUCCESS);
 }
 
 /**
- * @brief Update the frame set pointers in the current frame set block, already
- * written to disk. It also updates the pointers of the blocks pointing to
- * the current frame set block.
- * @param tng_data is a trajectory data container.
- * @param hash_mode specifies whether to update the block md5 hash when
- * updating the pointers.
- * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
- * error has occured.
+ * @brief Read consecutive 64 bit numerical values from file with one read.
+ * The byte order will be swapped if need be.
+ * @param tng_data is a trajectory data container
+ * @param dest is a pointer to where to store the values.
+ * @param n is the number of values.
+ * @param hash_mode is an option to decide whether to use the md5 hash or not.
+ * @param hash_state is a pointer to the current md5 storage, which will be
+ * appended with the read data if hash_mode == TNG_USE_HASH.
+ * @param line_nr is the line number where this function was called, to be
+ * able to give more useful error messages.
  */
-static tng_function_status tng_frame_set_pointers_update(struct tng_trajectory* tng_data, const char hash_mode)
+static TNG_INLINE tng_function_status tng_file_input_numerical_64_n(const struct tng_trajectory* tng_data,
+                                                                    void*                        dest,
+                                                                    const int64_t                n,
+                                                                    const char             hash_mode,
+                                                                    struct tng_hash_state* hash_state,
+                                                                    const int              line_nr)
 {
-    tng_gen_block_t            block;
-    tng_trajectory_frame_set_t frame_set;
-    FILE*                      temp = tng_data->input_file;
-    uint64_t                   pos, output_file_pos, contents_start_pos;
-
-    if (tng_output_file_init(tng_data) != TNG_SUCCESS)
+    if (tng_file_input_buffer(tng_data, dest, sizeof(uint64_t) * n, hash_mode, hash_state, line_nr)
+        != TNG_SUCCESS)
     {
-        fprintf(stderr, "TNG library: Cannot initialise destination file. %s: %d\n", __FILE__, __LINE__);
         return (TNG_CRITICAL);
     }
+    tng_input_values_swap_64(tng_data, (uint64_t*)dest, n, line_nr);
 
-    tng_block_init(&block);
-    output_file_pos = ftello(tng_data->output_file);
+    return (TNG_SUCCESS);
+}
 
-    tng_data->input_file = tng_data->output_file;
+/**
+ * @brief Write a numerical value to file.
+ * The byte order will be swapped if need be.
+ * @param tng_data is a trajectory data container
+ * @param src is a pointer to the data to write.
+ * @param len is the length (in bytes) of the numerical data type. Should
+ * be 8 for 64 bit, 4 for 32 bit or 1 for a single byte flag.
+ * @param hash_mode is an option to decide whether to use the md5 hash or not.
+ * @param hash_state is a pointer to the current md5 storage, which will be
+ * appended with str if hash_mode == TNG_USE_HASH.
+ * @param line_nr is the line number where this function was called, to be
+ * able to give more useful error messages.
+ */
+static TNG_INLINE tng_function_status tng_file_output_numerical(const struct tng_trajectory* tng_data,
+                                                                const void*                  src,
+                                                                const size_t                 len,
+                                                                const char             hash_mode,
+                                                                struct tng_hash_state* hash_state,
+                                                                const int              line_nr)
+{
+    uint32_t temp_i32;
+    uint64_t temp_i64;
 
-    frame_set = &tng_data->current_trajectory_frame_set;
+    switch (len)
+    {
+        case 8:
+            temp_i64 = *((uint64_t*)src);
+            if (tng_data->output_endianness_swap_func_64
+                && tng_data->output_endianness_swap_func_64(tng_data, &temp_i64) != TNG_SUCCESS)
+            {
+                fprintf(stderr, "TNG library: Cannot swap byte order. %s: %d\n", __FILE__, line_nr);
+            }
+            if (fwrite(&temp_i64, len, 1, tng_data->output_file) != 1)
+            {
+                fprintf(stderr, "TNG library: Could not write data. %s: %d\n", __FILE__, line_nr);
+                return (TNG_CRITICAL);
+            }
+            if (hash_mode == TNG_USE_HASH)
+            {
+                tng_hash_append(hash_state, &temp_i64, len);
+            }
+            break;
+        case 4:
+            temp_i32 = *((uint32_t*)src);
+            if (tng_data->output_endianness_swap_func_32
+                && tng_data->output_endianness_swap_func_32(tng_data, &temp_i32) != TNG_SUCCESS)
+            {
+                fprintf(stderr, "TNG library: Cannot swap byte order. %s: %d\n", __FILE__, line_nr);
+            }
+            if (fwrite(&temp_i32, len, 1, tng_data->output_file) != 1)
+            {
+                fprintf(stderr, "TNG library: Could not write data. %s: %d\n", __FILE__, line_nr);
+                return (TNG_CRITICAL);
+            }
+            if (hash_mode == TNG_USE_HASH)
+            {
+                tng_hash_append(hash_state, &temp_i32, len);
+            }
+            break;
+        default:
+            if (fwrite(src, len, 1, tng_data->output_file) != 1)
+            {
+                fprintf(stderr, "TNG library: Could not write data. %s: %d\n", __FILE__, line_nr);
+                return (TNG_CRITICAL);
+            }
+            if (hash_mode == TNG_USE_HASH)
+            {
+                tng_hash_append(hash_state, src, len);
+            }
+            break;
+    }
 
-    pos = tng_data->current_trajectory_frame_set_output_file_pos;
+    return (TNG_SUCCESS);
+}
 
-    /* Update next frame set */
-    if (frame_set->next_frame_set_file_pos > 0)
-    {
-        fseeko(tng_data->output_file, frame_set->next_frame_set_file_pos, SEEK_SET);
+/**
+ * @brief Generate the hash of a block.
+ * The hash is created based on the actual block contents. The type of the hash
+ * is the alternative hash type of the block, if set, otherwise MD5.
+ * @param block is a general block container.
+ * @return TNG_SUCCESS (0) if successful.
+ */
+static tng_function_status tng_block_hash_generate(struct tng_gen_block* block)
+{
+    struct tng_hash_state hash_state;
 
-        if (tng_block_header_read(tng_data, block) != TNG_SUCCESS)
-        {
-            fprintf(stderr, "TNG library: Cannot read frame header. %s: %d\n", __FILE__, __LINE__);
-            tng_data->input_file = temp;
-            tng_block_destroy(&block);
-            return (TNG_CRITICAL);
-        }
+    tng_block_hash_init(block, &hash_state);
+    tng_hash_append(&hash_state, block->block_contents, block->block_contents_size);
+    if (hash_state.type == TNG_MD5)
+    {
+        tng_hash_finish(&hash_state, block->md5_hash);
+    }
+    else if (block->alt_hash)
+    {
+        tng_hash_finish(&hash_state, block->alt_hash);
+    }
 
-        contents_start_pos = ftello(tng_data->output_file);
+    return (TNG_SUCCESS);
+}
 
-        fseeko(tng_data->output_file,
-               block->block_contents_size - (5 * sizeof(int64_t) + 2 * sizeof(double)), SEEK_CUR);
+/**
+ * @brief If there is data left in the block read that to append that to the MD5 hash.
+ * @param tng_data is a trajectory data container.
+ * @param block is the data block that is being read.
+ * @param start_pos is the file position where the block started.
+ * @param hash_state is the md5 to which the md5 of the remaining block
+ * will be appended.
+ * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
+ * error has occured.
+ */
+static tng_function_status tng_hash_remaining_append(const struct tng_trajectory* tng_data,
+                                                     const struct tng_gen_block*  block,
+                                                     const int64_t                start_pos,
+                                                     struct tng_hash_state*       hash_state)
+{
+    int64_t     curr_file_pos;
+    char*       temp_data;
+    const char* view;
 
-        if (tng_data->input_endianness_swap_func_64)
+    curr_file_pos = tng_input_file_tell(tng_data);
+    if (curr_file_pos < start_pos + block->block_contents_size)
+    {
+        view = tng_input_file_view(tng_data, start_pos + block->block_contents_size - curr_file_pos);
+        if (view)
         {
-            if (tng_data->input_endianness_swap_func_64(tng_data, &pos) != TNG_SUCCESS)
-            {
-                fprintf(stderr, "TNG library: Cannot swap byte order. %s: %d\n", __FILE__, __LINE__);
-            }
+            tng_hash_append(hash_state, view, start_pos + block->block_contents_size - curr_file_pos);
+            return (TNG_SUCCESS);
         }
-
-        if (fwrite(&pos, sizeof(int64_t), 1, tng_data->output_file) != 1)
+        temp_data = (char*)malloc(start_pos + block->block_contents_size - curr_file_pos);
+        if (!temp_data)
         {
-            tng_data->input_file = temp;
-            tng_block_destroy(&block);
+            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
             return (TNG_CRITICAL);
         }
-
-        if (hash_mode == TNG_USE_HASH)
-        {
-            tng_md5_hash_update(tng_data, block, frame_set->next_frame_set_file_pos, contents_start_pos);
-        }
-    }
-    /* Update previous frame set */
-    if (frame_set->prev_frame_set_file_pos > 0)
-    {
-        fseeko(tng_data->output_file, frame_set->prev_frame_set_file_pos, SEEK_SET);
-
-        if (tng_block_header_read(tng_data, block) != TNG_SUCCESS)
+        if (tng_input_file_read(tng_data, temp_data, start_pos + block->block_contents_size - curr_file_pos)
+            == 0)
         {
-            fprintf(stderr, "TNG library: Cannot read frame header. %s: %d\n", __FILE__, __LINE__);
-            tng_data->input_file = temp;
-            tng_block_destroy(&block);
+            fprintf(stderr,
+                    "TNG library: Cannot read remaining part of block to generate MD5 sum. %s: "
+                    "%d\n",
+                    __FILE__, __LINE__);
+            free(temp_data);
             return (TNG_CRITICAL);
         }
+        tng_hash_append(hash_state, temp_data, start_pos + block->block_contents_size - curr_file_pos);
+        free(temp_data);
+    }
 
-        contents_start_pos = ftello(tng_data->output_file);
-
-        fseeko(tng_data->output_file,
-               block->block_contents_size - (6 * sizeof(int64_t) + 2 * sizeof(double)), SEEK_CUR);
+    return (TNG_SUCCESS);
+}
 
-        if (tng_data->input_endianness_swap_func_64)
-        {
-            if (tng_data->input_endianness_swap_func_64(tng_data, &pos) != TNG_SUCCESS)
-            {
-                fprintf(stderr, "TNG library: Cannot swap byte order. %s: %d\n", __FILE__, __LINE__);
-            }
-        }
-
-        if (fwrite(&pos, sizeof(int64_t), 1, tng_data->output_file) != 1)
-        {
-            tng_data->input_file = temp;
-            tng_block_destroy(&block);
-            return (TNG_CRITICAL);
-        }
-
-        if (hash_mode == TNG_USE_HASH)
-        {
-            tng_md5_hash_update(tng_data, block, frame_set->prev_frame_set_file_pos, contents_start_pos);
-        }
-    }
-
-    /* Update the frame set one medium stride step after */
-    if (frame_set->medium_stride_next_frame_set_file_pos > 0)
-    {
-        fseeko(tng_data->output_file, frame_set->medium_stride_next_frame_set_file_pos, SEEK_SET);
-
-        if (tng_block_header_read(tng_data, block) != TNG_SUCCESS)
-        {
-            fprintf(stderr, "TNG library: Cannot read frame set header. %s: %d\n", __FILE__, __LINE__);
-            tng_data->input_file = temp;
-            tng_block_destroy(&block);
-            return (TNG_CRITICAL);
-        }
-
-        contents_start_pos = ftello(tng_data->output_file);
-
-        fseeko(tng_data->output_file,
-               block->block_contents_size - (3 * sizeof(int64_t) + 2 * sizeof(double)), SEEK_CUR);
-
-        if (tng_data->input_endianness_swap_func_64)
-        {
-            if (tng_data->input_endianness_swap_func_64(tng_data, &pos) != TNG_SUCCESS)
-            {
-                fprintf(stderr, "TNG library: Cannot swap byte order. %s: %d\n", __FILE__, __LINE__);
-            }
-        }
-
-        if (fwrite(&pos, sizeof(int64_t), 1, tng_data->output_file) != 1)
-        {
-            tng_data->input_file = temp;
-            tng_block_destroy(&block);
-            return (TNG_CRITICAL);
-        }
+/**
+ * @brief Open the input file if it is not already opened.
+ * @param tng_data is a trajectory data container.
+ * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
+ * error has occured.
+ */
+static tng_function_status tng_input_file_init(struct tng_trajectory* tng_data)
+{
+    int64_t file_pos;
 
-        if (hash_mode == TNG_USE_HASH)
-        {
-            tng_md5_hash_update(tng_data, block, frame_set->medium_stride_next_frame_set_file_pos,
-                                contents_start_pos);
-        }
-    }
-    /* Update the frame set one medium stride step before */
-    if (frame_set->medium_stride_prev_frame_set_file_pos > 0)
+    if (!tng_data->input_file)
     {
-        fseeko(tng_data->output_file, frame_set->medium_stride_prev_frame_set_file_pos, SEEK_SET);
-
-        if (tng_block_header_read(tng_data, block) != TNG_SUCCESS)
+        if (!tng_data->input_file_path)
         {
-            fprintf(stderr, "TNG library: Cannot read frame set header. %s: %d\n", __FILE__, __LINE__);
-            tng_data->input_file = temp;
-            tng_block_destroy(&block);
+            fprintf(stderr, "TNG library: No file specified for reading. %s: %d\n", __FILE__, __LINE__);
             return (TNG_CRITICAL);
         }
-
-        contents_start_pos = ftello(tng_data->output_file);
-
-        fseeko(tng_data->output_file,
-               block->block_contents_size - (4 * sizeof(int64_t) + 2 * sizeof(double)), SEEK_CUR);
-
-        if (tng_data->input_endianness_swap_func_64)
-        {
-            if (tng_data->input_endianness_swap_func_64(tng_data, &pos) != TNG_SUCCESS)
-            {
-                fprintf(stderr, "TNG library: Cannot swap byte order. %s: %d\n", __FILE__, __LINE__);
-            }
-        }
-
-        if (fwrite(&pos, sizeof(int64_t), 1, tng_data->output_file) != 1)
+        tng_data->input_file = fopen(tng_data->input_file_path, "rb");
+        if (!tng_data->input_file)
         {
-            tng_data->input_file = temp;
-            tng_block_destroy(&block);
+            fprintf(stderr, "TNG library: Cannot open file %s. %s: %d\n", tng_data->input_file_path,
+                    __FILE__, __LINE__);
             return (TNG_CRITICAL);
         }
-
-        if (hash_mode == TNG_USE_HASH)
+        if (tng_data->input_file_map_flag)
         {
-            tng_md5_hash_update(tng_data, block, frame_set->medium_stride_prev_frame_set_file_pos,
-                                contents_start_pos);
+            tng_input_map_create(tng_data);
         }
     }
 
-    /* Update the frame set one long stride step after */
-    if (frame_set->long_stride_next_frame_set_file_pos > 0)
+    if (!tng_data->input_file_len)
     {
-        fseeko(tng_data->output_file, frame_set->long_stride_next_frame_set_file_pos, SEEK_SET);
-
-        if (tng_block_header_read(tng_data, block) != TNG_SUCCESS)
-        {
-            fprintf(stderr, "TNG library: Cannot read frame set header. %s: %d\n", __FILE__, __LINE__);
-            tng_data->input_file = temp;
-            tng_block_destroy(&block);
-            return (TNG_CRITICAL);
-        }
-
-        contents_start_pos = ftello(tng_data->output_file);
-
-        fseeko(tng_data->output_file,
-               block->block_contents_size - (1 * sizeof(int64_t) + 2 * sizeof(double)), SEEK_CUR);
-
-        if (tng_data->input_endianness_swap_func_64)
-        {
-            if (tng_data->input_endianness_swap_func_64(tng_data, &pos) != TNG_SUCCESS)
-            {
-                fprintf(stderr, "TNG library: Cannot swap byte order. %s: %d\n", __FILE__, __LINE__);
-            }
-        }
+        file_pos = tng_input_file_tell(tng_data);
+        tng_input_file_seek(tng_data, 0, SEEK_END);
+        tng_data->input_file_len = tng_input_file_tell(tng_data);
+        tng_input_file_seek(tng_data, file_pos, SEEK_SET);
+    }
 
-        if (fwrite(&pos, sizeof(int64_t), 1, tng_data->output_file) != 1)
-        {
-            tng_data->input_file = temp;
-            tng_block_destroy(&block);
-            return (TNG_CRITICAL);
-        }
+    return (TNG_SUCCESS);
+}
 
-        if (hash_mode == TNG_USE_HASH)
-        {
-            tng_md5_hash_update(tng_data, block, frame_set->long_stride_next_frame_set_file_pos,
-                                contents_start_pos);
-        }
-    }
-    /* Update the frame set one long stride step before */
-    if (frame_set->long_stride_prev_frame_set_file_pos > 0)
+/**
+ * @brief Open the output file if it is not already opened
+ * @param tng_data is a trajectory data container.
+ * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
+ * error has occured.
+ */
+static tng_function_status tng_output_file_init(struct tng_trajectory* tng_data)
+{
+    if (!tng_data->output_file)
     {
-        fseeko(tng_data->output_file, frame_set->long_stride_prev_frame_set_file_pos, SEEK_SET);
-
-        if (tng_block_header_read(tng_data, block) != TNG_SUCCESS)
+        if (!tng_data->output_file_path)
         {
-            fprintf(stderr, "TNG library: Cannot read frame set header. %s: %d\n", __FILE__, __LINE__);
-            tng_data->input_file = temp;
-            tng_block_destroy(&block);
+            fprintf(stderr, "TNG library: No file specified for writing. %s: %d\n", __FILE__, __LINE__);
             return (TNG_CRITICAL);
         }
 
-        contents_start_pos = ftello(tng_data->output_file);
-
-        fseeko(tng_data->output_file,
-               block->block_contents_size - (2 * sizeof(int64_t) + 2 * sizeof(double)), SEEK_CUR);
-
-        if (tng_data->input_endianness_swap_func_64)
-        {
-            if (tng_data->input_endianness_swap_func_64(tng_data, &pos) != TNG_SUCCESS)
-            {
-                fprintf(stderr, "TNG library: Cannot swap byte order. %s: %d\n", __FILE__, __LINE__);
-            }
-        }
+        tng_data->output_file = fopen(tng_data->output_file_path, "wb+");
 
-        if (fwrite(&pos, sizeof(int64_t), 1, tng_data->output_file) != 1)
+        if (!tng_data->output_file)
         {
-            tng_data->input_file = temp;
-            tng_block_destroy(&block);
+            fprintf(stderr, "TNG library: Cannot open file %s. %s: %d\n",
+                    tng_data->output_file_path, __FILE__, __LINE__);
             return (TNG_CRITICAL);
         }
-
-        if (hash_mode == TNG_USE_HASH)
-        {
-            tng_md5_hash_update(tng_data, block, frame_set->long_stride_prev_frame_set_file_pos,
-                                contents_start_pos);
-        }
     }
-
-    fseeko(tng_data->output_file, output_file_pos, SEEK_SET);
-
-    tng_data->input_file = temp;
-
-    tng_block_destroy(&block);
-
     return (TNG_SUCCESS);
 }
 
-static tng_function_status tng_reread_frame_set_at_file_pos(struct tng_trajectory* tng_data, const int64_t pos)
+/**
+ * @brief Setup a file block container.
+ * @param block_p a pointer to memory to initialise as a file block container.
+ * @details Memory is allocated during initialisation.
+ * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
+ * error has occured.
+ */
+static tng_function_status tng_block_init(struct tng_gen_block** block_p)
 {
-    tng_gen_block_t     block;
-    tng_function_status stat;
-
-    tng_block_init(&block);
+    tng_gen_block_t block;
 
-    fseeko(tng_data->input_file, pos, SEEK_SET);
-    if (pos > 0)
+    *block_p = (struct tng_gen_block*)malloc(sizeof(struct tng_gen_block));
+    if (!*block_p)
     {
-        stat = tng_block_header_read(tng_data, block);
-        if (stat == TNG_CRITICAL || block->id != TNG_TRAJECTORY_FRAME_SET)
-        {
-            fprintf(stderr, "TNG library: Cannot read block header at pos %" PRId64 ". %s: %d\n",
-                    pos, __FILE__, __LINE__);
-            tng_block_destroy(&block);
-            return (TNG_FAILURE);
-        }
-
-        if (tng_block_read_next(tng_data, block, TNG_SKIP_HASH) != TNG_SUCCESS)
-        {
-            tng_block_destroy(&block);
-            return (TNG_CRITICAL);
-        }
+        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+        return (TNG_CRITICAL);
     }
 
-    tng_block_destroy(&block);
+    block = *block_p;
+
+    block->id = -1;
+    /* Reset the md5_hash */
+    memset(block->md5_hash, '\0', TNG_MD5_HASH_LEN);
+    block->name                 = 0;
+    block->block_version        = TNG_API_VERSION;
+    block->header_contents      = 0;
+    block->header_contents_size = 0;
+    block->block_contents       = 0;
+    block->block_contents_size  = 0;
+    block->alt_hash_type        = TNG_NO_HASH;
+    block->alt_hash_len         = 0;
+    block->alt_hash             = 0;
 
     return (TNG_SUCCESS);
 }
 
-static tng_function_status tng_file_pos_of_subsequent_trajectory_block_get(struct tng_trajectory* tng_data,
-                                                                           int64_t* pos)
+/**
+ * @brief Clean up a file block container.
+ * @param block_p a pointer to the file block container to destroy.
+ * @details All allocated memory in the data structure is freed, as well as
+ * block_p itself.
+ * @return TNG_SUCCESS (0) if successful.
+ */
+static tng_function_status tng_block_destroy(struct tng_gen_block** block_p)
 {
-    int64_t                    orig_pos, curr_frame_set_pos;
-    tng_gen_block_t            block;
-    tng_function_status        stat;
-    tng_trajectory_frame_set_t frame_set = &tng_data->current_trajectory_frame_set;
-
-    orig_pos           = ftello(tng_data->input_file);
-    curr_frame_set_pos = tng_data->current_trajectory_frame_set_input_file_pos;
-
-    *pos = tng_data->first_trajectory_frame_set_input_file_pos;
+    tng_gen_block_t block = *block_p;
 
-    if (*pos <= 0)
+    if (!*block_p)
     {
         return (TNG_SUCCESS);
     }
 
-    fseeko(tng_data->input_file, *pos, SEEK_SET);
-
-    tng_block_init(&block);
-    /* Read block headers first to see that a frame set block is found. */
-    stat = tng_block_header_read(tng_data, block);
-    if (stat == TNG_CRITICAL || block->id != TNG_TRAJECTORY_FRAME_SET)
-    {
-        fprintf(stderr, "TNG library: Cannot read block header at pos %" PRId64 ". %s: %d\n", *pos,
-                __FILE__, __LINE__);
-        tng_block_destroy(&block);
-        return (TNG_FAILURE);
+    /*     fprintf(stderr, "TNG library: Destroying block\n"); */
+    if (block->name)
+    {
+        free(block->name);
+        block->name = 0;
     }
-
-    if (tng_block_read_next(tng_data, block, TNG_SKIP_HASH) != TNG_SUCCESS)
+    if (block->header_contents)
     {
-        tng_block_destroy(&block);
-        return (TNG_CRITICAL);
+        free(block->header_contents);
+        block->header_contents = 0;
     }
-
-    /* Read all frame set blocks (not the blocks between them) */
-    while (frame_set->next_frame_set_file_pos > 0)
+    if (block->block_contents)
     {
-        fseeko(tng_data->input_file, frame_set->next_frame_set_file_pos, SEEK_SET);
-        stat = tng_block_header_read(tng_data, block);
-        if (stat == TNG_CRITICAL)
-        {
-            fprintf(stderr, "TNG library: Cannot read block header at pos %" PRId64 ". %s: %d\n",
-                    *pos, __FILE__, __LINE__);
-            tng_block_destroy(&block);
-            return (TNG_CRITICAL);
-        }
-        if (stat != TNG_SUCCESS || block->id != TNG_TRAJECTORY_FRAME_SET)
-        {
-            return (TNG_FAILURE);
-        }
-
-        stat = tng_block_read_next(tng_data, block, TNG_SKIP_HASH);
-        if (stat != TNG_SUCCESS)
-        {
-            tng_block_destroy(&block);
-            return (stat);
-        }
-        /* Update *pos if this is the earliest frame set so far (after orig_pos) */
-        if (tng_data->current_trajectory_frame_set_input_file_pos < *pos
-            && tng_data->current_trajectory_frame_set_input_file_pos > orig_pos)
-        {
-            *pos = tng_data->current_trajectory_frame_set_input_file_pos;
-        }
+        free(block->block_contents);
+        block->block_contents = 0;
+    }
+    if (block->alt_hash)
+    {
+        free(block->alt_hash);
+        block->alt_hash = 0;
     }
 
-    /* Re-read the frame set that used to be the current one */
-    tng_reread_frame_set_at_file_pos(tng_data, curr_frame_set_pos);
-
-    fseeko(tng_data->input_file, orig_pos, SEEK_SET);
-
-    tng_block_destroy(&block);
+    free(*block_p);
+    *block_p = 0;
 
     return (TNG_SUCCESS);
 }
 
 /**
- * @brief Migrate a whole frame set from one position in the file to another.
+ * @brief Read the header of a data block, regardless of its type
  * @param tng_data is a trajectory data container.
- * @param block_start_pos is the starting position in the file of the frame set.
- * @param block_len is the length of the whole frame set (including all data blocks etc).
- * @param new_pos is the new position in the file of the frame set.
- * @param hash_mode is an option to decide whether to generate/update the relevant md5 hashes.
+ * @param block is a general block container.
+ * @return TNG_SUCCESS (0) if successful, TNG_FAILURE(1) if a minor
+ * error has occured (not able to read the header size, thus skipping
+ * the block) or TNG_CRITICAL (2) if a major error has occured.
  */
-static tng_function_status tng_frame_set_complete_migrate(struct tng_trajectory* tng_data,
-                                                          const int64_t          block_start_pos,
-                                                          const int64_t          block_len,
-                                                          const int64_t          new_pos,
-                                                          const char             hash_mode)
+static tng_function_status tng_block_header_read(struct tng_trajectory* tng_data, struct tng_gen_block* block)
 {
-    tng_bool updated = TNG_FALSE;
+    /* The block contents size, ID, MD5 hash, name, block version and
+     * alternative hash */
+    char          buffer[sizeof(int64_t) * 5 + TNG_MD5_HASH_LEN * 2 + TNG_MAX_STR_LEN];
+    const int64_t min_len = sizeof(int64_t) * 3 + TNG_MD5_HASH_LEN + 1;
+    int64_t       start_pos, len, pos, name_len, max_name_len;
+    uint64_t      values[2];
+    const char*   name_end;
+    char *        temp_name, *temp_hash;
 
-    char* contents;
+    TNG_ASSERT(block != 0, "TNG library: Trying to read to uninitialized block (NULL pointer).");
 
     if (tng_input_file_init(tng_data) != TNG_SUCCESS)
     {
         return (TNG_CRITICAL);
     }
 
-    fseeko(tng_data->input_file, block_start_pos, SEEK_SET);
-
-    contents = (char*)malloc(block_len);
-    if (!contents)
-    {
-        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
-        return (TNG_CRITICAL);
-    }
+    start_pos = tng_input_file_tell(tng_data);
 
-    if (fread(contents, block_len, 1, tng_data->input_file) == 0)
+    /* First read the header size to be able to read the whole header. */
+    if (tng_input_file_read(tng_data, &block->header_contents_size, sizeof(block->header_contents_size)) == 0)
     {
-        fprintf(stderr, "TNG library: Cannot read data from file when migrating data. %s: %d\n",
-                __FILE__, __LINE__);
-        free(contents);
+        fprintf(stderr, "TNG library: Cannot read header size. %s: %d\n", __FILE__, __LINE__);
         return (TNG_CRITICAL);
     }
-    fseeko(tng_data->output_file, new_pos, SEEK_SET);
 
-    if (fwrite(contents, block_len, 1, tng_data->output_file) != 1)
+    if (block->header_contents_size == 0)
     {
-        fprintf(stderr, "TNG library: Could not write data to file when migrating data. %s: %d\n",
-                __FILE__, __LINE__);
-        free(contents);
-        return (TNG_CRITICAL);
+        block->id = -1;
+        return (TNG_FAILURE);
     }
 
-    tng_data->current_trajectory_frame_set_output_file_pos = new_pos;
-    if (tng_data->input_file == tng_data->output_file)
+    /* If this was the size of the general info block check the endianness */
+    if (tng_input_file_tell(tng_data) < 9)
     {
-        tng_data->current_trajectory_frame_set_input_file_pos = new_pos;
+        /* File is little endian */
+        if (*((const char*)&block->header_contents_size) != 0x00
+            && *((const char*)(&block->header_contents_size) + 7) == 0x00)
+        {
+            /* If the architecture endianness is little endian no byte swap
+             * will be needed. Otherwise use the functions to swap to little
+             * endian */
+            if (tng_data->endianness_32 == TNG_LITTLE_ENDIAN_32)
+            {
+                tng_data->input_endianness_swap_func_32 = 0;
+            }
+            else
+            {
+                tng_data->input_endianness_swap_func_32 = &tng_swap_byte_order_little_endian_32;
+            }
+            if (tng_data->endianness_64 == TNG_LITTLE_ENDIAN_64)
+            {
+                tng_data->input_endianness_swap_func_64 = 0;
+            }
+            else
+            {
+                tng_data->input_endianness_swap_func_64 = &tng_swap_byte_order_little_endian_64;
+            }
+        }
+        /* File is big endian */
+        else
+        {
+            /* If the architecture endianness is big endian no byte swap
+             * will be needed. Otherwise use the functions to swap to big
+             * endian */
+            if (tng_data->endianness_32 == TNG_BIG_ENDIAN_32)
+            {
+                tng_data->input_endianness_swap_func_32 = 0;
+            }
+            else
+            {
+                tng_data->input_endianness_swap_func_32 = &tng_swap_byte_order_big_endian_32;
+            }
+            if (tng_data->endianness_64 == TNG_BIG_ENDIAN_64)
+            {
+                tng_data->input_endianness_swap_func_64 = 0;
+            }
+            else
+            {
+                tng_data->input_endianness_swap_func_64 = &tng_swap_byte_order_big_endian_64;
+            }
+        }
     }
 
-    tng_frame_set_pointers_update(tng_data, hash_mode);
+    tng_input_values_swap_64(tng_data, (uint64_t*)&block->header_contents_size, 1, __LINE__);
 
-    /* Update the general info block if needed */
-    if (block_start_pos == tng_data->first_trajectory_frame_set_output_file_pos)
-    {
-        tng_data->first_trajectory_frame_set_output_file_pos = new_pos;
-        updated                                              = TNG_TRUE;
-    }
-    if (block_start_pos == tng_data->last_trajectory_frame_set_output_file_pos)
-    {
-        tng_data->last_trajectory_frame_set_output_file_pos = new_pos;
-        updated                                             = TNG_TRUE;
-    }
-    if (updated)
+    /* Read the rest of the header at once and decode it from memory. Fields
+     * added after the block version by later versions of the format are skipped. */
+    len = tng_min_i64(block->header_contents_size - (int64_t)sizeof(block->header_contents_size),
+                      (int64_t)sizeof(buffer));
+    if (len < min_len
+        || tng_file_input_buffer(tng_data, buffer, len, TNG_SKIP_HASH, 0, __LINE__) != TNG_SUCCESS)
     {
-        tng_header_pointers_update(tng_data, hash_mode);
+        fprintf(stderr, "TNG library: Cannot read block header. %s: %d\n", __FILE__, __LINE__);
+        return (TNG_CRITICAL);
     }
 
-    /* Fill the block with NULL to avoid confusion. */
-    memset(contents, '\0', block_len);
-    fseeko(tng_data->output_file, block_start_pos, SEEK_SET);
-
-    /* FIXME: casting block_len to size_t is dangerous */
-    fwrite(contents, 1, block_len, tng_data->output_file);
-
-    free(contents);
-
-    return (TNG_SUCCESS);
-}
-
-static tng_function_status tng_length_of_current_frame_set_contents_get(struct tng_trajectory* tng_data,
-                                                                        int64_t*               len)
-{
-    int64_t             orig_pos, pos, curr_frame_set_pos;
-    tng_gen_block_t     block;
-    tng_function_status stat;
-
-    orig_pos           = ftello(tng_data->input_file);
-    curr_frame_set_pos = pos = tng_data->current_trajectory_frame_set_input_file_pos;
+    /* The block contents size and the block ID */
+    memcpy(values, buffer, sizeof(int64_t) * 2);
+    tng_input_values_swap_64(tng_data, values, 2, __LINE__);
+    block->block_contents_size = (int64_t)values[0];
+    block->id                  = (int64_t)values[1];
+    pos                        = sizeof(int64_t) * 2;
 
-    *len = 0;
+    memcpy(block->md5_hash, buffer + pos, TNG_MD5_HASH_LEN);
+    pos += TNG_MD5_HASH_LEN;
 
-    fseeko(tng_data->input_file, curr_frame_set_pos, SEEK_SET);
+    /* The name is null terminated, but at most TNG_MAX_STR_LEN long, and
+     * followed by the block version. */
+    max_name_len = tng_min_i64(len - pos - (int64_t)sizeof(int64_t), TNG_MAX_STR_LEN);
+    name_end     = (const char*)memchr(buffer + pos, '\0', max_name_len);
+    name_len     = name_end ? name_end - (buffer + pos) : max_name_len - 1;
 
-    tng_block_init(&block);
-    /* Read block headers first to see that a frame set block is found. */
-    stat = tng_block_header_read(tng_data, block);
-    if (stat == TNG_CRITICAL || block->id != TNG_TRAJECTORY_FRAME_SET)
+    temp_name = (char*)realloc(block->name, name_len + 1);
+    if (!temp_name)
     {
-        fprintf(stderr, "TNG library: Cannot read block header at pos %" PRId64 ". %s: %d\n",
-                curr_frame_set_pos, __FILE__, __LINE__);
-        tng_block_destroy(&block);
-        return (TNG_FAILURE);
+        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+        free(block->name);
+        block->name = 0;
+        return (TNG_CRITICAL);
     }
+    block->name = temp_name;
+    memcpy(block->name, buffer + pos, name_len);
+    block->name[name_len] = '\0';
+    pos += name_len + 1;
 
-    /* Read the headers of all blocks in the frame set (not the actual contents of them) */
-    while (stat == TNG_SUCCESS)
+    memcpy(values, buffer + pos, sizeof(int64_t));
+    tng_input_values_swap_64(tng_data, values, 1, __LINE__);
+    block->block_version = (int64_t)values[0];
+    pos += sizeof(int64_t);
+
+    /* The alternative hash type, its length and the hash, if present. */
+    block->alt_hash_type = TNG_NO_HASH;
+    block->alt_hash_len  = 0;
+    if (len - pos >= (int64_t)sizeof(int64_t) * 2)
     {
-        fseeko(tng_data->input_file, block->block_contents_size, SEEK_CUR);
-        *len += block->header_contents_size + block->block_contents_size;
-        pos += block->header_contents_size + block->block_contents_size;
-        if (pos >= tng_data->input_file_len)
-        {
-            break;
-        }
-        stat = tng_block_header_read(tng_data, block);
-        if (block->id == TNG_TRAJECTORY_FRAME_SET)
+        memcpy(values, buffer + pos, sizeof(int64_t) * 2);
+        tng_input_values_swap_64(tng_data, values, 2, __LINE__);
+        pos += sizeof(int64_t) * 2;
+        if ((int64_t)values[1] > 0 && (int64_t)values[1] <= len - pos)
         {
-            break;
+            temp_hash = (char*)realloc(block->alt_hash, values[1]);
+            if (!temp_hash)
+            {
+                fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+                return (TNG_CRITICAL);
+            }
+            block->alt_hash      = temp_hash;
+            block->alt_hash_type = (int64_t)values[0];
+            block->alt_hash_len  = (int64_t)values[1];
+            memcpy(block->alt_hash, buffer + pos, block->alt_hash_len);
         }
     }
 
-    /* Re-read the frame set that used to be the current one */
-    tng_reread_frame_set_at_file_pos(tng_data, curr_frame_set_pos);
-
-    fseeko(tng_data->input_file, orig_pos, SEEK_SET);
-
-    tng_block_destroy(&block);
+    tng_input_file_seek(tng_data, start_pos + block->header_contents_size, SEEK_SET);
 
     return (TNG_SUCCESS);
 }
 
 /**
- * @brief Migrate blocks in the file to make room for new data in a block. This
- * is required e.g. when adding data to a block or extending strings in a
- * block.
+ * @brief Write a whole block, both header and contents, regardless of it type
  * @param tng_data is a trajectory data container.
- * @param start_pos is the position from which to start moving data, usually
- * the byte after the end of the block to which data was added.
- * @param offset is the number of bytes that were inserted.
- * @param hash_mode is an option to decide whether to generate/update the relevant md5 hashes.
- * @details Trajectory blocks (frame sets and their related blocks) are moved
- * to the end of the file (if needed) in order to make room for non-trajectory
- * data.
+ * @param block is a general block container.
+ * @return TNG_SUCCESS (0) if successful, TNG_FAILURE (1) if a minor error
+ * has occurred or TNG_CRITICAL (2) if a major error has occured.
  */
-static tng_function_status tng_migrate_data_in_file(struct tng_trajectory* tng_data,
-                                                    const int64_t          start_pos,
-                                                    const int64_t          offset,
-                                                    const char             hash_mode)
-{
-    int64_t             traj_start_pos, empty_space, orig_file_pos, frame_set_length;
-    tng_gen_block_t     block;
-    tng_function_status stat;
-
-    if (offset <= 0)
-    {
-        return (TNG_SUCCESS);
-    }
-
-    stat = tng_file_pos_of_subsequent_trajectory_block_get(tng_data, &traj_start_pos);
-    if (stat != TNG_SUCCESS)
-    {
-        return (stat);
-    }
-
-    tng_data->current_trajectory_frame_set_input_file_pos = traj_start_pos;
-
-    empty_space = traj_start_pos - (start_pos - 1);
-
-    if (empty_space >= offset)
+/* Disabled until it is used.*/
+/*
+// static tng_function_status tng_block_verbatim_write(tng_trajectory_t tng_data,
+//                                                     tng_gen_block_t block)
+// {
+//     if(!block->header_contents)
+//     {
+//         fprintf(stderr, "TNG library: No contents to write. %s: %d\n", __FILE__, __LINE__);
+//         return(TNG_FAILURE);
+//     }
+//     if(fwrite(block->header_contents, block->header_contents_size, 1,
+//                 tng_data->output_file) != 1)
+//     {
+//         fprintf(stderr, "TNG library: Could not write all header data. %s: %d\n",
+//                 __FILE__, __LINE__);
+//         return(TNG_CRITICAL);
+//     }
+//
+//     if(!block->block_contents)
+//     {
+//         fprintf(stderr, "TNG library: No block data to write. %s: %d\n",
+//                 __FILE__, __LINE__);
+//         return(TNG_FAILURE);
+//     }
+//     if(fwrite(block->block_contents, block->block_contents_size, 1,
+//                 tng_data->output_file) != 1)
+//     {
+//         fprintf(stderr, "TNG library: Could not write all block data. %s: %d\n",
+//                 __FILE__, __LINE__);
+//         return(TNG_CRITICAL);
+//     }
+//     return(TNG_SUCCESS);
+// }
+*/
+
+/**
+ * @brief Update the hash of a block already written to the file
+ * @param tng_data is a trajectory data container.
+ * @param block is the block, of which to update the hash.
+ * @param header_start_pos is the file position where the block header starts.
+ * @param contents_start_pos is the file position where the block contents
+ * start.
+ * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
+ * error has occured.
+ */
+static tng_function_status tng_block_hash_update(const struct tng_trajectory* tng_data,
+                                                 struct tng_gen_block*        block,
+                                                 const int64_t                header_start_pos,
+                                                 const int64_t                contents_start_pos)
+{
+    if (block->block_contents)
     {
-        return (TNG_SUCCESS);
+        free(block->block_contents);
     }
 
-    orig_file_pos = ftello(tng_data->input_file);
-    tng_block_init(&block);
-
-    while (empty_space < offset)
+    block->block_contents = (char*)malloc(block->block_contents_size);
+    if (!block->block_contents)
     {
-        fseeko(tng_data->input_file, traj_start_pos, SEEK_SET);
-        stat = tng_block_header_read(tng_data, block);
-        if (stat == TNG_CRITICAL)
-        {
-            fprintf(stderr, "TNG library: Cannot read block header. %s: %d\n", __FILE__, __LINE__);
-            tng_block_destroy(&block);
-            return (TNG_CRITICAL);
-        }
-        if (stat != TNG_SUCCESS || block->id != TNG_TRAJECTORY_FRAME_SET)
-        {
-            tng_block_destroy(&block);
-            return (TNG_FAILURE);
-        }
-        stat = tng_length_of_current_frame_set_contents_get(tng_data, &frame_set_length);
-        if (stat != TNG_SUCCESS)
-        {
-            tng_block_destroy(&block);
-            return (stat);
-        }
-        stat = tng_frame_set_complete_migrate(tng_data, traj_start_pos, frame_set_length,
-                                              tng_data->input_file_len, hash_mode);
-        if (stat != TNG_SUCCESS)
-        {
-            tng_block_destroy(&block);
-            return (stat);
-        }
-
-        empty_space += frame_set_length;
+        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+        return (TNG_CRITICAL);
     }
-    fseeko(tng_data->input_file, orig_file_pos, SEEK_SET);
-    tng_block_destroy(&block);
 
-    return (TNG_SUCCESS);
-}
+    fseeko(tng_data->output_file, contents_start_pos, SEEK_SET);
+    if (fread(block->block_contents, block->block_contents_size, 1, tng_data->output_file) == 0)
+    {
+        fprintf(stderr, "TNG library: Cannot read block. %s: %d\n", __FILE__, __LINE__);
+        return (TNG_CRITICAL);
+    }
 
-static tng_function_status tng_block_header_len_calculate(const struct tng_trajectory* tng_data,
-                                                          struct tng_gen_block*        block,
-                                                          int64_t*                     len)
-{
-    int name_len;
-    (void)tng_data;
+    tng_block_hash_generate(block);
 
-    /* If the string is unallocated allocate memory for just string
-     * termination */
-    if (!block->name)
+    if (block->alt_hash_type != TNG_NO_HASH)
     {
-        block->name = (char*)malloc(1);
-        if (!block->name)
+        if (block->alt_hash)
         {
-            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
-            return (TNG_CRITICAL);
+            fseeko(tng_data->output_file,
+                   header_start_pos + block->header_contents_size - block->alt_hash_len, SEEK_SET);
+            fwrite(block->alt_hash, block->alt_hash_len, 1, tng_data->output_file);
         }
-        block->name[0] = 0;
     }
-
-    name_len = tng_min_size(strlen(block->name) + 1, TNG_MAX_STR_LEN);
-
-    /* Calculate the size of the header to write */
-    *len = sizeof(block->header_contents_size) + sizeof(block->block_contents_size)
-           + sizeof(block->id) + sizeof(block->block_version) + TNG_MD5_HASH_LEN + name_len;
+    else
+    {
+        fseeko(tng_data->output_file, header_start_pos + 3 * sizeof(int64_t), SEEK_SET);
+        fwrite(block->md5_hash, TNG_MD5_HASH_LEN, 1, tng_data->output_file);
+    }
 
     return (TNG_SUCCESS);
 }
 
 /**
- * @brief Write the header of a data block, regardless of its type
+ * @brief Update the frame set pointers in the file header (general info block),
+ * already written to disk
  * @param tng_data is a trajectory data container.
- * @param block is a general block container.
- * @param hash_mode is an option to decide whether to use the md5 hash or not.
- * If hash_mode == TNG_USE_HASH an md5 hash will be generated and written.
+ * @param hash_mode specifies whether to update the block md5 hash when
+ * updating the pointers.
  * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
  * error has occured.
  */
-static tng_function_status tng_block_header_write(struct tng_trajectory* tng_data, struct tng_gen_block* block)
+static tng_function_status tng_header_pointers_update(struct tng_trajectory* tng_data, const char hash_mode)
 {
-    TNG_ASSERT(block != 0, "TNG library: Trying to write uninitialized block (NULL pointer).");
+    tng_gen_block_t block;
+    FILE*           temp = tng_data->input_file;
+    uint64_t        output_file_pos, pos, contents_start_pos;
 
     if (tng_output_file_init(tng_data) != TNG_SUCCESS)
     {
@@ -1943,818 +2565,943 @@ static tng_function_status tng_block_header_write(struct tng_trajectory* tng_dat
         return (TNG_CRITICAL);
     }
 
-    if (tng_block_header_len_calculate(tng_data, block, &block->header_contents_size) != TNG_SUCCESS)
-    {
-        fprintf(stderr, "TNG library: Cannot calculate length of block header. %s: %d\n", __FILE__, __LINE__);
-        return (TNG_CRITICAL);
-    }
+    tng_data->input_file = tng_data->output_file;
 
-    if (tng_file_output_numerical(tng_data, &block->header_contents_size,
-                                  sizeof(block->header_contents_size), TNG_SKIP_HASH, 0, __LINE__)
-        == TNG_CRITICAL)
+    tng_block_init(&block);
+
+    output_file_pos = ftello(tng_data->output_file);
+    fseeko(tng_data->output_file, 0, SEEK_SET);
+
+    if (tng_block_header_read(tng_data, block) != TNG_SUCCESS)
     {
+        fprintf(stderr, "TNG library: Cannot read general info header. %s: %d\n", __FILE__, __LINE__);
+        tng_data->input_file = temp;
+        tng_block_destroy(&block);
         return (TNG_CRITICAL);
     }
 
-    if (tng_file_output_numerical(tng_data, &block->block_contents_size,
-                                  sizeof(block->block_contents_size), TNG_SKIP_HASH, 0, __LINE__)
-        == TNG_CRITICAL)
+    contents_start_pos = ftello(tng_data->output_file);
+
+    fseeko(tng_data->output_file, block->block_contents_size - 5 * sizeof(int64_t), SEEK_CUR);
+
+    tng_data->input_file = temp;
+
+    pos = tng_data->first_trajectory_frame_set_output_file_pos;
+
+    if (tng_data->input_endianness_swap_func_64)
     {
-        return (TNG_CRITICAL);
+        if (tng_data->input_endianness_swap_func_64(tng_data, &pos) != TNG_SUCCESS)
+        {
+            fprintf(stderr, "TNG library: Cannot swap byte order. %s: %d\n", __FILE__, __LINE__);
+        }
     }
 
-    if (tng_file_output_numerical(tng_data, &block->id, sizeof(block->id), TNG_SKIP_HASH, 0, __LINE__)
-        == TNG_CRITICAL)
+    if (fwrite(&pos, sizeof(int64_t), 1, tng_data->output_file) != 1)
     {
+        tng_block_destroy(&block);
         return (TNG_CRITICAL);
     }
 
-    if (fwrite(block->md5_hash, TNG_MD5_HASH_LEN, 1, tng_data->output_file) != 1)
+    pos = tng_data->last_trajectory_frame_set_output_file_pos;
+
+    if (tng_data->input_endianness_swap_func_64)
     {
-        fprintf(stderr, "TNG library: Could not write header data. %s: %d\n", __FILE__, __LINE__);
-        return (TNG_CRITICAL);
+        if (tng_data->input_endianness_swap_func_64(tng_data, &pos) != TNG_SUCCESS)
+        {
+            fprintf(stderr, "TNG library: Cannot swap byte order. %s: %d\n", __FILE__, __LINE__);
+        }
     }
 
-    if (tng_fwritestr(tng_data, block->name, TNG_SKIP_HASH, 0, __LINE__) == TNG_CRITICAL)
+    if (fwrite(&pos, sizeof(int64_t), 1, tng_data->output_file) != 1)
     {
+        tng_block_destroy(&block);
         return (TNG_CRITICAL);
     }
 
-    if (tng_file_output_numerical(tng_data, &block->block_version, sizeof(block->block_version),
-                                  TNG_SKIP_HASH, 0, __LINE__)
-        == TNG_CRITICAL)
+    if (hash_mode == TNG_USE_HASH)
     {
-        return (TNG_CRITICAL);
+        tng_block_hash_update(tng_data, block, 0, contents_start_pos);
     }
 
+    tng_block_destroy(&block);
+
+    fseeko(tng_data->output_file, output_file_pos, SEEK_SET);
+
     return (TNG_SUCCESS);
 }
 
-static tng_function_status tng_general_info_block_len_calculate(struct tng_trajectory* tng_data, int64_t* len)
+/**
+ * @brief Update the frame set pointers in the current frame set block, already
+ * written to disk. It also updates the pointers of the blocks pointing to
+ * the current frame set block.
+ * @param tng_data is a trajectory data container.
+ * @param hash_mode specifies whether to update the block md5 hash when
+ * updating the pointers.
+ * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
+ * error has occured.
+ */
+static tng_function_status tng_frame_set_pointers_update(struct tng_trajectory* tng_data, const char hash_mode)
 {
-    size_t first_program_name_len, first_user_name_len;
-    size_t first_computer_name_len, first_pgp_signature_len;
-    size_t last_program_name_len, last_user_name_len;
-    size_t last_computer_name_len, last_pgp_signature_len;
-    size_t forcefield_name_len;
+    tng_gen_block_t            block;
+    tng_trajectory_frame_set_t frame_set;
+    FILE*                      temp = tng_data->input_file;
+    uint64_t                   pos, output_file_pos, contents_start_pos;
 
-    /* If the strings are unallocated allocate memory for just string
-     * termination */
-    if (!tng_data->first_program_name)
-    {
-        tng_data->first_program_name = (char*)malloc(1);
-        if (!tng_data->first_program_name)
-        {
-            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
-            return (TNG_CRITICAL);
-        }
-        tng_data->first_program_name[0] = 0;
-    }
-    if (!tng_data->last_program_name)
+    if (tng_output_file_init(tng_data) != TNG_SUCCESS)
     {
-        tng_data->last_program_name = (char*)malloc(1);
-        if (!tng_data->last_program_name)
-        {
-            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
-            return (TNG_CRITICAL);
-        }
-        tng_data->last_program_name[0] = 0;
+        fprintf(stderr, "TNG library: Cannot initialise destination file. %s: %d\n", __FILE__, __LINE__);
+        return (TNG_CRITICAL);
     }
-    if (!tng_data->first_user_name)
+
+    tng_block_init(&block);
+    output_file_pos = ftello(tng_data->output_file);
+
+    tng_data->input_file = tng_data->output_file;
+
+    frame_set = &tng_data->current_trajectory_frame_set;
+
+    pos = tng_data->current_trajectory_frame_set_output_file_pos;
+
+    /* Update next frame set */
+    if (frame_set->next_frame_set_file_pos > 0)
     {
-        tng_data->first_user_name = (char*)malloc(1);
-        if (!tng_data->first_user_name)
+        fseeko(tng_data->output_file, frame_set->next_frame_set_file_pos, SEEK_SET);
+
+        if (tng_block_header_read(tng_data, block) != TNG_SUCCESS)
         {
-            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+            fprintf(stderr, "TNG library: Cannot read frame header. %s: %d\n", __FILE__, __LINE__);
+            tng_data->input_file = temp;
+            tng_block_destroy(&block);
             return (TNG_CRITICAL);
         }
-        tng_data->first_user_name[0] = 0;
-    }
-    if (!tng_data->last_user_name)
-    {
-        tng_data->last_user_name = (char*)malloc(1);
-        if (!tng_data->last_user_name)
+
+        contents_start_pos = ftello(tng_data->output_file);
+
+        fseeko(tng_data->output_file,
+               block->block_contents_size - (5 * sizeof(int64_t) + 2 * sizeof(double)), SEEK_CUR);
+
+        if (tng_data->input_endianness_swap_func_64)
         {
-            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+            if (tng_data->input_endianness_swap_func_64(tng_data, &pos) != TNG_SUCCESS)
+            {
+                fprintf(stderr, "TNG library: Cannot swap byte order. %s: %d\n", __FILE__, __LINE__);
+            }
+        }
+
+        if (fwrite(&pos, sizeof(int64_t), 1, tng_data->output_file) != 1)
+        {
+            tng_data->input_file = temp;
+            tng_block_destroy(&block);
             return (TNG_CRITICAL);
         }
-        tng_data->last_user_name[0] = 0;
+
+        if (hash_mode == TNG_USE_HASH)
+        {
+            tng_block_hash_update(tng_data, block, frame_set->next_frame_set_file_pos,
+                                  contents_start_pos);
+        }
     }
-    if (!tng_data->first_computer_name)
+    /* Update previous frame set */
+    if (frame_set->prev_frame_set_file_pos > 0)
     {
-        tng_data->first_computer_name = (char*)malloc(1);
-        if (!tng_data->first_computer_name)
+        fseeko(tng_data->output_file, frame_set->prev_frame_set_file_pos, SEEK_SET);
+
+        if (tng_block_header_read(tng_data, block) != TNG_SUCCESS)
         {
-            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+            fprintf(stderr, "TNG library: Cannot read frame header. %s: %d\n", __FILE__, __LINE__);
+            tng_data->input_file = temp;
+            tng_block_destroy(&block);
             return (TNG_CRITICAL);
         }
-        tng_data->first_computer_name[0] = 0;
-    }
-    if (!tng_data->last_computer_name)
-    {
-        tng_data->last_computer_name = (char*)malloc(1);
-        if (!tng_data->last_computer_name)
+
+        contents_start_pos = ftello(tng_data->output_file);
+
+        fseeko(tng_data->output_file,
+               block->block_contents_size - (6 * sizeof(int64_t) + 2 * sizeof(double)), SEEK_CUR);
+
+        if (tng_data->input_endianness_swap_func_64)
         {
-            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+            if (tng_data->input_endianness_swap_func_64(tng_data, &pos) != TNG_SUCCESS)
+            {
+                fprintf(stderr, "TNG library: Cannot swap byte order. %s: %d\n", __FILE__, __LINE__);
+            }
+        }
+
+        if (fwrite(&pos, sizeof(int64_t), 1, tng_data->output_file) != 1)
+        {
+            tng_data->input_file = temp;
+            tng_block_destroy(&block);
             return (TNG_CRITICAL);
         }
-        tng_data->last_computer_name[0] = 0;
+
+        if (hash_mode == TNG_USE_HASH)
+        {
+            tng_block_hash_update(tng_data, block, frame_set->prev_frame_set_file_pos,
+                                  contents_start_pos);
+        }
     }
-    if (!tng_data->first_pgp_signature)
+
+    /* Update the frame set one medium stride step after */
+    if (frame_set->medium_stride_next_frame_set_file_pos > 0)
     {
-        tng_data->first_pgp_signature = (char*)malloc(1);
-        if (!tng_data->first_pgp_signature)
+        fseeko(tng_data->output_file, frame_set->medium_stride_next_frame_set_file_pos, SEEK_SET);
+
+        if (tng_block_header_read(tng_data, block) != TNG_SUCCESS)
         {
-            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+            fprintf(stderr, "TNG library: Cannot read frame set header. %s: %d\n", __FILE__, __LINE__);
+            tng_data->input_file = temp;
+            tng_block_destroy(&block);
             return (TNG_CRITICAL);
         }
-        tng_data->first_pgp_signature[0] = 0;
-    }
-    if (!tng_data->last_pgp_signature)
-    {
-        tng_data->last_pgp_signature = (char*)malloc(1);
-        if (!tng_data->last_pgp_signature)
+
+        contents_start_pos = ftello(tng_data->output_file);
+
+        fseeko(tng_data->output_file,
+               block->block_contents_size - (3 * sizeof(int64_t) + 2 * sizeof(double)), SEEK_CUR);
+
+        if (tng_data->input_endianness_swap_func_64)
         {
-            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+            if (tng_data->input_endianness_swap_func_64(tng_data, &pos) != TNG_SUCCESS)
+            {
+                fprintf(stderr, "TNG library: Cannot swap byte order. %s: %d\n", __FILE__, __LINE__);
+            }
+        }
+
+        if (fwrite(&pos, sizeof(int64_t), 1, tng_data->output_file) != 1)
+        {
+            tng_data->input_file = temp;
+            tng_block_destroy(&block);
             return (TNG_CRITICAL);
         }
-        tng_data->last_pgp_signature[0] = 0;
+
+        if (hash_mode == TNG_USE_HASH)
+        {
+            tng_block_hash_update(tng_data, block, frame_set->medium_stride_next_frame_set_file_pos,
+                                  contents_start_pos);
+        }
     }
-    if (!tng_data->forcefield_name)
+    /* Update the frame set one medium stride step before */
+    if (frame_set->medium_stride_prev_frame_set_file_pos > 0)
     {
-        tng_data->forcefield_name = (char*)malloc(1);
-        if (!tng_data->forcefield_name)
+        fseeko(tng_data->output_file, frame_set->medium_stride_prev_frame_set_file_pos, SEEK_SET);
+
+        if (tng_block_header_read(tng_data, block) != TNG_SUCCESS)
         {
-            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+            fprintf(stderr, "TNG library: Cannot read frame set header. %s: %d\n", __FILE__, __LINE__);
+            tng_data->input_file = temp;
+            tng_block_destroy(&block);
             return (TNG_CRITICAL);
         }
-        tng_data->forcefield_name[0] = 0;
-    }
-
-    first_program_name_len = tng_min_size(strlen(tng_data->first_program_name) + 1, TNG_MAX_STR_LEN);
-    last_program_name_len  = tng_min_size(strlen(tng_data->last_program_name) + 1, TNG_MAX_STR_LEN);
-    first_user_name_len    = tng_min_size(strlen(tng_data->first_user_name) + 1, TNG_MAX_STR_LEN);
-    last_user_name_len     = tng_min_size(strlen(tng_data->last_user_name) + 1, TNG_MAX_STR_LEN);
-    first_computer_name_len = tng_min_size(strlen(tng_data->first_computer_name) + 1, TNG_MAX_STR_LEN);
-    last_computer_name_len = tng_min_size(strlen(tng_data->last_computer_name) + 1, TNG_MAX_STR_LEN);
-    first_pgp_signature_len = tng_min_size(strlen(tng_data->first_pgp_signature) + 1, TNG_MAX_STR_LEN);
-    last_pgp_signature_len = tng_min_size(strlen(tng_data->last_pgp_signature) + 1, TNG_MAX_STR_LEN);
-    forcefield_name_len    = tng_min_size(strlen(tng_data->forcefield_name) + 1, TNG_MAX_STR_LEN);
 
-    *len = sizeof(tng_data->time) + sizeof(tng_data->var_num_atoms_flag)
-           + sizeof(tng_data->frame_set_n_frames)
-           + sizeof(tng_data->first_trajectory_frame_set_input_file_pos)
-           + sizeof(tng_data->last_trajectory_frame_set_input_file_pos)
-           + sizeof(tng_data->medium_stride_length) + sizeof(tng_data->long_stride_length)
-           + sizeof(tng_data->distance_unit_exponential) + first_program_name_len + last_program_name_len
-           + first_user_name_len + last_user_name_len + first_computer_name_len + last_computer_name_len
-           + first_pgp_signature_len + last_pgp_signature_len + forcefield_name_len;
+        contents_start_pos = ftello(tng_data->output_file);
 
-    return (TNG_SUCCESS);
-}
+        fseeko(tng_data->output_file,
+               block->block_contents_size - (4 * sizeof(int64_t) + 2 * sizeof(double)), SEEK_CUR);
 
-/**
- * @brief Read a general info block. This is the first block of a TNG file.
- * Populate the fields in tng_data.
- * @param tng_data is a trajectory data container.
- * @param block is a general block container.
- * @param hash_mode is an option to decide whether to use the md5 hash or not.
- * If hash_mode == TNG_USE_HASH the written md5 hash in the file will be
- * compared to the md5 hash of the read contents to ensure valid data.
- * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
- * error has occured.
- */
-static tng_function_status tng_general_info_block_read(struct tng_trajectory*      tng_data,
-                                                       const struct tng_gen_block* block,
-                                                       const char                  hash_mode)
-{
-    int64_t     start_pos;
-    char        hash[TNG_MD5_HASH_LEN];
-    md5_state_t md5_state;
+        if (tng_data->input_endianness_swap_func_64)
+        {
+            if (tng_data->input_endianness_swap_func_64(tng_data, &pos) != TNG_SUCCESS)
+            {
+                fprintf(stderr, "TNG library: Cannot swap byte order. %s: %d\n", __FILE__, __LINE__);
+            }
+        }
 
-    TNG_ASSERT(block != 0,
-               "TNG library: Trying to read data to an uninitialized block (NULL pointer)");
+        if (fwrite(&pos, sizeof(int64_t), 1, tng_data->output_file) != 1)
+        {
+            tng_data->input_file = temp;
+            tng_block_destroy(&block);
+            return (TNG_CRITICAL);
+        }
 
-    if (tng_input_file_init(tng_data) != TNG_SUCCESS)
-    {
-        return (TNG_CRITICAL);
+        if (hash_mode == TNG_USE_HASH)
+        {
+            tng_block_hash_update(tng_data, block, frame_set->medium_stride_prev_frame_set_file_pos,
+                                  contents_start_pos);
+        }
     }
 
-    start_pos = ftello(tng_data->input_file);
-
-    if (hash_mode == TNG_USE_HASH)
+    /* Update the frame set one long stride step after */
+    if (frame_set->long_stride_next_frame_set_file_pos > 0)
     {
-        md5_init(&md5_state);
-    }
+        fseeko(tng_data->output_file, frame_set->long_stride_next_frame_set_file_pos, SEEK_SET);
 
-    tng_freadstr(tng_data, &tng_data->first_program_name, hash_mode, &md5_state, __LINE__);
+        if (tng_block_header_read(tng_data, block) != TNG_SUCCESS)
+        {
+            fprintf(stderr, "TNG library: Cannot read frame set header. %s: %d\n", __FILE__, __LINE__);
+            tng_data->input_file = temp;
+            tng_block_destroy(&block);
+            return (TNG_CRITICAL);
+        }
 
-    tng_freadstr(tng_data, &tng_data->last_program_name, hash_mode, &md5_state, __LINE__);
+        contents_start_pos = ftello(tng_data->output_file);
 
-    tng_freadstr(tng_data, &tng_data->first_user_name, hash_mode, &md5_state, __LINE__);
+        fseeko(tng_data->output_file,
+               block->block_contents_size - (1 * sizeof(int64_t) + 2 * sizeof(double)), SEEK_CUR);
 
-    tng_freadstr(tng_data, &tng_data->last_user_name, hash_mode, &md5_state, __LINE__);
+        if (tng_data->input_endianness_swap_func_64)
+        {
+            if (tng_data->input_endianness_swap_func_64(tng_data, &pos) != TNG_SUCCESS)
+            {
+                fprintf(stderr, "TNG library: Cannot swap byte order. %s: %d\n", __FILE__, __LINE__);
+            }
+        }
 
-    tng_freadstr(tng_data, &tng_data->first_computer_name, hash_mode, &md5_state, __LINE__);
+        if (fwrite(&pos, sizeof(int64_t), 1, tng_data->output_file) != 1)
+        {
+            tng_data->input_file = temp;
+            tng_block_destroy(&block);
+            return (TNG_CRITICAL);
+        }
 
-    tng_freadstr(tng_data, &tng_data->last_computer_name, hash_mode, &md5_state, __LINE__);
+        if (hash_mode == TNG_USE_HASH)
+        {
+            tng_block_hash_update(tng_data, block, frame_set->long_stride_next_frame_set_file_pos,
+                                  contents_start_pos);
+        }
+    }
+    /* Update the frame set one long stride step before */
+    if (frame_set->long_stride_prev_frame_set_file_pos > 0)
+    {
+        fseeko(tng_data->output_file, frame_set->long_stride_prev_frame_set_file_pos, SEEK_SET);
 
-    tng_freadstr(tng_data, &tng_data->first_pgp_signature, hash_mode, &md5_state, __LINE__);
+        if (tng_block_header_read(tng_data, block) != TNG_SUCCESS)
+        {
+            fprintf(stderr, "TNG library: Cannot read frame set header. %s: %d\n", __FILE__, __LINE__);
+            tng_data->input_file = temp;
+            tng_block_destroy(&block);
+            return (TNG_CRITICAL);
+        }
 
-    tng_freadstr(tng_data, &tng_data->last_pgp_signature, hash_mode, &md5_state, __LINE__);
+        contents_start_pos = ftello(tng_data->output_file);
 
-    tng_freadstr(tng_data, &tng_data->forcefield_name, hash_mode, &md5_state, __LINE__);
+        fseeko(tng_data->output_file,
+               block->block_contents_size - (2 * sizeof(int64_t) + 2 * sizeof(double)), SEEK_CUR);
 
-    if (tng_file_input_numerical(tng_data, &tng_data->time, sizeof(tng_data->time), hash_mode,
-                                 &md5_state, __LINE__)
-        == TNG_CRITICAL)
-    {
-        return (TNG_CRITICAL);
-    }
+        if (tng_data->input_endianness_swap_func_64)
+        {
+            if (tng_data->input_endianness_swap_func_64(tng_data, &pos) != TNG_SUCCESS)
+            {
+                fprintf(stderr, "TNG library: Cannot swap byte order. %s: %d\n", __FILE__, __LINE__);
+            }
+        }
 
+        if (fwrite(&pos, sizeof(int64_t), 1, tng_data->output_file) != 1)
+        {
+            tng_data->input_file = temp;
+            tng_block_destroy(&block);
+            return (TNG_CRITICAL);
+        }
 
-    if (tng_file_input_numerical(tng_data, &tng_data->var_num_atoms_flag,
-                                 sizeof(tng_data->var_num_atoms_flag), hash_mode, &md5_state, __LINE__)
-        == TNG_CRITICAL)
-    {
-        return (TNG_CRITICAL);
+        if (hash_mode == TNG_USE_HASH)
+        {
+            tng_block_hash_update(tng_data, block, frame_set->long_stride_prev_frame_set_file_pos,
+                                  contents_start_pos);
+        }
     }
 
-    if (tng_file_input_numerical(tng_data, &tng_data->frame_set_n_frames,
-                                 sizeof(tng_data->frame_set_n_frames), hash_mode, &md5_state, __LINE__)
-        == TNG_CRITICAL)
-    {
-        return (TNG_CRITICAL);
-    }
+    fseeko(tng_data->output_file, output_file_pos, SEEK_SET);
 
-    if (tng_file_input_numerical(tng_data, &tng_data->first_trajectory_frame_set_input_file_pos,
-                                 sizeof(tng_data->first_trajectory_frame_set_input_file_pos),
-                                 hash_mode, &md5_state, __LINE__)
-        == TNG_CRITICAL)
-    {
-        return (TNG_CRITICAL);
-    }
+    tng_data->input_file = temp;
 
-    tng_data->current_trajectory_frame_set.next_frame_set_file_pos =
-            tng_data->first_trajectory_frame_set_input_file_pos;
+    tng_block_destroy(&block);
 
-    if (tng_file_input_numerical(tng_data, &tng_data->last_trajectory_frame_set_input_file_pos,
-                                 sizeof(tng_data->last_trajectory_frame_set_input_file_pos),
-                                 hash_mode, &md5_state, __LINE__)
-        == TNG_CRITICAL)
-    {
-        return (TNG_CRITICAL);
-    }
+    return (TNG_SUCCESS);
+}
 
-    if (tng_file_input_numerical(tng_data, &tng_data->medium_stride_length,
-                                 sizeof(tng_data->medium_stride_length), hash_mode, &md5_state, __LINE__)
-        == TNG_CRITICAL)
-    {
-        return (TNG_CRITICAL);
-    }
+static tng_function_status tng_reread_frame_set_at_file_pos(struct tng_trajectory* tng_data, const int64_t pos)
+{
+    tng_gen_block_t     block;
+    tng_function_status stat;
 
-    if (tng_file_input_numerical(tng_data, &tng_data->long_stride_length,
-                                 sizeof(tng_data->long_stride_length), hash_mode, &md5_state, __LINE__)
-        == TNG_CRITICAL)
-    {
-        return (TNG_CRITICAL);
-    }
+    tng_block_init(&block);
 
-    if (block->block_version >= 3)
+    tng_input_file_seek(tng_data, pos, SEEK_SET);
+    if (pos > 0)
     {
-        if (tng_file_input_numerical(tng_data, &tng_data->distance_unit_exponential,
-                                     sizeof(tng_data->distance_unit_exponential), hash_mode,
-                                     &md5_state, __LINE__)
-            == TNG_CRITICAL)
+        stat = tng_block_header_read(tng_data, block);
+        if (stat == TNG_CRITICAL || block->id != TNG_TRAJECTORY_FRAME_SET)
         {
-            return (TNG_CRITICAL);
+            fprintf(stderr, "TNG library: Cannot read block header at pos %" PRId64 ". %s: %d\n",
+                    pos, __FILE__, __LINE__);
+            tng_block_destroy(&block);
+            return (TNG_FAILURE);
         }
-    }
-
-    if (hash_mode == TNG_USE_HASH)
-    {
-        /* If there is data left in the block that the current version of the library
-         * cannot interpret still read that to generate the MD5 hash. */
-        tng_md5_remaining_append(tng_data, block, start_pos, &md5_state);
 
-        md5_finish(&md5_state, (md5_byte_t*)hash);
-        if (strncmp(block->md5_hash, "\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0", TNG_MD5_HASH_LEN) != 0)
+        if (tng_block_read_next(tng_data, block, TNG_SKIP_HASH) != TNG_SUCCESS)
         {
-            if (strncmp(block->md5_hash, hash, TNG_MD5_HASH_LEN) != 0)
-            {
-                fprintf(stderr,
-                        "TNG library: General info block contents corrupt. Hashes do not match. "
-                        "%s: %d\n",
-                        __FILE__, __LINE__);
-            }
+            tng_block_destroy(&block);
+            return (TNG_CRITICAL);
         }
     }
-    else
-    {
-        /* Seek to the end of the block */
-        fseeko(tng_data->input_file, start_pos + block->block_contents_size, SEEK_SET);
-    }
+
+    tng_block_destroy(&block);
 
     return (TNG_SUCCESS);
 }
 
-/**
- * @brief Write a general info block. This is the first block of a TNG file.
- * @param tng_data is a trajectory data container.
- * @param hash_mode is an option to decide whether to use the md5 hash or not.
- * If hash_mode == TNG_USE_HASH an md5 hash will be generated and written.
- * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
- * error has occured.
- */
-static tng_function_status tng_general_info_block_write(struct tng_trajectory* tng_data, const char hash_mode)
+static tng_function_status tng_file_pos_of_subsequent_trajectory_block_get(struct tng_trajectory* tng_data,
+                                                                           int64_t* pos)
 {
-    int64_t         header_file_pos, curr_file_pos;
-    size_t          name_len;
-    tng_gen_block_t block;
-    md5_state_t     md5_state;
-
-    if (tng_output_file_init(tng_data) != TNG_SUCCESS)
-    {
-        return (TNG_CRITICAL);
-    }
-
-    fseeko(tng_data->output_file, 0, SEEK_SET);
+    int64_t                    orig_pos, curr_frame_set_pos;
+    tng_gen_block_t            block;
+    tng_function_status        stat;
+    tng_trajectory_frame_set_t frame_set = &tng_data->current_trajectory_frame_set;
 
-    tng_block_init(&block);
+    orig_pos           = tng_input_file_tell(tng_data);
+    curr_frame_set_pos = tng_data->current_trajectory_frame_set_input_file_pos;
 
-    name_len = strlen("GENERAL INFO");
+    *pos = tng_data->first_trajectory_frame_set_input_file_pos;
 
-    block->name = (char*)malloc(name_len + 1);
-    if (!block->name)
+    if (*pos <= 0)
     {
-        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
-        tng_block_destroy(&block);
-        return (TNG_CRITICAL);
+        return (TNG_SUCCESS);
     }
 
-    strcpy(block->name, "GENERAL INFO");
-    block->id = TNG_GENERAL_INFO;
+    tng_input_file_seek(tng_data, *pos, SEEK_SET);
 
-    if (tng_general_info_block_len_calculate(tng_data, &block->block_contents_size) != TNG_SUCCESS)
+    tng_block_init(&block);
+    /* Read block headers first to see that a frame set block is found. */
+    stat = tng_block_header_read(tng_data, block);
+    if (stat == TNG_CRITICAL || block->id != TNG_TRAJECTORY_FRAME_SET)
     {
-        fprintf(stderr, "TNG library: Cannot calculate length of general info block. %s: %d\n",
+        fprintf(stderr, "TNG library: Cannot read block header at pos %" PRId64 ". %s: %d\n", *pos,
                 __FILE__, __LINE__);
         tng_block_destroy(&block);
-        return (TNG_CRITICAL);
+        return (TNG_FAILURE);
     }
 
-    header_file_pos = 0;
-
-    if (tng_block_header_write(tng_data, block) != TNG_SUCCESS)
+    if (tng_block_read_next(tng_data, block, TNG_SKIP_HASH) != TNG_SUCCESS)
     {
-        fprintf(stderr, "TNG library: Cannot write header of file %s. %s: %d\n",
-                tng_data->output_file_path, __FILE__, __LINE__);
         tng_block_destroy(&block);
         return (TNG_CRITICAL);
     }
 
-    if (hash_mode == TNG_USE_HASH)
-    {
-        md5_init(&md5_state);
-    }
-
-    if (tng_fwritestr(tng_data, tng_data->first_program_name, hash_mode, &md5_state, __LINE__) == TNG_CRITICAL)
+    /* Read all frame set blocks (not the blocks between them) */
+    while (frame_set->next_frame_set_file_pos > 0)
     {
-        return (TNG_CRITICAL);
-    }
+        tng_input_file_seek(tng_data, frame_set->next_frame_set_file_pos, SEEK_SET);
+        stat = tng_block_header_read(tng_data, block);
+        if (stat == TNG_CRITICAL)
+        {
+            fprintf(stderr, "TNG library: Cannot read block header at pos %" PRId64 ". %s: %d\n",
+                    *pos, __FILE__, __LINE__);
+            tng_block_destroy(&block);
+            return (TNG_CRITICAL);
+        }
+        if (stat != TNG_SUCCESS || block->id != TNG_TRAJECTORY_FRAME_SET)
+        {
+            return (TNG_FAILURE);
+        }
 
-    if (tng_fwritestr(tng_data, tng_data->last_program_name, hash_mode, &md5_state, __LINE__) == TNG_CRITICAL)
-    {
-        return (TNG_CRITICAL);
+        stat = tng_block_read_next(tng_data, block, TNG_SKIP_HASH);
+        if (stat != TNG_SUCCESS)
+        {
+            tng_block_destroy(&block);
+            return (stat);
+        }
+        /* Update *pos if this is the earliest frame set so far (after orig_pos) */
+        if (tng_data->current_trajectory_frame_set_input_file_pos < *pos
+            && tng_data->current_trajectory_frame_set_input_file_pos > orig_pos)
+        {
+            *pos = tng_data->current_trajectory_frame_set_input_file_pos;
+        }
     }
 
-    if (tng_fwritestr(tng_data, tng_data->first_user_name, hash_mode, &md5_state, __LINE__) == TNG_CRITICAL)
-    {
-        return (TNG_CRITICAL);
-    }
+    /* Re-read the frame set that used to be the current one */
+    tng_reread_frame_set_at_file_pos(tng_data, curr_frame_set_pos);
 
-    if (tng_fwritestr(tng_data, tng_data->last_user_name, hash_mode, &md5_state, __LINE__) == TNG_CRITICAL)
-    {
-        return (TNG_CRITICAL);
-    }
+    tng_input_file_seek(tng_data, orig_pos, SEEK_SET);
 
-    if (tng_fwritestr(tng_data, tng_data->first_computer_name, hash_mode, &md5_state, __LINE__) == TNG_CRITICAL)
-    {
-        return (TNG_CRITICAL);
-    }
+    tng_block_destroy(&block);
 
-    if (tng_fwritestr(tng_data, tng_data->last_computer_name, hash_mode, &md5_state, __LINE__) == TNG_CRITICAL)
-    {
-        return (TNG_CRITICAL);
-    }
+    return (TNG_SUCCESS);
+}
 
-    if (tng_fwritestr(tng_data, tng_data->first_pgp_signature, hash_mode, &md5_state, __LINE__) == TNG_CRITICAL)
-    {
-        return (TNG_CRITICAL);
-    }
+/**
+ * @brief Migrate a whole frame set from one position in the file to another.
+ * @param tng_data is a trajectory data container.
+ * @param block_start_pos is the starting position in the file of the frame set.
+ * @param block_len is the length of the whole frame set (including all data blocks etc).
+ * @param new_pos is the new position in the file of the frame set.
+ * @param hash_mode is an option to decide whether to generate/update the relevant md5 hashes.
+ */
+static tng_function_status tng_frame_set_complete_migrate(struct tng_trajectory* tng_data,
+                                                          const int64_t          block_start_pos,
+                                                          const int64_t          block_len,
+                                                          const int64_t          new_pos,
+                                                          const char             hash_mode)
+{
+    tng_bool updated = TNG_FALSE;
 
-    if (tng_fwritestr(tng_data, tng_data->last_pgp_signature, hash_mode, &md5_state, __LINE__) == TNG_CRITICAL)
-    {
-        return (TNG_CRITICAL);
-    }
+    char* contents;
 
-    if (tng_fwritestr(tng_data, tng_data->forcefield_name, hash_mode, &md5_state, __LINE__) == TNG_CRITICAL)
+    if (tng_input_file_init(tng_data) != TNG_SUCCESS)
     {
         return (TNG_CRITICAL);
     }
 
+    tng_input_file_seek(tng_data, block_start_pos, SEEK_SET);
 
-    if (tng_file_output_numerical(tng_data, &tng_data->time, sizeof(tng_data->time), hash_mode,
-                                  &md5_state, __LINE__)
-        == TNG_CRITICAL)
-    {
-        return (TNG_CRITICAL);
-    }
-
-    if (tng_file_output_numerical(tng_data, &tng_data->var_num_atoms_flag,
-                                  sizeof(tng_data->var_num_atoms_flag), hash_mode, &md5_state, __LINE__)
-        == TNG_CRITICAL)
+    contents = (char*)malloc(block_len);
+    if (!contents)
     {
+        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
         return (TNG_CRITICAL);
     }
 
-    if (tng_file_output_numerical(tng_data, &tng_data->frame_set_n_frames,
-                                  sizeof(tng_data->frame_set_n_frames), hash_mode, &md5_state, __LINE__)
-        == TNG_CRITICAL)
+    if (tng_input_file_read(tng_data, contents, block_len) == 0)
     {
+        fprintf(stderr, "TNG library: Cannot read data from file when migrating data. %s: %d\n",
+                __FILE__, __LINE__);
+        free(contents);
         return (TNG_CRITICAL);
     }
+    fseeko(tng_data->output_file, new_pos, SEEK_SET);
 
-    if (tng_file_output_numerical(tng_data, &tng_data->first_trajectory_frame_set_output_file_pos,
-                                  sizeof(tng_data->first_trajectory_frame_set_output_file_pos),
-                                  hash_mode, &md5_state, __LINE__)
-        == TNG_CRITICAL)
+    if (fwrite(contents, block_len, 1, tng_data->output_file) != 1)
     {
+        fprintf(stderr, "TNG library: Could not write data to file when migrating data. %s: %d\n",
+                __FILE__, __LINE__);
+        free(contents);
         return (TNG_CRITICAL);
     }
 
-    if (tng_file_output_numerical(tng_data, &tng_data->last_trajectory_frame_set_output_file_pos,
-                                  sizeof(tng_data->last_trajectory_frame_set_output_file_pos),
-                                  hash_mode, &md5_state, __LINE__)
-        == TNG_CRITICAL)
+    tng_data->current_trajectory_frame_set_output_file_pos = new_pos;
+    if (tng_data->input_file == tng_data->output_file)
     {
-        return (TNG_CRITICAL);
+        tng_data->current_trajectory_frame_set_input_file_pos = new_pos;
     }
 
-    if (tng_file_output_numerical(tng_data, &tng_data->medium_stride_length,
-                                  sizeof(tng_data->medium_stride_length), hash_mode, &md5_state, __LINE__)
-        == TNG_CRITICAL)
-    {
-        return (TNG_CRITICAL);
-    }
+    tng_frame_set_pointers_update(tng_data, hash_mode);
 
-    if (tng_file_output_numerical(tng_data, &tng_data->long_stride_length,
-                                  sizeof(tng_data->long_stride_length), hash_mode, &md5_state, __LINE__)
-        == TNG_CRITICAL)
+    /* Update the general info block if needed */
+    if (block_start_pos == tng_data->first_trajectory_frame_set_output_file_pos)
     {
-        return (TNG_CRITICAL);
+        tng_data->first_trajectory_frame_set_output_file_pos = new_pos;
+        updated                                              = TNG_TRUE;
     }
-
-    if (tng_file_output_numerical(tng_data, &tng_data->distance_unit_exponential,
-                                  sizeof(tng_data->distance_unit_exponential), hash_mode, &md5_state, __LINE__)
-        == TNG_CRITICAL)
+    if (block_start_pos == tng_data->last_trajectory_frame_set_output_file_pos)
     {
-        return (TNG_CRITICAL);
+        tng_data->last_trajectory_frame_set_output_file_pos = new_pos;
+        updated                                             = TNG_TRUE;
     }
-    if (hash_mode == TNG_USE_HASH)
+    if (updated)
     {
-        md5_finish(&md5_state, (md5_byte_t*)block->md5_hash);
-        curr_file_pos = ftello(tng_data->output_file);
-        fseeko(tng_data->output_file, header_file_pos + 3 * sizeof(int64_t), SEEK_SET);
-        if (fwrite(block->md5_hash, TNG_MD5_HASH_LEN, 1, tng_data->output_file) != 1)
-        {
-            fprintf(stderr, "TNG library: Could not write MD5 hash. %s: %d\n", __FILE__, __LINE__);
-            return (TNG_CRITICAL);
-        }
-        fseeko(tng_data->output_file, curr_file_pos, SEEK_SET);
+        tng_header_pointers_update(tng_data, hash_mode);
     }
 
-    tng_block_destroy(&block);
+    /* Fill the block with NULL to avoid confusion. */
+    memset(contents, '\0', block_len);
+    fseeko(tng_data->output_file, block_start_pos, SEEK_SET);
+
+    /* FIXME: casting block_len to size_t is dangerous */
+    fwrite(contents, 1, block_len, tng_data->output_file);
+
+    free(contents);
 
     return (TNG_SUCCESS);
 }
 
-/**
- * @brief Read the chain data of a molecules block.
- * @param tng_data is a trajectory data container.
- * @param chain is the chain data container.
- * @param hash_mode is an option to decide whether to generate/update the relevant md5 hashes.
- * @param md5_state is a pointer to the current md5 storage, which will be updated appropriately
- * if hash_mode == TNG_USE_HASH.
- * @return TNG_SUCCESS(0) is successful.
- */
-static tng_function_status tng_chain_data_read(const struct tng_trajectory* tng_data,
-                                               struct tng_chain*            chain,
-                                               const char                   hash_mode,
-                                               md5_state_t*                 md5_state)
+static tng_function_status tng_length_of_current_frame_set_contents_get(struct tng_trajectory* tng_data,
+                                                                        int64_t*               len)
 {
-    if (tng_file_input_numerical(tng_data, &chain->id, sizeof(chain->id), hash_mode, md5_state, __LINE__)
-        == TNG_CRITICAL)
+    int64_t             orig_pos, pos, curr_frame_set_pos;
+    tng_gen_block_t     block;
+    tng_function_status stat;
+
+    orig_pos           = tng_input_file_tell(tng_data);
+    curr_frame_set_pos = pos = tng_data->current_trajectory_frame_set_input_file_pos;
+
+    *len = 0;
+
+    tng_input_file_seek(tng_data, curr_frame_set_pos, SEEK_SET);
+
+    tng_block_init(&block);
+    /* Read block headers first to see that a frame set block is found. */
+    stat = tng_block_header_read(tng_data, block);
+    if (stat == TNG_CRITICAL || block->id != TNG_TRAJECTORY_FRAME_SET)
     {
-        return (TNG_CRITICAL);
+        fprintf(stderr, "TNG library: Cannot read block header at pos %" PRId64 ". %s: %d\n",
+                curr_frame_set_pos, __FILE__, __LINE__);
+        tng_block_destroy(&block);
+        return (TNG_FAILURE);
     }
 
-    tng_freadstr(tng_data, &chain->name, hash_mode, md5_state, __LINE__);
-
-    if (tng_file_input_numerical(tng_data, &chain->n_residues, sizeof(chain->n_residues), hash_mode,
-                                 md5_state, __LINE__)
-        == TNG_CRITICAL)
+    /* Read the headers of all blocks in the frame set (not the actual contents of them) */
+    while (stat == TNG_SUCCESS)
     {
-        return (TNG_CRITICAL);
+        tng_input_file_seek(tng_data, block->block_contents_size, SEEK_CUR);
+        *len += block->header_contents_size + block->block_contents_size;
+        pos += block->header_contents_size + block->block_contents_size;
+        if (pos >= tng_data->input_file_len)
+        {
+            break;
+        }
+        stat = tng_block_header_read(tng_data, block);
+        if (block->id == TNG_TRAJECTORY_FRAME_SET)
+        {
+            break;
+        }
     }
 
+    /* Re-read the frame set that used to be the current one */
+    tng_reread_frame_set_at_file_pos(tng_data, curr_frame_set_pos);
+
+    tng_input_file_seek(tng_data, orig_pos, SEEK_SET);
+
+    tng_block_destroy(&block);
+
     return (TNG_SUCCESS);
 }
 
 /**
- * @brief Write the chain data of a molecules block.
+ * @brief Migrate blocks in the file to make room for new data in a block. This
+ * is required e.g. when adding data to a block or extending strings in a
+ * block.
  * @param tng_data is a trajectory data container.
- * @param chain is the chain data container.
+ * @param start_pos is the position from which to start moving data, usually
+ * the byte after the end of the block to which data was added.
+ * @param offset is the number of bytes that were inserted.
  * @param hash_mode is an option to decide whether to generate/update the relevant md5 hashes.
- * @param md5_state is a pointer to the current md5 storage, which will be updated appropriately
- * if hash_mode == TNG_USE_HASH.
- * @return TNG_SUCCESS(0) is successful.
+ * @details Trajectory blocks (frame sets and their related blocks) are moved
+ * to the end of the file (if needed) in order to make room for non-trajectory
+ * data.
  */
-static tng_function_status tng_chain_data_write(struct tng_trajectory*  tng_data,
-                                                const struct tng_chain* chain,
-                                                const char              hash_mode,
-                                                md5_state_t*            md5_state)
+static tng_function_status tng_migrate_data_in_file(struct tng_trajectory* tng_data,
+                                                    const int64_t          start_pos,
+                                                    const int64_t          offset,
+                                                    const char             hash_mode)
 {
-    if (tng_file_output_numerical(tng_data, &chain->id, sizeof(chain->id), hash_mode, md5_state, __LINE__)
-        == TNG_CRITICAL)
+    int64_t             traj_start_pos, empty_space, orig_file_pos, frame_set_length;
+    tng_gen_block_t     block;
+    tng_function_status stat;
+
+    if (offset <= 0)
     {
-        return (TNG_CRITICAL);
+        return (TNG_SUCCESS);
     }
 
-    if (tng_fwritestr(tng_data, chain->name, hash_mode, md5_state, __LINE__) == TNG_CRITICAL)
+    stat = tng_file_pos_of_subsequent_trajectory_block_get(tng_data, &traj_start_pos);
+    if (stat != TNG_SUCCESS)
     {
-        return (TNG_CRITICAL);
+        return (stat);
     }
 
-    if (tng_file_output_numerical(tng_data, &chain->n_residues, sizeof(chain->n_residues),
-                                  hash_mode, md5_state, __LINE__)
-        == TNG_CRITICAL)
+    tng_data->current_trajectory_frame_set_input_file_pos = traj_start_pos;
+
+    empty_space = traj_start_pos - (start_pos - 1);
+
+    if (empty_space >= offset)
     {
-        return (TNG_CRITICAL);
+        return (TNG_SUCCESS);
+    }
+
+    orig_file_pos = tng_input_file_tell(tng_data);
+    tng_block_init(&block);
+
+    while (empty_space < offset)
+    {
+        tng_input_file_seek(tng_data, traj_start_pos, SEEK_SET);
+        stat = tng_block_header_read(tng_data, block);
+        if (stat == TNG_CRITICAL)
+        {
+            fprintf(stderr, "TNG library: Cannot read block header. %s: %d\n", __FILE__, __LINE__);
+            tng_block_destroy(&block);
+            return (TNG_CRITICAL);
+        }
+        if (stat != TNG_SUCCESS || block->id != TNG_TRAJECTORY_FRAME_SET)
+        {
+            tng_block_destroy(&block);
+            return (TNG_FAILURE);
+        }
+        stat = tng_length_of_current_frame_set_contents_get(tng_data, &frame_set_length);
+        if (stat != TNG_SUCCESS)
+        {
+            tng_block_destroy(&block);
+            return (stat);
+        }
+        stat = tng_frame_set_complete_migrate(tng_data, traj_start_pos, frame_set_length,
+                                              tng_data->input_file_len, hash_mode);
+        if (stat != TNG_SUCCESS)
+        {
+            tng_block_destroy(&block);
+            return (stat);
+        }
+
+        empty_space += frame_set_length;
     }
+    tng_input_file_seek(tng_data, orig_file_pos, SEEK_SET);
+    tng_block_destroy(&block);
 
     return (TNG_SUCCESS);
 }
 
-/**
- * @brief Read the residue data of a molecules block.
- * @param tng_data is a trajectory data container.
- * @param residue is the residue data container.
- * @param hash_mode is an option to decide whether to generate/update the relevant md5 hashes.
- * @param md5_state is a pointer to the current md5 storage, which will be updated appropriately
- * if hash_mode == TNG_USE_HASH.
- * @return TNG_SUCCESS(0) is successful.
- */
-static tng_function_status tng_residue_data_read(const struct tng_trajectory* tng_data,
-                                                 struct tng_residue*          residue,
-                                                 const char                   hash_mode,
-                                                 md5_state_t*                 md5_state)
+static tng_function_status tng_block_header_len_calculate(const struct tng_trajectory* tng_data,
+                                                          struct tng_gen_block*        block,
+                                                          int64_t*                     len)
 {
-    if (tng_file_input_numerical(tng_data, &residue->id, sizeof(residue->id), hash_mode, md5_state, __LINE__)
-        == TNG_CRITICAL)
+    int   name_len;
+    char* temp_hash;
+
+    /* If the string is unallocated allocate memory for just string
+     * termination */
+    if (!block->name)
     {
-        return (TNG_CRITICAL);
+        block->name = (char*)malloc(1);
+        if (!block->name)
+        {
+            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+            return (TNG_CRITICAL);
+        }
+        block->name[0] = 0;
     }
 
-    tng_freadstr(tng_data, &residue->name, hash_mode, md5_state, __LINE__);
+    name_len = tng_min_size(strlen(block->name) + 1, TNG_MAX_STR_LEN);
 
-    if (tng_file_input_numerical(tng_data, &residue->n_atoms, sizeof(residue->n_atoms), hash_mode,
-                                 md5_state, __LINE__)
-        == TNG_CRITICAL)
+    /* Calculate the size of the header to write */
+    *len = sizeof(block->header_contents_size) + sizeof(block->block_contents_size)
+           + sizeof(block->id) + sizeof(block->block_version) + TNG_MD5_HASH_LEN + name_len;
+
+    /* Blocks hashed with another hash than MD5 store that hash after the
+     * block version, leaving the MD5 hash empty. */
+    if (tng_data->output_hash_type == TNG_XXH64)
     {
-        return (TNG_CRITICAL);
+        if (block->alt_hash_len != TNG_XXH64_HASH_LEN)
+        {
+            temp_hash = (char*)realloc(block->alt_hash, TNG_XXH64_HASH_LEN);
+            if (!temp_hash)
+            {
+                fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+                return (TNG_CRITICAL);
+            }
+            block->alt_hash = temp_hash;
+        }
+        block->alt_hash_type = TNG_XXH64;
+        block->alt_hash_len  = TNG_XXH64_HASH_LEN;
+        memset(block->alt_hash, '\0', block->alt_hash_len);
+        *len += sizeof(block->alt_hash_type) + sizeof(block->alt_hash_len) + block->alt_hash_len;
+    }
+    else
+    {
+        block->alt_hash_type = TNG_NO_HASH;
     }
 
     return (TNG_SUCCESS);
 }
 
 /**
- * @brief Write the residue data of a molecules block.
+ * @brief Write the header of a data block, regardless of its type
  * @param tng_data is a trajectory data container.
- * @param residue is the residue data container.
- * @param hash_mode is an option to decide whether to generate/update the relevant md5 hashes.
- * @param md5_state is a pointer to the current md5 storage, which will be updated appropriately
- * if hash_mode == TNG_USE_HASH.
- * @return TNG_SUCCESS(0) is successful.
+ * @param block is a general block container.
+ * @param hash_mode is an option to decide whether to use the md5 hash or not.
+ * If hash_mode == TNG_USE_HASH an md5 hash will be generated and written.
+ * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
+ * error has occured.
  */
-static tng_function_status tng_residue_data_write(struct tng_trajectory*    tng_data,
-                                                  const struct tng_residue* residue,
-                                                  const char                hash_mode,
-                                                  md5_state_t*              md5_state)
+static tng_function_status tng_block_header_write(struct tng_trajectory* tng_data, struct tng_gen_block* block)
 {
-    if (tng_file_output_numerical(tng_data, &residue->id, sizeof(residue->id), hash_mode, md5_state, __LINE__)
-        == TNG_CRITICAL)
+    TNG_ASSERT(block != 0, "TNG library: Trying to write uninitialized block (NULL pointer).");
+
+    if (tng_output_file_init(tng_data) != TNG_SUCCESS)
     {
+        fprintf(stderr, "TNG library: Cannot initialise destination file. %s: %d\n", __FILE__, __LINE__);
         return (TNG_CRITICAL);
     }
 
-    if (tng_fwritestr(tng_data, residue->name, hash_mode, md5_state, __LINE__) == TNG_CRITICAL)
+    if (tng_block_header_len_calculate(tng_data, block, &block->header_contents_size) != TNG_SUCCESS)
     {
+        fprintf(stderr, "TNG library: Cannot calculate length of block header. %s: %d\n", __FILE__, __LINE__);
         return (TNG_CRITICAL);
     }
 
-    if (tng_file_output_numerical(tng_data, &residue->n_atoms, sizeof(residue->n_atoms), hash_mode,
-                                  md5_state, __LINE__)
+    if (tng_file_output_numerical(tng_data, &block->header_contents_size,
+                                  sizeof(block->header_contents_size), TNG_SKIP_HASH, 0, __LINE__)
         == TNG_CRITICAL)
     {
         return (TNG_CRITICAL);
     }
 
-    return (TNG_SUCCESS);
-}
-
-/**
- * @brief Read the atom data of a molecules block.
- * @param tng_data is a trajectory data container.
- * @param atom is the atom data container.
- * @param hash_mode is an option to decide whether to generate/update the relevant md5 hashes.
- * @param md5_state is a pointer to the current md5 storage, which will be updated appropriately
- * if hash_mode == TNG_USE_HASH.
- * @return TNG_SUCCESS(0) is successful.
- */
-static tng_function_status tng_atom_data_read(const struct tng_trajectory* tng_data,
-                                              struct tng_atom*             atom,
-                                              const char                   hash_mode,
-                                              md5_state_t*                 md5_state)
-{
-    if (tng_file_input_numerical(tng_data, &atom->id, sizeof(atom->id), hash_mode, md5_state, __LINE__)
+    if (tng_file_output_numerical(tng_data, &block->block_contents_size,
+                                  sizeof(block->block_contents_size), TNG_SKIP_HASH, 0, __LINE__)
         == TNG_CRITICAL)
     {
         return (TNG_CRITICAL);
     }
 
-    tng_freadstr(tng_data, &atom->name, hash_mode, md5_state, __LINE__);
-
-    tng_freadstr(tng_data, &atom->atom_type, hash_mode, md5_state, __LINE__);
-
-    return (TNG_SUCCESS);
-}
-
-/**
- * @brief Write the atom data of a molecules block.
- * @param tng_data is a trajectory data container.
- * @param atom is the atom data container.
- * @param hash_mode is an option to decide whether to generate/update the relevant md5 hashes.
- * @param md5_state is a pointer to the current md5 storage, which will be updated appropriately
- * if hash_mode == TNG_USE_HASH.
- * @return TNG_SUCCESS(0) is successful.
- */
-static tng_function_status tng_atom_data_write(struct tng_trajectory* tng_data,
-                                               const struct tng_atom* atom,
-                                               const char             hash_mode,
-                                               md5_state_t*           md5_state)
-{
-    if (tng_file_output_numerical(tng_data, &atom->id, sizeof(atom->id), hash_mode, md5_state, __LINE__)
+    if (tng_file_output_numerical(tng_data, &block->id, sizeof(block->id), TNG_SKIP_HASH, 0, __LINE__)
         == TNG_CRITICAL)
     {
         return (TNG_CRITICAL);
     }
 
-    if (tng_fwritestr(tng_data, atom->name, hash_mode, md5_state, __LINE__) == TNG_CRITICAL)
+    if (fwrite(block->md5_hash, TNG_MD5_HASH_LEN, 1, tng_data->output_file) != 1)
     {
+        fprintf(stderr, "TNG library: Could not write header data. %s: %d\n", __FILE__, __LINE__);
         return (TNG_CRITICAL);
     }
 
-    if (tng_fwritestr(tng_data, atom->atom_type, hash_mode, md5_state, __LINE__) == TNG_CRITICAL)
+    if (tng_fwritestr(tng_data, block->name, TNG_SKIP_HASH, 0, __LINE__) == TNG_CRITICAL)
     {
         return (TNG_CRITICAL);
     }
 
-    return (TNG_SUCCESS);
-}
+    if (tng_file_output_numerical(tng_data, &block->block_version, sizeof(block->block_version),
+                                  TNG_SKIP_HASH, 0, __LINE__)
+        == TNG_CRITICAL)
+    {
+        return (TNG_CRITICAL);
+    }
 
-static tng_function_status tng_molecules_block_len_calculate(const struct tng_trajectory* tng_data,
-                                                             int64_t*                     len)
-{
-    int64_t        i, j;
-    tng_molecule_t molecule;
-    tng_chain_t    chain;
-    tng_residue_t  residue;
-    tng_atom_t     atom;
-    tng_bond_t     bond;
-
-    *len = 0;
-
-    for (i = 0; i < tng_data->n_molecules; i++)
+    if (block->alt_hash_type != TNG_NO_HASH)
     {
-        molecule = &tng_data->molecules[i];
-        if (!molecule->name)
+        if (tng_file_output_numerical(tng_data, &block->alt_hash_type, sizeof(block->alt_hash_type),
+                                      TNG_SKIP_HASH, 0, __LINE__)
+            == TNG_CRITICAL)
         {
-            molecule->name = (char*)malloc(1);
-            if (!molecule->name)
-            {
-                fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
-                return (TNG_CRITICAL);
-            }
-            molecule->name[0] = 0;
+            return (TNG_CRITICAL);
         }
-        *len += tng_min_size(strlen(molecule->name) + 1, TNG_MAX_STR_LEN);
-
-        chain = molecule->chains;
-        for (j = 0; j < molecule->n_chains; j++)
+        if (tng_file_output_numerical(tng_data, &block->alt_hash_len, sizeof(block->alt_hash_len),
+                                      TNG_SKIP_HASH, 0, __LINE__)
+            == TNG_CRITICAL)
         {
-            *len += sizeof(chain->id);
-
-            if (!chain->name)
-            {
-                chain->name = (char*)malloc(1);
-                if (!chain->name)
-                {
-                    fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
-                    return (TNG_CRITICAL);
-                }
-                chain->name[0] = 0;
-            }
-            *len += tng_min_size(strlen(chain->name) + 1, TNG_MAX_STR_LEN);
-
-            *len += sizeof(chain->n_residues);
-
-            chain++;
+            return (TNG_CRITICAL);
         }
-
-        residue = molecule->residues;
-        for (j = 0; j < molecule->n_residues; j++)
+        if (fwrite(block->alt_hash, block->alt_hash_len, 1, tng_data->output_file) != 1)
         {
-            *len += sizeof(residue->id);
+            fprintf(stderr, "TNG library: Could not write header data. %s: %d\n", __FILE__, __LINE__);
+            return (TNG_CRITICAL);
+        }
+    }
 
-            if (!residue->name)
-            {
-                residue->name = (char*)malloc(1);
-                if (!residue->name)
-                {
-                    fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
-                    return (TNG_CRITICAL);
-                }
-                residue->name[0] = 0;
-            }
-            *len += tng_min_size(strlen(residue->name) + 1, TNG_MAX_STR_LEN);
+    return (TNG_SUCCESS);
+}
 
-            *len += sizeof(residue->n_atoms);
+static tng_function_status tng_general_info_block_len_calculate(struct tng_trajectory* tng_data, int64_t* len)
+{
+    size_t first_program_name_len, first_user_name_len;
+    size_t first_computer_name_len, first_pgp_signature_len;
+    size_t last_program_name_len, last_user_name_len;
+    size_t last_computer_name_len, last_pgp_signature_len;
+    size_t forcefield_name_len;
 
-            residue++;
+    /* If the strings are unallocated allocate memory for just string
+     * termination */
+    if (!tng_data->first_program_name)
+    {
+        tng_data->first_program_name = (char*)malloc(1);
+        if (!tng_data->first_program_name)
+        {
+            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+            return (TNG_CRITICAL);
         }
-
-        atom = molecule->atoms;
-        for (j = 0; j < molecule->n_atoms; j++)
+        tng_data->first_program_name[0] = 0;
+    }
+    if (!tng_data->last_program_name)
+    {
+        tng_data->last_program_name = (char*)malloc(1);
+        if (!tng_data->last_program_name)
         {
-            *len += sizeof(atom->id);
-            if (!atom->name)
-            {
-                atom->name = (char*)malloc(1);
-                if (!atom->name)
-                {
-                    fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
-                    return (TNG_CRITICAL);
-                }
-                atom->name[0] = 0;
-            }
-            *len += tng_min_size(strlen(atom->name) + 1, TNG_MAX_STR_LEN);
-
-            if (!atom->atom_type)
-            {
-                atom->atom_type = (char*)malloc(1);
-                if (!atom->atom_type)
-                {
-                    fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
-                    return (TNG_CRITICAL);
-                }
-                atom->atom_type[0] = 0;
-            }
-            *len += tng_min_size(strlen(atom->atom_type) + 1, TNG_MAX_STR_LEN);
-
-            atom++;
+            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+            return (TNG_CRITICAL);
         }
-
-        for (j = 0; j < molecule->n_bonds; j++)
+        tng_data->last_program_name[0] = 0;
+    }
+    if (!tng_data->first_user_name)
+    {
+        tng_data->first_user_name = (char*)malloc(1);
+        if (!tng_data->first_user_name)
         {
-            *len += sizeof(bond->from_atom_id) + sizeof(bond->to_atom_id);
+            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+            return (TNG_CRITICAL);
+        }
+        tng_data->first_user_name[0] = 0;
+    }
+    if (!tng_data->last_user_name)
+    {
+        tng_data->last_user_name = (char*)malloc(1);
+        if (!tng_data->last_user_name)
+        {
+            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+            return (TNG_CRITICAL);
         }
+        tng_data->last_user_name[0] = 0;
     }
-    *len += sizeof(tng_data->n_molecules)
-            + (sizeof(molecule->id) + sizeof(molecule->quaternary_str) + sizeof(molecule->n_chains)
-               + sizeof(molecule->n_residues) + sizeof(molecule->n_atoms) + sizeof(molecule->n_bonds))
-                      * tng_data->n_molecules;
-
-    if (!tng_data->var_num_atoms_flag)
+    if (!tng_data->first_computer_name)
     {
-        *len += tng_data->n_molecules * sizeof(int64_t);
+        tng_data->first_computer_name = (char*)malloc(1);
+        if (!tng_data->first_computer_name)
+        {
+            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+            return (TNG_CRITICAL);
+        }
+        tng_data->first_computer_name[0] = 0;
+    }
+    if (!tng_data->last_computer_name)
+    {
+        tng_data->last_computer_name = (char*)malloc(1);
+        if (!tng_data->last_computer_name)
+        {
+            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+            return (TNG_CRITICAL);
+        }
+        tng_data->last_computer_name[0] = 0;
+    }
+    if (!tng_data->first_pgp_signature)
+    {
+        tng_data->first_pgp_signature = (char*)malloc(1);
+        if (!tng_data->first_pgp_signature)
+        {
+            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+            return (TNG_CRITICAL);
+        }
+        tng_data->first_pgp_signature[0] = 0;
+    }
+    if (!tng_data->last_pgp_signature)
+    {
+        tng_data->last_pgp_signature = (char*)malloc(1);
+        if (!tng_data->last_pgp_signature)
+        {
+            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+            return (TNG_CRITICAL);
+        }
+        tng_data->last_pgp_signature[0] = 0;
+    }
+    if (!tng_data->forcefield_name)
+    {
+        tng_data->forcefield_name = (char*)malloc(1);
+        if (!tng_data->forcefield_name)
+        {
+            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+            return (TNG_CRITICAL);
+        }
+        tng_data->forcefield_name[0] = 0;
     }
 
+    first_program_name_len = tng_min_size(strlen(tng_data->first_program_name) + 1, TNG_MAX_STR_LEN);
+    last_program_name_len  = tng_min_size(strlen(tng_data->last_program_name) + 1, TNG_MAX_STR_LEN);
+    first_user_name_len    = tng_min_size(strlen(tng_data->first_user_name) + 1, TNG_MAX_STR_LEN);
+    last_user_name_len     = tng_min_size(strlen(tng_data->last_user_name) + 1, TNG_MAX_STR_LEN);
+    first_computer_name_len = tng_min_size(strlen(tng_data->first_computer_name) + 1, TNG_MAX_STR_LEN);
+    last_computer_name_len = tng_min_size(strlen(tng_data->last_computer_name) + 1, TNG_MAX_STR_LEN);
+    first_pgp_signature_len = tng_min_size(strlen(tng_data->first_pgp_signature) + 1, TNG_MAX_STR_LEN);
+    last_pgp_signature_len = tng_min_size(strlen(tng_data->last_pgp_signature) + 1, TNG_MAX_STR_LEN);
+    forcefield_name_len    = tng_min_size(strlen(tng_data->forcefield_name) + 1, TNG_MAX_STR_LEN);
+
+    *len = sizeof(tng_data->time) + sizeof(tng_data->var_num_atoms_flag)
+           + sizeof(tng_data->frame_set_n_frames)
+           + sizeof(tng_data->first_trajectory_frame_set_input_file_pos)
+           + sizeof(tng_data->last_trajectory_frame_set_input_file_pos)
+           + sizeof(tng_data->medium_stride_length) + sizeof(tng_data->long_stride_length)
+           + sizeof(tng_data->distance_unit_exponential) + first_program_name_len + last_program_name_len
+           + first_user_name_len + last_user_name_len + first_computer_name_len + last_computer_name_len
+           + first_pgp_signature_len + last_pgp_signature_len + forcefield_name_len;
+
     return (TNG_SUCCESS);
 }
 
 /**
- * @brief Read a molecules block. Contains chain, residue and atom data
+ * @brief Read a general info block. This is the first block of a TNG file.
+ * Populate the fields in tng_data.
  * @param tng_data is a trajectory data container.
  * @param block is a general block container.
  * @param hash_mode is an option to decide whether to use the md5 hash or not.
@@ -2763,610 +3510,634 @@ static tng_function_status tng_molecules_block_len_calculate(const struct tng_tr
  * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
  * error has occured.
  */
-static tng_function_status tng_molecules_block_read(struct tng_trajectory*      tng_data,
-                                                    const struct tng_gen_block* block,
-                                                    const char                  hash_mode)
+static tng_function_status tng_general_info_block_read(struct tng_trajectory*      tng_data,
+                                                       const struct tng_gen_block* block,
+                                                       const char                  hash_mode)
 {
-    int64_t        start_pos, i, j, k, l;
-    tng_molecule_t molecule;
-    tng_chain_t    chain;
-    tng_residue_t  residue;
-    tng_atom_t     atom;
-    tng_bond_t     bond;
-    char           hash[TNG_MD5_HASH_LEN];
-    md5_state_t    md5_state;
+    int64_t               start_pos, prev_last_frame_set_pos;
+    struct tng_hash_state hash_state;
+
+    TNG_ASSERT(block != 0,
+               "TNG library: Trying to read data to an uninitialized block (NULL pointer)");
 
     if (tng_input_file_init(tng_data) != TNG_SUCCESS)
     {
         return (TNG_CRITICAL);
     }
 
-    start_pos = ftello(tng_data->input_file);
-
-    /* FIXME: Does not check if the size of the contents matches the expected
-     * size or if the contents can be read. */
-
-    if (tng_data->molecules)
-    {
-        for (i = 0; i < tng_data->n_molecules; i++)
-        {
-            tng_molecule_destroy(tng_data, &tng_data->molecules[i]);
-        }
-        free(tng_data->molecules);
-        tng_data->molecules   = 0;
-        tng_data->n_molecules = 0;
-    }
+    start_pos = tng_input_file_tell(tng_data);
 
     if (hash_mode == TNG_USE_HASH)
     {
-        md5_init(&md5_state);
+        tng_block_hash_init(block, &hash_state);
     }
 
-    if (tng_file_input_numerical(tng_data, &tng_data->n_molecules, sizeof(tng_data->n_molecules),
-                                 hash_mode, &md5_state, __LINE__)
+    tng_freadstr(tng_data, &tng_data->first_program_name, hash_mode, &hash_state, __LINE__);
+
+    tng_freadstr(tng_data, &tng_data->last_program_name, hash_mode, &hash_state, __LINE__);
+
+    tng_freadstr(tng_data, &tng_data->first_user_name, hash_mode, &hash_state, __LINE__);
+
+    tng_freadstr(tng_data, &tng_data->last_user_name, hash_mode, &hash_state, __LINE__);
+
+    tng_freadstr(tng_data, &tng_data->first_computer_name, hash_mode, &hash_state, __LINE__);
+
+    tng_freadstr(tng_data, &tng_data->last_computer_name, hash_mode, &hash_state, __LINE__);
+
+    tng_freadstr(tng_data, &tng_data->first_pgp_signature, hash_mode, &hash_state, __LINE__);
+
+    tng_freadstr(tng_data, &tng_data->last_pgp_signature, hash_mode, &hash_state, __LINE__);
+
+    tng_freadstr(tng_data, &tng_data->forcefield_name, hash_mode, &hash_state, __LINE__);
+
+    if (tng_file_input_numerical(tng_data, &tng_data->time, sizeof(tng_data->time), hash_mode,
+                                 &hash_state, __LINE__)
         == TNG_CRITICAL)
     {
         return (TNG_CRITICAL);
     }
 
-    if (tng_data->molecules)
-    {
-        free(tng_data->molecules);
+
+    if (tng_file_input_numerical(tng_data, &tng_data->var_num_atoms_flag,
+                                 sizeof(tng_data->var_num_atoms_flag), hash_mode, &hash_state, __LINE__)
+        == TNG_CRITICAL)
+    {
+        return (TNG_CRITICAL);
     }
 
-    tng_data->n_particles = 0;
+    if (tng_file_input_numerical(tng_data, &tng_data->frame_set_n_frames,
+                                 sizeof(tng_data->frame_set_n_frames), hash_mode, &hash_state, __LINE__)
+        == TNG_CRITICAL)
+    {
+        return (TNG_CRITICAL);
+    }
 
-    tng_data->molecules =
-            (struct tng_molecule*)malloc(tng_data->n_molecules * sizeof(struct tng_molecule));
-    if (!tng_data->molecules)
+    if (tng_file_input_numerical(tng_data, &tng_data->first_trajectory_frame_set_input_file_pos,
+                                 sizeof(tng_data->first_trajectory_frame_set_input_file_pos),
+                                 hash_mode, &hash_state, __LINE__)
+        == TNG_CRITICAL)
     {
-        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
         return (TNG_CRITICAL);
     }
 
-    if (!tng_data->var_num_atoms_flag)
+    tng_data->current_trajectory_frame_set.next_frame_set_file_pos =
+            tng_data->first_trajectory_frame_set_input_file_pos;
+
+    prev_last_frame_set_pos = tng_data->last_trajectory_frame_set_input_file_pos;
+
+    if (tng_file_input_numerical(tng_data, &tng_data->last_trajectory_frame_set_input_file_pos,
+                                 sizeof(tng_data->last_trajectory_frame_set_input_file_pos),
+                                 hash_mode, &hash_state, __LINE__)
+        == TNG_CRITICAL)
     {
-        if (tng_data->molecule_cnt_list)
-        {
-            free(tng_data->molecule_cnt_list);
-        }
-        tng_data->molecule_cnt_list = (int64_t*)malloc(sizeof(int64_t) * tng_data->n_molecules);
-        if (!tng_data->molecule_cnt_list)
-        {
-            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
-            return (TNG_CRITICAL);
-        }
+        return (TNG_CRITICAL);
     }
 
-    /* Read each molecule from file */
-    for (i = 0; i < tng_data->n_molecules; i++)
+    /* Frame sets have been added since the file was last read. */
+    if (tng_data->last_trajectory_frame_set_input_file_pos != prev_last_frame_set_pos)
     {
-        molecule = &tng_data->molecules[i];
+        tng_data->n_input_frame_sets = -1;
+        tng_data->n_input_frames     = -1;
+    }
 
-        molecule->name = 0;
+    if (tng_file_input_numerical(tng_data, &tng_data->medium_stride_length,
+                                 sizeof(tng_data->medium_stride_length), hash_mode, &hash_state, __LINE__)
+        == TNG_CRITICAL)
+    {
+        return (TNG_CRITICAL);
+    }
 
-        if (tng_file_input_numerical(tng_data, &molecule->id, sizeof(molecule->id), hash_mode,
-                                     &md5_state, __LINE__)
+    if (tng_file_input_numerical(tng_data, &tng_data->long_stride_length,
+                                 sizeof(tng_data->long_stride_length), hash_mode, &hash_state, __LINE__)
+        == TNG_CRITICAL)
+    {
+        return (TNG_CRITICAL);
+    }
+
+    if (block->block_version >= 3)
+    {
+        if (tng_file_input_numerical(tng_data, &tng_data->distance_unit_exponential,
+                                     sizeof(tng_data->distance_unit_exponential), hash_mode,
+                                     &hash_state, __LINE__)
             == TNG_CRITICAL)
         {
             return (TNG_CRITICAL);
         }
+    }
 
-        /*         fprintf(stderr, "TNG library: Read id: %" PRId64 " offset: %d\n", molecule->id, offset);*/
-        tng_freadstr(tng_data, &molecule->name, hash_mode, &md5_state, __LINE__);
+    if (hash_mode == TNG_USE_HASH)
+    {
+        /* If there is data left in the block that the current version of the library
+         * cannot interpret still read that to generate the MD5 hash. */
+        tng_hash_remaining_append(tng_data, block, start_pos, &hash_state);
 
-        if (tng_file_input_numerical(tng_data, &molecule->quaternary_str,
-                                     sizeof(molecule->quaternary_str), hash_mode, &md5_state, __LINE__)
-            == TNG_CRITICAL)
+        if (tng_block_hash_match_verify(block, &hash_state) != TNG_SUCCESS)
         {
-            return (TNG_CRITICAL);
+            fprintf(stderr,
+                    "TNG library: General info block contents corrupt. Hashes do not match. "
+                    "%s: %d\n",
+                    __FILE__, __LINE__);
         }
+    }
+    else
+    {
+        /* Seek to the end of the block */
+        tng_input_file_seek(tng_data, start_pos + block->block_contents_size, SEEK_SET);
+    }
 
-        if (!tng_data->var_num_atoms_flag)
-        {
-            if (tng_file_input_numerical(tng_data, &tng_data->molecule_cnt_list[i], sizeof(int64_t),
-                                         hash_mode, &md5_state, __LINE__)
-                == TNG_CRITICAL)
-            {
-                return (TNG_CRITICAL);
-            }
-        }
+    return (TNG_SUCCESS);
+}
 
-        if (tng_file_input_numerical(tng_data, &molecule->n_chains, sizeof(molecule->n_chains),
-                                     hash_mode, &md5_state, __LINE__)
-            == TNG_CRITICAL)
-        {
-            return (TNG_CRITICAL);
-        }
+/**
+ * @brief Write a general info block. This is the first block of a TNG file.
+ * @param tng_data is a trajectory data container.
+ * @param hash_mode is an option to decide whether to use the md5 hash or not.
+ * If hash_mode == TNG_USE_HASH an md5 hash will be generated and written.
+ * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
+ * error has occured.
+ */
+static tng_function_status tng_general_info_block_write(struct tng_trajectory* tng_data, const char hash_mode)
+{
+    int64_t               header_file_pos;
+    size_t                name_len;
+    tng_gen_block_t       block;
+    struct tng_hash_state hash_state;
 
-        if (tng_file_input_numerical(tng_data, &molecule->n_residues, sizeof(molecule->n_residues),
-                                     hash_mode, &md5_state, __LINE__)
-            == TNG_CRITICAL)
-        {
-            return (TNG_CRITICAL);
-        }
+    if (tng_output_file_init(tng_data) != TNG_SUCCESS)
+    {
+        return (TNG_CRITICAL);
+    }
 
-        if (tng_file_input_numerical(tng_data, &molecule->n_atoms, sizeof(molecule->n_atoms),
-                                     hash_mode, &md5_state, __LINE__)
-            == TNG_CRITICAL)
-        {
-            return (TNG_CRITICAL);
-        }
+    fseeko(tng_data->output_file, 0, SEEK_SET);
 
-        tng_data->n_particles += molecule->n_atoms * tng_data->molecule_cnt_list[i];
+    tng_block_init(&block);
 
-        if (molecule->n_chains > 0)
-        {
-            molecule->chains = (struct tng_chain*)malloc(molecule->n_chains * sizeof(struct tng_chain));
-            if (!molecule->chains)
-            {
-                fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
-                return (TNG_CRITICAL);
-            }
+    name_len = strlen("GENERAL INFO");
 
-            chain = molecule->chains;
-        }
-        else
-        {
-            chain = 0;
-        }
+    block->name = (char*)malloc(name_len + 1);
+    if (!block->name)
+    {
+        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+        tng_block_destroy(&block);
+        return (TNG_CRITICAL);
+    }
 
-        if (molecule->n_residues > 0)
-        {
-            molecule->residues =
-                    (struct tng_residue*)malloc(molecule->n_residues * sizeof(struct tng_residue));
-            if (!molecule->residues)
-            {
-                fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
-                if (molecule->chains)
-                {
-                    free(molecule->chains);
-                    molecule->chains = 0;
-                }
-                return (TNG_CRITICAL);
-            }
+    strcpy(block->name, "GENERAL INFO");
+    block->id = TNG_GENERAL_INFO;
 
-            residue = molecule->residues;
-        }
-        else
-        {
-            residue = 0;
-        }
+    if (tng_general_info_block_len_calculate(tng_data, &block->block_contents_size) != TNG_SUCCESS)
+    {
+        fprintf(stderr, "TNG library: Cannot calculate length of general info block. %s: %d\n",
+                __FILE__, __LINE__);
+        tng_block_destroy(&block);
+        return (TNG_CRITICAL);
+    }
 
-        molecule->atoms = (struct tng_atom*)malloc(molecule->n_atoms * sizeof(struct tng_atom));
-        if (!molecule->atoms)
-        {
-            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
-            if (molecule->chains)
-            {
-                free(molecule->chains);
-                molecule->chains = 0;
-            }
-            if (molecule->residues)
-            {
-                free(molecule->residues);
-                molecule->residues = 0;
-            }
-            return (TNG_CRITICAL);
-        }
+    header_file_pos = 0;
 
-        atom = molecule->atoms;
+    if (tng_block_header_write(tng_data, block) != TNG_SUCCESS)
+    {
+        fprintf(stderr, "TNG library: Cannot write header of file %s. %s: %d\n",
+                tng_data->output_file_path, __FILE__, __LINE__);
+        tng_block_destroy(&block);
+        return (TNG_CRITICAL);
+    }
 
-        if (molecule->n_chains > 0)
-        {
-            /* Read the chains of the molecule */
-            for (j = 0; j < molecule->n_chains; j++)
-            {
-                chain->molecule = molecule;
+    if (hash_mode == TNG_USE_HASH)
+    {
+        tng_block_hash_init(block, &hash_state);
+    }
 
-                chain->name = 0;
+    if (tng_fwritestr(tng_data, tng_data->first_program_name, hash_mode, &hash_state, __LINE__) == TNG_CRITICAL)
+    {
+        return (TNG_CRITICAL);
+    }
 
-                tng_chain_data_read(tng_data, chain, hash_mode, &md5_state);
+    if (tng_fwritestr(tng_data, tng_data->last_program_name, hash_mode, &hash_state, __LINE__) == TNG_CRITICAL)
+    {
+        return (TNG_CRITICAL);
+    }
 
-                if (j == 0)
-                {
-                    chain->residues = molecule->residues;
-                    residue         = chain->residues;
-                }
-                else
-                {
-                    chain->residues = residue;
-                }
+    if (tng_fwritestr(tng_data, tng_data->first_user_name, hash_mode, &hash_state, __LINE__) == TNG_CRITICAL)
+    {
+        return (TNG_CRITICAL);
+    }
 
-                /* Read the residues of the chain */
-                for (k = 0; k < chain->n_residues; k++)
-                {
-                    residue->chain = chain;
+    if (tng_fwritestr(tng_data, tng_data->last_user_name, hash_mode, &hash_state, __LINE__) == TNG_CRITICAL)
+    {
+        return (TNG_CRITICAL);
+    }
 
-                    residue->name = 0;
+    if (tng_fwritestr(tng_data, tng_data->first_computer_name, hash_mode, &hash_state, __LINE__) == TNG_CRITICAL)
+    {
+        return (TNG_CRITICAL);
+    }
 
-                    tng_residue_data_read(tng_data, residue, hash_mode, &md5_state);
+    if (tng_fwritestr(tng_data, tng_data->last_computer_name, hash_mode, &hash_state, __LINE__) == TNG_CRITICAL)
+    {
+        return (TNG_CRITICAL);
+    }
 
-                    residue->atoms_offset = atom - molecule->atoms;
-                    /* Read the atoms of the residue */
-                    for (l = 0; l < residue->n_atoms; l++)
-                    {
-                        atom->residue = residue;
+    if (tng_fwritestr(tng_data, tng_data->first_pgp_signature, hash_mode, &hash_state, __LINE__) == TNG_CRITICAL)
+    {
+        return (TNG_CRITICAL);
+    }
 
-                        atom->name      = 0;
-                        atom->atom_type = 0;
+    if (tng_fwritestr(tng_data, tng_data->last_pgp_signature, hash_mode, &hash_state, __LINE__) == TNG_CRITICAL)
+    {
+        return (TNG_CRITICAL);
+    }
 
-                        tng_atom_data_read(tng_data, atom, hash_mode, &md5_state);
+    if (tng_fwritestr(tng_data, tng_data->forcefield_name, hash_mode, &hash_state, __LINE__) == TNG_CRITICAL)
+    {
+        return (TNG_CRITICAL);
+    }
 
-                        atom++;
-                    }
-                    residue++;
-                }
-                chain++;
-            }
-        }
-        else
-        {
-            if (molecule->n_residues > 0)
-            {
-                for (k = 0; k < molecule->n_residues; k++)
-                {
-                    residue->chain = 0;
-
-                    residue->name = 0;
-
-                    tng_residue_data_read(tng_data, residue, hash_mode, &md5_state);
-
-                    residue->atoms_offset = atom - molecule->atoms;
-                    /* Read the atoms of the residue */
-                    for (l = 0; l < residue->n_atoms; l++)
-                    {
-                        atom->residue = residue;
 
-                        tng_atom_data_read(tng_data, atom, hash_mode, &md5_state);
-
-                        atom++;
-                    }
-                    residue++;
-                }
-            }
-            else
-            {
-                for (l = 0; l < molecule->n_atoms; l++)
-                {
-                    atom->residue = 0;
+    if (tng_file_output_numerical(tng_data, &tng_data->time, sizeof(tng_data->time), hash_mode,
+                                  &hash_state, __LINE__)
+        == TNG_CRITICAL)
+    {
+        return (TNG_CRITICAL);
+    }
 
-                    atom->name      = 0;
-                    atom->atom_type = 0;
+    if (tng_file_output_numerical(tng_data, &tng_data->var_num_atoms_flag,
+                                  sizeof(tng_data->var_num_atoms_flag), hash_mode, &hash_state, __LINE__)
+        == TNG_CRITICAL)
+    {
+        return (TNG_CRITICAL);
+    }
 
-                    tng_atom_data_read(tng_data, atom, hash_mode, &md5_state);
+    if (tng_file_output_numerical(tng_data, &tng_data->frame_set_n_frames,
+                                  sizeof(tng_data->frame_set_n_frames), hash_mode, &hash_state, __LINE__)
+        == TNG_CRITICAL)
+    {
+        return (TNG_CRITICAL);
+    }
 
-                    atom++;
-                }
-            }
-        }
+    if (tng_file_output_numerical(tng_data, &tng_data->first_trajectory_frame_set_output_file_pos,
+                                  sizeof(tng_data->first_trajectory_frame_set_output_file_pos),
+                                  hash_mode, &hash_state, __LINE__)
+        == TNG_CRITICAL)
+    {
+        return (TNG_CRITICAL);
+    }
 
-        if (tng_file_input_numerical(tng_data, &molecule->n_bonds, sizeof(molecule->n_bonds),
-                                     hash_mode, &md5_state, __LINE__)
-            == TNG_CRITICAL)
-        {
-            return (TNG_CRITICAL);
-        }
+    if (tng_file_output_numerical(tng_data, &tng_data->last_trajectory_frame_set_output_file_pos,
+                                  sizeof(tng_data->last_trajectory_frame_set_output_file_pos),
+                                  hash_mode, &hash_state, __LINE__)
+        == TNG_CRITICAL)
+    {
+        return (TNG_CRITICAL);
+    }
 
-        if (molecule->n_bonds > 0)
-        {
-            tng_data->molecules[i].bonds =
-                    (struct tng_bond*)malloc(molecule->n_bonds * sizeof(struct tng_bond));
-            if (!molecule->bonds)
-            {
-                fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
-                if (molecule->chains)
-                {
-                    free(molecule->chains);
-                    molecule->chains = 0;
-                }
-                if (molecule->residues)
-                {
-                    free(molecule->residues);
-                    molecule->residues = 0;
-                }
-                if (molecule->atoms)
-                {
-                    free(molecule->atoms);
-                    molecule->atoms = 0;
-                }
-                return (TNG_CRITICAL);
-            }
+    if (tng_file_output_numerical(tng_data, &tng_data->medium_stride_length,
+                                  sizeof(tng_data->medium_stride_length), hash_mode, &hash_state, __LINE__)
+        == TNG_CRITICAL)
+    {
+        return (TNG_CRITICAL);
+    }
 
-            bond = molecule->bonds;
+    if (tng_file_output_numerical(tng_data, &tng_data->long_stride_length,
+                                  sizeof(tng_data->long_stride_length), hash_mode, &hash_state, __LINE__)
+        == TNG_CRITICAL)
+    {
+        return (TNG_CRITICAL);
+    }
 
-            for (j = 0; j < molecule->n_bonds; j++)
-            {
-                if (tng_file_input_numerical(tng_data, &bond->from_atom_id, sizeof(bond->from_atom_id),
-                                             hash_mode, &md5_state, __LINE__)
-                    == TNG_CRITICAL)
-                {
-                    return (TNG_CRITICAL);
-                }
+    if (tng_file_output_numerical(tng_data, &tng_data->distance_unit_exponential,
+                                  sizeof(tng_data->distance_unit_exponential), hash_mode, &hash_state, __LINE__)
+        == TNG_CRITICAL)
+    {
+        return (TNG_CRITICAL);
+    }
+    if (hash_mode == TNG_USE_HASH
+        && tng_block_hash_write(tng_data, block, header_file_pos, &hash_state) != TNG_SUCCESS)
+    {
+        return (TNG_CRITICAL);
+    }
 
-                if (tng_file_input_numerical(tng_data, &bond->to_atom_id, sizeof(bond->to_atom_id),
-                                             hash_mode, &md5_state, __LINE__)
-                    == TNG_CRITICAL)
-                {
-                    return (TNG_CRITICAL);
-                }
+    tng_block_destroy(&block);
 
-                bond++;
-            }
-        }
-        else
-        {
-            molecule->bonds = 0;
-        }
-    }
+    return (TNG_SUCCESS);
+}
 
-    if (hash_mode == TNG_USE_HASH)
+/**
+ * @brief Read the chain data of a molecules block.
+ * @param tng_data is a trajectory data container.
+ * @param chain is the chain data container.
+ * @param hash_mode is an option to decide whether to generate/update the relevant md5 hashes.
+ * @param hash_state is a pointer to the current md5 storage, which will be updated appropriately
+ * if hash_mode == TNG_USE_HASH.
+ * @return TNG_SUCCESS(0) is successful.
+ */
+static tng_function_status tng_chain_data_read(const struct tng_trajectory* tng_data,
+                                               struct tng_chain*            chain,
+                                               const char                   hash_mode,
+                                               struct tng_hash_state*       hash_state)
+{
+    if (tng_file_input_numerical(tng_data, &chain->id, sizeof(chain->id), hash_mode, hash_state, __LINE__)
+        == TNG_CRITICAL)
     {
-        /* If there is data left in the block that the current version of the library
-         * cannot interpret still read that to generate the MD5 hash. */
-        tng_md5_remaining_append(tng_data, block, start_pos, &md5_state);
-
-        md5_finish(&md5_state, (md5_byte_t*)hash);
-        if (strncmp(block->md5_hash, "\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0", TNG_MD5_HASH_LEN) != 0)
-        {
-            if (strncmp(block->md5_hash, hash, TNG_MD5_HASH_LEN) != 0)
-            {
-                fprintf(stderr,
-                        "TNG library: Molecules block contents corrupt. Hashes do not match. "
-                        "%s: %d\n",
-                        __FILE__, __LINE__);
-            }
-        }
+        return (TNG_CRITICAL);
     }
 
-    else
+    tng_freadstr(tng_data, &chain->name, hash_mode, hash_state, __LINE__);
+
+    if (tng_file_input_numerical(tng_data, &chain->n_residues, sizeof(chain->n_residues), hash_mode,
+                                 hash_state, __LINE__)
+        == TNG_CRITICAL)
     {
-        /* Seek to the end of the block */
-        fseeko(tng_data->input_file, start_pos + block->block_contents_size, SEEK_SET);
+        return (TNG_CRITICAL);
     }
 
     return (TNG_SUCCESS);
 }
 
 /**
- * @brief Write a molecules block.
+ * @brief Write the chain data of a molecules block.
  * @param tng_data is a trajectory data container.
- * @param hash_mode is an option to decide whether to use the md5 hash or not.
- * If hash_mode == TNG_USE_HASH an md5 hash will be generated and written.
- * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
- * error has occured.
+ * @param chain is the chain data container.
+ * @param hash_mode is an option to decide whether to generate/update the relevant md5 hashes.
+ * @param hash_state is a pointer to the current md5 storage, which will be updated appropriately
+ * if hash_mode == TNG_USE_HASH.
+ * @return TNG_SUCCESS(0) is successful.
  */
-static tng_function_status tng_molecules_block_write(struct tng_trajectory* tng_data, const char hash_mode)
+static tng_function_status tng_chain_data_write(struct tng_trajectory*  tng_data,
+                                                const struct tng_chain* chain,
+                                                const char              hash_mode,
+                                                struct tng_hash_state*  hash_state)
 {
-    int             name_len;
-    int64_t         i, j, k, l, header_file_pos, curr_file_pos;
-    tng_molecule_t  molecule;
-    tng_chain_t     chain;
-    tng_residue_t   residue;
-    tng_atom_t      atom;
-    tng_bond_t      bond;
-    tng_gen_block_t block;
-    md5_state_t     md5_state;
+    if (tng_file_output_numerical(tng_data, &chain->id, sizeof(chain->id), hash_mode, hash_state, __LINE__)
+        == TNG_CRITICAL)
+    {
+        return (TNG_CRITICAL);
+    }
 
-    if (tng_output_file_init(tng_data) != TNG_SUCCESS)
+    if (tng_fwritestr(tng_data, chain->name, hash_mode, hash_state, __LINE__) == TNG_CRITICAL)
     {
         return (TNG_CRITICAL);
     }
 
-    tng_block_init(&block);
+    if (tng_file_output_numerical(tng_data, &chain->n_residues, sizeof(chain->n_residues),
+                                  hash_mode, hash_state, __LINE__)
+        == TNG_CRITICAL)
+    {
+        return (TNG_CRITICAL);
+    }
 
-    name_len = (unsigned int)strlen("MOLECULES");
+    return (TNG_SUCCESS);
+}
 
-    block->name = (char*)malloc(name_len + 1);
-    if (!block->name)
+/**
+ * @brief Read the residue data of a molecules block.
+ * @param tng_data is a trajectory data container.
+ * @param residue is the residue data container.
+ * @param hash_mode is an option to decide whether to generate/update the relevant md5 hashes.
+ * @param hash_state is a pointer to the current md5 storage, which will be updated appropriately
+ * if hash_mode == TNG_USE_HASH.
+ * @return TNG_SUCCESS(0) is successful.
+ */
+static tng_function_status tng_residue_data_read(const struct tng_trajectory* tng_data,
+                                                 struct tng_residue*          residue,
+                                                 const char                   hash_mode,
+                                                 struct tng_hash_state*       hash_state)
+{
+    if (tng_file_input_numerical(tng_data, &residue->id, sizeof(residue->id), hash_mode, hash_state, __LINE__)
+        == TNG_CRITICAL)
     {
-        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
-        tng_block_destroy(&block);
         return (TNG_CRITICAL);
     }
 
-    strcpy(block->name, "MOLECULES");
-    block->id = TNG_MOLECULES;
+    tng_freadstr(tng_data, &residue->name, hash_mode, hash_state, __LINE__);
 
-    if (tng_molecules_block_len_calculate(tng_data, &block->block_contents_size) != TNG_SUCCESS)
+    if (tng_file_input_numerical(tng_data, &residue->n_atoms, sizeof(residue->n_atoms), hash_mode,
+                                 hash_state, __LINE__)
+        == TNG_CRITICAL)
     {
-        fprintf(stderr, "TNG library: Cannot calculate length of molecules block. %s: %d\n",
-                __FILE__, __LINE__);
-        tng_block_destroy(&block);
         return (TNG_CRITICAL);
     }
 
-    header_file_pos = ftello(tng_data->output_file);
+    return (TNG_SUCCESS);
+}
 
-    if (tng_block_header_write(tng_data, block) != TNG_SUCCESS)
+/**
+ * @brief Write the residue data of a molecules block.
+ * @param tng_data is a trajectory data container.
+ * @param residue is the residue data container.
+ * @param hash_mode is an option to decide whether to generate/update the relevant md5 hashes.
+ * @param hash_state is a pointer to the current md5 storage, which will be updated appropriately
+ * if hash_mode == TNG_USE_HASH.
+ * @return TNG_SUCCESS(0) is successful.
+ */
+static tng_function_status tng_residue_data_write(struct tng_trajectory*    tng_data,
+                                                  const struct tng_residue* residue,
+                                                  const char                hash_mode,
+                                                  struct tng_hash_state*    hash_state)
+{
+    if (tng_file_output_numerical(tng_data, &residue->id, sizeof(residue->id), hash_mode, hash_state, __LINE__)
+        == TNG_CRITICAL)
     {
-        fprintf(stderr, "TNG library: Cannot write header of file %s. %s: %d\n",
-                tng_data->output_file_path, __FILE__, __LINE__);
-        tng_block_destroy(&block);
         return (TNG_CRITICAL);
     }
 
-    if (hash_mode == TNG_USE_HASH)
+    if (tng_fwritestr(tng_data, residue->name, hash_mode, hash_state, __LINE__) == TNG_CRITICAL)
     {
-        md5_init(&md5_state);
+        return (TNG_CRITICAL);
     }
 
-    if (tng_file_output_numerical(tng_data, &tng_data->n_molecules, sizeof(tng_data->n_molecules),
-                                  hash_mode, &md5_state, __LINE__)
+    if (tng_file_output_numerical(tng_data, &residue->n_atoms, sizeof(residue->n_atoms), hash_mode,
+                                  hash_state, __LINE__)
         == TNG_CRITICAL)
     {
         return (TNG_CRITICAL);
     }
 
-    for (i = 0; i < tng_data->n_molecules; i++)
-    {
-        molecule = &tng_data->molecules[i];
-
-        if (tng_file_output_numerical(tng_data, &molecule->id, sizeof(molecule->id), hash_mode,
-                                      &md5_state, __LINE__)
-            == TNG_CRITICAL)
-        {
-            return (TNG_CRITICAL);
-        }
+    return (TNG_SUCCESS);
+}
 
-        if (tng_fwritestr(tng_data, molecule->name, hash_mode, &md5_state, __LINE__) == TNG_CRITICAL)
-        {
-            return (TNG_CRITICAL);
-        }
+/**
+ * @brief Read the atom data of a molecules block.
+ * @param tng_data is a trajectory data container.
+ * @param atom is the atom data container.
+ * @param hash_mode is an option to decide whether to generate/update the relevant md5 hashes.
+ * @param hash_state is a pointer to the current md5 storage, which will be updated appropriately
+ * if hash_mode == TNG_USE_HASH.
+ * @return TNG_SUCCESS(0) is successful.
+ */
+static tng_function_status tng_atom_data_read(const struct tng_trajectory* tng_data,
+                                              struct tng_atom*             atom,
+                                              const char                   hash_mode,
+                                              struct tng_hash_state*       hash_state)
+{
+    if (tng_file_input_numerical(tng_data, &atom->id, sizeof(atom->id), hash_mode, hash_state, __LINE__)
+        == TNG_CRITICAL)
+    {
+        return (TNG_CRITICAL);
+    }
 
-        if (tng_file_output_numerical(tng_data, &molecule->quaternary_str,
-                                      sizeof(molecule->quaternary_str), hash_mode, &md5_state, __LINE__)
-            == TNG_CRITICAL)
-        {
-            return (TNG_CRITICAL);
-        }
+    tng_freadstr(tng_data, &atom->name, hash_mode, hash_state, __LINE__);
 
-        if (!tng_data->var_num_atoms_flag)
+    tng_freadstr(tng_data, &atom->atom_type, hash_mode, hash_state, __LINE__);
+
+    return (TNG_SUCCESS);
+}
+
+/**
+ * @brief Write the atom data of a molecules block.
+ * @param tng_data is a trajectory data container.
+ * @param atom is the atom data container.
+ * @param hash_mode is an option to decide whether to generate/update the relevant md5 hashes.
+ * @param hash_state is a pointer to the current md5 storage, which will be updated appropriately
+ * if hash_mode == TNG_USE_HASH.
+ * @return TNG_SUCCESS(0) is successful.
+ */
+static tng_function_status tng_atom_data_write(struct tng_trajectory* tng_data,
+                                               const struct tng_atom* atom,
+                                               const char             hash_mode,
+                                               struct tng_hash_state* hash_state)
+{
+    if (tng_file_output_numerical(tng_data, &atom->id, sizeof(atom->id), hash_mode, hash_state, __LINE__)
+        == TNG_CRITICAL)
+    {
+        return (TNG_CRITICAL);
+    }
+
+    if (tng_fwritestr(tng_data, atom->name, hash_mode, hash_state, __LINE__) == TNG_CRITICAL)
+    {
+        return (TNG_CRITICAL);
+    }
+
+    if (tng_fwritestr(tng_data, atom->atom_type, hash_mode, hash_state, __LINE__) == TNG_CRITICAL)
+    {
+        return (TNG_CRITICAL);
+    }
+
+    return (TNG_SUCCESS);
+}
+
+static tng_function_status tng_molecules_block_len_calculate(const struct tng_trajectory* tng_data,
+                                                             int64_t*                     len)
+{
+    int64_t        i, j;
+    tng_molecule_t molecule;
+    tng_chain_t    chain;
+    tng_residue_t  residue;
+    tng_atom_t     atom;
+    tng_bond_t     bond;
+
+    *len = 0;
+
+    for (i = 0; i < tng_data->n_molecules; i++)
+    {
+        molecule = &tng_data->molecules[i];
+        if (!molecule->name)
         {
-            if (tng_file_output_numerical(tng_data, &tng_data->molecule_cnt_list[i],
-                                          sizeof(int64_t), hash_mode, &md5_state, __LINE__)
-                == TNG_CRITICAL)
+            molecule->name = (char*)malloc(1);
+            if (!molecule->name)
             {
+                fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
                 return (TNG_CRITICAL);
             }
+            molecule->name[0] = 0;
         }
+        *len += tng_min_size(strlen(molecule->name) + 1, TNG_MAX_STR_LEN);
 
-        if (tng_file_output_numerical(tng_data, &molecule->n_chains, sizeof(molecule->n_chains),
-                                      hash_mode, &md5_state, __LINE__)
-            == TNG_CRITICAL)
-        {
-            return (TNG_CRITICAL);
-        }
-
-        if (tng_file_output_numerical(tng_data, &molecule->n_residues, sizeof(molecule->n_residues),
-                                      hash_mode, &md5_state, __LINE__)
-            == TNG_CRITICAL)
-        {
-            return (TNG_CRITICAL);
-        }
-
-        if (tng_file_output_numerical(tng_data, &molecule->n_atoms, sizeof(molecule->n_atoms),
-                                      hash_mode, &md5_state, __LINE__)
-            == TNG_CRITICAL)
+        chain = molecule->chains;
+        for (j = 0; j < molecule->n_chains; j++)
         {
-            return (TNG_CRITICAL);
-        }
+            *len += sizeof(chain->id);
 
-        if (molecule->n_chains > 0)
-        {
-            chain = molecule->chains;
-            for (j = 0; j < molecule->n_chains; j++)
+            if (!chain->name)
             {
-                tng_chain_data_write(tng_data, chain, hash_mode, &md5_state);
-
-                residue = chain->residues;
-                for (k = 0; k < chain->n_residues; k++)
+                chain->name = (char*)malloc(1);
+                if (!chain->name)
                 {
-                    tng_residue_data_write(tng_data, residue, hash_mode, &md5_state);
-
-                    atom = molecule->atoms + residue->atoms_offset;
-                    for (l = 0; l < residue->n_atoms; l++)
-                    {
-                        tng_atom_data_write(tng_data, atom, hash_mode, &md5_state);
-
-                        atom++;
-                    }
-                    residue++;
+                    fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+                    return (TNG_CRITICAL);
                 }
-                chain++;
+                chain->name[0] = 0;
             }
+            *len += tng_min_size(strlen(chain->name) + 1, TNG_MAX_STR_LEN);
+
+            *len += sizeof(chain->n_residues);
+
+            chain++;
         }
-        else
-        {
-            if (molecule->n_residues > 0)
-            {
-                residue = molecule->residues;
-                for (k = 0; k < molecule->n_residues; k++)
-                {
-                    tng_residue_data_write(tng_data, residue, hash_mode, &md5_state);
 
-                    atom = molecule->atoms + residue->atoms_offset;
-                    for (l = 0; l < residue->n_atoms; l++)
-                    {
-                        tng_atom_data_write(tng_data, atom, hash_mode, &md5_state);
+        residue = molecule->residues;
+        for (j = 0; j < molecule->n_residues; j++)
+        {
+            *len += sizeof(residue->id);
 
-                        atom++;
-                    }
-                    residue++;
-                }
-            }
-            else
+            if (!residue->name)
             {
-                atom = molecule->atoms;
-                for (l = 0; l < molecule->n_atoms; l++)
+                residue->name = (char*)malloc(1);
+                if (!residue->name)
                 {
-                    tng_atom_data_write(tng_data, atom, hash_mode, &md5_state);
-
-                    atom++;
+                    fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+                    return (TNG_CRITICAL);
                 }
+                residue->name[0] = 0;
             }
-        }
+            *len += tng_min_size(strlen(residue->name) + 1, TNG_MAX_STR_LEN);
 
-        if (tng_file_output_numerical(tng_data, &molecule->n_bonds, sizeof(molecule->n_bonds),
-                                      hash_mode, &md5_state, __LINE__)
-            == TNG_CRITICAL)
-        {
-            return (TNG_CRITICAL);
+            *len += sizeof(residue->n_atoms);
+
+            residue++;
         }
 
-        bond = molecule->bonds;
-        for (j = 0; j < molecule->n_bonds; j++)
+        atom = molecule->atoms;
+        for (j = 0; j < molecule->n_atoms; j++)
         {
-            if (tng_file_output_numerical(tng_data, &bond->from_atom_id, sizeof(bond->from_atom_id),
-                                          hash_mode, &md5_state, __LINE__)
-                == TNG_CRITICAL)
+            *len += sizeof(atom->id);
+            if (!atom->name)
             {
-                return (TNG_CRITICAL);
+                atom->name = (char*)malloc(1);
+                if (!atom->name)
+                {
+                    fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+                    return (TNG_CRITICAL);
+                }
+                atom->name[0] = 0;
             }
+            *len += tng_min_size(strlen(atom->name) + 1, TNG_MAX_STR_LEN);
 
-            if (tng_file_output_numerical(tng_data, &bond->to_atom_id, sizeof(bond->to_atom_id),
-                                          hash_mode, &md5_state, __LINE__)
-                == TNG_CRITICAL)
+            if (!atom->atom_type)
             {
-                return (TNG_CRITICAL);
+                atom->atom_type = (char*)malloc(1);
+                if (!atom->atom_type)
+                {
+                    fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+                    return (TNG_CRITICAL);
+                }
+                atom->atom_type[0] = 0;
             }
+            *len += tng_min_size(strlen(atom->atom_type) + 1, TNG_MAX_STR_LEN);
 
-            bond++;
+            atom++;
         }
-    }
-    if (hash_mode == TNG_USE_HASH)
-    {
-        md5_finish(&md5_state, (md5_byte_t*)block->md5_hash);
-        curr_file_pos = ftello(tng_data->output_file);
-        fseeko(tng_data->output_file, header_file_pos + 3 * sizeof(int64_t), SEEK_SET);
-        if (fwrite(block->md5_hash, TNG_MD5_HASH_LEN, 1, tng_data->output_file) != 1)
+
+        for (j = 0; j < molecule->n_bonds; j++)
         {
-            fprintf(stderr, "TNG library: Could not write MD5 hash. %s: %d\n", __FILE__, __LINE__);
-            return (TNG_CRITICAL);
+            *len += sizeof(bond->from_atom_id) + sizeof(bond->to_atom_id);
         }
-        fseeko(tng_data->output_file, curr_file_pos, SEEK_SET);
     }
+    *len += sizeof(tng_data->n_molecules)
+            + (sizeof(molecule->id) + sizeof(molecule->quaternary_str) + sizeof(molecule->n_chains)
+               + sizeof(molecule->n_residues) + sizeof(molecule->n_atoms) + sizeof(molecule->n_bonds))
+                      * tng_data->n_molecules;
 
-    tng_block_destroy(&block);
-
-    return (TNG_SUCCESS);
-}
-
-static tng_function_status tng_frame_set_block_len_calculate(const struct tng_trajectory* tng_data,
-                                                             int64_t*                     len)
-{
-    *len = sizeof(int64_t) * 8;
-    *len += sizeof(double) * 2;
-
-    if (tng_data->var_num_atoms_flag)
+    if (!tng_data->var_num_atoms_flag)
     {
-        *len += sizeof(int64_t) * tng_data->n_molecules;
+        *len += tng_data->n_molecules * sizeof(int64_t);
     }
+
     return (TNG_SUCCESS);
 }
 
 /**
- * @brief Read a frame set block. Update tng_data->current_trajectory_frame_set
+ * @brief Read a molecules block. Contains chain, residue and atom data
  * @param tng_data is a trajectory data container.
  * @param block is a general block container.
  * @param hash_mode is an option to decide whether to use the md5 hash or not.
@@ -3375,523 +4146,763 @@ static tng_function_status tng_frame_set_block_len_calculate(const struct tng_tr
  * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
  * error has occured.
  */
-static tng_function_status tng_frame_set_block_read(tng_trajectory_t tng_data,
-                                                    tng_gen_block_t  block,
-                                                    const char       hash_mode)
+static tng_function_status tng_molecules_block_read(struct tng_trajectory*      tng_data,
+                                                    const struct tng_gen_block* block,
+                                                    const char                  hash_mode)
 {
-    int64_t                    file_pos, start_pos, i, prev_n_particles;
-    tng_trajectory_frame_set_t frame_set = &tng_data->current_trajectory_frame_set;
-    char                       hash[TNG_MD5_HASH_LEN];
-    md5_state_t                md5_state;
+    int64_t               start_pos, i, j, k, l;
+    tng_molecule_t        molecule;
+    tng_chain_t           chain;
+    tng_residue_t         residue;
+    tng_atom_t            atom;
+    tng_bond_t            bond;
+    struct tng_hash_state hash_state;
 
     if (tng_input_file_init(tng_data) != TNG_SUCCESS)
     {
         return (TNG_CRITICAL);
     }
 
-    start_pos = ftello(tng_data->input_file);
+    start_pos = tng_input_file_tell(tng_data);
 
     /* FIXME: Does not check if the size of the contents matches the expected
      * size or if the contents can be read. */
 
-    file_pos = start_pos - block->header_contents_size;
-
-    tng_data->current_trajectory_frame_set_input_file_pos = file_pos;
-
-    tng_frame_set_particle_mapping_free(tng_data);
+    if (tng_data->molecules)
+    {
+        for (i = 0; i < tng_data->n_molecules; i++)
+        {
+            tng_molecule_destroy(tng_data, &tng_data->molecules[i]);
+        }
+        free(tng_data->molecules);
+        tng_data->molecules   = 0;
+        tng_data->n_molecules = 0;
+    }
 
     if (hash_mode == TNG_USE_HASH)
     {
-        md5_init(&md5_state);
+        tng_block_hash_init(block, &hash_state);
     }
-    if (tng_file_input_numerical(tng_data, &frame_set->first_frame, sizeof(frame_set->first_frame),
-                                 hash_mode, &md5_state, __LINE__)
+
+    tng_data->molecule_index.valid = TNG_FALSE;
+
+    if (tng_file_input_numerical(tng_data, &tng_data->n_molecules, sizeof(tng_data->n_molecules),
+                                 hash_mode, &hash_state, __LINE__)
         == TNG_CRITICAL)
     {
         return (TNG_CRITICAL);
     }
 
-    if (tng_file_input_numerical(tng_data, &frame_set->n_frames, sizeof(frame_set->n_frames),
-                                 hash_mode, &md5_state, __LINE__)
-        == TNG_CRITICAL)
+    if (tng_data->molecules)
     {
-        return (TNG_CRITICAL);
+        free(tng_data->molecules);
     }
 
-    if (tng_data->var_num_atoms_flag)
-    {
-        prev_n_particles       = frame_set->n_particles;
-        frame_set->n_particles = 0;
-        /* If the list of molecule counts has already been created assume that
-         * it is of correct size. */
-        if (!frame_set->molecule_cnt_list)
-        {
-            frame_set->molecule_cnt_list = (int64_t*)malloc(sizeof(int64_t) * tng_data->n_molecules);
-
-            if (!frame_set->molecule_cnt_list)
-            {
-                fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
-                return (TNG_CRITICAL);
-            }
-        }
-        for (i = 0; i < tng_data->n_molecules; i++)
-        {
-            if (tng_file_input_numerical(tng_data, &frame_set->molecule_cnt_list[i],
-                                         sizeof(int64_t), hash_mode, &md5_state, __LINE__)
-                == TNG_CRITICAL)
-            {
-                return (TNG_CRITICAL);
-            }
-
-            frame_set->n_particles += tng_data->molecules[i].n_atoms * frame_set->molecule_cnt_list[i];
-        }
-        if (prev_n_particles && frame_set->n_particles != prev_n_particles)
-        {
-            /* FIXME: Particle dependent data memory management */
-        }
-    }
-
-    if (tng_file_input_numerical(tng_data, &frame_set->next_frame_set_file_pos,
-                                 sizeof(frame_set->next_frame_set_file_pos), hash_mode, &md5_state, __LINE__)
-        == TNG_CRITICAL)
-    {
-        return (TNG_CRITICAL);
-    }
-
-    if (tng_file_input_numerical(tng_data, &frame_set->prev_frame_set_file_pos,
-                                 sizeof(frame_set->prev_frame_set_file_pos), hash_mode, &md5_state, __LINE__)
-        == TNG_CRITICAL)
-    {
-        return (TNG_CRITICAL);
-    }
+    tng_data->n_particles = 0;
 
-    if (tng_file_input_numerical(tng_data, &frame_set->medium_stride_next_frame_set_file_pos,
-                                 sizeof(frame_set->medium_stride_next_frame_set_file_pos),
-                                 hash_mode, &md5_state, __LINE__)
-        == TNG_CRITICAL)
+    tng_data->molecules =
+            (struct tng_molecule*)malloc(tng_data->n_molecules * sizeof(struct tng_molecule));
+    if (!tng_data->molecules)
     {
+        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
         return (TNG_CRITICAL);
     }
 
-    if (tng_file_input_numerical(tng_data, &frame_set->medium_stride_prev_frame_set_file_pos,
-                                 sizeof(frame_set->medium_stride_prev_frame_set_file_pos),
-                                 hash_mode, &md5_state, __LINE__)
-        == TNG_CRITICAL)
+    if (!tng_data->var_num_atoms_flag)
     {
-        return (TNG_CRITICAL);
+        if (tng_data->molecule_cnt_list)
+        {
+            free(tng_data->molecule_cnt_list);
+        }
+        tng_data->molecule_cnt_list = (int64_t*)malloc(sizeof(int64_t) * tng_data->n_molecules);
+        if (!tng_data->molecule_cnt_list)
+        {
+            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+            return (TNG_CRITICAL);
+        }
     }
 
-    if (tng_file_input_numerical(tng_data, &frame_set->long_stride_next_frame_set_file_pos,
-                                 sizeof(frame_set->long_stride_next_frame_set_file_pos), hash_mode,
-                                 &md5_state, __LINE__)
-        == TNG_CRITICAL)
+    /* Read each molecule from file */
+    for (i = 0; i < tng_data->n_molecules; i++)
     {
-        return (TNG_CRITICAL);
-    }
+        molecule = &tng_data->molecules[i];
 
-    if (tng_file_input_numerical(tng_data, &frame_set->long_stride_prev_frame_set_file_pos,
-                                 sizeof(frame_set->long_stride_prev_frame_set_file_pos), hash_mode,
-                                 &md5_state, __LINE__)
-        == TNG_CRITICAL)
-    {
-        return (TNG_CRITICAL);
-    }
+        molecule->name = 0;
 
-    if (block->block_version >= 3)
-    {
-        if (tng_file_input_numerical(tng_data, &frame_set->first_frame_time,
-                                     sizeof(frame_set->first_frame_time), hash_mode, &md5_state, __LINE__)
+        if (tng_file_input_numerical(tng_data, &molecule->id, sizeof(molecule->id), hash_mode,
+                                     &hash_state, __LINE__)
             == TNG_CRITICAL)
         {
             return (TNG_CRITICAL);
         }
 
-        if (tng_file_input_numerical(tng_data, &tng_data->time_per_frame,
-                                     sizeof(tng_data->time_per_frame), hash_mode, &md5_state, __LINE__)
+        /*         fprintf(stderr, "TNG library: Read id: %" PRId64 " offset: %d\n", molecule->id, offset);*/
+        tng_freadstr(tng_data, &molecule->name, hash_mode, &hash_state, __LINE__);
+
+        if (tng_file_input_numerical(tng_data, &molecule->quaternary_str,
+                                     sizeof(molecule->quaternary_str), hash_mode, &hash_state, __LINE__)
             == TNG_CRITICAL)
         {
             return (TNG_CRITICAL);
         }
-    }
-    else
-    {
-        frame_set->first_frame_time = -1;
-        tng_data->time_per_frame    = -1;
-    }
-
-    if (hash_mode == TNG_USE_HASH)
-    {
-        /* If there is data left in the block that the current version of the library
-         * cannot interpret still read that to generate the MD5 hash. */
-        tng_md5_remaining_append(tng_data, block, start_pos, &md5_state);
 
-        md5_finish(&md5_state, (md5_byte_t*)hash);
-        if (strncmp(block->md5_hash, "\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0", TNG_MD5_HASH_LEN) != 0)
+        if (!tng_data->var_num_atoms_flag)
         {
-            if (strncmp(block->md5_hash, hash, TNG_MD5_HASH_LEN) != 0)
+            if (tng_file_input_numerical(tng_data, &tng_data->molecule_cnt_list[i], sizeof(int64_t),
+                                         hash_mode, &hash_state, __LINE__)
+                == TNG_CRITICAL)
             {
-                fprintf(stderr,
-                        "TNG library: Frame set block contents corrupt (first frame %" PRId64
-                        "). Hashes do not match. "
-                        "%s: %d\n",
-                        frame_set->first_frame, __FILE__, __LINE__);
+                return (TNG_CRITICAL);
             }
         }
-    }
-    else
-    {
-        /* Seek to the end of the block */
-        fseeko(tng_data->input_file, start_pos + block->block_contents_size, SEEK_SET);
-    }
-
-    /* If the output file and the input files are the same the number of
-     * frames in the file are the same number as has just been read.
-     * This is updated here to later on see if there have been new frames
-     * added and thereby the frame set needs to be rewritten. */
-    if (tng_data->output_file == tng_data->input_file)
-    {
-        frame_set->n_written_frames = frame_set->n_frames;
-    }
-
-    return (TNG_SUCCESS);
-}
-
-/**
- * @brief Write tng_data->current_trajectory_frame_set to file
- * @param tng_data is a trajectory data container.
- * @param block is a general block container.
- * @param hash_mode is an option to decide whether to use the md5 hash or not.
- * If hash_mode == TNG_USE_HASH an md5 hash will be generated and written.
- * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
- * error has occured.
- */
-static tng_function_status tng_frame_set_block_write(struct tng_trajectory* tng_data,
-                                                     struct tng_gen_block*  block,
-                                                     const char             hash_mode)
-{
-    char*                      temp_name;
-    int64_t                    i, header_file_pos, curr_file_pos;
-    unsigned int               name_len;
-    tng_trajectory_frame_set_t frame_set = &tng_data->current_trajectory_frame_set;
-    md5_state_t                md5_state;
 
-    if (tng_output_file_init(tng_data) != TNG_SUCCESS)
-    {
-        return (TNG_CRITICAL);
-    }
+        if (tng_file_input_numerical(tng_data, &molecule->n_chains, sizeof(molecule->n_chains),
+                                     hash_mode, &hash_state, __LINE__)
+            == TNG_CRITICAL)
+        {
+            return (TNG_CRITICAL);
+        }
 
-    name_len = (unsigned int)strlen("TRAJECTORY FRAME SET");
+        if (tng_file_input_numerical(tng_data, &molecule->n_residues, sizeof(molecule->n_residues),
+                                     hash_mode, &hash_state, __LINE__)
+            == TNG_CRITICAL)
+        {
+            return (TNG_CRITICAL);
+        }
 
-    if (!block->name || strlen(block->name) < name_len)
-    {
-        temp_name = (char*)realloc(block->name, name_len + 1);
-        if (!temp_name)
+        if (tng_file_input_numerical(tng_data, &molecule->n_atoms, sizeof(molecule->n_atoms),
+                                     hash_mode, &hash_state, __LINE__)
+            == TNG_CRITICAL)
         {
-            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
-            free(block->name);
-            block->name = 0;
             return (TNG_CRITICAL);
         }
-        block->name = temp_name;
-    }
-    strcpy(block->name, "TRAJECTORY FRAME SET");
-    block->id = TNG_TRAJECTORY_FRAME_SET;
 
-    if (tng_frame_set_block_len_calculate(tng_data, &block->block_contents_size) != TNG_SUCCESS)
-    {
-        fprintf(stderr, "TNG library: Cannot calculate length of frame set block. %s: %d\n",
-                __FILE__, __LINE__);
-        return (TNG_CRITICAL);
-    }
+        tng_data->n_particles += molecule->n_atoms * tng_data->molecule_cnt_list[i];
 
-    header_file_pos = ftello(tng_data->output_file);
+        if (molecule->n_chains > 0)
+        {
+            molecule->chains = (struct tng_chain*)malloc(molecule->n_chains * sizeof(struct tng_chain));
+            if (!molecule->chains)
+            {
+                fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+                return (TNG_CRITICAL);
+            }
 
-    if (tng_block_header_write(tng_data, block) != TNG_SUCCESS)
-    {
-        fprintf(stderr, "TNG library: Cannot write header of file %s. %s: %d\n",
-                tng_data->output_file_path, __FILE__, __LINE__);
-        return (TNG_CRITICAL);
-    }
+            chain = molecule->chains;
+        }
+        else
+        {
+            chain = 0;
+        }
 
-    if (hash_mode == TNG_USE_HASH)
-    {
-        md5_init(&md5_state);
-    }
-    if (tng_file_output_numerical(tng_data, &frame_set->first_frame, sizeof(frame_set->first_frame),
-                                  hash_mode, &md5_state, __LINE__)
-        == TNG_CRITICAL)
-    {
-        return (TNG_CRITICAL);
-    }
+        if (molecule->n_residues > 0)
+        {
+            molecule->residues =
+                    (struct tng_residue*)malloc(molecule->n_residues * sizeof(struct tng_residue));
+            if (!molecule->residues)
+            {
+                fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+                if (molecule->chains)
+                {
+                    free(molecule->chains);
+                    molecule->chains = 0;
+                }
+                return (TNG_CRITICAL);
+            }
 
-    if (tng_file_output_numerical(tng_data, &frame_set->n_frames, sizeof(frame_set->n_frames),
-                                  hash_mode, &md5_state, __LINE__)
-        == TNG_CRITICAL)
-    {
-        return (TNG_CRITICAL);
-    }
+            residue = molecule->residues;
+        }
+        else
+        {
+            residue = 0;
+        }
 
-    if (tng_data->var_num_atoms_flag)
-    {
-        for (i = 0; i < tng_data->n_molecules; i++)
+        molecule->atoms = (struct tng_atom*)malloc(molecule->n_atoms * sizeof(struct tng_atom));
+        if (!molecule->atoms)
         {
-            if (tng_file_output_numerical(tng_data, &frame_set->molecule_cnt_list[i],
-                                          sizeof(int64_t), hash_mode, &md5_state, __LINE__)
-                == TNG_CRITICAL)
+            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+            if (molecule->chains)
             {
-                return (TNG_CRITICAL);
+                free(molecule->chains);
+                molecule->chains = 0;
+            }
+            if (molecule->residues)
+            {
+                free(molecule->residues);
+                molecule->residues = 0;
             }
+            return (TNG_CRITICAL);
         }
-    }
 
-    if (tng_file_output_numerical(tng_data, &frame_set->next_frame_set_file_pos,
-                                  sizeof(frame_set->next_frame_set_file_pos), hash_mode, &md5_state, __LINE__)
-        == TNG_CRITICAL)
-    {
-        return (TNG_CRITICAL);
-    }
+        atom = molecule->atoms;
 
-    if (tng_file_output_numerical(tng_data, &frame_set->prev_frame_set_file_pos,
-                                  sizeof(frame_set->prev_frame_set_file_pos), hash_mode, &md5_state, __LINE__)
-        == TNG_CRITICAL)
-    {
-        return (TNG_CRITICAL);
-    }
+        if (molecule->n_chains > 0)
+        {
+            /* Read the chains of the molecule */
+            for (j = 0; j < molecule->n_chains; j++)
+            {
+                chain->molecule = molecule;
 
-    if (tng_file_output_numerical(tng_data, &frame_set->medium_stride_next_frame_set_file_pos,
-                                  sizeof(frame_set->medium_stride_next_frame_set_file_pos),
-                                  hash_mode, &md5_state, __LINE__)
-        == TNG_CRITICAL)
-    {
-        return (TNG_CRITICAL);
-    }
+                chain->name = 0;
 
-    if (tng_file_output_numerical(tng_data, &frame_set->medium_stride_prev_frame_set_file_pos,
-                                  sizeof(frame_set->medium_stride_prev_frame_set_file_pos),
-                                  hash_mode, &md5_state, __LINE__)
-        == TNG_CRITICAL)
-    {
-        return (TNG_CRITICAL);
-    }
+                tng_chain_data_read(tng_data, chain, hash_mode, &hash_state);
 
-    if (tng_file_output_numerical(tng_data, &frame_set->long_stride_next_frame_set_file_pos,
-                                  sizeof(frame_set->long_stride_next_frame_set_file_pos), hash_mode,
-                                  &md5_state, __LINE__)
-        == TNG_CRITICAL)
-    {
-        return (TNG_CRITICAL);
-    }
+                if (j == 0)
+                {
+                    chain->residues = molecule->residues;
+                    residue         = chain->residues;
+                }
+                else
+                {
+                    chain->residues = residue;
+                }
 
-    if (tng_file_output_numerical(tng_data, &frame_set->long_stride_prev_frame_set_file_pos,
-                                  sizeof(frame_set->long_stride_prev_frame_set_file_pos), hash_mode,
-                                  &md5_state, __LINE__)
-        == TNG_CRITICAL)
-    {
-        return (TNG_CRITICAL);
-    }
+                /* Read the residues of the chain */
+                for (k = 0; k < chain->n_residues; k++)
+                {
+                    residue->chain = chain;
 
-    if (tng_file_output_numerical(tng_data, &frame_set->first_frame_time,
-                                  sizeof(frame_set->first_frame_time), hash_mode, &md5_state, __LINE__)
-        == TNG_CRITICAL)
-    {
-        return (TNG_CRITICAL);
-    }
+                    residue->name = 0;
 
-    if (tng_file_output_numerical(tng_data, &tng_data->time_per_frame,
-                                  sizeof(tng_data->time_per_frame), hash_mode, &md5_state, __LINE__)
-        == TNG_CRITICAL)
-    {
-        return (TNG_CRITICAL);
+                    tng_residue_data_read(tng_data, residue, hash_mode, &hash_state);
+
+                    residue->atoms_offset = atom - molecule->atoms;
+                    /* Read the atoms of the residue */
+                    for (l = 0; l < residue->n_atoms; l++)
+                    {
+                        atom->residue = residue;
+
+                        atom->name      = 0;
+                        atom->atom_type = 0;
+
+                        tng_atom_data_read(tng_data, atom, hash_mode, &hash_state);
+
+                        atom++;
+                    }
+                    residue++;
+                }
+                chain++;
+            }
+        }
+        else
+        {
+            if (molecule->n_residues > 0)
+            {
+                for (k = 0; k < molecule->n_residues; k++)
+                {
+                    residue->chain = 0;
+
+                    residue->name = 0;
+
+                    tng_residue_data_read(tng_data, residue, hash_mode, &hash_state);
+
+                    residue->atoms_offset = atom - molecule->atoms;
+                    /* Read the atoms of the residue */
+                    for (l = 0; l < residue->n_atoms; l++)
+                    {
+                        atom->residue = residue;
+
+                        tng_atom_data_read(tng_data, atom, hash_mode, &hash_state);
+
+                        atom++;
+                    }
+                    residue++;
+                }
+            }
+            else
+            {
+                for (l = 0; l < molecule->n_atoms; l++)
+                {
+                    atom->residue = 0;
+
+                    atom->name      = 0;
+                    atom->atom_type = 0;
+
+                    tng_atom_data_read(tng_data, atom, hash_mode, &hash_state);
+
+                    atom++;
+                }
+            }
+        }
+
+        if (tng_file_input_numerical(tng_data, &molecule->n_bonds, sizeof(molecule->n_bonds),
+                                     hash_mode, &hash_state, __LINE__)
+            == TNG_CRITICAL)
+        {
+            return (TNG_CRITICAL);
+        }
+
+        if (molecule->n_bonds > 0)
+        {
+            tng_data->molecules[i].bonds =
+                    (struct tng_bond*)malloc(molecule->n_bonds * sizeof(struct tng_bond));
+            if (!molecule->bonds)
+            {
+                fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+                if (molecule->chains)
+                {
+                    free(molecule->chains);
+                    molecule->chains = 0;
+                }
+                if (molecule->residues)
+                {
+                    free(molecule->residues);
+                    molecule->residues = 0;
+                }
+                if (molecule->atoms)
+                {
+                    free(molecule->atoms);
+                    molecule->atoms = 0;
+                }
+                return (TNG_CRITICAL);
+            }
+
+            bond = molecule->bonds;
+
+            for (j = 0; j < molecule->n_bonds; j++)
+            {
+                if (tng_file_input_numerical(tng_data, &bond->from_atom_id, sizeof(bond->from_atom_id),
+                                             hash_mode, &hash_state, __LINE__)
+                    == TNG_CRITICAL)
+                {
+                    return (TNG_CRITICAL);
+                }
+
+                if (tng_file_input_numerical(tng_data, &bond->to_atom_id, sizeof(bond->to_atom_id),
+                                             hash_mode, &hash_state, __LINE__)
+                    == TNG_CRITICAL)
+                {
+                    return (TNG_CRITICAL);
+                }
+
+                bond++;
+            }
+        }
+        else
+        {
+            molecule->bonds = 0;
+        }
     }
+
     if (hash_mode == TNG_USE_HASH)
     {
-        md5_finish(&md5_state, (md5_byte_t*)block->md5_hash);
-        curr_file_pos = ftello(tng_data->output_file);
-        fseeko(tng_data->output_file, header_file_pos + 3 * sizeof(int64_t), SEEK_SET);
-        if (fwrite(block->md5_hash, TNG_MD5_HASH_LEN, 1, tng_data->output_file) != 1)
+        /* If there is data left in the block that the current version of the library
+         * cannot interpret still read that to generate the MD5 hash. */
+        tng_hash_remaining_append(tng_data, block, start_pos, &hash_state);
+
+        if (tng_block_hash_match_verify(block, &hash_state) != TNG_SUCCESS)
         {
-            fprintf(stderr, "TNG library: Could not write MD5 hash. %s: %d\n", __FILE__, __LINE__);
-            return (TNG_CRITICAL);
+            fprintf(stderr,
+                    "TNG library: Molecules block contents corrupt. Hashes do not match. "
+                    "%s: %d\n",
+                    __FILE__, __LINE__);
         }
-        fseeko(tng_data->output_file, curr_file_pos, SEEK_SET);
     }
 
-    return (TNG_SUCCESS);
-}
-
-static tng_function_status tng_trajectory_mapping_block_len_calculate(const struct tng_trajectory* tng_data,
-                                                                      const int64_t n_particles,
-                                                                      int64_t*      len)
-{
-    (void)tng_data;
-    *len = sizeof(int64_t) * (2 + n_particles);
+    else
+    {
+        /* Seek to the end of the block */
+        tng_input_file_seek(tng_data, start_pos + block->block_contents_size, SEEK_SET);
+    }
 
     return (TNG_SUCCESS);
 }
 
 /**
- * @brief Read an atom mappings block (translating between real atom indexes and how
- *  the atom info is written in this frame set).
+ * @brief Write a molecules block.
  * @param tng_data is a trajectory data container.
- * @param block is a general block container.
  * @param hash_mode is an option to decide whether to use the md5 hash or not.
- * If hash_mode == TNG_USE_HASH the written md5 hash in the file will be
- * compared to the md5 hash of the read contents to ensure valid data.
+ * If hash_mode == TNG_USE_HASH an md5 hash will be generated and written.
  * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
  * error has occured.
  */
-static tng_function_status tng_trajectory_mapping_block_read(struct tng_trajectory*      tng_data,
-                                                             const struct tng_gen_block* block,
-                                                             const char                  hash_mode)
+static tng_function_status tng_molecules_block_write(struct tng_trajectory* tng_data, const char hash_mode)
 {
-    int64_t                    start_pos, i;
-    tng_trajectory_frame_set_t frame_set = &tng_data->current_trajectory_frame_set;
-    tng_particle_mapping_t     mapping, mappings;
-    char                       hash[TNG_MD5_HASH_LEN];
-    md5_state_t                md5_state;
+    int                   name_len;
+    int64_t               i, j, k, l, header_file_pos;
+    tng_molecule_t        molecule;
+    tng_chain_t           chain;
+    tng_residue_t         residue;
+    tng_atom_t            atom;
+    tng_bond_t            bond;
+    tng_gen_block_t       block;
+    struct tng_hash_state hash_state;
 
-    if (tng_input_file_init(tng_data) != TNG_SUCCESS)
+    if (tng_output_file_init(tng_data) != TNG_SUCCESS)
     {
         return (TNG_CRITICAL);
     }
 
-    start_pos = ftello(tng_data->input_file);
+    tng_block_init(&block);
 
-    /* FIXME: Does not check if the size of the contents matches the expected
-     * size or if the contents can be read. */
+    name_len = (unsigned int)strlen("MOLECULES");
 
-    frame_set->n_mapping_blocks++;
-    mappings = (tng_particle_mapping_t)realloc(
-            frame_set->mappings, sizeof(struct tng_particle_mapping) * frame_set->n_mapping_blocks);
-    if (!mappings)
+    block->name = (char*)malloc(name_len + 1);
+    if (!block->name)
     {
         fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
-        free(frame_set->mappings);
-        frame_set->mappings = 0;
+        tng_block_destroy(&block);
         return (TNG_CRITICAL);
     }
-    frame_set->mappings = mappings;
-    mapping             = &mappings[frame_set->n_mapping_blocks - 1];
 
+    strcpy(block->name, "MOLECULES");
+    block->id = TNG_MOLECULES;
 
-    if (hash_mode == TNG_USE_HASH)
+    if (tng_molecules_block_len_calculate(tng_data, &block->block_contents_size) != TNG_SUCCESS)
     {
-        md5_init(&md5_state);
+        fprintf(stderr, "TNG library: Cannot calculate length of molecules block. %s: %d\n",
+                __FILE__, __LINE__);
+        tng_block_destroy(&block);
+        return (TNG_CRITICAL);
     }
 
-    if (tng_file_input_numerical(tng_data, &mapping->num_first_particle,
-                                 sizeof(mapping->num_first_particle), hash_mode, &md5_state, __LINE__)
-        == TNG_CRITICAL)
+    header_file_pos = ftello(tng_data->output_file);
+
+    if (tng_block_header_write(tng_data, block) != TNG_SUCCESS)
     {
+        fprintf(stderr, "TNG library: Cannot write header of file %s. %s: %d\n",
+                tng_data->output_file_path, __FILE__, __LINE__);
+        tng_block_destroy(&block);
         return (TNG_CRITICAL);
     }
 
-    if (tng_file_input_numerical(tng_data, &mapping->n_particles, sizeof(mapping->n_particles),
-                                 hash_mode, &md5_state, __LINE__)
-        == TNG_CRITICAL)
+    if (hash_mode == TNG_USE_HASH)
     {
-        return (TNG_CRITICAL);
+        tng_block_hash_init(block, &hash_state);
     }
 
-    mapping->real_particle_numbers = (int64_t*)malloc(mapping->n_particles * sizeof(int64_t));
-    if (!mapping->real_particle_numbers)
+    if (tng_file_output_numerical(tng_data, &tng_data->n_molecules, sizeof(tng_data->n_molecules),
+                                  hash_mode, &hash_state, __LINE__)
+        == TNG_CRITICAL)
     {
-        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
         return (TNG_CRITICAL);
     }
 
-    /* If the byte order needs to be swapped the data must be read one value at
-     * a time and swapped */
-    if (tng_data->input_endianness_swap_func_64)
+    for (i = 0; i < tng_data->n_molecules; i++)
     {
-        for (i = 0; i < mapping->n_particles; i++)
+        molecule = &tng_data->molecules[i];
+
+        if (tng_file_output_numerical(tng_data, &molecule->id, sizeof(molecule->id), hash_mode,
+                                      &hash_state, __LINE__)
+            == TNG_CRITICAL)
         {
-            if (tng_file_input_numerical(tng_data, &mapping->real_particle_numbers[i],
-                                         sizeof(int64_t), hash_mode, &md5_state, __LINE__)
-                == TNG_CRITICAL)
-            {
-                return (TNG_CRITICAL);
-            }
+            return (TNG_CRITICAL);
         }
-    }
-    /* Otherwise the data can be read all at once */
-    else
-    {
-        if (fread(mapping->real_particle_numbers, mapping->n_particles * sizeof(int64_t), 1, tng_data->input_file)
-            == 0)
+
+        if (tng_fwritestr(tng_data, molecule->name, hash_mode, &hash_state, __LINE__) == TNG_CRITICAL)
         {
-            fprintf(stderr, "TNG library: Cannot read block. %s: %d\n", __FILE__, __LINE__);
             return (TNG_CRITICAL);
         }
-        if (hash_mode == TNG_USE_HASH)
+
+        if (tng_file_output_numerical(tng_data, &molecule->quaternary_str,
+                                      sizeof(molecule->quaternary_str), hash_mode, &hash_state, __LINE__)
+            == TNG_CRITICAL)
         {
-            md5_append(&md5_state, (md5_byte_t*)mapping->real_particle_numbers,
-                       mapping->n_particles * sizeof(int64_t));
+            return (TNG_CRITICAL);
         }
-    }
-
-    if (hash_mode == TNG_USE_HASH)
-    {
-        /* If there is data left in the block that the current version of the library
-         * cannot interpret still read that to generate the MD5 hash. */
-        tng_md5_remaining_append(tng_data, block, start_pos, &md5_state);
 
-        md5_finish(&md5_state, (md5_byte_t*)hash);
-        if (strncmp(block->md5_hash, "\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0", TNG_MD5_HASH_LEN) != 0)
+        if (!tng_data->var_num_atoms_flag)
         {
-            if (strncmp(block->md5_hash, hash, TNG_MD5_HASH_LEN) != 0)
+            if (tng_file_output_numerical(tng_data, &tng_data->molecule_cnt_list[i],
+                                          sizeof(int64_t), hash_mode, &hash_state, __LINE__)
+                == TNG_CRITICAL)
             {
-                fprintf(stderr,
-                        "TNG library: Particle mapping block contents corrupt. Hashes do not "
-                        "match. "
-                        "%s: %d\n",
-                        __FILE__, __LINE__);
+                return (TNG_CRITICAL);
+            }
+        }
+
+        if (tng_file_output_numerical(tng_data, &molecule->n_chains, sizeof(molecule->n_chains),
+                                      hash_mode, &hash_state, __LINE__)
+            == TNG_CRITICAL)
+        {
+            return (TNG_CRITICAL);
+        }
+
+        if (tng_file_output_numerical(tng_data, &molecule->n_residues, sizeof(molecule->n_residues),
+                                      hash_mode, &hash_state, __LINE__)
+            == TNG_CRITICAL)
+        {
+            return (TNG_CRITICAL);
+        }
+
+        if (tng_file_output_numerical(tng_data, &molecule->n_atoms, sizeof(molecule->n_atoms),
+                                      hash_mode, &hash_state, __LINE__)
+            == TNG_CRITICAL)
+        {
+            return (TNG_CRITICAL);
+        }
+
+        if (molecule->n_chains > 0)
+        {
+            chain = molecule->chains;
+            for (j = 0; j < molecule->n_chains; j++)
+            {
+                tng_chain_data_write(tng_data, chain, hash_mode, &hash_state);
+
+                residue = chain->residues;
+                for (k = 0; k < chain->n_residues; k++)
+                {
+                    tng_residue_data_write(tng_data, residue, hash_mode, &hash_state);
+
+                    atom = molecule->atoms + residue->atoms_offset;
+                    for (l = 0; l < residue->n_atoms; l++)
+                    {
+                        tng_atom_data_write(tng_data, atom, hash_mode, &hash_state);
+
+                        atom++;
+                    }
+                    residue++;
+                }
+                chain++;
+            }
+        }
+        else
+        {
+            if (molecule->n_residues > 0)
+            {
+                residue = molecule->residues;
+                for (k = 0; k < molecule->n_residues; k++)
+                {
+                    tng_residue_data_write(tng_data, residue, hash_mode, &hash_state);
+
+                    atom = molecule->atoms + residue->atoms_offset;
+                    for (l = 0; l < residue->n_atoms; l++)
+                    {
+                        tng_atom_data_write(tng_data, atom, hash_mode, &hash_state);
+
+                        atom++;
+                    }
+                    residue++;
+                }
+            }
+            else
+            {
+                atom = molecule->atoms;
+                for (l = 0; l < molecule->n_atoms; l++)
+                {
+                    tng_atom_data_write(tng_data, atom, hash_mode, &hash_state);
+
+                    atom++;
+                }
+            }
+        }
+
+        if (tng_file_output_numerical(tng_data, &molecule->n_bonds, sizeof(molecule->n_bonds),
+                                      hash_mode, &hash_state, __LINE__)
+            == TNG_CRITICAL)
+        {
+            return (TNG_CRITICAL);
+        }
+
+        bond = molecule->bonds;
+        for (j = 0; j < molecule->n_bonds; j++)
+        {
+            if (tng_file_output_numerical(tng_data, &bond->from_atom_id, sizeof(bond->from_atom_id),
+                                          hash_mode, &hash_state, __LINE__)
+                == TNG_CRITICAL)
+            {
+                return (TNG_CRITICAL);
+            }
+
+            if (tng_file_output_numerical(tng_data, &bond->to_atom_id, sizeof(bond->to_atom_id),
+                                          hash_mode, &hash_state, __LINE__)
+                == TNG_CRITICAL)
+            {
+                return (TNG_CRITICAL);
             }
+
+            bond++;
         }
     }
-    else
+    if (hash_mode == TNG_USE_HASH
+        && tng_block_hash_write(tng_data, block, header_file_pos, &hash_state) != TNG_SUCCESS)
     {
-        /* Seek to the end of the block */
-        fseeko(tng_data->input_file, start_pos + block->block_contents_size, SEEK_SET);
+        return (TNG_CRITICAL);
     }
 
+    tng_block_destroy(&block);
+
+    return (TNG_SUCCESS);
+}
+
+static tng_function_status tng_frame_set_block_len_calculate(const struct tng_trajectory* tng_data,
+                                                             int64_t*                     len)
+{
+    *len = sizeof(int64_t) * 8;
+    *len += sizeof(double) * 2;
+
+    if (tng_data->var_num_atoms_flag)
+    {
+        *len += sizeof(int64_t) * tng_data->n_molecules;
+    }
     return (TNG_SUCCESS);
 }
 
 /**
- * @brief Write the atom mappings of the current trajectory frame set
+ * @brief Read a frame set block. Update tng_data->current_trajectory_frame_set
  * @param tng_data is a trajectory data container.
  * @param block is a general block container.
- * @param mapping_block_nr is the index of the mapping block to write.
  * @param hash_mode is an option to decide whether to use the md5 hash or not.
- * If hash_mode == TNG_USE_HASH an md5 hash will be generated and written.
- * @return TNG_SUCCESS (0) if successful, TNG_FAILURE (1) if a minor error
- * has occurred or TNG_CRITICAL (2) if a major error has occured.
+ * If hash_mode == TNG_USE_HASH the written md5 hash in the file will be
+ * compared to the md5 hash of the read contents to ensure valid data.
+ * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
+ * error has occured.
  */
-static tng_function_status tng_trajectory_mapping_block_write(struct tng_trajectory* tng_data,
-                                                              struct tng_gen_block*  block,
-                                                              const int  mapping_block_nr,
-                                                              const char hash_mode)
+static tng_function_status tng_frame_set_block_read(tng_trajectory_t tng_data,
+                                                    tng_gen_block_t  block,
+                                                    const char       hash_mode)
 {
-    int64_t                header_file_pos, curr_file_pos;
-    char*                  temp_name;
-    int                    i;
-    unsigned int           name_len;
-    md5_state_t            md5_state;
-    tng_particle_mapping_t mapping = &tng_data->current_trajectory_frame_set.mappings[mapping_block_nr];
+    int64_t                    file_pos, start_pos, i, prev_n_particles, n_values;
+    uint64_t                   values[8];
+    tng_trajectory_frame_set_t frame_set = &tng_data->current_trajectory_frame_set;
+    struct tng_hash_state      hash_state;
 
-    if (mapping_block_nr >= tng_data->current_trajectory_frame_set.n_mapping_blocks)
+    if (tng_input_file_init(tng_data) != TNG_SUCCESS)
     {
-        fprintf(stderr, "TNG library: Mapping block index out of bounds. %s: %d\n", __FILE__, __LINE__);
-        return (TNG_FAILURE);
+        return (TNG_CRITICAL);
+    }
+
+    start_pos = tng_input_file_tell(tng_data);
+
+    /* FIXME: Does not check if the size of the contents matches the expected
+     * size or if the contents can be read. */
+
+    file_pos = start_pos - block->header_contents_size;
+
+    tng_data->current_trajectory_frame_set_input_file_pos = file_pos;
+
+    tng_frame_set_particle_mapping_free(tng_data);
+
+    if (hash_mode == TNG_USE_HASH)
+    {
+        tng_block_hash_init(block, &hash_state);
+    }
+    /* The first frame and the number of frames */
+    if (tng_file_input_numerical_64_n(tng_data, values, 2, hash_mode, &hash_state, __LINE__)
+        != TNG_SUCCESS)
+    {
+        return (TNG_CRITICAL);
+    }
+    frame_set->first_frame = (int64_t)values[0];
+    frame_set->n_frames    = (int64_t)values[1];
+
+    if (tng_data->var_num_atoms_flag)
+    {
+        prev_n_particles       = frame_set->n_particles;
+        frame_set->n_particles = 0;
+        /* If the list of molecule counts has already been created assume that
+         * it is of correct size. */
+        if (!frame_set->molecule_cnt_list)
+        {
+            frame_set->molecule_cnt_list = (int64_t*)malloc(sizeof(int64_t) * tng_data->n_molecules);
+
+            if (!frame_set->molecule_cnt_list)
+            {
+                fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+                return (TNG_CRITICAL);
+            }
+        }
+        if (tng_file_input_numerical_64_n(tng_data, frame_set->molecule_cnt_list,
+                                          tng_data->n_molecules, hash_mode, &hash_state, __LINE__)
+            != TNG_SUCCESS)
+        {
+            return (TNG_CRITICAL);
+        }
+        for (i = 0; i < tng_data->n_molecules; i++)
+        {
+            frame_set->n_particles += tng_data->molecules[i].n_atoms * frame_set->molecule_cnt_list[i];
+        }
+        if (prev_n_particles && frame_set->n_particles != prev_n_particles)
+        {
+            /* FIXME: Particle dependent data memory management */
+        }
+    }
+
+    /* The pointers to the next and previous frame sets, the medium and long
+     * stride frame sets and (from block version 3) the time of the first
+     * frame and the time per frame */
+    n_values = block->block_version >= 3 ? 8 : 6;
+    if (tng_file_input_numerical_64_n(tng_data, values, n_values, hash_mode, &hash_state, __LINE__)
+        != TNG_SUCCESS)
+    {
+        return (TNG_CRITICAL);
+    }
+    frame_set->next_frame_set_file_pos               = (int64_t)values[0];
+    frame_set->prev_frame_set_file_pos               = (int64_t)values[1];
+    frame_set->medium_stride_next_frame_set_file_pos = (int64_t)values[2];
+    frame_set->medium_stride_prev_frame_set_file_pos = (int64_t)values[3];
+    frame_set->long_stride_next_frame_set_file_pos   = (int64_t)values[4];
+    frame_set->long_stride_prev_frame_set_file_pos   = (int64_t)values[5];
+
+    if (block->block_version >= 3)
+    {
+        memcpy(&frame_set->first_frame_time, &values[6], sizeof(frame_set->first_frame_time));
+        memcpy(&tng_data->time_per_frame, &values[7], sizeof(tng_data->time_per_frame));
+    }
+    else
+    {
+        frame_set->first_frame_time = -1;
+        tng_data->time_per_frame    = -1;
+    }
+
+    if (hash_mode == TNG_USE_HASH)
+    {
+        /* If there is data left in the block that the current version of the library
+         * cannot interpret still read that to generate the MD5 hash. */
+        tng_hash_remaining_append(tng_data, block, start_pos, &hash_state);
+
+        if (tng_block_hash_match_verify(block, &hash_state) != TNG_SUCCESS)
+        {
+            fprintf(stderr,
+                    "TNG library: Frame set block contents corrupt (first frame %" PRId64
+                    "). Hashes do not match. "
+                    "%s: %d\n",
+                    frame_set->first_frame, __FILE__, __LINE__);
+        }
+    }
+    else
+    {
+        /* Seek to the end of the block */
+        tng_input_file_seek(tng_data, start_pos + block->block_contents_size, SEEK_SET);
+    }
+
+    /* If the output file and the input files are the same the number of
+     * frames in the file are the same number as has just been read.
+     * This is updated here to later on see if there have been new frames
+     * added and thereby the frame set needs to be rewritten. */
+    if (tng_data->output_file == tng_data->input_file)
+    {
+        frame_set->n_written_frames = frame_set->n_frames;
     }
 
+    return (TNG_SUCCESS);
+}
+
+/**
+ * @brief Write tng_data->current_trajectory_frame_set to file
+ * @param tng_data is a trajectory data container.
+ * @param block is a general block container.
+ * @param hash_mode is an option to decide whether to use the md5 hash or not.
+ * If hash_mode == TNG_USE_HASH an md5 hash will be generated and written.
+ * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
+ * error has occured.
+ */
+static tng_function_status tng_frame_set_block_write(struct tng_trajectory* tng_data,
+                                                     struct tng_gen_block*  block,
+                                                     const char             hash_mode)
+{
+    char*                      temp_name;
+    int64_t                    i, header_file_pos;
+    unsigned int               name_len;
+    tng_trajectory_frame_set_t frame_set = &tng_data->current_trajectory_frame_set;
+    struct tng_hash_state      hash_state;
+
     if (tng_output_file_init(tng_data) != TNG_SUCCESS)
     {
         return (TNG_CRITICAL);
     }
 
-    name_len = (unsigned int)strlen("PARTICLE MAPPING");
+    name_len = (unsigned int)strlen("TRAJECTORY FRAME SET");
 
     if (!block->name || strlen(block->name) < name_len)
     {
@@ -3905,13 +4916,12 @@ static tng_function_status tng_trajectory_mapping_block_write(struct tng_traject
         }
         block->name = temp_name;
     }
-    strcpy(block->name, "PARTICLE MAPPING");
-    block->id = TNG_PARTICLE_MAPPING;
+    strcpy(block->name, "TRAJECTORY FRAME SET");
+    block->id = TNG_TRAJECTORY_FRAME_SET;
 
-    if (tng_trajectory_mapping_block_len_calculate(tng_data, mapping->n_particles, &block->block_contents_size)
-        != TNG_SUCCESS)
+    if (tng_frame_set_block_len_calculate(tng_data, &block->block_contents_size) != TNG_SUCCESS)
     {
-        fprintf(stderr, "TNG library: Cannot calculate length of atom mapping block. %s: %d\n",
+        fprintf(stderr, "TNG library: Cannot calculate length of frame set block. %s: %d\n",
                 __FILE__, __LINE__);
         return (TNG_CRITICAL);
     }
@@ -3927,667 +4937,2475 @@ static tng_function_status tng_trajectory_mapping_block_write(struct tng_traject
 
     if (hash_mode == TNG_USE_HASH)
     {
-        md5_init(&md5_state);
+        tng_block_hash_init(block, &hash_state);
     }
-    if (tng_file_output_numerical(tng_data, &mapping->num_first_particle,
-                                  sizeof(mapping->num_first_particle), hash_mode, &md5_state, __LINE__)
+    if (tng_file_output_numerical(tng_data, &frame_set->first_frame, sizeof(frame_set->first_frame),
+                                  hash_mode, &hash_state, __LINE__)
         == TNG_CRITICAL)
     {
         return (TNG_CRITICAL);
     }
 
-    if (tng_file_output_numerical(tng_data, &mapping->n_particles, sizeof(mapping->n_particles),
-                                  hash_mode, &md5_state, __LINE__)
+    if (tng_file_output_numerical(tng_data, &frame_set->n_frames, sizeof(frame_set->n_frames),
+                                  hash_mode, &hash_state, __LINE__)
         == TNG_CRITICAL)
     {
         return (TNG_CRITICAL);
     }
 
-    if (tng_data->output_endianness_swap_func_64)
+    if (tng_data->var_num_atoms_flag)
     {
-        for (i = 0; i < mapping->n_particles; i++)
+        for (i = 0; i < tng_data->n_molecules; i++)
         {
-            if (tng_file_output_numerical(tng_data, &mapping->real_particle_numbers[i],
-                                          sizeof(int64_t), hash_mode, &md5_state, __LINE__)
+            if (tng_file_output_numerical(tng_data, &frame_set->molecule_cnt_list[i],
+                                          sizeof(int64_t), hash_mode, &hash_state, __LINE__)
                 == TNG_CRITICAL)
             {
                 return (TNG_CRITICAL);
             }
         }
     }
-    else
+
+    if (tng_file_output_numerical(tng_data, &frame_set->next_frame_set_file_pos,
+                                  sizeof(frame_set->next_frame_set_file_pos), hash_mode, &hash_state, __LINE__)
+        == TNG_CRITICAL)
     {
-        if (fwrite(mapping->real_particle_numbers, mapping->n_particles * sizeof(int64_t), 1, tng_data->output_file)
-            != 1)
-        {
-            fprintf(stderr, "TNG library: Could not write block data. %s: %d\n", __FILE__, __LINE__);
-            return (TNG_CRITICAL);
-        }
-        if (hash_mode == TNG_USE_HASH)
-        {
-            md5_append(&md5_state, (md5_byte_t*)mapping->real_particle_numbers,
-                       mapping->n_particles * sizeof(int64_t));
-        }
+        return (TNG_CRITICAL);
     }
 
-    if (hash_mode == TNG_USE_HASH)
+    if (tng_file_output_numerical(tng_data, &frame_set->prev_frame_set_file_pos,
+                                  sizeof(frame_set->prev_frame_set_file_pos), hash_mode, &hash_state, __LINE__)
+        == TNG_CRITICAL)
     {
-        md5_finish(&md5_state, (md5_byte_t*)block->md5_hash);
-        curr_file_pos = ftello(tng_data->output_file);
-        fseeko(tng_data->output_file, header_file_pos + 3 * sizeof(int64_t), SEEK_SET);
-        if (fwrite(block->md5_hash, TNG_MD5_HASH_LEN, 1, tng_data->output_file) != 1)
-        {
-            fprintf(stderr, "TNG library: Could not write MD5 hash. %s: %d\n", __FILE__, __LINE__);
-            return (TNG_CRITICAL);
-        }
-        fseeko(tng_data->output_file, curr_file_pos, SEEK_SET);
+        return (TNG_CRITICAL);
+    }
+
+    if (tng_file_output_numerical(tng_data, &frame_set->medium_stride_next_frame_set_file_pos,
+                                  sizeof(frame_set->medium_stride_next_frame_set_file_pos),
+                                  hash_mode, &hash_state, __LINE__)
+        == TNG_CRITICAL)
+    {
+        return (TNG_CRITICAL);
+    }
+
+    if (tng_file_output_numerical(tng_data, &frame_set->medium_stride_prev_frame_set_file_pos,
+                                  sizeof(frame_set->medium_stride_prev_frame_set_file_pos),
+                                  hash_mode, &hash_state, __LINE__)
+        == TNG_CRITICAL)
+    {
+        return (TNG_CRITICAL);
+    }
+
+    if (tng_file_output_numerical(tng_data, &frame_set->long_stride_next_frame_set_file_pos,
+                                  sizeof(frame_set->long_stride_next_frame_set_file_pos), hash_mode,
+                                  &hash_state, __LINE__)
+        == TNG_CRITICAL)
+    {
+        return (TNG_CRITICAL);
+    }
+
+    if (tng_file_output_numerical(tng_data, &frame_set->long_stride_prev_frame_set_file_pos,
+                                  sizeof(frame_set->long_stride_prev_frame_set_file_pos), hash_mode,
+                                  &hash_state, __LINE__)
+        == TNG_CRITICAL)
+    {
+        return (TNG_CRITICAL);
+    }
+
+    if (tng_file_output_numerical(tng_data, &frame_set->first_frame_time,
+                                  sizeof(frame_set->first_frame_time), hash_mode, &hash_state, __LINE__)
+        == TNG_CRITICAL)
+    {
+        return (TNG_CRITICAL);
     }
 
+    if (tng_file_output_numerical(tng_data, &tng_data->time_per_frame,
+                                  sizeof(tng_data->time_per_frame), hash_mode, &hash_state, __LINE__)
+        == TNG_CRITICAL)
+    {
+        return (TNG_CRITICAL);
+    }
+    if (hash_mode == TNG_USE_HASH
+        && tng_block_hash_write(tng_data, block, header_file_pos, &hash_state) != TNG_SUCCESS)
+    {
+        return (TNG_CRITICAL);
+    }
+
+    return (TNG_SUCCESS);
+}
+
+static tng_function_status tng_trajectory_mapping_block_len_calculate(const struct tng_trajectory* tng_data,
+                                                                      const int64_t n_particles,
+                                                                      int64_t*      len)
+{
+    (void)tng_data;
+    *len = sizeof(int64_t) * (2 + n_particles);
+
     return (TNG_SUCCESS);
 }
 
 /**
- * @brief Prepare a block for storing particle data
- * @param tng_data is a trajectory data container.
- * @param block_type_flag specifies if this is a trajectory block or a
- * non-trajectory block. (TNG_TRAJECTORY_BLOCK or TNG_NON_TRAJECTORY_BLOCK)
+ * @brief Add the last particle mapping block of a frame set to the mapping
+ * index of the frame set.
+ * @param frame_set is the frame set containing the mapping blocks.
  * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
  * error has occured.
  */
-static tng_function_status tng_particle_data_block_create(struct tng_trajectory* tng_data,
-                                                          const char             block_type_flag)
+static tng_function_status tng_particle_mapping_index_add(tng_trajectory_frame_set_t frame_set)
 {
-    tng_trajectory_frame_set_t frame_set = &tng_data->current_trajectory_frame_set;
+    struct tng_particle_mapping_index* index   = &frame_set->mapping_index;
+    int64_t                            block_nr = frame_set->n_mapping_blocks - 1;
+    tng_particle_mapping_t             mapping  = &frame_set->mappings[block_nr];
+    tng_particle_mapping_t             other;
+    int64_t                            lo, hi, mid, max_real, n_real_particles, i;
+    int64_t*                           temp;
 
-    tng_data_t data;
+    temp = (int64_t*)realloc(index->ranges, sizeof(int64_t) * (index->n_ranges + 1));
+    if (!temp)
+    {
+        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+        return (TNG_CRITICAL);
+    }
+    index->ranges = temp;
 
-    if (block_type_flag == TNG_TRAJECTORY_BLOCK)
+    /* Keep the blocks sorted by their first particle, and empty blocks before
+     * a block starting at the same particle, so that a binary search for the
+     * last block starting at or before a particle finds the block containing it. */
+    lo = 0;
+    hi = index->n_ranges;
+    while (lo < hi)
     {
-        frame_set->n_particle_data_blocks++;
-        data = (tng_data_t)realloc(frame_set->tr_particle_data,
-                                   sizeof(struct tng_data) * frame_set->n_particle_data_blocks);
-        if (!data)
+        mid   = lo + (hi - lo) / 2;
+        other = &frame_set->mappings[index->ranges[mid]];
+        if (other->num_first_particle < mapping->num_first_particle
+            || (other->num_first_particle == mapping->num_first_particle
+                && other->n_particles <= mapping->n_particles))
         {
-            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
-            free(frame_set->tr_particle_data);
-            frame_set->tr_particle_data = 0;
-            return (TNG_CRITICAL);
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
         }
-        frame_set->tr_particle_data = data;
     }
-    else
+    memmove(index->ranges + lo + 1, index->ranges + lo, sizeof(int64_t) * (index->n_ranges - lo));
+    index->ranges[lo] = block_nr;
+    index->n_ranges++;
+
+    max_real = -1;
+    for (i = 0; i < mapping->n_particles; i++)
     {
-        tng_data->n_particle_data_blocks++;
-        data = (tng_data_t)realloc(tng_data->non_tr_particle_data,
-                                   sizeof(struct tng_data) * tng_data->n_particle_data_blocks);
-        if (!data)
+        if (mapping->real_particle_numbers[i] > max_real)
+        {
+            max_real = mapping->real_particle_numbers[i];
+        }
+    }
+    if (max_real >= index->n_real_particles)
+    {
+        n_real_particles = index->n_real_particles * 2;
+        if (n_real_particles <= max_real)
+        {
+            n_real_particles = max_real + 1;
+        }
+        temp = (int64_t*)realloc(index->local_particles, sizeof(int64_t) * n_real_particles);
+        if (!temp)
         {
             fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
-            free(tng_data->non_tr_particle_data);
-            tng_data->non_tr_particle_data = 0;
             return (TNG_CRITICAL);
         }
-        tng_data->non_tr_particle_data = data;
+        for (i = index->n_real_particles; i < n_real_particles; i++)
+        {
+            temp[i] = -1;
+        }
+        index->local_particles  = temp;
+        index->n_real_particles = n_real_particles;
+    }
+    for (i = 0; i < mapping->n_particles; i++)
+    {
+        if (mapping->real_particle_numbers[i] >= 0)
+        {
+            index->local_particles[mapping->real_particle_numbers[i]] =
+                    mapping->num_first_particle + i;
+        }
     }
 
     return (TNG_SUCCESS);
 }
 
-static tng_function_status tng_compress(struct tng_trajectory*      tng_data,
-                                        const struct tng_gen_block* block,
-                                        const int64_t               n_frames,
-                                        const int64_t               n_particles,
-                                        const char                  type,
-                                        char**                      data,
-                                        int64_t*                    new_len)
+/**
+ * @brief Free the memory of a particle mapping index.
+ * @param index is the particle mapping index.
+ */
+static void tng_particle_mapping_index_destroy(struct tng_particle_mapping_index* index)
 {
-    int     nalgo;
-    int     compressed_len;
-    int*    alt_algo = 0;
-    char*   dest;
-    int64_t algo_find_n_frames = -1;
-    float   f_precision;
-    double  d_precision;
+    free(index->ranges);
+    index->ranges   = 0;
+    index->n_ranges = 0;
+    free(index->local_particles);
+    index->local_particles  = 0;
+    index->n_real_particles = 0;
+}
 
-    if (block->id != TNG_TRAJ_POSITIONS && block->id != TNG_TRAJ_VELOCITIES)
+/**
+ * @brief Read an atom mappings block (translating between real atom indexes and how
+ *  the atom info is written in this frame set).
+ * @param tng_data is a trajectory data container.
+ * @param block is a general block container.
+ * @param hash_mode is an option to decide whether to use the md5 hash or not.
+ * If hash_mode == TNG_USE_HASH the written md5 hash in the file will be
+ * compared to the md5 hash of the read contents to ensure valid data.
+ * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
+ * error has occured.
+ */
+static tng_function_status tng_trajectory_mapping_block_read(struct tng_trajectory*      tng_data,
+                                                             const struct tng_gen_block* block,
+                                                             const char                  hash_mode)
+{
+    int64_t                    start_pos;
+    uint64_t                   values[2];
+    tng_trajectory_frame_set_t frame_set = &tng_data->current_trajectory_frame_set;
+    tng_particle_mapping_t     mapping, mappings;
+    struct tng_hash_state      hash_state;
+
+    if (tng_input_file_init(tng_data) != TNG_SUCCESS)
     {
-        fprintf(stderr,
-                "TNG library: Can only compress positions and velocities with the "
-                "TNG method. %s: %d\n",
-                __FILE__, __LINE__);
-        return (TNG_FAILURE);
+        return (TNG_CRITICAL);
     }
-    if (type != TNG_FLOAT_DATA && type != TNG_DOUBLE_DATA)
+
+    start_pos = tng_input_file_tell(tng_data);
+
+    /* FIXME: Does not check if the size of the contents matches the expected
+     * size or if the contents can be read. */
+
+    frame_set->n_mapping_blocks++;
+    mappings = (tng_particle_mapping_t)realloc(
+            frame_set->mappings, sizeof(struct tng_particle_mapping) * frame_set->n_mapping_blocks);
+    if (!mappings)
     {
-        fprintf(stderr, "TNG library: Data type not supported. %s: %d\n", __FILE__, __LINE__);
-        return (TNG_FAILURE);
+        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+        free(frame_set->mappings);
+        frame_set->mappings = 0;
+        return (TNG_CRITICAL);
     }
+    frame_set->mappings = mappings;
+    mapping             = &mappings[frame_set->n_mapping_blocks - 1];
 
-    if (n_frames <= 0 || n_particles <= 0)
+
+    if (hash_mode == TNG_USE_HASH)
     {
-        fprintf(stderr,
-                "TNG library: Missing frames or particles. Cannot compress data "
-                "with the TNG method. %s: %d\n",
-                __FILE__, __LINE__);
-        return (TNG_FAILURE);
+        tng_block_hash_init(block, &hash_state);
     }
 
-    f_precision = 1 / (float)tng_data->compression_precision;
-    d_precision = 1 / tng_data->compression_precision;
+    if (tng_file_input_numerical_64_n(tng_data, values, 2, hash_mode, &hash_state, __LINE__)
+        != TNG_SUCCESS)
+    {
+        return (TNG_CRITICAL);
+    }
+    mapping->num_first_particle = (int64_t)values[0];
+    mapping->n_particles        = (int64_t)values[1];
 
-    if (block->id == TNG_TRAJ_POSITIONS)
+    mapping->real_particle_numbers = (int64_t*)malloc(mapping->n_particles * sizeof(int64_t));
+    if (!mapping->real_particle_numbers)
     {
-        /* If there is only one frame in this frame set and there might be more
-         * do not store the algorithm as the compression algorithm, but find
-         * the best one without storing it */
-        if (n_frames == 1 && tng_data->frame_set_n_frames > 1)
+        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+        return (TNG_CRITICAL);
+    }
+
+    /* The particle numbers are read all at once and their byte order swapped afterwards. */
+    if (tng_file_input_numerical_64_n(tng_data, mapping->real_particle_numbers,
+                                      mapping->n_particles, hash_mode, &hash_state, __LINE__)
+        != TNG_SUCCESS)
+    {
+        return (TNG_CRITICAL);
+    }
+
+    if (tng_particle_mapping_index_add(frame_set) != TNG_SUCCESS)
+    {
+        return (TNG_CRITICAL);
+    }
+
+    if (hash_mode == TNG_USE_HASH)
+    {
+        /* If there is data left in the block that the current version of the library
+         * cannot interpret still read that to generate the MD5 hash. */
+        tng_hash_remaining_append(tng_data, block, start_pos, &hash_state);
+
+        if (tng_block_hash_match_verify(block, &hash_state) != TNG_SUCCESS)
         {
-            nalgo    = tng_compress_nalgo();
-            alt_algo = (int*)malloc(nalgo * sizeof *tng_data->compress_algo_pos);
+            fprintf(stderr,
+                    "TNG library: Particle mapping block contents corrupt. Hashes do not "
+                    "match. "
+                    "%s: %d\n",
+                    __FILE__, __LINE__);
+        }
+    }
+    else
+    {
+        /* Seek to the end of the block */
+        tng_input_file_seek(tng_data, start_pos + block->block_contents_size, SEEK_SET);
+    }
 
-            /* If we have already determined the initial coding and
-             * initial coding parameter do not determine them again. */
-            if (tng_data->compress_algo_pos)
-            {
-                alt_algo[0] = tng_data->compress_algo_pos[0];
-                alt_algo[1] = tng_data->compress_algo_pos[1];
-                alt_algo[2] = tng_data->compress_algo_pos[2];
-                alt_algo[3] = tng_data->compress_algo_pos[3];
-            }
-            else
-            {
-                alt_algo[0] = -1;
-                alt_algo[1] = -1;
-                alt_algo[2] = -1;
-                alt_algo[3] = -1;
-            }
+    return (TNG_SUCCESS);
+}
 
-            /* If the initial coding and initial coding parameter are -1
-             * they will be determined in tng_compress_pos/_float/. */
-            if (type == TNG_FLOAT_DATA)
-            {
-                dest = tng_compress_pos_float((float*)*data, (int)n_particles, (int)n_frames,
-                                              f_precision, 0, alt_algo, &compressed_len);
-            }
-            else
-            {
-                dest = tng_compress_pos((double*)*data, (int)n_particles, (int)n_frames,
-                                        d_precision, 0, alt_algo, &compressed_len);
-            }
-            /* If there had been no algorithm determined before keep the initial coding
-             * and initial coding parameter so that they won't have to be determined again. */
-            if (!tng_data->compress_algo_pos)
-            {
-                nalgo                       = tng_compress_nalgo();
-                tng_data->compress_algo_pos = (int*)malloc(nalgo * sizeof *tng_data->compress_algo_pos);
-                tng_data->compress_algo_pos[0] = alt_algo[0];
-                tng_data->compress_algo_pos[1] = alt_algo[1];
-                tng_data->compress_algo_pos[2] = -1;
-                tng_data->compress_algo_pos[3] = -1;
-            }
+/**
+ * @brief Write the atom mappings of the current trajectory frame set
+ * @param tng_data is a trajectory data container.
+ * @param block is a general block container.
+ * @param mapping_block_nr is the index of the mapping block to write.
+ * @param hash_mode is an option to decide whether to use the md5 hash or not.
+ * If hash_mode == TNG_USE_HASH an md5 hash will be generated and written.
+ * @return TNG_SUCCESS (0) if successful, TNG_FAILURE (1) if a minor error
+ * has occurred or TNG_CRITICAL (2) if a major error has occured.
+ */
+static tng_function_status tng_trajectory_mapping_block_write(struct tng_trajectory* tng_data,
+                                                              struct tng_gen_block*  block,
+                                                              const int  mapping_block_nr,
+                                                              const char hash_mode)
+{
+    int64_t                header_file_pos;
+    char*                  temp_name;
+    int                    i;
+    unsigned int           name_len;
+    struct tng_hash_state  hash_state;
+    tng_particle_mapping_t mapping = &tng_data->current_trajectory_frame_set.mappings[mapping_block_nr];
+
+    if (mapping_block_nr >= tng_data->current_trajectory_frame_set.n_mapping_blocks)
+    {
+        fprintf(stderr, "TNG library: Mapping block index out of bounds. %s: %d\n", __FILE__, __LINE__);
+        return (TNG_FAILURE);
+    }
+
+    if (tng_output_file_init(tng_data) != TNG_SUCCESS)
+    {
+        return (TNG_CRITICAL);
+    }
+
+    name_len = (unsigned int)strlen("PARTICLE MAPPING");
+
+    if (!block->name || strlen(block->name) < name_len)
+    {
+        temp_name = (char*)realloc(block->name, name_len + 1);
+        if (!temp_name)
+        {
+            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+            free(block->name);
+            block->name = 0;
+            return (TNG_CRITICAL);
         }
-        else if (!tng_data->compress_algo_pos || tng_data->compress_algo_pos[2] == -1
-                 || tng_data->compress_algo_pos[2] == -1)
+        block->name = temp_name;
+    }
+    strcpy(block->name, "PARTICLE MAPPING");
+    block->id = TNG_PARTICLE_MAPPING;
+
+    if (tng_trajectory_mapping_block_len_calculate(tng_data, mapping->n_particles, &block->block_contents_size)
+        != TNG_SUCCESS)
+    {
+        fprintf(stderr, "TNG library: Cannot calculate length of atom mapping block. %s: %d\n",
+                __FILE__, __LINE__);
+        return (TNG_CRITICAL);
+    }
+
+    header_file_pos = ftello(tng_data->output_file);
+
+    if (tng_block_header_write(tng_data, block) != TNG_SUCCESS)
+    {
+        fprintf(stderr, "TNG library: Cannot write header of file %s. %s: %d\n",
+                tng_data->output_file_path, __FILE__, __LINE__);
+        return (TNG_CRITICAL);
+    }
+
+    if (hash_mode == TNG_USE_HASH)
+    {
+        tng_block_hash_init(block, &hash_state);
+    }
+    if (tng_file_output_numerical(tng_data, &mapping->num_first_particle,
+                                  sizeof(mapping->num_first_particle), hash_mode, &hash_state, __LINE__)
+        == TNG_CRITICAL)
+    {
+        return (TNG_CRITICAL);
+    }
+
+    if (tng_file_output_numerical(tng_data, &mapping->n_particles, sizeof(mapping->n_particles),
+                                  hash_mode, &hash_state, __LINE__)
+        == TNG_CRITICAL)
+    {
+        return (TNG_CRITICAL);
+    }
+
+    if (tng_data->output_endianness_swap_func_64)
+    {
+        for (i = 0; i < mapping->n_particles; i++)
         {
-            if (n_frames > 6)
+            if (tng_file_output_numerical(tng_data, &mapping->real_particle_numbers[i],
+                                          sizeof(int64_t), hash_mode, &hash_state, __LINE__)
+                == TNG_CRITICAL)
             {
-                algo_find_n_frames = 5;
+                return (TNG_CRITICAL);
             }
-            else
+        }
+    }
+    else
+    {
+        if (fwrite(mapping->real_particle_numbers, mapping->n_particles * sizeof(int64_t), 1, tng_data->output_file)
+            != 1)
+        {
+            fprintf(stderr, "TNG library: Could not write block data. %s: %d\n", __FILE__, __LINE__);
+            return (TNG_CRITICAL);
+        }
+        if (hash_mode == TNG_USE_HASH)
+        {
+            tng_hash_append(&hash_state, mapping->real_particle_numbers,
+                       mapping->n_particles * sizeof(int64_t));
+        }
+    }
+
+    if (hash_mode == TNG_USE_HASH
+        && tng_block_hash_write(tng_data, block, header_file_pos, &hash_state) != TNG_SUCCESS)
+    {
+        return (TNG_CRITICAL);
+    }
+
+    return (TNG_SUCCESS);
+}
+
+/**
+ * @brief Remove all entries from a frame set index.
+ * @param index is the frame set index to clear.
+ * @param valid specifies if the emptied index is a valid (complete) index of
+ * the file, i.e. if the file does not contain any frame sets.
+ */
+static void tng_frame_set_index_clear(struct tng_frame_set_index* index, const char valid)
+{
+    if (index->entries)
+    {
+        free(index->entries);
+        index->entries = 0;
+    }
+    index->n_entries           = 0;
+    index->n_allocated_entries = 0;
+    index->valid               = valid;
+    index->searched            = TNG_FALSE;
+}
+
+/**
+ * @brief Copy the entries of a frame set index.
+ * @param src is the frame set index to copy from.
+ * @param dest is the frame set index to copy to. Its previous entries are freed.
+ * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
+ * error has occured.
+ */
+static tng_function_status tng_frame_set_index_copy(const struct tng_frame_set_index* src,
+                                                    struct tng_frame_set_index*       dest)
+{
+    tng_frame_set_index_clear(dest, TNG_FALSE);
+
+    if (src->n_entries > 0)
+    {
+        dest->entries = (struct tng_frame_set_index_entry*)malloc(
+                sizeof(struct tng_frame_set_index_entry) * src->n_entries);
+        if (!dest->entries)
+        {
+            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+            return (TNG_CRITICAL);
+        }
+        memcpy(dest->entries, src->entries, sizeof(struct tng_frame_set_index_entry) * src->n_entries);
+    }
+    dest->n_entries           = src->n_entries;
+    dest->n_allocated_entries = src->n_entries;
+    dest->valid               = src->valid;
+    dest->searched            = src->searched;
+
+    return (TNG_SUCCESS);
+}
+
+/**
+ * @brief Add a frame set to a frame set index. If the frame set starts at the
+ * same frame as the last frame set in the index it has been rewritten and the
+ * last entry is updated instead.
+ * @param index is the frame set index to add the frame set to.
+ * @param first_frame is the first frame of the frame set.
+ * @param n_frames is the number of frames in the frame set.
+ * @param file_pos is the position of the frame set block in the file.
+ * @param first_frame_time is the time stamp of the first frame of the frame set.
+ * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
+ * error has occured.
+ */
+static tng_function_status tng_frame_set_index_entry_add(struct tng_frame_set_index* index,
+                                                         const int64_t               first_frame,
+                                                         const int64_t               n_frames,
+                                                         const int64_t               file_pos,
+                                                         const double                first_frame_time)
+{
+    struct tng_frame_set_index_entry *entry, *entries;
+    int64_t                           n_allocated;
+
+    if (index->n_entries > 0 && index->entries[index->n_entries - 1].first_frame == first_frame)
+    {
+        entry = &index->entries[index->n_entries - 1];
+    }
+    else
+    {
+        if (index->n_entries == index->n_allocated_entries)
+        {
+            n_allocated = index->n_allocated_entries > 0 ? index->n_allocated_entries * 2 : 64;
+            entries     = (struct tng_frame_set_index_entry*)realloc(
+                    index->entries, sizeof(struct tng_frame_set_index_entry) * n_allocated);
+            if (!entries)
             {
-                algo_find_n_frames = n_frames;
+                fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+                tng_frame_set_index_clear(index, TNG_FALSE);
+                return (TNG_CRITICAL);
             }
+            index->entries             = entries;
+            index->n_allocated_entries = n_allocated;
+        }
+        entry     = &index->entries[index->n_entries];
+        entry->nr = index->n_entries++;
+    }
+
+    entry->first_frame      = first_frame;
+    entry->n_frames         = n_frames;
+    entry->file_pos         = file_pos;
+    entry->first_frame_time = first_frame_time;
+
+    return (TNG_SUCCESS);
+}
+
+/**
+ * @brief Find the entry of the frame set containing a frame in a frame set index.
+ * @param index is the frame set index to search in.
+ * @param frame is the frame number to search for.
+ * @param nr is set to the frame set number of the last frame set starting at or
+ * before frame.
+ * @return TNG_SUCCESS (0) if successful or TNG_FAILURE (1) if frame is before
+ * the first frame set of the index.
+ */
+static tng_function_status tng_frame_set_index_frame_find(const struct tng_frame_set_index* index,
+                                                          const int64_t                     frame,
+                                                          int64_t*                          nr)
+{
+    int64_t low, high, mid;
+
+    if (index->n_entries <= 0 || frame < index->entries[0].first_frame)
+    {
+        return (TNG_FAILURE);
+    }
+
+    low  = 0;
+    high = index->n_entries - 1;
+    while (low < high)
+    {
+        mid = low + (high - low + 1) / 2;
+        if (index->entries[mid].first_frame <= frame)
+        {
+            low = mid;
+        }
+        else
+        {
+            high = mid - 1;
+        }
+    }
+    *nr = low;
+
+    return (TNG_SUCCESS);
+}
+
+static tng_function_status tng_frame_set_index_block_len_calculate(const struct tng_frame_set_index* index,
+                                                                   int64_t*                          len)
+{
+    *len = sizeof(int64_t);
+    *len += index->n_entries * (sizeof(int64_t) * 4 + sizeof(double));
+
+    return (TNG_SUCCESS);
+}
+
+/**
+ * @brief Read a frame set index block into tng_data->input_frame_set_index.
+ * The index is only used if it matches the frame sets of the input file, which
+ * is not the case for an index written before frames were appended to the file.
+ * @param tng_data is a trajectory data container.
+ * @param block is a general block container.
+ * @param hash_mode is an option to decide whether to use the md5 hash or not.
+ * If hash_mode == TNG_USE_HASH the written md5 hash in the file will be
+ * compared to the md5 hash of the read contents to ensure valid data.
+ * @return TNG_SUCCESS (0) if successful, TNG_FAILURE (1) if the index could not
+ * be used or TNG_CRITICAL (2) if a major error has occured.
+ */
+static tng_function_status tng_frame_set_index_block_read(struct tng_trajectory*      tng_data,
+                                                          const struct tng_gen_block* block,
+                                                          const char                  hash_mode)
+{
+    int64_t                           start_pos, n_entries, i;
+    struct tng_frame_set_index*       index = &tng_data->input_frame_set_index;
+    struct tng_frame_set_index_entry *entries, *entry;
+    struct tng_hash_state             hash_state;
+    tng_bool                          valid = TNG_TRUE;
+
+    if (tng_input_file_init(tng_data) != TNG_SUCCESS)
+    {
+        return (TNG_CRITICAL);
+    }
+
+    start_pos = tng_input_file_tell(tng_data);
+
+    /* A valid index has already been read or the output file is being read
+     * back, in which case the index does not describe the input file. */
+    if (index->valid || tng_data->input_file == tng_data->output_file)
+    {
+        tng_input_file_seek(tng_data, start_pos + block->block_contents_size, SEEK_SET);
+        return (TNG_SUCCESS);
+    }
+
+    if (hash_mode == TNG_USE_HASH)
+    {
+        tng_block_hash_init(block, &hash_state);
+    }
+
+    if (tng_file_input_numerical(tng_data, &n_entries, sizeof(n_entries), hash_mode, &hash_state, __LINE__)
+        == TNG_CRITICAL)
+    {
+        return (TNG_CRITICAL);
+    }
+
+    if (n_entries <= 0
+        || n_entries > (block->block_contents_size - (int64_t)sizeof(int64_t))
+                               / (int64_t)(sizeof(int64_t) * 4 + sizeof(double)))
+    {
+        fprintf(stderr, "TNG library: Frame set index block contents corrupt. %s: %d\n", __FILE__, __LINE__);
+        tng_input_file_seek(tng_data, start_pos + block->block_contents_size, SEEK_SET);
+        return (TNG_FAILURE);
+    }
+
+    entries = (struct tng_frame_set_index_entry*)malloc(sizeof(struct tng_frame_set_index_entry) * n_entries);
+    if (!entries)
+    {
+        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+        return (TNG_CRITICAL);
+    }
+
+    for (i = 0; i < n_entries; i++)
+    {
+        entry = &entries[i];
+        if (tng_file_input_numerical(tng_data, &entry->nr, sizeof(entry->nr), hash_mode, &hash_state, __LINE__)
+                    == TNG_CRITICAL
+            || tng_file_input_numerical(tng_data, &entry->first_frame, sizeof(entry->first_frame),
+                                        hash_mode, &hash_state, __LINE__)
+                       == TNG_CRITICAL
+            || tng_file_input_numerical(tng_data, &entry->n_frames, sizeof(entry->n_frames), hash_mode,
+                                        &hash_state, __LINE__)
+                       == TNG_CRITICAL
+            || tng_file_input_numerical(tng_data, &entry->file_pos, sizeof(entry->file_pos), hash_mode,
+                                        &hash_state, __LINE__)
+                       == TNG_CRITICAL
+            || tng_file_input_numerical(tng_data, &entry->first_frame_time, sizeof(entry->first_frame_time),
+                                        hash_mode, &hash_state, __LINE__)
+                       == TNG_CRITICAL)
+        {
+            free(entries);
+            return (TNG_CRITICAL);
+        }
+
+        /* The frame sets must be listed in order and point into the file. */
+        if (entry->nr != i || entry->file_pos <= 0 || entry->file_pos >= tng_data->input_file_len
+            || (i > 0 && (entry->first_frame < entries[i - 1].first_frame
+                          || entry->file_pos == entries[i - 1].file_pos)))
+        {
+            valid = TNG_FALSE;
+        }
+    }
+
+    if (hash_mode == TNG_USE_HASH)
+    {
+        /* If there is data left in the block that the current version of the library
+         * cannot interpret still read that to generate the MD5 hash. */
+        tng_hash_remaining_append(tng_data, block, start_pos, &hash_state);
+
+        if (tng_block_hash_match_verify(block, &hash_state) != TNG_SUCCESS)
+        {
+            fprintf(stderr,
+                    "TNG library: Frame set index block contents corrupt. Hashes do not match. "
+                    "%s: %d\n",
+                    __FILE__, __LINE__);
+            valid = TNG_FALSE;
+        }
+    }
+    else
+    {
+        /* Seek to the end of the block */
+        tng_input_file_seek(tng_data, start_pos + block->block_contents_size, SEEK_SET);
+    }
+
+    /* An index written before more frame sets were appended to the file does
+     * not end at the last frame set. */
+    if (entries[0].file_pos != tng_data->first_trajectory_frame_set_input_file_pos
+        || entries[n_entries - 1].file_pos != tng_data->last_trajectory_frame_set_input_file_pos)
+    {
+        valid = TNG_FALSE;
+    }
+
+    if (!valid)
+    {
+        free(entries);
+        return (TNG_FAILURE);
+    }
+
+    tng_frame_set_index_clear(index, TNG_TRUE);
+    index->entries             = entries;
+    index->n_entries           = n_entries;
+    index->n_allocated_entries = n_entries;
+    index->searched            = TNG_TRUE;
+
+    return (TNG_SUCCESS);
+}
+
+/**
+ * @brief Write tng_data->output_frame_set_index as a frame set index block.
+ * @param tng_data is a trajectory data container.
+ * @param block is a general block container.
+ * @param hash_mode is an option to decide whether to use the md5 hash or not.
+ * If hash_mode == TNG_USE_HASH an md5 hash will be generated and written.
+ * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
+ * error has occured.
+ */
+static tng_function_status tng_frame_set_index_block_write(struct tng_trajectory* tng_data,
+                                                           struct tng_gen_block*  block,
+                                                           const char             hash_mode)
+{
+    int64_t                           header_file_pos, i;
+    char*                             temp_name;
+    unsigned int                      name_len;
+    struct tng_hash_state             hash_state;
+    struct tng_frame_set_index*       index = &tng_data->output_frame_set_index;
+    struct tng_frame_set_index_entry* entry;
+
+    if (tng_output_file_init(tng_data) != TNG_SUCCESS)
+    {
+        return (TNG_CRITICAL);
+    }
+
+    name_len = (unsigned int)strlen("FRAME SET INDEX");
+
+    if (!block->name || strlen(block->name) < name_len)
+    {
+        temp_name = (char*)realloc(block->name, name_len + 1);
+        if (!temp_name)
+        {
+            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+            free(block->name);
+            block->name = 0;
+            return (TNG_CRITICAL);
+        }
+        block->name = temp_name;
+    }
+    strcpy(block->name, "FRAME SET INDEX");
+    block->id = TNG_FRAME_SET_INDEX;
+
+    tng_frame_set_index_block_len_calculate(index, &block->block_contents_size);
+
+    header_file_pos = ftello(tng_data->output_file);
+
+    if (tng_block_header_write(tng_data, block) != TNG_SUCCESS)
+    {
+        fprintf(stderr, "TNG library: Cannot write header of file %s. %s: %d\n",
+                tng_data->output_file_path, __FILE__, __LINE__);
+        return (TNG_CRITICAL);
+    }
+
+    if (hash_mode == TNG_USE_HASH)
+    {
+        tng_block_hash_init(block, &hash_state);
+    }
+
+    if (tng_file_output_numerical(tng_data, &index->n_entries, sizeof(index->n_entries), hash_mode,
+                                  &hash_state, __LINE__)
+        == TNG_CRITICAL)
+    {
+        return (TNG_CRITICAL);
+    }
+
+    for (i = 0; i < index->n_entries; i++)
+    {
+        entry = &index->entries[i];
+        if (tng_file_output_numerical(tng_data, &entry->nr, sizeof(entry->nr), hash_mode, &hash_state, __LINE__)
+                    == TNG_CRITICAL
+            || tng_file_output_numerical(tng_data, &entry->first_frame, sizeof(entry->first_frame),
+                                         hash_mode, &hash_state, __LINE__)
+                       == TNG_CRITICAL
+            || tng_file_output_numerical(tng_data, &entry->n_frames, sizeof(entry->n_frames),
+                                         hash_mode, &hash_state, __LINE__)
+                       == TNG_CRITICAL
+            || tng_file_output_numerical(tng_data, &entry->file_pos, sizeof(entry->file_pos),
+                                         hash_mode, &hash_state, __LINE__)
+                       == TNG_CRITICAL
+            || tng_file_output_numerical(tng_data, &entry->first_frame_time, sizeof(entry->first_frame_time),
+                                         hash_mode, &hash_state, __LINE__)
+                       == TNG_CRITICAL)
+        {
+            return (TNG_CRITICAL);
+        }
+    }
+
+    if (hash_mode == TNG_USE_HASH
+        && tng_block_hash_write(tng_data, block, header_file_pos, &hash_state) != TNG_SUCCESS)
+    {
+        return (TNG_CRITICAL);
+    }
+
+    return (TNG_SUCCESS);
+}
+
+/**
+ * @brief Make tng_data->input_frame_set_index available. The index block is
+ * written after the last frame set, so only the block headers of the last frame
+ * set are read to find it. The input file is only searched once.
+ * The index is not used when the output file is read (input_file == output_file),
+ * e.g. when updating or appending to a file.
+ * @param tng_data is a trajectory data container.
+ * @return TNG_SUCCESS (0) if a valid frame set index is available or
+ * TNG_FAILURE (1) if not.
+ */
+static tng_function_status tng_frame_set_index_input_find(struct tng_trajectory* tng_data)
+{
+    int64_t                     file_pos, orig_file_pos;
+    struct tng_frame_set_index* index = &tng_data->input_frame_set_index;
+    tng_gen_block_t             block;
+
+    if (tng_data->input_file && tng_data->input_file == tng_data->output_file)
+    {
+        return (TNG_FAILURE);
+    }
+    if (index->valid)
+    {
+        if (index->entries[index->n_entries - 1].file_pos == tng_data->last_trajectory_frame_set_input_file_pos)
+        {
+            return (TNG_SUCCESS);
+        }
+        /* Frame sets have been added since the index was read. */
+        tng_frame_set_index_clear(index, TNG_FALSE);
+    }
+    if (index->searched)
+    {
+        return (TNG_FAILURE);
+    }
+    index->searched = TNG_TRUE;
+
+    file_pos = tng_data->last_trajectory_frame_set_input_file_pos;
+    if (file_pos <= 0 || tng_input_file_init(tng_data) != TNG_SUCCESS)
+    {
+        return (TNG_FAILURE);
+    }
+
+    orig_file_pos = tng_input_file_tell(tng_data);
+
+    tng_block_init(&block);
+    tng_input_file_seek(tng_data, file_pos, SEEK_SET);
+    if (tng_block_header_read(tng_data, block) == TNG_SUCCESS && block->id == TNG_TRAJECTORY_FRAME_SET)
+    {
+        file_pos += block->header_contents_size + block->block_contents_size;
+        while (file_pos < tng_data->input_file_len)
+        {
+            tng_input_file_seek(tng_data, file_pos, SEEK_SET);
+            if (tng_block_header_read(tng_data, block) != TNG_SUCCESS
+                || block->id == TNG_TRAJECTORY_FRAME_SET)
+            {
+                break;
+            }
+            if (block->id == TNG_FRAME_SET_INDEX)
+            {
+                tng_frame_set_index_block_read(tng_data, block, TNG_USE_HASH);
+                break;
+            }
+            file_pos += block->header_contents_size + block->block_contents_size;
+        }
+    }
+    tng_block_destroy(&block);
+
+    tng_input_file_seek(tng_data, orig_file_pos, SEEK_SET);
+
+    return (index->valid ? TNG_SUCCESS : TNG_FAILURE);
+}
+
+/**
+ * @brief Read the frame set block of a frame set listed in
+ * tng_data->input_frame_set_index. Update tng_data->current_trajectory_frame_set
+ * @param tng_data is a trajectory data container.
+ * @param nr is the number of the frame set to read.
+ * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
+ * error has occured.
+ */
+static tng_function_status tng_frame_set_index_entry_read(struct tng_trajectory* tng_data, const int64_t nr)
+{
+    int64_t             file_pos;
+    tng_gen_block_t     block;
+    tng_function_status stat;
+
+    file_pos = tng_data->input_frame_set_index.entries[nr].file_pos;
+
+    tng_block_init(&block);
+    tng_input_file_seek(tng_data, file_pos, SEEK_SET);
+    tng_data->current_trajectory_frame_set_input_file_pos = file_pos;
+    /* Read block headers first to see what block is found. */
+    stat = tng_block_header_read(tng_data, block);
+    if (stat == TNG_CRITICAL || block->id != TNG_TRAJECTORY_FRAME_SET)
+    {
+        fprintf(stderr, "TNG library: Cannot read block header at pos %" PRId64 ". %s: %d\n",
+                file_pos, __FILE__, __LINE__);
+        tng_block_destroy(&block);
+        return (TNG_CRITICAL);
+    }
+
+    stat = tng_block_read_next(tng_data, block, TNG_SKIP_HASH);
+    tng_block_destroy(&block);
+
+    return (stat == TNG_SUCCESS ? TNG_SUCCESS : TNG_CRITICAL);
+}
+
+/**
+ * @brief Get the first slot to probe for a block ID in a data block index.
+ * @param index is the data block index.
+ * @param id is the block ID.
+ * @return the slot number.
+ */
+static int tng_data_block_index_slot(const struct tng_data_block_index* index, const int64_t id)
+{
+    uint64_t hash = ((uint64_t)id * UINT64_C(0x9E3779B97F4A7C15)) >> 32;
+
+    return ((int)(hash & (uint64_t)(index->n_slots - 1)));
+}
+
+/**
+ * @brief Insert a data block into a data block index. If a block with the
+ * same ID is already indexed the earlier block is kept, so that lookups find
+ * the first block with an ID, as a scan of the list would.
+ * @param index is the data block index. It must have at least one empty slot.
+ * @param list is the list of data blocks.
+ * @param pos is the position of the data block in the list.
+ */
+static void tng_data_block_index_insert(struct tng_data_block_index* index,
+                                        const struct tng_data*       list,
+                                        const int                    pos)
+{
+    int slot = tng_data_block_index_slot(index, list[pos].block_id);
+
+    while (index->slots[slot] != -1)
+    {
+        if (list[index->slots[slot]].block_id == list[pos].block_id)
+        {
+            return;
+        }
+        slot = (slot + 1) & (index->n_slots - 1);
+    }
+    index->slots[slot] = pos;
+}
+
+/**
+ * @brief Add the last data block of a list to its data block index. The
+ * table is rebuilt with more slots when it becomes more than half full.
+ * @param index is the data block index.
+ * @param list is the list of data blocks.
+ * @param n_blocks is the number of data blocks in the list, including the
+ * added block.
+ * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
+ * error has occured.
+ */
+static tng_function_status tng_data_block_index_add(struct tng_data_block_index* index,
+                                                    const struct tng_data*       list,
+                                                    const int                    n_blocks)
+{
+    int  n_slots, i;
+    int* slots;
+
+    if (n_blocks * 2 <= index->n_slots)
+    {
+        tng_data_block_index_insert(index, list, n_blocks - 1);
+        return (TNG_SUCCESS);
+    }
+
+    n_slots = index->n_slots > 0 ? index->n_slots : 8;
+    while (n_blocks * 2 > n_slots)
+    {
+        n_slots *= 2;
+    }
+    slots = (int*)malloc(sizeof(int) * n_slots);
+    if (!slots)
+    {
+        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+        return (TNG_CRITICAL);
+    }
+    for (i = 0; i < n_slots; i++)
+    {
+        slots[i] = -1;
+    }
+    free(index->slots);
+    index->slots   = slots;
+    index->n_slots = n_slots;
+    for (i = 0; i < n_blocks; i++)
+    {
+        tng_data_block_index_insert(index, list, i);
+    }
+
+    return (TNG_SUCCESS);
+}
+
+/**
+ * @brief Find a data block in a list of data blocks using its index.
+ * @param index is the data block index of the list.
+ * @param list is the list of data blocks.
+ * @param id is the ID of the data block to find.
+ * @return the first data block with the ID or 0 if there is none.
+ */
+static tng_data_t tng_data_block_index_find(const struct tng_data_block_index* index,
+                                            struct tng_data*                   list,
+                                            const int64_t                      id)
+{
+    int slot;
+
+    if (index->n_slots == 0)
+    {
+        return (0);
+    }
+    slot = tng_data_block_index_slot(index, id);
+    while (index->slots[slot] != -1)
+    {
+        if (list[index->slots[slot]].block_id == id)
+        {
+            return (&list[index->slots[slot]]);
+        }
+        slot = (slot + 1) & (index->n_slots - 1);
+    }
+    return (0);
+}
+
+/**
+ * @brief Free the memory of a data block index.
+ * @param index is the data block index.
+ */
+static void tng_data_block_index_destroy(struct tng_data_block_index* index)
+{
+    free(index->slots);
+    index->slots   = 0;
+    index->n_slots = 0;
+}
+
+/**
+ * @brief Prepare a block for storing particle data
+ * @param tng_data is a trajectory data container.
+ * @param block_id is the ID of the block.
+ * @param block_type_flag specifies if this is a trajectory block or a
+ * non-trajectory block. (TNG_TRAJECTORY_BLOCK or TNG_NON_TRAJECTORY_BLOCK)
+ * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
+ * error has occured.
+ */
+static tng_function_status tng_particle_data_block_create(struct tng_trajectory* tng_data,
+                                                          const int64_t          block_id,
+                                                          const char             block_type_flag)
+{
+    tng_trajectory_frame_set_t frame_set = &tng_data->current_trajectory_frame_set;
+
+    tng_data_t data;
+
+    if (block_type_flag == TNG_TRAJECTORY_BLOCK)
+    {
+        frame_set->n_particle_data_blocks++;
+        data = (tng_data_t)realloc(frame_set->tr_particle_data,
+                                   sizeof(struct tng_data) * frame_set->n_particle_data_blocks);
+        if (!data)
+        {
+            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+            free(frame_set->tr_particle_data);
+            frame_set->tr_particle_data = 0;
+            return (TNG_CRITICAL);
+        }
+        frame_set->tr_particle_data = data;
+        data[frame_set->n_particle_data_blocks - 1].block_id = block_id;
+        return (tng_data_block_index_add(&frame_set->tr_particle_data_index, data,
+                                         frame_set->n_particle_data_blocks));
+    }
+    else
+    {
+        tng_data->n_particle_data_blocks++;
+        data = (tng_data_t)realloc(tng_data->non_tr_particle_data,
+                                   sizeof(struct tng_data) * tng_data->n_particle_data_blocks);
+        if (!data)
+        {
+            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+            free(tng_data->non_tr_particle_data);
+            tng_data->non_tr_particle_data = 0;
+            return (TNG_CRITICAL);
+        }
+        tng_data->non_tr_particle_data = data;
+        data[tng_data->n_particle_data_blocks - 1].block_id = block_id;
+        return (tng_data_block_index_add(&tng_data->non_tr_particle_data_index, data,
+                                         tng_data->n_particle_data_blocks));
+    }
+}
+
+static tng_function_status tng_compress(struct tng_trajectory* tng_data,
+                                        const int64_t          block_id,
+                                        const int64_t          n_frames,
+                                        const int64_t          n_particles,
+                                        const char             type,
+                                        char**                 data,
+                                        int64_t*               new_len)
+{
+    int     nalgo;
+    int     compressed_len;
+    int*    alt_algo = 0;
+    char*   dest;
+    int64_t algo_find_n_frames = -1;
+    float   f_precision;
+    double  d_precision;
+
+    if (block_id != TNG_TRAJ_POSITIONS && block_id != TNG_TRAJ_VELOCITIES)
+    {
+        fprintf(stderr,
+                "TNG library: Can only compress positions and velocities with the "
+                "TNG method. %s: %d\n",
+                __FILE__, __LINE__);
+        return (TNG_FAILURE);
+    }
+    if (type != TNG_FLOAT_DATA && type != TNG_DOUBLE_DATA)
+    {
+        fprintf(stderr, "TNG library: Data type not supported. %s: %d\n", __FILE__, __LINE__);
+        return (TNG_FAILURE);
+    }
+
+    if (n_frames <= 0 || n_particles <= 0)
+    {
+        fprintf(stderr,
+                "TNG library: Missing frames or particles. Cannot compress data "
+                "with the TNG method. %s: %d\n",
+                __FILE__, __LINE__);
+        return (TNG_FAILURE);
+    }
+
+    f_precision = 1 / (float)tng_data->compression_precision;
+    d_precision = 1 / tng_data->compression_precision;
+
+    if (block_id == TNG_TRAJ_POSITIONS)
+    {
+        /* If there is only one frame in this frame set and there might be more
+         * do not store the algorithm as the compression algorithm, but find
+         * the best one without storing it */
+        if (n_frames == 1 && tng_data->frame_set_n_frames > 1)
+        {
+            nalgo    = tng_compress_nalgo();
+            alt_algo = (int*)malloc(nalgo * sizeof *tng_data->compress_algo_pos);
+
+            /* If we have already determined the initial coding and
+             * initial coding parameter do not determine them again. */
+            if (tng_data->compress_algo_pos)
+            {
+                alt_algo[0] = tng_data->compress_algo_pos[0];
+                alt_algo[1] = tng_data->compress_algo_pos[1];
+                alt_algo[2] = tng_data->compress_algo_pos[2];
+                alt_algo[3] = tng_data->compress_algo_pos[3];
+            }
+            else
+            {
+                alt_algo[0] = -1;
+                alt_algo[1] = -1;
+                alt_algo[2] = -1;
+                alt_algo[3] = -1;
+            }
+
+            /* If the initial coding and initial coding parameter are -1
+             * they will be determined in tng_compress_pos/_float/. */
+            if (type == TNG_FLOAT_DATA)
+            {
+                dest = tng_compress_pos_float((float*)*data, (int)n_particles, (int)n_frames,
+                                              f_precision, 0, alt_algo, &compressed_len);
+            }
+            else
+            {
+                dest = tng_compress_pos((double*)*data, (int)n_particles, (int)n_frames,
+                                        d_precision, 0, alt_algo, &compressed_len);
+            }
+            /* If there had been no algorithm determined before keep the initial coding
+             * and initial coding parameter so that they won't have to be determined again. */
+            if (!tng_data->compress_algo_pos)
+            {
+                nalgo                       = tng_compress_nalgo();
+                tng_data->compress_algo_pos = (int*)malloc(nalgo * sizeof *tng_data->compress_algo_pos);
+                tng_data->compress_algo_pos[0] = alt_algo[0];
+                tng_data->compress_algo_pos[1] = alt_algo[1];
+                tng_data->compress_algo_pos[2] = -1;
+                tng_data->compress_algo_pos[3] = -1;
+            }
+        }
+        else if (!tng_data->compress_algo_pos || tng_data->compress_algo_pos[2] == -1
+                 || tng_data->compress_algo_pos[2] == -1)
+        {
+            if (n_frames > 6)
+            {
+                algo_find_n_frames = 5;
+            }
+            else
+            {
+                algo_find_n_frames = n_frames;
+            }
+
+            /* If the algorithm parameters are -1 they will be determined during the
+             * compression. */
+            if (!tng_data->compress_algo_pos)
+            {
+                nalgo                       = tng_compress_nalgo();
+                tng_data->compress_algo_pos = (int*)malloc(nalgo * sizeof *tng_data->compress_algo_pos);
+                tng_data->compress_algo_pos[0] = -1;
+                tng_data->compress_algo_pos[1] = -1;
+                tng_data->compress_algo_pos[2] = -1;
+                tng_data->compress_algo_pos[3] = -1;
+            }
+            if (type == TNG_FLOAT_DATA)
+            {
+                dest = tng_compress_pos_float((float*)*data, (int)n_particles,
+                                              (int)algo_find_n_frames, f_precision, 0,
+                                              tng_data->compress_algo_pos, &compressed_len);
+
+                if (algo_find_n_frames < n_frames)
+                {
+                    free(dest);
+                    dest = tng_compress_pos_float((float*)*data, (int)n_particles, (int)n_frames, f_precision,
+                                                  0, tng_data->compress_algo_pos, &compressed_len);
+                }
+            }
+            else
+            {
+                dest = tng_compress_pos((double*)*data, (int)n_particles, (int)algo_find_n_frames,
+                                        d_precision, 0, tng_data->compress_algo_pos, &compressed_len);
+
+                if (algo_find_n_frames < n_frames)
+                {
+                    free(dest);
+                    dest = tng_compress_pos((double*)*data, (int)n_particles, (int)n_frames, d_precision,
+                                            0, tng_data->compress_algo_pos, &compressed_len);
+                }
+            }
+        }
+        else
+        {
+            if (type == TNG_FLOAT_DATA)
+            {
+                dest = tng_compress_pos_float((float*)*data, (int)n_particles, (int)n_frames, f_precision,
+                                              0, tng_data->compress_algo_pos, &compressed_len);
+            }
+            else
+            {
+                dest = tng_compress_pos((double*)*data, (int)n_particles, (int)n_frames, d_precision,
+                                        0, tng_data->compress_algo_pos, &compressed_len);
+            }
+        }
+    }
+    else if (block_id == TNG_TRAJ_VELOCITIES)
+    {
+        /* If there is only one frame in this frame set and there might be more
+         * do not store the algorithm as the compression algorithm, but find
+         * the best one without storing it */
+        if (n_frames == 1 && tng_data->frame_set_n_frames > 1)
+        {
+            nalgo    = tng_compress_nalgo();
+            alt_algo = (int*)malloc(nalgo * sizeof *tng_data->compress_algo_vel);
+
+            /* If we have already determined the initial coding and
+             * initial coding parameter do not determine them again. */
+            if (tng_data->compress_algo_vel)
+            {
+                alt_algo[0] = tng_data->compress_algo_vel[0];
+                alt_algo[1] = tng_data->compress_algo_vel[1];
+                alt_algo[2] = tng_data->compress_algo_vel[2];
+                alt_algo[3] = tng_data->compress_algo_vel[3];
+            }
+            else
+            {
+                alt_algo[0] = -1;
+                alt_algo[1] = -1;
+                alt_algo[2] = -1;
+                alt_algo[3] = -1;
+            }
+
+            /* If the initial coding and initial coding parameter are -1
+             * they will be determined in tng_compress_pos/_float/. */
+            if (type == TNG_FLOAT_DATA)
+            {
+                dest = tng_compress_vel_float((float*)*data, (int)n_particles, (int)n_frames,
+                                              f_precision, 0, alt_algo, &compressed_len);
+            }
+            else
+            {
+                dest = tng_compress_vel((double*)*data, (int)n_particles, (int)n_frames,
+                                        d_precision, 0, alt_algo, &compressed_len);
+            }
+            /* If there had been no algorithm determined before keep the initial coding
+             * and initial coding parameter so that they won't have to be determined again. */
+            if (!tng_data->compress_algo_vel)
+            {
+                nalgo                       = tng_compress_nalgo();
+                tng_data->compress_algo_vel = (int*)malloc(nalgo * sizeof *tng_data->compress_algo_vel);
+                tng_data->compress_algo_vel[0] = alt_algo[0];
+                tng_data->compress_algo_vel[1] = alt_algo[1];
+                tng_data->compress_algo_vel[2] = -1;
+                tng_data->compress_algo_vel[3] = -1;
+            }
+        }
+        else if (!tng_data->compress_algo_vel || tng_data->compress_algo_vel[2] == -1
+                 || tng_data->compress_algo_vel[2] == -1)
+        {
+            if (n_frames > 6)
+            {
+                algo_find_n_frames = 5;
+            }
+            else
+            {
+                algo_find_n_frames = n_frames;
+            }
+
+            /* If the algorithm parameters are -1 they will be determined during the
+             * compression. */
+            if (!tng_data->compress_algo_vel)
+            {
+                nalgo                       = tng_compress_nalgo();
+                tng_data->compress_algo_vel = (int*)malloc(nalgo * sizeof *tng_data->compress_algo_vel);
+                tng_data->compress_algo_vel[0] = -1;
+                tng_data->compress_algo_vel[1] = -1;
+                tng_data->compress_algo_vel[2] = -1;
+                tng_data->compress_algo_vel[3] = -1;
+            }
+            if (type == TNG_FLOAT_DATA)
+            {
+                dest = tng_compress_vel_float((float*)*data, (int)n_particles,
+                                              (int)algo_find_n_frames, f_precision, 0,
+                                              tng_data->compress_algo_vel, &compressed_len);
+                if (algo_find_n_frames < n_frames)
+                {
+                    free(dest);
+                    dest = tng_compress_vel_float((float*)*data, (int)n_particles, (int)n_frames, f_precision,
+                                                  0, tng_data->compress_algo_vel, &compressed_len);
+                }
+            }
+            else
+            {
+                dest = tng_compress_vel((double*)*data, (int)n_particles, (int)algo_find_n_frames,
+                                        d_precision, 0, tng_data->compress_algo_vel, &compressed_len);
+                if (algo_find_n_frames < n_frames)
+                {
+                    free(dest);
+                    dest = tng_compress_vel((double*)*data, (int)n_particles, (int)n_frames, d_precision,
+                                            0, tng_data->compress_algo_vel, &compressed_len);
+                }
+            }
+        }
+        else
+        {
+            if (type == TNG_FLOAT_DATA)
+            {
+                dest = tng_compress_vel_float((float*)*data, (int)n_particles, (int)n_frames, f_precision,
+                                              0, tng_data->compress_algo_vel, &compressed_len);
+            }
+            else
+            {
+                dest = tng_compress_vel((double*)*data, (int)n_particles, (int)n_frames, d_precision,
+                                        0, tng_data->compress_algo_vel, &compressed_len);
+            }
+        }
+    }
+    else
+    {
+        fprintf(stderr,
+                "TNG library: Can only compress positions and velocities using TNG-MF1 "
+                "algorithms.\n");
+        return (TNG_FAILURE);
+    }
+
+    if (alt_algo)
+    {
+        free(alt_algo);
+    }
+
+    free(*data);
+
+    *data = dest;
+
+    *new_len = compressed_len;
+
+    return (TNG_SUCCESS);
+}
+
+static tng_function_status tng_uncompress(const struct tng_trajectory* tng_data,
+                                          const struct tng_gen_block*  block,
+                                          const char                   type,
+                                          char*                        contents,
+                                          void*                        dest)
+{
+    int result;
+    (void)tng_data;
+
+    if (block->id != TNG_TRAJ_POSITIONS && block->id != TNG_TRAJ_VELOCITIES)
+    {
+        fprintf(stderr,
+                "TNG library: Can only uncompress positions and velocities with the"
+                "TNG method.\n");
+        return (TNG_FAILURE);
+    }
+    if (type != TNG_FLOAT_DATA && type != TNG_DOUBLE_DATA)
+    {
+        fprintf(stderr, "TNG library: Data type not supported.\n");
+        return (TNG_FAILURE);
+    }
+
+    if (type == TNG_FLOAT_DATA)
+    {
+        result = tng_compress_uncompress_float(contents, (float*)dest);
+    }
+    else
+    {
+        result = tng_compress_uncompress(contents, (double*)dest);
+    }
+
+    if (result == 1)
+    {
+        fprintf(stderr, "TNG library: Cannot uncompress TNG compressed block.\n");
+        return (TNG_FAILURE);
+    }
+
+    return (TNG_SUCCESS);
+}
+
+static tng_function_status tng_gzip_compress(const struct tng_trajectory* tng_data,
+                                             char**                       data,
+                                             const int64_t                len,
+                                             int64_t*                     new_len)
+{
+    Bytef* dest;
+    uLongf stat, max_len;
+    (void)tng_data;
+
+    max_len = compressBound(len);
+    dest    = (Bytef*)malloc(max_len);
+    if (!dest)
+    {
+        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+        return (TNG_CRITICAL);
+    }
+
+    stat = compress(dest, &max_len, (Bytef*)*data, len);
+    if (stat != (unsigned long)Z_OK)
+    {
+        free(dest);
+        if (stat == (unsigned long)Z_MEM_ERROR)
+        {
+            fprintf(stderr, "TNG library: Not enough memory. ");
+        }
+        else if (stat == (unsigned long)Z_BUF_ERROR)
+        {
+            fprintf(stderr, "TNG library: Destination buffer too small. ");
+        }
+        fprintf(stderr, "TNG library: Error gzipping data. %s: %d\n", __FILE__, __LINE__);
+        return (TNG_FAILURE);
+    }
+
+    *new_len = max_len;
+
+    free(*data);
+
+    *data = (char*)dest;
+
+    return (TNG_SUCCESS);
+}
+
+static tng_function_status tng_gzip_uncompress(const struct tng_trajectory* tng_data,
+                                               const char*                  contents,
+                                               const int64_t                compressed_len,
+                                               void*                        dest,
+                                               const int64_t                uncompressed_len)
+{
+    unsigned long stat;
+    (void)tng_data;
+    uLongf new_len = uncompressed_len;
+
+    stat = uncompress((Bytef*)dest, &new_len, (const Bytef*)contents, compressed_len);
+
+    if (stat != Z_OK)
+    {
+        if (stat == (unsigned long)Z_MEM_ERROR)
+        {
+            fprintf(stderr, "TNG library: Not enough memory. ");
+        }
+        else if (stat == (unsigned long)Z_BUF_ERROR)
+        {
+            fprintf(stderr, "TNG library: Destination buffer too small. ");
+        }
+        else if (stat == (unsigned long)Z_DATA_ERROR)
+        {
+            fprintf(stderr, "TNG library: Data corrupt. ");
+        }
+        fprintf(stderr, "TNG library: Error uncompressing gzipped data. %s: %d\n", __FILE__, __LINE__);
+        return (TNG_FAILURE);
+    }
+
+    return (TNG_SUCCESS);
+}
+
+/**
+ * @brief Free the strings of a character data block. The string pointers and
+ * the tables pointing into them are stored contiguously, see
+ * tng_data_strings_alloc().
+ * @param data is the data block.
+ * @param n_particles is the number of particles of the data, 1 if the data is
+ * not particle dependent.
+ */
+static void tng_data_strings_free(struct tng_data* data, const int64_t n_particles)
+{
+    int64_t i, n_strings;
+    char**  strings;
+
+    if (!data->strings)
+    {
+        return;
+    }
+    if (data->strings[0])
+    {
+        strings = data->strings[0][0];
+        if (strings)
+        {
+            n_strings = ((tng_max_i64(1, data->n_frames) - 1) / tng_max_i64(1, data->stride_length) + 1)
+                        * n_particles * data->n_values_per_frame;
+            for (i = 0; i < n_strings; i++)
+            {
+                if (strings[i])
+                {
+                    free(strings[i]);
+                }
+            }
+            free(strings);
+        }
+        free(data->strings[0]);
+    }
+    free(data->strings);
+    data->strings = 0;
+}
+
+/**
+ * @brief Allocate the strings of a character data block. All string pointers
+ * are stored in one block, which the two outer dimensions of data->strings
+ * point into, so that only three allocations are needed.
+ * Particle data is indexed as strings[frame][particle][value] and non-particle
+ * data as strings[0][frame][value].
+ * @param data is the data block.
+ * @param n_outer is the size of the first dimension (the number of frames for
+ * particle data, 1 for non-particle data).
+ * @param n_inner is the size of the second dimension (the number of particles
+ * for particle data, the number of frames for non-particle data).
+ * @param n_values_per_frame is the number of values per frame (and particle).
+ * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
+ * error has occured.
+ */
+static tng_function_status tng_data_strings_alloc(struct tng_data* data,
+                                                  const int64_t    n_outer,
+                                                  const int64_t    n_inner,
+                                                  const int64_t    n_values_per_frame)
+{
+    int64_t i;
+
+    data->strings = (char****)malloc(sizeof(char***) * n_outer);
+    if (!data->strings)
+    {
+        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+        return (TNG_CRITICAL);
+    }
+    data->strings[0] = (char***)malloc(sizeof(char**) * n_outer * n_inner);
+    if (!data->strings[0])
+    {
+        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+        free(data->strings);
+        data->strings = 0;
+        return (TNG_CRITICAL);
+    }
+    data->strings[0][0] = (char**)calloc(n_outer * n_inner * n_values_per_frame, sizeof(char*));
+    if (!data->strings[0][0])
+    {
+        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+        free(data->strings[0]);
+        free(data->strings);
+        data->strings = 0;
+        return (TNG_CRITICAL);
+    }
+
+    for (i = 1; i < n_outer; i++)
+    {
+        data->strings[i] = data->strings[0] + i * n_inner;
+    }
+    for (i = 1; i < n_outer * n_inner; i++)
+    {
+        data->strings[0][i] = data->strings[0][0] + i * n_values_per_frame;
+    }
+
+    return (TNG_SUCCESS);
+}
+
+/**
+ * @brief Allocate memory for storing particle data.
+ * The allocated block will be refered to by data->values.
+ * @param tng_data is a trajectory data container.
+ * @param data is the data struct, which will contain the allocated memory in
+ * data->values.
+ * @param n_frames is the number of frames of data to store.
+ * @param n_particles is the number of particles with data.
+ * @param n_values_per_frame is the number of data values per particle and
+ * frame.
+ * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
+ * error has occured.
+ */
+static tng_function_status tng_allocate_particle_data_mem(const struct tng_trajectory* tng_data,
+                                                          struct tng_data*             data,
+                                                          int64_t                      n_frames,
+                                                          const int64_t stride_length,
+                                                          const int64_t n_particles,
+                                                          const int64_t n_values_per_frame)
+{
+    void*** values;
+    int64_t size, frame_alloc;
+    (void)tng_data;
+
+    if (n_particles == 0 || n_values_per_frame == 0)
+    {
+        return (TNG_FAILURE);
+    }
+
+    if (data->datatype == TNG_CHAR_DATA)
+    {
+        tng_data_strings_free(data, n_particles);
+    }
+    data->n_frames           = n_frames;
+    n_frames                 = tng_max_i64(1, n_frames);
+    data->stride_length      = tng_max_i64(1, stride_length);
+    data->n_values_per_frame = n_values_per_frame;
+    frame_alloc              = (n_frames - 1) / stride_length + 1;
+
+    if (data->datatype == TNG_CHAR_DATA)
+    {
+        if (tng_data_strings_alloc(data, frame_alloc, n_particles, n_values_per_frame) != TNG_SUCCESS)
+        {
+            return (TNG_CRITICAL);
+        }
+    }
+    else
+    {
+        switch (data->datatype)
+        {
+            case TNG_INT_DATA: size = sizeof(int64_t); break;
+            case TNG_FLOAT_DATA: size = sizeof(float); break;
+            case TNG_DOUBLE_DATA:
+            default: size = sizeof(double);
+        }
+
+        values = (void***)realloc(data->values, size * frame_alloc * n_particles * n_values_per_frame);
+        if (!values)
+        {
+            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+            free(data->values);
+            data->values = 0;
+            return (TNG_CRITICAL);
+        }
+        data->values = values;
+    }
+    return (TNG_SUCCESS);
+}
+
+static tng_function_status tng_particle_data_find(struct tng_trajectory* tng_data,
+                                                  const int64_t          id,
+                                                  tng_data_t*            data)
+{
+    tng_trajectory_frame_set_t frame_set = &tng_data->current_trajectory_frame_set;
+
+    if (tng_data->current_trajectory_frame_set_input_file_pos > 0
+        || tng_data->current_trajectory_frame_set_output_file_pos > 0)
+    {
+        *data = tng_data_block_index_find(&frame_set->tr_particle_data_index,
+                                          frame_set->tr_particle_data, id);
+    }
+    else
+    {
+        *data = tng_data_block_index_find(&tng_data->non_tr_particle_data_index,
+                                          tng_data->non_tr_particle_data, id);
+    }
+    if (!*data)
+    {
+        return (TNG_FAILURE);
+    }
+    return (TNG_SUCCESS);
+}
+
+static tng_function_status tng_data_find(struct tng_trajectory* tng_data, const int64_t id, tng_data_t* data)
+{
+    tng_trajectory_frame_set_t frame_set = &tng_data->current_trajectory_frame_set;
+
+    *data = 0;
+    if (tng_data->current_trajectory_frame_set_input_file_pos > 0
+        || tng_data->current_trajectory_frame_set_output_file_pos > 0)
+    {
+        *data = tng_data_block_index_find(&frame_set->tr_data_index, frame_set->tr_data, id);
+    }
+    if (!*data)
+    {
+        *data = tng_data_block_index_find(&tng_data->non_tr_data_index, tng_data->non_tr_data, id);
+    }
+    if (!*data)
+    {
+        return (TNG_FAILURE);
+    }
+    return (TNG_SUCCESS);
+}
+
+static tng_function_status tng_data_block_len_calculate(const struct tng_trajectory* tng_data,
+                                                        const struct tng_data*       data,
+                                                        const tng_bool is_particle_data,
+                                                        const int64_t  n_frames,
+                                                        const int64_t  frame_step,
+                                                        const int64_t  stride_length,
+                                                        const int64_t  num_first_particle,
+                                                        const int64_t  n_particles,
+                                                        int64_t*       data_start_pos,
+                                                        int64_t*       len)
+{
+    int     size;
+    int64_t i, j, k;
+    char ***first_dim_values, **second_dim_values;
+    (void)tng_data;
+
+    if (data == 0)
+    {
+        return (TNG_SUCCESS);
+    }
+
+    switch (data->datatype)
+    {
+        case TNG_CHAR_DATA: size = 1; break;
+        case TNG_INT_DATA: size = sizeof(int64_t); break;
+        case TNG_FLOAT_DATA: size = sizeof(float); break;
+        case TNG_DOUBLE_DATA:
+        default: size = sizeof(double);
+    }
 
-            /* If the algorithm parameters are -1 they will be determined during the
-             * compression. */
-            if (!tng_data->compress_algo_pos)
-            {
-                nalgo                       = tng_compress_nalgo();
-                tng_data->compress_algo_pos = (int*)malloc(nalgo * sizeof *tng_data->compress_algo_pos);
-                tng_data->compress_algo_pos[0] = -1;
-                tng_data->compress_algo_pos[1] = -1;
-                tng_data->compress_algo_pos[2] = -1;
-                tng_data->compress_algo_pos[3] = -1;
-            }
-            if (type == TNG_FLOAT_DATA)
-            {
-                dest = tng_compress_pos_float((float*)*data, (int)n_particles,
-                                              (int)algo_find_n_frames, f_precision, 0,
-                                              tng_data->compress_algo_pos, &compressed_len);
+    *len = sizeof(char) * 2 + sizeof(data->n_values_per_frame) + sizeof(data->codec_id);
+    if (is_particle_data)
+    {
+        *len += sizeof(num_first_particle) + sizeof(n_particles);
+    }
 
-                if (algo_find_n_frames < n_frames)
-                {
-                    free(dest);
-                    dest = tng_compress_pos_float((float*)*data, (int)n_particles, (int)n_frames, f_precision,
-                                                  0, tng_data->compress_algo_pos, &compressed_len);
-                }
-            }
-            else
-            {
-                dest = tng_compress_pos((double*)*data, (int)n_particles, (int)algo_find_n_frames,
-                                        d_precision, 0, tng_data->compress_algo_pos, &compressed_len);
+    if (stride_length > 1)
+    {
+        *len += sizeof(data->first_frame_with_data) + sizeof(data->stride_length);
+    }
 
-                if (algo_find_n_frames < n_frames)
+    if (data->codec_id != TNG_UNCOMPRESSED)
+    {
+        *len += sizeof(data->compression_multiplier);
+    }
+
+    if (data->dependency & TNG_FRAME_DEPENDENT)
+    {
+        *len += sizeof(char);
+    }
+
+    *data_start_pos = *len;
+
+    if (data->datatype == TNG_CHAR_DATA)
+    {
+        if (is_particle_data)
+        {
+            for (i = 0; i < n_frames; i++)
+            {
+                first_dim_values = data->strings[i];
+                for (j = num_first_particle; j < num_first_particle + n_particles; j++)
                 {
-                    free(dest);
-                    dest = tng_compress_pos((double*)*data, (int)n_particles, (int)n_frames, d_precision,
-                                            0, tng_data->compress_algo_pos, &compressed_len);
+                    second_dim_values = first_dim_values[j];
+                    for (k = 0; k < data->n_values_per_frame; k++)
+                    {
+                        *len += strlen(second_dim_values[k]) + 1;
+                    }
                 }
             }
         }
         else
         {
-            if (type == TNG_FLOAT_DATA)
-            {
-                dest = tng_compress_pos_float((float*)*data, (int)n_particles, (int)n_frames, f_precision,
-                                              0, tng_data->compress_algo_pos, &compressed_len);
-            }
-            else
+            for (i = 0; i < n_frames; i++)
             {
-                dest = tng_compress_pos((double*)*data, (int)n_particles, (int)n_frames, d_precision,
-                                        0, tng_data->compress_algo_pos, &compressed_len);
+                second_dim_values = data->strings[0][i];
+                for (j = 0; j < data->n_values_per_frame; j++)
+                {
+                    *len += strlen(second_dim_values[j]) + 1;
+                }
             }
         }
     }
-    else if (block->id == TNG_TRAJ_VELOCITIES)
+    else
     {
-        /* If there is only one frame in this frame set and there might be more
-         * do not store the algorithm as the compression algorithm, but find
-         * the best one without storing it */
-        if (n_frames == 1 && tng_data->frame_set_n_frames > 1)
+        *len += size * frame_step * n_particles * data->n_values_per_frame;
+    }
+
+    return (TNG_SUCCESS);
+}
+
+/* TEST: */
+/**
+ * @brief Create a non-particle data block
+ * @param tng_data is a trajectory data container.
+ * @param block_id is the ID of the block.
+ * @param block_type_flag specifies if this is a trajectory block or a
+ * non-trajectory block. (TNG_TRAJECTORY_BLOCK or TNG_NON_TRAJECTORY_BLOCK)
+ * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
+ * error has occured.
+ */
+static tng_function_status tng_data_block_create(struct tng_trajectory* tng_data,
+                                                 const int64_t          block_id,
+                                                 const char             block_type_flag)
+{
+    tng_trajectory_frame_set_t frame_set = &tng_data->current_trajectory_frame_set;
+
+    tng_data_t data;
+
+    if (block_type_flag == TNG_TRAJECTORY_BLOCK)
+    {
+        frame_set->n_data_blocks++;
+        data = (tng_data_t)realloc(frame_set->tr_data, sizeof(struct tng_data) * frame_set->n_data_blocks);
+        if (!data)
         {
-            nalgo    = tng_compress_nalgo();
-            alt_algo = (int*)malloc(nalgo * sizeof *tng_data->compress_algo_vel);
+            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+            free(frame_set->tr_data);
+            frame_set->tr_data = 0;
+            return (TNG_CRITICAL);
+        }
+        frame_set->tr_data = data;
+        data[frame_set->n_data_blocks - 1].block_id = block_id;
+        return (tng_data_block_index_add(&frame_set->tr_data_index, data,
+                                         frame_set->n_data_blocks));
+    }
+    else
+    {
+        tng_data->n_data_blocks++;
+        data = (tng_data_t)realloc(tng_data->non_tr_data, sizeof(struct tng_data) * tng_data->n_data_blocks);
+        if (!data)
+        {
+            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+            free(tng_data->non_tr_data);
+            tng_data->non_tr_data = 0;
+            return (TNG_CRITICAL);
+        }
+        tng_data->non_tr_data = data;
+        data[tng_data->n_data_blocks - 1].block_id = block_id;
+        return (tng_data_block_index_add(&tng_data->non_tr_data_index, data,
+                                         tng_data->n_data_blocks));
+    }
+}
 
-            /* If we have already determined the initial coding and
-             * initial coding parameter do not determine them again. */
-            if (tng_data->compress_algo_vel)
-            {
-                alt_algo[0] = tng_data->compress_algo_vel[0];
-                alt_algo[1] = tng_data->compress_algo_vel[1];
-                alt_algo[2] = tng_data->compress_algo_vel[2];
-                alt_algo[3] = tng_data->compress_algo_vel[3];
-            }
-            else
-            {
-                alt_algo[0] = -1;
-                alt_algo[1] = -1;
-                alt_algo[2] = -1;
-                alt_algo[3] = -1;
-            }
+/* TEST: */
+/**
+ * @brief Allocate memory for storing non-particle data.
+ * The allocated block will be refered to by data->values.
+ * @param tng_data is a trajectory data container.
+ * @param data is the data struct, which will contain the allocated memory in
+ * data->values.
+ * @param n_frames is the number of frames of data to store.
+ * @param n_values_per_frame is the number of data values per frame.
+ * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
+ * error has occured.
+ */
+static tng_function_status tng_allocate_data_mem(const struct tng_trajectory* tng_data,
+                                                 struct tng_data*             data,
+                                                 int64_t                      n_frames,
+                                                 const int64_t                stride_length,
+                                                 const int64_t                n_values_per_frame)
+{
+    void**  values;
+    int64_t size, frame_alloc;
+    (void)tng_data;
 
-            /* If the initial coding and initial coding parameter are -1
-             * they will be determined in tng_compress_pos/_float/. */
-            if (type == TNG_FLOAT_DATA)
-            {
-                dest = tng_compress_vel_float((float*)*data, (int)n_particles, (int)n_frames,
-                                              f_precision, 0, alt_algo, &compressed_len);
-            }
-            else
-            {
-                dest = tng_compress_vel((double*)*data, (int)n_particles, (int)n_frames,
-                                        d_precision, 0, alt_algo, &compressed_len);
-            }
-            /* If there had been no algorithm determined before keep the initial coding
-             * and initial coding parameter so that they won't have to be determined again. */
-            if (!tng_data->compress_algo_vel)
+    if (n_values_per_frame == 0)
+    {
+        return (TNG_FAILURE);
+    }
+
+    if (data->datatype == TNG_CHAR_DATA)
+    {
+        tng_data_strings_free(data, 1);
+    }
+    data->n_frames           = n_frames;
+    data->stride_length      = tng_max_i64(1, stride_length);
+    n_frames                 = tng_max_i64(1, n_frames);
+    data->n_values_per_frame = n_values_per_frame;
+    frame_alloc              = (n_frames - 1) / stride_length + 1;
+
+    if (data->datatype == TNG_CHAR_DATA)
+    {
+        if (tng_data_strings_alloc(data, 1, frame_alloc, n_values_per_frame) != TNG_SUCCESS)
+        {
+            return (TNG_CRITICAL);
+        }
+    }
+    else
+    {
+        switch (data->datatype)
+        {
+            case TNG_INT_DATA: size = sizeof(int64_t); break;
+            case TNG_FLOAT_DATA: size = sizeof(float); break;
+            case TNG_DOUBLE_DATA:
+            default: size = sizeof(double);
+        }
+
+        values = (void**)realloc(data->values, size * frame_alloc * n_values_per_frame);
+        if (!values)
+        {
+            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+            free(data->values);
+            data->values = 0;
+            return (TNG_CRITICAL);
+        }
+        data->values = values;
+    }
+
+    return (TNG_SUCCESS);
+}
+
+/**
+ * @brief Read the contents of a string data block into the strings of a data
+ * block. The file position must be at the start of the block contents.
+ * @param tng_data is a trajectory data container.
+ * @param data is the data block to store the strings in.
+ * @param block_data_len is the length (in bytes) of the block contents.
+ * @param num_first_particle is the number of the first particle in the block.
+ * @param n_particles is the number of particles in the block, 0 if the data
+ * is not particle dependent.
+ * @param n_frames_div is the number of frames with data in the block.
+ * @param n_values is the number of values per frame (and particle).
+ * @param codec_id is the compression codec of the block contents.
+ * @param full_data_len is the length of the uncompressed contents.
+ * @param hash_mode is an option to decide whether to use the md5 hash or not.
+ * @param hash_state is the md5 hash of the block, which will be appended with
+ * the block contents.
+ * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
+ * error has occured.
+ */
+static tng_function_status tng_data_strings_read(struct tng_trajectory* tng_data,
+                                                 struct tng_data*       data,
+                                                 const int64_t          block_data_len,
+                                                 const int64_t          num_first_particle,
+                                                 const int64_t          n_particles,
+                                                 const int64_t          n_frames_div,
+                                                 const int64_t          n_values,
+                                                 const int64_t          codec_id,
+                                                 const int64_t          full_data_len,
+                                                 const char             hash_mode,
+                                                 struct tng_hash_state* hash_state)
+{
+    int64_t  i, j, k, offset = 0;
+    int      len;
+    char *** first_dim_values, **second_dim_values;
+    char *   contents, *uncompressed_contents;
+    tng_bool contents_mapped;
+
+    contents        = (char*)tng_input_file_view(tng_data, block_data_len);
+    contents_mapped = contents ? TNG_TRUE : TNG_FALSE;
+    if (!contents_mapped)
+    {
+        contents = (char*)malloc(block_data_len);
+        if (!contents)
+        {
+            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+            return (TNG_CRITICAL);
+        }
+
+        if (tng_input_file_read(tng_data, contents, block_data_len) == 0)
+        {
+            fprintf(stderr, "TNG library: Cannot read block. %s: %d\n", __FILE__, __LINE__);
+            free(contents);
+            return (TNG_CRITICAL);
+        }
+    }
+
+    if (hash_mode == TNG_USE_HASH)
+    {
+        tng_hash_append(hash_state, contents, block_data_len);
+    }
+
+    if (codec_id == TNG_GZIP_COMPRESSION || codec_id == TNG_TNG_COMPRESSION)
+    {
+        uncompressed_contents = (char*)malloc(full_data_len);
+        if (!uncompressed_contents)
+        {
+            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+            if (!contents_mapped)
             {
-                nalgo                       = tng_compress_nalgo();
-                tng_data->compress_algo_vel = (int*)malloc(nalgo * sizeof *tng_data->compress_algo_vel);
-                tng_data->compress_algo_vel[0] = alt_algo[0];
-                tng_data->compress_algo_vel[1] = alt_algo[1];
-                tng_data->compress_algo_vel[2] = -1;
-                tng_data->compress_algo_vel[3] = -1;
+                free(contents);
             }
+            return (TNG_CRITICAL);
         }
-        else if (!tng_data->compress_algo_vel || tng_data->compress_algo_vel[2] == -1
-                 || tng_data->compress_algo_vel[2] == -1)
+        /* Strings cannot be TNG compressed. */
+        if (codec_id == TNG_TNG_COMPRESSION
+            || tng_gzip_uncompress(tng_data, contents, block_data_len, uncompressed_contents,
+                                   full_data_len)
+                       != TNG_SUCCESS)
         {
-            if (n_frames > 6)
-            {
-                algo_find_n_frames = 5;
-            }
-            else
+            fprintf(stderr, "TNG library: Could not read compressed block data. %s: %d\n",
+                    __FILE__, __LINE__);
+            free(uncompressed_contents);
+            if (!contents_mapped)
             {
-                algo_find_n_frames = n_frames;
+                free(contents);
             }
+            return (TNG_CRITICAL);
+        }
+        if (!contents_mapped)
+        {
+            free(contents);
+        }
+        contents        = uncompressed_contents;
+        contents_mapped = TNG_FALSE;
+    }
+    else if (codec_id == TNG_XTC_COMPRESSION)
+    {
+        fprintf(stderr, "TNG library: XTC compression not implemented yet.\n");
+    }
 
-            /* If the algorithm parameters are -1 they will be determined during the
-             * compression. */
-            if (!tng_data->compress_algo_vel)
-            {
-                nalgo                       = tng_compress_nalgo();
-                tng_data->compress_algo_vel = (int*)malloc(nalgo * sizeof *tng_data->compress_algo_vel);
-                tng_data->compress_algo_vel[0] = -1;
-                tng_data->compress_algo_vel[1] = -1;
-                tng_data->compress_algo_vel[2] = -1;
-                tng_data->compress_algo_vel[3] = -1;
-            }
-            if (type == TNG_FLOAT_DATA)
-            {
-                dest = tng_compress_vel_float((float*)*data, (int)n_particles,
-                                              (int)algo_find_n_frames, f_precision, 0,
-                                              tng_data->compress_algo_vel, &compressed_len);
-                if (algo_find_n_frames < n_frames)
-                {
-                    free(dest);
-                    dest = tng_compress_vel_float((float*)*data, (int)n_particles, (int)n_frames, f_precision,
-                                                  0, tng_data->compress_algo_vel, &compressed_len);
-                }
-            }
-            else
+    /* Strings are stores slightly differently if the data block contains particle
+     * data (frames * particles * n_values) or not (frames * n_values). */
+    if (n_particles > 0)
+    {
+        for (i = 0; i < n_frames_div; i++)
+        {
+            first_dim_values = data->strings[i];
+            for (j = num_first_particle; j < num_first_particle + n_particles; j++)
             {
-                dest = tng_compress_vel((double*)*data, (int)n_particles, (int)algo_find_n_frames,
-                                        d_precision, 0, tng_data->compress_algo_vel, &compressed_len);
-                if (algo_find_n_frames < n_frames)
+                second_dim_values = first_dim_values[j];
+                for (k = 0; k < n_values; k++)
                 {
-                    free(dest);
-                    dest = tng_compress_vel((double*)*data, (int)n_particles, (int)n_frames, d_precision,
-                                            0, tng_data->compress_algo_vel, &compressed_len);
+                    len = tng_min_size(strlen(contents + offset) + 1, TNG_MAX_STR_LEN);
+                    if (second_dim_values[k])
+                    {
+                        free(second_dim_values[k]);
+                    }
+                    second_dim_values[k] = (char*)malloc(len);
+                    if (!second_dim_values[k])
+                    {
+                        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__,
+                                __LINE__);
+                        if (!contents_mapped)
+                        {
+                            free(contents);
+                        }
+                        return (TNG_CRITICAL);
+                    }
+                    strncpy(second_dim_values[k], contents + offset, len);
+                    offset += len;
                 }
             }
         }
-        else
+    }
+    else
+    {
+        for (i = 0; i < n_frames_div; i++)
         {
-            if (type == TNG_FLOAT_DATA)
-            {
-                dest = tng_compress_vel_float((float*)*data, (int)n_particles, (int)n_frames, f_precision,
-                                              0, tng_data->compress_algo_vel, &compressed_len);
-            }
-            else
+            for (j = 0; j < n_values; j++)
             {
-                dest = tng_compress_vel((double*)*data, (int)n_particles, (int)n_frames, d_precision,
-                                        0, tng_data->compress_algo_vel, &compressed_len);
+                len = tng_min_size(strlen(contents + offset) + 1, TNG_MAX_STR_LEN);
+                if (data->strings[0][i][j])
+                {
+                    free(data->strings[0][i][j]);
+                }
+                data->strings[0][i][j] = (char*)malloc(len);
+                if (!data->strings[0][i][j])
+                {
+                    fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+                    if (!contents_mapped)
+                    {
+                        free(contents);
+                    }
+                    return (TNG_CRITICAL);
+                }
+                strncpy(data->strings[0][i][j], contents + offset, len);
+                offset += len;
             }
         }
     }
-    else
-    {
-        fprintf(stderr,
-                "TNG library: Can only compress positions and velocities using TNG-MF1 "
-                "algorithms.\n");
-        return (TNG_FAILURE);
-    }
 
-    if (alt_algo)
+    if (!contents_mapped)
     {
-        free(alt_algo);
+        free(contents);
     }
 
-    free(*data);
-
-    *data = dest;
-
-    *new_len = compressed_len;
-
     return (TNG_SUCCESS);
 }
 
-static tng_function_status tng_uncompress(const struct tng_trajectory* tng_data,
-                                          const struct tng_gen_block*  block,
-                                          const char                   type,
-                                          char**                       data,
-                                          const int64_t                uncompressed_len)
+/**
+ * @brief Get the hash table bucket of the frame set cache entries of a file
+ * position.
+ * @param cache is the frame set cache.
+ * @param file_pos is the file position of the block contents.
+ * @return The index of the bucket.
+ */
+static int64_t tng_frame_set_cache_bucket(const struct tng_frame_set_cache* cache,
+                                          const int64_t                     file_pos)
 {
-    double* d_dest = 0;
-    float*  f_dest = 0;
-    int     result;
-    (void)tng_data;
-
-    TNG_ASSERT(uncompressed_len,
-               "TNG library: The full length of the uncompressed data must be > 0.");
+    return ((int64_t)(((uint64_t)file_pos * 0x9E3779B97F4A7C15ULL) >> 32) & (cache->n_buckets - 1));
+}
 
-    if (block->id != TNG_TRAJ_POSITIONS && block->id != TNG_TRAJ_VELOCITIES)
+/**
+ * @brief Make an entry the most recently used entry of the frame set cache.
+ * @param cache is the frame set cache.
+ * @param entry is the entry, which must not be in the list of entries.
+ */
+static void tng_frame_set_cache_entry_push(struct tng_frame_set_cache*       cache,
+                                           struct tng_frame_set_cache_entry* entry)
+{
+    entry->more_recent = 0;
+    entry->less_recent = cache->most_recent;
+    if (cache->most_recent)
     {
-        fprintf(stderr,
-                "TNG library: Can only uncompress positions and velocities with the"
-                "TNG method.\n");
-        return (TNG_FAILURE);
+        cache->most_recent->more_recent = entry;
     }
-    if (type != TNG_FLOAT_DATA && type != TNG_DOUBLE_DATA)
+    else
     {
-        fprintf(stderr, "TNG library: Data type not supported.\n");
-        return (TNG_FAILURE);
+        cache->least_recent = entry;
     }
+    cache->most_recent = entry;
+}
 
-    if (type == TNG_FLOAT_DATA)
+/**
+ * @brief Remove an entry from the list of entries of the frame set cache,
+ * ordered by when they were used.
+ * @param cache is the frame set cache.
+ * @param entry is the entry.
+ */
+static void tng_frame_set_cache_entry_unlink(struct tng_frame_set_cache*       cache,
+                                             struct tng_frame_set_cache_entry* entry)
+{
+    if (entry->more_recent)
     {
-        f_dest = (float*)malloc(uncompressed_len);
-        if (!f_dest)
-        {
-            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
-            return (TNG_CRITICAL);
-        }
-        result = tng_compress_uncompress_float(*data, f_dest);
-
-        free(*data);
-
-        *data = (char*)f_dest;
+        entry->more_recent->less_recent = entry->less_recent;
     }
     else
     {
-        d_dest = (double*)malloc(uncompressed_len);
-        if (!d_dest)
-        {
-            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
-            return (TNG_CRITICAL);
-        }
-        result = tng_compress_uncompress(*data, d_dest);
-
-        free(*data);
-
-        *data = (char*)d_dest;
+        cache->most_recent = entry->less_recent;
     }
+    if (entry->less_recent)
+    {
+        entry->less_recent->more_recent = entry->more_recent;
+    }
+    else
+    {
+        cache->least_recent = entry->more_recent;
+    }
+}
 
-    if (result == 1)
+/**
+ * @brief Remove an entry from the frame set cache and free it.
+ * @param cache is the frame set cache.
+ * @param entry is the entry.
+ */
+static void tng_frame_set_cache_entry_remove(struct tng_frame_set_cache*       cache,
+                                             struct tng_frame_set_cache_entry* entry)
+{
+    struct tng_frame_set_cache_entry** link;
+
+    link = &cache->buckets[tng_frame_set_cache_bucket(cache, entry->file_pos)];
+    while (*link != entry)
     {
-        fprintf(stderr, "TNG library: Cannot uncompress TNG compressed block.\n");
-        return (TNG_FAILURE);
+        link = &(*link)->bucket_next;
     }
+    *link = entry->bucket_next;
+    tng_frame_set_cache_entry_unlink(cache, entry);
 
-    return (TNG_SUCCESS);
+    cache->size -= sizeof(struct tng_frame_set_cache_entry) + entry->values_len;
+    cache->n_entries--;
+    free(entry->values);
+    free(entry);
 }
 
-static tng_function_status tng_gzip_compress(const struct tng_trajectory* tng_data,
-                                             char**                       data,
-                                             const int64_t                len,
-                                             int64_t*                     new_len)
+/**
+ * @brief Find the decoded values of a data block in the frame set cache of a
+ * trajectory and make them the most recently used.
+ * @param tng_data is a trajectory data container.
+ * @param file_pos is the file position of the block contents.
+ * @param block_id is the ID of the block.
+ * @param hash_mode is the hash mode used for reading the block. Blocks cached
+ * without verifying their hashes are not used with TNG_USE_HASH.
+ * @return The cache entry of the block or 0 if it is not cached.
+ */
+static struct tng_frame_set_cache_entry* tng_frame_set_cache_find(struct tng_trajectory* tng_data,
+                                                                  const int64_t          file_pos,
+                                                                  const int64_t          block_id,
+                                                                  const char             hash_mode)
 {
-    Bytef* dest;
-    uLongf stat, max_len;
-    (void)tng_data;
+    struct tng_frame_set_cache*       cache = tng_data->frame_set_cache;
+    struct tng_frame_set_cache_entry* entry;
 
-    max_len = compressBound(len);
-    dest    = (Bytef*)malloc(max_len);
-    if (!dest)
+    /* Blocks of a file that is written to may change. */
+    if (!cache || cache->n_entries == 0 || tng_data->input_file == tng_data->output_file)
     {
-        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
-        return (TNG_CRITICAL);
+        return (0);
     }
 
-    stat = compress(dest, &max_len, (Bytef*)*data, len);
-    if (stat != (unsigned long)Z_OK)
+    for (entry = cache->buckets[tng_frame_set_cache_bucket(cache, file_pos)]; entry;
+         entry = entry->bucket_next)
     {
-        free(dest);
-        if (stat == (unsigned long)Z_MEM_ERROR)
-        {
-            fprintf(stderr, "TNG library: Not enough memory. ");
-        }
-        else if (stat == (unsigned long)Z_BUF_ERROR)
+        if (entry->file_pos == file_pos && entry->block_id == block_id)
         {
-            fprintf(stderr, "TNG library: Destination buffer too small. ");
+            if (entry->hash_mode < hash_mode)
+            {
+                return (0);
+            }
+            tng_frame_set_cache_entry_unlink(cache, entry);
+            tng_frame_set_cache_entry_push(cache, entry);
+            return (entry);
         }
-        fprintf(stderr, "TNG library: Error gzipping data. %s: %d\n", __FILE__, __LINE__);
-        return (TNG_FAILURE);
     }
 
-    *new_len = max_len;
-
-    free(*data);
-
-    *data = (char*)dest;
-
-    return (TNG_SUCCESS);
+    return (0);
 }
 
-static tng_function_status tng_gzip_uncompress(const struct tng_trajectory* tng_data,
-                                               char**                       data,
-                                               const int64_t                compressed_len,
-                                               const int64_t                uncompressed_len)
+/**
+ * @brief Add the decoded values of a data block to the frame set cache of a
+ * trajectory, evicting the least recently used entries to stay within its
+ * size.
+ * @param tng_data is a trajectory data container.
+ * @param src is the block to add. Its values are copied.
+ * @return TNG_SUCCESS (0) if successful, TNG_FAILURE (1) if the block is not
+ * added or TNG_CRITICAL (2) if a major error has occured.
+ */
+static tng_function_status tng_frame_set_cache_add(struct tng_trajectory*                  tng_data,
+                                                   const struct tng_frame_set_cache_entry* src)
 {
-    Bytef*        dest;
-    unsigned long stat;
-    (void)tng_data;
-    uLongf new_len = uncompressed_len;
+    struct tng_frame_set_cache*        cache = tng_data->frame_set_cache;
+    struct tng_frame_set_cache_entry*  entry;
+    struct tng_frame_set_cache_entry** buckets;
+    int64_t                            i, n_buckets, entry_size;
 
-    dest = (Bytef*)malloc(uncompressed_len);
-    if (!dest)
+    entry_size = sizeof(struct tng_frame_set_cache_entry) + src->values_len;
+    if (!cache || entry_size > cache->max_size || tng_data->input_file == tng_data->output_file)
     {
-        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
-        return (TNG_CRITICAL);
+        return (TNG_FAILURE);
     }
 
-    stat = uncompress(dest, &new_len, (Bytef*)*data, compressed_len);
-
-    if (stat != Z_OK)
+    /* A block read again with a stricter hash mode replaces its entry. */
+    for (entry = cache->buckets[tng_frame_set_cache_bucket(cache, src->file_pos)]; entry;
+         entry = entry->bucket_next)
     {
-        free(dest);
-        if (stat == (unsigned long)Z_MEM_ERROR)
+        if (entry->file_pos == src->file_pos && entry->block_id == src->block_id)
         {
-            fprintf(stderr, "TNG library: Not enough memory. ");
+            tng_frame_set_cache_entry_remove(cache, entry);
+            break;
         }
-        else if (stat == (unsigned long)Z_BUF_ERROR)
+    }
+    while (cache->n_entries > 0 && cache->size + entry_size > cache->max_size)
+    {
+        tng_frame_set_cache_entry_remove(cache, cache->least_recent);
+    }
+
+    /* Keep at most one entry per bucket on average. */
+    if (cache->n_entries >= cache->n_buckets)
+    {
+        n_buckets = cache->n_buckets * 2;
+        buckets   = (struct tng_frame_set_cache_entry**)calloc(
+                n_buckets, sizeof(struct tng_frame_set_cache_entry*));
+        if (!buckets)
         {
-            fprintf(stderr, "TNG library: Destination buffer too small. ");
+            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+            return (TNG_CRITICAL);
         }
-        else if (stat == (unsigned long)Z_DATA_ERROR)
+        free(cache->buckets);
+        cache->buckets   = buckets;
+        cache->n_buckets = n_buckets;
+        for (entry = cache->most_recent; entry; entry = entry->less_recent)
         {
-            fprintf(stderr, "TNG library: Data corrupt. ");
+            i                  = tng_frame_set_cache_bucket(cache, entry->file_pos);
+            entry->bucket_next = buckets[i];
+            buckets[i]         = entry;
         }
-        fprintf(stderr, "TNG library: Error uncompressing gzipped data. %s: %d\n", __FILE__, __LINE__);
-        return (TNG_FAILURE);
     }
 
-    free(*data);
+    entry = (struct tng_frame_set_cache_entry*)malloc(sizeof(struct tng_frame_set_cache_entry));
+    if (!entry)
+    {
+        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+        return (TNG_CRITICAL);
+    }
+    *entry        = *src;
+    entry->values = (char*)malloc(src->values_len);
+    if (!entry->values)
+    {
+        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+        free(entry);
+        return (TNG_CRITICAL);
+    }
+    memcpy(entry->values, src->values, src->values_len);
+
+    i                  = tng_frame_set_cache_bucket(cache, entry->file_pos);
+    entry->bucket_next = cache->buckets[i];
+    cache->buckets[i]  = entry;
+    tng_frame_set_cache_entry_push(cache, entry);
+    cache->size += entry_size;
+    cache->n_entries++;
+
+    return (TNG_SUCCESS);
+}
+
+/**
+ * @brief Remove all entries from the frame set cache of a trajectory.
+ * @param tng_data is a trajectory data container.
+ */
+static void tng_frame_set_cache_clear(struct tng_trajectory* tng_data)
+{
+    struct tng_frame_set_cache* cache = tng_data->frame_set_cache;
+
+    if (!cache)
+    {
+        return;
+    }
+    while (cache->n_entries > 0)
+    {
+        tng_frame_set_cache_entry_remove(cache, cache->least_recent);
+    }
+}
+
+/**
+ * @brief Remove all entries from the frame set cache of a trajectory and
+ * destroy the cache.
+ * @param tng_data is a trajectory data container.
+ */
+static void tng_frame_set_cache_destroy(struct tng_trajectory* tng_data)
+{
+    if (!tng_data->frame_set_cache)
+    {
+        return;
+    }
+    tng_frame_set_cache_clear(tng_data);
+    free(tng_data->frame_set_cache->buckets);
+    free(tng_data->frame_set_cache);
+    tng_data->frame_set_cache = 0;
+}
 
-    *data = (char*)dest;
+/**
+ * @brief Copy the values of a block containing a range of the particles to the
+ * data values of all particles.
+ * @param values is the data values of all particles, with the values of each frame
+ * after each other.
+ * @param block_values is the values of the particles of the block, with the values
+ * of each frame after each other.
+ * @param n_frames_div is the number of frames with data.
+ * @param num_first_particle is the number of the first particle of the block.
+ * @param n_particles is the number of particles of the block.
+ * @param tot_n_particles is the number of particles of the data values.
+ * @param particle_size is the size of the values of one particle in one frame.
+ */
+static void tng_data_particles_scatter(void*         values,
+                                       const char*   block_values,
+                                       const int64_t n_frames_div,
+                                       const int64_t num_first_particle,
+                                       const int64_t n_particles,
+                                       const int64_t tot_n_particles,
+                                       const int64_t particle_size)
+{
+    int64_t i;
 
-    return (TNG_SUCCESS);
+    for (i = 0; i < n_frames_div; i++)
+    {
+        memcpy((char*)values + (i * tot_n_particles + num_first_particle) * particle_size,
+               block_values + i * n_particles * particle_size, n_particles * particle_size);
+    }
 }
 
 /**
- * @brief Allocate memory for storing particle data.
- * The allocated block will be refered to by data->values.
+ * @brief Read the values of a data block
  * @param tng_data is a trajectory data container.
- * @param data is the data struct, which will contain the allocated memory in
- * data->values.
- * @param n_frames is the number of frames of data to store.
- * @param n_particles is the number of particles with data.
- * @param n_values_per_frame is the number of data values per particle and
- * frame.
+ * @param block is the block to store the data (should already contain
+ * the block headers and the block contents).
+ * @param block_data_len is the length of the data contents of the block.
+ * @param datatype is the type of data of the data block (char, int, float or
+ * double).
+ * @param num_first_particle is the number of the first particle in the data
+ * block. This should be the same as in the corresponding particle mapping
+ * block. Only used if reading particle dependent data.
+ * @param n_particles is the number of particles in the data block. This should
+ * be the same as in the corresponding particle mapping block. Only used if
+ * reading particle dependent data.
+ * @param first_frame_with_data is the frame number of the first frame with data
+ * in this data block.
+ * @param stride_length is the number of frames between each data entry.
+ * @param n_frames is the number of frames in this data block.
+ * @param n_values is the number of values per frame stored in this data block.
+ * @param codec_id is the ID of the codec to compress the data.
+ * @param multiplier is the multiplication factor applied to each data value
+ * before compression. This factor is applied since some compression algorithms
+ * work only on integers.
+ * @param hash_mode is an option to decide whether to generate/update the relevant md5 hashes.
+ * @param hash_state is a pointer to the current md5 storage, which will be updated appropriately
+ * if hash_mode == TNG_USE_HASH.
+ * @param cache_entry is a frame set cache entry of the block, or 0. If it has
+ * values they are copied instead of reading the block contents. Otherwise its
+ * values are set to point at the numerical values that have been read.
  * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
  * error has occured.
  */
-static tng_function_status tng_allocate_particle_data_mem(const struct tng_trajectory* tng_data,
-                                                          struct tng_data*             data,
-                                                          int64_t                      n_frames,
-                                                          const int64_t stride_length,
-                                                          const int64_t n_particles,
-                                                          const int64_t n_values_per_frame)
-{
-    void*** values;
-    int64_t i, j, k, size, frame_alloc;
-    (void)tng_data;
+static tng_function_status tng_data_read(struct tng_trajectory*            tng_data,
+                                         const struct tng_gen_block*       block,
+                                         const int64_t                     block_data_len,
+                                         const char                        datatype,
+                                         const int64_t                     num_first_particle,
+                                         const int64_t                     n_particles,
+                                         const int64_t                     first_frame_with_data,
+                                         const int64_t                     stride_length,
+                                         int64_t                           n_frames,
+                                         const int64_t                     n_values,
+                                         const int64_t                     codec_id,
+                                         const double                      multiplier,
+                                         const char                        hash_mode,
+                                         struct tng_hash_state*            hash_state,
+                                         struct tng_frame_set_cache_entry* cache_entry)
+{
+    int64_t                    tot_n_particles, n_frames_div, full_data_len, values_len;
+    int                        size;
+    tng_data_t                 data;
+    tng_trajectory_frame_set_t frame_set = &tng_data->current_trajectory_frame_set;
+    char                       block_type_flag, *contents, *dest, *partial_values = 0;
+    const char*                src;
+    tng_bool                   is_particle_data, contents_mapped, is_partial;
+    tng_function_status        stat;
 
-    if (n_particles == 0 || n_values_per_frame == 0)
+    /*     fprintf(stderr, "TNG library: %s\n", block->name);*/
+
+    switch (datatype)
     {
-        return (TNG_FAILURE);
+        case TNG_CHAR_DATA: size = 1; break;
+        case TNG_INT_DATA: size = sizeof(int64_t); break;
+        case TNG_FLOAT_DATA: size = sizeof(float); break;
+        case TNG_DOUBLE_DATA:
+        default: size = sizeof(double);
     }
 
-    if (data->strings && data->datatype == TNG_CHAR_DATA)
+    if (n_particles > 0)
     {
-        for (i = 0; i < data->n_frames; i++)
+        is_particle_data = TNG_TRUE;
+    }
+    else
+    {
+        if (codec_id == TNG_XTC_COMPRESSION || codec_id == TNG_TNG_COMPRESSION)
         {
-            for (j = 0; j < n_particles; j++)
-            {
-                for (k = 0; k < data->n_values_per_frame; k++)
-                {
-                    if (data->strings[i][j][k])
-                    {
-                        free(data->strings[i][j][k]);
-                    }
-                }
-                free(data->strings[i][j]);
-            }
-            free(data->strings[i]);
+            fprintf(stderr, "TNG library: Cannot uncompress data block. %s: %d\n", __FILE__, __LINE__);
+            return (TNG_FAILURE);
         }
-        free(data->strings);
+        is_particle_data = TNG_FALSE;
     }
-    data->n_frames           = n_frames;
-    n_frames                 = tng_max_i64(1, n_frames);
-    data->stride_length      = tng_max_i64(1, stride_length);
-    data->n_values_per_frame = n_values_per_frame;
-    frame_alloc              = (n_frames - 1) / stride_length + 1;
 
-    if (data->datatype == TNG_CHAR_DATA)
+    if (is_particle_data == TNG_TRUE)
     {
-        data->strings = (char****)malloc(sizeof(char***) * frame_alloc);
-        for (i = 0; i < frame_alloc; i++)
-        {
-            data->strings[i] = (char***)malloc(sizeof(char**) * n_particles);
-            if (!data->strings[i])
-            {
-                fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
-                return (TNG_CRITICAL);
-            }
-            for (j = 0; j < n_particles; j++)
-            {
-                data->strings[i][j] = (char**)malloc(sizeof(char*) * n_values_per_frame);
-                if (!data->strings[i][j])
-                {
-                    fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
-                    return (TNG_CRITICAL);
-                }
-                for (k = 0; k < n_values_per_frame; k++)
-                {
-                    data->strings[i][j][k] = 0;
-                }
-            }
-        }
+        stat = tng_particle_data_find(tng_data, block->id, &data);
     }
     else
     {
-        switch (data->datatype)
-        {
-            case TNG_INT_DATA: size = sizeof(int64_t); break;
-            case TNG_FLOAT_DATA: size = sizeof(float); break;
-            case TNG_DOUBLE_DATA:
-            default: size = sizeof(double);
-        }
-
-        values = (void***)realloc(data->values, size * frame_alloc * n_particles * n_values_per_frame);
-        if (!values)
-        {
-            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
-            free(data->values);
-            data->values = 0;
-            return (TNG_CRITICAL);
-        }
-        data->values = values;
+        stat = tng_data_find(tng_data, block->id, &data);
     }
-    return (TNG_SUCCESS);
-}
-
-static tng_function_status tng_particle_data_find(struct tng_trajectory* tng_data,
-                                                  const int64_t          id,
-                                                  tng_data_t*            data)
-{
-    int64_t                    block_index, i;
-    tng_trajectory_frame_set_t frame_set = &tng_data->current_trajectory_frame_set;
-    char                       block_type_flag;
 
-    if (tng_data->current_trajectory_frame_set_input_file_pos > 0
-        || tng_data->current_trajectory_frame_set_output_file_pos > 0)
+    if (tng_data->current_trajectory_frame_set_input_file_pos > 0)
     {
         block_type_flag = TNG_TRAJECTORY_BLOCK;
     }
@@ -4596,384 +7414,501 @@ static tng_function_status tng_particle_data_find(struct tng_trajectory* tng_dat
         block_type_flag = TNG_NON_TRAJECTORY_BLOCK;
     }
 
-    block_index = -1;
-    if (block_type_flag == TNG_TRAJECTORY_BLOCK)
+    /* If the block does not exist, create it */
+    if (stat != TNG_SUCCESS)
     {
-        for (i = 0; i < frame_set->n_particle_data_blocks; i++)
+        if (is_particle_data == TNG_TRUE)
+        {
+            stat = tng_particle_data_block_create(tng_data, block->id, block_type_flag);
+        }
+        else
+        {
+            stat = tng_data_block_create(tng_data, block->id, block_type_flag);
+        }
+
+        if (stat != TNG_SUCCESS)
         {
-            *data = &frame_set->tr_particle_data[i];
-            if ((*data)->block_id == id)
+            fprintf(stderr, "TNG library: Cannot create data block. %s: %d\n", __FILE__, __LINE__);
+            return (TNG_CRITICAL);
+        }
+
+        if (is_particle_data == TNG_TRUE)
+        {
+            if (block_type_flag == TNG_TRAJECTORY_BLOCK)
             {
-                block_index = i;
-                break;
+                data = &frame_set->tr_particle_data[frame_set->n_particle_data_blocks - 1];
+            }
+            else
+            {
+                data = &tng_data->non_tr_particle_data[tng_data->n_particle_data_blocks - 1];
             }
         }
-    }
-    else
-    {
-        for (i = 0; i < tng_data->n_particle_data_blocks; i++)
+        else
         {
-            *data = &tng_data->non_tr_particle_data[i];
-            if ((*data)->block_id == id)
+            if (block_type_flag == TNG_TRAJECTORY_BLOCK)
             {
-                block_index = i;
-                break;
+                data = &frame_set->tr_data[frame_set->n_data_blocks - 1];
+            }
+            else
+            {
+                data = &tng_data->non_tr_data[tng_data->n_data_blocks - 1];
             }
         }
-    }
-    if (block_index == -1)
-    {
-        return (TNG_FAILURE);
-    }
-    return (TNG_SUCCESS);
-}
 
-static tng_function_status tng_data_find(struct tng_trajectory* tng_data, const int64_t id, tng_data_t* data)
-{
-    int64_t                    block_index, i;
-    tng_trajectory_frame_set_t frame_set = &tng_data->current_trajectory_frame_set;
-    char                       block_type_flag;
+        data->block_name = (char*)malloc(strlen(block->name) + 1);
+        if (!data->block_name)
+        {
+            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+            return (TNG_CRITICAL);
+        }
+        strcpy(data->block_name, block->name);
 
-    if (tng_data->current_trajectory_frame_set_input_file_pos > 0
-        || tng_data->current_trajectory_frame_set_output_file_pos > 0)
-    {
-        block_type_flag = TNG_TRAJECTORY_BLOCK;
-    }
-    else
-    {
-        block_type_flag = TNG_NON_TRAJECTORY_BLOCK;
+        data->datatype = datatype;
+
+        data->values = 0;
+        /* FIXME: Memory leak from strings. */
+        data->strings    = 0;
+        data->n_frames   = 0;
+        data->dependency = 0;
+        if (is_particle_data == TNG_TRUE)
+        {
+            data->dependency += TNG_PARTICLE_DEPENDENT;
+        }
+        if (block_type_flag == TNG_TRAJECTORY_BLOCK
+            && (n_frames > 1 || frame_set->n_frames == n_frames || stride_length > 1))
+        {
+            data->dependency += TNG_FRAME_DEPENDENT;
+        }
+        data->codec_id               = codec_id;
+        data->compression_multiplier = multiplier;
+        data->last_retrieved_frame   = -1;
     }
 
-    block_index = -1;
-    if (block_type_flag == TNG_TRAJECTORY_BLOCK)
+    if (is_particle_data == TNG_TRUE)
     {
-        for (i = 0; i < frame_set->n_data_blocks; i++)
+        if (block_type_flag == TNG_TRAJECTORY_BLOCK && tng_data->var_num_atoms_flag)
         {
-            *data = &frame_set->tr_data[i];
-            if ((*data)->block_id == id)
-            {
-                block_index = i;
-                break;
-            }
+            tot_n_particles = frame_set->n_particles;
         }
-        if (block_index == -1)
+        else
         {
-            for (i = 0; i < tng_data->n_data_blocks; i++)
-            {
-                *data = &tng_data->non_tr_data[i];
-                if ((*data)->block_id == id)
-                {
-                    block_index = i;
-                    break;
-                }
-            }
+            tot_n_particles = tng_data->n_particles;
         }
     }
+    /* If there are no particles in this data block, still set tot_n_particles = 1
+     * to calculate block lengths etc properly. */
     else
     {
-        for (i = 0; i < tng_data->n_data_blocks; i++)
+        tot_n_particles = 1;
+    }
+
+    n_frames_div = (n_frames - 1) / stride_length + 1;
+
+    full_data_len = n_frames_div * size * n_values;
+    if (is_particle_data == TNG_TRUE)
+    {
+        full_data_len *= n_particles;
+    }
+
+    /* Allocate memory */
+    if (!data->values || data->n_frames != n_frames || data->n_values_per_frame != n_values)
+    {
+        if (is_particle_data == TNG_TRUE)
+        {
+            stat = tng_allocate_particle_data_mem(tng_data, data, n_frames, stride_length,
+                                                  tot_n_particles, n_values);
+        }
+        else
+        {
+            stat = tng_allocate_data_mem(tng_data, data, n_frames, stride_length, n_values);
+        }
+        if (stat != TNG_SUCCESS)
         {
-            *data = &tng_data->non_tr_data[i];
-            if ((*data)->block_id == id)
-            {
-                block_index = i;
-                break;
-            }
+            fprintf(stderr, "TNG library: Cannot allocate memory for data. %s: %d\n", __FILE__, __LINE__);
+            return (TNG_CRITICAL);
         }
     }
-    if (block_index == -1)
-    {
-        return (TNG_FAILURE);
-    }
-    return (TNG_SUCCESS);
-}
 
-static tng_function_status tng_data_block_len_calculate(const struct tng_trajectory* tng_data,
-                                                        const struct tng_data*       data,
-                                                        const tng_bool is_particle_data,
-                                                        const int64_t  n_frames,
-                                                        const int64_t  frame_step,
-                                                        const int64_t  stride_length,
-                                                        const int64_t  num_first_particle,
-                                                        const int64_t  n_particles,
-                                                        int64_t*       data_start_pos,
-                                                        int64_t*       len)
-{
-    int     size;
-    int64_t i, j, k;
-    char ***first_dim_values, **second_dim_values;
-    (void)tng_data;
+    data->first_frame_with_data = first_frame_with_data;
 
-    if (data == 0)
+    if (datatype == TNG_CHAR_DATA)
     {
-        return (TNG_SUCCESS);
+        return (tng_data_strings_read(tng_data, data, block_data_len, num_first_particle,
+                                      n_particles, n_frames_div, n_values, codec_id, full_data_len,
+                                      hash_mode, hash_state));
     }
 
-    switch (data->datatype)
+    /* Numerical data is read, or decompressed, directly into the data values of the block.
+     * A block with only the particles of a mapping block is read separately and its values
+     * are then copied to the particles in each frame. */
+    is_partial = is_particle_data && (num_first_particle != 0 || n_particles < tot_n_particles)
+                         ? TNG_TRUE
+                         : TNG_FALSE;
+    dest       = (char*)data->values;
+    if (cache_entry && cache_entry->values)
     {
-        case TNG_CHAR_DATA: size = 1; break;
-        case TNG_INT_DATA: size = sizeof(int64_t); break;
-        case TNG_FLOAT_DATA: size = sizeof(float); break;
-        case TNG_DOUBLE_DATA:
-        default: size = sizeof(double);
+        full_data_len = cache_entry->values_len;
     }
-
-    *len = sizeof(char) * 2 + sizeof(data->n_values_per_frame) + sizeof(data->codec_id);
-    if (is_particle_data)
+    else if (codec_id == TNG_UNCOMPRESSED)
     {
-        *len += sizeof(num_first_particle) + sizeof(n_particles);
+        full_data_len = block_data_len;
     }
-
-    if (stride_length > 1)
+    values_len = ((tng_max_i64(1, data->n_frames) - 1) / data->stride_length + 1) * size
+                 * data->n_values_per_frame * tot_n_particles;
+    if (is_partial
+                ? (num_first_particle < 0 || num_first_particle + n_particles > tot_n_particles
+                   || full_data_len > n_frames_div * size * n_values * n_particles
+                   || n_frames_div * size * n_values * tot_n_particles > values_len)
+                : full_data_len > values_len)
     {
-        *len += sizeof(data->first_frame_with_data) + sizeof(data->stride_length);
+        fprintf(stderr, "TNG library: Data block contents do not fit in the data block. %s: %d\n",
+                __FILE__, __LINE__);
+        return (TNG_CRITICAL);
     }
 
-    if (data->codec_id != TNG_UNCOMPRESSED)
+    /* The values of a block found in the frame set cache are copied from there. Blocks with
+     * only some of the particles are not cached. */
+    if (cache_entry && cache_entry->values)
     {
-        *len += sizeof(data->compression_multiplier);
+        memcpy(dest, cache_entry->values, full_data_len);
+        return (TNG_SUCCESS);
     }
 
-    if (data->dependency & TNG_FRAME_DEPENDENT)
+    if (is_partial)
     {
-        *len += sizeof(char);
+        partial_values = (char*)malloc(full_data_len);
+        if (!partial_values)
+        {
+            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+            return (TNG_CRITICAL);
+        }
+        dest = partial_values;
     }
 
-    *data_start_pos = *len;
-
-    if (data->datatype == TNG_CHAR_DATA)
+    /* src is where the values are when they have been read, before swapping their byte order. */
+    src = dest;
+    if (codec_id == TNG_UNCOMPRESSED)
     {
-        if (is_particle_data)
+        /* Values in a memory mapped input file are copied when swapping their byte order. */
+        contents = (char*)tng_input_file_view(tng_data, block_data_len);
+        if (contents)
         {
-            for (i = 0; i < n_frames; i++)
+            src = contents;
+        }
+        else if (tng_input_file_read(tng_data, dest, block_data_len) == 0)
+        {
+            fprintf(stderr, "TNG library: Cannot read block. %s: %d\n", __FILE__, __LINE__);
+            free(partial_values);
+            return (TNG_CRITICAL);
+        }
+        if (hash_mode == TNG_USE_HASH)
+        {
+            tng_hash_append(hash_state, src, block_data_len);
+        }
+    }
+    else
+    {
+        /* The compressed contents are only read, so they can be used directly from a memory
+         * mapped input file. */
+        contents        = (char*)tng_input_file_view(tng_data, block_data_len);
+        contents_mapped = contents ? TNG_TRUE : TNG_FALSE;
+        if (!contents_mapped)
+        {
+            contents = (char*)malloc(block_data_len);
+            if (!contents)
             {
-                first_dim_values = data->strings[i];
-                for (j = num_first_particle; j < num_first_particle + n_particles; j++)
-                {
-                    second_dim_values = first_dim_values[j];
-                    for (k = 0; k < data->n_values_per_frame; k++)
-                    {
-                        *len += strlen(second_dim_values[k]) + 1;
-                    }
-                }
+                fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+                free(partial_values);
+                return (TNG_CRITICAL);
+            }
+
+            if (tng_input_file_read(tng_data, contents, block_data_len) == 0)
+            {
+                fprintf(stderr, "TNG library: Cannot read block. %s: %d\n", __FILE__, __LINE__);
+                free(contents);
+                free(partial_values);
+                return (TNG_CRITICAL);
             }
         }
-        else
+
+        if (hash_mode == TNG_USE_HASH)
         {
-            for (i = 0; i < n_frames; i++)
-            {
-                second_dim_values = data->strings[0][i];
-                for (j = 0; j < data->n_values_per_frame; j++)
+            tng_hash_append(hash_state, contents, block_data_len);
+        }
+
+        switch (codec_id)
+        {
+            case TNG_XTC_COMPRESSION:
+                fprintf(stderr, "TNG library: XTC compression not implemented yet.\n");
+                break;
+            case TNG_TNG_COMPRESSION:
+                if (tng_uncompress(tng_data, block, datatype, contents, dest) != TNG_SUCCESS)
                 {
-                    *len += strlen(second_dim_values[j]) + 1;
+                    fprintf(stderr,
+                            "TNG library: Could not read tng compressed block data. %s: %d\n",
+                            __FILE__, __LINE__);
+                    stat = TNG_CRITICAL;
                 }
-            }
+                break;
+            case TNG_GZIP_COMPRESSION:
+                if (tng_gzip_uncompress(tng_data, contents, block_data_len, dest, full_data_len)
+                    != TNG_SUCCESS)
+                {
+                    fprintf(stderr, "TNG library: Could not read gzipped block data. %s: %d\n",
+                            __FILE__, __LINE__);
+                    stat = TNG_CRITICAL;
+                }
+                break;
+        }
+        if (!contents_mapped)
+        {
+            free(contents);
+        }
+        if (stat != TNG_SUCCESS)
+        {
+            free(partial_values);
+            return (stat);
         }
     }
-    else
+
+    /* Endianness is handled by the TNG compression library. TNG compressed blocks are always
+     * written as little endian by the compression library. */
+    if (codec_id != TNG_TNG_COMPRESSION)
     {
-        *len += size * frame_step * n_particles * data->n_values_per_frame;
+        stat = TNG_SUCCESS;
+        switch (datatype)
+        {
+            case TNG_FLOAT_DATA:
+                stat = tng_swap_byte_order_copy_32(
+                        tng_data, tng_data->input_endianness_swap_func_32, dest, src,
+                        full_data_len / size);
+                break;
+            case TNG_INT_DATA:
+            case TNG_DOUBLE_DATA:
+                stat = tng_swap_byte_order_copy_64(
+                        tng_data, tng_data->input_endianness_swap_func_64, dest, src,
+                        full_data_len / size);
+                break;
+            case TNG_CHAR_DATA: break;
+        }
+        if (stat != TNG_SUCCESS)
+        {
+            /* The values may only have been partly copied from a memory mapped file. */
+            fprintf(stderr, "TNG library: Cannot swap byte order. %s: %d\n", __FILE__, __LINE__);
+            free(partial_values);
+            return (TNG_CRITICAL);
+        }
+    }
+
+    if (partial_values)
+    {
+        tng_data_particles_scatter(data->values, partial_values, n_frames_div, num_first_particle,
+                                   n_particles, tot_n_particles, size * n_values);
+        free(partial_values);
+    }
+    else if (cache_entry)
+    {
+        cache_entry->values     = dest;
+        cache_entry->values_len = full_data_len;
     }
 
     return (TNG_SUCCESS);
 }
 
-/* TEST: */
 /**
- * @brief Create a non-particle data block
+ * @brief Find a data block to write and get the frames and particles to write
+ * of it. The compression multiplier of the data block is set according to its
+ * codec.
  * @param tng_data is a trajectory data container.
- * @param block_type_flag specifies if this is a trajectory block or a
- * non-trajectory block. (TNG_TRAJECTORY_BLOCK or TNG_NON_TRAJECTORY_BLOCK)
- * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
- * error has occured.
+ * @param block_index is the index number of the data block in the frame set.
+ * @param is_particle_data is a flag to specify if the data to write is
+ * particle dependent or not.
+ * @param mapping is the particle mapping that is relevant for the data block.
+ * Only relevant if writing particle dependent data.
+ * @param data_p will be pointing to the data block.
+ * @param n_frames will be set to the number of frames of the data block.
+ * @param stride_length will be set to the stride length of the data block.
+ * @param frame_step will be set to the number of frames with data.
+ * @param num_first_particle will be set to the number of the first particle
+ * to write. Only relevant if writing particle dependent data.
+ * @param n_particles will be set to the number of particles to write. Only
+ * relevant if writing particle dependent data.
+ * @return TNG_SUCCESS (0) if successful or TNG_FAILURE (1) if the data block
+ * has no data in the current frame set and should not be written.
  */
-static tng_function_status tng_data_block_create(struct tng_trajectory* tng_data, const char block_type_flag)
+static tng_function_status tng_data_block_write_setup(struct tng_trajectory*             tng_data,
+                                                      const int64_t                      block_index,
+                                                      const tng_bool                     is_particle_data,
+                                                      const struct tng_particle_mapping* mapping,
+                                                      tng_data_t*                        data_p,
+                                                      int64_t*                           n_frames,
+                                                      int64_t*                           stride_length,
+                                                      int64_t*                           frame_step,
+                                                      int64_t* num_first_particle,
+                                                      int64_t* n_particles)
 {
     tng_trajectory_frame_set_t frame_set = &tng_data->current_trajectory_frame_set;
+    tng_data_t                 data;
+    char                       block_type_flag;
 
-    tng_data_t data;
+    /* If we have already started writing frame sets it is too late to write
+     * non-trajectory data blocks */
+    if (tng_data->current_trajectory_frame_set_output_file_pos > 0)
+    {
+        block_type_flag = TNG_TRAJECTORY_BLOCK;
+    }
+    else
+    {
+        block_type_flag = TNG_NON_TRAJECTORY_BLOCK;
+    }
 
-    if (block_type_flag == TNG_TRAJECTORY_BLOCK)
+    if (is_particle_data == TNG_TRUE)
     {
-        frame_set->n_data_blocks++;
-        data = (tng_data_t)realloc(frame_set->tr_data, sizeof(struct tng_data) * frame_set->n_data_blocks);
-        if (!data)
+        if (block_type_flag == TNG_TRAJECTORY_BLOCK)
         {
-            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
-            free(frame_set->tr_data);
-            frame_set->tr_data = 0;
-            return (TNG_CRITICAL);
+            data = &frame_set->tr_particle_data[block_index];
+
+            /* If this data block has not had any data added in this frame set
+             * do not write it. */
+            if (data->first_frame_with_data < frame_set->first_frame)
+            {
+                return (TNG_FAILURE);
+            }
+
+            *stride_length = tng_max_i64(1, data->stride_length);
+        }
+        else
+        {
+            data           = &tng_data->non_tr_particle_data[block_index];
+            *stride_length = 1;
         }
-        frame_set->tr_data = data;
     }
     else
     {
-        tng_data->n_data_blocks++;
-        data = (tng_data_t)realloc(tng_data->non_tr_data, sizeof(struct tng_data) * tng_data->n_data_blocks);
-        if (!data)
+        if (block_type_flag == TNG_TRAJECTORY_BLOCK)
         {
-            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
-            free(tng_data->non_tr_data);
-            tng_data->non_tr_data = 0;
-            return (TNG_CRITICAL);
+            data = &frame_set->tr_data[block_index];
+
+            /* If this data block has not had any data added in this frame set
+             * do not write it. */
+            if (data->first_frame_with_data < frame_set->first_frame)
+            {
+                return (TNG_FAILURE);
+            }
+
+            *stride_length = tng_max_i64(1, data->stride_length);
+        }
+        else
+        {
+            data           = &tng_data->non_tr_data[block_index];
+            *stride_length = 1;
         }
-        tng_data->non_tr_data = data;
     }
+    *data_p = data;
 
-    return (TNG_SUCCESS);
-}
+    /* If writing frame independent data data->n_frames is 0, but n_frames
+       is used for the loop writing the data (and reserving memory) and needs
+       to be at least 1 */
+    *n_frames = tng_max_i64(1, data->n_frames);
 
-/* TEST: */
-/**
- * @brief Allocate memory for storing non-particle data.
- * The allocated block will be refered to by data->values.
- * @param tng_data is a trajectory data container.
- * @param data is the data struct, which will contain the allocated memory in
- * data->values.
- * @param n_frames is the number of frames of data to store.
- * @param n_values_per_frame is the number of data values per frame.
- * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
- * error has occured.
- */
-static tng_function_status tng_allocate_data_mem(const struct tng_trajectory* tng_data,
-                                                 struct tng_data*             data,
-                                                 int64_t                      n_frames,
-                                                 const int64_t                stride_length,
-                                                 const int64_t                n_values_per_frame)
-{
-    void**  values;
-    int64_t i, j, size, frame_alloc;
-    (void)tng_data;
+    if (block_type_flag == TNG_TRAJECTORY_BLOCK)
+    {
+        /* If the frame set is finished before writing the full number of frames
+           make sure the data block is not longer than the frame set. */
+        *n_frames = tng_min_i64(*n_frames, frame_set->n_frames);
 
-    if (n_values_per_frame == 0)
+        *n_frames -= (data->first_frame_with_data - frame_set->first_frame);
+    }
+
+    *frame_step = (*n_frames - 1) / *stride_length + 1;
+
+    /* TNG compression will use compression precision to get integers from
+     * floating point data. The compression multiplier stores that information
+     * to be able to return the precision of the compressed data. */
+    if (data->codec_id == TNG_TNG_COMPRESSION)
+    {
+        data->compression_multiplier = tng_data->compression_precision;
+    }
+    /* Uncompressed data blocks do not use compression multipliers at all.
+     * GZip compression does not need it either. */
+    else if (data->codec_id == TNG_UNCOMPRESSED || data->codec_id == TNG_GZIP_COMPRESSION)
     {
-        return (TNG_FAILURE);
+        data->compression_multiplier = 1.0;
     }
 
-    if (data->strings && data->datatype == TNG_CHAR_DATA)
+    if (data->dependency & TNG_PARTICLE_DEPENDENT)
     {
-        for (i = 0; i < data->n_frames; i++)
+        if (mapping && mapping->n_particles != 0)
         {
-            for (j = 0; j < data->n_values_per_frame; j++)
-            {
-                if (data->strings[0][i][j])
-                {
-                    free(data->strings[0][i][j]);
-                    data->strings[0][i][j] = 0;
-                }
-            }
-            free(data->strings[0][i]);
-            data->strings[0][i] = 0;
+            *n_particles        = mapping->n_particles;
+            *num_first_particle = mapping->num_first_particle;
         }
-        free(data->strings[0]);
-        data->strings[0] = 0;
-        free(data->strings);
-    }
-    data->n_frames           = n_frames;
-    data->stride_length      = tng_max_i64(1, stride_length);
-    n_frames                 = tng_max_i64(1, n_frames);
-    data->n_values_per_frame = n_values_per_frame;
-    frame_alloc              = (n_frames - 1) / stride_length + 1;
-
-    if (data->datatype == TNG_CHAR_DATA)
-    {
-        data->strings    = (char****)malloc(sizeof(char***));
-        data->strings[0] = (char***)malloc(sizeof(char**) * frame_alloc);
-        for (i = 0; i < frame_alloc; i++)
+        else
         {
-            data->strings[0][i] = (char**)malloc(sizeof(char*) * n_values_per_frame);
-            if (!data->strings[0][i])
+            *num_first_particle = 0;
+            if (tng_data->var_num_atoms_flag)
             {
-                fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
-                return (TNG_CRITICAL);
+                *n_particles = frame_set->n_particles;
             }
-            for (j = 0; j < n_values_per_frame; j++)
+            else
             {
-                data->strings[0][i][j] = 0;
+                *n_particles = tng_data->n_particles;
             }
         }
     }
     else
     {
-        switch (data->datatype)
-        {
-            case TNG_INT_DATA: size = sizeof(int64_t); break;
-            case TNG_FLOAT_DATA: size = sizeof(float); break;
-            case TNG_DOUBLE_DATA:
-            default: size = sizeof(double);
-        }
-
-        values = (void**)realloc(data->values, size * frame_alloc * n_values_per_frame);
-        if (!values)
-        {
-            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
-            free(data->values);
-            data->values = 0;
-            return (TNG_CRITICAL);
-        }
-        data->values = values;
+        /* This just appeases gcc-7 -Wmaybe-uninitialized.
+         * FIXME: It would be better to refactor so that
+         * TNG_PARTICLE_DEPENDENT triggers two distinct code paths.
+         */
+        *num_first_particle = -1;
+        *n_particles        = -1;
     }
 
     return (TNG_SUCCESS);
 }
 
 /**
- * @brief Read the values of a data block
+ * @brief Get the contents of a numerical data block to write, converted to the
+ * endianness of the output file and compressed using the codec of the data block.
  * @param tng_data is a trajectory data container.
- * @param block is the block to store the data (should already contain
- * the block headers and the block contents).
- * @param block_data_len is the length of the data contents of the block.
- * @param datatype is the type of data of the data block (char, int, float or
- * double).
- * @param num_first_particle is the number of the first particle in the data
- * block. This should be the same as in the corresponding particle mapping
- * block. Only used if reading particle dependent data.
- * @param n_particles is the number of particles in the data block. This should
- * be the same as in the corresponding particle mapping block. Only used if
- * reading particle dependent data.
- * @param first_frame_with_data is the frame number of the first frame with data
- * in this data block.
- * @param stride_length is the number of frames between each data entry.
- * @param n_frames is the number of frames in this data block.
- * @param n_values is the number of values per frame stored in this data block.
- * @param codec_id is the ID of the codec to compress the data.
- * @param multiplier is the multiplication factor applied to each data value
- * before compression. This factor is applied since some compression algorithms
- * work only on integers.
- * @param hash_mode is an option to decide whether to generate/update the relevant md5 hashes.
- * @param md5_state is a pointer to the current md5 storage, which will be updated appropriately
- * if hash_mode == TNG_USE_HASH.
+ * @param data is the data block.
+ * @param frame_step is the number of frames with data to write.
+ * @param num_first_particle is the number of the first particle to write.
+ * Only relevant if writing particle dependent data.
+ * @param n_particles is the number of particles to write. Only relevant if
+ * writing particle dependent data.
+ * @param contents_p will be pointing to the contents. The memory must be
+ * freed by the caller.
+ * @param len will be set to the length of the contents.
+ * @details If the contents cannot be compressed the codec of the data block is
+ * set to TNG_UNCOMPRESSED and the contents are not compressed.
+ * The data blocks of a frame set can be compressed in parallel, except for
+ * blocks compressed with the TNG method with the same block ID, since the
+ * compression algorithms of positions and velocities are stored in the
+ * trajectory.
  * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
  * error has occured.
  */
-static tng_function_status tng_data_read(struct tng_trajectory*      tng_data,
-                                         const struct tng_gen_block* block,
-                                         const int64_t               block_data_len,
-                                         const char                  datatype,
-                                         const int64_t               num_first_particle,
-                                         const int64_t               n_particles,
-                                         const int64_t               first_frame_with_data,
-                                         const int64_t               stride_length,
-                                         int64_t                     n_frames,
-                                         const int64_t               n_values,
-                                         const int64_t               codec_id,
-                                         const double                multiplier,
-                                         const char                  hash_mode,
-                                         md5_state_t*                md5_state)
-{
-    int64_t                    i, j, k, tot_n_particles, n_frames_div, offset;
-    int64_t                    full_data_len;
-    int                        size, len;
-    char ***                   first_dim_values, **second_dim_values;
-    tng_data_t                 data;
-    tng_trajectory_frame_set_t frame_set = &tng_data->current_trajectory_frame_set;
-    char                       block_type_flag, *contents;
-    tng_bool                   is_particle_data;
-    tng_function_status        stat;
+static tng_function_status tng_data_block_contents_get(struct tng_trajectory* tng_data,
+                                                       tng_data_t             data,
+                                                       const int64_t          frame_step,
+                                                       const int64_t          num_first_particle,
+                                                       const int64_t          n_particles,
+                                                       char**                 contents_p,
+                                                       int64_t*               len)
+{
+    int64_t             i, full_data_len, block_data_len, tot_n_particles, particle_size;
+    int                 size;
+    char*               contents;
+    const char*         values;
+    double              multiplier;
+    tng_function_status stat;
 
-    /*     fprintf(stderr, "TNG library: %s\n", block->name);*/
+    *contents_p = 0;
 
-    switch (datatype)
+    switch (data->datatype)
     {
         case TNG_CHAR_DATA: size = 1; break;
         case TNG_INT_DATA: size = sizeof(int64_t); break;
@@ -4982,3410 +7917,4384 @@ static tng_function_status tng_data_read(struct tng_trajectory*      tng_data,
         default: size = sizeof(double);
     }
 
-    if (n_particles > 0)
-    {
-        is_particle_data = TNG_TRUE;
-    }
-    else
-    {
-        if (codec_id == TNG_XTC_COMPRESSION || codec_id == TNG_TNG_COMPRESSION)
-        {
-            fprintf(stderr, "TNG library: Cannot uncompress data block. %s: %d\n", __FILE__, __LINE__);
-            return (TNG_FAILURE);
-        }
-        is_particle_data = TNG_FALSE;
-    }
-
-    if (is_particle_data == TNG_TRUE)
+    if (data->dependency & TNG_PARTICLE_DEPENDENT)
     {
-        stat = tng_particle_data_find(tng_data, block->id, &data);
+        full_data_len = size * frame_step * n_particles * data->n_values_per_frame;
     }
     else
     {
-        stat = tng_data_find(tng_data, block->id, &data);
-    }
-
-    if (tng_data->current_trajectory_frame_set_input_file_pos > 0)
-    {
-        block_type_flag = TNG_TRAJECTORY_BLOCK;
+        full_data_len = size * frame_step * data->n_values_per_frame;
     }
-    else
+    contents = (char*)malloc(full_data_len);
+    if (!contents)
     {
-        block_type_flag = TNG_NON_TRAJECTORY_BLOCK;
+        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+        return (TNG_CRITICAL);
     }
 
-    /* If the block does not exist, create it */
-    if (stat != TNG_SUCCESS)
+    if (data->values)
     {
-        if (is_particle_data == TNG_TRUE)
-        {
-            stat = tng_particle_data_block_create(tng_data, block_type_flag);
-        }
-        else
-        {
-            stat = tng_data_block_create(tng_data, block_type_flag);
-        }
-
-        if (stat != TNG_SUCCESS)
+        values = (const char*)data->values;
+        if (data->dependency & TNG_PARTICLE_DEPENDENT)
         {
-            fprintf(stderr, "TNG library: Cannot create data block. %s: %d\n", __FILE__, __LINE__);
-            return (TNG_CRITICAL);
+            if (tng_data->current_trajectory_frame_set_output_file_pos > 0
+                && tng_data->var_num_atoms_flag)
+            {
+                tot_n_particles = tng_data->current_trajectory_frame_set.n_particles;
+            }
+            else
+            {
+                tot_n_particles = tng_data->n_particles;
+            }
+            /* The values of the particles of a mapping block are gathered from each frame. */
+            if (n_particles < tot_n_particles)
+            {
+                particle_size = size * data->n_values_per_frame;
+                for (i = 0; i < frame_step; i++)
+                {
+                    memcpy(contents + i * n_particles * particle_size,
+                           values + (i * tot_n_particles + num_first_particle) * particle_size,
+                           n_particles * particle_size);
+                }
+                values = contents;
+            }
         }
-
-        if (is_particle_data == TNG_TRUE)
+        /* If writing TNG compressed data the endianness is taken into account by the
+         * compression routines. TNG compressed data is always written as little endian.
+         * Uncompressed and gzipped values get their byte order swapped while being copied. */
+        if ((data->codec_id == TNG_UNCOMPRESSED || data->codec_id == TNG_GZIP_COMPRESSION)
+            && data->datatype != TNG_CHAR_DATA)
         {
-            if (block_type_flag == TNG_TRAJECTORY_BLOCK)
+            if (data->datatype == TNG_FLOAT_DATA)
             {
-                data = &frame_set->tr_particle_data[frame_set->n_particle_data_blocks - 1];
+                stat = tng_swap_byte_order_copy_32(tng_data, tng_data->output_endianness_swap_func_32,
+                                                   contents, values, full_data_len / size);
             }
             else
             {
-                data = &tng_data->non_tr_particle_data[tng_data->n_particle_data_blocks - 1];
+                stat = tng_swap_byte_order_copy_64(tng_data, tng_data->output_endianness_swap_func_64,
+                                                   contents, values, full_data_len / size);
+            }
+            if (stat != TNG_SUCCESS)
+            {
+                fprintf(stderr, "TNG library: Cannot swap byte order. %s: %d\n", __FILE__,
+                        __LINE__);
             }
         }
         else
         {
-            if (block_type_flag == TNG_TRAJECTORY_BLOCK)
+            if (values != contents)
             {
-                data = &frame_set->tr_data[frame_set->n_data_blocks - 1];
+                memcpy(contents, values, full_data_len);
             }
-            else
+            if (data->codec_id != TNG_TNG_COMPRESSION)
             {
-                data = &tng_data->non_tr_data[tng_data->n_data_blocks - 1];
+                switch (data->datatype)
+                {
+                    case TNG_FLOAT_DATA:
+                        multiplier = data->compression_multiplier;
+                        if (fabs(multiplier - 1.0) > 0.00001 || tng_data->output_endianness_swap_func_32)
+                        {
+                            for (i = 0; i < full_data_len; i += size)
+                            {
+                                *(float*)(contents + i) *= (float)multiplier;
+                                if (tng_data->output_endianness_swap_func_32
+                                    && tng_data->output_endianness_swap_func_32(
+                                               tng_data, (uint32_t*)(contents + i))
+                                               != TNG_SUCCESS)
+                                {
+                                    fprintf(stderr,
+                                            "TNG library: Cannot swap byte order. %s: %d\n",
+                                            __FILE__, __LINE__);
+                                }
+                            }
+                        }
+                        break;
+                    case TNG_INT_DATA:
+                        if (tng_swap_byte_order_copy_64(tng_data,
+                                                        tng_data->output_endianness_swap_func_64,
+                                                        contents, contents, full_data_len / size)
+                            != TNG_SUCCESS)
+                        {
+                            fprintf(stderr, "TNG library: Cannot swap byte order. %s: %d\n",
+                                    __FILE__, __LINE__);
+                        }
+                        break;
+                    case TNG_DOUBLE_DATA:
+                        multiplier = data->compression_multiplier;
+                        if (fabs(multiplier - 1.0) > 0.00001 || tng_data->output_endianness_swap_func_64)
+                        {
+                            for (i = 0; i < full_data_len; i += size)
+                            {
+                                *(double*)(contents + i) *= multiplier;
+                                if (tng_data->output_endianness_swap_func_64
+                                    && tng_data->output_endianness_swap_func_64(
+                                               tng_data, (uint64_t*)(contents + i))
+                                               != TNG_SUCCESS)
+                                {
+                                    fprintf(stderr,
+                                            "TNG library: Cannot swap byte order. %s: %d\n",
+                                            __FILE__, __LINE__);
+                                }
+                            }
+                        }
+                        break;
+                    case TNG_CHAR_DATA: break;
+                }
             }
         }
+    }
+    else
+    {
+        memset(contents, 0, full_data_len);
+    }
 
-        data->block_id = block->id;
+    block_data_len = full_data_len;
 
-        data->block_name = (char*)malloc(strlen(block->name) + 1);
-        if (!data->block_name)
+    switch (data->codec_id)
+    {
+        case TNG_XTC_COMPRESSION:
+            fprintf(stderr, "TNG library: XTC compression not implemented yet.\n");
+            data->codec_id = TNG_UNCOMPRESSED;
+            break;
+        case TNG_TNG_COMPRESSION:
+            stat = tng_compress(tng_data, data->block_id, frame_step, n_particles, data->datatype,
+                                &contents, &block_data_len);
+            if (stat != TNG_SUCCESS)
+            {
+                fprintf(stderr, "TNG library: Could not write TNG compressed block data. %s: %d\n",
+                        __FILE__, __LINE__);
+                free(contents);
+                if (stat == TNG_CRITICAL)
+                {
+                    return (TNG_CRITICAL);
+                }
+                /* Get the data again, but with no compression (to write only
+                 * the relevant data) */
+                data->codec_id               = TNG_UNCOMPRESSED;
+                data->compression_multiplier = 1.0;
+                return (tng_data_block_contents_get(tng_data, data, frame_step, num_first_particle,
+                                                    n_particles, contents_p, len));
+            }
+            break;
+        case TNG_GZIP_COMPRESSION:
+            /*         fprintf(stderr, "TNG library: Before compression: %" PRId64 "\n", block->block_contents_size); */
+            stat = tng_gzip_compress(tng_data, &contents, full_data_len, &block_data_len);
+            if (stat != TNG_SUCCESS)
+            {
+                fprintf(stderr, "TNG library: Could not write gzipped block data. %s: %d\n", __FILE__,
+                        __LINE__);
+                if (stat == TNG_CRITICAL)
+                {
+                    free(contents);
+                    return (TNG_CRITICAL);
+                }
+                data->codec_id = TNG_UNCOMPRESSED;
+            }
+            /*         fprintf(stderr, "TNG library: After compression: %" PRId64 "\n", block->block_contents_size); */
+            break;
+    }
+
+    *contents_p = contents;
+    *len        = block_data_len;
+
+    return (TNG_SUCCESS);
+}
+
+/**
+ * @brief Write a data block (particle or non-particle data)
+ * @param tng_data is a trajectory data container.
+ * @param block is the block to store the data (should already contain
+ * the block headers and the block contents).
+ * @param block_index is the index number of the data block in the frame set.
+ * @param is_particle_data is a flag to specify if the data to write is
+ * particle dependent or not.
+ * @param mapping is the particle mapping that is relevant for the data block.
+ * Only relevant if writing particle dependent data.
+ * @param hash_mode is an option to decide whether to use the md5 hash or not.
+ * If hash_mode == TNG_USE_HASH an md5 hash will be generated and written.
+ * @param prepared is the contents of the data block, if they have already been
+ * compressed using tng_data_block_contents_get(), otherwise 0. The contents
+ * are freed after writing them.
+ * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
+ * error has occured.
+ */
+static tng_function_status tng_data_block_write(struct tng_trajectory*             tng_data,
+                                                struct tng_gen_block*              block,
+                                                const int64_t                      block_index,
+                                                const tng_bool                     is_particle_data,
+                                                const struct tng_particle_mapping* mapping,
+                                                const char                         hash_mode,
+                                                struct tng_data_block_contents*    prepared)
+{
+    int64_t                    n_particles, num_first_particle, n_frames, stride_length;
+    int64_t                    block_data_len = 0, frame_step, data_start_pos;
+    int64_t                    i, j, k, header_file_pos;
+    size_t                     len;
+    char                       temp, *temp_name, ***first_dim_values, **second_dim_values;
+    char*                      contents = 0;
+    tng_trajectory_frame_set_t frame_set = &tng_data->current_trajectory_frame_set;
+    tng_data_t                 data;
+    struct tng_hash_state      hash_state;
+
+    if (tng_output_file_init(tng_data) != TNG_SUCCESS)
+    {
+        return (TNG_CRITICAL);
+    }
+
+    if (tng_data_block_write_setup(tng_data, block_index, is_particle_data, mapping, &data,
+                                   &n_frames, &stride_length, &frame_step, &num_first_particle,
+                                   &n_particles)
+        != TNG_SUCCESS)
+    {
+        return (TNG_SUCCESS);
+    }
+
+    len = strlen(data->block_name) + 1;
+
+    if (!block->name || strlen(block->name) < len)
+    {
+        temp_name = (char*)realloc(block->name, len);
+        if (!temp_name)
         {
             fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+            free(block->name);
+            block->name = 0;
             return (TNG_CRITICAL);
         }
-        strcpy(data->block_name, block->name);
-
-        data->datatype = datatype;
+        block->name = temp_name;
+    }
+    strncpy(block->name, data->block_name, len);
+    block->id = data->block_id;
 
-        data->values = 0;
-        /* FIXME: Memory leak from strings. */
-        data->strings    = 0;
-        data->n_frames   = 0;
-        data->dependency = 0;
-        if (is_particle_data == TNG_TRUE)
+    /* The contents are compressed before writing the block header, since the
+     * codec can change if the compression fails. */
+    if (data->datatype != TNG_CHAR_DATA)
+    {
+        if (prepared && prepared->contents)
         {
-            data->dependency += TNG_PARTICLE_DEPENDENT;
+            contents           = prepared->contents;
+            block_data_len     = prepared->len;
+            prepared->contents = 0;
         }
-        if (block_type_flag == TNG_TRAJECTORY_BLOCK
-            && (n_frames > 1 || frame_set->n_frames == n_frames || stride_length > 1))
+        else if (tng_data_block_contents_get(tng_data, data, frame_step, num_first_particle,
+                                             n_particles, &contents, &block_data_len)
+                 != TNG_SUCCESS)
         {
-            data->dependency += TNG_FRAME_DEPENDENT;
+            return (TNG_CRITICAL);
         }
-        data->codec_id               = codec_id;
-        data->compression_multiplier = multiplier;
-        data->last_retrieved_frame   = -1;
     }
 
-    if (is_particle_data == TNG_TRUE)
+    if (data->dependency & TNG_PARTICLE_DEPENDENT)
     {
-        if (block_type_flag == TNG_TRAJECTORY_BLOCK && tng_data->var_num_atoms_flag)
+        if (tng_data_block_len_calculate(tng_data, data, TNG_TRUE, n_frames, frame_step,
+                                         stride_length, num_first_particle, n_particles,
+                                         &data_start_pos, &block->block_contents_size)
+            != TNG_SUCCESS)
         {
-            tot_n_particles = frame_set->n_particles;
+            fprintf(stderr, "TNG library: Cannot calculate length of particle data block. %s: %d\n",
+                    __FILE__, __LINE__);
+            free(contents);
+            return (TNG_CRITICAL);
         }
-        else
+    }
+    else
+    {
+        if (tng_data_block_len_calculate(tng_data, data, TNG_FALSE, n_frames, frame_step, stride_length,
+                                         0, 1, &data_start_pos, &block->block_contents_size)
+            != TNG_SUCCESS)
         {
-            tot_n_particles = tng_data->n_particles;
+            fprintf(stderr,
+                    "TNG library: Cannot calculate length of non-particle data block. %s: %d\n",
+                    __FILE__, __LINE__);
+            free(contents);
+            return (TNG_CRITICAL);
         }
     }
-    /* If there are no particles in this data block, still set tot_n_particles = 1
-     * to calculate block lengths etc properly. */
-    else
+    if (data->datatype != TNG_CHAR_DATA)
     {
-        tot_n_particles = 1;
+        block->block_contents_size = data_start_pos + block_data_len;
     }
 
-    n_frames_div = (n_frames - 1) / stride_length + 1;
+    header_file_pos = ftello(tng_data->output_file);
 
-    contents = (char*)malloc(block_data_len);
-    if (!contents)
+    if (tng_block_header_write(tng_data, block) != TNG_SUCCESS)
     {
-        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+        fprintf(stderr, "TNG library: Cannot write header of file %s. %s: %d\n",
+                tng_data->output_file_path, __FILE__, __LINE__);
+        free(contents);
         return (TNG_CRITICAL);
     }
 
-    if (fread(contents, block_data_len, 1, tng_data->input_file) == 0)
+    if (hash_mode == TNG_USE_HASH)
     {
-        fprintf(stderr, "TNG library: Cannot read block. %s: %d\n", __FILE__, __LINE__);
+        tng_block_hash_init(block, &hash_state);
+    }
+
+    if (tng_file_output_numerical(tng_data, &data->datatype, sizeof(data->datatype), hash_mode,
+                                  &hash_state, __LINE__)
+        == TNG_CRITICAL)
+    {
+        free(contents);
         return (TNG_CRITICAL);
     }
 
-    if (hash_mode == TNG_USE_HASH)
+    if (tng_file_output_numerical(tng_data, &data->dependency, sizeof(data->dependency), hash_mode,
+                                  &hash_state, __LINE__)
+        == TNG_CRITICAL)
     {
-        md5_append(md5_state, (md5_byte_t*)contents, block_data_len);
+        free(contents);
+        return (TNG_CRITICAL);
     }
 
-    if (codec_id != TNG_UNCOMPRESSED)
+    if (data->dependency & TNG_FRAME_DEPENDENT)
     {
-        full_data_len = n_frames_div * size * n_values;
-        if (is_particle_data == TNG_TRUE)
+        if (stride_length > 1)
         {
-            full_data_len *= n_particles;
+            temp = 1;
         }
-        switch (codec_id)
+        else
         {
-            case TNG_XTC_COMPRESSION:
-                fprintf(stderr, "TNG library: XTC compression not implemented yet.\n");
-                break;
-            case TNG_TNG_COMPRESSION:
-                /*            fprintf(stderr, "TNG library: Before TNG uncompression: %" PRId64 "\n", block->block_contents_size);*/
-                if (tng_uncompress(tng_data, block, datatype, &contents, full_data_len) != TNG_SUCCESS)
-                {
-                    fprintf(stderr,
-                            "TNG library: Could not read tng compressed block data. %s: %d\n",
-                            __FILE__, __LINE__);
-                    free(contents);
-                    return (TNG_CRITICAL);
-                }
-                /*            fprintf(stderr, "TNG library: After TNG uncompression: %" PRId64 "\n", block->block_contents_size);*/
-                break;
-            case TNG_GZIP_COMPRESSION:
-                /*         fprintf(stderr, "TNG library: Before compression: %" PRId64 "\n", block->block_contents_size); */
-                if (tng_gzip_uncompress(tng_data, &contents, block_data_len, full_data_len) != TNG_SUCCESS)
-                {
-                    fprintf(stderr, "TNG library: Could not read gzipped block data. %s: %d\n",
-                            __FILE__, __LINE__);
-                    free(contents);
-                    return (TNG_CRITICAL);
-                }
-                /*         fprintf(stderr, "TNG library: After compression: %" PRId64 "\n", block->block_contents_size); */
-                break;
+            temp = 0;
+        }
+        if (tng_file_output_numerical(tng_data, &temp, sizeof(temp), hash_mode, &hash_state, __LINE__)
+            == TNG_CRITICAL)
+        {
+            free(contents);
+            return (TNG_CRITICAL);
         }
     }
-    else
+
+    if (tng_file_output_numerical(tng_data, &data->n_values_per_frame,
+                                  sizeof(data->n_values_per_frame), hash_mode, &hash_state, __LINE__)
+        == TNG_CRITICAL)
     {
-        full_data_len = block_data_len;
+        free(contents);
+        return (TNG_CRITICAL);
     }
 
-    /* Allocate memory */
-    if (!data->values || data->n_frames != n_frames || data->n_values_per_frame != n_values)
+    if (tng_file_output_numerical(tng_data, &data->codec_id, sizeof(data->codec_id), hash_mode,
+                                  &hash_state, __LINE__)
+        == TNG_CRITICAL)
     {
-        if (is_particle_data == TNG_TRUE)
+        free(contents);
+        return (TNG_CRITICAL);
+    }
+
+    if (data->codec_id != TNG_UNCOMPRESSED)
+    {
+        if (tng_file_output_numerical(tng_data, &data->compression_multiplier,
+                                      sizeof(data->compression_multiplier), hash_mode, &hash_state, __LINE__)
+            == TNG_CRITICAL)
         {
-            stat = tng_allocate_particle_data_mem(tng_data, data, n_frames, stride_length,
-                                                  tot_n_particles, n_values);
+            free(contents);
+            return (TNG_CRITICAL);
         }
-        else
+    }
+
+    if (data->n_frames > 0 && stride_length > 1)
+    {
+        /* FIXME: first_frame_with_data is not reliably set */
+        if (data->first_frame_with_data == 0)
         {
-            stat = tng_allocate_data_mem(tng_data, data, n_frames, stride_length, n_values);
+            data->first_frame_with_data = frame_set->first_frame;
         }
-        if (stat != TNG_SUCCESS)
+        if (tng_file_output_numerical(tng_data, &data->first_frame_with_data,
+                                      sizeof(data->first_frame_with_data), hash_mode, &hash_state, __LINE__)
+            == TNG_CRITICAL)
+        {
+            free(contents);
+            return (TNG_CRITICAL);
+        }
+
+        if (tng_file_output_numerical(tng_data, &stride_length, sizeof(stride_length), hash_mode,
+                                      &hash_state, __LINE__)
+            == TNG_CRITICAL)
         {
-            fprintf(stderr, "TNG library: Cannot allocate memory for data. %s: %d\n", __FILE__, __LINE__);
             free(contents);
             return (TNG_CRITICAL);
         }
     }
 
-    data->first_frame_with_data = first_frame_with_data;
+    if (data->dependency & TNG_PARTICLE_DEPENDENT)
+    {
+        if (tng_file_output_numerical(tng_data, &num_first_particle, sizeof(num_first_particle),
+                                      hash_mode, &hash_state, __LINE__)
+            == TNG_CRITICAL)
+        {
+            free(contents);
+            return (TNG_CRITICAL);
+        }
 
-    if (datatype == TNG_CHAR_DATA)
+        if (tng_file_output_numerical(tng_data, &n_particles, sizeof(n_particles), hash_mode, &hash_state, __LINE__)
+            == TNG_CRITICAL)
+        {
+            free(contents);
+            return (TNG_CRITICAL);
+        }
+    }
+
+    if (data->datatype == TNG_CHAR_DATA)
     {
-        offset = 0;
-        /* Strings are stores slightly differently if the data block contains particle
-         * data (frames * particles * n_values) or not (frames * n_values). */
-        if (is_particle_data == TNG_TRUE)
+        if (data->strings)
         {
-            for (i = 0; i < n_frames_div; i++)
+            if (data->dependency & TNG_PARTICLE_DEPENDENT)
             {
-                first_dim_values = data->strings[i];
-                for (j = num_first_particle; j < num_first_particle + n_particles; j++)
+                for (i = 0; i < frame_step; i++)
                 {
-                    second_dim_values = first_dim_values[j];
-                    for (k = 0; k < n_values; k++)
+                    first_dim_values = data->strings[i];
+                    for (j = num_first_particle; j < num_first_particle + n_particles; j++)
                     {
-                        len = tng_min_size(strlen(contents + offset) + 1, TNG_MAX_STR_LEN);
-                        if (second_dim_values[k])
-                        {
-                            free(second_dim_values[k]);
-                        }
-                        second_dim_values[k] = (char*)malloc(len);
-                        if (!second_dim_values[k])
+                        second_dim_values = first_dim_values[j];
+                        for (k = 0; k < data->n_values_per_frame; k++)
                         {
-                            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n",
-                                    __FILE__, __LINE__);
-                            free(contents);
-                            return (TNG_CRITICAL);
+                            if (tng_fwritestr(tng_data, second_dim_values[k], hash_mode, &hash_state, __LINE__)
+                                == TNG_CRITICAL)
+                            {
+                                free(contents);
+                                return (TNG_CRITICAL);
+                            }
                         }
-                        strncpy(second_dim_values[k], contents + offset, len);
-                        offset += len;
                     }
                 }
             }
-        }
-        else
-        {
-            for (i = 0; i < n_frames_div; i++)
+            else
             {
-                for (j = 0; j < n_values; j++)
+                for (i = 0; i < frame_step; i++)
                 {
-                    len = tng_min_size(strlen(contents + offset) + 1, TNG_MAX_STR_LEN);
-                    if (data->strings[0][i][j])
-                    {
-                        free(data->strings[0][i][j]);
-                    }
-                    data->strings[0][i][j] = (char*)malloc(len);
-                    if (!data->strings[0][i][j])
+                    for (j = 0; j < data->n_values_per_frame; j++)
                     {
-                        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
-                        free(contents);
-                        return (TNG_CRITICAL);
+                        if (tng_fwritestr(tng_data, data->strings[0][i][j], hash_mode, &hash_state, __LINE__)
+                            == TNG_CRITICAL)
+                        {
+                            free(contents);
+                            return (TNG_CRITICAL);
+                        }
                     }
-                    strncpy(data->strings[0][i][j], contents + offset, len);
-                    offset += len;
                 }
             }
         }
     }
     else
     {
-        if (is_particle_data)
+        if (fwrite(contents, block_data_len, 1, tng_data->output_file) != 1)
+        {
+            fprintf(stderr, "TNG library: Could not write all block data. %s: %d\n", __FILE__, __LINE__);
+            free(contents);
+            return (TNG_CRITICAL);
+        }
+        if (hash_mode == TNG_USE_HASH)
+        {
+            tng_hash_append(&hash_state, contents, block_data_len);
+        }
+
+        free(contents);
+    }
+
+    if (hash_mode == TNG_USE_HASH
+        && tng_block_hash_write(tng_data, block, header_file_pos, &hash_state) != TNG_SUCCESS)
+    {
+        return (TNG_CRITICAL);
+    }
+
+    frame_set->n_written_frames += frame_set->n_unwritten_frames;
+    frame_set->n_unwritten_frames = 0;
+
+    return (TNG_SUCCESS);
+}
+
+/**
+ * @brief Read the meta information of a data block (particle or non-particle data).
+ * @param tng_data is a trajectory data container.
+ * @param datatype is set to the datatype of the data block.
+ * @param dependency is set to the dependency (particle and/or frame dependent)
+ * @param sparse_data is set to TRUE if data is not written every frame.
+ * @param n_values is set to the number of values per frame of the data.
+ * @param codec_id is set to the ID of the codec used to compress the data.
+ * @param first_frame_with_data is set to the first frame with data (only relevant if
+ * sparse_data == TRUE).
+ * @param stride_length is set to the writing interval of the data (1 if sparse_data
+ * == FALSE).
+ * @param num_first_particle is set to the number of the first particle with data written
+ * in this block.
+ * @param block_n_particles is set to the number of particles in this data block.
+ * @param multiplier is set to the compression multiplier.
+ * @param hash_mode specifies whether to check if the hash matches the contents or not.
+ * @param hash_state is the md5 hash of the block (only used if hash_mode == TNG_USE_HASH).
+ * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
+ * error has occured.
+ */
+static tng_function_status tng_data_block_meta_information_read(const struct tng_trajectory* tng_data,
+                                                                char*                  datatype,
+                                                                char*                  dependency,
+                                                                char*                  sparse_data,
+                                                                int64_t*               n_values,
+                                                                int64_t*               codec_id,
+                                                                int64_t*               first_frame_with_data,
+                                                                int64_t*               stride_length,
+                                                                int64_t*               n_frames,
+                                                                int64_t*               num_first_particle,
+                                                                int64_t*               block_n_particles,
+                                                                double*                multiplier,
+                                                                const char             hash_mode,
+                                                                struct tng_hash_state* hash_state)
+{
+    char     flags[2], buffer[sizeof(char) + sizeof(int64_t) * 2];
+    uint64_t values[5];
+    int64_t  n_values_left, i = 0;
+    tng_bool is_sparse;
+
+    /* The fields are read in three groups, since the presence of the later
+     * fields depends on the earlier ones. */
+    if (tng_file_input_buffer(tng_data, flags, sizeof(flags), hash_mode, hash_state, __LINE__)
+        != TNG_SUCCESS)
+    {
+        return (TNG_CRITICAL);
+    }
+    *datatype   = flags[0];
+    *dependency = flags[1];
+
+    /* The sparse data flag (if frame dependent), the number of values and the codec ID */
+    if (*dependency & TNG_FRAME_DEPENDENT)
+    {
+        if (tng_file_input_buffer(tng_data, buffer, sizeof(buffer), hash_mode, hash_state, __LINE__)
+            != TNG_SUCCESS)
+        {
+            return (TNG_CRITICAL);
+        }
+        *sparse_data = buffer[0];
+        memcpy(values, buffer + 1, sizeof(int64_t) * 2);
+        tng_input_values_swap_64(tng_data, values, 2, __LINE__);
+    }
+    else if (tng_file_input_numerical_64_n(tng_data, values, 2, hash_mode, hash_state, __LINE__)
+             != TNG_SUCCESS)
+    {
+        return (TNG_CRITICAL);
+    }
+    *n_values = (int64_t)values[0];
+    *codec_id = (int64_t)values[1];
+
+    /* The compression multiplier, the first frame with data and stride length
+     * (if sparse) and the particle range (if particle dependent) */
+    is_sparse     = (*dependency & TNG_FRAME_DEPENDENT) && *sparse_data ? TNG_TRUE : TNG_FALSE;
+    n_values_left = (*codec_id != TNG_UNCOMPRESSED ? 1 : 0) + (is_sparse ? 2 : 0)
+                    + (*dependency & TNG_PARTICLE_DEPENDENT ? 2 : 0);
+    if (tng_file_input_numerical_64_n(tng_data, values, n_values_left, hash_mode, hash_state,
+                                      __LINE__)
+        != TNG_SUCCESS)
+    {
+        return (TNG_CRITICAL);
+    }
+
+    if (*codec_id != TNG_UNCOMPRESSED)
+    {
+        memcpy(multiplier, &values[i++], sizeof(*multiplier));
+    }
+    else
+    {
+        *multiplier = 1;
+    }
+
+    if (*dependency & TNG_FRAME_DEPENDENT)
+    {
+        if (is_sparse)
         {
-            memcpy((char*)data->values + n_frames_div * size * n_values * num_first_particle,
-                   contents, full_data_len);
+            *first_frame_with_data = (int64_t)values[i++];
+            *stride_length         = (int64_t)values[i++];
+
+            *n_frames = tng_data->current_trajectory_frame_set.n_frames
+                        - (*first_frame_with_data - tng_data->current_trajectory_frame_set.first_frame);
         }
         else
         {
-            memcpy(data->values, contents, full_data_len);
-        }
-        /* Endianness is handled by the TNG compression library. TNG compressed blocks are always
-         * written as little endian by the compression library. */
-        if (codec_id != TNG_TNG_COMPRESSION)
-        {
-            switch (datatype)
-            {
-                case TNG_FLOAT_DATA:
-                    if (tng_data->input_endianness_swap_func_32)
-                    {
-                        for (i = 0; i < full_data_len; i += size)
-                        {
-                            if (tng_data->input_endianness_swap_func_32(
-                                        tng_data, (uint32_t*)((char*)data->values + i))
-                                != TNG_SUCCESS)
-                            {
-                                fprintf(stderr, "TNG library: Cannot swap byte order. %s: %d\n",
-                                        __FILE__, __LINE__);
-                            }
-                        }
-                    }
-                    break;
-                case TNG_INT_DATA:
-                case TNG_DOUBLE_DATA:
-                    if (tng_data->input_endianness_swap_func_64)
-                    {
-                        for (i = 0; i < full_data_len; i += size)
-                        {
-                            if (tng_data->input_endianness_swap_func_64(
-                                        tng_data, (uint64_t*)((char*)data->values + i))
-                                != TNG_SUCCESS)
-                            {
-                                fprintf(stderr, "TNG library: Cannot swap byte order. %s: %d\n",
-                                        __FILE__, __LINE__);
-                            }
-                        }
-                    }
-                    break;
-                case TNG_CHAR_DATA: break;
-            }
+            *first_frame_with_data = tng_data->current_trajectory_frame_set.first_frame;
+            *stride_length         = 1;
+            *n_frames              = tng_data->current_trajectory_frame_set.n_frames;
         }
     }
+    else
+    {
+        *first_frame_with_data = 0;
+        *stride_length         = 1;
+        *n_frames              = 1;
+    }
 
-    free(contents);
+    if (*dependency & TNG_PARTICLE_DEPENDENT)
+    {
+        *num_first_particle = (int64_t)values[i++];
+        *block_n_particles  = (int64_t)values[i++];
+    }
+    else
+    {
+        *num_first_particle = -1;
+        *block_n_particles  = 0;
+    }
 
     return (TNG_SUCCESS);
 }
 
 /**
- * @brief Write a data block (particle or non-particle data)
+ * @brief Read the contents of a data block (particle or non-particle data).
  * @param tng_data is a trajectory data container.
  * @param block is the block to store the data (should already contain
- * the block headers and the block contents).
- * @param block_index is the index number of the data block in the frame set.
- * @param is_particle_data is a flag to specify if the data to write is
- * particle dependent or not.
- * @param mapping is the particle mapping that is relevant for the data block.
- * Only relevant if writing particle dependent data.
+ * the block headers).
  * @param hash_mode is an option to decide whether to use the md5 hash or not.
- * If hash_mode == TNG_USE_HASH an md5 hash will be generated and written.
+ * If hash_mode == TNG_USE_HASH the written md5 hash in the file will be
+ * compared to the md5 hash of the read contents to ensure valid data.
  * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
  * error has occured.
  */
-static tng_function_status tng_data_block_write(struct tng_trajectory*             tng_data,
-                                                struct tng_gen_block*              block,
-                                                const int64_t                      block_index,
-                                                const tng_bool                     is_particle_data,
-                                                const struct tng_particle_mapping* mapping,
-                                                const char                         hash_mode)
+static tng_function_status tng_data_block_contents_read(struct tng_trajectory*      tng_data,
+                                                        const struct tng_gen_block* block,
+                                                        const char                  hash_mode)
 {
-    int64_t             n_particles, num_first_particle, n_frames, stride_length;
-    int64_t             full_data_len, block_data_len, frame_step, data_start_pos;
-    int64_t             i, j, k, curr_file_pos, header_file_pos;
-    int                 size;
-    size_t              len;
-    tng_function_status stat;
-    char                temp, *temp_name, ***first_dim_values, **second_dim_values, *contents;
-    double              multiplier;
-    tng_trajectory_frame_set_t frame_set = &tng_data->current_trajectory_frame_set;
-    tng_data_t                 data;
-    char                       block_type_flag;
-    md5_state_t                md5_state;
+    int64_t                           start_pos, n_values, codec_id, n_frames;
+    int64_t                           first_frame_with_data, remaining_len, stride_length;
+    int64_t                           block_n_particles, num_first_particle;
+    double                            multiplier;
+    char                              datatype, dependency, sparse_data;
+    tng_function_status               stat = TNG_SUCCESS;
+    struct tng_hash_state             hash_state;
+    struct tng_frame_set_cache_entry  cache_entry;
+    struct tng_frame_set_cache_entry* cached;
 
-    /* If we have already started writing frame sets it is too late to write
-     * non-trajectory data blocks */
-    if (tng_data->current_trajectory_frame_set_output_file_pos > 0)
+    if (tng_input_file_init(tng_data) != TNG_SUCCESS)
     {
-        block_type_flag = TNG_TRAJECTORY_BLOCK;
+        return (TNG_CRITICAL);
     }
-    else
+
+    start_pos = tng_input_file_tell(tng_data);
+
+    /* The decoded values of trajectory blocks may be kept in the frame set cache. */
+    cached = 0;
+    if (tng_data->current_trajectory_frame_set_input_file_pos > 0)
     {
-        block_type_flag = TNG_NON_TRAJECTORY_BLOCK;
+        cached = tng_frame_set_cache_find(tng_data, start_pos, block->id, hash_mode);
+    }
+    if (cached)
+    {
+        stat = tng_data_read(tng_data, block, cached->values_len, cached->datatype,
+                             cached->num_first_particle, cached->n_particles,
+                             cached->first_frame_with_data, cached->stride_length, cached->n_frames,
+                             cached->n_values, cached->codec_id, cached->multiplier, TNG_SKIP_HASH,
+                             0, cached);
+        tng_input_file_seek(tng_data, start_pos + block->block_contents_size, SEEK_SET);
+        return (stat);
     }
 
-    if (tng_output_file_init(tng_data) != TNG_SUCCESS)
+    if (hash_mode == TNG_USE_HASH)
     {
-        return (TNG_CRITICAL);
+        tng_block_hash_init(block, &hash_state);
     }
 
-    if (is_particle_data == TNG_TRUE)
+    /* FIXME: Does not check if the size of the contents matches the expected
+     * size or if the contents can be read. */
+
+    if (tng_data_block_meta_information_read(tng_data, &datatype, &dependency, &sparse_data,
+                                             &n_values, &codec_id, &first_frame_with_data,
+                                             &stride_length, &n_frames, &num_first_particle,
+                                             &block_n_particles, &multiplier, hash_mode, &hash_state)
+        == TNG_CRITICAL)
     {
-        if (block_type_flag == TNG_TRAJECTORY_BLOCK)
-        {
-            data = &frame_set->tr_particle_data[block_index];
+        fprintf(stderr, "TNG library: Cannot read data block (%s) meta information. %s: %d\n",
+                block->name, __FILE__, __LINE__);
+        return (TNG_CRITICAL);
+    }
 
-            /* If this data block has not had any data added in this frame set
-             * do not write it. */
-            if (data->first_frame_with_data < frame_set->first_frame)
-            {
-                return (TNG_SUCCESS);
-            }
+    remaining_len = block->block_contents_size - (tng_input_file_tell(tng_data) - start_pos);
 
-            stride_length = tng_max_i64(1, data->stride_length);
-        }
-        else
+    cache_entry.values = 0;
+    stat = tng_data_read(tng_data, block, remaining_len, datatype, num_first_particle,
+                         block_n_particles, first_frame_with_data, stride_length, n_frames,
+                         n_values, codec_id, multiplier, hash_mode, &hash_state,
+                         tng_data->frame_set_cache ? &cache_entry : 0);
+
+    if (hash_mode == TNG_USE_HASH)
+    {
+        /* If there is data left in the block that the current version of the library
+         * cannot interpret still read that to generate the MD5 hash. */
+        tng_hash_remaining_append(tng_data, block, start_pos, &hash_state);
+
+        if (tng_block_hash_match_verify(block, &hash_state) != TNG_SUCCESS)
         {
-            data          = &tng_data->non_tr_particle_data[block_index];
-            stride_length = 1;
+            fprintf(stderr,
+                    "TNG library: Data block contents corrupt (%s). Hashes do not match. "
+                    "%s: %d\n",
+                    block->name, __FILE__, __LINE__);
+            /* Corrupt blocks are not cached, so that they are reported again. */
+            cache_entry.values = 0;
         }
     }
     else
     {
-        if (block_type_flag == TNG_TRAJECTORY_BLOCK)
-        {
-            data = &frame_set->tr_data[block_index];
-
-            /* If this data block has not had any data added in this frame set
-             * do not write it. */
-            if (data->first_frame_with_data < frame_set->first_frame)
-            {
-                return (TNG_SUCCESS);
-            }
-
-            stride_length = tng_max_i64(1, data->stride_length);
-        }
-        else
+        /* Seek to the end of the block */
+        tng_input_file_seek(tng_data, start_pos + block->block_contents_size, SEEK_SET);
+    }
+
+    if (stat == TNG_SUCCESS && cache_entry.values
+        && tng_data->current_trajectory_frame_set_input_file_pos > 0)
+    {
+        cache_entry.file_pos              = start_pos;
+        cache_entry.block_id              = block->id;
+        cache_entry.hash_mode             = hash_mode;
+        cache_entry.datatype              = datatype;
+        cache_entry.n_values              = n_values;
+        cache_entry.codec_id              = codec_id;
+        cache_entry.first_frame_with_data = first_frame_with_data;
+        cache_entry.stride_length         = stride_length;
+        cache_entry.n_frames              = n_frames;
+        cache_entry.num_first_particle    = num_first_particle;
+        cache_entry.n_particles           = block_n_particles;
+        cache_entry.multiplier            = multiplier;
+        if (tng_frame_set_cache_add(tng_data, &cache_entry) == TNG_CRITICAL)
         {
-            data          = &tng_data->non_tr_data[block_index];
-            stride_length = 1;
+            return (TNG_CRITICAL);
         }
     }
 
-    switch (data->datatype)
+    return (stat);
+}
+
+/*
+// ** Move the blocks in a frame set so that there is no unused space between
+//  * them. This can only be done on the last frame set in the file and should
+//  * be done e.g. if the last frame set in the file has fewer frames than
+//  * default or after compressing data blocks in a frame set.
+//  * @param tng_data is a trajectory data container.
+//  * @details the current_trajectory_frame_set is the one that will be modified.
+//  * @return TNG_SUCCESS (0) if successful, TNG_FAILURE (1) if the frame set
+//  * cannot be aligned or TNG_CRITICAL (2) if a major error has occured.
+//  * FIXME: This function is not finished!!!
+//  *
+// static tng_function_status tng_frame_set_align(tng_trajectory_t tng_data)
+// {
+//     tng_gen_block_t block;
+//     tng_trajectory_frame_set_t frame_set;
+//     FILE *temp = tng_data->input_file;
+//     int64_t pos, contents_start_pos, output_file_len;
+//
+//     frame_set = &tng_data->current_trajectory_frame_set;
+//
+//     if(frame_set->n_written_frames == frame_set->n_frames)
+//     {
+//         return(TNG_SUCCESS);
+//     }
+//
+//     if(tng_data->current_trajectory_frame_set_output_file_pos !=
+//        tng_data->last_trajectory_frame_set_output_file_pos)
+//     {
+//     }
+//
+//     if(tng_output_file_init(tng_data) != TNG_SUCCESS)
+//     {
+//         fprintf(stderr, "TNG library: Cannot initialise destination file. %s: %d\n",
+//                __FILE__, __LINE__);
+//         return(TNG_CRITICAL);
+//     }
+//
+//     tng_block_init(&block);
+// //     output_file_pos = ftello(tng_data->output_file);
+//
+//     tng_data->input_file = tng_data->output_file;
+//
+//     pos = tng_data->current_trajectory_frame_set_output_file_pos;
+//
+//     fseeko(tng_data->output_file, pos, SEEK_SET);
+//     if(tng_block_header_read(tng_data, block) != TNG_SUCCESS)
+//     {
+//         fprintf(stderr, "TNG library: Cannot read frame set header. %s: %d\n",
+//             __FILE__, __LINE__);
+//         tng_data->input_file = temp;
+//         tng_block_destroy(&block);
+//         return(TNG_CRITICAL);
+//     }
+//
+//     contents_start_pos = ftello(tng_data->output_file);
+//
+//     fseeko(tng_data->output_file, 0, SEEK_END);
+//     output_file_len = ftello(tng_data->output_file);
+//     pos = contents_start_pos + block->block_contents_size;
+//     fseeko(tng_data->output_file, pos,
+//           SEEK_SET);
+//
+//     while(pos < output_file_len)
+//     {
+//         if(tng_block_header_read(tng_data, block) != TNG_SUCCESS)
+//         {
+//             fprintf(stderr, "TNG library: Cannot read block header at pos %" PRId64 ". %s: %d\n", pos,
+//                    __FILE__, __LINE__);
+//             tng_data->input_file = temp;
+//             tng_block_destroy(&block);
+//             return(TNG_CRITICAL);
+//         }
+//         pos += block->header_contents_size + block->block_contents_size;
+//         fseeko(tng_data->output_file, pos, SEEK_SET);
+//     }
+//
+//     return(TNG_SUCCESS);
+// }
+*/
+/**
+ * @brief Finish writing the current frame set. Update the number of frames
+ * and the hashes of the frame set and all its data blocks (if hash_mode
+ * == TNG_USE_HASH).
+ * @param tng_data is a trajectory data container.
+ * @param hash_mode specifies whether to update the block md5 hash when
+ * updating the pointers.
+ * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
+ * error has occured.
+ */
+static tng_function_status tng_frame_set_finalize(struct tng_trajectory* tng_data, const char hash_mode)
+{
+    tng_gen_block_t            block;
+    tng_trajectory_frame_set_t frame_set;
+    FILE*                      temp = tng_data->input_file;
+    int64_t                    pos, curr_file_pos;
+
+    frame_set = &tng_data->current_trajectory_frame_set;
+
+    if (frame_set->n_written_frames == frame_set->n_frames)
     {
-        case TNG_CHAR_DATA: size = 1; break;
-        case TNG_INT_DATA: size = sizeof(int64_t); break;
-        case TNG_FLOAT_DATA: size = sizeof(float); break;
-        case TNG_DOUBLE_DATA:
-        default: size = sizeof(double);
+        return (TNG_SUCCESS);
     }
 
-    len = strlen(data->block_name) + 1;
+    frame_set->n_written_frames = frame_set->n_frames;
 
-    if (!block->name || strlen(block->name) < len)
+    if (tng_output_file_init(tng_data) != TNG_SUCCESS)
     {
-        temp_name = (char*)realloc(block->name, len);
-        if (!temp_name)
-        {
-            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
-            free(block->name);
-            block->name = 0;
-            return (TNG_CRITICAL);
-        }
-        block->name = temp_name;
+        fprintf(stderr, "TNG library: Cannot initialise destination file. %s: %d\n", __FILE__, __LINE__);
+        return (TNG_CRITICAL);
     }
-    strncpy(block->name, data->block_name, len);
-    block->id = data->block_id;
 
-    /* If writing frame independent data data->n_frames is 0, but n_frames
-       is used for the loop writing the data (and reserving memory) and needs
-       to be at least 1 */
-    n_frames = tng_max_i64(1, data->n_frames);
+    tng_block_init(&block);
+    /*     output_file_pos = ftello(tng_data->output_file); */
 
-    if (block_type_flag == TNG_TRAJECTORY_BLOCK)
-    {
-        /* If the frame set is finished before writing the full number of frames
-           make sure the data block is not longer than the frame set. */
-        n_frames = tng_min_i64(n_frames, frame_set->n_frames);
+    tng_data->input_file = tng_data->output_file;
 
-        n_frames -= (data->first_frame_with_data - frame_set->first_frame);
-    }
+    curr_file_pos = ftello(tng_data->output_file);
 
-    frame_step = (n_frames - 1) / stride_length + 1;
+    pos = tng_data->current_trajectory_frame_set_output_file_pos;
 
-    /* TNG compression will use compression precision to get integers from
-     * floating point data. The compression multiplier stores that information
-     * to be able to return the precision of the compressed data. */
-    if (data->codec_id == TNG_TNG_COMPRESSION)
+    fseeko(tng_data->output_file, pos, SEEK_SET);
+
+    if (tng_block_header_read(tng_data, block) != TNG_SUCCESS)
     {
-        data->compression_multiplier = tng_data->compression_precision;
+        fprintf(stderr, "TNG library: Cannot read frame set header. %s: %d\n", __FILE__, __LINE__);
+        tng_data->input_file = temp;
+        tng_block_destroy(&block);
+        return (TNG_CRITICAL);
     }
-    /* Uncompressed data blocks do not use compression multipliers at all.
-     * GZip compression does not need it either. */
-    else if (data->codec_id == TNG_UNCOMPRESSED || data->codec_id == TNG_GZIP_COMPRESSION)
+
+    //     contents_start_pos = ftello(tng_data->output_file);
+
+    fseeko(tng_data->output_file, sizeof(frame_set->first_frame), SEEK_CUR);
+    if (fwrite(&frame_set->n_frames, sizeof(frame_set->n_frames), 1, tng_data->output_file) != 1)
     {
-        data->compression_multiplier = 1.0;
+        tng_data->input_file = temp;
+        tng_block_destroy(&block);
+        return (TNG_CRITICAL);
     }
 
-    if (data->dependency & TNG_PARTICLE_DEPENDENT)
+    if (hash_mode == TNG_USE_HASH)
     {
-        if (mapping && mapping->n_particles != 0)
-        {
-            n_particles        = mapping->n_particles;
-            num_first_particle = mapping->num_first_particle;
-        }
-        else
-        {
-            num_first_particle = 0;
-            if (tng_data->var_num_atoms_flag)
-            {
-                n_particles = frame_set->n_particles;
-            }
-            else
-            {
-                n_particles = tng_data->n_particles;
-            }
-        }
+        tng_block_hash_update(tng_data, block, pos, pos + block->header_contents_size);
     }
-    else
+
+    fseeko(tng_data->output_file, curr_file_pos, SEEK_SET);
+
+    tng_data->input_file = temp;
+    tng_block_destroy(&block);
+    return (TNG_SUCCESS);
+}
+
+tng_function_status DECLSPECDLLEXPORT tng_atom_residue_get(struct tng_trajectory* tng_data,
+                                                           struct tng_atom*       atom,
+                                                           tng_residue_t*         residue)
+{
+    (void)tng_data;
+
+    TNG_ASSERT(atom, "TNG library: atom must not be NULL");
+
+    *residue = atom->residue;
+
+    return (TNG_SUCCESS);
+}
+
+tng_function_status DECLSPECDLLEXPORT tng_atom_name_get(struct tng_trajectory* tng_data,
+                                                        struct tng_atom*       atom,
+                                                        char*                  name,
+                                                        const int              max_len)
+{
+    (void)tng_data;
+    TNG_ASSERT(atom, "TNG library: atom must not be NULL");
+    TNG_ASSERT(name, "TNG library: name must not be a NULL pointer");
+
+    strncpy(name, atom->name, max_len - 1);
+    name[max_len - 1] = 0;
+
+    if (strlen(atom->name) > (unsigned int)max_len - 1)
     {
-        /* This just appeases gcc-7 -Wmaybe-uninitialized.
-         * FIXME: It would be better to refactor so that
-         * TNG_PARTICLE_DEPENDENT triggers two distinct code paths.
-         */
-        num_first_particle = -1;
-        n_particles        = -1;
+        return (TNG_FAILURE);
     }
+    return (TNG_SUCCESS);
+}
 
-    if (data->dependency & TNG_PARTICLE_DEPENDENT)
+tng_function_status DECLSPECDLLEXPORT tng_atom_name_set(struct tng_trajectory* tng_data,
+                                                        struct tng_atom*       atom,
+                                                        const char*            new_name)
+{
+    unsigned int len;
+    (void)tng_data;
+
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(new_name, "TNG library: new_name must not be a NULL pointer.");
+
+    len = tng_min_size(strlen(new_name) + 1, TNG_MAX_STR_LEN);
+
+    /* If the currently stored string length is not enough to store the new
+     * string it is freed and reallocated. */
+    if (atom->name && strlen(atom->name) < len)
     {
-        if (tng_data_block_len_calculate(tng_data, data, TNG_TRUE, n_frames, frame_step,
-                                         stride_length, num_first_particle, n_particles,
-                                         &data_start_pos, &block->block_contents_size)
-            != TNG_SUCCESS)
-        {
-            fprintf(stderr, "TNG library: Cannot calculate length of particle data block. %s: %d\n",
-                    __FILE__, __LINE__);
-            return (TNG_CRITICAL);
-        }
+        free(atom->name);
+        atom->name = 0;
     }
-    else
+    if (!atom->name)
     {
-        if (tng_data_block_len_calculate(tng_data, data, TNG_FALSE, n_frames, frame_step, stride_length,
-                                         0, 1, &data_start_pos, &block->block_contents_size)
-            != TNG_SUCCESS)
+        atom->name = (char*)malloc(len);
+        if (!atom->name)
         {
-            fprintf(stderr,
-                    "TNG library: Cannot calculate length of non-particle data block. %s: %d\n",
-                    __FILE__, __LINE__);
+            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
             return (TNG_CRITICAL);
         }
     }
 
-    header_file_pos = ftello(tng_data->output_file);
+    strncpy(atom->name, new_name, len);
 
-    if (tng_block_header_write(tng_data, block) != TNG_SUCCESS)
-    {
-        fprintf(stderr, "TNG library: Cannot write header of file %s. %s: %d\n",
-                tng_data->output_file_path, __FILE__, __LINE__);
-        return (TNG_CRITICAL);
-    }
+    return (TNG_SUCCESS);
+}
 
-    if (hash_mode == TNG_USE_HASH)
-    {
-        md5_init(&md5_state);
-    }
+tng_function_status DECLSPECDLLEXPORT tng_atom_type_get(struct tng_trajectory* tng_data,
+                                                        struct tng_atom*       atom,
+                                                        char*                  type,
+                                                        const int              max_len)
+{
+    (void)tng_data;
+    TNG_ASSERT(atom, "TNG library: atom must not be NULL");
+    TNG_ASSERT(type, "TNG library: type must not be a NULL pointer");
 
-    if (tng_file_output_numerical(tng_data, &data->datatype, sizeof(data->datatype), hash_mode,
-                                  &md5_state, __LINE__)
-        == TNG_CRITICAL)
+    strncpy(type, atom->atom_type, max_len - 1);
+    type[max_len - 1] = 0;
+
+    if (strlen(atom->atom_type) > (unsigned int)max_len - 1)
     {
-        return (TNG_CRITICAL);
+        return (TNG_FAILURE);
     }
+    return (TNG_SUCCESS);
+}
 
-    if (tng_file_output_numerical(tng_data, &data->dependency, sizeof(data->dependency), hash_mode,
-                                  &md5_state, __LINE__)
-        == TNG_CRITICAL)
+tng_function_status DECLSPECDLLEXPORT tng_atom_type_set(struct tng_trajectory* tng_data,
+                                                        struct tng_atom*       atom,
+                                                        const char*            new_type)
+{
+    unsigned int len;
+    (void)tng_data;
+
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(new_type, "TNG library: new_type must not be a NULL pointer.");
+
+    len = tng_min_size(strlen(new_type) + 1, TNG_MAX_STR_LEN);
+
+    /* If the currently stored string length is not enough to store the new
+     * string it is freed and reallocated. */
+    if (atom->atom_type && strlen(atom->atom_type) < len)
     {
-        return (TNG_CRITICAL);
+        free(atom->atom_type);
+        atom->atom_type = 0;
     }
-
-    if (data->dependency & TNG_FRAME_DEPENDENT)
+    if (!atom->atom_type)
     {
-        if (stride_length > 1)
-        {
-            temp = 1;
-        }
-        else
-        {
-            temp = 0;
-        }
-        if (tng_file_output_numerical(tng_data, &temp, sizeof(temp), hash_mode, &md5_state, __LINE__)
-            == TNG_CRITICAL)
+        atom->atom_type = (char*)malloc(len);
+        if (!atom->atom_type)
         {
+            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
             return (TNG_CRITICAL);
         }
     }
 
-    if (tng_file_output_numerical(tng_data, &data->n_values_per_frame,
-                                  sizeof(data->n_values_per_frame), hash_mode, &md5_state, __LINE__)
-        == TNG_CRITICAL)
+    strncpy(atom->atom_type, new_type, len);
+
+    return (TNG_SUCCESS);
+}
+
+/**
+ * @brief Initialise an atom struct
+ * @param atom is the atom to initialise.
+ * @return TNG_SUCCESS (0) if successful.
+ */
+static tng_function_status tng_atom_init(struct tng_atom* atom)
+{
+    atom->name      = 0;
+    atom->atom_type = 0;
+
+    return (TNG_SUCCESS);
+}
+
+/**
+ * @brief Free the memory in an atom struct
+ * @param atom is the atom to destroy.
+ * @return TNG_SUCCESS (0) if successful.
+ */
+static tng_function_status tng_atom_destroy(struct tng_atom* atom)
+{
+    if (atom->name)
+    {
+        free(atom->name);
+        atom->name = 0;
+    }
+    if (atom->atom_type)
     {
-        return (TNG_CRITICAL);
+        free(atom->atom_type);
+        atom->atom_type = 0;
     }
 
-    if (tng_file_output_numerical(tng_data, &data->codec_id, sizeof(data->codec_id), hash_mode,
-                                  &md5_state, __LINE__)
-        == TNG_CRITICAL)
+    return (TNG_SUCCESS);
+}
+
+/**
+ * @brief Update chain->residue pointers (after new memory for
+ * molecule->residues has been allocated).
+ * @param tng_data The trajectory container containing the molecule.
+ * @param mol The molecule that contains the chains that need to be
+ * updated.
+ * @returns TNG_SUCCESS (0) if successful.
+ */
+static tng_function_status tng_molecule_chains_residue_pointers_update(const struct tng_trajectory* tng_data,
+                                                                       const struct tng_molecule* mol)
+{
+    tng_chain_t chain;
+    int64_t     i, res_cnt = 0;
+    (void)tng_data;
+
+    for (i = 0; i < mol->n_chains; i++)
     {
-        return (TNG_CRITICAL);
+        chain           = &mol->chains[i];
+        chain->residues = mol->residues + res_cnt;
+        res_cnt += chain->n_residues;
     }
+    return (TNG_SUCCESS);
+}
 
-    if (data->codec_id != TNG_UNCOMPRESSED)
+/**
+ * @brief Update atoms->residue pointers (after new memory for
+ * molecule->residues has been allocated).
+ * @param tng_data The trajectory container containing the molecule.
+ * @param mol The molecule that contains the chains that need to be
+ * updated.
+ * @returns TNG_SUCCESS (0) if successful.
+ */
+static tng_function_status tng_molecule_atoms_residue_pointers_update(const struct tng_trajectory* tng_data,
+                                                                      const struct tng_molecule* mol)
+{
+    tng_atom_t    atom;
+    tng_residue_t residue;
+    int64_t       i, j, atom_offset = 0;
+    (void)tng_data;
+
+    for (i = 0; i < mol->n_residues; i++)
     {
-        if (tng_file_output_numerical(tng_data, &data->compression_multiplier,
-                                      sizeof(data->compression_multiplier), hash_mode, &md5_state, __LINE__)
-            == TNG_CRITICAL)
+        residue = &mol->residues[i];
+        for (j = 0; j < residue->n_atoms; j++)
         {
-            return (TNG_CRITICAL);
+            atom          = &mol->atoms[j + atom_offset];
+            atom->residue = residue;
         }
+        atom_offset += residue->n_atoms;
     }
+    return (TNG_SUCCESS);
+}
 
-    if (data->n_frames > 0 && stride_length > 1)
-    {
-        /* FIXME: first_frame_with_data is not reliably set */
-        if (data->first_frame_with_data == 0)
-        {
-            data->first_frame_with_data = frame_set->first_frame;
-        }
-        if (tng_file_output_numerical(tng_data, &data->first_frame_with_data,
-                                      sizeof(data->first_frame_with_data), hash_mode, &md5_state, __LINE__)
-            == TNG_CRITICAL)
-        {
-            return (TNG_CRITICAL);
-        }
+tng_function_status DECLSPECDLLEXPORT tng_version_major(struct tng_trajectory* tng_data, int* version)
+{
+    (void)tng_data;
 
-        if (tng_file_output_numerical(tng_data, &stride_length, sizeof(stride_length), hash_mode,
-                                      &md5_state, __LINE__)
-            == TNG_CRITICAL)
-        {
-            return (TNG_CRITICAL);
-        }
-    }
+    *version = TNG_VERSION_MAJOR;
 
-    if (data->dependency & TNG_PARTICLE_DEPENDENT)
-    {
-        if (tng_file_output_numerical(tng_data, &num_first_particle, sizeof(num_first_particle),
-                                      hash_mode, &md5_state, __LINE__)
-            == TNG_CRITICAL)
-        {
-            return (TNG_CRITICAL);
-        }
+    return (TNG_SUCCESS);
+}
 
-        if (tng_file_output_numerical(tng_data, &n_particles, sizeof(n_particles), hash_mode, &md5_state, __LINE__)
-            == TNG_CRITICAL)
-        {
-            return (TNG_CRITICAL);
-        }
-    }
+tng_function_status DECLSPECDLLEXPORT tng_version_minor(struct tng_trajectory* tng_data, int* version)
+{
+    (void)tng_data;
 
-    if (data->datatype == TNG_CHAR_DATA)
-    {
-        if (data->strings)
-        {
-            if (data->dependency & TNG_PARTICLE_DEPENDENT)
-            {
-                for (i = 0; i < frame_step; i++)
-                {
-                    first_dim_values = data->strings[i];
-                    for (j = num_first_particle; j < num_first_particle + n_particles; j++)
-                    {
-                        second_dim_values = first_dim_values[j];
-                        for (k = 0; k < data->n_values_per_frame; k++)
-                        {
-                            if (tng_fwritestr(tng_data, second_dim_values[k], hash_mode, &md5_state, __LINE__)
-                                == TNG_CRITICAL)
-                            {
-                                return (TNG_CRITICAL);
-                            }
-                        }
-                    }
-                }
-            }
-            else
-            {
-                for (i = 0; i < frame_step; i++)
-                {
-                    for (j = 0; j < data->n_values_per_frame; j++)
-                    {
-                        if (tng_fwritestr(tng_data, data->strings[0][i][j], hash_mode, &md5_state, __LINE__)
-                            == TNG_CRITICAL)
-                        {
-                            return (TNG_CRITICAL);
-                        }
-                    }
-                }
-            }
-        }
-    }
-    else
-    {
-        if (data->dependency & TNG_PARTICLE_DEPENDENT)
-        {
-            full_data_len = size * frame_step * n_particles * data->n_values_per_frame;
-        }
-        else
-        {
-            full_data_len = size * frame_step * data->n_values_per_frame;
-        }
-        contents = (char*)malloc(full_data_len);
-        if (!contents)
-        {
-            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
-            return (TNG_CRITICAL);
-        }
+    *version = TNG_VERSION_MINOR;
 
-        if (data->values)
-        {
-            memcpy(contents, data->values, full_data_len);
-            /* If writing TNG compressed data the endianness is taken into account by the
-             * compression routines. TNG compressed data is always written as little endian. */
-            if (data->codec_id != TNG_TNG_COMPRESSION)
-            {
-                switch (data->datatype)
-                {
-                    case TNG_FLOAT_DATA:
-                        if (data->codec_id == TNG_UNCOMPRESSED || data->codec_id == TNG_GZIP_COMPRESSION)
-                        {
-                            if (tng_data->output_endianness_swap_func_32)
-                            {
-                                for (i = 0; i < full_data_len; i += size)
-                                {
-                                    if (tng_data->output_endianness_swap_func_32(
-                                                tng_data, (uint32_t*)(contents + i))
-                                        != TNG_SUCCESS)
-                                    {
-                                        fprintf(stderr,
-                                                "TNG library: Cannot swap byte order. %s: %d\n",
-                                                __FILE__, __LINE__);
-                                    }
-                                }
-                            }
-                        }
-                        else
-                        {
-                            multiplier = data->compression_multiplier;
-                            if (fabs(multiplier - 1.0) > 0.00001 || tng_data->output_endianness_swap_func_32)
-                            {
-                                for (i = 0; i < full_data_len; i += size)
-                                {
-                                    *(float*)(contents + i) *= (float)multiplier;
-                                    if (tng_data->output_endianness_swap_func_32
-                                        && tng_data->output_endianness_swap_func_32(
-                                                   tng_data, (uint32_t*)(contents + i))
-                                                   != TNG_SUCCESS)
-                                    {
-                                        fprintf(stderr,
-                                                "TNG library: Cannot swap byte order. %s: %d\n",
-                                                __FILE__, __LINE__);
-                                    }
-                                }
-                            }
-                        }
-                        break;
-                    case TNG_INT_DATA:
-                        if (tng_data->output_endianness_swap_func_64)
-                        {
-                            for (i = 0; i < full_data_len; i += size)
-                            {
-                                if (tng_data->output_endianness_swap_func_64(
-                                            tng_data, (uint64_t*)(contents + i))
-                                    != TNG_SUCCESS)
-                                {
-                                    fprintf(stderr, "TNG library: Cannot swap byte order. %s: %d\n",
-                                            __FILE__, __LINE__);
-                                }
-                            }
-                        }
-                        break;
-                    case TNG_DOUBLE_DATA:
-                        if (data->codec_id == TNG_UNCOMPRESSED || data->codec_id == TNG_GZIP_COMPRESSION)
-                        {
-                            if (tng_data->output_endianness_swap_func_64)
-                            {
-                                for (i = 0; i < full_data_len; i += size)
-                                {
-                                    if (tng_data->output_endianness_swap_func_64(
-                                                tng_data, (uint64_t*)(contents + i))
-                                        != TNG_SUCCESS)
-                                    {
-                                        fprintf(stderr,
-                                                "TNG library: Cannot swap byte order. %s: %d\n",
-                                                __FILE__, __LINE__);
-                                    }
-                                }
-                            }
-                        }
-                        else
-                        {
-                            multiplier = data->compression_multiplier;
-                            if (fabs(multiplier - 1.0) > 0.00001 || tng_data->output_endianness_swap_func_64)
-                            {
-                                for (i = 0; i < full_data_len; i += size)
-                                {
-                                    *(double*)(contents + i) *= multiplier;
-                                    if (tng_data->output_endianness_swap_func_64
-                                        && tng_data->output_endianness_swap_func_64(
-                                                   tng_data, (uint64_t*)(contents + i))
-                                                   != TNG_SUCCESS)
-                                    {
-                                        fprintf(stderr,
-                                                "TNG library: Cannot swap byte order. %s: %d\n",
-                                                __FILE__, __LINE__);
-                                    }
-                                }
-                            }
-                        }
-                        break;
-                    case TNG_CHAR_DATA: break;
-                }
-            }
-        }
-        else
-        {
-            memset(contents, 0, full_data_len);
-        }
+    return (TNG_SUCCESS);
+}
 
-        block_data_len = full_data_len;
+tng_function_status DECLSPECDLLEXPORT tng_version_patchlevel(struct tng_trajectory* tng_data, int* patch_level)
+{
+    (void)tng_data;
 
-        switch (data->codec_id)
-        {
-            case TNG_XTC_COMPRESSION:
-                fprintf(stderr, "TNG library: XTC compression not implemented yet.\n");
-                data->codec_id = TNG_UNCOMPRESSED;
-                break;
-            case TNG_TNG_COMPRESSION:
-                stat = tng_compress(tng_data, block, frame_step, n_particles, data->datatype,
-                                    &contents, &block_data_len);
-                if (stat != TNG_SUCCESS)
-                {
-                    fprintf(stderr,
-                            "TNG library: Could not write TNG compressed block data. %s: %d\n",
-                            __FILE__, __LINE__);
-                    if (stat == TNG_CRITICAL)
-                    {
-                        return (TNG_CRITICAL);
-                    }
-                    /* Set the data again, but with no compression (to write only
-                     * the relevant data) */
-                    data->codec_id = TNG_UNCOMPRESSED;
-                    stat = tng_data_block_write(tng_data, block, block_index, is_particle_data,
-                                                mapping, hash_mode);
-                    free(contents);
-                    return (stat);
-                }
-                break;
-            case TNG_GZIP_COMPRESSION:
-                /*         fprintf(stderr, "TNG library: Before compression: %" PRId64 "\n", block->block_contents_size); */
-                stat = tng_gzip_compress(tng_data, &contents, full_data_len, &block_data_len);
-                if (stat != TNG_SUCCESS)
-                {
-                    fprintf(stderr, "TNG library: Could not write gzipped block data. %s: %d\n",
-                            __FILE__, __LINE__);
-                    if (stat == TNG_CRITICAL)
-                    {
-                        return (TNG_CRITICAL);
-                    }
-                    data->codec_id = TNG_UNCOMPRESSED;
-                }
-                /*         fprintf(stderr, "TNG library: After compression: %" PRId64 "\n", block->block_contents_size); */
-                break;
-        }
-        if (block_data_len != full_data_len)
-        {
-            block->block_contents_size -= full_data_len - block_data_len;
+    *patch_level = TNG_VERSION_PATCHLEVEL;
 
-            curr_file_pos = ftello(tng_data->output_file);
-            fseeko(tng_data->output_file, header_file_pos + sizeof(block->header_contents_size), SEEK_SET);
+    return (TNG_SUCCESS);
+}
 
-            if (tng_file_output_numerical(tng_data, &block->block_contents_size,
-                                          sizeof(block->block_contents_size), TNG_SKIP_HASH, 0, __LINE__)
-                == TNG_CRITICAL)
-            {
-                return (TNG_CRITICAL);
-            }
-            fseeko(tng_data->output_file, curr_file_pos, SEEK_SET);
-        }
-        if (fwrite(contents, block_data_len, 1, tng_data->output_file) != 1)
-        {
-            fprintf(stderr, "TNG library: Could not write all block data. %s: %d\n", __FILE__, __LINE__);
-            return (TNG_CRITICAL);
-        }
-        if (hash_mode == TNG_USE_HASH)
-        {
-            md5_append(&md5_state, (md5_byte_t*)contents, block_data_len);
-        }
+tng_function_status DECLSPECDLLEXPORT tng_version(struct tng_trajectory* tng_data, char* version, const int max_len)
+{
+    (void)tng_data;
+    TNG_ASSERT(version, "TNG library: version must not be a NULL pointer");
+
+    TNG_SNPRINTF(version, max_len, "%s", TNG_VERSION);
 
-        free(contents);
-    }
+    return (TNG_SUCCESS);
+}
 
-    if (hash_mode == TNG_USE_HASH)
+tng_function_status DECLSPECDLLEXPORT tng_molecule_add(struct tng_trajectory* tng_data,
+                                                       const char*            name,
+                                                       tng_molecule_t*        molecule)
+{
+    int64_t id;
+
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(name, "TNG library: name must not be a NULL pointer.");
+
+    /* Set ID to the ID of the last molecule + 1 */
+    if (tng_data->n_molecules)
     {
-        md5_finish(&md5_state, (md5_byte_t*)block->md5_hash);
-        curr_file_pos = ftello(tng_data->output_file);
-        fseeko(tng_data->output_file, header_file_pos + 3 * sizeof(int64_t), SEEK_SET);
-        if (fwrite(block->md5_hash, TNG_MD5_HASH_LEN, 1, tng_data->output_file) != 1)
-        {
-            fprintf(stderr, "TNG library: Could not write MD5 hash. %s: %d\n", __FILE__, __LINE__);
-            return (TNG_CRITICAL);
-        }
-        fseeko(tng_data->output_file, curr_file_pos, SEEK_SET);
+        id = tng_data->molecules[tng_data->n_molecules - 1].id + 1;
+    }
+    else
+    {
+        id = 1;
     }
 
-    frame_set->n_written_frames += frame_set->n_unwritten_frames;
-    frame_set->n_unwritten_frames = 0;
-
-    return (TNG_SUCCESS);
+    return (tng_molecule_w_id_add(tng_data, name, id, molecule));
 }
 
-/**
- * @brief Read the meta information of a data block (particle or non-particle data).
- * @param tng_data is a trajectory data container.
- * @param datatype is set to the datatype of the data block.
- * @param dependency is set to the dependency (particle and/or frame dependent)
- * @param sparse_data is set to TRUE if data is not written every frame.
- * @param n_values is set to the number of values per frame of the data.
- * @param codec_id is set to the ID of the codec used to compress the data.
- * @param first_frame_with_data is set to the first frame with data (only relevant if
- * sparse_data == TRUE).
- * @param stride_length is set to the writing interval of the data (1 if sparse_data
- * == FALSE).
- * @param num_first_particle is set to the number of the first particle with data written
- * in this block.
- * @param block_n_particles is set to the number of particles in this data block.
- * @param multiplier is set to the compression multiplier.
- * @param hash_mode specifies whether to check if the hash matches the contents or not.
- * @param md5_state is the md5 hash of the block (only used if hash_mode == TNG_USE_HASH).
- * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
- * error has occured.
- */
-static tng_function_status tng_data_block_meta_information_read(const struct tng_trajectory* tng_data,
-                                                                char*        datatype,
-                                                                char*        dependency,
-                                                                char*        sparse_data,
-                                                                int64_t*     n_values,
-                                                                int64_t*     codec_id,
-                                                                int64_t*     first_frame_with_data,
-                                                                int64_t*     stride_length,
-                                                                int64_t*     n_frames,
-                                                                int64_t*     num_first_particle,
-                                                                int64_t*     block_n_particles,
-                                                                double*      multiplier,
-                                                                const char   hash_mode,
-                                                                md5_state_t* md5_state)
-{
-    if (tng_file_input_numerical(tng_data, datatype, sizeof(*datatype), hash_mode, md5_state, __LINE__)
-        == TNG_CRITICAL)
+tng_function_status DECLSPECDLLEXPORT tng_molecule_w_id_add(struct tng_trajectory* tng_data,
+                                                            const char*            name,
+                                                            const int64_t          id,
+                                                            tng_molecule_t*        molecule)
+{
+    tng_molecule_t      new_molecules;
+    int64_t*            new_molecule_cnt_list;
+    tng_function_status stat = TNG_SUCCESS;
+
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(name, "TNG library: name must not be a NULL pointer.");
+
+    new_molecules = (tng_molecule_t)realloc(
+            tng_data->molecules, sizeof(struct tng_molecule) * (tng_data->n_molecules + 1));
+
+    if (!new_molecules)
     {
+        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+        free(tng_data->molecules);
+        tng_data->molecules = 0;
         return (TNG_CRITICAL);
     }
 
-    if (tng_file_input_numerical(tng_data, dependency, sizeof(*dependency), hash_mode, md5_state, __LINE__)
-        == TNG_CRITICAL)
+    new_molecule_cnt_list = (int64_t*)realloc(tng_data->molecule_cnt_list,
+                                              sizeof(int64_t) * (tng_data->n_molecules + 1));
+
+    if (!new_molecule_cnt_list)
     {
+        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+        free(tng_data->molecule_cnt_list);
+        tng_data->molecule_cnt_list = 0;
+        free(new_molecules);
         return (TNG_CRITICAL);
     }
 
-    if (*dependency & TNG_FRAME_DEPENDENT)
+    tng_data->molecules         = new_molecules;
+    tng_data->molecule_cnt_list = new_molecule_cnt_list;
+
+    *molecule = &new_molecules[tng_data->n_molecules];
+
+    tng_molecule_init(tng_data, *molecule);
+    tng_molecule_name_set(tng_data, *molecule, name);
+
+    /* FIXME: Should this be a function argument instead? */
+    tng_data->molecule_cnt_list[tng_data->n_molecules] = 0;
+    tng_data->molecule_index.valid                     = TNG_FALSE;
+
+    (*molecule)->id = id;
+
+    tng_data->n_molecules++;
+
+    return (stat);
+}
+
+tng_function_status DECLSPECDLLEXPORT tng_molecule_existing_add(struct tng_trajectory* tng_data,
+                                                                tng_molecule_t*        molecule_p)
+{
+    int64_t *      new_molecule_cnt_list, id;
+    tng_molecule_t new_molecules, molecule;
+
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+
+    /* Set ID to the ID of the last molecule + 1 */
+    if (tng_data->n_molecules)
     {
-        if (tng_file_input_numerical(tng_data, sparse_data, sizeof(*sparse_data), hash_mode, md5_state, __LINE__)
-            == TNG_CRITICAL)
-        {
-            return (TNG_CRITICAL);
-        }
+        id = tng_data->molecules[tng_data->n_molecules - 1].id + 1;
     }
-
-    if (tng_file_input_numerical(tng_data, n_values, sizeof(*n_values), hash_mode, md5_state, __LINE__)
-        == TNG_CRITICAL)
+    else
     {
-        return (TNG_CRITICAL);
+        id = 1;
     }
 
-    if (tng_file_input_numerical(tng_data, codec_id, sizeof(*codec_id), hash_mode, md5_state, __LINE__)
-        == TNG_CRITICAL)
+    new_molecules = (tng_molecule_t)realloc(
+            tng_data->molecules, sizeof(struct tng_molecule) * (tng_data->n_molecules + 1));
+
+    if (!new_molecules)
     {
+        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+        free(tng_data->molecules);
+        tng_data->molecules = 0;
         return (TNG_CRITICAL);
     }
 
-    if (*codec_id != TNG_UNCOMPRESSED)
+    new_molecule_cnt_list = (int64_t*)realloc(tng_data->molecule_cnt_list,
+                                              sizeof(int64_t) * (tng_data->n_molecules + 1));
+
+    if (!new_molecule_cnt_list)
     {
-        if (tng_file_input_numerical(tng_data, multiplier, sizeof(*multiplier), hash_mode, md5_state, __LINE__)
-            == TNG_CRITICAL)
-        {
-            return (TNG_CRITICAL);
-        }
+        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+        free(tng_data->molecule_cnt_list);
+        tng_data->molecule_cnt_list = 0;
+        free(new_molecules);
+        return (TNG_CRITICAL);
     }
-    else
+
+    molecule = *molecule_p;
+
+    tng_data->molecules         = new_molecules;
+    tng_data->molecule_cnt_list = new_molecule_cnt_list;
+
+    new_molecules[tng_data->n_molecules] = *molecule;
+
+    tng_data->molecule_cnt_list[tng_data->n_molecules] = 0;
+    tng_data->molecule_index.valid                     = TNG_FALSE;
+
+    free(*molecule_p);
+
+    molecule = &new_molecules[tng_data->n_molecules];
+
+    *molecule_p = molecule;
+
+    molecule->id = id;
+
+    tng_data->n_molecules++;
+
+    return (TNG_SUCCESS);
+}
+
+tng_function_status tng_molecule_name_get(struct tng_trajectory* tng_data,
+                                          struct tng_molecule*   molecule,
+                                          char*                  name,
+                                          const int              max_len)
+{
+    (void)tng_data;
+    TNG_ASSERT(molecule, "TNG library: molecule must not be NULL");
+    TNG_ASSERT(name, "TNG library: name must not be a NULL pointer");
+
+    strncpy(name, molecule->name, max_len - 1);
+    name[max_len - 1] = 0;
+
+    if (strlen(molecule->name) > (unsigned int)max_len - 1)
     {
-        *multiplier = 1;
+        return (TNG_FAILURE);
     }
+    return (TNG_SUCCESS);
+}
 
-    if (*dependency & TNG_FRAME_DEPENDENT)
-    {
-        if (*sparse_data)
-        {
-            if (tng_file_input_numerical(tng_data, first_frame_with_data,
-                                         sizeof(*first_frame_with_data), hash_mode, md5_state, __LINE__)
-                == TNG_CRITICAL)
-            {
-                return (TNG_CRITICAL);
-            }
+tng_function_status DECLSPECDLLEXPORT tng_molecule_name_set(struct tng_trajectory* tng_data,
+                                                            struct tng_molecule*   molecule,
+                                                            const char*            new_name)
+{
+    unsigned int len;
+    (void)tng_data;
 
-            if (tng_file_input_numerical(tng_data, stride_length, sizeof(*stride_length), hash_mode,
-                                         md5_state, __LINE__)
-                == TNG_CRITICAL)
-            {
-                return (TNG_CRITICAL);
-            }
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(new_name, "TNG library: new_name must not be a NULL pointer.");
 
-            *n_frames = tng_data->current_trajectory_frame_set.n_frames
-                        - (*first_frame_with_data - tng_data->current_trajectory_frame_set.first_frame);
-        }
-        else
-        {
-            *first_frame_with_data = tng_data->current_trajectory_frame_set.first_frame;
-            *stride_length         = 1;
-            *n_frames              = tng_data->current_trajectory_frame_set.n_frames;
-        }
-    }
-    else
+    len = tng_min_size(strlen(new_name) + 1, TNG_MAX_STR_LEN);
+
+    /* If the currently stored string length is not enough to store the new
+     * string it is freed and reallocated. */
+    if (molecule->name && strlen(molecule->name) < len)
     {
-        *first_frame_with_data = 0;
-        *stride_length         = 1;
-        *n_frames              = 1;
+        free(molecule->name);
+        molecule->name = 0;
     }
-
-    if (*dependency & TNG_PARTICLE_DEPENDENT)
+    if (!molecule->name)
     {
-        if (tng_file_input_numerical(tng_data, num_first_particle, sizeof(*num_first_particle),
-                                     hash_mode, md5_state, __LINE__)
-            == TNG_CRITICAL)
+        molecule->name = (char*)malloc(len);
+        if (!molecule->name)
         {
+            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
             return (TNG_CRITICAL);
         }
+    }
 
-        if (tng_file_input_numerical(tng_data, block_n_particles, sizeof(*block_n_particles),
-                                     hash_mode, md5_state, __LINE__)
-            == TNG_CRITICAL)
+    strncpy(molecule->name, new_name, len);
+
+    return (TNG_SUCCESS);
+}
+
+tng_function_status DECLSPECDLLEXPORT tng_molecule_cnt_get(struct tng_trajectory* tng_data,
+                                                           struct tng_molecule*   molecule,
+                                                           int64_t*               cnt)
+{
+    int64_t i, index = -1;
+
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(cnt, "TNG library: cnt must not be a NULL pointer.");
+
+    for (i = 0; i < tng_data->n_molecules; i++)
+    {
+        if (&tng_data->molecules[i] == molecule)
         {
-            return (TNG_CRITICAL);
+            index = i;
+            break;
         }
     }
-    else
-    {
-        *num_first_particle = -1;
-        *block_n_particles  = 0;
+    if (index == -1)
+    {
+        return (TNG_FAILURE);
     }
+    *cnt = tng_data->molecule_cnt_list[index];
 
     return (TNG_SUCCESS);
 }
 
-/**
- * @brief Read the contents of a data block (particle or non-particle data).
- * @param tng_data is a trajectory data container.
- * @param block is the block to store the data (should already contain
- * the block headers).
- * @param hash_mode is an option to decide whether to use the md5 hash or not.
- * If hash_mode == TNG_USE_HASH the written md5 hash in the file will be
- * compared to the md5 hash of the read contents to ensure valid data.
- * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
- * error has occured.
- */
-static tng_function_status tng_data_block_contents_read(struct tng_trajectory*      tng_data,
-                                                        const struct tng_gen_block* block,
-                                                        const char                  hash_mode)
+tng_function_status DECLSPECDLLEXPORT tng_molecule_cnt_set(struct tng_trajectory* tng_data,
+                                                           struct tng_molecule*   molecule,
+                                                           const int64_t          cnt)
 {
-    int64_t             start_pos, n_values, codec_id, n_frames, first_frame_with_data;
-    int64_t             remaining_len, stride_length, block_n_particles, num_first_particle;
-    double              multiplier;
-    char                datatype, dependency, sparse_data;
-    tng_function_status stat = TNG_SUCCESS;
-    char                hash[TNG_MD5_HASH_LEN];
-    md5_state_t         md5_state;
-
-    if (tng_input_file_init(tng_data) != TNG_SUCCESS)
-    {
-        return (TNG_CRITICAL);
-    }
+    int64_t i, old_cnt, index = -1;
 
-    start_pos = ftello(tng_data->input_file);
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
 
-    if (hash_mode == TNG_USE_HASH)
+    for (i = 0; i < tng_data->n_molecules; i++)
     {
-        md5_init(&md5_state);
+        if (&tng_data->molecules[i] == molecule)
+        {
+            index = i;
+            break;
+        }
     }
-
-    /* FIXME: Does not check if the size of the contents matches the expected
-     * size or if the contents can be read. */
-
-    if (tng_data_block_meta_information_read(tng_data, &datatype, &dependency, &sparse_data,
-                                             &n_values, &codec_id, &first_frame_with_data,
-                                             &stride_length, &n_frames, &num_first_particle,
-                                             &block_n_particles, &multiplier, hash_mode, &md5_state)
-        == TNG_CRITICAL)
+    if (index == -1)
     {
-        fprintf(stderr, "TNG library: Cannot read data block (%s) meta information. %s: %d\n",
-                block->name, __FILE__, __LINE__);
-        return (TNG_CRITICAL);
+        fprintf(stderr, "TNG library: Could not find molecule in TNG trajectory. %s: %d\n",
+                __FILE__, __LINE__);
+        return (TNG_FAILURE);
     }
-
-    remaining_len = block->block_contents_size - (ftello(tng_data->input_file) - start_pos);
-
-    stat = tng_data_read(tng_data, block, remaining_len, datatype, num_first_particle,
-                         block_n_particles, first_frame_with_data, stride_length, n_frames,
-                         n_values, codec_id, multiplier, hash_mode, &md5_state);
-
-    if (hash_mode == TNG_USE_HASH)
+    if (tng_data->var_num_atoms_flag == TNG_CONSTANT_N_ATOMS)
     {
-        /* If there is data left in the block that the current version of the library
-         * cannot interpret still read that to generate the MD5 hash. */
-        tng_md5_remaining_append(tng_data, block, start_pos, &md5_state);
+        old_cnt                            = tng_data->molecule_cnt_list[index];
+        tng_data->molecule_cnt_list[index] = cnt;
 
-        md5_finish(&md5_state, (md5_byte_t*)hash);
-        if (strncmp(block->md5_hash, "\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0", TNG_MD5_HASH_LEN) != 0)
-        {
-            if (strncmp(block->md5_hash, hash, TNG_MD5_HASH_LEN) != 0)
-            {
-                fprintf(stderr,
-                        "TNG library: Data block contents corrupt (%s). Hashes do not match. "
-                        "%s: %d\n",
-                        block->name, __FILE__, __LINE__);
-            }
-        }
+        tng_data->n_particles += (cnt - old_cnt) * tng_data->molecules[index].n_atoms;
     }
     else
     {
-        /* Seek to the end of the block */
-        fseeko(tng_data->input_file, start_pos + block->block_contents_size, SEEK_SET);
+        old_cnt = tng_data->current_trajectory_frame_set.molecule_cnt_list[index];
+        tng_data->current_trajectory_frame_set.molecule_cnt_list[index] = cnt;
+
+        tng_data->current_trajectory_frame_set.n_particles +=
+                (cnt - old_cnt) * tng_data->molecules[index].n_atoms;
     }
+    tng_data->molecule_index.valid = TNG_FALSE;
 
-    return (stat);
+    return (TNG_SUCCESS);
 }
 
-/*
-// ** Move the blocks in a frame set so that there is no unused space between
-//  * them. This can only be done on the last frame set in the file and should
-//  * be done e.g. if the last frame set in the file has fewer frames than
-//  * default or after compressing data blocks in a frame set.
-//  * @param tng_data is a trajectory data container.
-//  * @details the current_trajectory_frame_set is the one that will be modified.
-//  * @return TNG_SUCCESS (0) if successful, TNG_FAILURE (1) if the frame set
-//  * cannot be aligned or TNG_CRITICAL (2) if a major error has occured.
-//  * FIXME: This function is not finished!!!
-//  *
-// static tng_function_status tng_frame_set_align(tng_trajectory_t tng_data)
-// {
-//     tng_gen_block_t block;
-//     tng_trajectory_frame_set_t frame_set;
-//     FILE *temp = tng_data->input_file;
-//     int64_t pos, contents_start_pos, output_file_len;
-//
-//     frame_set = &tng_data->current_trajectory_frame_set;
-//
-//     if(frame_set->n_written_frames == frame_set->n_frames)
-//     {
-//         return(TNG_SUCCESS);
-//     }
-//
-//     if(tng_data->current_trajectory_frame_set_output_file_pos !=
-//        tng_data->last_trajectory_frame_set_output_file_pos)
-//     {
-//     }
-//
-//     if(tng_output_file_init(tng_data) != TNG_SUCCESS)
-//     {
-//         fprintf(stderr, "TNG library: Cannot initialise destination file. %s: %d\n",
-//                __FILE__, __LINE__);
-//         return(TNG_CRITICAL);
-//     }
-//
-//     tng_block_init(&block);
-// //     output_file_pos = ftello(tng_data->output_file);
-//
-//     tng_data->input_file = tng_data->output_file;
-//
-//     pos = tng_data->current_trajectory_frame_set_output_file_pos;
-//
-//     fseeko(tng_data->output_file, pos, SEEK_SET);
-//     if(tng_block_header_read(tng_data, block) != TNG_SUCCESS)
-//     {
-//         fprintf(stderr, "TNG library: Cannot read frame set header. %s: %d\n",
-//             __FILE__, __LINE__);
-//         tng_data->input_file = temp;
-//         tng_block_destroy(&block);
-//         return(TNG_CRITICAL);
-//     }
-//
-//     contents_start_pos = ftello(tng_data->output_file);
-//
-//     fseeko(tng_data->output_file, 0, SEEK_END);
-//     output_file_len = ftello(tng_data->output_file);
-//     pos = contents_start_pos + block->block_contents_size;
-//     fseeko(tng_data->output_file, pos,
-//           SEEK_SET);
-//
-//     while(pos < output_file_len)
-//     {
-//         if(tng_block_header_read(tng_data, block) != TNG_SUCCESS)
-//         {
-//             fprintf(stderr, "TNG library: Cannot read block header at pos %" PRId64 ". %s: %d\n", pos,
-//                    __FILE__, __LINE__);
-//             tng_data->input_file = temp;
-//             tng_block_destroy(&block);
-//             return(TNG_CRITICAL);
-//         }
-//         pos += block->header_contents_size + block->block_contents_size;
-//         fseeko(tng_data->output_file, pos, SEEK_SET);
-//     }
-//
-//     return(TNG_SUCCESS);
-// }
-*/
-/**
- * @brief Finish writing the current frame set. Update the number of frames
- * and the hashes of the frame set and all its data blocks (if hash_mode
- * == TNG_USE_HASH).
- * @param tng_data is a trajectory data container.
- * @param hash_mode specifies whether to update the block md5 hash when
- * updating the pointers.
- * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
- * error has occured.
- */
-static tng_function_status tng_frame_set_finalize(struct tng_trajectory* tng_data, const char hash_mode)
+tng_function_status DECLSPECDLLEXPORT tng_molecule_find(struct tng_trajectory* tng_data,
+                                                        const char*            name,
+                                                        const int64_t          nr,
+                                                        tng_molecule_t*        molecule)
 {
-    tng_gen_block_t            block;
-    tng_trajectory_frame_set_t frame_set;
-    FILE*                      temp = tng_data->input_file;
-    int64_t                    pos, curr_file_pos;
-
-    frame_set = &tng_data->current_trajectory_frame_set;
+    int64_t i, n_molecules;
 
-    if (frame_set->n_written_frames == frame_set->n_frames)
-    {
-        return (TNG_SUCCESS);
-    }
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(name, "TNG library: name must not be a NULL pointer.");
+    TNG_ASSERT(molecule, "TNG library: molecule must not be a NULL pointer.");
 
-    frame_set->n_written_frames = frame_set->n_frames;
+    n_molecules = tng_data->n_molecules;
 
-    if (tng_output_file_init(tng_data) != TNG_SUCCESS)
+    for (i = n_molecules - 1; i >= 0; i--)
     {
-        fprintf(stderr, "TNG library: Cannot initialise destination file. %s: %d\n", __FILE__, __LINE__);
-        return (TNG_CRITICAL);
+        *molecule = &tng_data->molecules[i];
+        if (name[0] == 0 || strcmp(name, (*molecule)->name) == 0)
+        {
+            if (nr == -1 || nr == (*molecule)->id)
+            {
+                return (TNG_SUCCESS);
+            }
+        }
     }
 
-    tng_block_init(&block);
-    /*     output_file_pos = ftello(tng_data->output_file); */
+    *molecule = 0;
 
-    tng_data->input_file = tng_data->output_file;
+    return (TNG_FAILURE);
+}
 
-    curr_file_pos = ftello(tng_data->output_file);
+tng_function_status DECLSPECDLLEXPORT tng_molecule_of_index_get(struct tng_trajectory* tng_data,
+                                                                const int64_t          index,
+                                                                tng_molecule_t*        molecule)
+{
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(molecule, "TNG library: molecule must not be a NULL pointer.");
 
-    pos = tng_data->current_trajectory_frame_set_output_file_pos;
+    if (index >= tng_data->n_molecules)
+    {
+        *molecule = 0;
+        return (TNG_FAILURE);
+    }
+    *molecule = &tng_data->molecules[index];
+    return (TNG_SUCCESS);
+}
 
-    fseeko(tng_data->output_file, pos, SEEK_SET);
+tng_function_status DECLSPECDLLEXPORT tng_molecule_system_copy(struct tng_trajectory* tng_data_src,
+                                                               struct tng_trajectory* tng_data_dest)
+{
+    tng_molecule_t      molecule, molecule_temp;
+    tng_chain_t         chain, chain_temp;
+    tng_residue_t       residue, residue_temp;
+    tng_atom_t          atom, atom_temp;
+    tng_bond_t          bond_temp;
+    tng_function_status stat;
+    int64_t             i, j, k, l, *list_temp;
 
-    if (tng_block_header_read(tng_data, block) != TNG_SUCCESS)
+    TNG_ASSERT(tng_data_src, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(tng_data_dest, "TNG library: Trajectory container not properly setup.");
+
+    for (i = 0; i < tng_data_dest->n_molecules; i++)
     {
-        fprintf(stderr, "TNG library: Cannot read frame set header. %s: %d\n", __FILE__, __LINE__);
-        tng_data->input_file = temp;
-        tng_block_destroy(&block);
-        return (TNG_CRITICAL);
+        molecule = &tng_data_dest->molecules[i];
+        tng_molecule_destroy(tng_data_dest, molecule);
     }
 
-    //     contents_start_pos = ftello(tng_data->output_file);
+    tng_data_dest->n_molecules = 0;
+    tng_data_dest->n_particles = 0;
 
-    fseeko(tng_data->output_file, sizeof(frame_set->first_frame), SEEK_CUR);
-    if (fwrite(&frame_set->n_frames, sizeof(frame_set->n_frames), 1, tng_data->output_file) != 1)
+    tng_data_dest->molecule_index.valid = TNG_FALSE;
+
+    molecule_temp = (tng_molecule_t)realloc(
+            tng_data_dest->molecules, sizeof(struct tng_molecule) * tng_data_src->n_molecules);
+    if (!molecule_temp)
     {
-        tng_data->input_file = temp;
-        tng_block_destroy(&block);
+        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+        free(tng_data_dest->molecules);
+        tng_data_dest->molecules = 0;
         return (TNG_CRITICAL);
     }
-
-    if (hash_mode == TNG_USE_HASH)
+    list_temp = (int64_t*)realloc(tng_data_dest->molecule_cnt_list,
+                                  sizeof(int64_t) * tng_data_src->n_molecules);
+    if (!list_temp)
     {
-        tng_md5_hash_update(tng_data, block, pos, pos + block->header_contents_size);
+        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+        free(tng_data_dest->molecule_cnt_list);
+        tng_data_dest->molecule_cnt_list = 0;
+        free(molecule_temp);
+        return (TNG_CRITICAL);
     }
 
-    fseeko(tng_data->output_file, curr_file_pos, SEEK_SET);
+    tng_data_dest->molecules         = molecule_temp;
+    tng_data_dest->molecule_cnt_list = list_temp;
 
-    tng_data->input_file = temp;
-    tng_block_destroy(&block);
+    for (i = 0; i < tng_data_src->n_molecules; i++)
+    {
+        molecule = &tng_data_src->molecules[i];
+        stat = tng_molecule_w_id_add(tng_data_dest, molecule->name, molecule->id, &molecule_temp);
+        if (stat != TNG_SUCCESS)
+        {
+            fprintf(stderr, "TNG library: Cannot create new molecule to make a copy. %s: %d\n",
+                    __FILE__, __LINE__);
+            return (stat);
+        }
+        molecule_temp->quaternary_str = molecule->quaternary_str;
+        for (j = 0; j < molecule->n_chains; j++)
+        {
+            chain = &molecule->chains[j];
+            stat = tng_molecule_chain_w_id_add(tng_data_dest, molecule_temp, chain->name, chain->id,
+                                               &chain_temp);
+            if (stat != TNG_SUCCESS)
+            {
+                fprintf(stderr, "TNG library: Cannot create new chain to make a copy. %s: %d\n",
+                        __FILE__, __LINE__);
+                return (stat);
+            }
+            for (k = 0; k < chain->n_residues; k++)
+            {
+                residue = &chain->residues[k];
+                stat    = tng_chain_residue_w_id_add(tng_data_dest, chain_temp, residue->name,
+                                                  residue->id, &residue_temp);
+                if (stat != TNG_SUCCESS)
+                {
+                    fprintf(stderr,
+                            "TNG library: Cannot create new residue to make a copy. %s: %d\n",
+                            __FILE__, __LINE__);
+                    return (stat);
+                }
+                for (l = 0; l < residue->n_atoms; l++)
+                {
+                    atom = &molecule->atoms[residue->atoms_offset + l];
+                    stat = tng_residue_atom_w_id_add(tng_data_dest, residue_temp, atom->name,
+                                                     atom->atom_type, atom->id, &atom_temp);
+                    if (stat != TNG_SUCCESS)
+                    {
+                        fprintf(stderr,
+                                "TNG library: Cannot create new atom to make a copy. %s: %d\n",
+                                __FILE__, __LINE__);
+                        return (stat);
+                    }
+                }
+            }
+        }
+        molecule_temp->n_bonds = molecule->n_bonds;
+        if (molecule->n_bonds > 0)
+        {
+            bond_temp = (tng_bond_t)realloc(molecule_temp->bonds,
+                                            sizeof(struct tng_bond) * molecule->n_bonds);
+            if (!bond_temp)
+            {
+                fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+                free(molecule_temp->bonds);
+                molecule_temp->n_bonds = 0;
+                return (TNG_CRITICAL);
+            }
+            molecule_temp->bonds = bond_temp;
+            for (j = 0; j < molecule->n_bonds; j++)
+            {
+                molecule_temp->bonds[j] = molecule->bonds[j];
+            }
+        }
+        stat = tng_molecule_cnt_set(tng_data_dest, molecule_temp, tng_data_src->molecule_cnt_list[i]);
+        if (stat != TNG_SUCCESS)
+        {
+            fprintf(stderr, "TNG library: Cannot set molecule count. %s: %d.\n", __FILE__, __LINE__);
+            return (stat);
+        }
+    }
     return (TNG_SUCCESS);
 }
 
-tng_function_status DECLSPECDLLEXPORT tng_atom_residue_get(struct tng_trajectory* tng_data,
-                                                           struct tng_atom*       atom,
-                                                           tng_residue_t*         residue)
+tng_function_status DECLSPECDLLEXPORT tng_molecule_num_chains_get(struct tng_trajectory* tng_data,
+                                                                  struct tng_molecule*   molecule,
+                                                                  int64_t*               n)
 {
     (void)tng_data;
+    TNG_ASSERT(molecule, "TNG library: molecule must not be NULL");
+    TNG_ASSERT(n, "TNG library: n must not be a NULL pointer");
 
-    TNG_ASSERT(atom, "TNG library: atom must not be NULL");
-
-    *residue = atom->residue;
+    *n = molecule->n_chains;
 
     return (TNG_SUCCESS);
 }
 
-tng_function_status DECLSPECDLLEXPORT tng_atom_name_get(struct tng_trajectory* tng_data,
-                                                        struct tng_atom*       atom,
-                                                        char*                  name,
-                                                        const int              max_len)
+tng_function_status DECLSPECDLLEXPORT tng_molecule_chain_of_index_get(struct tng_trajectory* tng_data,
+                                                                      struct tng_molecule* molecule,
+                                                                      const int64_t        index,
+                                                                      tng_chain_t*         chain)
 {
     (void)tng_data;
-    TNG_ASSERT(atom, "TNG library: atom must not be NULL");
-    TNG_ASSERT(name, "TNG library: name must not be a NULL pointer");
-
-    strncpy(name, atom->name, max_len - 1);
-    name[max_len - 1] = 0;
+    TNG_ASSERT(molecule, "TNG library: molecule must not be a NULL pointer.");
+    TNG_ASSERT(chain, "TNG library: chain must not be a NULL pointer.");
 
-    if (strlen(atom->name) > (unsigned int)max_len - 1)
+    if (index >= molecule->n_chains)
     {
+        *chain = 0;
         return (TNG_FAILURE);
     }
+    *chain = &molecule->chains[index];
     return (TNG_SUCCESS);
 }
 
-tng_function_status DECLSPECDLLEXPORT tng_atom_name_set(struct tng_trajectory* tng_data,
-                                                        struct tng_atom*       atom,
-                                                        const char*            new_name)
+tng_function_status DECLSPECDLLEXPORT tng_molecule_num_residues_get(struct tng_trajectory* tng_data,
+                                                                    struct tng_molecule*   molecule,
+                                                                    int64_t*               n)
 {
-    unsigned int len;
     (void)tng_data;
+    TNG_ASSERT(molecule, "TNG library: molecule must not be NULL");
+    TNG_ASSERT(n, "TNG library: n must not be a NULL pointer");
 
-    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
-    TNG_ASSERT(new_name, "TNG library: new_name must not be a NULL pointer.");
+    *n = molecule->n_residues;
 
-    len = tng_min_size(strlen(new_name) + 1, TNG_MAX_STR_LEN);
+    return (TNG_SUCCESS);
+}
 
-    /* If the currently stored string length is not enough to store the new
-     * string it is freed and reallocated. */
-    if (atom->name && strlen(atom->name) < len)
-    {
-        free(atom->name);
-        atom->name = 0;
-    }
-    if (!atom->name)
+tng_function_status DECLSPECDLLEXPORT tng_molecule_residue_of_index_get(struct tng_trajectory* tng_data,
+                                                                        struct tng_molecule* molecule,
+                                                                        const int64_t        index,
+                                                                        tng_residue_t* residue)
+{
+    (void)tng_data;
+    TNG_ASSERT(molecule, "TNG library: molecule must not be a NULL pointer.");
+    TNG_ASSERT(residue, "TNG library: residue must not be a NULL pointer.");
+
+    if (index >= molecule->n_residues)
     {
-        atom->name = (char*)malloc(len);
-        if (!atom->name)
-        {
-            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
-            return (TNG_CRITICAL);
-        }
+        *residue = 0;
+        return (TNG_FAILURE);
     }
+    *residue = &molecule->residues[index];
+    return (TNG_SUCCESS);
+}
 
-    strncpy(atom->name, new_name, len);
+tng_function_status DECLSPECDLLEXPORT tng_molecule_num_atoms_get(struct tng_trajectory* tng_data,
+                                                                 struct tng_molecule*   molecule,
+                                                                 int64_t*               n)
+{
+    (void)tng_data;
+    TNG_ASSERT(molecule, "TNG library: molecule must not be NULL");
+    TNG_ASSERT(n, "TNG library: n must not be a NULL pointer");
+
+    *n = molecule->n_atoms;
 
     return (TNG_SUCCESS);
 }
 
-tng_function_status DECLSPECDLLEXPORT tng_atom_type_get(struct tng_trajectory* tng_data,
-                                                        struct tng_atom*       atom,
-                                                        char*                  type,
-                                                        const int              max_len)
+tng_function_status DECLSPECDLLEXPORT tng_molecule_atom_of_index_get(struct tng_trajectory* tng_data,
+                                                                     struct tng_molecule* molecule,
+                                                                     const int64_t        index,
+                                                                     tng_atom_t*          atom)
 {
     (void)tng_data;
-    TNG_ASSERT(atom, "TNG library: atom must not be NULL");
-    TNG_ASSERT(type, "TNG library: type must not be a NULL pointer");
-
-    strncpy(type, atom->atom_type, max_len - 1);
-    type[max_len - 1] = 0;
+    TNG_ASSERT(molecule, "TNG library: molecule must not be a NULL pointer.");
+    TNG_ASSERT(atom, "TNG library: atom must not be a NULL pointer.");
 
-    if (strlen(atom->atom_type) > (unsigned int)max_len - 1)
+    if (index >= molecule->n_atoms)
     {
+        *atom = 0;
         return (TNG_FAILURE);
     }
+    *atom = &molecule->atoms[index];
     return (TNG_SUCCESS);
 }
 
-tng_function_status DECLSPECDLLEXPORT tng_atom_type_set(struct tng_trajectory* tng_data,
-                                                        struct tng_atom*       atom,
-                                                        const char*            new_type)
+tng_function_status DECLSPECDLLEXPORT tng_molecule_chain_find(struct tng_trajectory* tng_data,
+                                                              struct tng_molecule*   molecule,
+                                                              const char*            name,
+                                                              const int64_t          nr,
+                                                              tng_chain_t*           chain)
 {
-    unsigned int len;
+    int64_t i, n_chains;
     (void)tng_data;
 
     TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
-    TNG_ASSERT(new_type, "TNG library: new_type must not be a NULL pointer.");
+    TNG_ASSERT(name, "TNG library: name must not be a NULL pointer.");
 
-    len = tng_min_size(strlen(new_type) + 1, TNG_MAX_STR_LEN);
+    n_chains = molecule->n_chains;
 
-    /* If the currently stored string length is not enough to store the new
-     * string it is freed and reallocated. */
-    if (atom->atom_type && strlen(atom->atom_type) < len)
-    {
-        free(atom->atom_type);
-        atom->atom_type = 0;
-    }
-    if (!atom->atom_type)
+    for (i = n_chains - 1; i >= 0; i--)
     {
-        atom->atom_type = (char*)malloc(len);
-        if (!atom->atom_type)
+        *chain = &molecule->chains[i];
+        if (name[0] == 0 || strcmp(name, (*chain)->name) == 0)
         {
-            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
-            return (TNG_CRITICAL);
+            if (nr == -1 || nr == (*chain)->id)
+            {
+                return (TNG_SUCCESS);
+            }
         }
     }
 
-    strncpy(atom->atom_type, new_type, len);
+    *chain = 0;
 
-    return (TNG_SUCCESS);
+    return (TNG_FAILURE);
 }
 
-/**
- * @brief Initialise an atom struct
- * @param atom is the atom to initialise.
- * @return TNG_SUCCESS (0) if successful.
- */
-static tng_function_status tng_atom_init(struct tng_atom* atom)
+tng_function_status DECLSPECDLLEXPORT tng_molecule_chain_add(struct tng_trajectory* tng_data,
+                                                             struct tng_molecule*   molecule,
+                                                             const char*            name,
+                                                             tng_chain_t*           chain)
 {
-    atom->name      = 0;
-    atom->atom_type = 0;
+    int64_t id;
 
-    return (TNG_SUCCESS);
-}
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(name, "TNG library: name must not be a NULL pointer.");
 
-/**
- * @brief Free the memory in an atom struct
- * @param atom is the atom to destroy.
- * @return TNG_SUCCESS (0) if successful.
- */
-static tng_function_status tng_atom_destroy(struct tng_atom* atom)
-{
-    if (atom->name)
+    /* Set ID to the ID of the last chain + 1 */
+    if (molecule->n_chains)
     {
-        free(atom->name);
-        atom->name = 0;
+        id = molecule->chains[molecule->n_chains - 1].id + 1;
     }
-    if (atom->atom_type)
+    else
     {
-        free(atom->atom_type);
-        atom->atom_type = 0;
+        id = 1;
     }
 
-    return (TNG_SUCCESS);
+    return (tng_molecule_chain_w_id_add(tng_data, molecule, name, id, chain));
 }
 
-/**
- * @brief Update chain->residue pointers (after new memory for
- * molecule->residues has been allocated).
- * @param tng_data The trajectory container containing the molecule.
- * @param mol The molecule that contains the chains that need to be
- * updated.
- * @returns TNG_SUCCESS (0) if successful.
- */
-static tng_function_status tng_molecule_chains_residue_pointers_update(const struct tng_trajectory* tng_data,
-                                                                       const struct tng_molecule* mol)
+tng_function_status DECLSPECDLLEXPORT tng_molecule_chain_w_id_add(struct tng_trajectory* tng_data,
+                                                                  struct tng_molecule*   molecule,
+                                                                  const char*            name,
+                                                                  const int64_t          id,
+                                                                  tng_chain_t*           chain)
 {
-    tng_chain_t chain;
-    int64_t     i, res_cnt = 0;
-    (void)tng_data;
+    tng_chain_t         new_chains;
+    tng_function_status stat = TNG_SUCCESS;
 
-    for (i = 0; i < mol->n_chains; i++)
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(name, "TNG library: name must not be a NULL pointer.");
+
+    new_chains = (tng_chain_t)realloc(molecule->chains,
+                                      sizeof(struct tng_chain) * (molecule->n_chains + 1));
+
+    if (!new_chains)
     {
-        chain           = &mol->chains[i];
-        chain->residues = mol->residues + res_cnt;
-        res_cnt += chain->n_residues;
+        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+        free(molecule->chains);
+        molecule->chains = 0;
+        return (TNG_CRITICAL);
     }
-    return (TNG_SUCCESS);
+
+    molecule->chains = new_chains;
+
+    *chain         = &new_chains[molecule->n_chains];
+    (*chain)->name = 0;
+
+    tng_chain_name_set(tng_data, *chain, name);
+
+    (*chain)->molecule   = molecule;
+    (*chain)->n_residues = 0;
+
+    molecule->n_chains++;
+
+    (*chain)->id = id;
+
+    return (stat);
 }
 
-/**
- * @brief Update atoms->residue pointers (after new memory for
- * molecule->residues has been allocated).
- * @param tng_data The trajectory container containing the molecule.
- * @param mol The molecule that contains the chains that need to be
- * updated.
- * @returns TNG_SUCCESS (0) if successful.
- */
-static tng_function_status tng_molecule_atoms_residue_pointers_update(const struct tng_trajectory* tng_data,
-                                                                      const struct tng_molecule* mol)
+tng_function_status DECLSPECDLLEXPORT tng_molecule_bond_add(struct tng_trajectory* tng_data,
+                                                            struct tng_molecule*   molecule,
+                                                            const int64_t          from_atom_id,
+                                                            const int64_t          to_atom_id,
+                                                            tng_bond_t*            bond)
 {
-    tng_atom_t    atom;
-    tng_residue_t residue;
-    int64_t       i, j, atom_offset = 0;
+    tng_bond_t new_bonds;
     (void)tng_data;
 
-    for (i = 0; i < mol->n_residues; i++)
+    new_bonds = (tng_bond_t)realloc(molecule->bonds, sizeof(struct tng_bond) * (molecule->n_bonds + 1));
+
+    if (!new_bonds)
     {
-        residue = &mol->residues[i];
-        for (j = 0; j < residue->n_atoms; j++)
-        {
-            atom          = &mol->atoms[j + atom_offset];
-            atom->residue = residue;
-        }
-        atom_offset += residue->n_atoms;
+        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+        *bond = 0;
+        free(molecule->bonds);
+        molecule->bonds = 0;
+        return (TNG_CRITICAL);
     }
-    return (TNG_SUCCESS);
-}
 
-tng_function_status DECLSPECDLLEXPORT tng_version_major(struct tng_trajectory* tng_data, int* version)
-{
-    (void)tng_data;
+    molecule->bonds = new_bonds;
 
-    *version = TNG_VERSION_MAJOR;
+    *bond = &new_bonds[molecule->n_bonds];
+
+    (*bond)->from_atom_id = from_atom_id;
+    (*bond)->to_atom_id   = to_atom_id;
+
+    molecule->n_bonds++;
 
     return (TNG_SUCCESS);
 }
 
-tng_function_status DECLSPECDLLEXPORT tng_version_minor(struct tng_trajectory* tng_data, int* version)
+tng_function_status DECLSPECDLLEXPORT tng_molecule_atom_find(struct tng_trajectory* tng_data,
+                                                             struct tng_molecule*   molecule,
+                                                             const char*            name,
+                                                             const int64_t          id,
+                                                             tng_atom_t*            atom)
 {
+    int64_t i, n_atoms;
     (void)tng_data;
 
-    *version = TNG_VERSION_MINOR;
+    TNG_ASSERT(name, "TNG library: name must not be a NULL pointer.");
 
-    return (TNG_SUCCESS);
-}
+    n_atoms = molecule->n_atoms;
 
-tng_function_status DECLSPECDLLEXPORT tng_version_patchlevel(struct tng_trajectory* tng_data, int* patch_level)
-{
-    (void)tng_data;
+    for (i = n_atoms - 1; i >= 0; i--)
+    {
+        *atom = &molecule->atoms[i];
+        if (name[0] == 0 || strcmp(name, (*atom)->name) == 0)
+        {
+            if (id == -1 || id == (*atom)->id)
+            {
+                return (TNG_SUCCESS);
+            }
+        }
+    }
 
-    *patch_level = TNG_VERSION_PATCHLEVEL;
+    *atom = 0;
 
-    return (TNG_SUCCESS);
+    return (TNG_FAILURE);
 }
 
-tng_function_status DECLSPECDLLEXPORT tng_version(struct tng_trajectory* tng_data, char* version, const int max_len)
+tng_function_status tng_chain_name_get(struct tng_trajectory* tng_data,
+                                       struct tng_chain*      chain,
+                                       char*                  name,
+                                       const int              max_len)
 {
     (void)tng_data;
-    TNG_ASSERT(version, "TNG library: version must not be a NULL pointer");
+    TNG_ASSERT(chain, "TNG library: chain must not be NULL");
+    TNG_ASSERT(name, "TNG library: name must not be a NULL pointer");
 
-    TNG_SNPRINTF(version, max_len, "%s", TNG_VERSION);
+    strncpy(name, chain->name, max_len - 1);
+    name[max_len - 1] = 0;
 
+    if (strlen(chain->name) > (unsigned int)max_len - 1)
+    {
+        return (TNG_FAILURE);
+    }
     return (TNG_SUCCESS);
 }
 
-tng_function_status DECLSPECDLLEXPORT tng_molecule_add(struct tng_trajectory* tng_data,
-                                                       const char*            name,
-                                                       tng_molecule_t*        molecule)
+tng_function_status DECLSPECDLLEXPORT tng_chain_name_set(struct tng_trajectory* tng_data,
+                                                         struct tng_chain*      chain,
+                                                         const char*            new_name)
 {
-    int64_t id;
+    unsigned int len;
+    (void)tng_data;
 
-    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
-    TNG_ASSERT(name, "TNG library: name must not be a NULL pointer.");
+    TNG_ASSERT(new_name, "TNG library: new_name must not be a NULL pointer.");
 
-    /* Set ID to the ID of the last molecule + 1 */
-    if (tng_data->n_molecules)
+    len = tng_min_size(strlen(new_name) + 1, TNG_MAX_STR_LEN);
+
+    /* If the currently stored string length is not enough to store the new
+     * string it is freed and reallocated. */
+    if (chain->name && strlen(chain->name) < len)
     {
-        id = tng_data->molecules[tng_data->n_molecules - 1].id + 1;
+        free(chain->name);
+        chain->name = 0;
     }
-    else
+    if (!chain->name)
     {
-        id = 1;
+        chain->name = (char*)malloc(len);
+        if (!chain->name)
+        {
+            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+            return (TNG_CRITICAL);
+        }
     }
 
-    return (tng_molecule_w_id_add(tng_data, name, id, molecule));
+    strncpy(chain->name, new_name, len);
+
+    return (TNG_SUCCESS);
 }
 
-tng_function_status DECLSPECDLLEXPORT tng_molecule_w_id_add(struct tng_trajectory* tng_data,
-                                                            const char*            name,
-                                                            const int64_t          id,
-                                                            tng_molecule_t*        molecule)
+tng_function_status DECLSPECDLLEXPORT tng_chain_num_residues_get(struct tng_trajectory* tng_data,
+                                                                 struct tng_chain*      chain,
+                                                                 int64_t*               n)
 {
-    tng_molecule_t      new_molecules;
-    int64_t*            new_molecule_cnt_list;
-    tng_function_status stat = TNG_SUCCESS;
-
-    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
-    TNG_ASSERT(name, "TNG library: name must not be a NULL pointer.");
+    (void)tng_data;
+    TNG_ASSERT(chain, "TNG library: chain must not be NULL");
+    TNG_ASSERT(n, "TNG library: n must not be a NULL pointer");
 
-    new_molecules = (tng_molecule_t)realloc(
-            tng_data->molecules, sizeof(struct tng_molecule) * (tng_data->n_molecules + 1));
+    *n = chain->n_residues;
 
-    if (!new_molecules)
-    {
-        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
-        free(tng_data->molecules);
-        tng_data->molecules = 0;
-        return (TNG_CRITICAL);
-    }
+    return (TNG_SUCCESS);
+}
 
-    new_molecule_cnt_list = (int64_t*)realloc(tng_data->molecule_cnt_list,
-                                              sizeof(int64_t) * (tng_data->n_molecules + 1));
+tng_function_status DECLSPECDLLEXPORT tng_chain_residue_of_index_get(struct tng_trajectory* tng_data,
+                                                                     struct tng_chain*      chain,
+                                                                     const int64_t          index,
+                                                                     tng_residue_t*         residue)
+{
+    (void)tng_data;
+    TNG_ASSERT(chain, "TNG library: chain must not be a NULL pointer.");
+    TNG_ASSERT(residue, "TNG library: residue must not be a NULL pointer.");
 
-    if (!new_molecule_cnt_list)
+    if (index >= chain->n_residues)
     {
-        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
-        free(tng_data->molecule_cnt_list);
-        tng_data->molecule_cnt_list = 0;
-        free(new_molecules);
-        return (TNG_CRITICAL);
+        *residue = 0;
+        return (TNG_FAILURE);
     }
+    *residue = &chain->residues[index];
+    return (TNG_SUCCESS);
+}
 
-    tng_data->molecules         = new_molecules;
-    tng_data->molecule_cnt_list = new_molecule_cnt_list;
-
-    *molecule = &new_molecules[tng_data->n_molecules];
+tng_function_status DECLSPECDLLEXPORT tng_chain_residue_find(struct tng_trajectory* tng_data,
+                                                             struct tng_chain*      chain,
+                                                             const char*            name,
+                                                             const int64_t          id,
+                                                             tng_residue_t*         residue)
+{
+    int64_t i, n_residues;
+    (void)tng_data;
 
-    tng_molecule_init(tng_data, *molecule);
-    tng_molecule_name_set(tng_data, *molecule, name);
+    TNG_ASSERT(name, "TNG library: name must not be a NULL pointer.");
 
-    /* FIXME: Should this be a function argument instead? */
-    tng_data->molecule_cnt_list[tng_data->n_molecules] = 0;
+    n_residues = chain->n_residues;
 
-    (*molecule)->id = id;
+    for (i = n_residues - 1; i >= 0; i--)
+    {
+        *residue = &chain->residues[i];
+        if (name[0] == 0 || strcmp(name, (*residue)->name) == 0)
+        {
+            if (id == -1 || id == (*residue)->id)
+            {
+                return (TNG_SUCCESS);
+            }
+        }
+    }
 
-    tng_data->n_molecules++;
+    *residue = 0;
 
-    return (stat);
+    return (TNG_FAILURE);
 }
 
-tng_function_status DECLSPECDLLEXPORT tng_molecule_existing_add(struct tng_trajectory* tng_data,
-                                                                tng_molecule_t*        molecule_p)
+tng_function_status DECLSPECDLLEXPORT tng_chain_residue_add(struct tng_trajectory* tng_data,
+                                                            struct tng_chain*      chain,
+                                                            const char*            name,
+                                                            tng_residue_t*         residue)
 {
-    int64_t *      new_molecule_cnt_list, id;
-    tng_molecule_t new_molecules, molecule;
+    int64_t id;
 
     TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(name, "TNG library: name must not be a NULL pointer.");
 
-    /* Set ID to the ID of the last molecule + 1 */
-    if (tng_data->n_molecules)
+    /* Set ID to the ID of the last residue + 1 */
+    if (chain->n_residues)
     {
-        id = tng_data->molecules[tng_data->n_molecules - 1].id + 1;
+        id = chain->residues[chain->n_residues - 1].id + 1;
     }
     else
     {
-        id = 1;
+        id = 0;
     }
 
-    new_molecules = (tng_molecule_t)realloc(
-            tng_data->molecules, sizeof(struct tng_molecule) * (tng_data->n_molecules + 1));
+    return (tng_chain_residue_w_id_add(tng_data, chain, name, id, residue));
+}
 
-    if (!new_molecules)
+tng_function_status DECLSPECDLLEXPORT tng_chain_residue_w_id_add(struct tng_trajectory* tng_data,
+                                                                 struct tng_chain*      chain,
+                                                                 const char*            name,
+                                                                 const int64_t          id,
+                                                                 tng_residue_t*         residue)
+{
+    int64_t             curr_index;
+    tng_residue_t       new_residues, temp_residue, last_residue;
+    tng_molecule_t      molecule = chain->molecule;
+    tng_function_status stat     = TNG_SUCCESS;
+
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(name, "TNG library: name must not be a NULL pointer.");
+
+    if (chain->n_residues)
     {
-        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
-        free(tng_data->molecules);
-        tng_data->molecules = 0;
-        return (TNG_CRITICAL);
+        curr_index = chain->residues - molecule->residues;
+    }
+    else
+    {
+        curr_index = -1;
     }
 
-    new_molecule_cnt_list = (int64_t*)realloc(tng_data->molecule_cnt_list,
-                                              sizeof(int64_t) * (tng_data->n_molecules + 1));
+    new_residues = (tng_residue_t)realloc(molecule->residues,
+                                          sizeof(struct tng_residue) * (molecule->n_residues + 1));
 
-    if (!new_molecule_cnt_list)
+    if (!new_residues)
     {
         fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
-        free(tng_data->molecule_cnt_list);
-        tng_data->molecule_cnt_list = 0;
-        free(new_molecules);
+        free(molecule->residues);
+        molecule->residues = 0;
         return (TNG_CRITICAL);
     }
 
-    molecule = *molecule_p;
+    molecule->residues = new_residues;
 
-    tng_data->molecules         = new_molecules;
-    tng_data->molecule_cnt_list = new_molecule_cnt_list;
+    if (curr_index != -1)
+    {
+        chain->residues = new_residues + curr_index;
+        if (molecule->n_residues)
+        {
+            last_residue = &new_residues[molecule->n_residues - 1];
 
-    new_molecules[tng_data->n_molecules] = *molecule;
+            temp_residue = chain->residues + (chain->n_residues - 1);
+            /* Make space in list of residues to add the new residues together with the other
+             * residues of this chain */
+            if (temp_residue != last_residue)
+            {
+                ++temp_residue;
+                memmove(temp_residue + 1, temp_residue, last_residue - temp_residue);
+            }
+        }
+    }
+    else
+    {
+        curr_index = molecule->n_residues;
+    }
 
-    tng_data->molecule_cnt_list[tng_data->n_molecules] = 0;
+    *residue = &molecule->residues[curr_index + chain->n_residues];
 
-    free(*molecule_p);
+    tng_molecule_chains_residue_pointers_update(tng_data, molecule);
+    tng_molecule_atoms_residue_pointers_update(tng_data, molecule);
 
-    molecule = &new_molecules[tng_data->n_molecules];
+    (*residue)->name = 0;
+    tng_residue_name_set(tng_data, *residue, name);
 
-    *molecule_p = molecule;
+    (*residue)->chain        = chain;
+    (*residue)->n_atoms      = 0;
+    (*residue)->atoms_offset = 0;
 
-    molecule->id = id;
+    chain->n_residues++;
+    molecule->n_residues++;
+    tng_data->molecule_index.valid = TNG_FALSE;
 
-    tng_data->n_molecules++;
+    (*residue)->id = id;
 
-    return (TNG_SUCCESS);
+    return (stat);
 }
 
-tng_function_status tng_molecule_name_get(struct tng_trajectory* tng_data,
-                                          struct tng_molecule*   molecule,
-                                          char*                  name,
-                                          const int              max_len)
+tng_function_status tng_residue_name_get(struct tng_trajectory* tng_data,
+                                         struct tng_residue*    residue,
+                                         char*                  name,
+                                         const int              max_len)
 {
     (void)tng_data;
-    TNG_ASSERT(molecule, "TNG library: molecule must not be NULL");
+    TNG_ASSERT(residue, "TNG library: residue must not be NULL");
     TNG_ASSERT(name, "TNG library: name must not be a NULL pointer");
 
-    strncpy(name, molecule->name, max_len - 1);
+    strncpy(name, residue->name, max_len - 1);
     name[max_len - 1] = 0;
 
-    if (strlen(molecule->name) > (unsigned int)max_len - 1)
+    if (strlen(residue->name) > (unsigned int)max_len - 1)
     {
         return (TNG_FAILURE);
     }
     return (TNG_SUCCESS);
 }
 
-tng_function_status DECLSPECDLLEXPORT tng_molecule_name_set(struct tng_trajectory* tng_data,
-                                                            struct tng_molecule*   molecule,
-                                                            const char*            new_name)
+tng_function_status DECLSPECDLLEXPORT tng_residue_name_set(struct tng_trajectory* tng_data,
+                                                           struct tng_residue*    residue,
+                                                           const char*            new_name)
 {
     unsigned int len;
     (void)tng_data;
 
     TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
-    TNG_ASSERT(new_name, "TNG library: new_name must not be a NULL pointer.");
+    TNG_ASSERT(new_name, "TNG library: new_name must not be a NULL pointer");
 
     len = tng_min_size(strlen(new_name) + 1, TNG_MAX_STR_LEN);
 
     /* If the currently stored string length is not enough to store the new
      * string it is freed and reallocated. */
-    if (molecule->name && strlen(molecule->name) < len)
+    if (residue->name && strlen(residue->name) < len)
     {
-        free(molecule->name);
-        molecule->name = 0;
+        free(residue->name);
+        residue->name = 0;
     }
-    if (!molecule->name)
+    if (!residue->name)
     {
-        molecule->name = (char*)malloc(len);
-        if (!molecule->name)
+        residue->name = (char*)malloc(len);
+        if (!residue->name)
         {
             fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
             return (TNG_CRITICAL);
         }
     }
 
-    strncpy(molecule->name, new_name, len);
+    strncpy(residue->name, new_name, len);
 
     return (TNG_SUCCESS);
 }
 
-tng_function_status DECLSPECDLLEXPORT tng_molecule_cnt_get(struct tng_trajectory* tng_data,
-                                                           struct tng_molecule*   molecule,
-                                                           int64_t*               cnt)
+tng_function_status DECLSPECDLLEXPORT tng_residue_num_atoms_get(struct tng_trajectory* tng_data,
+                                                                struct tng_residue*    residue,
+                                                                int64_t*               n)
 {
-    int64_t i, index = -1;
+    (void)tng_data;
+    TNG_ASSERT(residue, "TNG library: residue must not be NULL");
+    TNG_ASSERT(n, "TNG library: n must not be a NULL pointer");
 
-    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
-    TNG_ASSERT(cnt, "TNG library: cnt must not be a NULL pointer.");
+    *n = residue->n_atoms;
 
-    for (i = 0; i < tng_data->n_molecules; i++)
+    return (TNG_SUCCESS);
+}
+
+tng_function_status DECLSPECDLLEXPORT tng_residue_atom_of_index_get(struct tng_trajectory* tng_data,
+                                                                    struct tng_residue*    residue,
+                                                                    const int64_t          index,
+                                                                    tng_atom_t*            atom)
+{
+    tng_chain_t    chain;
+    tng_molecule_t molecule;
+
+    (void)tng_data;
+    TNG_ASSERT(residue, "TNG library: residue must not be a NULL pointer.");
+    TNG_ASSERT(atom, "TNG library: atom must not be a NULL pointer.");
+
+    if (index >= residue->n_atoms)
     {
-        if (&tng_data->molecules[i] == molecule)
-        {
-            index = i;
-            break;
-        }
+        *atom = 0;
+        return (TNG_FAILURE);
     }
-    if (index == -1)
+    chain    = residue->chain;
+    molecule = chain->molecule;
+
+    if (index + residue->atoms_offset >= molecule->n_atoms)
     {
+        *atom = 0;
         return (TNG_FAILURE);
     }
-    *cnt = tng_data->molecule_cnt_list[index];
 
+    *atom = &molecule->atoms[residue->atoms_offset + index];
     return (TNG_SUCCESS);
 }
 
-tng_function_status DECLSPECDLLEXPORT tng_molecule_cnt_set(struct tng_trajectory* tng_data,
-                                                           struct tng_molecule*   molecule,
-                                                           const int64_t          cnt)
+tng_function_status DECLSPECDLLEXPORT tng_residue_atom_add(struct tng_trajectory* tng_data,
+                                                           struct tng_residue*    residue,
+                                                           const char*            atom_name,
+                                                           const char*            atom_type,
+                                                           tng_atom_t*            atom)
 {
-    int64_t i, old_cnt, index = -1;
+    int64_t id;
 
     TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(atom_name, "TNG library: atom_name must not be a NULL pointer.");
+    TNG_ASSERT(atom_type, "TNG library: atom_type must not be a NULL pointer.");
 
-    for (i = 0; i < tng_data->n_molecules; i++)
+    /* Set ID to the ID of the last atom + 1 */
+    if (residue->chain->molecule->n_atoms)
     {
-        if (&tng_data->molecules[i] == molecule)
-        {
-            index = i;
-            break;
-        }
+        id = residue->chain->molecule->atoms[residue->chain->molecule->n_atoms - 1].id + 1;
     }
-    if (index == -1)
+    else
     {
-        fprintf(stderr, "TNG library: Could not find molecule in TNG trajectory. %s: %d\n",
-                __FILE__, __LINE__);
-        return (TNG_FAILURE);
+        id = 0;
     }
-    if (tng_data->var_num_atoms_flag == TNG_CONSTANT_N_ATOMS)
+
+    return (tng_residue_atom_w_id_add(tng_data, residue, atom_name, atom_type, id, atom));
+}
+
+tng_function_status DECLSPECDLLEXPORT tng_residue_atom_w_id_add(struct tng_trajectory* tng_data,
+                                                                struct tng_residue*    residue,
+                                                                const char*            atom_name,
+                                                                const char*            atom_type,
+                                                                const int64_t          id,
+                                                                tng_atom_t*            atom)
+{
+    tng_atom_t          new_atoms;
+    tng_molecule_t      molecule = residue->chain->molecule;
+    tng_function_status stat     = TNG_SUCCESS;
+
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(atom_name, "TNG library: atom_name must not be a NULL pointer.");
+    TNG_ASSERT(atom_type, "TNG library: atom_type must not be a NULL pointer.");
+
+    if (!residue->n_atoms)
     {
-        old_cnt                            = tng_data->molecule_cnt_list[index];
-        tng_data->molecule_cnt_list[index] = cnt;
+        residue->atoms_offset = molecule->n_atoms;
+    }
+
+    new_atoms = (tng_atom_t)realloc(molecule->atoms, sizeof(struct tng_atom) * (molecule->n_atoms + 1));
 
-        tng_data->n_particles += (cnt - old_cnt) * tng_data->molecules[index].n_atoms;
-    }
-    else
+    if (!new_atoms)
     {
-        old_cnt = tng_data->current_trajectory_frame_set.molecule_cnt_list[index];
-        tng_data->current_trajectory_frame_set.molecule_cnt_list[index] = cnt;
-
-        tng_data->current_trajectory_frame_set.n_particles +=
-                (cnt - old_cnt) * tng_data->molecules[index].n_atoms;
+        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+        free(molecule->atoms);
+        molecule->atoms = 0;
+        return (TNG_CRITICAL);
     }
 
-    return (TNG_SUCCESS);
-}
+    molecule->atoms = new_atoms;
 
-tng_function_status DECLSPECDLLEXPORT tng_molecule_find(struct tng_trajectory* tng_data,
-                                                        const char*            name,
-                                                        const int64_t          nr,
-                                                        tng_molecule_t*        molecule)
-{
-    int64_t i, n_molecules;
+    *atom = &new_atoms[molecule->n_atoms];
 
-    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
-    TNG_ASSERT(name, "TNG library: name must not be a NULL pointer.");
-    TNG_ASSERT(molecule, "TNG library: molecule must not be a NULL pointer.");
+    tng_atom_init(*atom);
+    tng_atom_name_set(tng_data, *atom, atom_name);
+    tng_atom_type_set(tng_data, *atom, atom_type);
 
-    n_molecules = tng_data->n_molecules;
+    (*atom)->residue = residue;
 
-    for (i = n_molecules - 1; i >= 0; i--)
+    residue->n_atoms++;
+    molecule->n_atoms++;
+    tng_data->molecule_index.valid = TNG_FALSE;
+
+    (*atom)->id = id;
+
+    return (stat);
+}
+
+tng_function_status DECLSPECDLLEXPORT tng_molecule_alloc(struct tng_trajectory* tng_data,
+                                                         tng_molecule_t*        molecule_p)
+{
+    *molecule_p = (tng_molecule_t)malloc(sizeof(struct tng_molecule));
+    if (!*molecule_p)
     {
-        *molecule = &tng_data->molecules[i];
-        if (name[0] == 0 || strcmp(name, (*molecule)->name) == 0)
-        {
-            if (nr == -1 || nr == (*molecule)->id)
-            {
-                return (TNG_SUCCESS);
-            }
-        }
+        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+        return (TNG_CRITICAL);
     }
 
-    *molecule = 0;
+    tng_molecule_init(tng_data, *molecule_p);
 
-    return (TNG_FAILURE);
+    return (TNG_SUCCESS);
 }
 
-tng_function_status DECLSPECDLLEXPORT tng_molecule_of_index_get(struct tng_trajectory* tng_data,
-                                                                const int64_t          index,
-                                                                tng_molecule_t*        molecule)
+tng_function_status DECLSPECDLLEXPORT tng_molecule_free(struct tng_trajectory* tng_data,
+                                                        tng_molecule_t*        molecule_p)
 {
-    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
-    TNG_ASSERT(molecule, "TNG library: molecule must not be a NULL pointer.");
-
-    if (index >= tng_data->n_molecules)
+    if (!*molecule_p)
     {
-        *molecule = 0;
-        return (TNG_FAILURE);
+        return (TNG_SUCCESS);
     }
-    *molecule = &tng_data->molecules[index];
+
+    tng_molecule_destroy(tng_data, *molecule_p);
+
+    free(*molecule_p);
+    *molecule_p = 0;
+
     return (TNG_SUCCESS);
 }
 
-tng_function_status DECLSPECDLLEXPORT tng_molecule_system_copy(struct tng_trajectory* tng_data_src,
-                                                               struct tng_trajectory* tng_data_dest)
+tng_function_status DECLSPECDLLEXPORT tng_molecule_init(struct tng_trajectory* tng_data,
+                                                        struct tng_molecule*   molecule)
 {
-    tng_molecule_t      molecule, molecule_temp;
-    tng_chain_t         chain, chain_temp;
-    tng_residue_t       residue, residue_temp;
-    tng_atom_t          atom, atom_temp;
-    tng_bond_t          bond_temp;
-    tng_function_status stat;
-    int64_t             i, j, k, l, *list_temp;
-
-    TNG_ASSERT(tng_data_src, "TNG library: Trajectory container not properly setup.");
-    TNG_ASSERT(tng_data_dest, "TNG library: Trajectory container not properly setup.");
+    (void)tng_data;
+    molecule->quaternary_str = 1;
+    molecule->name           = 0;
+    molecule->n_chains       = 0;
+    molecule->chains         = 0;
+    molecule->n_residues     = 0;
+    molecule->residues       = 0;
+    molecule->n_atoms        = 0;
+    molecule->atoms          = 0;
+    molecule->n_bonds        = 0;
+    molecule->bonds          = 0;
 
-    for (i = 0; i < tng_data_dest->n_molecules; i++)
-    {
-        molecule = &tng_data_dest->molecules[i];
-        tng_molecule_destroy(tng_data_dest, molecule);
-    }
+    return (TNG_SUCCESS);
+}
 
-    tng_data_dest->n_molecules = 0;
-    tng_data_dest->n_particles = 0;
+tng_function_status DECLSPECDLLEXPORT tng_molecule_destroy(struct tng_trajectory* tng_data,
+                                                           struct tng_molecule*   molecule)
+{
+    int64_t i;
+    (void)tng_data;
 
-    molecule_temp = (tng_molecule_t)realloc(
-            tng_data_dest->molecules, sizeof(struct tng_molecule) * tng_data_src->n_molecules);
-    if (!molecule_temp)
-    {
-        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
-        free(tng_data_dest->molecules);
-        tng_data_dest->molecules = 0;
-        return (TNG_CRITICAL);
-    }
-    list_temp = (int64_t*)realloc(tng_data_dest->molecule_cnt_list,
-                                  sizeof(int64_t) * tng_data_src->n_molecules);
-    if (!list_temp)
+    if (molecule->name)
     {
-        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
-        free(tng_data_dest->molecule_cnt_list);
-        tng_data_dest->molecule_cnt_list = 0;
-        free(molecule_temp);
-        return (TNG_CRITICAL);
+        free(molecule->name);
+        molecule->name = 0;
     }
 
-    tng_data_dest->molecules         = molecule_temp;
-    tng_data_dest->molecule_cnt_list = list_temp;
-
-    for (i = 0; i < tng_data_src->n_molecules; i++)
+    if (molecule->chains)
     {
-        molecule = &tng_data_src->molecules[i];
-        stat = tng_molecule_w_id_add(tng_data_dest, molecule->name, molecule->id, &molecule_temp);
-        if (stat != TNG_SUCCESS)
-        {
-            fprintf(stderr, "TNG library: Cannot create new molecule to make a copy. %s: %d\n",
-                    __FILE__, __LINE__);
-            return (stat);
-        }
-        molecule_temp->quaternary_str = molecule->quaternary_str;
-        for (j = 0; j < molecule->n_chains; j++)
+        for (i = 0; i < molecule->n_chains; i++)
         {
-            chain = &molecule->chains[j];
-            stat = tng_molecule_chain_w_id_add(tng_data_dest, molecule_temp, chain->name, chain->id,
-                                               &chain_temp);
-            if (stat != TNG_SUCCESS)
-            {
-                fprintf(stderr, "TNG library: Cannot create new chain to make a copy. %s: %d\n",
-                        __FILE__, __LINE__);
-                return (stat);
-            }
-            for (k = 0; k < chain->n_residues; k++)
+            if (molecule->chains[i].name)
             {
-                residue = &chain->residues[k];
-                stat    = tng_chain_residue_w_id_add(tng_data_dest, chain_temp, residue->name,
-                                                  residue->id, &residue_temp);
-                if (stat != TNG_SUCCESS)
-                {
-                    fprintf(stderr,
-                            "TNG library: Cannot create new residue to make a copy. %s: %d\n",
-                            __FILE__, __LINE__);
-                    return (stat);
-                }
-                for (l = 0; l < residue->n_atoms; l++)
-                {
-                    atom = &molecule->atoms[residue->atoms_offset + l];
-                    stat = tng_residue_atom_w_id_add(tng_data_dest, residue_temp, atom->name,
-                                                     atom->atom_type, atom->id, &atom_temp);
-                    if (stat != TNG_SUCCESS)
-                    {
-                        fprintf(stderr,
-                                "TNG library: Cannot create new atom to make a copy. %s: %d\n",
-                                __FILE__, __LINE__);
-                        return (stat);
-                    }
-                }
+                free(molecule->chains[i].name);
+                molecule->chains[i].name = 0;
             }
         }
-        molecule_temp->n_bonds = molecule->n_bonds;
-        if (molecule->n_bonds > 0)
+        free(molecule->chains);
+        molecule->chains = 0;
+    }
+    molecule->n_chains = 0;
+
+    if (molecule->residues)
+    {
+        for (i = 0; i < molecule->n_residues; i++)
         {
-            bond_temp = (tng_bond_t)realloc(molecule_temp->bonds,
-                                            sizeof(struct tng_bond) * molecule->n_bonds);
-            if (!bond_temp)
-            {
-                fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
-                free(molecule_temp->bonds);
-                molecule_temp->n_bonds = 0;
-                return (TNG_CRITICAL);
-            }
-            molecule_temp->bonds = bond_temp;
-            for (j = 0; j < molecule->n_bonds; j++)
+            if (molecule->residues[i].name)
             {
-                molecule_temp->bonds[j] = molecule->bonds[j];
+                free(molecule->residues[i].name);
+                molecule->residues[i].name = 0;
             }
         }
-        stat = tng_molecule_cnt_set(tng_data_dest, molecule_temp, tng_data_src->molecule_cnt_list[i]);
-        if (stat != TNG_SUCCESS)
+        free(molecule->residues);
+        molecule->residues = 0;
+    }
+    molecule->n_residues = 0;
+
+    if (molecule->atoms)
+    {
+        for (i = 0; i < molecule->n_atoms; i++)
         {
-            fprintf(stderr, "TNG library: Cannot set molecule count. %s: %d.\n", __FILE__, __LINE__);
-            return (stat);
+            tng_atom_destroy(&molecule->atoms[i]);
         }
+        free(molecule->atoms);
+        molecule->atoms = 0;
     }
-    return (TNG_SUCCESS);
-}
-
-tng_function_status DECLSPECDLLEXPORT tng_molecule_num_chains_get(struct tng_trajectory* tng_data,
-                                                                  struct tng_molecule*   molecule,
-                                                                  int64_t*               n)
-{
-    (void)tng_data;
-    TNG_ASSERT(molecule, "TNG library: molecule must not be NULL");
-    TNG_ASSERT(n, "TNG library: n must not be a NULL pointer");
-
-    *n = molecule->n_chains;
-
-    return (TNG_SUCCESS);
-}
-
-tng_function_status DECLSPECDLLEXPORT tng_molecule_chain_of_index_get(struct tng_trajectory* tng_data,
-                                                                      struct tng_molecule* molecule,
-                                                                      const int64_t        index,
-                                                                      tng_chain_t*         chain)
-{
-    (void)tng_data;
-    TNG_ASSERT(molecule, "TNG library: molecule must not be a NULL pointer.");
-    TNG_ASSERT(chain, "TNG library: chain must not be a NULL pointer.");
+    molecule->n_atoms = 0;
 
-    if (index >= molecule->n_chains)
+    if (molecule->bonds)
     {
-        *chain = 0;
-        return (TNG_FAILURE);
+        free(molecule->bonds);
+        molecule->bonds = 0;
     }
-    *chain = &molecule->chains[index];
+    molecule->n_bonds = 0;
+
     return (TNG_SUCCESS);
 }
 
-tng_function_status DECLSPECDLLEXPORT tng_molecule_num_residues_get(struct tng_trajectory* tng_data,
-                                                                    struct tng_molecule*   molecule,
-                                                                    int64_t*               n)
+/**
+ * @brief Bring the molecule index of a trajectory up to date with its
+ * molecules and molecule counts. When using a variable number of atoms the
+ * molecule counts can differ between frame sets, so the index is rebuilt.
+ * @param tng_data is a trajectory data container.
+ * @return TNG_SUCCESS (0) if successful, TNG_FAILURE (1) if there are no
+ * molecule counts or TNG_CRITICAL (2) if a major error has occured.
+ */
+static tng_function_status tng_molecule_index_update(struct tng_trajectory* tng_data)
 {
-    (void)tng_data;
-    TNG_ASSERT(molecule, "TNG library: molecule must not be NULL");
-    TNG_ASSERT(n, "TNG library: n must not be a NULL pointer");
-
-    *n = molecule->n_residues;
+    struct tng_molecule_index* index             = &tng_data->molecule_index;
+    int64_t*                   molecule_cnt_list = 0;
+    int64_t*                   temp;
+    int64_t                    i;
+    tng_molecule_t             mol;
 
-    return (TNG_SUCCESS);
-}
+    if (index->valid && !tng_data->var_num_atoms_flag)
+    {
+        return (TNG_SUCCESS);
+    }
 
-tng_function_status DECLSPECDLLEXPORT tng_molecule_residue_of_index_get(struct tng_trajectory* tng_data,
-                                                                        struct tng_molecule* molecule,
-                                                                        const int64_t        index,
-                                                                        tng_residue_t* residue)
-{
-    (void)tng_data;
-    TNG_ASSERT(molecule, "TNG library: molecule must not be a NULL pointer.");
-    TNG_ASSERT(residue, "TNG library: residue must not be a NULL pointer.");
+    tng_molecule_cnt_list_get(tng_data, &molecule_cnt_list);
 
-    if (index >= molecule->n_residues)
+    if (!molecule_cnt_list)
     {
-        *residue = 0;
         return (TNG_FAILURE);
     }
-    *residue = &molecule->residues[index];
+
+    if (tng_data->n_molecules > index->n_allocated_molecules)
+    {
+        temp = (int64_t*)realloc(index->first_particles,
+                                 sizeof(int64_t) * (tng_data->n_molecules + 1));
+        if (!temp)
+        {
+            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+            return (TNG_CRITICAL);
+        }
+        index->first_particles = temp;
+        temp = (int64_t*)realloc(index->first_residues,
+                                 sizeof(int64_t) * (tng_data->n_molecules + 1));
+        if (!temp)
+        {
+            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+            return (TNG_CRITICAL);
+        }
+        index->first_residues        = temp;
+        index->n_allocated_molecules = tng_data->n_molecules;
+    }
+
+    index->first_particles[0] = 0;
+    index->first_residues[0]  = 0;
+    for (i = 0; i < tng_data->n_molecules; i++)
+    {
+        mol = &tng_data->molecules[i];
+        index->first_particles[i + 1] =
+                index->first_particles[i] + mol->n_atoms * molecule_cnt_list[i];
+        index->first_residues[i + 1] =
+                index->first_residues[i] + mol->n_residues * molecule_cnt_list[i];
+    }
+    index->n_molecules = tng_data->n_molecules;
+    index->valid       = TNG_TRUE;
+
     return (TNG_SUCCESS);
 }
 
-tng_function_status DECLSPECDLLEXPORT tng_molecule_num_atoms_get(struct tng_trajectory* tng_data,
-                                                                 struct tng_molecule*   molecule,
-                                                                 int64_t*               n)
+/**
+ * @brief Free the memory of the molecule index of a trajectory.
+ * @param tng_data is a trajectory data container.
+ */
+static void tng_molecule_index_destroy(struct tng_trajectory* tng_data)
 {
-    (void)tng_data;
-    TNG_ASSERT(molecule, "TNG library: molecule must not be NULL");
-    TNG_ASSERT(n, "TNG library: n must not be a NULL pointer");
-
-    *n = molecule->n_atoms;
+    struct tng_molecule_index* index = &tng_data->molecule_index;
 
-    return (TNG_SUCCESS);
+    free(index->first_particles);
+    index->first_particles = 0;
+    free(index->first_residues);
+    index->first_residues        = 0;
+    index->n_molecules           = 0;
+    index->n_allocated_molecules = 0;
+    index->valid                 = TNG_FALSE;
 }
 
-tng_function_status DECLSPECDLLEXPORT tng_molecule_atom_of_index_get(struct tng_trajectory* tng_data,
-                                                                     struct tng_molecule* molecule,
-                                                                     const int64_t        index,
-                                                                     tng_atom_t*          atom)
+/**
+ * @brief Find the molecule type of a particle using the molecule index.
+ * @param tng_data is a trajectory data container.
+ * @param nr is the real number of the particle in the molecular system.
+ * @param n_particles is the number of consecutive particles, starting at nr,
+ * that must all be in the molecular system.
+ * @param molecule_nr is set to the number of the molecule type of the particle.
+ * @param offset is set to the number of the particle counted from the first
+ * particle of the molecule type.
+ * @return TNG_SUCCESS (0) if successful, TNG_FAILURE (1) if the particles are
+ * not in the molecular system or TNG_CRITICAL (2) if a major error has
+ * occured.
+ */
+static tng_function_status tng_molecule_of_particle_nr_find(struct tng_trajectory* tng_data,
+                                                            const int64_t          nr,
+                                                            const int64_t          n_particles,
+                                                            int64_t*               molecule_nr,
+                                                            int64_t*               offset)
 {
-    (void)tng_data;
-    TNG_ASSERT(molecule, "TNG library: molecule must not be a NULL pointer.");
-    TNG_ASSERT(atom, "TNG library: atom must not be a NULL pointer.");
+    struct tng_molecule_index* index = &tng_data->molecule_index;
+    tng_function_status        stat;
+    int64_t                    lo, hi, mid;
 
-    if (index >= molecule->n_atoms)
+    stat = tng_molecule_index_update(tng_data);
+    if (stat != TNG_SUCCESS)
+    {
+        return (stat);
+    }
+    if (nr < 0 || n_particles < 0 || nr + n_particles > index->first_particles[index->n_molecules]
+        || nr >= index->first_particles[index->n_molecules])
     {
-        *atom = 0;
         return (TNG_FAILURE);
     }
-    *atom = &molecule->atoms[index];
+
+    /* Find the first molecule type ending after the particle. Molecule types
+     * without particles end where they start and are skipped. */
+    lo = 0;
+    hi = index->n_molecules;
+    while (lo < hi)
+    {
+        mid = lo + (hi - lo) / 2;
+        if (index->first_particles[mid + 1] <= nr)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    *molecule_nr = lo;
+    *offset      = nr - index->first_particles[lo];
+
     return (TNG_SUCCESS);
 }
 
-tng_function_status DECLSPECDLLEXPORT tng_molecule_chain_find(struct tng_trajectory* tng_data,
-                                                              struct tng_molecule*   molecule,
-                                                              const char*            name,
-                                                              const int64_t          nr,
-                                                              tng_chain_t*           chain)
+tng_function_status DECLSPECDLLEXPORT tng_molecule_name_of_particle_nr_get(struct tng_trajectory* tng_data,
+                                                                           const int64_t nr,
+                                                                           char*         name,
+                                                                           const int     max_len)
 {
-    int64_t i, n_chains;
-    (void)tng_data;
+    int64_t             molecule_nr, offset;
+    tng_molecule_t      mol;
+    tng_function_status stat;
 
     TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
     TNG_ASSERT(name, "TNG library: name must not be a NULL pointer.");
 
-    n_chains = molecule->n_chains;
-
-    for (i = n_chains - 1; i >= 0; i--)
+    stat = tng_molecule_of_particle_nr_find(tng_data, nr, 1, &molecule_nr, &offset);
+    if (stat != TNG_SUCCESS)
     {
-        *chain = &molecule->chains[i];
-        if (name[0] == 0 || strcmp(name, (*chain)->name) == 0)
-        {
-            if (nr == -1 || nr == (*chain)->id)
-            {
-                return (TNG_SUCCESS);
-            }
-        }
+        return (stat);
     }
+    mol = &tng_data->molecules[molecule_nr];
 
-    *chain = 0;
+    strncpy(name, mol->name, max_len - 1);
+    name[max_len - 1] = 0;
 
-    return (TNG_FAILURE);
+    if (strlen(mol->name) > (unsigned int)max_len - 1)
+    {
+        return (TNG_FAILURE);
+    }
+    return (TNG_SUCCESS);
 }
 
-tng_function_status DECLSPECDLLEXPORT tng_molecule_chain_add(struct tng_trajectory* tng_data,
-                                                             struct tng_molecule*   molecule,
-                                                             const char*            name,
-                                                             tng_chain_t*           chain)
+tng_function_status DECLSPECDLLEXPORT tng_molecule_id_of_particle_nr_get(struct tng_trajectory* tng_data,
+                                                                         const int64_t          nr,
+                                                                         int64_t*               id)
 {
-    int64_t id;
+    int64_t             molecule_nr, offset;
+    tng_molecule_t      mol;
+    tng_function_status stat;
 
     TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
-    TNG_ASSERT(name, "TNG library: name must not be a NULL pointer.");
+    TNG_ASSERT(id, "TNG library: id must not be a NULL pointer.");
 
-    /* Set ID to the ID of the last chain + 1 */
-    if (molecule->n_chains)
-    {
-        id = molecule->chains[molecule->n_chains - 1].id + 1;
-    }
-    else
+    stat = tng_molecule_of_particle_nr_find(tng_data, nr, 1, &molecule_nr, &offset);
+    if (stat != TNG_SUCCESS)
     {
-        id = 1;
+        return (stat);
     }
+    mol = &tng_data->molecules[molecule_nr];
 
-    return (tng_molecule_chain_w_id_add(tng_data, molecule, name, id, chain));
+    *id = mol->id;
+
+    return (TNG_SUCCESS);
 }
 
-tng_function_status DECLSPECDLLEXPORT tng_molecule_chain_w_id_add(struct tng_trajectory* tng_data,
-                                                                  struct tng_molecule*   molecule,
-                                                                  const char*            name,
-                                                                  const int64_t          id,
-                                                                  tng_chain_t*           chain)
+tng_function_status DECLSPECDLLEXPORT tng_molsystem_bonds_get(struct tng_trajectory* tng_data,
+                                                              int64_t*               n_bonds,
+                                                              int64_t**              from_atoms,
+                                                              int64_t**              to_atoms)
 {
-    tng_chain_t         new_chains;
-    tng_function_status stat = TNG_SUCCESS;
+    int64_t        atom_cnt = 0, cnt, mol_cnt, i, j, k;
+    int64_t        from_atom, to_atom, *molecule_cnt_list = 0;
+    tng_molecule_t mol;
+    tng_bond_t     bond;
 
     TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
-    TNG_ASSERT(name, "TNG library: name must not be a NULL pointer.");
+    TNG_ASSERT(n_bonds, "TNG library: n_bonds must not be a NULL pointer.");
+    TNG_ASSERT(from_atoms, "TNG library: from_atoms must not be a NULL pointer.");
+    TNG_ASSERT(to_atoms, "TNG library: to_atoms must not be a NULL pointer.");
 
-    new_chains = (tng_chain_t)realloc(molecule->chains,
-                                      sizeof(struct tng_chain) * (molecule->n_chains + 1));
+    tng_molecule_cnt_list_get(tng_data, &molecule_cnt_list);
 
-    if (!new_chains)
+    if (!molecule_cnt_list)
     {
-        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
-        free(molecule->chains);
-        molecule->chains = 0;
-        return (TNG_CRITICAL);
+        return (TNG_FAILURE);
     }
 
-    molecule->chains = new_chains;
-
-    *chain         = &new_chains[molecule->n_chains];
-    (*chain)->name = 0;
-
-    tng_chain_name_set(tng_data, *chain, name);
-
-    (*chain)->molecule   = molecule;
-    (*chain)->n_residues = 0;
+    *n_bonds = 0;
+    /* First count the total number of bonds to allocate memory */
+    for (i = 0; i < tng_data->n_molecules; i++)
+    {
+        mol     = &tng_data->molecules[i];
+        mol_cnt = molecule_cnt_list[i];
+        *n_bonds += mol_cnt * mol->n_bonds;
+    }
+    if (*n_bonds == 0)
+    {
+        return (TNG_SUCCESS);
+    }
 
-    molecule->n_chains++;
+    *from_atoms = (int64_t*)malloc(sizeof(int64_t) * (*n_bonds));
+    if (!*from_atoms)
+    {
+        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+        return (TNG_CRITICAL);
+    }
+    *to_atoms = (int64_t*)malloc(sizeof(int64_t) * (*n_bonds));
+    if (!*to_atoms)
+    {
+        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+        free(*from_atoms);
+        *from_atoms = 0;
+        return (TNG_CRITICAL);
+    }
 
-    (*chain)->id = id;
+    cnt = 0;
+    for (i = 0; i < tng_data->n_molecules; i++)
+    {
+        mol     = &tng_data->molecules[i];
+        mol_cnt = molecule_cnt_list[i];
+        for (j = 0; j < mol_cnt; j++)
+        {
+            for (k = 0; k < mol->n_bonds; k++)
+            {
+                bond               = &mol->bonds[k];
+                from_atom          = atom_cnt + bond->from_atom_id;
+                to_atom            = atom_cnt + bond->to_atom_id;
+                (*from_atoms)[cnt] = from_atom;
+                (*to_atoms)[cnt++] = to_atom;
+            }
+            atom_cnt += mol->n_atoms;
+        }
+    }
 
-    return (stat);
+    return (TNG_SUCCESS);
 }
 
-tng_function_status DECLSPECDLLEXPORT tng_molecule_bond_add(struct tng_trajectory* tng_data,
-                                                            struct tng_molecule*   molecule,
-                                                            const int64_t          from_atom_id,
-                                                            const int64_t          to_atom_id,
-                                                            tng_bond_t*            bond)
+tng_function_status DECLSPECDLLEXPORT tng_chain_name_of_particle_nr_get(struct tng_trajectory* tng_data,
+                                                                        const int64_t          nr,
+                                                                        char*                  name,
+                                                                        const int max_len)
 {
-    tng_bond_t new_bonds;
-    (void)tng_data;
+    int64_t             molecule_nr, offset;
+    tng_molecule_t      mol;
+    tng_atom_t          atom;
+    tng_function_status stat;
 
-    new_bonds = (tng_bond_t)realloc(molecule->bonds, sizeof(struct tng_bond) * (molecule->n_bonds + 1));
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(name, "TNG library: name must not be a NULL pointer.");
 
-    if (!new_bonds)
+    stat = tng_molecule_of_particle_nr_find(tng_data, nr, 1, &molecule_nr, &offset);
+    if (stat != TNG_SUCCESS)
     {
-        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
-        *bond = 0;
-        free(molecule->bonds);
-        molecule->bonds = 0;
-        return (TNG_CRITICAL);
+        return (stat);
+    }
+    mol  = &tng_data->molecules[molecule_nr];
+    atom = &mol->atoms[offset % mol->n_atoms];
+    if (!atom->residue || !atom->residue->chain)
+    {
+        return (TNG_FAILURE);
     }
 
-    molecule->bonds = new_bonds;
-
-    *bond = &new_bonds[molecule->n_bonds];
-
-    (*bond)->from_atom_id = from_atom_id;
-    (*bond)->to_atom_id   = to_atom_id;
-
-    molecule->n_bonds++;
+    strncpy(name, atom->residue->chain->name, max_len - 1);
+    name[max_len - 1] = 0;
 
+    if (strlen(atom->residue->chain->name) > (unsigned int)max_len - 1)
+    {
+        return (TNG_FAILURE);
+    }
     return (TNG_SUCCESS);
 }
 
-tng_function_status DECLSPECDLLEXPORT tng_molecule_atom_find(struct tng_trajectory* tng_data,
-                                                             struct tng_molecule*   molecule,
-                                                             const char*            name,
-                                                             const int64_t          id,
-                                                             tng_atom_t*            atom)
+tng_function_status DECLSPECDLLEXPORT tng_residue_name_of_particle_nr_get(struct tng_trajectory* tng_data,
+                                                                          const int64_t          nr,
+                                                                          char*     name,
+                                                                          const int max_len)
 {
-    int64_t i, n_atoms;
-    (void)tng_data;
+    int64_t             molecule_nr, offset;
+    tng_molecule_t      mol;
+    tng_atom_t          atom;
+    tng_function_status stat;
 
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
     TNG_ASSERT(name, "TNG library: name must not be a NULL pointer.");
 
-    n_atoms = molecule->n_atoms;
-
-    for (i = n_atoms - 1; i >= 0; i--)
+    stat = tng_molecule_of_particle_nr_find(tng_data, nr, 1, &molecule_nr, &offset);
+    if (stat != TNG_SUCCESS)
     {
-        *atom = &molecule->atoms[i];
-        if (name[0] == 0 || strcmp(name, (*atom)->name) == 0)
-        {
-            if (id == -1 || id == (*atom)->id)
-            {
-                return (TNG_SUCCESS);
-            }
-        }
+        return (stat);
+    }
+    mol  = &tng_data->molecules[molecule_nr];
+    atom = &mol->atoms[offset % mol->n_atoms];
+    if (!atom->residue)
+    {
+        return (TNG_FAILURE);
     }
 
-    *atom = 0;
+    strncpy(name, atom->residue->name, max_len - 1);
+    name[max_len - 1] = 0;
 
-    return (TNG_FAILURE);
+    if (strlen(atom->residue->name) > (unsigned int)max_len - 1)
+    {
+        return (TNG_FAILURE);
+    }
+    return (TNG_SUCCESS);
 }
 
-tng_function_status tng_chain_name_get(struct tng_trajectory* tng_data,
-                                       struct tng_chain*      chain,
-                                       char*                  name,
-                                       const int              max_len)
+tng_function_status DECLSPECDLLEXPORT tng_residue_id_of_particle_nr_get(struct tng_trajectory* tng_data,
+                                                                        const int64_t          nr,
+                                                                        int64_t*               id)
 {
-    (void)tng_data;
-    TNG_ASSERT(chain, "TNG library: chain must not be NULL");
-    TNG_ASSERT(name, "TNG library: name must not be a NULL pointer");
+    int64_t             molecule_nr, offset;
+    tng_molecule_t      mol;
+    tng_atom_t          atom;
+    tng_function_status stat;
 
-    strncpy(name, chain->name, max_len - 1);
-    name[max_len - 1] = 0;
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(id, "TNG library: id must not be a NULL pointer.");
 
-    if (strlen(chain->name) > (unsigned int)max_len - 1)
+    stat = tng_molecule_of_particle_nr_find(tng_data, nr, 1, &molecule_nr, &offset);
+    if (stat != TNG_SUCCESS)
+    {
+        return (stat);
+    }
+    mol  = &tng_data->molecules[molecule_nr];
+    atom = &mol->atoms[offset % mol->n_atoms];
+    if (!atom->residue)
     {
         return (TNG_FAILURE);
     }
+
+    *id = atom->residue->id;
+
     return (TNG_SUCCESS);
 }
 
-tng_function_status DECLSPECDLLEXPORT tng_chain_name_set(struct tng_trajectory* tng_data,
-                                                         struct tng_chain*      chain,
-                                                         const char*            new_name)
+tng_function_status DECLSPECDLLEXPORT tng_global_residue_id_of_particle_nr_get(struct tng_trajectory* tng_data,
+                                                                               const int64_t nr,
+                                                                               int64_t*      id)
 {
-    unsigned int len;
-    (void)tng_data;
-
-    TNG_ASSERT(new_name, "TNG library: new_name must not be a NULL pointer.");
+    int64_t             molecule_nr, offset;
+    tng_molecule_t      mol;
+    tng_atom_t          atom;
+    tng_function_status stat;
 
-    len = tng_min_size(strlen(new_name) + 1, TNG_MAX_STR_LEN);
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(id, "TNG library: id must not be a NULL pointer.");
 
-    /* If the currently stored string length is not enough to store the new
-     * string it is freed and reallocated. */
-    if (chain->name && strlen(chain->name) < len)
+    stat = tng_molecule_of_particle_nr_find(tng_data, nr, 1, &molecule_nr, &offset);
+    if (stat != TNG_SUCCESS)
     {
-        free(chain->name);
-        chain->name = 0;
+        return (stat);
     }
-    if (!chain->name)
+    mol  = &tng_data->molecules[molecule_nr];
+    atom = &mol->atoms[offset % mol->n_atoms];
+    if (!atom->residue)
     {
-        chain->name = (char*)malloc(len);
-        if (!chain->name)
-        {
-            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
-            return (TNG_CRITICAL);
-        }
+        return (TNG_FAILURE);
     }
 
-    strncpy(chain->name, new_name, len);
+    *id = atom->residue->id + tng_data->molecule_index.first_residues[molecule_nr]
+          + mol->n_residues * (offset / mol->n_atoms);
 
     return (TNG_SUCCESS);
 }
 
-tng_function_status DECLSPECDLLEXPORT tng_chain_num_residues_get(struct tng_trajectory* tng_data,
-                                                                 struct tng_chain*      chain,
-                                                                 int64_t*               n)
+tng_function_status DECLSPECDLLEXPORT tng_atom_name_of_particle_nr_get(struct tng_trajectory* tng_data,
+                                                                       const int64_t          nr,
+                                                                       char*                  name,
+                                                                       const int max_len)
 {
-    (void)tng_data;
-    TNG_ASSERT(chain, "TNG library: chain must not be NULL");
-    TNG_ASSERT(n, "TNG library: n must not be a NULL pointer");
+    int64_t             molecule_nr, offset;
+    tng_molecule_t      mol;
+    tng_atom_t          atom;
+    tng_function_status stat;
 
-    *n = chain->n_residues;
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(name, "TNG library: name must not be a NULL pointer.");
+
+    stat = tng_molecule_of_particle_nr_find(tng_data, nr, 1, &molecule_nr, &offset);
+    if (stat != TNG_SUCCESS)
+    {
+        return (stat);
+    }
+    mol  = &tng_data->molecules[molecule_nr];
+    atom = &mol->atoms[offset % mol->n_atoms];
+
+    strncpy(name, atom->name, max_len - 1);
+    name[max_len - 1] = 0;
 
+    if (strlen(atom->name) > (unsigned int)max_len - 1)
+    {
+        return (TNG_FAILURE);
+    }
     return (TNG_SUCCESS);
 }
 
-tng_function_status DECLSPECDLLEXPORT tng_chain_residue_of_index_get(struct tng_trajectory* tng_data,
-                                                                     struct tng_chain*      chain,
-                                                                     const int64_t          index,
-                                                                     tng_residue_t*         residue)
+tng_function_status tng_atom_type_of_particle_nr_get(struct tng_trajectory* tng_data,
+                                                     const int64_t          nr,
+                                                     char*                  type,
+                                                     const int              max_len)
 {
-    (void)tng_data;
-    TNG_ASSERT(chain, "TNG library: chain must not be a NULL pointer.");
-    TNG_ASSERT(residue, "TNG library: residue must not be a NULL pointer.");
+    int64_t             molecule_nr, offset;
+    tng_molecule_t      mol;
+    tng_atom_t          atom;
+    tng_function_status stat;
 
-    if (index >= chain->n_residues)
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(type, "TNG library: type must not be a NULL pointer.");
+
+    stat = tng_molecule_of_particle_nr_find(tng_data, nr, 1, &molecule_nr, &offset);
+    if (stat != TNG_SUCCESS)
+    {
+        return (stat);
+    }
+    mol  = &tng_data->molecules[molecule_nr];
+    atom = &mol->atoms[offset % mol->n_atoms];
+
+    strncpy(type, atom->atom_type, max_len - 1);
+    type[max_len - 1] = 0;
+
+    if (strlen(atom->atom_type) > (unsigned int)max_len - 1)
     {
-        *residue = 0;
         return (TNG_FAILURE);
     }
-    *residue = &chain->residues[index];
     return (TNG_SUCCESS);
 }
 
-tng_function_status DECLSPECDLLEXPORT tng_chain_residue_find(struct tng_trajectory* tng_data,
-                                                             struct tng_chain*      chain,
-                                                             const char*            name,
-                                                             const int64_t          id,
-                                                             tng_residue_t*         residue)
+tng_function_status DECLSPECDLLEXPORT tng_particle_names_of_particle_range_get(struct tng_trajectory* tng_data,
+                                                                               const int64_t first_nr,
+                                                                               const int64_t n_particles,
+                                                                               const tng_particle_name_type name_type,
+                                                                               char*     names,
+                                                                               const int max_len)
 {
-    int64_t i, n_residues;
-    (void)tng_data;
+    int64_t             i, molecule_nr, offset, *first_particles;
+    tng_molecule_t      mol;
+    tng_atom_t          atom;
+    const char*         src;
+    char*               name;
+    tng_function_status stat = TNG_SUCCESS;
 
-    TNG_ASSERT(name, "TNG library: name must not be a NULL pointer.");
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(names, "TNG library: names must not be a NULL pointer.");
+    TNG_ASSERT(max_len > 0, "TNG library: max_len must be larger than 0.");
 
-    n_residues = chain->n_residues;
+    if (n_particles <= 0)
+    {
+        return (TNG_SUCCESS);
+    }
+    stat = tng_molecule_of_particle_nr_find(tng_data, first_nr, n_particles, &molecule_nr, &offset);
+    if (stat != TNG_SUCCESS)
+    {
+        return (stat);
+    }
+    first_particles = tng_data->molecule_index.first_particles;
 
-    for (i = n_residues - 1; i >= 0; i--)
+    /* Walk through the particles in order, moving on to the next molecule type
+     * with particles at the end of each molecule type. */
+    for (i = 0; i < n_particles; i++)
     {
-        *residue = &chain->residues[i];
-        if (name[0] == 0 || strcmp(name, (*residue)->name) == 0)
+        while (first_particles[molecule_nr] + offset >= first_particles[molecule_nr + 1])
         {
-            if (id == -1 || id == (*residue)->id)
-            {
-                return (TNG_SUCCESS);
-            }
+            molecule_nr++;
+            offset = 0;
         }
-    }
+        mol  = &tng_data->molecules[molecule_nr];
+        atom = &mol->atoms[offset % mol->n_atoms];
+        offset++;
 
-    *residue = 0;
+        switch (name_type)
+        {
+            case TNG_MOLECULE_NAME: src = mol->name; break;
+            case TNG_CHAIN_NAME:
+                src = atom->residue && atom->residue->chain ? atom->residue->chain->name : 0;
+                break;
+            case TNG_RESIDUE_NAME: src = atom->residue ? atom->residue->name : 0; break;
+            case TNG_ATOM_NAME: src = atom->name; break;
+            case TNG_ATOM_TYPE: src = atom->atom_type; break;
+            default: src = 0;
+        }
+        name = names + i * max_len;
+        if (!src)
+        {
+            name[0] = 0;
+            stat    = TNG_FAILURE;
+            continue;
+        }
+        strncpy(name, src, max_len - 1);
+        name[max_len - 1] = 0;
+        if (strlen(src) > (unsigned int)max_len - 1)
+        {
+            stat = TNG_FAILURE;
+        }
+    }
 
-    return (TNG_FAILURE);
+    return (stat);
 }
 
-tng_function_status DECLSPECDLLEXPORT tng_chain_residue_add(struct tng_trajectory* tng_data,
-                                                            struct tng_chain*      chain,
-                                                            const char*            name,
-                                                            tng_residue_t*         residue)
+tng_function_status DECLSPECDLLEXPORT tng_particle_ids_of_particle_range_get(struct tng_trajectory* tng_data,
+                                                                             const int64_t first_nr,
+                                                                             const int64_t n_particles,
+                                                                             const tng_particle_id_type id_type,
+                                                                             int64_t* ids)
 {
-    int64_t id;
+    int64_t             i, molecule_nr, offset, *first_particles, *first_residues;
+    tng_molecule_t      mol;
+    tng_atom_t          atom;
+    tng_function_status stat = TNG_SUCCESS;
 
     TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
-    TNG_ASSERT(name, "TNG library: name must not be a NULL pointer.");
+    TNG_ASSERT(ids, "TNG library: ids must not be a NULL pointer.");
 
-    /* Set ID to the ID of the last residue + 1 */
-    if (chain->n_residues)
+    if (n_particles <= 0)
     {
-        id = chain->residues[chain->n_residues - 1].id + 1;
+        return (TNG_SUCCESS);
     }
-    else
+    stat = tng_molecule_of_particle_nr_find(tng_data, first_nr, n_particles, &molecule_nr, &offset);
+    if (stat != TNG_SUCCESS)
     {
-        id = 0;
+        return (stat);
+    }
+    first_particles = tng_data->molecule_index.first_particles;
+    first_residues  = tng_data->molecule_index.first_residues;
+
+    for (i = 0; i < n_particles; i++)
+    {
+        while (first_particles[molecule_nr] + offset >= first_particles[molecule_nr + 1])
+        {
+            molecule_nr++;
+            offset = 0;
+        }
+        mol  = &tng_data->molecules[molecule_nr];
+        atom = &mol->atoms[offset % mol->n_atoms];
+
+        if (id_type == TNG_MOLECULE_ID)
+        {
+            ids[i] = mol->id;
+        }
+        else if (!atom->residue)
+        {
+            ids[i] = -1;
+            stat   = TNG_FAILURE;
+        }
+        else if (id_type == TNG_RESIDUE_ID)
+        {
+            ids[i] = atom->residue->id;
+        }
+        else
+        {
+            ids[i] = atom->residue->id + first_residues[molecule_nr]
+                     + mol->n_residues * (offset / mol->n_atoms);
+        }
+        offset++;
     }
 
-    return (tng_chain_residue_w_id_add(tng_data, chain, name, id, residue));
+    return (stat);
 }
 
-tng_function_status DECLSPECDLLEXPORT tng_chain_residue_w_id_add(struct tng_trajectory* tng_data,
-                                                                 struct tng_chain*      chain,
-                                                                 const char*            name,
-                                                                 const int64_t          id,
-                                                                 tng_residue_t*         residue)
+tng_function_status DECLSPECDLLEXPORT tng_particle_mapping_add(struct tng_trajectory* tng_data,
+                                                               const int64_t  num_first_particle,
+                                                               const int64_t  n_particles,
+                                                               const int64_t* mapping_table)
 {
-    int64_t             curr_index;
-    tng_residue_t       new_residues, temp_residue, last_residue;
-    tng_molecule_t      molecule = chain->molecule;
-    tng_function_status stat     = TNG_SUCCESS;
+    int64_t                    i;
+    tng_particle_mapping_t     mapping;
+    tng_trajectory_frame_set_t frame_set;
 
     TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
-    TNG_ASSERT(name, "TNG library: name must not be a NULL pointer.");
 
-    if (chain->n_residues)
-    {
-        curr_index = chain->residues - molecule->residues;
-    }
-    else
+    frame_set = &tng_data->current_trajectory_frame_set;
+
+    /* Sanity check of the particle ranges. Split into multiple if
+     * statements for improved readability */
+    for (i = 0; i < frame_set->n_mapping_blocks; i++)
     {
-        curr_index = -1;
+        mapping = &frame_set->mappings[i];
+        if (num_first_particle >= mapping->num_first_particle
+            && num_first_particle < mapping->num_first_particle + mapping->n_particles)
+        {
+            fprintf(stderr, "TNG library: Particle mapping overlap. %s: %d\n", __FILE__, __LINE__);
+            return (TNG_FAILURE);
+        }
+        if (num_first_particle + n_particles > mapping->num_first_particle
+            && num_first_particle + n_particles < mapping->num_first_particle + mapping->n_particles)
+        {
+            fprintf(stderr, "TNG library: Particle mapping overlap. %s: %d\n", __FILE__, __LINE__);
+            return (TNG_FAILURE);
+        }
+        if (mapping->num_first_particle >= num_first_particle
+            && mapping->num_first_particle < num_first_particle + n_particles)
+        {
+            fprintf(stderr, "TNG library: Particle mapping overlap. %s: %d\n", __FILE__, __LINE__);
+            return (TNG_FAILURE);
+        }
+        if (mapping->num_first_particle + mapping->n_particles > num_first_particle
+            && mapping->num_first_particle + mapping->n_particles < num_first_particle + n_particles)
+        {
+            fprintf(stderr, "TNG library: Particle mapping overlap. %s: %d\n", __FILE__, __LINE__);
+            return (TNG_FAILURE);
+        }
     }
 
-    new_residues = (tng_residue_t)realloc(molecule->residues,
-                                          sizeof(struct tng_residue) * (molecule->n_residues + 1));
+    frame_set->n_mapping_blocks++;
 
-    if (!new_residues)
+    mapping = (tng_particle_mapping_t)realloc(
+            frame_set->mappings, sizeof(struct tng_particle_mapping) * frame_set->n_mapping_blocks);
+
+    if (!mapping)
     {
         fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
-        free(molecule->residues);
-        molecule->residues = 0;
+        free(frame_set->mappings);
+        frame_set->mappings = 0;
         return (TNG_CRITICAL);
     }
+    frame_set->mappings = mapping;
 
-    molecule->residues = new_residues;
-
-    if (curr_index != -1)
-    {
-        chain->residues = new_residues + curr_index;
-        if (molecule->n_residues)
-        {
-            last_residue = &new_residues[molecule->n_residues - 1];
+    frame_set->mappings[frame_set->n_mapping_blocks - 1].num_first_particle = num_first_particle;
+    frame_set->mappings[frame_set->n_mapping_blocks - 1].n_particles        = n_particles;
 
-            temp_residue = chain->residues + (chain->n_residues - 1);
-            /* Make space in list of residues to add the new residues together with the other
-             * residues of this chain */
-            if (temp_residue != last_residue)
-            {
-                ++temp_residue;
-                memmove(temp_residue + 1, temp_residue, last_residue - temp_residue);
-            }
-        }
-    }
-    else
+    frame_set->mappings[frame_set->n_mapping_blocks - 1].real_particle_numbers =
+            (int64_t*)malloc(sizeof(int64_t) * n_particles);
+    if (!frame_set->mappings[frame_set->n_mapping_blocks - 1].real_particle_numbers)
     {
-        curr_index = molecule->n_residues;
+        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+        return (TNG_CRITICAL);
     }
 
-    *residue = &molecule->residues[curr_index + chain->n_residues];
-
-    tng_molecule_chains_residue_pointers_update(tng_data, molecule);
-    tng_molecule_atoms_residue_pointers_update(tng_data, molecule);
-
-    (*residue)->name = 0;
-    tng_residue_name_set(tng_data, *residue, name);
-
-    (*residue)->chain        = chain;
-    (*residue)->n_atoms      = 0;
-    (*residue)->atoms_offset = 0;
-
-    chain->n_residues++;
-    molecule->n_residues++;
-
-    (*residue)->id = id;
-
-    return (stat);
-}
-
-tng_function_status tng_residue_name_get(struct tng_trajectory* tng_data,
-                                         struct tng_residue*    residue,
-                                         char*                  name,
-                                         const int              max_len)
-{
-    (void)tng_data;
-    TNG_ASSERT(residue, "TNG library: residue must not be NULL");
-    TNG_ASSERT(name, "TNG library: name must not be a NULL pointer");
-
-    strncpy(name, residue->name, max_len - 1);
-    name[max_len - 1] = 0;
-
-    if (strlen(residue->name) > (unsigned int)max_len - 1)
+    for (i = 0; i < n_particles; i++)
     {
-        return (TNG_FAILURE);
+        frame_set->mappings[frame_set->n_mapping_blocks - 1].real_particle_numbers[i] = mapping_table[i];
     }
-    return (TNG_SUCCESS);
+
+    return (tng_particle_mapping_index_add(frame_set));
 }
 
-tng_function_status DECLSPECDLLEXPORT tng_residue_name_set(struct tng_trajectory* tng_data,
-                                                           struct tng_residue*    residue,
-                                                           const char*            new_name)
+tng_function_status DECLSPECDLLEXPORT tng_frame_set_particle_mapping_free(struct tng_trajectory* tng_data)
 {
-    unsigned int len;
-    (void)tng_data;
+    tng_trajectory_frame_set_t frame_set;
+    tng_particle_mapping_t     mapping;
+    int64_t                    i;
 
     TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
-    TNG_ASSERT(new_name, "TNG library: new_name must not be a NULL pointer");
 
-    len = tng_min_size(strlen(new_name) + 1, TNG_MAX_STR_LEN);
+    frame_set = &tng_data->current_trajectory_frame_set;
 
-    /* If the currently stored string length is not enough to store the new
-     * string it is freed and reallocated. */
-    if (residue->name && strlen(residue->name) < len)
-    {
-        free(residue->name);
-        residue->name = 0;
-    }
-    if (!residue->name)
+    if (frame_set->n_mapping_blocks && frame_set->mappings)
     {
-        residue->name = (char*)malloc(len);
-        if (!residue->name)
+        for (i = 0; i < frame_set->n_mapping_blocks; i++)
         {
-            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
-            return (TNG_CRITICAL);
+            mapping = &frame_set->mappings[i];
+            if (mapping->real_particle_numbers)
+            {
+                free(mapping->real_particle_numbers);
+                mapping->real_particle_numbers = 0;
+            }
         }
+        free(frame_set->mappings);
+        frame_set->mappings         = 0;
+        frame_set->n_mapping_blocks = 0;
     }
-
-    strncpy(residue->name, new_name, len);
-
-    return (TNG_SUCCESS);
-}
-
-tng_function_status DECLSPECDLLEXPORT tng_residue_num_atoms_get(struct tng_trajectory* tng_data,
-                                                                struct tng_residue*    residue,
-                                                                int64_t*               n)
-{
-    (void)tng_data;
-    TNG_ASSERT(residue, "TNG library: residue must not be NULL");
-    TNG_ASSERT(n, "TNG library: n must not be a NULL pointer");
-
-    *n = residue->n_atoms;
+    tng_particle_mapping_index_destroy(&frame_set->mapping_index);
 
     return (TNG_SUCCESS);
 }
 
-tng_function_status DECLSPECDLLEXPORT tng_residue_atom_of_index_get(struct tng_trajectory* tng_data,
-                                                                    struct tng_residue*    residue,
-                                                                    const int64_t          index,
-                                                                    tng_atom_t*            atom)
+tng_function_status DECLSPECDLLEXPORT tng_trajectory_init(tng_trajectory_t* tng_data_p)
 {
-    tng_chain_t    chain;
-    tng_molecule_t molecule;
-
-    (void)tng_data;
-    TNG_ASSERT(residue, "TNG library: residue must not be a NULL pointer.");
-    TNG_ASSERT(atom, "TNG library: atom must not be a NULL pointer.");
+    time_t                     seconds;
+    tng_trajectory_frame_set_t frame_set;
+    tng_trajectory_t           tng_data;
 
-    if (index >= residue->n_atoms)
+    *tng_data_p = (tng_trajectory_t)malloc(sizeof(struct tng_trajectory));
+    if (!*tng_data_p)
     {
-        *atom = 0;
-        return (TNG_FAILURE);
+        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+        return (TNG_CRITICAL);
     }
-    chain    = residue->chain;
-    molecule = chain->molecule;
 
-    if (index + residue->atoms_offset >= molecule->n_atoms)
-    {
-        *atom = 0;
-        return (TNG_FAILURE);
-    }
+    tng_data = *tng_data_p;
 
-    *atom = &molecule->atoms[residue->atoms_offset + index];
-    return (TNG_SUCCESS);
-}
+    frame_set = &tng_data->current_trajectory_frame_set;
 
-tng_function_status DECLSPECDLLEXPORT tng_residue_atom_add(struct tng_trajectory* tng_data,
-                                                           struct tng_residue*    residue,
-                                                           const char*            atom_name,
-                                                           const char*            atom_type,
-                                                           tng_atom_t*            atom)
-{
-    int64_t id;
+    tng_data->input_file_path     = 0;
+    tng_data->input_file          = 0;
+    tng_data->input_file_len      = 0;
+    tng_data->input_file_map_flag = TNG_FALSE;
+    tng_data->input_map           = 0;
+    tng_data->reader              = 0;
+    tng_data->output_file_path    = 0;
+    tng_data->output_file         = 0;
+    tng_data->n_read_threads      = 1;
+    tng_data->n_read_block_ids    = 0;
+    tng_data->read_block_ids      = 0;
+    tng_data->n_write_threads     = 1;
+    tng_data->output_hash_type    = TNG_MD5;
+    tng_data->write_behind_flag   = TNG_FALSE;
+    tng_data->write_behind        = 0;
+
+    tng_data->hash_verifier           = 0;
+    tng_data->hash_mismatch_callback  = 0;
+    tng_data->hash_mismatch_user_data = 0;
+    tng_data->n_hash_mismatches       = 0;
+    tng_data->hash_mismatches         = 0;
+    tng_data->prefetch                = 0;
+    tng_data->frame_set_cache         = 0;
 
-    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
-    TNG_ASSERT(atom_name, "TNG library: atom_name must not be a NULL pointer.");
-    TNG_ASSERT(atom_type, "TNG library: atom_type must not be a NULL pointer.");
+    tng_data->first_program_name  = 0;
+    tng_data->first_user_name     = 0;
+    tng_data->first_computer_name = 0;
+    tng_data->first_pgp_signature = 0;
+    tng_data->last_program_name   = 0;
+    tng_data->last_user_name      = 0;
+    tng_data->last_computer_name  = 0;
+    tng_data->last_pgp_signature  = 0;
+    tng_data->forcefield_name     = 0;
 
-    /* Set ID to the ID of the last atom + 1 */
-    if (residue->chain->molecule->n_atoms)
+    seconds = time(0);
+    if (seconds == -1)
     {
-        id = residue->chain->molecule->atoms[residue->chain->molecule->n_atoms - 1].id + 1;
+        fprintf(stderr, "TNG library: Cannot get time. %s: %d\n", __FILE__, __LINE__);
     }
     else
     {
-        id = 0;
+        tng_data->time = seconds;
     }
 
-    return (tng_residue_atom_w_id_add(tng_data, residue, atom_name, atom_type, id, atom));
-}
+    tng_data->var_num_atoms_flag                           = TNG_CONSTANT_N_ATOMS;
+    tng_data->first_trajectory_frame_set_input_file_pos    = -1;
+    tng_data->last_trajectory_frame_set_input_file_pos     = -1;
+    tng_data->current_trajectory_frame_set_input_file_pos  = -1;
+    tng_data->first_trajectory_frame_set_output_file_pos   = -1;
+    tng_data->last_trajectory_frame_set_output_file_pos    = -1;
+    tng_data->current_trajectory_frame_set_output_file_pos = -1;
+    tng_data->frame_set_n_frames                           = 100;
+    tng_data->n_trajectory_frame_sets                      = 0;
+    tng_data->medium_stride_length                         = 100;
+    tng_data->long_stride_length                           = 10000;
+
+    tng_data->n_input_frame_sets = -1;
+    tng_data->n_input_frames     = -1;
 
-tng_function_status DECLSPECDLLEXPORT tng_residue_atom_w_id_add(struct tng_trajectory* tng_data,
-                                                                struct tng_residue*    residue,
-                                                                const char*            atom_name,
-                                                                const char*            atom_type,
-                                                                const int64_t          id,
-                                                                tng_atom_t*            atom)
-{
-    tng_atom_t          new_atoms;
-    tng_molecule_t      molecule = residue->chain->molecule;
-    tng_function_status stat     = TNG_SUCCESS;
+    tng_data->input_frame_set_index.entries  = 0;
+    tng_data->output_frame_set_index.entries = 0;
+    tng_frame_set_index_clear(&tng_data->input_frame_set_index, TNG_FALSE);
+    tng_frame_set_index_clear(&tng_data->output_frame_set_index, TNG_TRUE);
 
-    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
-    TNG_ASSERT(atom_name, "TNG library: atom_name must not be a NULL pointer.");
-    TNG_ASSERT(atom_type, "TNG library: atom_type must not be a NULL pointer.");
+    tng_data->time_per_frame = -1;
 
-    if (!residue->n_atoms)
-    {
-        residue->atoms_offset = molecule->n_atoms;
-    }
+    tng_data->n_particle_data_blocks = 0;
+    tng_data->n_data_blocks          = 0;
 
-    new_atoms = (tng_atom_t)realloc(molecule->atoms, sizeof(struct tng_atom) * (molecule->n_atoms + 1));
+    tng_data->non_tr_particle_data = 0;
+    tng_data->non_tr_data          = 0;
 
-    if (!new_atoms)
-    {
-        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
-        free(molecule->atoms);
-        molecule->atoms = 0;
-        return (TNG_CRITICAL);
-    }
+    tng_data->non_tr_particle_data_index.n_slots = 0;
+    tng_data->non_tr_particle_data_index.slots   = 0;
+    tng_data->non_tr_data_index.n_slots          = 0;
+    tng_data->non_tr_data_index.slots            = 0;
 
-    molecule->atoms = new_atoms;
+    tng_data->compress_algo_pos         = 0;
+    tng_data->compress_algo_vel         = 0;
+    tng_data->compression_precision     = 1000;
+    tng_data->distance_unit_exponential = -9;
 
-    *atom = &new_atoms[molecule->n_atoms];
+    frame_set->first_frame       = -1;
+    frame_set->n_mapping_blocks  = 0;
+    frame_set->mappings          = 0;
+    frame_set->molecule_cnt_list = 0;
 
-    tng_atom_init(*atom);
-    tng_atom_name_set(tng_data, *atom, atom_name);
-    tng_atom_type_set(tng_data, *atom, atom_type);
+    frame_set->mapping_index.n_ranges         = 0;
+    frame_set->mapping_index.ranges           = 0;
+    frame_set->mapping_index.n_real_particles = 0;
+    frame_set->mapping_index.local_particles  = 0;
 
-    (*atom)->residue = residue;
+    frame_set->n_particle_data_blocks = 0;
+    frame_set->n_data_blocks          = 0;
 
-    residue->n_atoms++;
-    molecule->n_atoms++;
+    frame_set->tr_particle_data = 0;
+    frame_set->tr_data          = 0;
 
-    (*atom)->id = id;
+    frame_set->tr_particle_data_index.n_slots = 0;
+    frame_set->tr_particle_data_index.slots   = 0;
+    frame_set->tr_data_index.n_slots          = 0;
+    frame_set->tr_data_index.slots            = 0;
 
-    return (stat);
-}
+    frame_set->n_written_frames   = 0;
+    frame_set->n_unwritten_frames = 0;
+
+    frame_set->next_frame_set_file_pos               = -1;
+    frame_set->prev_frame_set_file_pos               = -1;
+    frame_set->medium_stride_next_frame_set_file_pos = -1;
+    frame_set->medium_stride_prev_frame_set_file_pos = -1;
+    frame_set->long_stride_next_frame_set_file_pos   = -1;
+    frame_set->long_stride_prev_frame_set_file_pos   = -1;
+
+    frame_set->first_frame_time = -1;
+
+    tng_data->n_molecules       = 0;
+    tng_data->molecules         = 0;
+    tng_data->molecule_cnt_list = 0;
+    tng_data->n_particles       = 0;
+
+    tng_data->molecule_index.valid                 = TNG_FALSE;
+    tng_data->molecule_index.n_molecules           = 0;
+    tng_data->molecule_index.n_allocated_molecules = 0;
+    tng_data->molecule_index.first_particles       = 0;
+    tng_data->molecule_index.first_residues        = 0;
 
-tng_function_status DECLSPECDLLEXPORT tng_molecule_alloc(struct tng_trajectory* tng_data,
-                                                         tng_molecule_t*        molecule_p)
-{
-    *molecule_p = (tng_molecule_t)malloc(sizeof(struct tng_molecule));
-    if (!*molecule_p)
     {
-        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
-        return (TNG_CRITICAL);
+        /* Check the endianness of the computer */
+        static int32_t endianness_32 = 0x01234567;
+        /* 0x01234567 */
+        if (*(const unsigned char*)&endianness_32 == 0x01)
+        {
+            tng_data->endianness_32 = TNG_BIG_ENDIAN_32;
+        }
+
+        /* 0x67452301 */
+        else if (*(const unsigned char*)&endianness_32 == 0x67)
+        {
+            tng_data->endianness_32 = TNG_LITTLE_ENDIAN_32;
+        }
+
+        /* 0x45670123 */
+        else if (*(const unsigned char*)&endianness_32 == 0x45)
+        {
+            tng_data->endianness_32 = TNG_BYTE_PAIR_SWAP_32;
+        }
     }
+    {
+        static int64_t endianness_64 = 0x0123456789ABCDEFLL;
+        /* 0x0123456789ABCDEF */
+        if (*(const unsigned char*)&endianness_64 == 0x01)
+        {
+            tng_data->endianness_64 = TNG_BIG_ENDIAN_64;
+        }
 
-    tng_molecule_init(tng_data, *molecule_p);
+        /* 0xEFCDAB8967452301 */
+        else if (*(const unsigned char*)&endianness_64 == 0xEF)
+        {
+            tng_data->endianness_64 = TNG_LITTLE_ENDIAN_64;
+        }
 
-    return (TNG_SUCCESS);
-}
+        /* 0x89ABCDEF01234567 */
+        else if (*(const unsigned char*)&endianness_64 == 0x89)
+        {
+            tng_data->endianness_64 = TNG_QUAD_SWAP_64;
+        }
 
-tng_function_status DECLSPECDLLEXPORT tng_molecule_free(struct tng_trajectory* tng_data,
-                                                        tng_molecule_t*        molecule_p)
-{
-    if (!*molecule_p)
-    {
-        return (TNG_SUCCESS);
+        /* 0x45670123CDEF89AB */
+        else if (*(const unsigned char*)&endianness_64 == 0x45)
+        {
+            tng_data->endianness_64 = TNG_BYTE_PAIR_SWAP_64;
+        }
+
+        /* 0x23016745AB89EFCD */
+        else if (*(const unsigned char*)&endianness_64 == 0x23)
+        {
+            tng_data->endianness_64 = TNG_BYTE_SWAP_64;
+        }
     }
 
-    tng_molecule_destroy(tng_data, *molecule_p);
+    /* By default do not swap the byte order, i.e. keep the byte order of the
+     * architecture. The input file endianness will be set when reading the
+     * header. The output endianness can be changed - before the file is
+     * written. */
+    tng_data->input_endianness_swap_func_32  = 0;
+    tng_data->input_endianness_swap_func_64  = 0;
+    tng_data->output_endianness_swap_func_32 = 0;
+    tng_data->output_endianness_swap_func_64 = 0;
 
-    free(*molecule_p);
-    *molecule_p = 0;
+    tng_data->current_trajectory_frame_set.next_frame_set_file_pos = -1;
+    tng_data->current_trajectory_frame_set.prev_frame_set_file_pos = -1;
+    tng_data->current_trajectory_frame_set.n_frames                = 0;
 
     return (TNG_SUCCESS);
 }
 
-tng_function_status DECLSPECDLLEXPORT tng_molecule_init(struct tng_trajectory* tng_data,
-                                                        struct tng_molecule*   molecule)
+#ifdef TNG_USE_PTHREADS
+/**
+ * @brief Set up the file pointers of the current frame set, in the same way as
+ * tng_frame_set_new(), without changing the frames already added to it.
+ * @param tng_data is the trajectory writing the frame set.
+ * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
+ * error has occured.
+ */
+static tng_function_status tng_frame_set_file_pointers_prepare(struct tng_trajectory* tng_data)
 {
-    (void)tng_data;
-    molecule->quaternary_str = 1;
-    molecule->name           = 0;
-    molecule->n_chains       = 0;
-    molecule->chains         = 0;
-    molecule->n_residues     = 0;
-    molecule->residues       = 0;
-    molecule->n_atoms        = 0;
-    molecule->atoms          = 0;
-    molecule->n_bonds        = 0;
-    molecule->bonds          = 0;
+    tng_trajectory_frame_set_t frame_set          = &tng_data->current_trajectory_frame_set;
+    int64_t                    n_written_frames   = frame_set->n_written_frames;
+    int64_t                    n_unwritten_frames = frame_set->n_unwritten_frames;
+    double                     first_frame_time   = frame_set->first_frame_time;
+    tng_function_status        stat;
 
-    return (TNG_SUCCESS);
+    stat = tng_frame_set_new(tng_data, frame_set->first_frame, frame_set->n_frames);
+
+    frame_set->n_written_frames   = n_written_frames;
+    frame_set->n_unwritten_frames = n_unwritten_frames;
+    frame_set->first_frame_time   = first_frame_time;
+
+    return (stat);
 }
 
-tng_function_status DECLSPECDLLEXPORT tng_molecule_destroy(struct tng_trajectory* tng_data,
-                                                           struct tng_molecule*   molecule)
+/**
+ * @brief Copy the file pointers of a frame set to another frame set. When
+ * setting up a new frame set, tng_frame_set_new() relies on the file pointers
+ * of the previous frame set still being in the frame set.
+ * @param dest is the frame set to copy the file pointers to.
+ * @param src is the frame set to copy the file pointers from.
+ */
+static void tng_frame_set_file_pointers_copy(struct tng_trajectory_frame_set*       dest,
+                                             const struct tng_trajectory_frame_set* src)
 {
-    int64_t i;
-    (void)tng_data;
+    dest->next_frame_set_file_pos               = src->next_frame_set_file_pos;
+    dest->prev_frame_set_file_pos               = src->prev_frame_set_file_pos;
+    dest->medium_stride_next_frame_set_file_pos = src->medium_stride_next_frame_set_file_pos;
+    dest->medium_stride_prev_frame_set_file_pos = src->medium_stride_prev_frame_set_file_pos;
+    dest->long_stride_next_frame_set_file_pos   = src->long_stride_next_frame_set_file_pos;
+    dest->long_stride_prev_frame_set_file_pos   = src->long_stride_prev_frame_set_file_pos;
+}
 
-    if (molecule->name)
-    {
-        free(molecule->name);
-        molecule->name = 0;
-    }
+/**
+ * @brief Add the data blocks of another frame set that are missing in the
+ * current frame set to it, with the same layout. The values of the added
+ * data blocks are allocated but not set.
+ * @param tng_data is the trajectory of which to add data blocks to the current
+ * frame set.
+ * @param src is the frame set of which to copy the data blocks.
+ * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
+ * error has occured.
+ */
+static tng_function_status tng_frame_set_data_blocks_layout_copy(struct tng_trajectory* tng_data,
+                                                                 const struct tng_trajectory_frame_set* src)
+{
+    tng_trajectory_frame_set_t frame_set = &tng_data->current_trajectory_frame_set;
+    tng_data_t                 data, src_data;
+    int                        i;
 
-    if (molecule->chains)
+    for (i = 0; i < src->n_particle_data_blocks; i++)
     {
-        for (i = 0; i < molecule->n_chains; i++)
+        src_data = &src->tr_particle_data[i];
+        if (tng_particle_data_find(tng_data, src_data->block_id, &data) == TNG_SUCCESS)
         {
-            if (molecule->chains[i].name)
-            {
-                free(molecule->chains[i].name);
-                molecule->chains[i].name = 0;
-            }
+            continue;
         }
-        free(molecule->chains);
-        molecule->chains = 0;
-    }
-    molecule->n_chains = 0;
-
-    if (molecule->residues)
-    {
-        for (i = 0; i < molecule->n_residues; i++)
+        if (tng_particle_data_block_add(tng_data, src_data->block_id, src_data->block_name,
+                                        src_data->datatype, TNG_TRAJECTORY_BLOCK, src_data->n_frames,
+                                        src_data->n_values_per_frame, src_data->stride_length, 0,
+                                        tng_data->n_particles, src_data->codec_id, 0)
+            != TNG_SUCCESS)
         {
-            if (molecule->residues[i].name)
-            {
-                free(molecule->residues[i].name);
-                molecule->residues[i].name = 0;
-            }
+            return (TNG_CRITICAL);
         }
-        free(molecule->residues);
-        molecule->residues = 0;
-    }
-    molecule->n_residues = 0;
-
-    if (molecule->atoms)
-    {
-        for (i = 0; i < molecule->n_atoms; i++)
+        data                         = &frame_set->tr_particle_data[frame_set->n_particle_data_blocks - 1];
+        data->dependency             = src_data->dependency;
+        data->compression_multiplier = src_data->compression_multiplier;
+        if (tng_allocate_particle_data_mem(tng_data, data, src_data->n_frames, src_data->stride_length,
+                                           tng_data->n_particles, src_data->n_values_per_frame)
+            != TNG_SUCCESS)
         {
-            tng_atom_destroy(&molecule->atoms[i]);
+            return (TNG_CRITICAL);
         }
-        free(molecule->atoms);
-        molecule->atoms = 0;
     }
-    molecule->n_atoms = 0;
-
-    if (molecule->bonds)
+    for (i = 0; i < src->n_data_blocks; i++)
     {
-        free(molecule->bonds);
-        molecule->bonds = 0;
+        src_data = &src->tr_data[i];
+        if (tng_data_find(tng_data, src_data->block_id, &data) == TNG_SUCCESS)
+        {
+            continue;
+        }
+        if (tng_data_block_add(tng_data, src_data->block_id, src_data->block_name, src_data->datatype,
+                               TNG_TRAJECTORY_BLOCK, src_data->n_frames, src_data->n_values_per_frame,
+                               src_data->stride_length, src_data->codec_id, 0)
+            != TNG_SUCCESS)
+        {
+            return (TNG_CRITICAL);
+        }
+        data                         = &frame_set->tr_data[frame_set->n_data_blocks - 1];
+        data->dependency             = src_data->dependency;
+        data->compression_multiplier = src_data->compression_multiplier;
+        if (tng_allocate_data_mem(tng_data, data, src_data->n_frames, src_data->stride_length,
+                                  src_data->n_values_per_frame)
+            != TNG_SUCCESS)
+        {
+            return (TNG_CRITICAL);
+        }
     }
-    molecule->n_bonds = 0;
-
-    return (TNG_SUCCESS);
-}
-
-tng_function_status DECLSPECDLLEXPORT tng_molecule_name_of_particle_nr_get(struct tng_trajectory* tng_data,
-                                                                           const int64_t nr,
-                                                                           char*         name,
-                                                                           const int     max_len)
-{
-    int64_t        cnt = 0, i, *molecule_cnt_list = 0;
-    tng_molecule_t mol;
-    tng_bool       found = TNG_FALSE;
 
-    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
-    TNG_ASSERT(name, "TNG library: name must not be a NULL pointer.");
+    return (TNG_SUCCESS);
+}
 
-    tng_molecule_cnt_list_get(tng_data, &molecule_cnt_list);
+/**
+ * @brief The background thread writing the frame sets handed over to it.
+ * @param arg is the struct tng_write_behind of the writing trajectory.
+ * @return 0
+ */
+static void* tng_write_behind_thread(void* arg)
+{
+    struct tng_write_behind* write_behind = (struct tng_write_behind*)arg;
+    tng_function_status      stat;
 
-    if (!molecule_cnt_list)
+    pthread_mutex_lock(&write_behind->mutex);
+    for (;;)
     {
-        return (TNG_FAILURE);
-    }
+        while (!write_behind->busy && !write_behind->quit)
+        {
+            pthread_cond_wait(&write_behind->cond, &write_behind->mutex);
+        }
+        if (!write_behind->busy)
+        {
+            break;
+        }
+        pthread_mutex_unlock(&write_behind->mutex);
 
-    for (i = 0; i < tng_data->n_molecules; i++)
-    {
-        mol = &tng_data->molecules[i];
-        if (cnt + mol->n_atoms * molecule_cnt_list[i] - 1 < nr)
+        stat = TNG_SUCCESS;
+        if (!write_behind->prepared)
         {
-            cnt += mol->n_atoms * molecule_cnt_list[i];
-            continue;
+            stat = tng_frame_set_file_pointers_prepare(write_behind->writer);
         }
-        found = TNG_TRUE;
-        break;
-    }
-    if (!found)
-    {
-        return (TNG_FAILURE);
+        if (stat == TNG_SUCCESS)
+        {
+            stat = tng_frame_set_write(write_behind->writer, TNG_USE_HASH);
+        }
+
+        pthread_mutex_lock(&write_behind->mutex);
+        if (write_behind->stat == TNG_SUCCESS)
+        {
+            write_behind->stat = stat;
+        }
+        write_behind->busy = TNG_FALSE;
+        pthread_cond_broadcast(&write_behind->cond);
     }
+    pthread_mutex_unlock(&write_behind->mutex);
 
-    strncpy(name, mol->name, max_len - 1);
-    name[max_len - 1] = 0;
+    return (0);
+}
 
-    if (strlen(mol->name) > (unsigned int)max_len - 1)
+/**
+ * @brief Destroy the trajectory used for writing in the background, without
+ * closing or freeing what it shares with the writing trajectory.
+ * @param writer_p is a pointer to the trajectory used for writing in the background.
+ */
+static void tng_write_behind_writer_destroy(tng_trajectory_t* writer_p)
+{
+    struct tng_trajectory* writer = *writer_p;
+
+    if (!writer)
     {
-        return (TNG_FAILURE);
+        return;
     }
-    return (TNG_SUCCESS);
-}
 
-tng_function_status DECLSPECDLLEXPORT tng_molecule_id_of_particle_nr_get(struct tng_trajectory* tng_data,
-                                                                         const int64_t          nr,
-                                                                         int64_t*               id)
-{
-    int64_t        cnt = 0, i, *molecule_cnt_list = 0;
-    tng_molecule_t mol;
-    tng_bool       found = TNG_FALSE;
+    writer->output_file         = 0;
+    writer->first_program_name  = 0;
+    writer->last_program_name   = 0;
+    writer->first_user_name     = 0;
+    writer->last_user_name      = 0;
+    writer->first_computer_name = 0;
+    writer->last_computer_name  = 0;
+    writer->first_pgp_signature = 0;
+    writer->last_pgp_signature  = 0;
+    writer->forcefield_name     = 0;
+    writer->molecules           = 0;
+    writer->n_molecules         = 0;
+    writer->molecule_cnt_list   = 0;
 
-    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
-    TNG_ASSERT(id, "TNG library: id must not be a NULL pointer.");
+    tng_trajectory_destroy(writer_p);
+}
 
-    tng_molecule_cnt_list_get(tng_data, &molecule_cnt_list);
+/**
+ * @brief Start the background thread writing the frame sets of a trajectory.
+ * The background thread takes over the output file pointers, the frame set
+ * index and the compression algorithms of the trajectory until
+ * tng_write_behind_finish() is called.
+ * @param tng_data is the writing trajectory. Its current frame set must have been
+ * set up by tng_frame_set_new().
+ * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
+ * error has occured.
+ */
+static tng_function_status tng_write_behind_start(struct tng_trajectory* tng_data)
+{
+    struct tng_write_behind* write_behind;
+    struct tng_trajectory*   writer;
 
-    if (!molecule_cnt_list)
+    write_behind = (struct tng_write_behind*)malloc(sizeof(struct tng_write_behind));
+    if (!write_behind)
     {
-        return (TNG_FAILURE);
+        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+        return (TNG_CRITICAL);
     }
 
-    for (i = 0; i < tng_data->n_molecules; i++)
+    if (tng_trajectory_init_from_src(tng_data, &write_behind->writer) != TNG_SUCCESS)
     {
-        mol = &tng_data->molecules[i];
-        if (cnt + mol->n_atoms * molecule_cnt_list[i] - 1 < nr)
-        {
-            cnt += mol->n_atoms * molecule_cnt_list[i];
-            continue;
-        }
-        found = TNG_TRUE;
-        break;
+        /* A writer that was not fully initialised cannot be destroyed, since its
+         * members may not have been set. */
+        free(write_behind->writer);
+        free(write_behind);
+        return (TNG_CRITICAL);
     }
-    if (!found)
-    {
-        return (TNG_FAILURE);
+    writer = write_behind->writer;
+
+    writer->output_file = tng_data->output_file;
+
+    writer->first_program_name  = tng_data->first_program_name;
+    writer->last_program_name   = tng_data->last_program_name;
+    writer->first_user_name     = tng_data->first_user_name;
+    writer->last_user_name      = tng_data->last_user_name;
+    writer->first_computer_name = tng_data->first_computer_name;
+    writer->last_computer_name  = tng_data->last_computer_name;
+    writer->first_pgp_signature = tng_data->first_pgp_signature;
+    writer->last_pgp_signature  = tng_data->last_pgp_signature;
+    writer->forcefield_name     = tng_data->forcefield_name;
+
+    writer->time                      = tng_data->time;
+    writer->distance_unit_exponential = tng_data->distance_unit_exponential;
+
+    writer->n_molecules       = tng_data->n_molecules;
+    writer->molecules         = tng_data->molecules;
+    writer->molecule_cnt_list = tng_data->molecule_cnt_list;
+
+    writer->compress_algo_pos   = tng_data->compress_algo_pos;
+    writer->compress_algo_vel   = tng_data->compress_algo_vel;
+    tng_data->compress_algo_pos = 0;
+    tng_data->compress_algo_vel = 0;
+
+    writer->output_frame_set_index           = tng_data->output_frame_set_index;
+    tng_data->output_frame_set_index.entries = 0;
+    tng_frame_set_index_clear(&tng_data->output_frame_set_index,
+                              tng_data->output_frame_set_index.valid);
+
+    write_behind->busy     = TNG_FALSE;
+    write_behind->quit     = TNG_FALSE;
+    write_behind->prepared = TNG_FALSE;
+    write_behind->stat     = TNG_SUCCESS;
+
+    pthread_mutex_init(&write_behind->mutex, 0);
+    pthread_cond_init(&write_behind->cond, 0);
+
+    if (pthread_create(&write_behind->thread, 0, tng_write_behind_thread, write_behind) != 0)
+    {
+        fprintf(stderr, "TNG library: Cannot start writing thread. %s: %d\n", __FILE__, __LINE__);
+        tng_data->compress_algo_pos      = writer->compress_algo_pos;
+        tng_data->compress_algo_vel      = writer->compress_algo_vel;
+        writer->compress_algo_pos        = 0;
+        writer->compress_algo_vel        = 0;
+        tng_data->output_frame_set_index = writer->output_frame_set_index;
+        writer->output_frame_set_index.entries = 0;
+        pthread_cond_destroy(&write_behind->cond);
+        pthread_mutex_destroy(&write_behind->mutex);
+        tng_write_behind_writer_destroy(&write_behind->writer);
+        free(write_behind);
+        return (TNG_CRITICAL);
     }
 
-    *id = mol->id;
+    tng_data->write_behind = write_behind;
 
     return (TNG_SUCCESS);
 }
+#endif
 
-tng_function_status DECLSPECDLLEXPORT tng_molsystem_bonds_get(struct tng_trajectory* tng_data,
-                                                              int64_t*               n_bonds,
-                                                              int64_t**              from_atoms,
-                                                              int64_t**              to_atoms)
+/**
+ * @brief Wait until the frame sets handed over to the background thread have
+ * been written and stop the thread. The output file pointers, the frame set
+ * index and the compression algorithms are handed back to the trajectory and
+ * the file pointers of its current frame set are set up, so that the output
+ * file can be used directly again.
+ * @param tng_data is the writing trajectory.
+ * @return TNG_SUCCESS (0) if successful, otherwise the status of the first
+ * frame set that could not be written.
+ */
+static tng_function_status tng_write_behind_finish(struct tng_trajectory* tng_data)
 {
-    int64_t        atom_cnt = 0, cnt, mol_cnt, i, j, k;
-    int64_t        from_atom, to_atom, *molecule_cnt_list = 0;
-    tng_molecule_t mol;
-    tng_bond_t     bond;
-
-    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
-    TNG_ASSERT(n_bonds, "TNG library: n_bonds must not be a NULL pointer.");
-    TNG_ASSERT(from_atoms, "TNG library: from_atoms must not be a NULL pointer.");
-    TNG_ASSERT(to_atoms, "TNG library: to_atoms must not be a NULL pointer.");
-
-    tng_molecule_cnt_list_get(tng_data, &molecule_cnt_list);
-
-    if (!molecule_cnt_list)
-    {
-        return (TNG_FAILURE);
-    }
+#ifdef TNG_USE_PTHREADS
+    struct tng_write_behind* write_behind = tng_data->write_behind;
+    struct tng_trajectory*   writer;
+    tng_function_status      stat;
 
-    *n_bonds = 0;
-    /* First count the total number of bonds to allocate memory */
-    for (i = 0; i < tng_data->n_molecules; i++)
-    {
-        mol     = &tng_data->molecules[i];
-        mol_cnt = molecule_cnt_list[i];
-        *n_bonds += mol_cnt * mol->n_bonds;
-    }
-    if (*n_bonds == 0)
+    if (!write_behind)
     {
         return (TNG_SUCCESS);
     }
 
-    *from_atoms = (int64_t*)malloc(sizeof(int64_t) * (*n_bonds));
-    if (!*from_atoms)
-    {
-        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
-        return (TNG_CRITICAL);
-    }
-    *to_atoms = (int64_t*)malloc(sizeof(int64_t) * (*n_bonds));
-    if (!*to_atoms)
+    pthread_mutex_lock(&write_behind->mutex);
+    write_behind->quit = TNG_TRUE;
+    pthread_cond_broadcast(&write_behind->cond);
+    pthread_mutex_unlock(&write_behind->mutex);
+
+    pthread_join(write_behind->thread, 0);
+    pthread_cond_destroy(&write_behind->cond);
+    pthread_mutex_destroy(&write_behind->mutex);
+
+    writer = write_behind->writer;
+    stat   = write_behind->stat;
+
+    tng_data->first_trajectory_frame_set_output_file_pos = writer->first_trajectory_frame_set_output_file_pos;
+    tng_data->last_trajectory_frame_set_output_file_pos = writer->last_trajectory_frame_set_output_file_pos;
+    tng_data->current_trajectory_frame_set_output_file_pos =
+            writer->current_trajectory_frame_set_output_file_pos;
+    tng_data->n_trajectory_frame_sets = writer->n_trajectory_frame_sets;
+    tng_frame_set_file_pointers_copy(&tng_data->current_trajectory_frame_set,
+                                     &writer->current_trajectory_frame_set);
+
+    tng_data->compress_algo_pos = writer->compress_algo_pos;
+    tng_data->compress_algo_vel = writer->compress_algo_vel;
+    writer->compress_algo_pos   = 0;
+    writer->compress_algo_vel   = 0;
+
+    tng_frame_set_index_clear(&tng_data->output_frame_set_index, TNG_FALSE);
+    tng_data->output_frame_set_index       = writer->output_frame_set_index;
+    writer->output_frame_set_index.entries = 0;
+
+    tng_write_behind_writer_destroy(&write_behind->writer);
+    free(write_behind);
+    tng_data->write_behind = 0;
+
+    /* The frame set counts and the index read from the file do not include
+     * the frame sets added to it. */
+    if (tng_data->input_file && tng_data->input_file == tng_data->output_file)
     {
-        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
-        free(*from_atoms);
-        *from_atoms = 0;
-        return (TNG_CRITICAL);
+        tng_data->n_input_frame_sets = -1;
+        tng_data->n_input_frames     = -1;
+        tng_frame_set_index_clear(&tng_data->input_frame_set_index, TNG_FALSE);
+        tng_data->input_frame_set_index.searched = TNG_TRUE;
     }
 
-    cnt = 0;
-    for (i = 0; i < tng_data->n_molecules; i++)
+    if (stat == TNG_SUCCESS)
     {
-        mol     = &tng_data->molecules[i];
-        mol_cnt = molecule_cnt_list[i];
-        for (j = 0; j < mol_cnt; j++)
-        {
-            for (k = 0; k < mol->n_bonds; k++)
-            {
-                bond               = &mol->bonds[k];
-                from_atom          = atom_cnt + bond->from_atom_id;
-                to_atom            = atom_cnt + bond->to_atom_id;
-                (*from_atoms)[cnt] = from_atom;
-                (*to_atoms)[cnt++] = to_atom;
-            }
-            atom_cnt += mol->n_atoms;
-        }
+        stat = tng_frame_set_file_pointers_prepare(tng_data);
     }
 
+    return (stat);
+#else
+    (void)tng_data;
     return (TNG_SUCCESS);
+#endif
 }
 
-tng_function_status DECLSPECDLLEXPORT tng_chain_name_of_particle_nr_get(struct tng_trajectory* tng_data,
-                                                                        const int64_t          nr,
-                                                                        char*                  name,
-                                                                        const int max_len)
+#ifdef TNG_USE_PTHREADS
+/**
+ * @brief Read the contents of a block again and compare their hash to the hash
+ * stored in the block header.
+ * @param file is the file containing the block.
+ * @param check is the block to verify.
+ * @return TNG_SUCCESS (0) if the hashes match or TNG_FAILURE (1) if they do
+ * not or if the block contents cannot be read.
+ */
+static tng_function_status tng_hash_check_run(FILE* file, const struct tng_hash_check* check)
 {
-    int64_t        cnt = 0, i, *molecule_cnt_list = 0;
-    tng_molecule_t mol;
-    tng_atom_t     atom;
-    tng_bool       found = TNG_FALSE;
-
-    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
-    TNG_ASSERT(name, "TNG library: name must not be a NULL pointer.");
+    struct tng_hash_state hash_state;
+    char                  buffer[65536];
+    char                  hash[TNG_MD5_HASH_LEN];
+    int64_t               remaining, len;
 
-    tng_molecule_cnt_list_get(tng_data, &molecule_cnt_list);
-
-    if (!molecule_cnt_list)
+    if (fseeko(file, check->contents_pos, SEEK_SET) != 0)
     {
         return (TNG_FAILURE);
     }
 
-    for (i = 0; i < tng_data->n_molecules; i++)
+    tng_hash_init(&hash_state, check->hash_type);
+    for (remaining = check->contents_size; remaining > 0; remaining -= len)
     {
-        mol = &tng_data->molecules[i];
-        if (cnt + mol->n_atoms * molecule_cnt_list[i] - 1 < nr)
+        len = tng_min_i64(remaining, sizeof(buffer));
+        if (fread(buffer, len, 1, file) != 1)
         {
-            cnt += mol->n_atoms * molecule_cnt_list[i];
-            continue;
+            return (TNG_FAILURE);
         }
-        atom  = &mol->atoms[nr % mol->n_atoms];
-        found = TNG_TRUE;
-        break;
-    }
-    if (!found)
-    {
-        return (TNG_FAILURE);
-    }
-    if (!atom->residue || !atom->residue->chain)
-    {
-        return (TNG_FAILURE);
+        tng_hash_append(&hash_state, buffer, len);
     }
+    tng_hash_finish(&hash_state, hash);
 
-    strncpy(name, atom->residue->chain->name, max_len - 1);
-    name[max_len - 1] = 0;
-
-    if (strlen(atom->residue->chain->name) > (unsigned int)max_len - 1)
-    {
-        return (TNG_FAILURE);
-    }
-    return (TNG_SUCCESS);
+    return (memcmp(hash, check->hash, check->hash_len) == 0 ? TNG_SUCCESS : TNG_FAILURE);
 }
 
-tng_function_status DECLSPECDLLEXPORT tng_residue_name_of_particle_nr_get(struct tng_trajectory* tng_data,
-                                                                          const int64_t          nr,
-                                                                          char*     name,
-                                                                          const int max_len)
+/**
+ * @brief The background thread verifying the hashes of the blocks handed over
+ * to it.
+ * @param arg is the struct tng_hash_verifier of the reading trajectory.
+ * @return 0
+ */
+static void* tng_hash_verifier_thread(void* arg)
 {
-    int64_t        cnt = 0, i, *molecule_cnt_list = 0;
-    tng_molecule_t mol;
-    tng_atom_t     atom;
-    tng_bool       found = TNG_FALSE;
+    struct tng_hash_verifier*  verifier = (struct tng_hash_verifier*)arg;
+    struct tng_trajectory*     tng_data = verifier->tng_data;
+    struct tng_hash_check      check;
+    tng_hash_mismatch_callback callback;
+    void*                      user_data;
+    int64_t*                   temp;
 
-    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
-    TNG_ASSERT(name, "TNG library: name must not be a NULL pointer.");
+    pthread_mutex_lock(&verifier->mutex);
+    for (;;)
+    {
+        while (verifier->next_check == verifier->n_checks && !verifier->quit)
+        {
+            pthread_cond_wait(&verifier->cond, &verifier->mutex);
+        }
+        if (verifier->next_check == verifier->n_checks)
+        {
+            break;
+        }
+        check = verifier->checks[verifier->next_check];
+        pthread_mutex_unlock(&verifier->mutex);
 
-    tng_molecule_cnt_list_get(tng_data, &molecule_cnt_list);
+        if (tng_hash_check_run(verifier->file, &check) != TNG_SUCCESS)
+        {
+            pthread_mutex_lock(&verifier->mutex);
+            temp = (int64_t*)realloc(tng_data->hash_mismatches,
+                                     sizeof(int64_t) * (tng_data->n_hash_mismatches + 1));
+            if (temp)
+            {
+                tng_data->hash_mismatches                              = temp;
+                tng_data->hash_mismatches[tng_data->n_hash_mismatches] = check.header_pos;
+                tng_data->n_hash_mismatches++;
+            }
+            callback  = tng_data->hash_mismatch_callback;
+            user_data = tng_data->hash_mismatch_user_data;
+            pthread_mutex_unlock(&verifier->mutex);
 
-    if (!molecule_cnt_list)
-    {
-        return (TNG_FAILURE);
-    }
+            if (callback)
+            {
+                callback(check.block_id, check.header_pos, user_data);
+            }
+            else
+            {
+                fprintf(stderr,
+                        "TNG library: Contents of block at file position %" PRId64
+                        " corrupt. Hashes do not match. %s: %d\n",
+                        check.header_pos, __FILE__, __LINE__);
+            }
+        }
 
-    for (i = 0; i < tng_data->n_molecules; i++)
-    {
-        mol = &tng_data->molecules[i];
-        if (cnt + mol->n_atoms * molecule_cnt_list[i] - 1 < nr)
+        pthread_mutex_lock(&verifier->mutex);
+        verifier->next_check++;
+        if (verifier->next_check == verifier->n_checks)
         {
-            cnt += mol->n_atoms * molecule_cnt_list[i];
-            continue;
+            verifier->next_check = 0;
+            verifier->n_checks   = 0;
         }
-        atom  = &mol->atoms[nr % mol->n_atoms];
-        found = TNG_TRUE;
-        break;
-    }
-    if (!found)
-    {
-        return (TNG_FAILURE);
-    }
-    if (!atom->residue)
-    {
-        return (TNG_FAILURE);
+        pthread_cond_broadcast(&verifier->cond);
     }
+    pthread_mutex_unlock(&verifier->mutex);
 
-    strncpy(name, atom->residue->name, max_len - 1);
-    name[max_len - 1] = 0;
-
-    if (strlen(atom->residue->name) > (unsigned int)max_len - 1)
-    {
-        return (TNG_FAILURE);
-    }
-    return (TNG_SUCCESS);
+    return (0);
 }
 
-tng_function_status DECLSPECDLLEXPORT tng_residue_id_of_particle_nr_get(struct tng_trajectory* tng_data,
-                                                                        const int64_t          nr,
-                                                                        int64_t*               id)
+/**
+ * @brief Start the background thread verifying the hashes of the blocks read
+ * by a trajectory and its cursors.
+ * @param tng_data is the reading trajectory. Its input file must be set.
+ * @return TNG_SUCCESS (0) if successful, TNG_FAILURE (1) if the input file
+ * cannot be opened again or TNG_CRITICAL (2) if a major error has occured.
+ */
+static tng_function_status tng_hash_verifier_start(struct tng_trajectory* tng_data)
 {
-    int64_t        cnt = 0, i, *molecule_cnt_list = 0;
-    tng_molecule_t mol;
-    tng_atom_t     atom;
-    tng_bool       found = TNG_FALSE;
-
-    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
-    TNG_ASSERT(id, "TNG library: id must not be a NULL pointer.");
+    struct tng_hash_verifier* verifier;
 
-    tng_molecule_cnt_list_get(tng_data, &molecule_cnt_list);
-
-    if (!molecule_cnt_list)
+    if (!tng_data->input_file_path)
     {
         return (TNG_FAILURE);
     }
 
-    for (i = 0; i < tng_data->n_molecules; i++)
+    verifier = (struct tng_hash_verifier*)malloc(sizeof(struct tng_hash_verifier));
+    if (!verifier)
     {
-        mol = &tng_data->molecules[i];
-        if (cnt + mol->n_atoms * molecule_cnt_list[i] - 1 < nr)
-        {
-            cnt += mol->n_atoms * molecule_cnt_list[i];
-            continue;
-        }
-        atom  = &mol->atoms[nr % mol->n_atoms];
-        found = TNG_TRUE;
-        break;
+        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+        return (TNG_CRITICAL);
     }
-    if (!found)
+
+    verifier->file = fopen(tng_data->input_file_path, "rb");
+    if (!verifier->file)
     {
+        fprintf(stderr, "TNG library: Cannot open file %s. %s: %d\n", tng_data->input_file_path,
+                __FILE__, __LINE__);
+        free(verifier);
         return (TNG_FAILURE);
     }
-    if (!atom->residue)
+
+    verifier->tng_data           = tng_data;
+    verifier->checks             = 0;
+    verifier->n_checks           = 0;
+    verifier->n_allocated_checks = 0;
+    verifier->next_check         = 0;
+    verifier->quit               = TNG_FALSE;
+
+    pthread_mutex_init(&verifier->mutex, 0);
+    pthread_cond_init(&verifier->cond, 0);
+
+    if (pthread_create(&verifier->thread, 0, tng_hash_verifier_thread, verifier) != 0)
     {
-        return (TNG_FAILURE);
+        fprintf(stderr, "TNG library: Cannot start hash verification thread. %s: %d\n", __FILE__,
+                __LINE__);
+        pthread_cond_destroy(&verifier->cond);
+        pthread_mutex_destroy(&verifier->mutex);
+        fclose(verifier->file);
+        free(verifier);
+        return (TNG_CRITICAL);
     }
 
-    *id = atom->residue->id;
+    tng_data->hash_verifier = verifier;
 
     return (TNG_SUCCESS);
 }
 
-tng_function_status DECLSPECDLLEXPORT tng_global_residue_id_of_particle_nr_get(struct tng_trajectory* tng_data,
-                                                                               const int64_t nr,
-                                                                               int64_t*      id)
+/**
+ * @brief Hand over the hash verification of a block to the background thread,
+ * if the hashes of the blocks read by the trajectory (or by the reader of a
+ * cursor) are verified in the background.
+ * @param tng_data is a trajectory data container. Its input file must be
+ * positioned at the start of the block contents.
+ * @param block is the block, of which the header has been read.
+ * @return TNG_SUCCESS (0) if the hash will be verified in the background or
+ * if the block has no hash to verify, TNG_FAILURE (1) if the hash must be
+ * verified when reading the block or TNG_CRITICAL (2) if a major error has
+ * occured.
+ */
+static tng_function_status tng_hash_verification_defer(struct tng_trajectory*      tng_data,
+                                                       const struct tng_gen_block* block)
 {
-    int64_t        cnt = 0, i, offset = 0, *molecule_cnt_list = 0;
-    tng_molecule_t mol;
-    tng_atom_t     atom;
-    tng_bool       found = TNG_FALSE;
-
-    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
-    TNG_ASSERT(id, "TNG library: id must not be a NULL pointer.");
-
-    tng_molecule_cnt_list_get(tng_data, &molecule_cnt_list);
+    struct tng_hash_verifier* verifier;
+    struct tng_hash_check*    check;
+    int64_t                   i, n_allocated;
 
-    if (!molecule_cnt_list)
+    verifier = tng_data->reader ? tng_data->reader->hash_verifier : tng_data->hash_verifier;
+    if (!verifier)
     {
         return (TNG_FAILURE);
     }
 
-    for (i = 0; i < tng_data->n_molecules; i++)
+    pthread_mutex_lock(&verifier->mutex);
+    if (verifier->n_checks == verifier->n_allocated_checks)
     {
-        mol = &tng_data->molecules[i];
-        if (cnt + mol->n_atoms * molecule_cnt_list[i] - 1 < nr)
+        n_allocated = verifier->n_allocated_checks * 2 + 16;
+        check       = (struct tng_hash_check*)realloc(verifier->checks,
+                                                      sizeof(struct tng_hash_check) * n_allocated);
+        if (!check)
         {
-            cnt += mol->n_atoms * molecule_cnt_list[i];
-            offset += mol->n_residues * molecule_cnt_list[i];
-            continue;
+            pthread_mutex_unlock(&verifier->mutex);
+            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+            return (TNG_CRITICAL);
         }
-        atom  = &mol->atoms[nr % mol->n_atoms];
-        found = TNG_TRUE;
-        break;
+        verifier->checks             = check;
+        verifier->n_allocated_checks = n_allocated;
     }
-    if (!found)
+    check = &verifier->checks[verifier->n_checks];
+
+    if (block->alt_hash_type == TNG_XXH64 && block->alt_hash_len == TNG_XXH64_HASH_LEN)
     {
-        return (TNG_FAILURE);
+        check->hash_type = TNG_XXH64;
+        check->hash_len  = TNG_XXH64_HASH_LEN;
+        memcpy(check->hash, block->alt_hash, TNG_XXH64_HASH_LEN);
     }
-    if (!atom->residue)
+    else
     {
-        return (TNG_FAILURE);
+        check->hash_type = TNG_MD5;
+        check->hash_len  = TNG_MD5_HASH_LEN;
+        memcpy(check->hash, block->md5_hash, TNG_MD5_HASH_LEN);
+    }
+    /* Empty hashes and hash types that cannot be generated are always accepted. */
+    for (i = 0; i < check->hash_len && check->hash[i] == '\0'; i++) {}
+    if (i == check->hash_len || (block->alt_hash_type != TNG_NO_HASH && check->hash_type != TNG_XXH64))
+    {
+        pthread_mutex_unlock(&verifier->mutex);
+        return (TNG_SUCCESS);
     }
 
-    offset += mol->n_residues * ((nr - cnt) / mol->n_atoms);
-
-    *id = atom->residue->id + offset;
+    check->block_id      = block->id;
+    check->contents_pos  = tng_input_file_tell(tng_data);
+    check->header_pos    = check->contents_pos - block->header_contents_size;
+    check->contents_size = block->block_contents_size;
+    verifier->n_checks++;
+    pthread_cond_broadcast(&verifier->cond);
+    pthread_mutex_unlock(&verifier->mutex);
 
     return (TNG_SUCCESS);
 }
+#endif
 
-tng_function_status DECLSPECDLLEXPORT tng_atom_name_of_particle_nr_get(struct tng_trajectory* tng_data,
-                                                                       const int64_t          nr,
-                                                                       char*                  name,
-                                                                       const int max_len)
+/**
+ * @brief Wait until the hashes of the blocks handed over to the background
+ * thread have been verified.
+ * @param tng_data is the reading trajectory.
+ */
+static void tng_hash_verifier_wait(struct tng_trajectory* tng_data)
 {
-    int64_t        cnt = 0, i, *molecule_cnt_list = 0;
-    tng_molecule_t mol;
-    tng_atom_t     atom;
-    tng_bool       found = TNG_FALSE;
-
-    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
-    TNG_ASSERT(name, "TNG library: name must not be a NULL pointer.");
+#ifdef TNG_USE_PTHREADS
+    struct tng_hash_verifier* verifier = tng_data->hash_verifier;
 
-    tng_molecule_cnt_list_get(tng_data, &molecule_cnt_list);
-
-    if (!molecule_cnt_list)
+    if (!verifier)
     {
-        return (TNG_FAILURE);
+        return;
     }
 
-    for (i = 0; i < tng_data->n_molecules; i++)
+    pthread_mutex_lock(&verifier->mutex);
+    while (verifier->next_check != verifier->n_checks)
     {
-        mol = &tng_data->molecules[i];
-        if (cnt + mol->n_atoms * molecule_cnt_list[i] - 1 < nr)
-        {
-            cnt += mol->n_atoms * molecule_cnt_list[i];
-            continue;
-        }
-        atom  = &mol->atoms[nr % mol->n_atoms];
-        found = TNG_TRUE;
-        break;
+        pthread_cond_wait(&verifier->cond, &verifier->mutex);
     }
-    if (!found)
+    pthread_mutex_unlock(&verifier->mutex);
+#else
+    (void)tng_data;
+#endif
+}
+
+/**
+ * @brief Verify the hashes of the blocks handed over to the background thread
+ * and stop the thread.
+ * @param tng_data is the reading trajectory.
+ */
+static void tng_hash_verifier_finish(struct tng_trajectory* tng_data)
+{
+#ifdef TNG_USE_PTHREADS
+    struct tng_hash_verifier* verifier = tng_data->hash_verifier;
+
+    if (!verifier)
     {
-        return (TNG_FAILURE);
+        return;
     }
 
-    strncpy(name, atom->name, max_len - 1);
-    name[max_len - 1] = 0;
+    pthread_mutex_lock(&verifier->mutex);
+    verifier->quit = TNG_TRUE;
+    pthread_cond_broadcast(&verifier->cond);
+    pthread_mutex_unlock(&verifier->mutex);
 
-    if (strlen(atom->name) > (unsigned int)max_len - 1)
+    pthread_join(verifier->thread, 0);
+    pthread_cond_destroy(&verifier->cond);
+    pthread_mutex_destroy(&verifier->mutex);
+
+    fclose(verifier->file);
+    if (verifier->checks)
     {
-        return (TNG_FAILURE);
+        free(verifier->checks);
     }
-    return (TNG_SUCCESS);
+    free(verifier);
+    tng_data->hash_verifier = 0;
+#else
+    (void)tng_data;
+#endif
 }
 
-tng_function_status tng_atom_type_of_particle_nr_get(struct tng_trajectory* tng_data,
-                                                     const int64_t          nr,
-                                                     char*                  type,
-                                                     const int              max_len)
+#ifdef TNG_USE_PTHREADS
+/**
+ * @brief Tell the operating system that a part of the input file will be read
+ * soon, so that it can be read into the page cache in the background.
+ * @param tng_data is a trajectory data container.
+ * @param pos is the file position of the part.
+ * @param len is the length of the part in bytes.
+ */
+static void tng_input_file_advise(const struct tng_trajectory* tng_data,
+                                  const int64_t                pos,
+                                  int64_t                      len)
 {
-    int64_t        cnt = 0, i, *molecule_cnt_list = 0;
-    tng_molecule_t mol;
-    tng_atom_t     atom;
-    tng_bool       found = TNG_FALSE;
-
-    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
-    TNG_ASSERT(type, "TNG library: type must not be a NULL pointer.");
-
-    tng_molecule_cnt_list_get(tng_data, &molecule_cnt_list);
+#    ifdef TNG_USE_POSIX_IO
+    const struct tng_input_map* map = tng_data->input_map;
+    long                        page_size;
+    int64_t                     start;
 
-    if (!molecule_cnt_list)
+    if (pos <= 0 || len <= 0)
     {
-        return (TNG_FAILURE);
+        return;
     }
-
-    for (i = 0; i < tng_data->n_molecules; i++)
+    if (map && map->data)
     {
-        mol = &tng_data->molecules[i];
-        if (cnt + mol->n_atoms * molecule_cnt_list[i] - 1 < nr)
+        page_size = sysconf(_SC_PAGESIZE);
+        if (page_size <= 0)
         {
-            cnt += mol->n_atoms * molecule_cnt_list[i];
-            continue;
+            return;
+        }
+        start = pos - pos % page_size;
+        len   = tng_min_i64(pos + len, map->len) - start;
+        if (len > 0)
+        {
+            madvise(map->data + start, len, MADV_WILLNEED);
         }
-        atom  = &mol->atoms[nr % mol->n_atoms];
-        found = TNG_TRUE;
-        break;
-    }
-    if (!found)
-    {
-        return (TNG_FAILURE);
     }
-
-    strncpy(type, atom->atom_type, max_len - 1);
-    type[max_len - 1] = 0;
-
-    if (strlen(atom->atom_type) > (unsigned int)max_len - 1)
+#        ifdef POSIX_FADV_WILLNEED
+    else
     {
-        return (TNG_FAILURE);
+        posix_fadvise(map ? map->fd : fileno(tng_data->input_file), pos, len, POSIX_FADV_WILLNEED);
     }
-    return (TNG_SUCCESS);
+#        endif
+#    else
+    (void)tng_data;
+    (void)pos;
+    (void)len;
+#    endif
 }
 
-tng_function_status DECLSPECDLLEXPORT tng_particle_mapping_add(struct tng_trajectory* tng_data,
-                                                               const int64_t  num_first_particle,
-                                                               const int64_t  n_particles,
-                                                               const int64_t* mapping_table)
+/**
+ * @brief The background thread reading frame sets ahead of the reading
+ * trajectory, each into the cursor of a free slot.
+ * @param arg is the struct tng_prefetch of the reading trajectory.
+ * @return 0
+ */
+static void* tng_prefetch_thread(void* arg)
 {
-    int64_t                    i;
-    tng_particle_mapping_t     mapping;
-    tng_trajectory_frame_set_t frame_set;
-
-    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
-
-    frame_set = &tng_data->current_trajectory_frame_set;
+    struct tng_prefetch*      prefetch = (struct tng_prefetch*)arg;
+    struct tng_prefetch_slot* slot;
+    struct tng_trajectory*    cursor;
+    int64_t                   i, file_pos, end_pos, next_file_pos, generation;
+    char                      hash_mode;
+    tng_function_status       stat;
 
-    /* Sanity check of the particle ranges. Split into multiple if
-     * statements for improved readability */
-    for (i = 0; i < frame_set->n_mapping_blocks; i++)
+    pthread_mutex_lock(&prefetch->mutex);
+    for (;;)
     {
-        mapping = &frame_set->mappings[i];
-        if (num_first_particle >= mapping->num_first_particle
-            && num_first_particle < mapping->num_first_particle + mapping->n_particles)
+        while (!prefetch->quit
+               && (prefetch->n_ready == prefetch->n_slots || prefetch->next_file_pos <= 0))
         {
-            fprintf(stderr, "TNG library: Particle mapping overlap. %s: %d\n", __FILE__, __LINE__);
-            return (TNG_FAILURE);
+            pthread_cond_wait(&prefetch->cond, &prefetch->mutex);
         }
-        if (num_first_particle + n_particles >= mapping->num_first_particle
-            && num_first_particle + n_particles < mapping->num_first_particle + mapping->n_particles)
+        if (prefetch->quit)
         {
-            fprintf(stderr, "TNG library: Particle mapping overlap. %s: %d\n", __FILE__, __LINE__);
-            return (TNG_FAILURE);
+            break;
         }
-        if (mapping->num_first_particle >= num_first_particle
-            && mapping->num_first_particle < num_first_particle + n_particles)
+        i          = (prefetch->first_slot + prefetch->n_ready) % prefetch->n_slots;
+        slot       = &prefetch->slots[i];
+        cursor     = slot->cursor;
+        file_pos   = prefetch->next_file_pos;
+        hash_mode  = prefetch->hash_mode;
+        generation = prefetch->generation;
+
+        prefetch->next_file_pos    = -1;
+        prefetch->reading_file_pos = file_pos;
+        pthread_mutex_unlock(&prefetch->mutex);
+
+        tng_input_file_seek(cursor, file_pos, SEEK_SET);
+        stat          = tng_frame_set_read(cursor, hash_mode);
+        end_pos       = tng_input_file_tell(cursor);
+        next_file_pos = -1;
+        if (stat == TNG_SUCCESS)
         {
-            fprintf(stderr, "TNG library: Particle mapping overlap. %s: %d\n", __FILE__, __LINE__);
-            return (TNG_FAILURE);
+            next_file_pos = cursor->current_trajectory_frame_set.next_frame_set_file_pos;
+            /* The next frame set is probably about as long as this one. */
+            tng_input_file_advise(cursor, next_file_pos, end_pos - file_pos);
         }
-        if (mapping->num_first_particle + mapping->n_particles > num_first_particle
-            && mapping->num_first_particle + mapping->n_particles < num_first_particle + n_particles)
+
+        pthread_mutex_lock(&prefetch->mutex);
+        prefetch->reading_file_pos = -1;
+        /* The frame set is discarded if the read ahead frame sets have been
+         * discarded while reading it. */
+        if (generation == prefetch->generation && stat == TNG_SUCCESS)
         {
-            fprintf(stderr, "TNG library: Particle mapping overlap. %s: %d\n", __FILE__, __LINE__);
-            return (TNG_FAILURE);
+            slot->file_pos          = file_pos;
+            slot->end_pos           = end_pos;
+            slot->hash_mode         = hash_mode;
+            prefetch->next_file_pos = next_file_pos;
+            prefetch->n_ready++;
         }
+        pthread_cond_broadcast(&prefetch->cond);
     }
+    pthread_mutex_unlock(&prefetch->mutex);
 
-    frame_set->n_mapping_blocks++;
+    return (0);
+}
 
-    mapping = (tng_particle_mapping_t)realloc(
-            frame_set->mappings, sizeof(struct tng_particle_mapping) * frame_set->n_mapping_blocks);
+/**
+ * @brief Start the background thread reading frame sets ahead of a trajectory.
+ * @param tng_data is the reading trajectory. Its input file must be set.
+ * @param n_frame_sets is the maximum number of frame sets read ahead.
+ * @return TNG_SUCCESS (0) if successful, TNG_FAILURE (1) if the input file
+ * cannot be read by cursors or TNG_CRITICAL (2) if a major error has occured.
+ */
+static tng_function_status tng_prefetch_start(struct tng_trajectory* tng_data,
+                                              const int64_t          n_frame_sets)
+{
+    struct tng_prefetch* prefetch;
+    int64_t              i;
+    tng_function_status  stat = TNG_SUCCESS;
 
-    if (!mapping)
+    prefetch = (struct tng_prefetch*)malloc(sizeof(struct tng_prefetch));
+    if (!prefetch)
     {
         fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
-        free(frame_set->mappings);
-        frame_set->mappings = 0;
         return (TNG_CRITICAL);
     }
-    frame_set->mappings = mapping;
-
-    frame_set->mappings[frame_set->n_mapping_blocks - 1].num_first_particle = num_first_particle;
-    frame_set->mappings[frame_set->n_mapping_blocks - 1].n_particles        = n_particles;
-
-    frame_set->mappings[frame_set->n_mapping_blocks - 1].real_particle_numbers =
-            (int64_t*)malloc(sizeof(int64_t) * n_particles);
-    if (!frame_set->mappings[frame_set->n_mapping_blocks - 1].real_particle_numbers)
+    prefetch->slots = (struct tng_prefetch_slot*)calloc(n_frame_sets,
+                                                        sizeof(struct tng_prefetch_slot));
+    if (!prefetch->slots)
     {
         fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+        free(prefetch);
         return (TNG_CRITICAL);
     }
 
-    for (i = 0; i < n_particles; i++)
+    /* The cursors read the same data blocks as the reading trajectory. */
+    for (i = 0; i < n_frame_sets && stat == TNG_SUCCESS; i++)
     {
-        frame_set->mappings[frame_set->n_mapping_blocks - 1].real_particle_numbers[i] = mapping_table[i];
+        stat = tng_trajectory_cursor_init(tng_data, &prefetch->slots[i].cursor);
+        if (stat == TNG_SUCCESS && tng_data->n_read_block_ids > 0)
+        {
+            stat = tng_frame_set_read_block_ids_set(prefetch->slots[i].cursor,
+                                                    tng_data->n_read_block_ids,
+                                                    tng_data->read_block_ids);
+        }
+    }
+    if (stat != TNG_SUCCESS)
+    {
+        for (i = 0; i < n_frame_sets; i++)
+        {
+            tng_trajectory_destroy(&prefetch->slots[i].cursor);
+        }
+        free(prefetch->slots);
+        free(prefetch);
+        return (stat);
     }
 
-    return (TNG_SUCCESS);
-}
-
-tng_function_status DECLSPECDLLEXPORT tng_frame_set_particle_mapping_free(struct tng_trajectory* tng_data)
-{
-    tng_trajectory_frame_set_t frame_set;
-    tng_particle_mapping_t     mapping;
-    int64_t                    i;
+    prefetch->n_slots          = n_frame_sets;
+    prefetch->first_slot       = 0;
+    prefetch->n_ready          = 0;
+    prefetch->reading_file_pos = -1;
+    prefetch->hash_mode        = TNG_USE_HASH;
+    prefetch->generation       = 0;
+    prefetch->quit             = TNG_FALSE;
 
-    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+    /* Start reading the frame set following the current one right away. */
+    prefetch->next_file_pos = tng_data->current_trajectory_frame_set.next_frame_set_file_pos;
+    if (prefetch->next_file_pos < 0 && tng_data->current_trajectory_frame_set_input_file_pos <= 0)
+    {
+        prefetch->next_file_pos = tng_data->first_trajectory_frame_set_input_file_pos;
+    }
 
-    frame_set = &tng_data->current_trajectory_frame_set;
+    pthread_mutex_init(&prefetch->mutex, 0);
+    pthread_cond_init(&prefetch->cond, 0);
 
-    if (frame_set->n_mapping_blocks && frame_set->mappings)
+    if (pthread_create(&prefetch->thread, 0, tng_prefetch_thread, prefetch) != 0)
     {
-        for (i = 0; i < frame_set->n_mapping_blocks; i++)
+        fprintf(stderr, "TNG library: Cannot start prefetching thread. %s: %d\n", __FILE__,
+                __LINE__);
+        pthread_cond_destroy(&prefetch->cond);
+        pthread_mutex_destroy(&prefetch->mutex);
+        for (i = 0; i < n_frame_sets; i++)
         {
-            mapping = &frame_set->mappings[i];
-            if (mapping->real_particle_numbers)
-            {
-                free(mapping->real_particle_numbers);
-                mapping->real_particle_numbers = 0;
-            }
+            tng_trajectory_destroy(&prefetch->slots[i].cursor);
         }
-        free(frame_set->mappings);
-        frame_set->mappings         = 0;
-        frame_set->n_mapping_blocks = 0;
+        free(prefetch->slots);
+        free(prefetch);
+        return (TNG_CRITICAL);
     }
 
+    tng_data->prefetch = prefetch;
+
     return (TNG_SUCCESS);
 }
 
-tng_function_status DECLSPECDLLEXPORT tng_trajectory_init(tng_trajectory_t* tng_data_p)
+/**
+ * @brief Check if a data block has been read as part of the current frame set
+ * of a trajectory, rather than as part of an earlier frame set.
+ * @param tng_data is a trajectory data container.
+ * @param block_id is the ID of the data block.
+ * @return TNG_TRUE if the data block has been read with the current frame set.
+ */
+static tng_bool tng_frame_set_data_block_is_current(const struct tng_trajectory* tng_data,
+                                                    const int64_t                block_id)
 {
-    time_t                     seconds;
-    tng_trajectory_frame_set_t frame_set;
-    tng_trajectory_t           tng_data;
+    const struct tng_trajectory_frame_set* frame_set = &tng_data->current_trajectory_frame_set;
+    const struct tng_data*                 data;
+    int                                    i, n_blocks;
 
-    *tng_data_p = (tng_trajectory_t)malloc(sizeof(struct tng_trajectory));
-    if (!*tng_data_p)
+    n_blocks = frame_set->n_particle_data_blocks + frame_set->n_data_blocks;
+    for (i = 0; i < n_blocks; i++)
     {
-        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
-        return (TNG_CRITICAL);
+        data = i < frame_set->n_particle_data_blocks
+                       ? &frame_set->tr_particle_data[i]
+                       : &frame_set->tr_data[i - frame_set->n_particle_data_blocks];
+        if (data->block_id == block_id)
+        {
+            if (data->first_frame_with_data >= frame_set->first_frame
+                && data->first_frame_with_data < frame_set->first_frame + frame_set->n_frames)
+            {
+                return (TNG_TRUE);
+            }
+            return (TNG_FALSE);
+        }
     }
 
-    tng_data = *tng_data_p;
-
-    frame_set = &tng_data->current_trajectory_frame_set;
-
-    tng_data->input_file_path  = 0;
-    tng_data->input_file       = 0;
-    tng_data->input_file_len   = 0;
-    tng_data->output_file_path = 0;
-    tng_data->output_file      = 0;
+    return (TNG_FALSE);
+}
+#endif
 
-    tng_data->first_program_name  = 0;
-    tng_data->first_user_name     = 0;
-    tng_data->first_computer_name = 0;
-    tng_data->first_pgp_signature = 0;
-    tng_data->last_program_name   = 0;
-    tng_data->last_user_name      = 0;
-    tng_data->last_computer_name  = 0;
-    tng_data->last_pgp_signature  = 0;
-    tng_data->forcefield_name     = 0;
+/**
+ * @brief Make a frame set read ahead in the background the current frame set
+ * of the reading trajectory. If the frame set at file_pos is being read it is
+ * waited for. Otherwise, if it has not been read ahead, the frame sets read
+ * ahead are discarded.
+ * @param tng_data is the reading trajectory.
+ * @param file_pos is the file position of the requested frame set.
+ * @param hash_mode is the hash mode the frame set is requested with. It is
+ * also used for reading further frame sets ahead.
+ * @param block_id is the ID of a data block that must have been read with the
+ * frame set, or -1.
+ * @return TNG_SUCCESS (0) if the frame set has been taken over, TNG_FAILURE
+ * (1) if it must be read by the reading trajectory.
+ */
+static tng_function_status tng_prefetched_frame_set_take(struct tng_trajectory* tng_data,
+                                                         const int64_t          file_pos,
+                                                         const char             hash_mode,
+                                                         const int64_t          block_id)
+{
+#ifdef TNG_USE_PTHREADS
+    struct tng_prefetch*            prefetch = tng_data->prefetch;
+    struct tng_prefetch_slot*       slot;
+    struct tng_trajectory*          cursor;
+    struct tng_trajectory_frame_set frame_set;
+    int64_t                         i;
 
-    seconds = time(0);
-    if (seconds == -1)
-    {
-        fprintf(stderr, "TNG library: Cannot get time. %s: %d\n", __FILE__, __LINE__);
-    }
-    else
+    if (!prefetch || file_pos <= 0)
     {
-        tng_data->time = seconds;
+        return (TNG_FAILURE);
     }
 
-    tng_data->var_num_atoms_flag                           = TNG_CONSTANT_N_ATOMS;
-    tng_data->first_trajectory_frame_set_input_file_pos    = -1;
-    tng_data->last_trajectory_frame_set_input_file_pos     = -1;
-    tng_data->current_trajectory_frame_set_input_file_pos  = -1;
-    tng_data->first_trajectory_frame_set_output_file_pos   = -1;
-    tng_data->last_trajectory_frame_set_output_file_pos    = -1;
-    tng_data->current_trajectory_frame_set_output_file_pos = -1;
-    tng_data->frame_set_n_frames                           = 100;
-    tng_data->n_trajectory_frame_sets                      = 0;
-    tng_data->medium_stride_length                         = 100;
-    tng_data->long_stride_length                           = 10000;
+    pthread_mutex_lock(&prefetch->mutex);
+    prefetch->hash_mode = hash_mode;
+    for (;;)
+    {
+        /* Frame sets read ahead before the requested one are skipped. If the
+         * requested one has not been read ahead all are skipped. */
+        for (i = 0; i < prefetch->n_ready; i++)
+        {
+            slot = &prefetch->slots[(prefetch->first_slot + i) % prefetch->n_slots];
+            if (slot->file_pos == file_pos)
+            {
+                break;
+            }
+        }
+        prefetch->first_slot = (prefetch->first_slot + i) % prefetch->n_slots;
+        prefetch->n_ready -= i;
+        if (prefetch->n_ready > 0
+            || (prefetch->reading_file_pos != file_pos && prefetch->next_file_pos != file_pos))
+        {
+            break;
+        }
+        /* Wait for the requested frame set, which is being read ahead. */
+        pthread_cond_broadcast(&prefetch->cond);
+        pthread_cond_wait(&prefetch->cond, &prefetch->mutex);
+    }
+    slot   = &prefetch->slots[prefetch->first_slot];
+    cursor = slot->cursor;
+    if (prefetch->n_ready == 0 || slot->hash_mode < hash_mode
+        || (block_id >= 0 && !tng_frame_set_data_block_is_current(cursor, block_id)))
+    {
+        prefetch->generation++;
+        prefetch->n_ready       = 0;
+        prefetch->next_file_pos = -1;
+        pthread_mutex_unlock(&prefetch->mutex);
+        return (TNG_FAILURE);
+    }
 
-    tng_data->time_per_frame = -1;
+    /* The previous frame set of the reading trajectory is reused by the cursor. */
+    frame_set                              = tng_data->current_trajectory_frame_set;
+    tng_data->current_trajectory_frame_set = cursor->current_trajectory_frame_set;
+    cursor->current_trajectory_frame_set   = frame_set;
 
-    tng_data->n_particle_data_blocks = 0;
-    tng_data->n_data_blocks          = 0;
+    tng_data->current_trajectory_frame_set_input_file_pos = file_pos;
+    tng_data->time_per_frame                              = cursor->time_per_frame;
+    tng_data->n_trajectory_frame_sets++;
+    tng_input_file_seek(tng_data, slot->end_pos, SEEK_SET);
 
-    tng_data->non_tr_particle_data = 0;
-    tng_data->non_tr_data          = 0;
+    prefetch->first_slot = (prefetch->first_slot + 1) % prefetch->n_slots;
+    prefetch->n_ready--;
+    pthread_cond_broadcast(&prefetch->cond);
+    pthread_mutex_unlock(&prefetch->mutex);
 
-    tng_data->compress_algo_pos         = 0;
-    tng_data->compress_algo_vel         = 0;
-    tng_data->compression_precision     = 1000;
-    tng_data->distance_unit_exponential = -9;
+    return (TNG_SUCCESS);
+#else
+    (void)tng_data;
+    (void)file_pos;
+    (void)hash_mode;
+    (void)block_id;
+    return (TNG_FAILURE);
+#endif
+}
 
-    frame_set->first_frame       = -1;
-    frame_set->n_mapping_blocks  = 0;
-    frame_set->mappings          = 0;
-    frame_set->molecule_cnt_list = 0;
+/**
+ * @brief Continue reading frame sets ahead of the reading trajectory after it
+ * has read a frame set itself.
+ * @param tng_data is the reading trajectory.
+ * @param stat is the status of reading the frame set.
+ */
+static void tng_prefetch_continue(struct tng_trajectory* tng_data, const tng_function_status stat)
+{
+#ifdef TNG_USE_PTHREADS
+    struct tng_prefetch* prefetch = tng_data->prefetch;
 
-    frame_set->n_particle_data_blocks = 0;
-    frame_set->n_data_blocks          = 0;
+    if (!prefetch || stat == TNG_CRITICAL)
+    {
+        return;
+    }
 
-    frame_set->tr_particle_data = 0;
-    frame_set->tr_data          = 0;
+    pthread_mutex_lock(&prefetch->mutex);
+    prefetch->next_file_pos = tng_data->current_trajectory_frame_set.next_frame_set_file_pos;
+    pthread_cond_broadcast(&prefetch->cond);
+    pthread_mutex_unlock(&prefetch->mutex);
+#else
+    (void)tng_data;
+    (void)stat;
+#endif
+}
 
-    frame_set->n_written_frames   = 0;
-    frame_set->n_unwritten_frames = 0;
+/**
+ * @brief Stop the background thread reading frame sets ahead and discard the
+ * frame sets read ahead.
+ * @param tng_data is the reading trajectory.
+ */
+static void tng_prefetch_finish(struct tng_trajectory* tng_data)
+{
+#ifdef TNG_USE_PTHREADS
+    struct tng_prefetch* prefetch = tng_data->prefetch;
+    int64_t              i;
 
-    frame_set->next_frame_set_file_pos               = -1;
-    frame_set->prev_frame_set_file_pos               = -1;
-    frame_set->medium_stride_next_frame_set_file_pos = -1;
-    frame_set->medium_stride_prev_frame_set_file_pos = -1;
-    frame_set->long_stride_next_frame_set_file_pos   = -1;
-    frame_set->long_stride_prev_frame_set_file_pos   = -1;
+    if (!prefetch)
+    {
+        return;
+    }
 
-    frame_set->first_frame_time = -1;
+    pthread_mutex_lock(&prefetch->mutex);
+    prefetch->quit = TNG_TRUE;
+    pthread_cond_broadcast(&prefetch->cond);
+    pthread_mutex_unlock(&prefetch->mutex);
 
-    tng_data->n_molecules       = 0;
-    tng_data->molecules         = 0;
-    tng_data->molecule_cnt_list = 0;
-    tng_data->n_particles       = 0;
+    pthread_join(prefetch->thread, 0);
+    pthread_cond_destroy(&prefetch->cond);
+    pthread_mutex_destroy(&prefetch->mutex);
 
+    for (i = 0; i < prefetch->n_slots; i++)
     {
-        /* Check the endianness of the computer */
-        static int32_t endianness_32 = 0x01234567;
-        /* 0x01234567 */
-        if (*(const unsigned char*)&endianness_32 == 0x01)
-        {
-            tng_data->endianness_32 = TNG_BIG_ENDIAN_32;
-        }
+        tng_trajectory_destroy(&prefetch->slots[i].cursor);
+    }
+    free(prefetch->slots);
+    free(prefetch);
+    tng_data->prefetch = 0;
+#else
+    (void)tng_data;
+#endif
+}
 
-        /* 0x67452301 */
-        else if (*(const unsigned char*)&endianness_32 == 0x67)
-        {
-            tng_data->endianness_32 = TNG_LITTLE_ENDIAN_32;
-        }
+/**
+ * @brief Write the current frame set and start a new frame set. If write-behind
+ * is enabled (see tng_write_behind_set()) the current frame set is handed over
+ * to the background thread instead, after waiting for the previous frame set to
+ * be written, and the new frame set reuses the data blocks of the previous frame
+ * set.
+ * @param tng_data is the writing trajectory.
+ * @param first_frame is the first frame of the new frame set.
+ * @param n_frames is the number of frames in the new frame set.
+ * @return TNG_SUCCESS (0) if successful, TNG_FAILURE (1) if a minor error
+ * has occurred or TNG_CRITICAL (2) if a major error has occured.
+ */
+static tng_function_status tng_frame_set_write_and_new(struct tng_trajectory* tng_data,
+                                                       const int64_t          first_frame,
+                                                       const int64_t          n_frames)
+{
+    tng_function_status stat;
+#ifdef TNG_USE_PTHREADS
+    tng_trajectory_frame_set_t      frame_set = &tng_data->current_trajectory_frame_set;
+    struct tng_write_behind*        write_behind;
+    struct tng_trajectory*          writer;
+    struct tng_trajectory_frame_set temp;
+    char                            started = TNG_FALSE;
 
-        /* 0x45670123 */
-        else if (*(const unsigned char*)&endianness_32 == 0x45)
-        {
-            tng_data->endianness_32 = TNG_BYTE_PAIR_SWAP_32;
-        }
-    }
+    if (tng_data->write_behind_flag && frame_set->n_mapping_blocks == 0 && !tng_data->var_num_atoms_flag)
     {
-        static int64_t endianness_64 = 0x0123456789ABCDEFLL;
-        /* 0x0123456789ABCDEF */
-        if (*(const unsigned char*)&endianness_64 == 0x01)
+        if (!tng_data->write_behind)
         {
-            tng_data->endianness_64 = TNG_BIG_ENDIAN_64;
+            stat = tng_write_behind_start(tng_data);
+            if (stat != TNG_SUCCESS)
+            {
+                return (stat);
+            }
+            started = TNG_TRUE;
         }
+        write_behind = tng_data->write_behind;
+        writer       = write_behind->writer;
 
-        /* 0xEFCDAB8967452301 */
-        else if (*(const unsigned char*)&endianness_64 == 0xEF)
+        pthread_mutex_lock(&write_behind->mutex);
+        while (write_behind->busy)
         {
-            tng_data->endianness_64 = TNG_LITTLE_ENDIAN_64;
+            pthread_cond_wait(&write_behind->cond, &write_behind->mutex);
         }
-
-        /* 0x89ABCDEF01234567 */
-        else if (*(const unsigned char*)&endianness_64 == 0x89)
+        stat = write_behind->stat;
+        if (stat != TNG_SUCCESS)
         {
-            tng_data->endianness_64 = TNG_QUAD_SWAP_64;
+            pthread_mutex_unlock(&write_behind->mutex);
+            fprintf(stderr, "TNG library: Cannot write frame set.  %s: %d\n", __FILE__, __LINE__);
+            return (stat);
         }
 
-        /* 0x45670123CDEF89AB */
-        else if (*(const unsigned char*)&endianness_64 == 0x45)
+        writer->time_per_frame        = tng_data->time_per_frame;
+        writer->compression_precision = tng_data->compression_precision;
+        writer->n_write_threads       = tng_data->n_write_threads;
+        writer->output_hash_type      = tng_data->output_hash_type;
+        writer->n_particles           = tng_data->n_particles;
+        writer->medium_stride_length  = tng_data->medium_stride_length;
+        writer->long_stride_length    = tng_data->long_stride_length;
+
+        temp = writer->current_trajectory_frame_set;
+        if (!started)
         {
-            tng_data->endianness_64 = TNG_BYTE_PAIR_SWAP_64;
+            tng_frame_set_file_pointers_copy(frame_set, &temp);
         }
+        writer->current_trajectory_frame_set = *frame_set;
+        *frame_set                           = temp;
 
-        /* 0x23016745AB89EFCD */
-        else if (*(const unsigned char*)&endianness_64 == 0x23)
+        /* The file pointers of the new frame set are set up when it is handed
+         * over or when the writing in the background is finished. */
+        frame_set->first_frame        = first_frame;
+        frame_set->n_frames           = n_frames;
+        frame_set->n_written_frames   = 0;
+        frame_set->n_unwritten_frames = 0;
+        frame_set->first_frame_time   = -1;
+
+        /* The new frame set must have the same data blocks as the frame set
+         * written before it. */
+        stat = tng_frame_set_data_blocks_layout_copy(tng_data, &writer->current_trajectory_frame_set);
+        if (stat == TNG_SUCCESS)
         {
-            tng_data->endianness_64 = TNG_BYTE_SWAP_64;
+            write_behind->prepared = started;
+            write_behind->busy     = TNG_TRUE;
+            pthread_cond_broadcast(&write_behind->cond);
         }
-    }
+        pthread_mutex_unlock(&write_behind->mutex);
 
-    /* By default do not swap the byte order, i.e. keep the byte order of the
-     * architecture. The input file endianness will be set when reading the
-     * header. The output endianness can be changed - before the file is
-     * written. */
-    tng_data->input_endianness_swap_func_32  = 0;
-    tng_data->input_endianness_swap_func_64  = 0;
-    tng_data->output_endianness_swap_func_32 = 0;
-    tng_data->output_endianness_swap_func_64 = 0;
+        return (stat);
+    }
+#endif
 
-    tng_data->current_trajectory_frame_set.next_frame_set_file_pos = -1;
-    tng_data->current_trajectory_frame_set.prev_frame_set_file_pos = -1;
-    tng_data->current_trajectory_frame_set.n_frames                = 0;
+    stat = tng_frame_set_write(tng_data, TNG_USE_HASH);
+    if (stat != TNG_SUCCESS)
+    {
+        fprintf(stderr, "TNG library: Cannot write frame set.  %s: %d\n", __FILE__, __LINE__);
+        return (stat);
+    }
+    stat = tng_frame_set_new(tng_data, first_frame, n_frames);
+    if (stat != TNG_SUCCESS)
+    {
+        fprintf(stderr, "TNG library: Cannot create frame set.  %s: %d\n", __FILE__, __LINE__);
+    }
 
-    return (TNG_SUCCESS);
+    return (stat);
 }
 
 tng_function_status DECLSPECDLLEXPORT tng_trajectory_destroy(tng_trajectory_t* tng_data_p)
 {
-    int64_t                    i, j, k, l;
-    int64_t                    n_particles, n_values_per_frame;
+    int64_t                    i, n_particles;
     tng_trajectory_t           tng_data = *tng_data_p;
     tng_trajectory_frame_set_t frame_set;
 
@@ -8394,8 +12303,38 @@ tng_function_status DECLSPECDLLEXPORT tng_trajectory_destroy(tng_trajectory_t* t
         return (TNG_SUCCESS);
     }
 
+    tng_write_behind_finish(tng_data);
+    tng_prefetch_finish(tng_data);
+    tng_hash_verifier_finish(tng_data);
+    tng_frame_set_cache_destroy(tng_data);
+    if (tng_data->hash_mismatches)
+    {
+        free(tng_data->hash_mismatches);
+        tng_data->hash_mismatches = 0;
+    }
+
     frame_set = &tng_data->current_trajectory_frame_set;
 
+    /* The topology, the general information and the input file of a cursor
+     * belong to its reader. */
+    if (tng_data->reader)
+    {
+        tng_input_map_destroy(tng_data);
+        tng_data->input_file          = 0;
+        tng_data->first_program_name  = 0;
+        tng_data->last_program_name   = 0;
+        tng_data->first_user_name     = 0;
+        tng_data->last_user_name      = 0;
+        tng_data->first_computer_name = 0;
+        tng_data->last_computer_name  = 0;
+        tng_data->first_pgp_signature = 0;
+        tng_data->last_pgp_signature  = 0;
+        tng_data->forcefield_name     = 0;
+        tng_data->molecules           = 0;
+        tng_data->n_molecules         = 0;
+        tng_data->molecule_cnt_list   = 0;
+    }
+
     if (tng_data->input_file)
     {
         if (tng_data->output_file == tng_data->input_file)
@@ -8403,6 +12342,7 @@ tng_function_status DECLSPECDLLEXPORT tng_trajectory_destroy(tng_trajectory_t* t
             tng_frame_set_finalize(tng_data, TNG_USE_HASH);
             tng_data->output_file = 0;
         }
+        tng_input_map_destroy(tng_data);
         fclose(tng_data->input_file);
         tng_data->input_file = 0;
     }
@@ -8508,33 +12448,7 @@ tng_function_status DECLSPECDLLEXPORT tng_trajectory_destroy(tng_trajectory_t* t
                 tng_data->non_tr_particle_data[i].values = 0;
             }
 
-            if (tng_data->non_tr_particle_data[i].strings)
-            {
-                n_values_per_frame = tng_data->non_tr_particle_data[i].n_values_per_frame;
-                if (tng_data->non_tr_particle_data[i].strings[0])
-                {
-                    for (j = 0; j < n_particles; j++)
-                    {
-                        if (tng_data->non_tr_particle_data[i].strings[0][j])
-                        {
-                            for (k = 0; k < n_values_per_frame; k++)
-                            {
-                                if (tng_data->non_tr_particle_data[i].strings[0][j][k])
-                                {
-                                    free(tng_data->non_tr_particle_data[i].strings[0][j][k]);
-                                    tng_data->non_tr_particle_data[i].strings[0][j][k] = 0;
-                                }
-                            }
-                            free(tng_data->non_tr_particle_data[i].strings[0][j]);
-                            tng_data->non_tr_particle_data[i].strings[0][j] = 0;
-                        }
-                    }
-                    free(tng_data->non_tr_particle_data[i].strings[0]);
-                    tng_data->non_tr_particle_data[i].strings[0] = 0;
-                }
-                free(tng_data->non_tr_particle_data[i].strings);
-                tng_data->non_tr_particle_data[i].strings = 0;
-            }
+            tng_data_strings_free(&tng_data->non_tr_particle_data[i], n_particles);
 
             if (tng_data->non_tr_particle_data[i].block_name)
             {
@@ -8556,27 +12470,7 @@ tng_function_status DECLSPECDLLEXPORT tng_trajectory_destroy(tng_trajectory_t* t
                 tng_data->non_tr_data[i].values = 0;
             }
 
-            if (tng_data->non_tr_data[i].strings)
-            {
-                n_values_per_frame = tng_data->non_tr_data[i].n_values_per_frame;
-                if (tng_data->non_tr_data[i].strings[0][0])
-                {
-                    for (j = 0; j < n_values_per_frame; j++)
-                    {
-                        if (tng_data->non_tr_data[i].strings[0][0][j])
-                        {
-                            free(tng_data->non_tr_data[i].strings[0][0][j]);
-                            tng_data->non_tr_data[i].strings[0][0][j] = 0;
-                        }
-                    }
-                    free(tng_data->non_tr_data[i].strings[0][0]);
-                    tng_data->non_tr_data[i].strings[0][0] = 0;
-                }
-                free(tng_data->non_tr_data[i].strings[0]);
-                tng_data->non_tr_data[i].strings[0] = 0;
-                free(tng_data->non_tr_data[i].strings);
-                tng_data->non_tr_data[i].strings = 0;
-            }
+            tng_data_strings_free(&tng_data->non_tr_data[i], 1);
 
             if (tng_data->non_tr_data[i].block_name)
             {
@@ -8590,6 +12484,8 @@ tng_function_status DECLSPECDLLEXPORT tng_trajectory_destroy(tng_trajectory_t* t
 
     tng_data->n_particle_data_blocks = 0;
     tng_data->n_data_blocks          = 0;
+    tng_data_block_index_destroy(&tng_data->non_tr_particle_data_index);
+    tng_data_block_index_destroy(&tng_data->non_tr_data_index);
 
     if (tng_data->compress_algo_pos)
     {
@@ -8602,6 +12498,13 @@ tng_function_status DECLSPECDLLEXPORT tng_trajectory_destroy(tng_trajectory_t* t
         tng_data->compress_algo_vel = 0;
     }
 
+    if (tng_data->read_block_ids)
+    {
+        free(tng_data->read_block_ids);
+        tng_data->read_block_ids   = 0;
+        tng_data->n_read_block_ids = 0;
+    }
+
     if (frame_set->tr_particle_data)
     {
         for (i = 0; i < frame_set->n_particle_data_blocks; i++)
@@ -8612,36 +12515,7 @@ tng_function_status DECLSPECDLLEXPORT tng_trajectory_destroy(tng_trajectory_t* t
                 frame_set->tr_particle_data[i].values = 0;
             }
 
-            if (frame_set->tr_particle_data[i].strings)
-            {
-                n_values_per_frame = frame_set->tr_particle_data[i].n_values_per_frame;
-                for (j = 0; j < frame_set->tr_particle_data[i].n_frames; j++)
-                {
-                    if (frame_set->tr_particle_data[i].strings[j])
-                    {
-                        for (k = 0; k < n_particles; k++)
-                        {
-                            if (frame_set->tr_particle_data[i].strings[j][k])
-                            {
-                                for (l = 0; l < n_values_per_frame; l++)
-                                {
-                                    if (frame_set->tr_particle_data[i].strings[j][k][l])
-                                    {
-                                        free(frame_set->tr_particle_data[i].strings[j][k][l]);
-                                        frame_set->tr_particle_data[i].strings[j][k][l] = 0;
-                                    }
-                                }
-                                free(frame_set->tr_particle_data[i].strings[j][k]);
-                                frame_set->tr_particle_data[i].strings[j][k] = 0;
-                            }
-                        }
-                        free(frame_set->tr_particle_data[i].strings[j]);
-                        frame_set->tr_particle_data[i].strings[j] = 0;
-                    }
-                }
-                free(frame_set->tr_particle_data[i].strings);
-                frame_set->tr_particle_data[i].strings = 0;
-            }
+            tng_data_strings_free(&frame_set->tr_particle_data[i], n_particles);
 
             if (frame_set->tr_particle_data[i].block_name)
             {
@@ -8663,28 +12537,7 @@ tng_function_status DECLSPECDLLEXPORT tng_trajectory_destroy(tng_trajectory_t* t
                 frame_set->tr_data[i].values = 0;
             }
 
-            if (frame_set->tr_data[i].strings)
-            {
-                n_values_per_frame = frame_set->tr_data[i].n_values_per_frame;
-                for (j = 0; j < frame_set->tr_data[i].n_frames; j++)
-                {
-                    if (frame_set->tr_data[i].strings[j])
-                    {
-                        for (k = 0; k < n_values_per_frame; k++)
-                        {
-                            if (frame_set->tr_data[i].strings[j][k])
-                            {
-                                free(frame_set->tr_data[i].strings[j][k]);
-                                frame_set->tr_data[i].strings[j][k] = 0;
-                            }
-                        }
-                        free(frame_set->tr_data[i].strings[j]);
-                        frame_set->tr_data[i].strings[j] = 0;
-                    }
-                }
-                free(frame_set->tr_data[i].strings);
-                frame_set->tr_data[i].strings = 0;
-            }
+            tng_data_strings_free(&frame_set->tr_data[i], 1);
 
             if (frame_set->tr_data[i].block_name)
             {
@@ -8698,6 +12551,8 @@ tng_function_status DECLSPECDLLEXPORT tng_trajectory_destroy(tng_trajectory_t* t
 
     frame_set->n_particle_data_blocks = 0;
     frame_set->n_data_blocks          = 0;
+    tng_data_block_index_destroy(&frame_set->tr_particle_data_index);
+    tng_data_block_index_destroy(&frame_set->tr_data_index);
 
     if (tng_data->molecules)
     {
@@ -8714,6 +12569,10 @@ tng_function_status DECLSPECDLLEXPORT tng_trajectory_destroy(tng_trajectory_t* t
         free(tng_data->molecule_cnt_list);
         tng_data->molecule_cnt_list = 0;
     }
+    tng_molecule_index_destroy(tng_data);
+
+    tng_frame_set_index_clear(&tng_data->input_frame_set_index, TNG_FALSE);
+    tng_frame_set_index_clear(&tng_data->output_frame_set_index, TNG_FALSE);
 
     free(*tng_data_p);
     *tng_data_p = 0;
@@ -8755,7 +12614,26 @@ tng_function_status DECLSPECDLLEXPORT tng_trajectory_init_from_src(struct tng_tr
     {
         dest->input_file_path = 0;
     }
-    dest->input_file = 0;
+    dest->input_file          = 0;
+    dest->input_file_map_flag = src->input_file_map_flag;
+    dest->input_map           = 0;
+    dest->reader              = 0;
+    dest->n_read_threads      = 1;
+    dest->n_read_block_ids    = 0;
+    dest->read_block_ids      = 0;
+    dest->n_write_threads     = 1;
+    dest->output_hash_type    = src->output_hash_type;
+    dest->write_behind_flag   = TNG_FALSE;
+    dest->write_behind        = 0;
+
+    dest->hash_verifier           = 0;
+    dest->hash_mismatch_callback  = 0;
+    dest->hash_mismatch_user_data = 0;
+    dest->n_hash_mismatches       = 0;
+    dest->hash_mismatches         = 0;
+    dest->prefetch                = 0;
+    dest->frame_set_cache         = 0;
+
     if (src->output_file_path)
     {
         dest->output_file_path = (char*)malloc(strlen(src->output_file_path) + 1);
@@ -8794,6 +12672,18 @@ tng_function_status DECLSPECDLLEXPORT tng_trajectory_init_from_src(struct tng_tr
     dest->medium_stride_length                         = src->medium_stride_length;
     dest->long_stride_length                           = src->long_stride_length;
 
+    dest->n_input_frame_sets = src->n_input_frame_sets;
+    dest->n_input_frames     = src->n_input_frames;
+
+    dest->input_frame_set_index.entries  = 0;
+    dest->output_frame_set_index.entries = 0;
+    if (tng_frame_set_index_copy(&src->input_frame_set_index, &dest->input_frame_set_index) != TNG_SUCCESS)
+    {
+        return (TNG_CRITICAL);
+    }
+    /* The frame sets already written to the output file are not known. */
+    tng_frame_set_index_clear(&dest->output_frame_set_index, TNG_FALSE);
+
     dest->time_per_frame = src->time_per_frame;
 
     /* Currently the non trajectory data blocks are not copied since it
@@ -8803,6 +12693,11 @@ tng_function_status DECLSPECDLLEXPORT tng_trajectory_init_from_src(struct tng_tr
     dest->non_tr_particle_data   = 0;
     dest->non_tr_data            = 0;
 
+    dest->non_tr_particle_data_index.n_slots = 0;
+    dest->non_tr_particle_data_index.slots   = 0;
+    dest->non_tr_data_index.n_slots          = 0;
+    dest->non_tr_data_index.slots            = 0;
+
     dest->compress_algo_pos         = 0;
     dest->compress_algo_vel         = 0;
     dest->distance_unit_exponential = -9;
@@ -8812,12 +12707,22 @@ tng_function_status DECLSPECDLLEXPORT tng_trajectory_init_from_src(struct tng_tr
     frame_set->mappings          = 0;
     frame_set->molecule_cnt_list = 0;
 
+    frame_set->mapping_index.n_ranges         = 0;
+    frame_set->mapping_index.ranges           = 0;
+    frame_set->mapping_index.n_real_particles = 0;
+    frame_set->mapping_index.local_particles  = 0;
+
     frame_set->n_particle_data_blocks = 0;
     frame_set->n_data_blocks          = 0;
 
     frame_set->tr_particle_data = 0;
     frame_set->tr_data          = 0;
 
+    frame_set->tr_particle_data_index.n_slots = 0;
+    frame_set->tr_particle_data_index.slots   = 0;
+    frame_set->tr_data_index.n_slots          = 0;
+    frame_set->tr_data_index.slots            = 0;
+
     frame_set->n_written_frames   = 0;
     frame_set->n_unwritten_frames = 0;
 
@@ -8834,6 +12739,12 @@ tng_function_status DECLSPECDLLEXPORT tng_trajectory_init_from_src(struct tng_tr
     dest->molecule_cnt_list = 0;
     dest->n_particles       = src->n_particles;
 
+    dest->molecule_index.valid                 = TNG_FALSE;
+    dest->molecule_index.n_molecules           = 0;
+    dest->molecule_index.n_allocated_molecules = 0;
+    dest->molecule_index.first_particles       = 0;
+    dest->molecule_index.first_residues        = 0;
+
     dest->endianness_32                  = src->endianness_32;
     dest->endianness_64                  = src->endianness_64;
     dest->input_endianness_swap_func_32  = src->input_endianness_swap_func_32;
@@ -8848,6 +12759,95 @@ tng_function_status DECLSPECDLLEXPORT tng_trajectory_init_from_src(struct tng_tr
     return (TNG_SUCCESS);
 }
 
+tng_function_status DECLSPECDLLEXPORT tng_trajectory_cursor_init(struct tng_trajectory* reader,
+                                                                 tng_trajectory_t*      cursor_p)
+{
+    struct tng_trajectory* cursor;
+    struct tng_input_map*  map;
+
+    TNG_ASSERT(reader != 0, "TNG library: Reader trajectory must not be NULL.");
+    TNG_ASSERT(cursor_p != 0, "TNG library: cursor_p must not be a NULL pointer.");
+
+    *cursor_p = 0;
+
+    if (reader->reader)
+    {
+        reader = reader->reader;
+    }
+
+    if (!reader->input_file || reader->input_file == reader->output_file)
+    {
+        fprintf(stderr, "TNG library: The reader must have an input file open for reading. %s: %d\n",
+                __FILE__, __LINE__);
+        return (TNG_FAILURE);
+    }
+#ifndef TNG_USE_POSIX_IO
+    /* Positioned reads are not available. All cursors must use the mapping of the reader. */
+    if (!tng_input_file_is_mapped(reader))
+    {
+        return (TNG_FAILURE);
+    }
+#endif
+
+    map = (struct tng_input_map*)malloc(sizeof(struct tng_input_map));
+    if (!map)
+    {
+        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+        return (TNG_CRITICAL);
+    }
+    map->file      = reader->input_file;
+    map->fd        = fileno(reader->input_file);
+    map->owns_data = TNG_FALSE;
+    map->pos       = 0;
+    if (tng_input_file_is_mapped(reader))
+    {
+        map->data = reader->input_map->data;
+        map->len  = reader->input_map->len;
+    }
+    else
+    {
+        map->data = 0;
+        map->len  = reader->input_file_len;
+    }
+
+    if (tng_trajectory_init_from_src(reader, cursor_p) != TNG_SUCCESS)
+    {
+        /* A cursor that was not fully initialised cannot be destroyed. */
+        free(map);
+        free(*cursor_p);
+        *cursor_p = 0;
+        return (TNG_CRITICAL);
+    }
+    cursor = *cursor_p;
+
+    cursor->reader         = reader;
+    cursor->input_file     = reader->input_file;
+    cursor->input_file_len = reader->input_file_len;
+    cursor->input_map      = map;
+
+    cursor->first_program_name  = reader->first_program_name;
+    cursor->last_program_name   = reader->last_program_name;
+    cursor->first_user_name     = reader->first_user_name;
+    cursor->last_user_name      = reader->last_user_name;
+    cursor->first_computer_name = reader->first_computer_name;
+    cursor->last_computer_name  = reader->last_computer_name;
+    cursor->first_pgp_signature = reader->first_pgp_signature;
+    cursor->last_pgp_signature  = reader->last_pgp_signature;
+    cursor->forcefield_name     = reader->forcefield_name;
+
+    cursor->time                      = reader->time;
+    cursor->distance_unit_exponential = reader->distance_unit_exponential;
+    cursor->compression_precision     = reader->compression_precision;
+
+    cursor->n_molecules       = reader->n_molecules;
+    cursor->molecules         = reader->molecules;
+    cursor->molecule_cnt_list = reader->molecule_cnt_list;
+
+    tng_input_file_seek(cursor, cursor->first_trajectory_frame_set_input_file_pos, SEEK_SET);
+
+    return (TNG_SUCCESS);
+}
+
 tng_function_status DECLSPECDLLEXPORT tng_input_file_get(struct tng_trajectory* tng_data,
                                                          char*                  file_name,
                                                          const int              max_len)
@@ -8867,8 +12867,11 @@ tng_function_status DECLSPECDLLEXPORT tng_input_file_get(struct tng_trajectory*
 
 tng_function_status DECLSPECDLLEXPORT tng_input_file_set(struct tng_trajectory* tng_data, const char* file_name)
 {
-    unsigned int len;
-    char*        temp;
+    unsigned int        len;
+    char*               temp;
+    char                verify_in_background;
+    int64_t             n_prefetch_frame_sets;
+    tng_function_status stat;
 
     TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
     TNG_ASSERT(file_name, "TNG library: file_name must not be a NULL pointer");
@@ -8879,10 +12882,16 @@ tng_function_status DECLSPECDLLEXPORT tng_input_file_set(struct tng_trajectory*
         return (TNG_SUCCESS);
     }
 
+    tng_frame_set_prefetch_get(tng_data, &n_prefetch_frame_sets);
+    tng_prefetch_finish(tng_data);
     if (tng_data->input_file)
     {
+        tng_input_map_destroy(tng_data);
         fclose(tng_data->input_file);
+        tng_data->input_file = 0;
     }
+    verify_in_background = tng_data->hash_verifier != 0;
+    tng_hash_verifier_finish(tng_data);
 
     len  = tng_min_size(strlen(file_name) + 1, TNG_MAX_STR_LEN);
     temp = (char*)realloc(tng_data->input_file_path, len);
@@ -8897,7 +12906,22 @@ tng_function_status DECLSPECDLLEXPORT tng_input_file_set(struct tng_trajectory*
 
     strncpy(tng_data->input_file_path, file_name, len);
 
-    return (tng_input_file_init(tng_data));
+    tng_data->n_input_frame_sets = -1;
+    tng_data->n_input_frames     = -1;
+    tng_frame_set_index_clear(&tng_data->input_frame_set_index, TNG_FALSE);
+    tng_frame_set_cache_clear(tng_data);
+
+    stat = tng_input_file_init(tng_data);
+    if (stat == TNG_SUCCESS && verify_in_background)
+    {
+        stat = tng_deferred_hash_verification_set(tng_data, TNG_TRUE);
+    }
+    if (stat == TNG_SUCCESS && n_prefetch_frame_sets > 0)
+    {
+        stat = tng_frame_set_prefetch_set(tng_data, n_prefetch_frame_sets);
+    }
+
+    return (stat);
 }
 
 tng_function_status tng_output_file_get(struct tng_trajectory* tng_data, char* file_name, const int max_len)
@@ -8923,9 +12947,14 @@ tng_function_status DECLSPECDLLEXPORT tng_output_file_set(struct tng_trajectory*
     TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
     TNG_ASSERT(file_name, "TNG library: file_name must not be a NULL pointer");
 
-    if (tng_data->output_file_path && strcmp(tng_data->output_file_path, file_name) == 0)
+    if (tng_data->output_file_path && strcmp(tng_data->output_file_path, file_name) == 0)
+    {
+        return (TNG_SUCCESS);
+    }
+
+    if (tng_write_behind_finish(tng_data) != TNG_SUCCESS)
     {
-        return (TNG_SUCCESS);
+        return (TNG_CRITICAL);
     }
 
     if (tng_data->output_file)
@@ -8946,6 +12975,8 @@ tng_function_status DECLSPECDLLEXPORT tng_output_file_set(struct tng_trajectory*
 
     strncpy(tng_data->output_file_path, file_name, len);
 
+    tng_frame_set_index_clear(&tng_data->output_frame_set_index, TNG_TRUE);
+
     return (tng_output_file_init(tng_data));
 }
 
@@ -8963,6 +12994,11 @@ tng_function_status DECLSPECDLLEXPORT tng_output_append_file_set(struct tng_traj
         return (TNG_SUCCESS);
     }
 
+    if (tng_write_behind_finish(tng_data) != TNG_SUCCESS)
+    {
+        return (TNG_CRITICAL);
+    }
+
     if (tng_data->output_file)
     {
         fclose(tng_data->output_file);
@@ -8990,6 +13026,9 @@ tng_function_status DECLSPECDLLEXPORT tng_output_append_file_set(struct tng_traj
     }
     tng_data->input_file = tng_data->output_file;
 
+    /* The frame sets already in the file are not known. */
+    tng_frame_set_index_clear(&tng_data->output_frame_set_index, TNG_FALSE);
+
     return (TNG_SUCCESS);
 }
 
@@ -9124,6 +13163,32 @@ tng_function_status DECLSPECDLLEXPORT tng_output_file_endianness_set(struct tng_
     return (TNG_FAILURE);
 }
 
+tng_function_status DECLSPECDLLEXPORT tng_output_hash_type_get(struct tng_trajectory* tng_data,
+                                                               tng_hash_type*         type)
+{
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(type, "TNG library: type must not be a NULL pointer");
+
+    *type = (tng_hash_type)tng_data->output_hash_type;
+
+    return (TNG_SUCCESS);
+}
+
+tng_function_status DECLSPECDLLEXPORT tng_output_hash_type_set(struct tng_trajectory* tng_data,
+                                                               const tng_hash_type    type)
+{
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+
+    if (type != TNG_MD5 && type != TNG_XXH64)
+    {
+        return (TNG_FAILURE);
+    }
+
+    tng_data->output_hash_type = type;
+
+    return (TNG_SUCCESS);
+}
+
 tng_function_status DECLSPECDLLEXPORT tng_first_program_name_get(struct tng_trajectory* tng_data,
                                                                  char*                  name,
                                                                  const int              max_len)
@@ -9660,71 +13725,452 @@ tng_function_status DECLSPECDLLEXPORT tng_input_file_len_get(struct tng_trajecto
 
 tng_function_status DECLSPECDLLEXPORT tng_num_frames_get(struct tng_trajectory* tng_data, int64_t* n)
 {
-    tng_gen_block_t     block;
-    tng_function_status stat;
-    int64_t             file_pos, last_file_pos, first_frame, n_frames;
+    tng_gen_block_t             block;
+    tng_function_status         stat;
+    int64_t                     file_pos, last_file_pos, first_frame, n_frames;
+    struct tng_frame_set_index* index;
 
     TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
     TNG_ASSERT(tng_data->input_file,
                "TNG library: An input file must be open to find the next frame set");
     TNG_ASSERT(n, "TNG library: n must not be a NULL pointer");
 
-    file_pos      = ftello(tng_data->input_file);
-    last_file_pos = tng_data->last_trajectory_frame_set_input_file_pos;
+    /* The output file may be read through input_file while it is being written. */
+    if (tng_data->input_file != tng_data->output_file)
+    {
+        if (tng_data->n_input_frames < 0 && tng_frame_set_index_input_find(tng_data) == TNG_SUCCESS)
+        {
+            index                    = &tng_data->input_frame_set_index;
+            tng_data->n_input_frames = index->entries[index->n_entries - 1].first_frame
+                                       + index->entries[index->n_entries - 1].n_frames;
+        }
+        if (tng_data->n_input_frames >= 0)
+        {
+            *n = tng_data->n_input_frames;
+            return (TNG_SUCCESS);
+        }
+    }
+
+    file_pos      = tng_input_file_tell(tng_data);
+    last_file_pos = tng_data->last_trajectory_frame_set_input_file_pos;
+
+    if (last_file_pos <= 0)
+    {
+        return (TNG_FAILURE);
+    }
+
+    tng_block_init(&block);
+    tng_input_file_seek(tng_data, last_file_pos, SEEK_SET);
+    /* Read block headers first to see that a frame set block is found. */
+    stat = tng_block_header_read(tng_data, block);
+    if (stat == TNG_CRITICAL || block->id != TNG_TRAJECTORY_FRAME_SET)
+    {
+        fprintf(stderr, "TNG library: Cannot read block header at pos %" PRId64 ". %s: %d\n",
+                last_file_pos, __FILE__, __LINE__);
+        tng_block_destroy(&block);
+        return (TNG_FAILURE);
+    }
+    tng_block_destroy(&block);
+
+    if (tng_file_input_numerical(tng_data, &first_frame, sizeof(first_frame), TNG_SKIP_HASH, 0, __LINE__)
+        == TNG_CRITICAL)
+    {
+        return (TNG_CRITICAL);
+    }
+
+    if (tng_file_input_numerical(tng_data, &n_frames, sizeof(n_frames), TNG_SKIP_HASH, 0, __LINE__)
+        == TNG_CRITICAL)
+    {
+        return (TNG_CRITICAL);
+    }
+
+    tng_input_file_seek(tng_data, file_pos, SEEK_SET);
+
+    *n = first_frame + n_frames;
+
+    if (tng_data->input_file != tng_data->output_file)
+    {
+        tng_data->n_input_frames = *n;
+    }
+
+    return (TNG_SUCCESS);
+}
+
+tng_function_status DECLSPECDLLEXPORT tng_compression_precision_get(struct tng_trajectory* tng_data,
+                                                                    double* precision)
+{
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+
+    *precision = tng_data->compression_precision;
+
+    return (TNG_SUCCESS);
+}
+
+tng_function_status DECLSPECDLLEXPORT tng_compression_precision_set(struct tng_trajectory* tng_data,
+                                                                    const double precision)
+{
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+
+    tng_data->compression_precision = precision;
+
+    return (TNG_SUCCESS);
+}
+
+tng_function_status DECLSPECDLLEXPORT tng_num_read_threads_get(struct tng_trajectory* tng_data,
+                                                              int64_t*               n_threads)
+{
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(n_threads, "TNG library: n_threads must not be a NULL pointer.");
+
+    *n_threads = tng_data->n_read_threads;
+
+    return (TNG_SUCCESS);
+}
+
+tng_function_status DECLSPECDLLEXPORT tng_num_read_threads_set(struct tng_trajectory* tng_data,
+                                                              const int64_t          n_threads)
+{
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+
+    if (n_threads < 1)
+    {
+        return (TNG_FAILURE);
+    }
+#ifndef _OPENMP
+    if (n_threads > 1)
+    {
+        return (TNG_FAILURE);
+    }
+#endif
+
+    tng_data->n_read_threads = n_threads;
+
+    return (TNG_SUCCESS);
+}
+
+tng_function_status DECLSPECDLLEXPORT tng_frame_set_read_block_ids_get(struct tng_trajectory* tng_data,
+                                                                      int64_t*               n_block_ids,
+                                                                      const int64_t**        block_ids)
+{
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(n_block_ids, "TNG library: n_block_ids must not be a NULL pointer.");
+    TNG_ASSERT(block_ids, "TNG library: block_ids must not be a NULL pointer.");
+
+    *n_block_ids = tng_data->n_read_block_ids;
+    *block_ids   = tng_data->read_block_ids;
+
+    return (TNG_SUCCESS);
+}
+
+tng_function_status DECLSPECDLLEXPORT tng_frame_set_read_block_ids_set(struct tng_trajectory* tng_data,
+                                                                      const int64_t          n_block_ids,
+                                                                      const int64_t*         block_ids)
+{
+    int64_t* ids = 0;
+    int64_t  n_prefetch_frame_sets;
+
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(n_block_ids <= 0 || block_ids, "TNG library: block_ids must not be a NULL pointer.");
+
+    if (n_block_ids > 0)
+    {
+        ids = (int64_t*)malloc(sizeof(int64_t) * n_block_ids);
+        if (!ids)
+        {
+            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+            return (TNG_CRITICAL);
+        }
+        memcpy(ids, block_ids, sizeof(int64_t) * n_block_ids);
+    }
+
+    free(tng_data->read_block_ids);
+    tng_data->read_block_ids   = ids;
+    tng_data->n_read_block_ids = n_block_ids > 0 ? n_block_ids : 0;
+
+    /* The frame sets read ahead may be missing data blocks. */
+    tng_frame_set_prefetch_get(tng_data, &n_prefetch_frame_sets);
+    if (n_prefetch_frame_sets > 0)
+    {
+        tng_prefetch_finish(tng_data);
+        return (tng_frame_set_prefetch_set(tng_data, n_prefetch_frame_sets));
+    }
+
+    return (TNG_SUCCESS);
+}
+
+tng_function_status DECLSPECDLLEXPORT tng_num_write_threads_get(struct tng_trajectory* tng_data,
+                                                               int64_t*               n_threads)
+{
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(n_threads, "TNG library: n_threads must not be a NULL pointer.");
+
+    *n_threads = tng_data->n_write_threads;
+
+    return (TNG_SUCCESS);
+}
+
+tng_function_status DECLSPECDLLEXPORT tng_num_write_threads_set(struct tng_trajectory* tng_data,
+                                                               const int64_t          n_threads)
+{
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+
+    if (n_threads < 1)
+    {
+        return (TNG_FAILURE);
+    }
+#ifndef _OPENMP
+    if (n_threads > 1)
+    {
+        return (TNG_FAILURE);
+    }
+#endif
+
+    tng_data->n_write_threads = n_threads;
+
+    return (TNG_SUCCESS);
+}
+
+tng_function_status DECLSPECDLLEXPORT tng_write_behind_get(struct tng_trajectory* tng_data, char* flag)
+{
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(flag, "TNG library: flag must not be a NULL pointer.");
+
+    *flag = tng_data->write_behind_flag;
+
+    return (TNG_SUCCESS);
+}
+
+tng_function_status DECLSPECDLLEXPORT tng_write_behind_set(struct tng_trajectory* tng_data, const char flag)
+{
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+
+    if (!flag)
+    {
+        tng_data->write_behind_flag = TNG_FALSE;
+        return (tng_write_behind_finish(tng_data));
+    }
+#ifndef TNG_USE_PTHREADS
+    return (TNG_FAILURE);
+#else
+    tng_data->write_behind_flag = TNG_TRUE;
+
+    return (TNG_SUCCESS);
+#endif
+}
+
+tng_function_status DECLSPECDLLEXPORT tng_deferred_hash_verification_get(struct tng_trajectory* tng_data,
+                                                                         char*                  flag)
+{
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(flag, "TNG library: flag must not be a NULL pointer.");
+
+    *flag = tng_data->hash_verifier ? TNG_TRUE : TNG_FALSE;
+
+    return (TNG_SUCCESS);
+}
+
+tng_function_status DECLSPECDLLEXPORT tng_deferred_hash_verification_set(struct tng_trajectory* tng_data,
+                                                                         const char             flag)
+{
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+
+    if (!flag)
+    {
+        tng_hash_verifier_finish(tng_data);
+        return (TNG_SUCCESS);
+    }
+#ifndef TNG_USE_PTHREADS
+    return (TNG_FAILURE);
+#else
+    if (tng_data->hash_verifier)
+    {
+        return (TNG_SUCCESS);
+    }
+    /* Cursors hand over their blocks to the thread of their reader. */
+    if (tng_data->reader)
+    {
+        return (TNG_FAILURE);
+    }
+
+    return (tng_hash_verifier_start(tng_data));
+#endif
+}
+
+tng_function_status DECLSPECDLLEXPORT tng_deferred_hash_verification_wait(struct tng_trajectory* tng_data)
+{
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+
+    tng_hash_verifier_wait(tng_data);
+
+    return (TNG_SUCCESS);
+}
+
+tng_function_status DECLSPECDLLEXPORT tng_hash_mismatch_callback_set(struct tng_trajectory* tng_data,
+                                                                     tng_hash_mismatch_callback callback,
+                                                                     void* user_data)
+{
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+
+#ifdef TNG_USE_PTHREADS
+    if (tng_data->hash_verifier)
+    {
+        pthread_mutex_lock(&tng_data->hash_verifier->mutex);
+    }
+#endif
+    tng_data->hash_mismatch_callback  = callback;
+    tng_data->hash_mismatch_user_data = user_data;
+#ifdef TNG_USE_PTHREADS
+    if (tng_data->hash_verifier)
+    {
+        pthread_mutex_unlock(&tng_data->hash_verifier->mutex);
+    }
+#endif
+
+    return (TNG_SUCCESS);
+}
+
+tng_function_status DECLSPECDLLEXPORT tng_hash_mismatches_get(struct tng_trajectory* tng_data,
+                                                              int64_t*               n_mismatches,
+                                                              int64_t**              file_positions)
+{
+    tng_function_status stat = TNG_SUCCESS;
+
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(n_mismatches, "TNG library: n_mismatches must not be a NULL pointer.");
+    TNG_ASSERT(file_positions, "TNG library: file_positions must not be a NULL pointer.");
+
+#ifdef TNG_USE_PTHREADS
+    if (tng_data->hash_verifier)
+    {
+        pthread_mutex_lock(&tng_data->hash_verifier->mutex);
+    }
+#endif
+    *n_mismatches   = tng_data->n_hash_mismatches;
+    *file_positions = 0;
+    if (*n_mismatches > 0)
+    {
+        *file_positions = (int64_t*)malloc(sizeof(int64_t) * *n_mismatches);
+        if (*file_positions)
+        {
+            memcpy(*file_positions, tng_data->hash_mismatches, sizeof(int64_t) * *n_mismatches);
+        }
+        else
+        {
+            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+            *n_mismatches = 0;
+            stat          = TNG_CRITICAL;
+        }
+    }
+#ifdef TNG_USE_PTHREADS
+    if (tng_data->hash_verifier)
+    {
+        pthread_mutex_unlock(&tng_data->hash_verifier->mutex);
+    }
+#endif
+
+    return (stat);
+}
+
+tng_function_status DECLSPECDLLEXPORT tng_frame_set_prefetch_get(struct tng_trajectory* tng_data,
+                                                                 int64_t*               n_frame_sets)
+{
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(n_frame_sets, "TNG library: n_frame_sets must not be a NULL pointer.");
+
+#ifdef TNG_USE_PTHREADS
+    *n_frame_sets = tng_data->prefetch ? tng_data->prefetch->n_slots : 0;
+#else
+    *n_frame_sets = 0;
+#endif
 
-    if (last_file_pos <= 0)
-    {
-        return (TNG_FAILURE);
-    }
+    return (TNG_SUCCESS);
+}
 
-    tng_block_init(&block);
-    fseeko(tng_data->input_file, last_file_pos, SEEK_SET);
-    /* Read block headers first to see that a frame set block is found. */
-    stat = tng_block_header_read(tng_data, block);
-    if (stat == TNG_CRITICAL || block->id != TNG_TRAJECTORY_FRAME_SET)
+tng_function_status DECLSPECDLLEXPORT tng_frame_set_prefetch_set(struct tng_trajectory* tng_data,
+                                                                 const int64_t          n_frame_sets)
+{
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+
+    if (n_frame_sets <= 0)
     {
-        fprintf(stderr, "TNG library: Cannot read block header at pos %" PRId64 ". %s: %d\n",
-                last_file_pos, __FILE__, __LINE__);
-        tng_block_destroy(&block);
-        return (TNG_FAILURE);
+        tng_prefetch_finish(tng_data);
+        return (TNG_SUCCESS);
     }
-    tng_block_destroy(&block);
-
-    if (tng_file_input_numerical(tng_data, &first_frame, sizeof(first_frame), TNG_SKIP_HASH, 0, __LINE__)
-        == TNG_CRITICAL)
+#ifndef TNG_USE_PTHREADS
+    return (TNG_FAILURE);
+#else
+    if (tng_data->prefetch && tng_data->prefetch->n_slots == n_frame_sets)
     {
-        return (TNG_CRITICAL);
+        return (TNG_SUCCESS);
     }
-
-    if (tng_file_input_numerical(tng_data, &n_frames, sizeof(n_frames), TNG_SKIP_HASH, 0, __LINE__)
-        == TNG_CRITICAL)
+    /* Frame sets are read ahead into cursors of the reading trajectory. */
+    if (tng_data->reader || !tng_data->input_file_path
+        || tng_input_file_init(tng_data) != TNG_SUCCESS)
     {
-        return (TNG_CRITICAL);
+        return (TNG_FAILURE);
     }
 
-    fseeko(tng_data->input_file, file_pos, SEEK_SET);
-
-    *n = first_frame + n_frames;
+    tng_prefetch_finish(tng_data);
 
-    return (TNG_SUCCESS);
+    return (tng_prefetch_start(tng_data, n_frame_sets));
+#endif
 }
 
-tng_function_status DECLSPECDLLEXPORT tng_compression_precision_get(struct tng_trajectory* tng_data,
-                                                                    double* precision)
+tng_function_status DECLSPECDLLEXPORT tng_frame_set_cache_size_get(struct tng_trajectory* tng_data,
+                                                                   int64_t*               max_size)
 {
     TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(max_size, "TNG library: max_size must not be a NULL pointer.");
 
-    *precision = tng_data->compression_precision;
+    *max_size = tng_data->frame_set_cache ? tng_data->frame_set_cache->max_size : 0;
 
     return (TNG_SUCCESS);
 }
 
-tng_function_status DECLSPECDLLEXPORT tng_compression_precision_set(struct tng_trajectory* tng_data,
-                                                                    const double precision)
+tng_function_status DECLSPECDLLEXPORT tng_frame_set_cache_size_set(struct tng_trajectory* tng_data,
+                                                                   const int64_t          max_size)
 {
+    struct tng_frame_set_cache* cache;
+
     TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
 
-    tng_data->compression_precision = precision;
+    if (max_size <= 0)
+    {
+        tng_frame_set_cache_destroy(tng_data);
+        return (TNG_SUCCESS);
+    }
+
+    cache = tng_data->frame_set_cache;
+    if (!cache)
+    {
+        cache = (struct tng_frame_set_cache*)malloc(sizeof(struct tng_frame_set_cache));
+        if (!cache)
+        {
+            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+            return (TNG_CRITICAL);
+        }
+        cache->n_buckets = 64;
+        cache->buckets   = (struct tng_frame_set_cache_entry**)calloc(
+                cache->n_buckets, sizeof(struct tng_frame_set_cache_entry*));
+        if (!cache->buckets)
+        {
+            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+            free(cache);
+            return (TNG_CRITICAL);
+        }
+        cache->size         = 0;
+        cache->n_entries    = 0;
+        cache->most_recent  = 0;
+        cache->least_recent = 0;
+
+        tng_data->frame_set_cache = cache;
+    }
+
+    cache->max_size = max_size;
+    while (cache->n_entries > 0 && cache->size > cache->max_size)
+    {
+        tng_frame_set_cache_entry_remove(cache, cache->least_recent);
+    }
 
     return (TNG_SUCCESS);
 }
@@ -9960,12 +14406,7 @@ tng_function_status DECLSPECDLLEXPORT tng_num_frame_sets_get(struct tng_trajecto
     TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
     TNG_ASSERT(n, "TNG library: n must not be a NULL pointer");
 
-    orig_frame_set = tng_data->current_trajectory_frame_set;
-
-    frame_set = &tng_data->current_trajectory_frame_set;
-
-    orig_frame_set_file_pos = tng_data->current_trajectory_frame_set_input_file_pos;
-    file_pos                = tng_data->first_trajectory_frame_set_input_file_pos;
+    file_pos = tng_data->first_trajectory_frame_set_input_file_pos;
 
     if (file_pos < 0)
     {
@@ -9973,8 +14414,29 @@ tng_function_status DECLSPECDLLEXPORT tng_num_frame_sets_get(struct tng_trajecto
         return (TNG_SUCCESS);
     }
 
+    /* The output file may be read through input_file while it is being written. */
+    if (tng_data->input_file != tng_data->output_file)
+    {
+        if (tng_data->n_input_frame_sets < 0 && tng_frame_set_index_input_find(tng_data) == TNG_SUCCESS)
+        {
+            tng_data->n_input_frame_sets = tng_data->input_frame_set_index.n_entries;
+        }
+        if (tng_data->n_input_frame_sets >= 0)
+        {
+            *n = tng_data->n_trajectory_frame_sets = tng_data->n_input_frame_sets;
+            tng_input_file_seek(tng_data, file_pos, SEEK_SET);
+            return (TNG_SUCCESS);
+        }
+    }
+
+    orig_frame_set = tng_data->current_trajectory_frame_set;
+
+    frame_set = &tng_data->current_trajectory_frame_set;
+
+    orig_frame_set_file_pos = tng_data->current_trajectory_frame_set_input_file_pos;
+
     tng_block_init(&block);
-    fseeko(tng_data->input_file, file_pos, SEEK_SET);
+    tng_input_file_seek(tng_data, file_pos, SEEK_SET);
     tng_data->current_trajectory_frame_set_input_file_pos = file_pos;
     /* Read block headers first to see what block is found. */
     stat = tng_block_header_read(tng_data, block);
@@ -10005,7 +14467,7 @@ tng_function_status DECLSPECDLLEXPORT tng_num_frame_sets_get(struct tng_trajecto
         if (file_pos > 0)
         {
             cnt += long_stride_length;
-            fseeko(tng_data->input_file, file_pos, SEEK_SET);
+            tng_input_file_seek(tng_data, file_pos, SEEK_SET);
             /* Read block headers first to see what block is found. */
             stat = tng_block_header_read(tng_data, block);
             if (stat == TNG_CRITICAL || block->id != TNG_TRAJECTORY_FRAME_SET)
@@ -10033,7 +14495,7 @@ tng_function_status DECLSPECDLLEXPORT tng_num_frame_sets_get(struct tng_trajecto
         if (file_pos > 0)
         {
             cnt += medium_stride_length;
-            fseeko(tng_data->input_file, file_pos, SEEK_SET);
+            tng_input_file_seek(tng_data, file_pos, SEEK_SET);
             /* Read block headers first to see what block is found. */
             stat = tng_block_header_read(tng_data, block);
             if (stat == TNG_CRITICAL || block->id != TNG_TRAJECTORY_FRAME_SET)
@@ -10060,7 +14522,7 @@ tng_function_status DECLSPECDLLEXPORT tng_num_frame_sets_get(struct tng_trajecto
         if (file_pos > 0)
         {
             ++cnt;
-            fseeko(tng_data->input_file, file_pos, SEEK_SET);
+            tng_input_file_seek(tng_data, file_pos, SEEK_SET);
             /* Read block headers first to see what block is found. */
             stat = tng_block_header_read(tng_data, block);
             if (stat == TNG_CRITICAL || block->id != TNG_TRAJECTORY_FRAME_SET)
@@ -10084,13 +14546,23 @@ tng_function_status DECLSPECDLLEXPORT tng_num_frame_sets_get(struct tng_trajecto
 
     *n = tng_data->n_trajectory_frame_sets = cnt;
 
+    if (tng_data->input_file != tng_data->output_file)
+    {
+        tng_data->n_input_frame_sets = cnt;
+    }
+
     *frame_set = orig_frame_set;
     /* The mapping block in the original frame set has been freed when reading
      * other frame sets. */
     frame_set->mappings         = 0;
     frame_set->n_mapping_blocks = 0;
 
-    fseeko(tng_data->input_file, tng_data->first_trajectory_frame_set_input_file_pos, SEEK_SET);
+    frame_set->mapping_index.n_ranges         = 0;
+    frame_set->mapping_index.ranges           = 0;
+    frame_set->mapping_index.n_real_particles = 0;
+    frame_set->mapping_index.local_particles  = 0;
+
+    tng_input_file_seek(tng_data, tng_data->first_trajectory_frame_set_input_file_pos, SEEK_SET);
 
     tng_data->current_trajectory_frame_set_input_file_pos = orig_frame_set_file_pos;
 
@@ -10120,6 +14592,17 @@ tng_function_status DECLSPECDLLEXPORT tng_frame_set_nr_find(struct tng_trajector
 
     frame_set = &tng_data->current_trajectory_frame_set;
 
+    /* Jump directly to the frame set if the file contains a frame set index. */
+    if (tng_frame_set_index_input_find(tng_data) == TNG_SUCCESS)
+    {
+        tng_data->n_trajectory_frame_sets = tng_data->input_frame_set_index.n_entries;
+        if (nr >= tng_data->input_frame_set_index.n_entries)
+        {
+            return (TNG_FAILURE);
+        }
+        return (tng_frame_set_index_entry_read(tng_data, nr));
+    }
+
     stat = tng_num_frame_sets_get(tng_data, &n_frame_sets);
 
     if (stat != TNG_SUCCESS)
@@ -10154,7 +14637,7 @@ tng_function_status DECLSPECDLLEXPORT tng_frame_set_nr_find(struct tng_trajector
     }
 
     tng_block_init(&block);
-    fseeko(tng_data->input_file, file_pos, SEEK_SET);
+    tng_input_file_seek(tng_data, file_pos, SEEK_SET);
     tng_data->current_trajectory_frame_set_input_file_pos = file_pos;
     /* Read block headers first to see what block is found. */
     stat = tng_block_header_read(tng_data, block);
@@ -10188,7 +14671,7 @@ tng_function_status DECLSPECDLLEXPORT tng_frame_set_nr_find(struct tng_trajector
         if (file_pos > 0)
         {
             curr_nr += long_stride_length;
-            fseeko(tng_data->input_file, file_pos, SEEK_SET);
+            tng_input_file_seek(tng_data, file_pos, SEEK_SET);
             /* Read block headers first to see what block is found. */
             stat = tng_block_header_read(tng_data, block);
             if (stat == TNG_CRITICAL || block->id != TNG_TRAJECTORY_FRAME_SET)
@@ -10220,7 +14703,7 @@ tng_function_status DECLSPECDLLEXPORT tng_frame_set_nr_find(struct tng_trajector
         if (file_pos > 0)
         {
             curr_nr += medium_stride_length;
-            fseeko(tng_data->input_file, file_pos, SEEK_SET);
+            tng_input_file_seek(tng_data, file_pos, SEEK_SET);
             /* Read block headers first to see what block is found. */
             stat = tng_block_header_read(tng_data, block);
             if (stat == TNG_CRITICAL || block->id != TNG_TRAJECTORY_FRAME_SET)
@@ -10252,7 +14735,7 @@ tng_function_status DECLSPECDLLEXPORT tng_frame_set_nr_find(struct tng_trajector
         if (file_pos > 0)
         {
             ++curr_nr;
-            fseeko(tng_data->input_file, file_pos, SEEK_SET);
+            tng_input_file_seek(tng_data, file_pos, SEEK_SET);
             /* Read block headers first to see what block is found. */
             stat = tng_block_header_read(tng_data, block);
             if (stat == TNG_CRITICAL || block->id != TNG_TRAJECTORY_FRAME_SET)
@@ -10284,7 +14767,7 @@ tng_function_status DECLSPECDLLEXPORT tng_frame_set_nr_find(struct tng_trajector
         if (file_pos > 0)
         {
             curr_nr -= long_stride_length;
-            fseeko(tng_data->input_file, file_pos, SEEK_SET);
+            tng_input_file_seek(tng_data, file_pos, SEEK_SET);
             /* Read block headers first to see what block is found. */
             stat = tng_block_header_read(tng_data, block);
             if (stat == TNG_CRITICAL || block->id != TNG_TRAJECTORY_FRAME_SET)
@@ -10316,7 +14799,7 @@ tng_function_status DECLSPECDLLEXPORT tng_frame_set_nr_find(struct tng_trajector
         if (file_pos > 0)
         {
             curr_nr -= medium_stride_length;
-            fseeko(tng_data->input_file, file_pos, SEEK_SET);
+            tng_input_file_seek(tng_data, file_pos, SEEK_SET);
             /* Read block headers first to see what block is found. */
             stat = tng_block_header_read(tng_data, block);
             if (stat == TNG_CRITICAL || block->id != TNG_TRAJECTORY_FRAME_SET)
@@ -10347,7 +14830,7 @@ tng_function_status DECLSPECDLLEXPORT tng_frame_set_nr_find(struct tng_trajector
         if (file_pos > 0)
         {
             --curr_nr;
-            fseeko(tng_data->input_file, file_pos, SEEK_SET);
+            tng_input_file_seek(tng_data, file_pos, SEEK_SET);
             /* Read block headers first to see what block is found. */
             stat = tng_block_header_read(tng_data, block);
             if (stat == TNG_CRITICAL || block->id != TNG_TRAJECTORY_FRAME_SET)
@@ -10379,7 +14862,7 @@ tng_function_status DECLSPECDLLEXPORT tng_frame_set_nr_find(struct tng_trajector
         if (file_pos > 0)
         {
             ++curr_nr;
-            fseeko(tng_data->input_file, file_pos, SEEK_SET);
+            tng_input_file_seek(tng_data, file_pos, SEEK_SET);
             /* Read block headers first to see what block is found. */
             stat = tng_block_header_read(tng_data, block);
             if (stat == TNG_CRITICAL || block->id != TNG_TRAJECTORY_FRAME_SET)
@@ -10412,7 +14895,7 @@ tng_function_status DECLSPECDLLEXPORT tng_frame_set_of_frame_find(struct tng_tra
 {
     int64_t                    first_frame, last_frame, n_frames_per_frame_set;
     int64_t                    long_stride_length, medium_stride_length;
-    int64_t                    file_pos, temp_frame, n_frames;
+    int64_t                    file_pos, temp_frame, n_frames, nr;
     tng_trajectory_frame_set_t frame_set;
     tng_gen_block_t            block;
     tng_function_status        stat;
@@ -10422,12 +14905,34 @@ tng_function_status DECLSPECDLLEXPORT tng_frame_set_of_frame_find(struct tng_tra
 
     frame_set = &tng_data->current_trajectory_frame_set;
 
+    /* Jump directly to the frame set if the file contains a frame set index. */
+    if (tng_frame_set_index_input_find(tng_data) == TNG_SUCCESS)
+    {
+        if (tng_data->current_trajectory_frame_set_input_file_pos < 0
+            || frame < frame_set->first_frame || frame >= frame_set->first_frame + frame_set->n_frames)
+        {
+            if (tng_frame_set_index_frame_find(&tng_data->input_frame_set_index, frame, &nr) != TNG_SUCCESS)
+            {
+                return (TNG_FAILURE);
+            }
+            stat = tng_frame_set_index_entry_read(tng_data, nr);
+            if (stat != TNG_SUCCESS)
+            {
+                return (stat);
+            }
+        }
+        first_frame = tng_max_i64(frame_set->first_frame, 0);
+        last_frame  = first_frame + frame_set->n_frames - 1;
+
+        return ((frame >= first_frame && frame <= last_frame) ? TNG_SUCCESS : TNG_FAILURE);
+    }
+
     tng_block_init(&block);
 
     if (tng_data->current_trajectory_frame_set_input_file_pos < 0)
     {
         file_pos = tng_data->first_trajectory_frame_set_input_file_pos;
-        fseeko(tng_data->input_file, file_pos, SEEK_SET);
+        tng_input_file_seek(tng_data, file_pos, SEEK_SET);
         tng_data->current_trajectory_frame_set_input_file_pos = file_pos;
         /* Read block headers first to see what block is found. */
         stat = tng_block_header_read(tng_data, block);
@@ -10505,7 +15010,7 @@ tng_function_status DECLSPECDLLEXPORT tng_frame_set_of_frame_find(struct tng_tra
 
         if (file_pos > 0)
         {
-            fseeko(tng_data->input_file, file_pos, SEEK_SET);
+            tng_input_file_seek(tng_data, file_pos, SEEK_SET);
             tng_data->current_trajectory_frame_set_input_file_pos = file_pos;
             /* Read block headers first to see what block is found. */
             stat = tng_block_header_read(tng_data, block);
@@ -10543,7 +15048,7 @@ tng_function_status DECLSPECDLLEXPORT tng_frame_set_of_frame_find(struct tng_tra
         file_pos = frame_set->long_stride_next_frame_set_file_pos;
         if (file_pos > 0)
         {
-            fseeko(tng_data->input_file, file_pos, SEEK_SET);
+            tng_input_file_seek(tng_data, file_pos, SEEK_SET);
             /* Read block headers first to see what block is found. */
             stat = tng_block_header_read(tng_data, block);
             if (stat == TNG_CRITICAL || block->id != TNG_TRAJECTORY_FRAME_SET)
@@ -10576,7 +15081,7 @@ tng_function_status DECLSPECDLLEXPORT tng_frame_set_of_frame_find(struct tng_tra
         file_pos = frame_set->medium_stride_next_frame_set_file_pos;
         if (file_pos > 0)
         {
-            fseeko(tng_data->input_file, file_pos, SEEK_SET);
+            tng_input_file_seek(tng_data, file_pos, SEEK_SET);
             /* Read block headers first to see what block is found. */
             stat = tng_block_header_read(tng_data, block);
             if (stat == TNG_CRITICAL || block->id != TNG_TRAJECTORY_FRAME_SET)
@@ -10608,7 +15113,7 @@ tng_function_status DECLSPECDLLEXPORT tng_frame_set_of_frame_find(struct tng_tra
         file_pos = frame_set->next_frame_set_file_pos;
         if (file_pos > 0)
         {
-            fseeko(tng_data->input_file, file_pos, SEEK_SET);
+            tng_input_file_seek(tng_data, file_pos, SEEK_SET);
             /* Read block headers first to see what block is found. */
             stat = tng_block_header_read(tng_data, block);
             if (stat == TNG_CRITICAL || block->id != TNG_TRAJECTORY_FRAME_SET)
@@ -10641,7 +15146,7 @@ tng_function_status DECLSPECDLLEXPORT tng_frame_set_of_frame_find(struct tng_tra
         file_pos = frame_set->long_stride_prev_frame_set_file_pos;
         if (file_pos > 0)
         {
-            fseeko(tng_data->input_file, file_pos, SEEK_SET);
+            tng_input_file_seek(tng_data, file_pos, SEEK_SET);
             /* Read block headers first to see what block is found. */
             stat = tng_block_header_read(tng_data, block);
             if (stat == TNG_CRITICAL || block->id != TNG_TRAJECTORY_FRAME_SET)
@@ -10674,7 +15179,7 @@ tng_function_status DECLSPECDLLEXPORT tng_frame_set_of_frame_find(struct tng_tra
         file_pos = frame_set->medium_stride_prev_frame_set_file_pos;
         if (file_pos > 0)
         {
-            fseeko(tng_data->input_file, file_pos, SEEK_SET);
+            tng_input_file_seek(tng_data, file_pos, SEEK_SET);
             /* Read block headers first to see what block is found. */
             stat = tng_block_header_read(tng_data, block);
             if (stat == TNG_CRITICAL || block->id != TNG_TRAJECTORY_FRAME_SET)
@@ -10706,7 +15211,7 @@ tng_function_status DECLSPECDLLEXPORT tng_frame_set_of_frame_find(struct tng_tra
         file_pos = frame_set->prev_frame_set_file_pos;
         if (file_pos > 0)
         {
-            fseeko(tng_data->input_file, file_pos, SEEK_SET);
+            tng_input_file_seek(tng_data, file_pos, SEEK_SET);
             /* Read block headers first to see what block is found. */
             stat = tng_block_header_read(tng_data, block);
             if (stat == TNG_CRITICAL || block->id != TNG_TRAJECTORY_FRAME_SET)
@@ -10739,7 +15244,7 @@ tng_function_status DECLSPECDLLEXPORT tng_frame_set_of_frame_find(struct tng_tra
         file_pos = frame_set->next_frame_set_file_pos;
         if (file_pos > 0)
         {
-            fseeko(tng_data->input_file, file_pos, SEEK_SET);
+            tng_input_file_seek(tng_data, file_pos, SEEK_SET);
             /* Read block headers first to see what block is found. */
             stat = tng_block_header_read(tng_data, block);
             if (stat == TNG_CRITICAL || block->id != TNG_TRAJECTORY_FRAME_SET)
@@ -10829,23 +15334,37 @@ static TNG_INLINE tng_function_status tng_particle_mapping_get_real_particle(str
                                                                              const int64_t local,
                                                                              int64_t*      real)
 {
-    int64_t                i, n_blocks = frame_set->n_mapping_blocks, first;
-    tng_particle_mapping_t mapping;
-    if (n_blocks <= 0)
+    const struct tng_particle_mapping_index* index = &frame_set->mapping_index;
+    int64_t                                  lo, hi, mid;
+    tng_particle_mapping_t                   mapping;
+    if (frame_set->n_mapping_blocks <= 0)
     {
         *real = local;
         return (TNG_SUCCESS);
     }
-    for (i = 0; i < n_blocks; i++)
+    /* Find the last mapping block starting at or before the particle. */
+    lo = 0;
+    hi = index->n_ranges;
+    while (lo < hi)
     {
-        mapping = &frame_set->mappings[i];
-        first   = mapping->num_first_particle;
-        if (local < first || local >= first + mapping->n_particles)
+        mid = lo + (hi - lo) / 2;
+        if (frame_set->mappings[index->ranges[mid]].num_first_particle <= local)
         {
-            continue;
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    if (lo > 0)
+    {
+        mapping = &frame_set->mappings[index->ranges[lo - 1]];
+        if (local < mapping->num_first_particle + mapping->n_particles)
+        {
+            *real = mapping->real_particle_numbers[local - mapping->num_first_particle];
+            return (TNG_SUCCESS);
         }
-        *real = mapping->real_particle_numbers[local - first];
-        return (TNG_SUCCESS);
     }
     *real = local;
     return (TNG_FAILURE);
@@ -10860,33 +15379,45 @@ static TNG_INLINE tng_function_status tng_particle_mapping_get_real_particle(str
  * @return TNG_SUCCESS (0) if successful or TNG_FAILURE (1) if the mapping
  * cannot be found.
  */
-/*static TNG_INLINE tng_function_status tng_particle_mapping_get_local_particle
-                (struct tng_trajectory_frame_set* frame_set,
-                 const int64_t real,
-                 int64_t *local)
+static TNG_INLINE tng_function_status tng_particle_mapping_get_local_particle(struct tng_trajectory_frame_set* frame_set,
+                                                                              const int64_t real,
+                                                                              int64_t*      local)
 {
-    int64_t i, j, n_blocks = frame_set->n_mapping_blocks;
-    tng_particle_mapping_t mapping;
-    if(n_blocks <= 0)
+    const struct tng_particle_mapping_index* index = &frame_set->mapping_index;
+    if (frame_set->n_mapping_blocks <= 0)
     {
         *local = real;
-        return(TNG_SUCCESS);
+        return (TNG_SUCCESS);
     }
-    for(i = 0; i < n_blocks; i++)
+    if (real < 0 || real >= index->n_real_particles || index->local_particles[real] < 0)
     {
-        mapping = &frame_set->mappings[i];
-        for(j = mapping->n_particles; j--;)
-        {
-            if(mapping->real_particle_numbers[j] == real)
-            {
-                *local = j;
-                return(TNG_SUCCESS);
-            }
-        }
+        return (TNG_FAILURE);
     }
-    return(TNG_FAILURE);
+    *local = index->local_particles[real];
+    return (TNG_SUCCESS);
+}
+
+tng_function_status DECLSPECDLLEXPORT tng_particle_mapping_real_particle_get(struct tng_trajectory* tng_data,
+                                                                            const int64_t          local,
+                                                                            int64_t*               real)
+{
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(real, "TNG library: real must not be a NULL pointer.");
+
+    return (tng_particle_mapping_get_real_particle(&tng_data->current_trajectory_frame_set, local,
+                                                   real));
+}
+
+tng_function_status DECLSPECDLLEXPORT tng_particle_mapping_local_particle_get(struct tng_trajectory* tng_data,
+                                                                             const int64_t          real,
+                                                                             int64_t*               local)
+{
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(local, "TNG library: local must not be a NULL pointer.");
+
+    return (tng_particle_mapping_get_local_particle(&tng_data->current_trajectory_frame_set, real,
+                                                    local));
 }
-*/
 
 static tng_function_status tng_file_headers_len_get(struct tng_trajectory* tng_data, int64_t* len)
 {
@@ -10902,9 +15433,9 @@ static tng_function_status tng_file_headers_len_get(struct tng_trajectory* tng_d
 
     *len = 0;
 
-    orig_pos = ftello(tng_data->input_file);
+    orig_pos = tng_input_file_tell(tng_data);
 
-    fseeko(tng_data->input_file, 0, SEEK_SET);
+    tng_input_file_seek(tng_data, 0, SEEK_SET);
 
     tng_block_init(&block);
     /* Read through the headers of non-trajectory blocks (they come before the
@@ -10913,10 +15444,10 @@ static tng_function_status tng_file_headers_len_get(struct tng_trajectory* tng_d
            && block->id != -1 && block->id != TNG_TRAJECTORY_FRAME_SET)
     {
         *len += block->header_contents_size + block->block_contents_size;
-        fseeko(tng_data->input_file, block->block_contents_size, SEEK_CUR);
+        tng_input_file_seek(tng_data, block->block_contents_size, SEEK_CUR);
     }
 
-    fseeko(tng_data->input_file, orig_pos, SEEK_SET);
+    tng_input_file_seek(tng_data, orig_pos, SEEK_SET);
 
     tng_block_destroy(&block);
 
@@ -10938,7 +15469,7 @@ tng_function_status DECLSPECDLLEXPORT tng_file_headers_read(struct tng_trajector
         return (TNG_CRITICAL);
     }
 
-    fseeko(tng_data->input_file, 0, SEEK_SET);
+    tng_input_file_seek(tng_data, 0, SEEK_SET);
 
     tng_block_init(&block);
     /* Non trajectory blocks (they come before the trajectory
@@ -10947,13 +15478,13 @@ tng_function_status DECLSPECDLLEXPORT tng_file_headers_read(struct tng_trajector
            && block->id != -1 && block->id != TNG_TRAJECTORY_FRAME_SET)
     {
         tng_block_read_next(tng_data, block, hash_mode);
-        prev_pos = ftello(tng_data->input_file);
+        prev_pos = tng_input_file_tell(tng_data);
     }
 
     /* Go back if a trajectory block was encountered */
     if (block->id == TNG_TRAJECTORY_FRAME_SET)
     {
-        fseeko(tng_data->input_file, prev_pos, SEEK_SET);
+        tng_input_file_seek(tng_data, prev_pos, SEEK_SET);
     }
 
     tng_block_destroy(&block);
@@ -10971,6 +15502,12 @@ tng_function_status DECLSPECDLLEXPORT tng_file_headers_write(struct tng_trajecto
 
     TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
 
+    stat = tng_write_behind_finish(tng_data);
+    if (stat != TNG_SUCCESS)
+    {
+        return (stat);
+    }
+
     if (tng_output_file_init(tng_data) != TNG_SUCCESS)
     {
         return (TNG_CRITICAL);
@@ -11063,13 +15600,13 @@ tng_function_status DECLSPECDLLEXPORT tng_file_headers_write(struct tng_trajecto
     for (i = 0; i < tng_data->n_data_blocks; i++)
     {
         block->id = tng_data->non_tr_data[i].block_id;
-        tng_data_block_write(tng_data, block, i, TNG_FALSE, 0, hash_mode);
+        tng_data_block_write(tng_data, block, i, TNG_FALSE, 0, hash_mode, 0);
     }
 
     for (i = 0; i < tng_data->n_particle_data_blocks; i++)
     {
         block->id = tng_data->non_tr_particle_data[i].block_id;
-        tng_data_block_write(tng_data, block, i, TNG_TRUE, 0, hash_mode);
+        tng_data_block_write(tng_data, block, i, TNG_TRUE, 0, hash_mode, 0);
     }
 
     tng_block_destroy(&block);
@@ -11086,11 +15623,23 @@ tng_function_status DECLSPECDLLEXPORT tng_file_headers_write(struct tng_trajecto
 
 tng_function_status DECLSPECDLLEXPORT tng_block_read_next(struct tng_trajectory* tng_data,
                                                           struct tng_gen_block*  block,
-                                                          const char             hash_mode)
+                                                          char                   hash_mode)
 {
     TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
     TNG_ASSERT(block, "TNG library: block must be initialised and must not be a NULL pointer.");
 
+#ifdef TNG_USE_PTHREADS
+    if (hash_mode == TNG_USE_HASH)
+    {
+        switch (tng_hash_verification_defer(tng_data, block))
+        {
+            case TNG_SUCCESS: hash_mode = TNG_SKIP_HASH; break;
+            case TNG_CRITICAL: return (TNG_CRITICAL);
+            default: break;
+        }
+    }
+#endif
+
     switch (block->id)
     {
         case TNG_TRAJECTORY_FRAME_SET:
@@ -11099,6 +15648,8 @@ tng_function_status DECLSPECDLLEXPORT tng_block_read_next(struct tng_trajectory*
             return (tng_trajectory_mapping_block_read(tng_data, block, hash_mode));
         case TNG_GENERAL_INFO: return (tng_general_info_block_read(tng_data, block, hash_mode));
         case TNG_MOLECULES: return (tng_molecules_block_read(tng_data, block, hash_mode));
+        case TNG_FRAME_SET_INDEX:
+            return (tng_frame_set_index_block_read(tng_data, block, hash_mode));
         default:
             if (block->id >= TNG_TRAJ_BOX_SHAPE)
             {
@@ -11107,12 +15658,39 @@ tng_function_status DECLSPECDLLEXPORT tng_block_read_next(struct tng_trajectory*
             else
             {
                 /* Skip to the next block */
-                fseeko(tng_data->input_file, block->block_contents_size, SEEK_CUR);
+                tng_input_file_seek(tng_data, block->block_contents_size, SEEK_CUR);
                 return (TNG_FAILURE);
             }
     }
 }
 
+/**
+ * @brief Check if a block is read by tng_frame_set_read(), according to the
+ * data block IDs set by tng_frame_set_read_block_ids_set().
+ * @param tng_data is a trajectory data container.
+ * @param block_id is the ID of the block.
+ * @return TNG_TRUE if the block should be read, TNG_FALSE if it should be skipped.
+ */
+static tng_bool tng_frame_set_block_id_is_read(const struct tng_trajectory* tng_data,
+                                               const int64_t                block_id)
+{
+    int64_t i;
+
+    /* Blocks describing the frame set, e.g. particle mappings, are always read. */
+    if (tng_data->n_read_block_ids == 0 || block_id < TNG_TRAJ_BOX_SHAPE)
+    {
+        return (TNG_TRUE);
+    }
+    for (i = 0; i < tng_data->n_read_block_ids; i++)
+    {
+        if (tng_data->read_block_ids[i] == block_id)
+        {
+            return (TNG_TRUE);
+        }
+    }
+    return (TNG_FALSE);
+}
+
 tng_function_status DECLSPECDLLEXPORT tng_frame_set_read(struct tng_trajectory* tng_data, const char hash_mode)
 {
     int64_t             file_pos;
@@ -11126,7 +15704,7 @@ tng_function_status DECLSPECDLLEXPORT tng_frame_set_read(struct tng_trajectory*
         return (TNG_CRITICAL);
     }
 
-    file_pos = ftello(tng_data->input_file);
+    file_pos = tng_input_file_tell(tng_data);
 
     tng_block_init(&block);
 
@@ -11145,16 +15723,24 @@ tng_function_status DECLSPECDLLEXPORT tng_frame_set_read(struct tng_trajectory*
     if (tng_block_read_next(tng_data, block, hash_mode) == TNG_SUCCESS)
     {
         tng_data->n_trajectory_frame_sets++;
-        file_pos = ftello(tng_data->input_file);
+        file_pos = tng_input_file_tell(tng_data);
         /* Read all blocks until next frame set block */
         stat = tng_block_header_read(tng_data, block);
         while (file_pos < tng_data->input_file_len && stat != TNG_CRITICAL
                && block->id != TNG_TRAJECTORY_FRAME_SET && block->id != -1)
         {
-            stat = tng_block_read_next(tng_data, block, hash_mode);
+            if (tng_frame_set_block_id_is_read(tng_data, block->id))
+            {
+                stat = tng_block_read_next(tng_data, block, hash_mode);
+            }
+            else
+            {
+                /* Only the header of unwanted data blocks is read. */
+                tng_input_file_seek(tng_data, block->block_contents_size, SEEK_CUR);
+            }
             if (stat != TNG_CRITICAL)
             {
-                file_pos = ftello(tng_data->input_file);
+                file_pos = tng_input_file_tell(tng_data);
                 if (file_pos < tng_data->input_file_len)
                 {
                     stat = tng_block_header_read(tng_data, block);
@@ -11171,7 +15757,7 @@ tng_function_status DECLSPECDLLEXPORT tng_frame_set_read(struct tng_trajectory*
 
         if (block->id == TNG_TRAJECTORY_FRAME_SET)
         {
-            fseeko(tng_data->input_file, file_pos, SEEK_SET);
+            tng_input_file_seek(tng_data, file_pos, SEEK_SET);
         }
     }
 
@@ -11210,7 +15796,7 @@ tng_function_status DECLSPECDLLEXPORT
 
     if (file_pos > 0)
     {
-        fseeko(tng_data->input_file, file_pos, SEEK_SET);
+        tng_input_file_seek(tng_data, file_pos, SEEK_SET);
     }
     else
     {
@@ -11228,10 +15814,12 @@ tng_function_status DECLSPECDLLEXPORT
         tng_block_destroy(&block);
         return (TNG_CRITICAL);
     }
-    /* If the current frame set had already been read skip its block contents */
+    /* If the current frame set had already been read skip its block contents, but read
+     * its particle mapping blocks again. */
     if (found_flag)
     {
-        fseeko(tng_data->input_file, block->block_contents_size, SEEK_CUR);
+        tng_input_file_seek(tng_data, block->block_contents_size, SEEK_CUR);
+        tng_frame_set_particle_mapping_free(tng_data);
     }
     /* Otherwise read the frame set block */
     else
@@ -11244,23 +15832,26 @@ tng_function_status DECLSPECDLLEXPORT
             return (stat);
         }
     }
-    file_pos = ftello(tng_data->input_file);
+    file_pos = tng_input_file_tell(tng_data);
 
     found_flag = 0;
 
-    /* Read only blocks of the requested ID
+    /* Read only blocks of the requested ID, and the particle mapping blocks,
      * until next frame set block */
     stat = tng_block_header_read(tng_data, block);
     while (file_pos < tng_data->input_file_len && stat != TNG_CRITICAL
            && block->id != TNG_TRAJECTORY_FRAME_SET && block->id != -1)
     {
-        if (block->id == block_id)
+        if (block->id == block_id || block->id == TNG_PARTICLE_MAPPING)
         {
+            if (block->id == block_id)
+            {
+                found_flag = 1;
+            }
             stat = tng_block_read_next(tng_data, block, hash_mode);
             if (stat != TNG_CRITICAL)
             {
-                file_pos   = ftello(tng_data->input_file);
-                found_flag = 1;
+                file_pos = tng_input_file_tell(tng_data);
                 if (file_pos < tng_data->input_file_len)
                 {
                     stat = tng_block_header_read(tng_data, block);
@@ -11270,7 +15861,7 @@ tng_function_status DECLSPECDLLEXPORT
         else
         {
             file_pos += block->block_contents_size + block->header_contents_size;
-            fseeko(tng_data->input_file, block->block_contents_size, SEEK_CUR);
+            tng_input_file_seek(tng_data, block->block_contents_size, SEEK_CUR);
             if (file_pos < tng_data->input_file_len)
             {
                 stat = tng_block_header_read(tng_data, block);
@@ -11287,7 +15878,7 @@ tng_function_status DECLSPECDLLEXPORT
 
     if (block->id == TNG_TRAJECTORY_FRAME_SET)
     {
-        fseeko(tng_data->input_file, file_pos, SEEK_SET);
+        tng_input_file_seek(tng_data, file_pos, SEEK_SET);
     }
 
     tng_block_destroy(&block);
@@ -11305,7 +15896,8 @@ tng_function_status DECLSPECDLLEXPORT
 tng_function_status DECLSPECDLLEXPORT tng_frame_set_read_next(struct tng_trajectory* tng_data,
                                                               const char             hash_mode)
 {
-    int64_t file_pos;
+    int64_t             file_pos;
+    tng_function_status stat;
 
     TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
 
@@ -11323,14 +15915,22 @@ tng_function_status DECLSPECDLLEXPORT tng_frame_set_read_next(struct tng_traject
 
     if (file_pos > 0)
     {
-        fseeko(tng_data->input_file, file_pos, SEEK_SET);
+        tng_input_file_seek(tng_data, file_pos, SEEK_SET);
     }
     else
     {
         return (TNG_FAILURE);
     }
 
-    return (tng_frame_set_read(tng_data, hash_mode));
+    if (tng_prefetched_frame_set_take(tng_data, file_pos, hash_mode, -1) == TNG_SUCCESS)
+    {
+        return (TNG_SUCCESS);
+    }
+
+    stat = tng_frame_set_read(tng_data, hash_mode);
+    tng_prefetch_continue(tng_data, stat);
+
+    return (stat);
 }
 
 tng_function_status DECLSPECDLLEXPORT
@@ -11358,13 +15958,18 @@ tng_function_status DECLSPECDLLEXPORT
 
     if (file_pos > 0)
     {
-        fseeko(tng_data->input_file, file_pos, SEEK_SET);
+        tng_input_file_seek(tng_data, file_pos, SEEK_SET);
     }
     else
     {
         return (TNG_FAILURE);
     }
 
+    if (tng_prefetched_frame_set_take(tng_data, file_pos, hash_mode, block_id) == TNG_SUCCESS)
+    {
+        return (TNG_SUCCESS);
+    }
+
     tng_block_init(&block);
 
     /* Read block headers first to see what block is found. */
@@ -11386,18 +15991,110 @@ tng_function_status DECLSPECDLLEXPORT
 
     tng_block_destroy(&block);
 
+    tng_prefetch_continue(tng_data, stat);
+
     return (stat);
 }
 
+#ifdef _OPENMP
+/**
+ * @brief Compress the data blocks of the current frame set in parallel, using
+ * tng_data->n_write_threads threads, before writing them in order.
+ * @param tng_data is the trajectory writing the frame set. It must not have
+ * particle mapping blocks.
+ * @param contents_p will be pointing to a list of the compressed contents of
+ * the non-particle data blocks followed by the particle data blocks. The list
+ * and the contents left in it must be freed by the caller.
+ * @return TNG_SUCCESS (0) if successful or TNG_CRITICAL (2) if a major
+ * error has occured.
+ */
+static tng_function_status
+        tng_frame_set_data_blocks_compress(struct tng_trajectory*           tng_data,
+                                           struct tng_data_block_contents** contents_p)
+{
+    tng_trajectory_frame_set_t      frame_set = &tng_data->current_trajectory_frame_set;
+    struct tng_data_block_contents* contents;
+    int64_t                         i, n_blocks;
+    tng_function_status             stat = TNG_SUCCESS;
+
+    n_blocks = frame_set->n_data_blocks + frame_set->n_particle_data_blocks;
+
+    contents = (struct tng_data_block_contents*)malloc(sizeof(struct tng_data_block_contents)
+                                                       * n_blocks);
+    if (!contents)
+    {
+        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+        return (TNG_CRITICAL);
+    }
+    for (i = 0; i < n_blocks; i++)
+    {
+        contents[i].contents = 0;
+        contents[i].len      = 0;
+    }
+
+    /* Only positions and velocities can be compressed using the TNG method and
+     * there is only one block of each, so the compression algorithms stored in
+     * the trajectory are not shared between threads. */
+#    pragma omp parallel for num_threads(tng_data->n_write_threads) schedule(dynamic, 1)
+    for (i = 0; i < n_blocks; i++)
+    {
+        tng_data_t data;
+        int64_t    n_frames, stride_length, frame_step, num_first_particle, n_particles;
+        tng_bool   is_particle_data = i >= frame_set->n_data_blocks ? TNG_TRUE : TNG_FALSE;
+
+        int64_t    block_index = is_particle_data ? i - frame_set->n_data_blocks : i;
+
+        if (tng_data_block_write_setup(tng_data, block_index, is_particle_data, 0, &data, &n_frames,
+                                       &stride_length, &frame_step, &num_first_particle,
+                                       &n_particles)
+                    != TNG_SUCCESS
+            || data->datatype == TNG_CHAR_DATA)
+        {
+            continue;
+        }
+        if (tng_data_block_contents_get(tng_data, data, frame_step, num_first_particle, n_particles,
+                                        &contents[i].contents, &contents[i].len)
+            != TNG_SUCCESS)
+        {
+#    pragma omp critical(tng_write_stat)
+            stat = TNG_CRITICAL;
+        }
+    }
+
+    if (stat != TNG_SUCCESS)
+    {
+        for (i = 0; i < n_blocks; i++)
+        {
+            free(contents[i].contents);
+        }
+        free(contents);
+        return (stat);
+    }
+
+    *contents_p = contents;
+
+    return (TNG_SUCCESS);
+}
+#endif
+
 tng_function_status tng_frame_set_write(struct tng_trajectory* tng_data, const char hash_mode)
 {
-    int                        i, j;
-    tng_gen_block_t            block;
-    tng_trajectory_frame_set_t frame_set;
-    tng_function_status        stat;
+    int                             i, j;
+    tng_gen_block_t                 block;
+    tng_trajectory_frame_set_t      frame_set;
+    struct tng_data_block_contents* contents = 0;
+    tng_function_status             stat;
 
     TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
 
+    /* The file pointers of the frame set are set up when the frame sets
+     * handed over before it are written. */
+    stat = tng_write_behind_finish(tng_data);
+    if (stat != TNG_SUCCESS)
+    {
+        return (stat);
+    }
+
     frame_set = &tng_data->current_trajectory_frame_set;
 
     if (frame_set->n_written_frames == frame_set->n_frames)
@@ -11420,19 +16117,54 @@ tng_function_status tng_frame_set_write(struct tng_trajectory* tng_data, const c
                 tng_data->current_trajectory_frame_set_output_file_pos;
     }
 
-    tng_block_init(&block);
-
-    if (tng_frame_set_block_write(tng_data, block, hash_mode) != TNG_SUCCESS)
+    tng_block_init(&block);
+
+    if (tng_frame_set_block_write(tng_data, block, hash_mode) != TNG_SUCCESS)
+    {
+        tng_block_destroy(&block);
+        return (TNG_FAILURE);
+    }
+
+    /* The frame set counts and the index read from the file do not include
+     * the frame sets added to it. */
+    if (tng_data->input_file == tng_data->output_file)
+    {
+        tng_data->n_input_frame_sets = -1;
+        tng_data->n_input_frames     = -1;
+        tng_frame_set_index_clear(&tng_data->input_frame_set_index, TNG_FALSE);
+        tng_data->input_frame_set_index.searched = TNG_TRUE;
+    }
+
+    if (tng_data->output_frame_set_index.valid
+        && tng_frame_set_index_entry_add(&tng_data->output_frame_set_index, frame_set->first_frame,
+                                         frame_set->n_frames,
+                                         tng_data->current_trajectory_frame_set_output_file_pos,
+                                         frame_set->first_frame_time)
+                   != TNG_SUCCESS)
     {
         tng_block_destroy(&block);
-        return (TNG_FAILURE);
+        return (TNG_CRITICAL);
+    }
+
+#ifdef _OPENMP
+    /* Compress the data blocks in parallel. They are still written in order. */
+    if (tng_data->n_write_threads > 1 && frame_set->n_mapping_blocks == 0
+        && frame_set->n_data_blocks + frame_set->n_particle_data_blocks > 1)
+    {
+        if (tng_frame_set_data_blocks_compress(tng_data, &contents) != TNG_SUCCESS)
+        {
+            tng_block_destroy(&block);
+            return (TNG_CRITICAL);
+        }
     }
+#endif
 
     /* Write non-particle data blocks */
     for (i = 0; i < frame_set->n_data_blocks; i++)
     {
         block->id = frame_set->tr_data[i].block_id;
-        tng_data_block_write(tng_data, block, i, TNG_FALSE, 0, hash_mode);
+        tng_data_block_write(tng_data, block, i, TNG_FALSE, 0, hash_mode,
+                             contents ? &contents[i] : 0);
     }
     /* Write the mapping blocks and particle data blocks*/
     if (frame_set->n_mapping_blocks)
@@ -11446,7 +16178,8 @@ tng_function_status tng_frame_set_write(struct tng_trajectory* tng_data, const c
                 for (j = 0; j < frame_set->n_particle_data_blocks; j++)
                 {
                     block->id = frame_set->tr_particle_data[j].block_id;
-                    tng_data_block_write(tng_data, block, j, TNG_TRUE, &frame_set->mappings[i], hash_mode);
+                    tng_data_block_write(tng_data, block, j, TNG_TRUE, &frame_set->mappings[i],
+                                         hash_mode, 0);
                 }
             }
         }
@@ -11456,8 +16189,19 @@ tng_function_status tng_frame_set_write(struct tng_trajectory* tng_data, const c
         for (i = 0; i < frame_set->n_particle_data_blocks; i++)
         {
             block->id = frame_set->tr_particle_data[i].block_id;
-            tng_data_block_write(tng_data, block, i, TNG_TRUE, 0, hash_mode);
+            tng_data_block_write(tng_data, block, i, TNG_TRUE, 0, hash_mode,
+                                 contents ? &contents[frame_set->n_data_blocks + i] : 0);
+        }
+    }
+
+    if (contents)
+    {
+        /* Free the contents of blocks that were not written. */
+        for (i = 0; i < frame_set->n_data_blocks + frame_set->n_particle_data_blocks; i++)
+        {
+            free(contents[i].contents);
         }
+        free(contents);
     }
 
 
@@ -11496,6 +16240,53 @@ tng_function_status DECLSPECDLLEXPORT tng_frame_set_premature_write(struct tng_t
     return (tng_frame_set_write(tng_data, hash_mode));
 }
 
+tng_function_status DECLSPECDLLEXPORT tng_frame_set_index_write(struct tng_trajectory* tng_data,
+                                                                const char             hash_mode)
+{
+    tng_gen_block_t             block;
+    struct tng_frame_set_index* index;
+    tng_function_status         stat;
+
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+
+    stat = tng_write_behind_finish(tng_data);
+    if (stat != TNG_SUCCESS)
+    {
+        return (stat);
+    }
+
+    index = &tng_data->output_frame_set_index;
+
+    if (!index->valid || index->n_entries <= 0)
+    {
+        return (TNG_FAILURE);
+    }
+
+    if (tng_output_file_init(tng_data) != TNG_SUCCESS)
+    {
+        return (TNG_CRITICAL);
+    }
+
+    /* The number of frames of the current frame set may have been updated
+     * after it was written. */
+    if (index->entries[index->n_entries - 1].file_pos == tng_data->current_trajectory_frame_set_output_file_pos)
+    {
+        index->entries[index->n_entries - 1].n_frames = tng_data->current_trajectory_frame_set.n_frames;
+    }
+
+    fseeko(tng_data->output_file, 0, SEEK_END);
+
+    tng_block_init(&block);
+
+    stat = tng_frame_set_index_block_write(tng_data, block, hash_mode);
+
+    tng_block_destroy(&block);
+
+    fflush(tng_data->output_file);
+
+    return (stat);
+}
+
 tng_function_status DECLSPECDLLEXPORT tng_frame_set_new(struct tng_trajectory* tng_data,
                                                         const int64_t          first_frame,
                                                         const int64_t          n_frames)
@@ -11509,6 +16300,11 @@ tng_function_status DECLSPECDLLEXPORT tng_frame_set_new(struct tng_trajectory* t
     TNG_ASSERT(first_frame >= 0, "TNG library: first_frame must be >= 0.");
     TNG_ASSERT(n_frames >= 0, "TNG library: n_frames must be >= 0.");
 
+    if (tng_write_behind_finish(tng_data) != TNG_SUCCESS)
+    {
+        return (TNG_CRITICAL);
+    }
+
     frame_set = &tng_data->current_trajectory_frame_set;
 
     curr_file_pos = ftello(tng_data->output_file);
@@ -11722,7 +16518,7 @@ tng_function_status DECLSPECDLLEXPORT tng_first_frame_nr_of_next_frame_set_get(s
                "TNG library: An input file must be open to find the next frame set");
     TNG_ASSERT(frame, "TNG library: frame must not be a NULL pointer");
 
-    file_pos = ftello(tng_data->input_file);
+    file_pos = tng_input_file_tell(tng_data);
 
     if (tng_data->current_trajectory_frame_set_input_file_pos <= 0)
     {
@@ -11739,7 +16535,7 @@ tng_function_status DECLSPECDLLEXPORT tng_first_frame_nr_of_next_frame_set_get(s
         return (TNG_FAILURE);
     }
 
-    fseeko(tng_data->input_file, next_frame_set_file_pos, SEEK_SET);
+    tng_input_file_seek(tng_data, next_frame_set_file_pos, SEEK_SET);
     /* Read block headers first to see that a frame set block is found. */
     tng_block_init(&block);
     stat = tng_block_header_read(tng_data, block);
@@ -11755,13 +16551,13 @@ tng_function_status DECLSPECDLLEXPORT tng_first_frame_nr_of_next_frame_set_get(s
         }*/
     tng_block_destroy(&block);
 
-    if (fread(frame, sizeof(int64_t), 1, tng_data->input_file) == 0)
+    if (tng_input_file_read(tng_data, frame, sizeof(int64_t)) == 0)
     {
         fprintf(stderr, "TNG library: Cannot read first frame of next frame set. %s: %d\n",
                 __FILE__, __LINE__);
         return (TNG_CRITICAL);
     }
-    fseeko(tng_data->input_file, file_pos, SEEK_SET);
+    tng_input_file_seek(tng_data, file_pos, SEEK_SET);
 
     return (TNG_SUCCESS);
 }
@@ -11809,11 +16605,11 @@ static tng_function_status tng_gen_data_block_add(struct tng_trajectory* tng_dat
     {
         if (is_particle_data)
         {
-            stat = tng_particle_data_block_create(tng_data, block_type_flag);
+            stat = tng_particle_data_block_create(tng_data, id, block_type_flag);
         }
         else
         {
-            stat = tng_data_block_create(tng_data, block_type_flag);
+            stat = tng_data_block_create(tng_data, id, block_type_flag);
         }
 
         if (stat != TNG_SUCCESS)
@@ -11843,8 +16639,6 @@ static tng_function_status tng_gen_data_block_add(struct tng_trajectory* tng_dat
                 data = &tng_data->non_tr_data[tng_data->n_data_blocks - 1];
             }
         }
-        data->block_id = id;
-
         data->block_name = (char*)malloc(strlen(block_name) + 1);
         if (!data->block_name)
         {
@@ -12299,14 +17093,14 @@ tng_function_status DECLSPECDLLEXPORT tng_frame_set_n_frames_of_data_block_get(s
                                                                                const int64_t block_id,
                                                                                int64_t* n_frames)
 {
-    tng_gen_block_t     block;
-    tng_function_status stat;
-    char                datatype, dependency, sparse_data;
-    int64_t             n_values, codec_id, first_frame_with_data, stride_length, curr_n_frames;
-    int64_t             num_first_particle, block_n_particles;
-    double              multiplier;
-    md5_state_t         md5_state;
-    int                 found = TNG_FALSE;
+    tng_gen_block_t       block;
+    tng_function_status   stat;
+    char                  datatype, dependency, sparse_data;
+    int64_t               n_values, codec_id, first_frame_with_data, stride_length, curr_n_frames;
+    int64_t               num_first_particle, block_n_particles;
+    double                multiplier;
+    struct tng_hash_state hash_state;
+    int                   found = TNG_FALSE;
 
     TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
 
@@ -12318,7 +17112,7 @@ tng_function_status DECLSPECDLLEXPORT tng_frame_set_n_frames_of_data_block_get(s
      * set. */
     if (stat != TNG_SUCCESS)
     {
-        fseeko(tng_data->input_file, tng_data->current_trajectory_frame_set_input_file_pos, SEEK_SET);
+        tng_input_file_seek(tng_data, tng_data->current_trajectory_frame_set_input_file_pos, SEEK_SET);
         stat = tng_block_header_read(tng_data, block);
         if (stat != TNG_SUCCESS)
         {
@@ -12343,7 +17137,7 @@ tng_function_status DECLSPECDLLEXPORT tng_frame_set_n_frames_of_data_block_get(s
             stat = tng_data_block_meta_information_read(
                     tng_data, &datatype, &dependency, &sparse_data, &n_values, &codec_id,
                     &first_frame_with_data, &stride_length, &curr_n_frames, &num_first_particle,
-                    &block_n_particles, &multiplier, TNG_SKIP_HASH, &md5_state);
+                    &block_n_particles, &multiplier, TNG_SKIP_HASH, &hash_state);
             if (stat == TNG_SUCCESS)
             {
                 found = TNG_TRUE;
@@ -12351,7 +17145,7 @@ tng_function_status DECLSPECDLLEXPORT tng_frame_set_n_frames_of_data_block_get(s
         }
         else
         {
-            fseeko(tng_data->input_file, block->block_contents_size, SEEK_CUR);
+            tng_input_file_seek(tng_data, block->block_contents_size, SEEK_CUR);
             stat = tng_block_header_read(tng_data, block);
         }
     }
@@ -12384,7 +17178,7 @@ static tng_function_status tng_frame_gen_data_write(struct tng_trajectory* tng_d
     int64_t                    output_file_len, n_values_per_frame, size, contents_size;
     int64_t                    header_size, temp_first, temp_last;
     int64_t                    mapping_block_end_pos, num_first_particle, block_n_particles;
-    int64_t                    i, last_frame, temp_current, write_n_particles;
+    int64_t                    last_frame, temp_current, write_n_particles;
     tng_gen_block_t            block;
     tng_trajectory_frame_set_t frame_set;
     FILE*                      temp = tng_data->input_file;
@@ -12394,6 +17188,12 @@ static tng_function_status tng_frame_gen_data_write(struct tng_trajectory* tng_d
     char                       dependency, sparse_data, datatype;
     void*                      copy;
 
+    stat = tng_write_behind_finish(tng_data);
+    if (stat != TNG_SUCCESS)
+    {
+        return (stat);
+    }
+
     if (tng_output_file_init(tng_data) != TNG_SUCCESS)
     {
         fprintf(stderr, "TNG library: Cannot initialise destination file. %s: %d\n", __FILE__, __LINE__);
@@ -12762,13 +17562,12 @@ static tng_function_status tng_frame_gen_data_write(struct tng_trajectory* tng_d
         && tng_data->output_endianness_swap_func_64)
     {
         copy = (char*)malloc(write_n_particles * n_values_per_frame * size);
-        memcpy(copy, values, write_n_particles * n_values_per_frame * size);
-        for (i = 0; i < write_n_particles * n_values_per_frame; i++)
+        if (tng_swap_byte_order_copy_64(tng_data, tng_data->output_endianness_swap_func_64,
+                                        (char*)copy, (const char*)values,
+                                        write_n_particles * n_values_per_frame)
+            != TNG_SUCCESS)
         {
-            if (tng_data->output_endianness_swap_func_64(tng_data, (uint64_t*)copy + i) != TNG_SUCCESS)
-            {
-                fprintf(stderr, "TNG library: Cannot swap byte order. %s: %d\n", __FILE__, __LINE__);
-            }
+            fprintf(stderr, "TNG library: Cannot swap byte order. %s: %d\n", __FILE__, __LINE__);
         }
         fwrite(copy, write_n_particles * n_values_per_frame, size, tng_data->output_file);
         free(copy);
@@ -12776,13 +17575,12 @@ static tng_function_status tng_frame_gen_data_write(struct tng_trajectory* tng_d
     else if (data.datatype == TNG_FLOAT_DATA && tng_data->output_endianness_swap_func_32)
     {
         copy = (char*)malloc(write_n_particles * n_values_per_frame * size);
-        memcpy(copy, values, write_n_particles * n_values_per_frame * size);
-        for (i = 0; i < write_n_particles * n_values_per_frame; i++)
+        if (tng_swap_byte_order_copy_32(tng_data, tng_data->output_endianness_swap_func_32,
+                                        (char*)copy, (const char*)values,
+                                        write_n_particles * n_values_per_frame)
+            != TNG_SUCCESS)
         {
-            if (tng_data->output_endianness_swap_func_32(tng_data, (uint32_t*)copy + i) != TNG_SUCCESS)
-            {
-                fprintf(stderr, "TNG library: Cannot swap byte order. %s: %d\n", __FILE__, __LINE__);
-            }
+            fprintf(stderr, "TNG library: Cannot swap byte order. %s: %d\n", __FILE__, __LINE__);
         }
         fwrite(copy, write_n_particles * n_values_per_frame, size, tng_data->output_file);
         free(copy);
@@ -12805,7 +17603,7 @@ static tng_function_status tng_frame_gen_data_write(struct tng_trajectory* tng_d
     if (hash_mode == TNG_USE_HASH
         && (frame_nr + data.stride_length - data.first_frame_with_data) >= frame_set->n_frames)
     {
-        tng_md5_hash_update(tng_data, block, header_pos, header_pos + header_size);
+        tng_block_hash_update(tng_data, block, header_pos, header_pos + header_size);
     }
 
     tng_block_destroy(&block);
@@ -12850,6 +17648,18 @@ tng_function_status DECLSPECDLLEXPORT tng_frame_particle_data_write(struct tng_t
                                      val_n_particles, values, hash_mode));
 }
 
+/**
+ * @brief Allocate a 2D array of data values. The rows point into one contiguous
+ * block of values, so that the whole array only takes two allocations.
+ * @param tng_data is a trajectory data container.
+ * @param values is a pointer to the array to allocate. If it is already allocated
+ * it will be freed first.
+ * @param n_frames is the number of frames (rows) of the array.
+ * @param n_values_per_frame is the number of values per frame.
+ * @param type is the data type of the values.
+ * @return TNG_SUCCESS (0) if successful, TNG_FAILURE (1) if the dimensions are
+ * invalid or TNG_CRITICAL (2) if a major error has occured.
+ */
 static tng_function_status tng_data_values_alloc(struct tng_trajectory* tng_data,
                                                  union data_values***   values,
                                                  const int64_t          n_frames,
@@ -12879,17 +17689,18 @@ static tng_function_status tng_data_values_alloc(struct tng_trajectory* tng_data
         fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
         return (TNG_CRITICAL);
     }
+    (*values)[0] = (union data_values*)calloc(n_frames * n_values_per_frame, sizeof(union data_values));
+    if (!(*values)[0])
+    {
+        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+        free(*values);
+        *values = 0;
+        return (TNG_CRITICAL);
+    }
 
-    for (i = 0; i < n_frames; i++)
+    for (i = 1; i < n_frames; i++)
     {
-        (*values)[i] = (union data_values*)malloc(sizeof(union data_values) * n_values_per_frame);
-        if (!(*values)[i])
-        {
-            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
-            free(values);
-            values = 0;
-            return (TNG_CRITICAL);
-        }
+        (*values)[i] = (*values)[0] + i * n_values_per_frame;
     }
     return (TNG_SUCCESS);
 }
@@ -12901,11 +17712,22 @@ tng_function_status DECLSPECDLLEXPORT tng_data_values_free(struct tng_trajectory
                                                            const int64_t n_values_per_frame,
                                                            const char    type)
 {
-    int64_t i, j;
+    int64_t  i, j;
+    tng_bool is_contiguous;
     (void)tng_data;
 
     if (values)
     {
+        /* Arrays allocated by the library keep all values in one block. Arrays
+         * built by the caller may have one allocation per frame. */
+        is_contiguous = values[0] ? TNG_TRUE : TNG_FALSE;
+        for (i = 1; i < n_frames && is_contiguous; i++)
+        {
+            if (values[i] != values[0] + i * n_values_per_frame)
+            {
+                is_contiguous = TNG_FALSE;
+            }
+        }
         for (i = 0; i < n_frames; i++)
         {
             if (values[i])
@@ -12921,10 +17743,17 @@ tng_function_status DECLSPECDLLEXPORT tng_data_values_free(struct tng_trajectory
                         }
                     }
                 }
-                free(values[i]);
-                values[i] = 0;
+                if (!is_contiguous)
+                {
+                    free(values[i]);
+                    values[i] = 0;
+                }
             }
         }
+        if (is_contiguous)
+        {
+            free(values[0]);
+        }
         free(values);
         values = 0;
     }
@@ -12932,6 +17761,19 @@ tng_function_status DECLSPECDLLEXPORT tng_data_values_free(struct tng_trajectory
     return (TNG_SUCCESS);
 }
 
+/**
+ * @brief Allocate a 3D array of data values. The frames and particles point
+ * into contiguous blocks, so that the whole array only takes three allocations.
+ * @param tng_data is a trajectory data container.
+ * @param values is a pointer to the array to allocate. If it is already allocated
+ * it will be freed first.
+ * @param n_frames is the number of frames of the array.
+ * @param n_particles is the number of particles of the array.
+ * @param n_values_per_frame is the number of values per frame and particle.
+ * @param type is the data type of the values.
+ * @return TNG_SUCCESS (0) if successful, TNG_FAILURE (1) if the dimensions are
+ * invalid or TNG_CRITICAL (2) if a major error has occured.
+ */
 static tng_function_status tng_particle_data_values_alloc(struct tng_trajectory* tng_data,
                                                           union data_values****  values,
                                                           const int64_t          n_frames,
@@ -12939,10 +17781,10 @@ static tng_function_status tng_particle_data_values_alloc(struct tng_trajectory*
                                                           const int64_t          n_values_per_frame,
                                                           const char             type)
 {
-    int64_t             i, j;
+    int64_t             i;
     tng_function_status stat;
 
-    if (n_particles == 0 || n_values_per_frame == 0)
+    if (n_frames <= 0 || n_particles <= 0 || n_values_per_frame <= 0)
     {
         return (TNG_FAILURE);
     }
@@ -12963,29 +17805,32 @@ static tng_function_status tng_particle_data_values_alloc(struct tng_trajectory*
         fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
         return (TNG_CRITICAL);
     }
+    (*values)[0] = (union data_values**)malloc(sizeof(union data_values*) * n_frames * n_particles);
+    if (!(*values)[0])
+    {
+        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+        free(*values);
+        *values = 0;
+        return (TNG_CRITICAL);
+    }
+    (*values)[0][0] = (union data_values*)calloc(n_frames * n_particles * n_values_per_frame,
+                                                 sizeof(union data_values));
+    if (!(*values)[0][0])
+    {
+        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+        free((*values)[0]);
+        free(*values);
+        *values = 0;
+        return (TNG_CRITICAL);
+    }
 
-    for (i = 0; i < n_frames; i++)
+    for (i = 1; i < n_frames; i++)
     {
-        (*values)[i] = (union data_values**)malloc(sizeof(union data_values*) * n_particles);
-        if (!(*values)[i])
-        {
-            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
-            free(*values);
-            *values = 0;
-            return (TNG_CRITICAL);
-        }
-        for (j = 0; j < n_particles; j++)
-        {
-            (*values)[i][j] = (union data_values*)malloc(sizeof(union data_values) * n_values_per_frame);
-            if (!(*values)[i][j])
-            {
-                fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
-                tng_particle_data_values_free(tng_data, *values, n_frames, n_particles,
-                                              n_values_per_frame, type);
-                *values = 0;
-                return (TNG_CRITICAL);
-            }
-        }
+        (*values)[i] = (*values)[0] + i * n_particles;
+    }
+    for (i = 1; i < n_frames * n_particles; i++)
+    {
+        (*values)[0][i] = (*values)[0][0] + i * n_values_per_frame;
     }
     return (TNG_SUCCESS);
 }
@@ -12998,18 +17843,37 @@ tng_function_status DECLSPECDLLEXPORT tng_particle_data_values_free(struct tng_t
                                                                     const int64_t n_values_per_frame,
                                                                     const char    type)
 {
-    int64_t i, j, k;
+    int64_t  i, j, k;
+    tng_bool is_contiguous;
     (void)tng_data;
 
     if (values)
     {
+        /* Arrays allocated by the library keep all frames, particles and values
+         * in one block each. Arrays built by the caller may have one allocation
+         * per frame and particle. */
+        is_contiguous = values[0] && values[0][0] ? TNG_TRUE : TNG_FALSE;
+        for (i = 1; i < n_frames && is_contiguous; i++)
+        {
+            if (values[i] != values[0] + i * n_particles)
+            {
+                is_contiguous = TNG_FALSE;
+            }
+        }
+        for (i = 1; i < n_frames * n_particles && is_contiguous; i++)
+        {
+            if (values[0][i] != values[0][0] + i * n_values_per_frame)
+            {
+                is_contiguous = TNG_FALSE;
+            }
+        }
         for (i = 0; i < n_frames; i++)
         {
             if (values[i])
             {
                 for (j = 0; j < n_particles; j++)
                 {
-                    if (type == TNG_CHAR_DATA)
+                    if (type == TNG_CHAR_DATA && values[i][j])
                     {
                         for (k = 0; k < n_values_per_frame; k++)
                         {
@@ -13020,13 +17884,24 @@ tng_function_status DECLSPECDLLEXPORT tng_particle_data_values_free(struct tng_t
                             }
                         }
                     }
-                    free(values[i][j]);
-                    values[i][j] = 0;
+                    if (!is_contiguous)
+                    {
+                        free(values[i][j]);
+                        values[i][j] = 0;
+                    }
+                }
+                if (!is_contiguous)
+                {
+                    free(values[i]);
+                    values[i] = 0;
                 }
-                free(values[i]);
-                values[i] = 0;
             }
         }
+        if (is_contiguous)
+        {
+            free(values[0][0]);
+            free(values[0]);
+        }
         free(values);
         values = 0;
     }
@@ -13034,18 +17909,34 @@ tng_function_status DECLSPECDLLEXPORT tng_particle_data_values_free(struct tng_t
     return (TNG_SUCCESS);
 }
 
-static tng_function_status tng_gen_data_get(struct tng_trajectory* tng_data,
-                                            const int64_t          block_id,
-                                            const tng_bool         is_particle_data,
-                                            union data_values****  values,
-                                            int64_t*               n_frames,
-                                            int64_t*               n_particles,
-                                            int64_t*               n_values_per_frame,
-                                            char*                  type)
+/**
+ * @brief Find a data block of the current frame set, reading the rest of the
+ * frame set if it is not read yet, and get its dimensions.
+ * @param tng_data is a trajectory data container.
+ * @param block_id is the ID number of the data block.
+ * @param is_particle_data is a flag to specify if the data is particle dependent or not.
+ * @param data_p will be pointing to the data block.
+ * @param n_frames is set to the number of frames covered by the data.
+ * @param stride_length is set to the stride length of the data.
+ * @param n_particles is set to the number of particles of the data. Only used if
+ * is_particle_data is TNG_TRUE.
+ * @param n_values_per_frame is set to the number of values per frame of the data.
+ * @param type is set to the data type of the data.
+ * @return TNG_SUCCESS (0) if successful, TNG_FAILURE (1) if a minor error
+ * has occurred (e.g. the data block is not found) or TNG_CRITICAL (2) if a
+ * major error has occured.
+ */
+static tng_function_status tng_gen_data_block_find(struct tng_trajectory* tng_data,
+                                                   const int64_t          block_id,
+                                                   const tng_bool         is_particle_data,
+                                                   tng_data_t*            data_p,
+                                                   int64_t*               n_frames,
+                                                   int64_t*               stride_length,
+                                                   int64_t*               n_particles,
+                                                   int64_t*               n_values_per_frame,
+                                                   char*                  type)
 {
-    int64_t                    i, j, k, mapping, file_pos, i_step, block_index;
-    int                        size;
-    size_t                     len;
+    int64_t                    i, file_pos, block_index;
     tng_data_t                 data;
     tng_trajectory_frame_set_t frame_set;
     tng_gen_block_t            block;
@@ -13066,19 +17957,10 @@ static tng_function_status tng_gen_data_get(struct tng_trajectory* tng_data,
         stat = tng_data_find(tng_data, block_id, &data);
     }
 
-    if (tng_data->current_trajectory_frame_set_input_file_pos > 0)
-    {
-        block_type_flag = TNG_TRAJECTORY_BLOCK;
-    }
-    else
-    {
-        block_type_flag = TNG_NON_TRAJECTORY_BLOCK;
-    }
-
     if (stat != TNG_SUCCESS)
     {
         tng_block_init(&block);
-        file_pos = ftello(tng_data->input_file);
+        file_pos = tng_input_file_tell(tng_data);
         /* Read all blocks until next frame set block */
         stat = tng_block_header_read(tng_data, block);
         while (file_pos < tng_data->input_file_len && stat != TNG_CRITICAL
@@ -13088,7 +17970,7 @@ static tng_function_status tng_gen_data_get(struct tng_trajectory* tng_data,
             stat = tng_block_read_next(tng_data, block, TNG_USE_HASH);
             if (stat != TNG_CRITICAL)
             {
-                file_pos = ftello(tng_data->input_file);
+                file_pos = tng_input_file_tell(tng_data);
                 if (file_pos < tng_data->input_file_len)
                 {
                     stat = tng_block_header_read(tng_data, block);
@@ -13110,8 +17992,7 @@ static tng_function_status tng_gen_data_get(struct tng_trajectory* tng_data,
                 data = &frame_set->tr_particle_data[i];
                 if (data->block_id == block_id)
                 {
-                    block_index     = i;
-                    block_type_flag = TNG_TRAJECTORY_BLOCK;
+                    block_index = i;
                     break;
                 }
             }
@@ -13134,24 +18015,132 @@ static tng_function_status tng_gen_data_get(struct tng_trajectory* tng_data,
         }
     }
 
-    if (is_particle_data == TNG_TRUE)
+    if (is_particle_data == TNG_TRUE)
+    {
+        if (tng_data->current_trajectory_frame_set_input_file_pos > 0)
+        {
+            block_type_flag = TNG_TRAJECTORY_BLOCK;
+        }
+        else
+        {
+            block_type_flag = TNG_NON_TRAJECTORY_BLOCK;
+        }
+
+        if (block_type_flag == TNG_TRAJECTORY_BLOCK && tng_data->var_num_atoms_flag)
+        {
+            *n_particles = frame_set->n_particles;
+        }
+        else
+        {
+            *n_particles = tng_data->n_particles;
+        }
+    }
+
+    *type               = data->datatype;
+    *n_frames           = tng_max_i64(1, data->n_frames);
+    *n_values_per_frame = data->n_values_per_frame;
+    *stride_length      = data->stride_length;
+
+    *data_p = data;
+
+    return (TNG_SUCCESS);
+}
+
+/**
+ * @brief Get the size (in bytes) of one frame of particle data, or of one
+ * frame of non-particle data, of a numerical data block.
+ * @param data is the data block.
+ * @param n_particles is the number of particles of the data, 1 if the data is
+ * not particle dependent.
+ * @return the size of one frame of data.
+ */
+static int64_t tng_data_frame_size_get(const struct tng_data* data, const int64_t n_particles)
+{
+    int64_t size;
+
+    switch (data->datatype)
+    {
+        case TNG_INT_DATA: size = sizeof(int64_t); break;
+        case TNG_FLOAT_DATA: size = sizeof(float); break;
+        case TNG_CHAR_DATA:
+        case TNG_DOUBLE_DATA:
+        default: size = sizeof(double);
+    }
+
+    return (size * data->n_values_per_frame * n_particles);
+}
+
+/**
+ * @brief Copy numerical values into an array of data_values unions.
+ * @param dest is the array of unions to fill.
+ * @param src is the array of values to copy.
+ * @param type is the data type of the values in src.
+ * @param n_values is the number of values to copy.
+ */
+static void tng_data_values_union_copy(union data_values* dest,
+                                       const void*        src,
+                                       const char         type,
+                                       const int64_t      n_values)
+{
+    int64_t i;
+
+    switch (type)
+    {
+        case TNG_INT_DATA:
+            for (i = 0; i < n_values; i++)
+            {
+                dest[i].i = ((const int64_t*)src)[i];
+            }
+            break;
+        case TNG_FLOAT_DATA:
+            for (i = 0; i < n_values; i++)
+            {
+                dest[i].f = ((const float*)src)[i];
+            }
+            break;
+        case TNG_DOUBLE_DATA:
+        default:
+            for (i = 0; i < n_values; i++)
+            {
+                dest[i].d = ((const double*)src)[i];
+            }
+    }
+}
+
+static tng_function_status tng_gen_data_get(struct tng_trajectory* tng_data,
+                                            const int64_t          block_id,
+                                            const tng_bool         is_particle_data,
+                                            union data_values****  values,
+                                            int64_t*               n_frames,
+                                            int64_t*               n_particles,
+                                            int64_t*               n_values_per_frame,
+                                            char*                  type)
+{
+    int64_t                    i, j, k, mapping, stride_length, n_frames_div, n_frame_particles;
+    int64_t                    frame_size, particle_size;
+    size_t                     len;
+    const char*                str;
+    tng_data_t                 data;
+    tng_trajectory_frame_set_t frame_set;
+    union data_values**        frame_values;
+    tng_function_status        stat;
+
+    frame_set = &tng_data->current_trajectory_frame_set;
+
+    stat = tng_gen_data_block_find(tng_data, block_id, is_particle_data, &data, n_frames,
+                                   &stride_length, n_particles, n_values_per_frame, type);
+    if (stat != TNG_SUCCESS)
     {
-        if (block_type_flag == TNG_TRAJECTORY_BLOCK && tng_data->var_num_atoms_flag)
-        {
-            *n_particles = frame_set->n_particles;
-        }
-        else
-        {
-            *n_particles = tng_data->n_particles;
-        }
+        return (stat);
     }
 
-    *n_frames           = tng_max_i64(1, data->n_frames);
-    *n_values_per_frame = data->n_values_per_frame;
-    *type               = data->datatype;
+    /* Only every stride_length frame is stored, so only those frames are returned. */
+    n_frames_div = (*n_frames - 1) / stride_length + 1;
+    *n_frames    = n_frames_div;
 
     if (is_particle_data == TNG_TRUE)
     {
+        n_frame_particles = *n_particles;
         if (*values == 0)
         {
             if (tng_particle_data_values_alloc(tng_data, values, *n_frames, *n_particles,
@@ -13161,81 +18150,10 @@ static tng_function_status tng_gen_data_get(struct tng_trajectory* tng_data,
                 return (TNG_CRITICAL);
             }
         }
-
-        i_step = (*n_particles) * (*n_values_per_frame);
-
-        /* It's not very elegant to reuse so much of the code in the different case
-         * statements, but it's unnecessarily slow to have the switch-case block
-         * inside the for loops. */
-        switch (*type)
-        {
-            case TNG_CHAR_DATA:
-                for (i = 0; i < *n_frames; i++)
-                {
-                    for (j = 0; j < *n_particles; j++)
-                    {
-                        tng_particle_mapping_get_real_particle(frame_set, j, &mapping);
-                        for (k = 0; k < *n_values_per_frame; k++)
-                        {
-                            len                        = strlen(data->strings[i][j][k]) + 1;
-                            (*values)[i][mapping][k].c = (char*)malloc(len);
-                            strncpy((*values)[i][mapping][k].c, data->strings[i][j][k], len);
-                        }
-                    }
-                }
-                break;
-            case TNG_INT_DATA:
-                size = sizeof(int);
-                for (i = 0; i < *n_frames; i++)
-                {
-                    for (j = 0; j < *n_particles; j++)
-                    {
-                        tng_particle_mapping_get_real_particle(frame_set, j, &mapping);
-                        for (k = 0; k < *n_values_per_frame; k++)
-                        {
-                            (*values)[i][mapping][k].i =
-                                    *(int*)((char*)data->values
-                                            + size * (i * i_step + j * (*n_values_per_frame) + k));
-                        }
-                    }
-                }
-                break;
-            case TNG_FLOAT_DATA:
-                size = sizeof(float);
-                for (i = 0; i < *n_frames; i++)
-                {
-                    for (j = 0; j < *n_particles; j++)
-                    {
-                        tng_particle_mapping_get_real_particle(frame_set, j, &mapping);
-                        for (k = 0; k < *n_values_per_frame; k++)
-                        {
-                            (*values)[i][mapping][k].f =
-                                    *(float*)((char*)data->values
-                                              + size * (i * i_step + j * (*n_values_per_frame) + k));
-                        }
-                    }
-                }
-                break;
-            case TNG_DOUBLE_DATA:
-            default:
-                size = sizeof(double);
-                for (i = 0; i < *n_frames; i++)
-                {
-                    for (j = 0; j < *n_particles; j++)
-                    {
-                        tng_particle_mapping_get_real_particle(frame_set, j, &mapping);
-                        for (k = 0; k < *n_values_per_frame; k++)
-                        {
-                            (*values)[i][mapping][k].d =
-                                    *(double*)((char*)data->values
-                                               + size * (i * i_step + j * (*n_values_per_frame) + k));
-                        }
-                    }
-                }
-        }
     }
     else
     {
+        n_frame_particles = 1;
         if (*(values[0]) == 0)
         {
             if (tng_data_values_alloc(tng_data, values[0], *n_frames, *n_values_per_frame, *type) != TNG_SUCCESS)
@@ -13243,52 +18161,52 @@ static tng_function_status tng_gen_data_get(struct tng_trajectory* tng_data,
                 return (TNG_CRITICAL);
             }
         }
-        switch (*type)
+    }
+
+    if (*type == TNG_CHAR_DATA)
+    {
+        for (i = 0; i < n_frames_div; i++)
         {
-            case TNG_CHAR_DATA:
-                for (i = 0; i < *n_frames; i++)
-                {
-                    for (j = 0; j < *n_values_per_frame; j++)
-                    {
-                        len                  = strlen(data->strings[0][i][j]) + 1;
-                        (*values)[0][i][j].c = (char*)malloc(len);
-                        strncpy((*values)[0][i][j].c, data->strings[0][i][j], len);
-                    }
-                }
-                break;
-            case TNG_INT_DATA:
-                size = sizeof(int);
-                for (i = 0; i < *n_frames; i++)
+            frame_values = is_particle_data == TNG_TRUE ? (*values)[i] : &(*values)[0][i];
+            for (j = 0; j < n_frame_particles; j++)
+            {
+                mapping = 0;
+                if (is_particle_data == TNG_TRUE)
                 {
-                    for (j = 0; j < *n_values_per_frame; j++)
-                    {
-                        (*values)[0][i][j].i =
-                                *(int*)((char*)data->values + size * (i * (*n_values_per_frame) + j));
-                    }
+                    tng_particle_mapping_get_real_particle(frame_set, j, &mapping);
                 }
-                break;
-            case TNG_FLOAT_DATA:
-                size = sizeof(float);
-                for (i = 0; i < *n_frames; i++)
+                for (k = 0; k < *n_values_per_frame; k++)
                 {
-                    for (j = 0; j < *n_values_per_frame; j++)
+                    str = is_particle_data == TNG_TRUE ? data->strings[i][j][k] : data->strings[0][i][k];
+                    if (!str)
                     {
-                        (*values)[0][i][j].f =
-                                *(float*)((char*)data->values + size * (i * (*n_values_per_frame) + j));
+                        continue;
                     }
+                    len                        = strlen(str) + 1;
+                    frame_values[mapping][k].c = (char*)malloc(len);
+                    strncpy(frame_values[mapping][k].c, str, len);
                 }
-                break;
-            case TNG_DOUBLE_DATA:
-            default:
-                size = sizeof(double);
-                for (i = 0; i < *n_frames; i++)
+            }
+        }
+    }
+    else
+    {
+        frame_size    = tng_data_frame_size_get(data, n_frame_particles);
+        particle_size = frame_size / n_frame_particles;
+        for (i = 0; i < n_frames_div; i++)
+        {
+            frame_values = is_particle_data == TNG_TRUE ? (*values)[i] : &(*values)[0][i];
+            for (j = 0; j < n_frame_particles; j++)
+            {
+                mapping = 0;
+                if (is_particle_data == TNG_TRUE)
                 {
-                    for (j = 0; j < *n_values_per_frame; j++)
-                    {
-                        (*values)[0][i][j].d =
-                                *(double*)((char*)data->values + size * (i * (*n_values_per_frame) + j));
-                    }
+                    tng_particle_mapping_get_real_particle(frame_set, j, &mapping);
                 }
+                tng_data_values_union_copy(frame_values[mapping],
+                                           (char*)data->values + i * frame_size + j * particle_size,
+                                           *type, *n_values_per_frame);
+            }
         }
     }
 
@@ -13312,6 +18230,77 @@ tng_function_status DECLSPECDLLEXPORT tng_data_get(struct tng_trajectory* tng_da
     return (tng_gen_data_get(tng_data, block_id, TNG_FALSE, &values, n_frames, 0, n_values_per_frame, type));
 }
 
+/**
+ * @brief Find a numerical data block of the current frame set, reading the
+ * rest of the frame set if it is not read yet, and get its dimensions.
+ * @param tng_data is a trajectory data container.
+ * @param block_id is the ID number of the data block.
+ * @param is_particle_data is a flag to specify if the data is particle dependent or not.
+ * @param data_p will be pointing to the data block.
+ * @param n_frames is set to the number of frames covered by the data.
+ * @param stride_length is set to the stride length of the data.
+ * @param n_particles is set to the number of particles of the data. Only used if
+ * is_particle_data is TNG_TRUE.
+ * @param n_values_per_frame is set to the number of values per frame of the data.
+ * @param type is set to the data type of the data.
+ * @return TNG_SUCCESS (0) if successful, TNG_FAILURE (1) if a minor error
+ * has occurred (e.g. the data block is not found or does not contain numerical
+ * data) or TNG_CRITICAL (2) if a major error has occured.
+ */
+static tng_function_status tng_gen_data_vector_find(struct tng_trajectory* tng_data,
+                                                    const int64_t          block_id,
+                                                    const tng_bool         is_particle_data,
+                                                    tng_data_t*            data_p,
+                                                    int64_t*               n_frames,
+                                                    int64_t*               stride_length,
+                                                    int64_t*               n_particles,
+                                                    int64_t*               n_values_per_frame,
+                                                    char*                  type)
+{
+    tng_function_status stat;
+
+    stat = tng_gen_data_block_find(tng_data, block_id, is_particle_data, data_p, n_frames,
+                                   stride_length, n_particles, n_values_per_frame, type);
+    if (stat == TNG_SUCCESS && *type == TNG_CHAR_DATA)
+    {
+        return (TNG_FAILURE);
+    }
+
+    return (stat);
+}
+
+/**
+ * @brief Copy one frame of data, ordering the particles according to the
+ * particle mappings of a frame set.
+ * @param frame_set is the frame set with the particle mappings, or 0 if the
+ * data is not particle dependent.
+ * @param dest is the destination of the frame.
+ * @param src is the frame to copy, in the order of the particle mapping blocks.
+ * @param n_particles is the number of particles of the data, 1 if the data is
+ * not particle dependent.
+ * @param particle_size is the size (in bytes) of the data of one particle.
+ */
+static void tng_data_frame_values_copy(struct tng_trajectory_frame_set* frame_set,
+                                       void*                            dest,
+                                       const void*                      src,
+                                       const int64_t                    n_particles,
+                                       const int64_t                    particle_size)
+{
+    int64_t i, mapping;
+
+    if (!frame_set || frame_set->n_mapping_blocks <= 0)
+    {
+        memcpy(dest, src, n_particles * particle_size);
+        return;
+    }
+    for (i = 0; i < n_particles; i++)
+    {
+        tng_particle_mapping_get_real_particle(frame_set, i, &mapping);
+        memcpy((char*)dest + mapping * particle_size, (const char*)src + i * particle_size,
+               particle_size);
+    }
+}
+
 static tng_function_status tng_gen_data_vector_get(struct tng_trajectory* tng_data,
                                                    const int64_t          block_id,
                                                    const tng_bool         is_particle_data,
@@ -13322,501 +18311,488 @@ static tng_function_status tng_gen_data_vector_get(struct tng_trajectory* tng_da
                                                    int64_t*               n_values_per_frame,
                                                    char*                  type)
 {
-    int64_t                    i, j, mapping, file_pos, i_step, full_data_len, n_frames_div;
-    int64_t                    block_index;
-    int                        size;
+    int64_t                    i, n_frames_div, n_frame_particles, frame_size;
     tng_data_t                 data;
-    tng_trajectory_frame_set_t frame_set;
-    tng_gen_block_t            block;
+    tng_trajectory_frame_set_t frame_set = 0;
     void*                      temp;
-    char                       block_type_flag;
     tng_function_status        stat;
 
-    frame_set = &tng_data->current_trajectory_frame_set;
-
-    block_index = -1;
-    data        = 0;
+    stat = tng_gen_data_vector_find(tng_data, block_id, is_particle_data, &data, n_frames,
+                                    stride_length, n_particles, n_values_per_frame, type);
+    if (stat != TNG_SUCCESS)
+    {
+        return (stat);
+    }
 
+    n_frame_particles = 1;
     if (is_particle_data == TNG_TRUE)
     {
-        stat = tng_particle_data_find(tng_data, block_id, &data);
+        frame_set         = &tng_data->current_trajectory_frame_set;
+        n_frame_particles = *n_particles;
     }
-    else
+    n_frames_div = (*n_frames - 1) / *stride_length + 1;
+    frame_size   = tng_data_frame_size_get(data, n_frame_particles);
+
+    temp = (char*)realloc(*values, n_frames_div * frame_size);
+    if (!temp)
     {
-        stat = tng_data_find(tng_data, block_id, &data);
+        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+        free(*values);
+        *values = 0;
+        return (TNG_CRITICAL);
     }
 
-    if (stat != TNG_SUCCESS)
-    {
-        tng_block_init(&block);
-        file_pos = ftello(tng_data->input_file);
-        /* Read all blocks until next frame set block */
-        stat = tng_block_header_read(tng_data, block);
-        while (file_pos < tng_data->input_file_len && stat != TNG_CRITICAL
-               && block->id != TNG_TRAJECTORY_FRAME_SET && block->id != -1)
-        {
-            /* Use hash by default */
-            stat = tng_block_read_next(tng_data, block, TNG_USE_HASH);
-            if (stat != TNG_CRITICAL)
-            {
-                file_pos = ftello(tng_data->input_file);
-                if (file_pos < tng_data->input_file_len)
-                {
-                    stat = tng_block_header_read(tng_data, block);
-                }
-            }
-        }
-        tng_block_destroy(&block);
-        if (stat == TNG_CRITICAL)
-        {
-            fprintf(stderr, "TNG library: Cannot read block header at pos %" PRId64 ". %s: %d\n",
-                    file_pos, __FILE__, __LINE__);
-            return (stat);
-        }
+    *values = temp;
 
-        for (i = 0; i < frame_set->n_particle_data_blocks; i++)
-        {
-            data = &frame_set->tr_particle_data[i];
-            if (data->block_id == block_id)
-            {
-                block_index = i;
-                break;
-            }
-        }
-        if (block_index < 0)
-        {
-            return (TNG_FAILURE);
-        }
+    if (!frame_set || frame_set->n_mapping_blocks <= 0)
+    {
+        memcpy(*values, data->values, n_frames_div * frame_size);
     }
-
-    if (is_particle_data == TNG_TRUE)
+    else
     {
-        if (tng_data->current_trajectory_frame_set_input_file_pos > 0)
-        {
-            block_type_flag = TNG_TRAJECTORY_BLOCK;
-        }
-        else
-        {
-            block_type_flag = TNG_NON_TRAJECTORY_BLOCK;
-        }
-
-        if (block_type_flag == TNG_TRAJECTORY_BLOCK && tng_data->var_num_atoms_flag)
-        {
-            *n_particles = frame_set->n_particles;
-        }
-        else
+        for (i = 0; i < n_frames_div; i++)
         {
-            *n_particles = tng_data->n_particles;
+            tng_data_frame_values_copy(frame_set, (char*)*values + i * frame_size,
+                                       (const char*)data->values + i * frame_size,
+                                       n_frame_particles, frame_size / n_frame_particles);
         }
     }
 
-    *type = data->datatype;
+    data->last_retrieved_frame = data->first_frame_with_data + data->n_frames - 1;
 
-    switch (*type)
-    {
-        case TNG_CHAR_DATA: return (TNG_FAILURE);
-        case TNG_INT_DATA: size = sizeof(int64_t); break;
-        case TNG_FLOAT_DATA: size = sizeof(float); break;
-        case TNG_DOUBLE_DATA:
-        default: size = sizeof(double);
-    }
+    return (TNG_SUCCESS);
+}
 
-    *n_frames           = tng_max_i64(1, data->n_frames);
-    *n_values_per_frame = data->n_values_per_frame;
-    *stride_length      = data->stride_length;
+tng_function_status DECLSPECDLLEXPORT tng_data_vector_get(struct tng_trajectory* tng_data,
+                                                          const int64_t          block_id,
+                                                          void**                 values,
+                                                          int64_t*               n_frames,
+                                                          int64_t*               stride_length,
+                                                          int64_t*               n_values_per_frame,
+                                                          char*                  type)
+{
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(n_frames, "TNG library: n_frames must not be a NULL pointer.");
+    TNG_ASSERT(stride_length, "TNG library: stride_length must not be a NULL pointer.");
+    TNG_ASSERT(n_values_per_frame, "TNG library: n_values_per_frame must not be a NULL pointer.");
+    TNG_ASSERT(type, "TNG library: type must not be a NULL pointer.");
 
-    n_frames_div = (*n_frames - 1) / *stride_length + 1;
+    return (tng_gen_data_vector_get(tng_data, block_id, TNG_FALSE, values, n_frames, stride_length,
+                                    0, n_values_per_frame, type));
+}
 
-    full_data_len = n_frames_div * size * (*n_values_per_frame);
-    if (is_particle_data == TNG_TRUE)
+/**
+ * @brief Get the frames of a data block of one frame set, which are within an
+ * interval, and where they are stored in a data vector of the whole interval.
+ * @param data is the data block.
+ * @param n_frames_div is the number of frames (with data) in the interval vector.
+ * @param start_frame_nr is the first frame of the interval.
+ * @param end_frame_nr is the last frame of the interval.
+ * @param offset is set to the interval vector position of the first frame
+ * (with data) of the data block.
+ * @param first is set to the first frame (with data) of the data block within
+ * the interval.
+ * @param last is set to the last frame (with data) of the data block within
+ * the interval.
+ * @return TNG_TRUE if any frames of the data block are within the interval,
+ * otherwise TNG_FALSE.
+ */
+static tng_bool tng_data_interval_frames_get(const struct tng_data* data,
+                                             const int64_t          n_frames_div,
+                                             const int64_t          start_frame_nr,
+                                             const int64_t          end_frame_nr,
+                                             int64_t*               offset,
+                                             int64_t*               first,
+                                             int64_t*               last)
+{
+    int64_t stride_length, first_frame_with_data;
+
+    stride_length         = data->stride_length;
+    first_frame_with_data = data->first_frame_with_data;
+
+    /* A frame with data is stored at the interval position of the first frame it covers. */
+    *offset = first_frame_with_data - start_frame_nr;
+    if (*offset >= 0)
     {
-        full_data_len *= (*n_particles);
+        *offset = (*offset + stride_length - 1) / stride_length;
+    }
+    else
+    {
+        *offset = -(-*offset / stride_length);
     }
 
-    temp = (char*)realloc(*values, full_data_len);
-    if (!temp)
+    if (end_frame_nr < first_frame_with_data)
     {
-        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
-        free(*values);
-        *values = 0;
-        return (TNG_CRITICAL);
+        return (TNG_FALSE);
     }
+    *first = tng_max_i64(0, -*offset);
+    *last  = tng_min_i64((tng_max_i64(1, data->n_frames) - 1) / stride_length,
+                         tng_min_i64(n_frames_div - 1 - *offset,
+                                     (end_frame_nr - first_frame_with_data) / stride_length));
 
-    *values = temp;
+    return (*last < *first ? TNG_FALSE : TNG_TRUE);
+}
+
+/**
+ * @brief Copy the frames of a data block of one frame set, which are within an
+ * interval, to their positions in a data vector of the whole interval.
+ * @param frame_set is the frame set of the data block, whose particle mappings
+ * are used for ordering the particles, or 0 if the data is not particle dependent.
+ * @param data is the data block.
+ * @param n_particles is the number of particles of the data, 1 if the data is
+ * not particle dependent.
+ * @param values is the data vector of the interval.
+ * @param n_frames_div is the number of frames (with data) in the interval vector.
+ * @param frame_stride is the distance (in bytes) between the starts of two
+ * frames in the interval vector.
+ * @param start_frame_nr is the first frame of the interval.
+ * @param end_frame_nr is the last frame of the interval.
+ */
+static void tng_data_vector_interval_copy(struct tng_trajectory_frame_set* frame_set,
+                                          const struct tng_data*           data,
+                                          const int64_t                    n_particles,
+                                          void*                            values,
+                                          const int64_t                    n_frames_div,
+                                          const int64_t                    frame_stride,
+                                          const int64_t                    start_frame_nr,
+                                          const int64_t                    end_frame_nr)
+{
+    int64_t i, offset, first, last, frame_size;
 
-    if (is_particle_data != TNG_TRUE || frame_set->n_mapping_blocks <= 0)
+    if (!tng_data_interval_frames_get(data, n_frames_div, start_frame_nr, end_frame_nr, &offset,
+                                      &first, &last))
     {
-        memcpy(*values, data->values, full_data_len);
+        return;
     }
-    else
+    frame_size = tng_data_frame_size_get(data, n_particles);
+
+    if (frame_stride == frame_size && (!frame_set || frame_set->n_mapping_blocks <= 0))
+    {
+        memcpy((char*)values + (first + offset) * frame_size,
+               (const char*)data->values + first * frame_size, (last - first + 1) * frame_size);
+        return;
+    }
+    for (i = first; i <= last; i++)
+    {
+        tng_data_frame_values_copy(frame_set, (char*)values + (i + offset) * frame_stride,
+                                   (const char*)data->values + i * frame_size, n_particles,
+                                   frame_size / n_particles);
+    }
+}
+
+/**
+ * @brief Read the frame sets following the current frame set, up to the frame set
+ * containing end_frame_nr, and copy the data of a data block to an interval data vector.
+ * @param tng_data is a trajectory data container.
+ * @param block_id is the ID number of the block containing the data of interest.
+ * @param is_particle_data is a flag to specify if the data is particle dependent or not.
+ * @param start_frame_nr is the first frame of the interval.
+ * @param end_frame_nr is the last frame of the interval.
+ * @param hash_mode is an option to decide whether to use the md5 hash or not.
+ * @param values is the data vector of the interval.
+ * @param n_frames_div is the number of frames (with data) in the interval vector.
+ * @param frame_stride is the distance (in bytes) between the starts of two
+ * frames in the interval vector.
+ * @return TNG_SUCCESS (0) if successful, TNG_FAILURE (1) if a minor error
+ * has occurred or TNG_CRITICAL (2) if a major error has occured.
+ */
+static tng_function_status tng_gen_data_vector_interval_next_read(struct tng_trajectory* tng_data,
+                                                                  const int64_t          block_id,
+                                                                  const tng_bool         is_particle_data,
+                                                                  const int64_t          start_frame_nr,
+                                                                  const int64_t          end_frame_nr,
+                                                                  const char             hash_mode,
+                                                                  void*                  values,
+                                                                  const int64_t          n_frames_div,
+                                                                  const int64_t          frame_stride)
+{
+    int64_t                    n_frames, stride_length, n_particles = 1, n_values_per_frame;
+    char                       type;
+    tng_trajectory_frame_set_t frame_set = &tng_data->current_trajectory_frame_set;
+    tng_data_t                 data;
+    tng_function_status        stat = TNG_SUCCESS;
+
+    while (stat == TNG_SUCCESS && frame_set->first_frame + frame_set->n_frames <= end_frame_nr)
     {
-        i_step = (*n_particles) * (*n_values_per_frame);
-        for (i = 0; i < *n_frames; i++)
+        stat = tng_frame_set_read_next(tng_data, hash_mode);
+        if (stat != TNG_SUCCESS)
         {
-            for (j = 0; j < *n_particles; j++)
-            {
-                tng_particle_mapping_get_real_particle(frame_set, j, &mapping);
-                memcpy(((char*)*values) + size * (i * i_step + mapping * (*n_values_per_frame)),
-                       (char*)data->values + size * (i * i_step + j * (*n_values_per_frame)),
-                       size * (*n_values_per_frame));
-            }
+            break;
         }
-    }
-
-    data->last_retrieved_frame = data->first_frame_with_data + data->n_frames - 1;
 
-    return (TNG_SUCCESS);
-}
+        stat = tng_gen_data_vector_find(tng_data, block_id, is_particle_data, &data, &n_frames,
+                                        &stride_length, &n_particles, &n_values_per_frame, &type);
+        if (stat != TNG_SUCCESS)
+        {
+            break;
+        }
 
-tng_function_status DECLSPECDLLEXPORT tng_data_vector_get(struct tng_trajectory* tng_data,
-                                                          const int64_t          block_id,
-                                                          void**                 values,
-                                                          int64_t*               n_frames,
-                                                          int64_t*               stride_length,
-                                                          int64_t*               n_values_per_frame,
-                                                          char*                  type)
-{
-    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
-    TNG_ASSERT(n_frames, "TNG library: n_frames must not be a NULL pointer.");
-    TNG_ASSERT(stride_length, "TNG library: stride_length must not be a NULL pointer.");
-    TNG_ASSERT(n_values_per_frame, "TNG library: n_values_per_frame must not be a NULL pointer.");
-    TNG_ASSERT(type, "TNG library: type must not be a NULL pointer.");
+        tng_data_vector_interval_copy(is_particle_data ? frame_set : 0, data, n_particles, values,
+                                      n_frames_div, frame_stride, start_frame_nr, end_frame_nr);
+    }
 
-    return (tng_gen_data_vector_get(tng_data, block_id, TNG_FALSE, values, n_frames, stride_length,
-                                    0, n_values_per_frame, type));
+    return (stat);
 }
 
-static tng_function_status tng_gen_data_interval_get(struct tng_trajectory* tng_data,
-                                                     const int64_t          block_id,
-                                                     const tng_bool         is_particle_data,
-                                                     const int64_t          start_frame_nr,
-                                                     const int64_t          end_frame_nr,
-                                                     const char             hash_mode,
-                                                     union data_values****  values,
-                                                     int64_t*               n_particles,
-                                                     int64_t*               n_values_per_frame,
-                                                     char*                  type)
-{
-    int64_t                    i, j, k, mapping, n_frames, file_pos, current_frame_pos, i_step;
-    int64_t                    first_frame, block_index;
-    int                        size;
-    size_t                     len;
-    tng_data_t                 data;
-    tng_trajectory_frame_set_t frame_set;
-    tng_gen_block_t            block;
-    char                       block_type_flag;
-    tng_function_status        stat;
-
-    block_index = -1;
+#ifdef _OPENMP
+/**
+ * @brief Read one data block (and the particle mapping blocks) of the frame set
+ * at a given position and copy its data to an interval data vector.
+ * @param tng_data is a trajectory data container.
+ * @param file_pos is the position of the frame set in the input file.
+ * @param block_id is the ID number of the block containing the data of interest.
+ * @param is_particle_data is a flag to specify if the data is particle dependent or not.
+ * @param start_frame_nr is the first frame of the interval.
+ * @param end_frame_nr is the last frame of the interval.
+ * @param hash_mode is an option to decide whether to use the md5 hash or not.
+ * @param values is the data vector of the interval.
+ * @param n_frames_div is the number of frames (with data) in the interval vector.
+ * @param frame_stride is the distance (in bytes) between the starts of two
+ * frames in the interval vector.
+ * @return TNG_SUCCESS (0) if successful, TNG_FAILURE (1) if a minor error
+ * has occurred or TNG_CRITICAL (2) if a major error has occured.
+ */
+static tng_function_status tng_gen_data_vector_interval_frame_set_read(struct tng_trajectory* tng_data,
+                                                                       const int64_t          file_pos,
+                                                                       const int64_t          block_id,
+                                                                       const tng_bool is_particle_data,
+                                                                       const int64_t  start_frame_nr,
+                                                                       const int64_t  end_frame_nr,
+                                                                       const char     hash_mode,
+                                                                       void*          values,
+                                                                       const int64_t  n_frames_div,
+                                                                       const int64_t  frame_stride)
+{
+    int64_t             n_frames, stride_length, n_particles = 1, n_values_per_frame, curr_file_pos;
+    char                type;
+    tng_bool            found = TNG_FALSE;
+    tng_data_t          data;
+    tng_gen_block_t     block;
+    tng_function_status stat;
 
-    frame_set   = &tng_data->current_trajectory_frame_set;
-    first_frame = frame_set->first_frame;
+    tng_input_file_seek(tng_data, file_pos, SEEK_SET);
 
-    stat = tng_frame_set_of_frame_find(tng_data, start_frame_nr);
-    if (stat != TNG_SUCCESS)
+    tng_block_init(&block);
+    stat = tng_block_header_read(tng_data, block);
+    if (stat == TNG_CRITICAL || block->id != TNG_TRAJECTORY_FRAME_SET)
     {
-        return (stat);
+        fprintf(stderr, "TNG library: Cannot read block header at pos %" PRId64 ". %s: %d\n", file_pos,
+                __FILE__, __LINE__);
+        tng_block_destroy(&block);
+        return (TNG_CRITICAL);
     }
+    stat = tng_block_read_next(tng_data, block, hash_mode);
 
-    /* Do not re-read the frame set. */
-    if ((is_particle_data == TNG_TRUE
-         && (first_frame != frame_set->first_frame || frame_set->n_particle_data_blocks <= 0))
-        || (is_particle_data == TNG_FALSE
-            && (first_frame != frame_set->first_frame || frame_set->n_data_blocks <= 0)))
+    /* Read the requested data block and the particle mappings until the next frame set block. */
+    curr_file_pos = tng_input_file_tell(tng_data);
+    while (stat != TNG_CRITICAL && curr_file_pos < tng_data->input_file_len
+           && tng_block_header_read(tng_data, block) != TNG_CRITICAL
+           && block->id != TNG_TRAJECTORY_FRAME_SET && block->id != -1)
     {
-        tng_block_init(&block);
-        file_pos = ftello(tng_data->input_file);
-        /* Read all blocks until next frame set block */
-        stat = tng_block_header_read(tng_data, block);
-        while (file_pos < tng_data->input_file_len && stat != TNG_CRITICAL
-               && block->id != TNG_TRAJECTORY_FRAME_SET && block->id != -1)
+        if (block->id == block_id || block->id == TNG_PARTICLE_MAPPING)
         {
             stat = tng_block_read_next(tng_data, block, hash_mode);
-            if (stat != TNG_CRITICAL)
+            if (block->id == block_id && stat == TNG_SUCCESS)
             {
-                file_pos = ftello(tng_data->input_file);
-                if (file_pos < tng_data->input_file_len)
-                {
-                    stat = tng_block_header_read(tng_data, block);
-                }
+                found = TNG_TRUE;
             }
         }
-        tng_block_destroy(&block);
-        if (stat == TNG_CRITICAL)
+        else
         {
-            fprintf(stderr, "TNG library: Cannot read block header at pos %" PRId64 ". %s: %d\n",
-                    file_pos, __FILE__, __LINE__);
-            return (stat);
+            tng_input_file_seek(tng_data, block->block_contents_size, SEEK_CUR);
         }
+        curr_file_pos = tng_input_file_tell(tng_data);
     }
-
-    /* See if there is already a data block of this ID.
-     * Start checking the last read frame set */
-    if (is_particle_data == TNG_TRUE)
+    tng_block_destroy(&block);
+    if (stat == TNG_CRITICAL)
     {
-        for (i = frame_set->n_particle_data_blocks; i--;)
-        {
-            data = &frame_set->tr_particle_data[i];
-            if (data->block_id == block_id)
-            {
-                block_index     = i;
-                block_type_flag = TNG_TRAJECTORY_BLOCK;
-                break;
-            }
-        }
+        fprintf(stderr, "TNG library: Cannot read frame set at pos %" PRId64 ". %s: %d\n", file_pos,
+                __FILE__, __LINE__);
+        return (stat);
     }
-    else
+    /* There are no data of this block in this frame set. */
+    if (!found)
     {
-        for (i = 0; i < frame_set->n_data_blocks; i++)
-        {
-            data = &frame_set->tr_data[i];
-            if (data->block_id == block_id)
-            {
-                block_index = i;
-                break;
-            }
-        }
+        return (TNG_SUCCESS);
     }
 
-    if (block_index < 0)
+    stat = tng_gen_data_vector_find(tng_data, block_id, is_particle_data, &data, &n_frames,
+                                    &stride_length, &n_particles, &n_values_per_frame, &type);
+    if (stat == TNG_SUCCESS)
     {
-        fprintf(stderr,
-                "TNG library: Could not find particle data block with id %" PRId64 ". %s: %d\n",
-                block_id, __FILE__, __LINE__);
-        return (TNG_FAILURE);
+        tng_data_vector_interval_copy(is_particle_data ? &tng_data->current_trajectory_frame_set : 0,
+                                      data, n_particles, values, n_frames_div, frame_stride,
+                                      start_frame_nr, end_frame_nr);
     }
 
-    if (is_particle_data == TNG_TRUE)
+    return (stat);
+}
+
+/**
+ * @brief Read the frame sets following the current frame set, up to the frame set
+ * containing end_frame_nr, using tng_data->n_read_threads threads and copy the data
+ * of a data block to an interval data vector. Each thread reads its frame sets using
+ * a cursor, except for the last frame set, which is read by tng_data itself so that
+ * it is the current frame set afterwards, as when reading the frame sets in order.
+ * @param tng_data is a trajectory data container.
+ * @param block_id is the ID number of the block containing the data of interest.
+ * @param is_particle_data is a flag to specify if the data is particle dependent or not.
+ * @param start_frame_nr is the first frame of the interval.
+ * @param end_frame_nr is the last frame of the interval.
+ * @param hash_mode is an option to decide whether to use the md5 hash or not.
+ * @param values is the data vector of the interval.
+ * @param n_frames_div is the number of frames (with data) in the interval vector.
+ * @param frame_stride is the distance (in bytes) between the starts of two
+ * frames in the interval vector.
+ * @return TNG_SUCCESS (0) if successful, TNG_FAILURE (1) if a minor error
+ * has occurred or TNG_CRITICAL (2) if a major error has occured.
+ */
+static tng_function_status tng_gen_data_vector_interval_parallel_read(struct tng_trajectory* tng_data,
+                                                                      const int64_t          block_id,
+                                                                      const tng_bool is_particle_data,
+                                                                      const int64_t  start_frame_nr,
+                                                                      const int64_t  end_frame_nr,
+                                                                      const char     hash_mode,
+                                                                      void*          values,
+                                                                      const int64_t  n_frames_div,
+                                                                      const int64_t  frame_stride)
+{
+    int64_t                     i, nr, n_threads, n_positions = 0, n_allocated_positions = 0;
+    int64_t                     file_pos, *positions = 0, *temp;
+    tng_trajectory_t*           cursors;
+    tng_trajectory_frame_set_t  frame_set = &tng_data->current_trajectory_frame_set;
+    struct tng_frame_set_index* index     = &tng_data->input_frame_set_index;
+    tng_gen_block_t             block;
+    tng_function_status         stat = TNG_SUCCESS;
+
+    n_threads = tng_data->n_read_threads;
+    cursors   = (tng_trajectory_t*)calloc(n_threads, sizeof(tng_trajectory_t));
+    if (!cursors)
     {
-        if (block_type_flag == TNG_TRAJECTORY_BLOCK && tng_data->var_num_atoms_flag)
-        {
-            *n_particles = frame_set->n_particles;
-        }
-        else
+        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+        return (TNG_CRITICAL);
+    }
+    for (i = 0; i < n_threads && stat == TNG_SUCCESS; i++)
+    {
+        stat = tng_trajectory_cursor_init(tng_data, &cursors[i]);
+    }
+    /* Read the frame sets in order if they cannot be read from other threads. */
+    if (stat != TNG_SUCCESS)
+    {
+        for (i = 0; i < n_threads; i++)
         {
-            *n_particles = tng_data->n_particles;
+            tng_trajectory_destroy(&cursors[i]);
         }
+        free(cursors);
+        return (tng_gen_data_vector_interval_next_read(tng_data, block_id, is_particle_data, start_frame_nr,
+                                                       end_frame_nr, hash_mode, values, n_frames_div,
+                                                       frame_stride));
     }
 
-    n_frames            = end_frame_nr - start_frame_nr + 1;
-    *n_values_per_frame = data->n_values_per_frame;
-    *type               = data->datatype;
-
-    if (*values == 0)
+    /* List the positions of the frame sets to read, from the frame set index
+     * if there is one, otherwise by following the frame set pointers. */
+    if (tng_frame_set_index_input_find(tng_data) == TNG_SUCCESS
+        && tng_frame_set_index_frame_find(index, frame_set->first_frame, &nr) == TNG_SUCCESS)
     {
-        if (is_particle_data == TNG_TRUE)
+        n_allocated_positions = index->n_entries - nr;
+        positions             = (int64_t*)malloc(sizeof(int64_t) * n_allocated_positions);
+        if (!positions)
         {
-            if (tng_particle_data_values_alloc(tng_data, values, n_frames, *n_particles,
-                                               *n_values_per_frame, *type)
-                != TNG_SUCCESS)
-            {
-                return (TNG_CRITICAL);
-            }
+            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+            stat = TNG_CRITICAL;
         }
         else
         {
-            if (tng_data_values_alloc(tng_data, *values, n_frames, *n_values_per_frame, *type) != TNG_SUCCESS)
+            for (nr++; nr < index->n_entries && index->entries[nr].first_frame <= end_frame_nr; nr++)
             {
-                return (TNG_CRITICAL);
+                positions[n_positions++] = index->entries[nr].file_pos;
+            }
+            /* The interval ends after the last frame set. */
+            if (index->entries[nr - 1].first_frame + index->entries[nr - 1].n_frames <= end_frame_nr)
+            {
+                stat = TNG_FAILURE;
             }
         }
     }
-
-    current_frame_pos = start_frame_nr - frame_set->first_frame;
-
-    if (is_particle_data == TNG_TRUE)
-    {
-        i_step = (*n_particles) * (*n_values_per_frame);
-    }
     else
     {
-        i_step = (*n_values_per_frame);
-    }
-    /* It's not very elegant to reuse so much of the code in the different case
-     * statements, but it's unnecessarily slow to have the switch-case block
-     * inside the for loops. */
-    switch (*type)
-    {
-        case TNG_CHAR_DATA:
-            for (i = 0; i < n_frames; i++)
+        tng_block_init(&block);
+        while (stat == TNG_SUCCESS && frame_set->first_frame + frame_set->n_frames <= end_frame_nr)
+        {
+            file_pos = frame_set->next_frame_set_file_pos;
+            if (file_pos <= 0)
             {
-                if (current_frame_pos == frame_set->n_frames)
-                {
-                    stat = tng_frame_set_read_next(tng_data, hash_mode);
-                    if (stat != TNG_SUCCESS)
-                    {
-                        return (stat);
-                    }
-                    current_frame_pos = 0;
-                }
-                if (is_particle_data == TNG_TRUE)
-                {
-                    for (j = 0; j < *n_particles; j++)
-                    {
-                        tng_particle_mapping_get_real_particle(frame_set, j, &mapping);
-                        for (k = 0; k < *n_values_per_frame; k++)
-                        {
-                            len = strlen(data->strings[current_frame_pos][j][k]) + 1;
-                            (*values)[i][mapping][k].c = (char*)malloc(len);
-                            strncpy((*values)[i][mapping][k].c,
-                                    data->strings[current_frame_pos][j][k], len);
-                        }
-                    }
-                }
-                else
-                {
-                    for (j = 0; j < *n_values_per_frame; j++)
-                    {
-                        len                  = strlen(data->strings[0][current_frame_pos][j]) + 1;
-                        (*values)[0][i][j].c = (char*)malloc(len);
-                        strncpy((*values)[0][i][j].c, data->strings[0][current_frame_pos][j], len);
-                    }
-                }
-                current_frame_pos++;
+                stat = TNG_FAILURE;
+                break;
             }
-            break;
-        case TNG_INT_DATA:
-            size = sizeof(int);
-            for (i = 0; i < n_frames; i++)
+            if (n_positions == n_allocated_positions)
             {
-                if (current_frame_pos == frame_set->n_frames)
-                {
-                    stat = tng_frame_set_read_next(tng_data, hash_mode);
-                    if (stat != TNG_SUCCESS)
-                    {
-                        return (stat);
-                    }
-                    current_frame_pos = 0;
-                }
-                if (is_particle_data == TNG_TRUE)
-                {
-                    for (j = 0; j < *n_particles; j++)
-                    {
-                        tng_particle_mapping_get_real_particle(frame_set, j, &mapping);
-                        for (k = 0; k < *n_values_per_frame; k++)
-                        {
-                            (*values)[i][mapping][k].i =
-                                    *(int*)((char*)data->values
-                                            + size
-                                                      * (current_frame_pos * i_step
-                                                         + j * (*n_values_per_frame) + k));
-                        }
-                    }
-                    current_frame_pos++;
-                }
-                else
+                n_allocated_positions = n_allocated_positions ? n_allocated_positions * 2 : 64;
+                temp = (int64_t*)realloc(positions, sizeof(int64_t) * n_allocated_positions);
+                if (!temp)
                 {
-                    for (j = 0; j < *n_values_per_frame; j++)
-                    {
-                        (*values)[0][i][j].i =
-                                *(int*)((char*)data->values + size * (current_frame_pos * i_step + j));
-                    }
+                    fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+                    stat = TNG_CRITICAL;
+                    break;
                 }
+                positions = temp;
             }
-            break;
-        case TNG_FLOAT_DATA:
-            size = sizeof(float);
-            for (i = 0; i < n_frames; i++)
+            positions[n_positions++] = file_pos;
+
+            tng_input_file_seek(tng_data, file_pos, SEEK_SET);
+            stat = tng_block_header_read(tng_data, block);
+            if (stat == TNG_SUCCESS)
             {
-                if (current_frame_pos == frame_set->n_frames)
-                {
-                    stat = tng_frame_set_read_next(tng_data, hash_mode);
-                    if (stat != TNG_SUCCESS)
-                    {
-                        return (stat);
-                    }
-                    current_frame_pos = 0;
-                }
-                if (is_particle_data == TNG_TRUE)
-                {
-                    for (j = 0; j < *n_particles; j++)
-                    {
-                        tng_particle_mapping_get_real_particle(frame_set, j, &mapping);
-                        for (k = 0; k < *n_values_per_frame; k++)
-                        {
-                            (*values)[i][mapping][k].f =
-                                    *(float*)((char*)data->values
-                                              + size
-                                                        * (current_frame_pos * i_step
-                                                           + j * (*n_values_per_frame) + k));
-                        }
-                    }
-                }
-                else
-                {
-                    for (j = 0; j < *n_values_per_frame; j++)
-                    {
-                        (*values)[0][i][j].f =
-                                *(float*)((char*)data->values + size * (current_frame_pos * i_step + j));
-                    }
-                }
-                current_frame_pos++;
+                stat = block->id == TNG_TRAJECTORY_FRAME_SET ? tng_block_read_next(tng_data, block, hash_mode)
+                                                             : TNG_CRITICAL;
+            }
+        }
+        tng_block_destroy(&block);
+    }
+
+    if (stat == TNG_SUCCESS && n_positions > 0)
+    {
+        /* The last frame set is read first, by tng_data. */
+#    pragma omp parallel for num_threads(n_threads) schedule(dynamic, 1)
+        for (i = 0; i < n_positions; i++)
+        {
+            tng_function_status item_stat;
+            if (i == 0)
+            {
+                item_stat = tng_gen_data_vector_interval_frame_set_read(
+                        tng_data, positions[n_positions - 1], block_id, is_particle_data, start_frame_nr,
+                        end_frame_nr, hash_mode, values, n_frames_div, frame_stride);
             }
-            break;
-        case TNG_DOUBLE_DATA:
-        default:
-            size = sizeof(double);
-            for (i = 0; i < n_frames; i++)
+            else
             {
-                if (current_frame_pos == frame_set->n_frames)
-                {
-                    stat = tng_frame_set_read_next(tng_data, hash_mode);
-                    if (stat != TNG_SUCCESS)
-                    {
-                        return (stat);
-                    }
-                    current_frame_pos = 0;
-                }
-                if (is_particle_data == TNG_TRUE)
-                {
-                    for (j = 0; j < *n_particles; j++)
-                    {
-                        tng_particle_mapping_get_real_particle(frame_set, j, &mapping);
-                        for (k = 0; k < *n_values_per_frame; k++)
-                        {
-                            (*values)[i][mapping][k].d =
-                                    *(double*)((char*)data->values
-                                               + size
-                                                         * (current_frame_pos * i_step
-                                                            + j * (*n_values_per_frame) + k));
-                        }
-                    }
-                }
-                else
+                item_stat = tng_gen_data_vector_interval_frame_set_read(
+                        cursors[omp_get_thread_num()], positions[i - 1], block_id, is_particle_data,
+                        start_frame_nr, end_frame_nr, hash_mode, values, n_frames_div, frame_stride);
+            }
+            if (item_stat != TNG_SUCCESS)
+            {
+#    pragma omp critical(tng_read_stat)
+                if (item_stat > stat)
                 {
-                    for (j = 0; j < *n_values_per_frame; j++)
-                    {
-                        (*values)[0][i][j].d = *(double*)((char*)data->values
-                                                          + size * (current_frame_pos * i_step + j));
-                    }
+                    stat = item_stat;
                 }
-                current_frame_pos++;
             }
+        }
     }
 
-    data->last_retrieved_frame = end_frame_nr;
-
-    return (TNG_SUCCESS);
-}
-
-tng_function_status DECLSPECDLLEXPORT tng_data_interval_get(struct tng_trajectory* tng_data,
-                                                            const int64_t          block_id,
-                                                            const int64_t          start_frame_nr,
-                                                            const int64_t          end_frame_nr,
-                                                            const char             hash_mode,
-                                                            union data_values***   values,
-                                                            int64_t* n_values_per_frame,
-                                                            char*    type)
-{
-    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
-    TNG_ASSERT(start_frame_nr <= end_frame_nr,
-               "TNG library: start_frame_nr must not be higher than tne end_frame_nr.");
-    TNG_ASSERT(n_values_per_frame, "TNG library: n_values_per_frame must not be a NULL pointer.");
-    TNG_ASSERT(type, "TNG library: type must not be a NULL pointer.");
+    for (i = 0; i < n_threads; i++)
+    {
+        tng_trajectory_destroy(&cursors[i]);
+    }
+    free(cursors);
+    if (positions)
+    {
+        free(positions);
+    }
 
-    return (tng_gen_data_interval_get(tng_data, block_id, TNG_FALSE, start_frame_nr, end_frame_nr,
-                                      hash_mode, &values, 0, n_values_per_frame, type));
+    return (stat);
 }
+#endif
 
 static tng_function_status tng_gen_data_vector_interval_get(struct tng_trajectory* tng_data,
                                                             const int64_t          block_id,
@@ -13825,18 +18801,20 @@ static tng_function_status tng_gen_data_vector_interval_get(struct tng_trajector
                                                             const int64_t          end_frame_nr,
                                                             const char             hash_mode,
                                                             void**                 values,
+                                                            const int64_t          values_len,
+                                                            const int64_t          values_frame_stride,
+                                                            const char             values_type,
                                                             int64_t*               n_particles,
                                                             int64_t*               stride_length,
                                                             int64_t* n_values_per_frame,
                                                             char*    type)
 {
-    int64_t n_frames, tot_n_frames, n_frames_div, n_frames_div_2, first_frame;
-    int64_t file_pos, current_frame_pos, last_frame_pos, full_data_len, frame_size;
-    int     size;
-    tng_trajectory_frame_set_t frame_set;
+    int64_t n_frames, tot_n_frames, n_frames_div, first_frame, n_frame_particles;
+    int64_t file_pos, frame_size, frame_stride;
+    tng_trajectory_frame_set_t frame_set, mapping_frame_set;
     tng_data_t                 data;
     tng_gen_block_t            block;
-    void *                     current_values = 0, *temp;
+    void*                      temp;
     tng_function_status        stat;
 
     frame_set   = &tng_data->current_trajectory_frame_set;
@@ -13875,7 +18853,7 @@ static tng_function_status tng_gen_data_vector_interval_get(struct tng_trajector
         tng_block_init(&block);
         if (stat != TNG_SUCCESS)
         {
-            fseeko(tng_data->input_file, tng_data->current_trajectory_frame_set_input_file_pos, SEEK_SET);
+            tng_input_file_seek(tng_data, tng_data->current_trajectory_frame_set_input_file_pos, SEEK_SET);
             stat = tng_block_header_read(tng_data, block);
             if (stat != TNG_SUCCESS)
             {
@@ -13883,9 +18861,9 @@ static tng_function_status tng_gen_data_vector_interval_get(struct tng_trajector
                 return (stat);
             }
 
-            fseeko(tng_data->input_file, block->block_contents_size, SEEK_CUR);
+            tng_input_file_seek(tng_data, block->block_contents_size, SEEK_CUR);
         }
-        file_pos = ftello(tng_data->input_file);
+        file_pos = tng_input_file_tell(tng_data);
         /* Read until next frame set block */
         while (file_pos < tng_data->input_file_len && tng_block_header_read(tng_data, block) != TNG_CRITICAL
                && block->id != TNG_TRAJECTORY_FRAME_SET && block->id != -1)
@@ -13895,13 +18873,13 @@ static tng_function_status tng_gen_data_vector_interval_get(struct tng_trajector
                 stat = tng_block_read_next(tng_data, block, hash_mode);
                 if (stat != TNG_CRITICAL)
                 {
-                    file_pos = ftello(tng_data->input_file);
+                    file_pos = tng_input_file_tell(tng_data);
                 }
             }
             else
             {
                 file_pos += block->block_contents_size + block->header_contents_size;
-                fseeko(tng_data->input_file, block->block_contents_size, SEEK_CUR);
+                tng_input_file_seek(tng_data, block->block_contents_size, SEEK_CUR);
             }
         }
         tng_block_destroy(&block);
@@ -13925,15 +18903,11 @@ static tng_function_status tng_gen_data_vector_interval_get(struct tng_trajector
         return (stat);
     }
 
-    stat = tng_gen_data_vector_get(tng_data, block_id, is_particle_data, &current_values, &n_frames,
-                                   stride_length, n_particles, n_values_per_frame, type);
+    stat = tng_gen_data_vector_find(tng_data, block_id, is_particle_data, &data, &n_frames,
+                                    stride_length, n_particles, n_values_per_frame, type);
 
     if (stat != TNG_SUCCESS || (is_particle_data && *n_particles == 0))
     {
-        if (current_values)
-        {
-            free(current_values);
-        }
         return (stat);
     }
 
@@ -13954,139 +18928,310 @@ static tng_function_status tng_gen_data_vector_interval_get(struct tng_trajector
         return (TNG_FAILURE);
     }
 
-    switch (*type)
-    {
-        case TNG_CHAR_DATA: return (TNG_FAILURE);
-        case TNG_INT_DATA: size = sizeof(int64_t); break;
-        case TNG_FLOAT_DATA: size = sizeof(float); break;
-        case TNG_DOUBLE_DATA:
-        default: size = sizeof(double);
-    }
-
-    n_frames_div = (tot_n_frames - 1) / *stride_length + 1;
+    n_frames_div      = (tot_n_frames - 1) / *stride_length + 1;
+    n_frame_particles = is_particle_data ? *n_particles : 1;
+    frame_size        = tng_data_frame_size_get(data, n_frame_particles);
 
-    full_data_len = n_frames_div * size * (*n_values_per_frame);
-    if (is_particle_data)
+    if (values_len < 0)
     {
-        full_data_len *= (*n_particles);
-    }
+        frame_stride = frame_size;
+        temp         = (char*)realloc(*values, n_frames_div * frame_size);
+        if (!temp)
+        {
+            fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+            free(*values);
+            *values = 0;
+            return (TNG_CRITICAL);
+        }
 
-    temp = (char*)realloc(*values, full_data_len);
-    if (!temp)
+        *values = temp;
+    }
+    else
     {
-        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
-        free(*values);
-        *values = 0;
-        return (TNG_CRITICAL);
+        /* The data must fit in the array of the caller. */
+        frame_stride = values_frame_stride > 0 ? values_frame_stride : frame_size;
+        if ((values_type != TNG_CHAR_DATA && *type != values_type) || frame_stride < frame_size
+            || (n_frames_div - 1) * frame_stride + frame_size > values_len)
+        {
+            return (TNG_FAILURE);
+        }
     }
 
-    *values = temp;
+    /* The particles are ordered according to the particle mappings of the frame sets. */
+    mapping_frame_set = is_particle_data == TNG_TRUE ? frame_set : 0;
 
     if (n_frames == 1 && n_frames < frame_set->n_frames)
     {
-        if (is_particle_data)
+        tng_data_frame_values_copy(mapping_frame_set, *values, data->values, n_frame_particles,
+                                   frame_size / n_frame_particles);
+    }
+    else
+    {
+        tng_data_vector_interval_copy(mapping_frame_set, data, n_frame_particles, *values,
+                                      n_frames_div, frame_stride, start_frame_nr, end_frame_nr);
+
+#ifdef _OPENMP
+        if (tng_data->n_read_threads > 1 && tng_data->input_file != tng_data->output_file
+            && frame_set->first_frame + frame_set->n_frames <= end_frame_nr)
         {
-            memcpy(*values, current_values, size * (*n_particles) * (*n_values_per_frame));
+            stat = tng_gen_data_vector_interval_parallel_read(tng_data, block_id, is_particle_data,
+                                                              start_frame_nr, end_frame_nr, hash_mode,
+                                                              *values, n_frames_div, frame_stride);
         }
         else
+#endif
         {
-            memcpy(*values, current_values, size * (*n_values_per_frame));
+            stat = tng_gen_data_vector_interval_next_read(tng_data, block_id, is_particle_data,
+                                                          start_frame_nr, end_frame_nr, hash_mode,
+                                                          *values, n_frames_div, frame_stride);
+        }
+        if (stat != TNG_SUCCESS)
+        {
+            if (values_len < 0)
+            {
+                free(*values);
+                *values = 0;
+            }
+            return (stat);
         }
     }
+
+    /* *data may have been reinitialized/freed when reading frame sets. Re-find the correct data block. */
+    if (is_particle_data == TNG_TRUE)
+    {
+        stat = tng_particle_data_find(tng_data, block_id, &data);
+    }
     else
     {
-        current_frame_pos = start_frame_nr - frame_set->first_frame;
+        stat = tng_data_find(tng_data, block_id, &data);
+    }
+    if (stat != TNG_SUCCESS)
+    {
+        return (stat);
+    }
+
+    data->last_retrieved_frame = end_frame_nr;
+
+    return (TNG_SUCCESS);
+}
 
-        frame_size = size * (*n_values_per_frame);
-        if (is_particle_data)
-        {
-            frame_size *= (*n_particles);
-        }
 
-        last_frame_pos = tng_min_i64(n_frames - 1, end_frame_nr - start_frame_nr);
+static tng_function_status tng_gen_data_interval_get(struct tng_trajectory* tng_data,
+                                                     const int64_t          block_id,
+                                                     const tng_bool         is_particle_data,
+                                                     const int64_t          start_frame_nr,
+                                                     const int64_t          end_frame_nr,
+                                                     const char             hash_mode,
+                                                     union data_values****  values,
+                                                     int64_t*               n_particles,
+                                                     int64_t*               n_values_per_frame,
+                                                     char*                  type)
+{
+    int64_t                    i, j, k, mapping, n_frames, file_pos, current_frame_pos;
+    int64_t                    first_frame, block_index, n_frames_div, n_frame_particles;
+    int64_t                    stride_length, particle_size;
+    size_t                     len;
+    void*                      vector;
+    tng_data_t                 data;
+    tng_trajectory_frame_set_t frame_set;
+    tng_gen_block_t            block;
+    char                       block_type_flag;
+    tng_function_status        stat;
 
-        n_frames_div   = current_frame_pos / *stride_length;
-        n_frames_div_2 = last_frame_pos / *stride_length + 1;
+    block_index = -1;
 
-        memcpy(*values, (char*)current_values + n_frames_div * frame_size, n_frames_div_2 * frame_size);
+    frame_set   = &tng_data->current_trajectory_frame_set;
+    first_frame = frame_set->first_frame;
 
-        current_frame_pos += n_frames - current_frame_pos;
+    stat = tng_frame_set_of_frame_find(tng_data, start_frame_nr);
+    if (stat != TNG_SUCCESS)
+    {
+        return (stat);
+    }
 
-        while (current_frame_pos <= end_frame_nr - start_frame_nr)
+    /* Do not re-read the frame set. */
+    if ((is_particle_data == TNG_TRUE
+         && (first_frame != frame_set->first_frame || frame_set->n_particle_data_blocks <= 0))
+        || (is_particle_data == TNG_FALSE
+            && (first_frame != frame_set->first_frame || frame_set->n_data_blocks <= 0)))
+    {
+        tng_block_init(&block);
+        file_pos = tng_input_file_tell(tng_data);
+        /* Read all blocks until next frame set block */
+        stat = tng_block_header_read(tng_data, block);
+        while (file_pos < tng_data->input_file_len && stat != TNG_CRITICAL
+               && block->id != TNG_TRAJECTORY_FRAME_SET && block->id != -1)
         {
-            stat = tng_frame_set_read_next(tng_data, hash_mode);
-            if (stat != TNG_SUCCESS)
+            stat = tng_block_read_next(tng_data, block, hash_mode);
+            if (stat != TNG_CRITICAL)
             {
-                if (current_values)
+                file_pos = tng_input_file_tell(tng_data);
+                if (file_pos < tng_data->input_file_len)
                 {
-                    free(current_values);
+                    stat = tng_block_header_read(tng_data, block);
                 }
-                free(*values);
-                *values = 0;
-                return (stat);
             }
+        }
+        tng_block_destroy(&block);
+        if (stat == TNG_CRITICAL)
+        {
+            fprintf(stderr, "TNG library: Cannot read block header at pos %" PRId64 ". %s: %d\n",
+                    file_pos, __FILE__, __LINE__);
+            return (stat);
+        }
+    }
 
-            if (is_particle_data == TNG_TRUE)
+    /* See if there is already a data block of this ID.
+     * Start checking the last read frame set */
+    if (is_particle_data == TNG_TRUE)
+    {
+        for (i = frame_set->n_particle_data_blocks; i--;)
+        {
+            data = &frame_set->tr_particle_data[i];
+            if (data->block_id == block_id)
             {
-                stat = tng_particle_data_find(tng_data, block_id, &data);
+                block_index     = i;
+                block_type_flag = TNG_TRAJECTORY_BLOCK;
+                break;
             }
-            else
+        }
+    }
+    else
+    {
+        for (i = 0; i < frame_set->n_data_blocks; i++)
+        {
+            data = &frame_set->tr_data[i];
+            if (data->block_id == block_id)
+            {
+                block_index = i;
+                break;
+            }
+        }
+    }
+
+    if (block_index < 0)
+    {
+        fprintf(stderr,
+                "TNG library: Could not find particle data block with id %" PRId64 ". %s: %d\n",
+                block_id, __FILE__, __LINE__);
+        return (TNG_FAILURE);
+    }
+
+    if (is_particle_data == TNG_TRUE)
+    {
+        if (block_type_flag == TNG_TRAJECTORY_BLOCK && tng_data->var_num_atoms_flag)
+        {
+            *n_particles = frame_set->n_particles;
+        }
+        else
+        {
+            *n_particles = tng_data->n_particles;
+        }
+    }
+
+    n_frames            = end_frame_nr - start_frame_nr + 1;
+    *n_values_per_frame = data->n_values_per_frame;
+    *type               = data->datatype;
+
+    if (is_particle_data == TNG_TRUE)
+    {
+        if (*values == 0)
+        {
+            if (tng_particle_data_values_alloc(tng_data, values, n_frames, *n_particles,
+                                               *n_values_per_frame, *type)
+                != TNG_SUCCESS)
+            {
+                return (TNG_CRITICAL);
+            }
+        }
+    }
+    else
+    {
+        if (*(values[0]) == 0)
+        {
+            if (tng_data_values_alloc(tng_data, values[0], n_frames, *n_values_per_frame, *type) != TNG_SUCCESS)
+            {
+                return (TNG_CRITICAL);
+            }
+        }
+    }
+
+    if (*type != TNG_CHAR_DATA)
+    {
+        /* Numerical data is read as one contiguous vector, which is then copied
+         * to the values array. Only frames with data are included. */
+        n_frame_particles = is_particle_data == TNG_TRUE ? *n_particles : 1;
+        if (tng_max_i64(1, data->n_frames) == 1 && frame_set->n_frames > 1)
+        {
+            n_frames_div = 1;
+        }
+        else
+        {
+            n_frames_div = (n_frames - 1) / data->stride_length + 1;
+        }
+        vector = 0;
+        stat   = tng_gen_data_vector_interval_get(tng_data, block_id, is_particle_data, start_frame_nr,
+                                                end_frame_nr, hash_mode, &vector, -1, 0, TNG_CHAR_DATA,
+                                                n_particles, &stride_length, n_values_per_frame, type);
+        if (stat != TNG_SUCCESS)
+        {
+            if (vector)
             {
-                stat = tng_data_find(tng_data, block_id, &data);
+                free(vector);
             }
-            if (stat != TNG_SUCCESS)
+            return (stat);
+        }
+        particle_size = tng_data_frame_size_get(data, 1);
+        for (i = 0; i < n_frames_div; i++)
+        {
+            for (j = 0; j < n_frame_particles; j++)
             {
-                return (stat);
+                tng_data_values_union_copy(is_particle_data == TNG_TRUE ? (*values)[i][j] : (*values)[0][i],
+                                           (char*)vector + (i * n_frame_particles + j) * particle_size,
+                                           *type, *n_values_per_frame);
             }
-            stat = tng_gen_data_vector_get(tng_data, block_id, is_particle_data, &current_values, &n_frames,
-                                           stride_length, n_particles, n_values_per_frame, type);
+        }
+        free(vector);
+
+        return (TNG_SUCCESS);
+    }
+
+    current_frame_pos = start_frame_nr - frame_set->first_frame;
 
+    for (i = 0; i < n_frames; i++)
+    {
+        if (current_frame_pos == frame_set->n_frames)
+        {
+            stat = tng_frame_set_read_next(tng_data, hash_mode);
             if (stat != TNG_SUCCESS)
             {
-                if (current_values)
-                {
-                    free(current_values);
-                }
-                free(*values);
-                *values = 0;
                 return (stat);
             }
-
-            last_frame_pos = tng_min_i64(n_frames - 1, end_frame_nr - current_frame_pos);
-
-            if (current_frame_pos < data->first_frame_with_data)
+            current_frame_pos = 0;
+        }
+        if (is_particle_data == TNG_TRUE)
+        {
+            for (j = 0; j < *n_particles; j++)
             {
-                if (end_frame_nr >= data->first_frame_with_data)
+                tng_particle_mapping_get_real_particle(frame_set, j, &mapping);
+                for (k = 0; k < *n_values_per_frame; k++)
                 {
-                    current_frame_pos = data->first_frame_with_data;
+                    len = strlen(data->strings[current_frame_pos][j][k]) + 1;
+                    (*values)[i][mapping][k].c = (char*)malloc(len);
+                    strncpy((*values)[i][mapping][k].c, data->strings[current_frame_pos][j][k], len);
                 }
             }
-            n_frames_div   = current_frame_pos / *stride_length;
-            n_frames_div_2 = last_frame_pos / *stride_length + 1;
-
-            memcpy(((char*)*values) + n_frames_div * frame_size, current_values, n_frames_div_2 * frame_size);
-
-            current_frame_pos += n_frames * *stride_length;
         }
-    }
-
-    if (current_values)
-    {
-        free(current_values);
-    }
-
-    /* *data may have been reinitialized/freed when reading frame sets. Re-find the correct data block. */
-    if (is_particle_data == TNG_TRUE)
-    {
-        stat = tng_particle_data_find(tng_data, block_id, &data);
-    }
-    else
-    {
-        stat = tng_data_find(tng_data, block_id, &data);
-    }
-    if (stat != TNG_SUCCESS)
-    {
-        return (stat);
+        else
+        {
+            for (j = 0; j < *n_values_per_frame; j++)
+            {
+                len                  = strlen(data->strings[0][current_frame_pos][j]) + 1;
+                (*values)[0][i][j].c = (char*)malloc(len);
+                strncpy((*values)[0][i][j].c, data->strings[0][current_frame_pos][j], len);
+            }
+        }
+        current_frame_pos++;
     }
 
     data->last_retrieved_frame = end_frame_nr;
@@ -14094,6 +19239,24 @@ static tng_function_status tng_gen_data_vector_interval_get(struct tng_trajector
     return (TNG_SUCCESS);
 }
 
+tng_function_status DECLSPECDLLEXPORT tng_data_interval_get(struct tng_trajectory* tng_data,
+                                                            const int64_t          block_id,
+                                                            const int64_t          start_frame_nr,
+                                                            const int64_t          end_frame_nr,
+                                                            const char             hash_mode,
+                                                            union data_values***   values,
+                                                            int64_t* n_values_per_frame,
+                                                            char*    type)
+{
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(start_frame_nr <= end_frame_nr,
+               "TNG library: start_frame_nr must not be higher than tne end_frame_nr.");
+    TNG_ASSERT(n_values_per_frame, "TNG library: n_values_per_frame must not be a NULL pointer.");
+    TNG_ASSERT(type, "TNG library: type must not be a NULL pointer.");
+
+    return (tng_gen_data_interval_get(tng_data, block_id, TNG_FALSE, start_frame_nr, end_frame_nr,
+                                      hash_mode, &values, 0, n_values_per_frame, type));
+}
 
 tng_function_status DECLSPECDLLEXPORT tng_data_vector_interval_get(struct tng_trajectory* tng_data,
                                                                    const int64_t          block_id,
@@ -14113,8 +19276,8 @@ tng_function_status DECLSPECDLLEXPORT tng_data_vector_interval_get(struct tng_tr
     TNG_ASSERT(type, "TNG library: type must not be a NULL pointer.");
 
     return (tng_gen_data_vector_interval_get(tng_data, block_id, TNG_FALSE, start_frame_nr,
-                                             end_frame_nr, hash_mode, values, 0, stride_length,
-                                             n_values_per_frame, type));
+                                             end_frame_nr, hash_mode, values, -1, 0, TNG_CHAR_DATA,
+                                             0, stride_length, n_values_per_frame, type));
 }
 
 tng_function_status DECLSPECDLLEXPORT tng_particle_data_get(struct tng_trajectory* tng_data,
@@ -14195,7 +19358,37 @@ tng_function_status DECLSPECDLLEXPORT tng_particle_data_vector_interval_get(stru
     TNG_ASSERT(type, "TNG library: type must not be a NULL pointer.");
 
     return (tng_gen_data_vector_interval_get(tng_data, block_id, TNG_TRUE, start_frame_nr,
-                                             end_frame_nr, hash_mode, values, n_particles,
+                                             end_frame_nr, hash_mode, values, -1, 0, TNG_CHAR_DATA,
+                                             n_particles, stride_length, n_values_per_frame, type));
+}
+
+tng_function_status DECLSPECDLLEXPORT
+        tng_particle_data_vector_interval_get_into(struct tng_trajectory* tng_data,
+                                                   const int64_t          block_id,
+                                                   const int64_t          start_frame_nr,
+                                                   const int64_t          end_frame_nr,
+                                                   const char             hash_mode,
+                                                   void*                  values,
+                                                   const int64_t          values_len,
+                                                   const int64_t          frame_stride,
+                                                   int64_t*               n_particles,
+                                                   int64_t*               stride_length,
+                                                   int64_t*               n_values_per_frame,
+                                                   char*                  type)
+{
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(start_frame_nr <= end_frame_nr,
+               "TNG library: start_frame_nr must not be higher than tne end_frame_nr.");
+    TNG_ASSERT(values, "TNG library: values must not be a NULL pointer.");
+    TNG_ASSERT(values_len >= 0, "TNG library: values_len must not be negative.");
+    TNG_ASSERT(n_particles, "TNG library: n_particles must not be a NULL pointer.");
+    TNG_ASSERT(stride_length, "TNG library: stride_length must not be a NULL pointer.");
+    TNG_ASSERT(n_values_per_frame, "TNG library: n_values_per_frame must not be a NULL pointer.");
+    TNG_ASSERT(type, "TNG library: type must not be a NULL pointer.");
+
+    return (tng_gen_data_vector_interval_get(tng_data, block_id, TNG_TRUE, start_frame_nr,
+                                             end_frame_nr, hash_mode, &values, values_len,
+                                             frame_stride, TNG_CHAR_DATA, n_particles,
                                              stride_length, n_values_per_frame, type));
 }
 
@@ -14233,11 +19426,11 @@ tng_function_status DECLSPECDLLEXPORT tng_data_get_stride_length(struct tng_traj
             /* If no specific frame was required read until this data block is found */
             if (frame < 0)
             {
-                file_pos = ftello(tng_data->input_file);
+                file_pos = tng_input_file_tell(tng_data);
                 while (stat != TNG_SUCCESS && file_pos < tng_data->input_file_len)
                 {
                     stat = tng_frame_set_read_next_only_data_from_block_id(tng_data, TNG_USE_HASH, block_id);
-                    file_pos = ftello(tng_data->input_file);
+                    file_pos = tng_input_file_tell(tng_data);
                 }
             }
             if (stat != TNG_SUCCESS)
@@ -14318,7 +19511,7 @@ tng_function_status DECLSPECDLLEXPORT tng_util_trajectory_open(const char*
 
     TNG_ASSERT(filename, "TNG library: filename must not be a NULL pointer.");
 
-    if (mode != 'r' && mode != 'w' && mode != 'a')
+    if (mode != 'r' && mode != 'm' && mode != 'w' && mode != 'a')
     {
         return (TNG_FAILURE);
     }
@@ -14329,6 +19522,11 @@ tng_function_status DECLSPECDLLEXPORT tng_util_trajectory_open(const char*
         return (TNG_CRITICAL);
     }
 
+    if (mode == 'm')
+    {
+        (*tng_data_p)->input_file_map_flag = TNG_TRUE;
+    }
+
     if (mode == 'w')
     {
         stat = tng_output_file_set(*tng_data_p, filename);
@@ -14353,7 +19551,7 @@ tng_function_status DECLSPECDLLEXPORT tng_util_trajectory_open(const char*
             fclose((*tng_data_p)->output_file);
         }
         (*tng_data_p)->output_file = (*tng_data_p)->input_file;
-        fseeko((*tng_data_p)->input_file, (*tng_data_p)->last_trajectory_frame_set_input_file_pos, SEEK_SET);
+        tng_input_file_seek(*tng_data_p, (*tng_data_p)->last_trajectory_frame_set_input_file_pos, SEEK_SET);
 
         stat = tng_frame_set_read(*tng_data_p, TNG_USE_HASH);
         if (stat != TNG_SUCCESS)
@@ -14363,6 +19561,8 @@ tng_function_status DECLSPECDLLEXPORT tng_util_trajectory_open(const char*
         }
         (*tng_data_p)->output_file = 0;
 
+        tng_frame_set_index_input_find(*tng_data_p);
+
         (*tng_data_p)->first_trajectory_frame_set_output_file_pos =
                 (*tng_data_p)->first_trajectory_frame_set_input_file_pos;
         (*tng_data_p)->last_trajectory_frame_set_output_file_pos =
@@ -14381,6 +19581,17 @@ tng_function_status DECLSPECDLLEXPORT tng_util_trajectory_open(const char*
         }
         tng_output_append_file_set(*tng_data_p, filename);
 
+        /* Keep indexing the frame sets if all frame sets in the file are known. */
+        if ((*tng_data_p)->first_trajectory_frame_set_output_file_pos <= 0)
+        {
+            tng_frame_set_index_clear(&(*tng_data_p)->output_frame_set_index, TNG_TRUE);
+        }
+        else if ((*tng_data_p)->input_frame_set_index.valid)
+        {
+            tng_frame_set_index_copy(&(*tng_data_p)->input_frame_set_index,
+                                     &(*tng_data_p)->output_frame_set_index);
+        }
+
         fseeko((*tng_data_p)->output_file, 0, SEEK_END);
 
         (*tng_data_p)->output_endianness_swap_func_32 = (*tng_data_p)->input_endianness_swap_func_32;
@@ -14415,6 +19626,11 @@ tng_function_status DECLSPECDLLEXPORT tng_util_trajectory_close(tng_trajectory_t
         tng_frame_set_write(*tng_data_p, TNG_USE_HASH);
     }
 
+    if ((*tng_data_p)->output_file && (*tng_data_p)->output_frame_set_index.n_entries > 0)
+    {
+        tng_frame_set_index_write(*tng_data_p, TNG_USE_HASH);
+    }
+
     return (tng_trajectory_destroy(tng_data_p));
 }
 
@@ -14644,41 +19860,241 @@ tng_function_status DECLSPECDLLEXPORT tng_util_box_shape_read(struct tng_traject
     char                type;
     tng_function_status stat;
 
-    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
-    TNG_ASSERT(box_shape, "TNG library: box_shape must not be a NULL pointer");
-    TNG_ASSERT(stride_length, "TNG library: stride_length must not be a NULL pointer");
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(box_shape, "TNG library: box_shape must not be a NULL pointer");
+    TNG_ASSERT(stride_length, "TNG library: stride_length must not be a NULL pointer");
+
+    stat = tng_num_frames_get(tng_data, &n_frames);
+    if (stat != TNG_SUCCESS)
+    {
+        return (stat);
+    }
+
+    stat = tng_data_vector_interval_get(tng_data, TNG_TRAJ_BOX_SHAPE, 0, n_frames - 1, TNG_USE_HASH,
+                                        (void**)box_shape, stride_length, &n_values_per_frame, &type);
+
+    if (stat == TNG_SUCCESS && type != TNG_FLOAT_DATA)
+    {
+        return (TNG_FAILURE);
+    }
+
+    return (stat);
+}
+
+tng_function_status DECLSPECDLLEXPORT tng_util_particle_data_next_frame_read(struct tng_trajectory* tng_data,
+                                                                             const int64_t block_id,
+                                                                             void**        values,
+                                                                             char* data_type,
+                                                                             int64_t* retrieved_frame_number,
+                                                                             double* retrieved_time)
+{
+    tng_trajectory_frame_set_t frame_set;
+    tng_data_t                 data = 0;
+    tng_function_status        stat;
+    int                        size;
+    int64_t                    i, full_data_len, n_particles;
+    void*                      temp;
+    int64_t                    file_pos;
+    tng_bool                   prefetched = TNG_FALSE;
+
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(values, "TNG library: The pointer to the values array must not be a NULL pointer");
+    TNG_ASSERT(data_type,
+               "TNG library: The pointer to the data type of the returned data must not be a NULL "
+               "pointer");
+    TNG_ASSERT(retrieved_frame_number,
+               "TNG library: The pointer to the frame number of the returned data must not be a "
+               "NULL pointer");
+    TNG_ASSERT(
+            retrieved_time,
+            "TNG library: The pointer to the time of the returned data must not be a NULL pointer");
+
+    frame_set = &tng_data->current_trajectory_frame_set;
+
+    stat = tng_particle_data_find(tng_data, block_id, &data);
+    if (stat != TNG_SUCCESS)
+    {
+        stat = tng_frame_set_read_current_only_data_from_block_id(tng_data, TNG_USE_HASH, block_id);
+        file_pos = tng_input_file_tell(tng_data);
+        while (stat != TNG_SUCCESS && file_pos < tng_data->input_file_len)
+        {
+            stat = tng_frame_set_read_next_only_data_from_block_id(tng_data, TNG_USE_HASH, block_id);
+            file_pos = tng_input_file_tell(tng_data);
+        }
+        if (stat != TNG_SUCCESS)
+        {
+            return (stat);
+        }
+        stat = tng_particle_data_find(tng_data, block_id, &data);
+        if (stat != TNG_SUCCESS)
+        {
+            return (stat);
+        }
+    }
+    if (data->last_retrieved_frame < 0)
+    {
+        /* The first frame set may have been read ahead in the background. */
+        file_pos = tng_data->first_trajectory_frame_set_input_file_pos;
+        if (tng_prefetched_frame_set_take(tng_data, file_pos, TNG_USE_HASH, -1) != TNG_SUCCESS)
+        {
+            tng_input_file_seek(tng_data, file_pos, SEEK_SET);
+            stat = tng_frame_set_read(tng_data, TNG_USE_HASH);
+            tng_prefetch_continue(tng_data, stat);
+            if (stat != TNG_SUCCESS)
+            {
+                return (stat);
+            }
+        }
+        stat = tng_frame_set_read_current_only_data_from_block_id(tng_data, TNG_USE_HASH, block_id);
+        if (stat != TNG_SUCCESS)
+        {
+            return (stat);
+        }
+        /* The data blocks may have been moved when reading the frame set. */
+        stat = tng_particle_data_find(tng_data, block_id, &data);
+        if (stat != TNG_SUCCESS)
+        {
+            return (stat);
+        }
+
+        i = data->first_frame_with_data;
+    }
+    else
+    {
+        if (data->n_frames == 1 && frame_set->n_frames == 1)
+        {
+            i = data->last_retrieved_frame + 1;
+        }
+        else
+        {
+            i = data->last_retrieved_frame + data->stride_length;
+        }
+        if (i < frame_set->first_frame || i >= frame_set->first_frame + frame_set->n_frames)
+        {
+            /* The following frame set may have been read ahead in the background. */
+            if (i == frame_set->first_frame + frame_set->n_frames
+                && tng_prefetched_frame_set_take(tng_data, frame_set->next_frame_set_file_pos,
+                                                 TNG_USE_HASH, block_id)
+                           == TNG_SUCCESS)
+            {
+                prefetched = TNG_TRUE;
+                i          = tng_max_i64(i, frame_set->first_frame);
+            }
+            else
+            {
+                stat = tng_frame_set_of_frame_find(tng_data, i);
+                if (stat != TNG_SUCCESS)
+                {
+                    /* If the frame set search found the frame set after the starting
+                     * frame set there is a gap in the frame sets. So, even if the frame
+                     * was not found the next frame with data is still in the found
+                     * frame set. */
+                    if (stat == TNG_CRITICAL)
+                    {
+                        return (stat);
+                    }
+                    if (frame_set->first_frame + frame_set->n_frames - 1 < i)
+                    {
+                        return (TNG_FAILURE);
+                    }
+                    i = frame_set->first_frame;
+                }
+                tng_prefetch_continue(tng_data, stat);
+            }
+        }
+        if (prefetched)
+        {
+            /* The data blocks have been read with the frame set. */
+            stat = tng_particle_data_find(tng_data, block_id, &data);
+            if (stat != TNG_SUCCESS)
+            {
+                return (stat);
+            }
+        }
+        else if (data->last_retrieved_frame < frame_set->first_frame)
+        {
+            stat = tng_frame_set_read_current_only_data_from_block_id(tng_data, TNG_USE_HASH, block_id);
+            if (stat != TNG_SUCCESS)
+            {
+                return (stat);
+            }
+            stat = tng_particle_data_find(tng_data, block_id, &data);
+            if (stat != TNG_SUCCESS)
+            {
+                return (stat);
+            }
+        }
+    }
+    data->last_retrieved_frame = i;
+    *retrieved_frame_number    = i;
+    if (frame_set->first_frame_time >= 0 && tng_data->time_per_frame >= 0)
+    {
+        *retrieved_time =
+                frame_set->first_frame_time + (i - frame_set->first_frame) * tng_data->time_per_frame;
+    }
+    else
+    {
+        *retrieved_time = 0;
+    }
+
+    if (data->stride_length > 1)
+    {
+        i = (i - data->first_frame_with_data) / data->stride_length;
+    }
+    else
+    {
+        i = (i - frame_set->first_frame);
+    }
+
+    tng_num_particles_get(tng_data, &n_particles);
 
-    stat = tng_num_frames_get(tng_data, &n_frames);
-    if (stat != TNG_SUCCESS)
+    *data_type = data->datatype;
+
+    switch (*data_type)
     {
-        return (stat);
+        case TNG_CHAR_DATA: return (TNG_FAILURE);
+        case TNG_INT_DATA: size = sizeof(int64_t); break;
+        case TNG_FLOAT_DATA: size = sizeof(float); break;
+        case TNG_DOUBLE_DATA:
+        default: size = sizeof(double);
     }
 
-    stat = tng_data_vector_interval_get(tng_data, TNG_TRAJ_BOX_SHAPE, 0, n_frames - 1, TNG_USE_HASH,
-                                        (void**)box_shape, stride_length, &n_values_per_frame, &type);
+    full_data_len = size * n_particles * data->n_values_per_frame;
 
-    if (stat == TNG_SUCCESS && type != TNG_FLOAT_DATA)
+    //     fprintf(stderr, "TNG library: TEMP: i = %" PRId64 ", full_data_len = %" PRId64 ", size = %d, n_particles = %" PRId64 ", n_values_per_frame = %" PRId64 "\n",
+    //            i, full_data_len, size, n_particles, data->n_values_per_frame);
+
+    temp = (char*)realloc(*values, full_data_len);
+    if (!temp)
     {
-        return (TNG_FAILURE);
+        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+        free(*values);
+        *values = 0;
+        return (TNG_CRITICAL);
     }
 
-    return (stat);
+    *values = temp;
+
+    memcpy(*values, (char*)data->values + i * full_data_len, full_data_len);
+
+    return (TNG_SUCCESS);
 }
 
-tng_function_status DECLSPECDLLEXPORT tng_util_particle_data_next_frame_read(struct tng_trajectory* tng_data,
-                                                                             const int64_t block_id,
-                                                                             void**        values,
-                                                                             char* data_type,
-                                                                             int64_t* retrieved_frame_number,
-                                                                             double* retrieved_time)
+tng_function_status DECLSPECDLLEXPORT tng_util_non_particle_data_next_frame_read(struct tng_trajectory* tng_data,
+                                                                                 const int64_t block_id,
+                                                                                 void** values,
+                                                                                 char*  data_type,
+                                                                                 int64_t* retrieved_frame_number,
+                                                                                 double* retrieved_time)
 {
     tng_trajectory_frame_set_t frame_set;
     tng_data_t                 data = 0;
     tng_function_status        stat;
     int                        size;
-    int64_t                    i, full_data_len, n_particles;
+    int64_t                    i, full_data_len;
     void*                      temp;
     int64_t                    file_pos;
+    tng_bool                   prefetched = TNG_FALSE;
 
     TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
     TNG_ASSERT(values, "TNG library: The pointer to the values array must not be a NULL pointer");
@@ -14694,21 +20110,21 @@ tng_function_status DECLSPECDLLEXPORT tng_util_particle_data_next_frame_read(str
 
     frame_set = &tng_data->current_trajectory_frame_set;
 
-    stat = tng_particle_data_find(tng_data, block_id, &data);
+    stat = tng_data_find(tng_data, block_id, &data);
     if (stat != TNG_SUCCESS)
     {
         stat = tng_frame_set_read_current_only_data_from_block_id(tng_data, TNG_USE_HASH, block_id);
-        file_pos = ftello(tng_data->input_file);
+        file_pos = tng_input_file_tell(tng_data);
         while (stat != TNG_SUCCESS && file_pos < tng_data->input_file_len)
         {
             stat = tng_frame_set_read_next_only_data_from_block_id(tng_data, TNG_USE_HASH, block_id);
-            file_pos = ftello(tng_data->input_file);
+            file_pos = tng_input_file_tell(tng_data);
         }
         if (stat != TNG_SUCCESS)
         {
             return (stat);
         }
-        stat = tng_particle_data_find(tng_data, block_id, &data);
+        stat = tng_data_find(tng_data, block_id, &data);
         if (stat != TNG_SUCCESS)
         {
             return (stat);
@@ -14716,13 +20132,25 @@ tng_function_status DECLSPECDLLEXPORT tng_util_particle_data_next_frame_read(str
     }
     if (data->last_retrieved_frame < 0)
     {
-        fseeko(tng_data->input_file, tng_data->first_trajectory_frame_set_input_file_pos, SEEK_SET);
-        stat = tng_frame_set_read(tng_data, TNG_USE_HASH);
+        /* The first frame set may have been read ahead in the background. */
+        file_pos = tng_data->first_trajectory_frame_set_input_file_pos;
+        if (tng_prefetched_frame_set_take(tng_data, file_pos, TNG_USE_HASH, -1) != TNG_SUCCESS)
+        {
+            tng_input_file_seek(tng_data, file_pos, SEEK_SET);
+            stat = tng_frame_set_read(tng_data, TNG_USE_HASH);
+            tng_prefetch_continue(tng_data, stat);
+            if (stat != TNG_SUCCESS)
+            {
+                return (stat);
+            }
+        }
+        stat = tng_frame_set_read_current_only_data_from_block_id(tng_data, TNG_USE_HASH, block_id);
         if (stat != TNG_SUCCESS)
         {
             return (stat);
         }
-        stat = tng_frame_set_read_current_only_data_from_block_id(tng_data, TNG_USE_HASH, block_id);
+        /* The data blocks may have been moved when reading the frame set. */
+        stat = tng_data_find(tng_data, block_id, &data);
         if (stat != TNG_SUCCESS)
         {
             return (stat);
@@ -14742,31 +20170,58 @@ tng_function_status DECLSPECDLLEXPORT tng_util_particle_data_next_frame_read(str
         }
         if (i < frame_set->first_frame || i >= frame_set->first_frame + frame_set->n_frames)
         {
-            stat = tng_frame_set_of_frame_find(tng_data, i);
-            if (stat != TNG_SUCCESS)
+            /* The following frame set may have been read ahead in the background. */
+            if (i == frame_set->first_frame + frame_set->n_frames
+                && tng_prefetched_frame_set_take(tng_data, frame_set->next_frame_set_file_pos,
+                                                 TNG_USE_HASH, block_id)
+                           == TNG_SUCCESS)
             {
-                /* If the frame set search found the frame set after the starting
-                 * frame set there is a gap in the frame sets. So, even if the frame
-                 * was not found the next frame with data is still in the found
-                 * frame set. */
-                if (stat == TNG_CRITICAL)
-                {
-                    return (stat);
-                }
-                if (frame_set->first_frame + frame_set->n_frames - 1 < i)
+                prefetched = TNG_TRUE;
+                i          = tng_max_i64(i, frame_set->first_frame);
+            }
+            else
+            {
+                stat = tng_frame_set_of_frame_find(tng_data, i);
+                if (stat != TNG_SUCCESS)
                 {
-                    return (TNG_FAILURE);
+                    /* If the frame set search found the frame set after the starting
+                     * frame set there is a gap in the frame sets. So, even if the frame
+                     * was not found the next frame with data is still in the found
+                     * frame set. */
+                    if (stat == TNG_CRITICAL)
+                    {
+                        return (stat);
+                    }
+                    if (frame_set->first_frame + frame_set->n_frames - 1 < i)
+                    {
+                        return (TNG_FAILURE);
+                    }
+                    i = frame_set->first_frame;
                 }
-                i = frame_set->first_frame;
+                tng_prefetch_continue(tng_data, stat);
             }
         }
-        if (data->last_retrieved_frame < frame_set->first_frame)
+        if (prefetched)
+        {
+            /* The data blocks have been read with the frame set. */
+            stat = tng_data_find(tng_data, block_id, &data);
+            if (stat != TNG_SUCCESS)
+            {
+                return (stat);
+            }
+        }
+        else if (data->last_retrieved_frame < frame_set->first_frame)
         {
             stat = tng_frame_set_read_current_only_data_from_block_id(tng_data, TNG_USE_HASH, block_id);
             if (stat != TNG_SUCCESS)
             {
                 return (stat);
             }
+            stat = tng_data_find(tng_data, block_id, &data);
+            if (stat != TNG_SUCCESS)
+            {
+                return (stat);
+            }
         }
     }
     data->last_retrieved_frame = i;
@@ -14790,8 +20245,6 @@ tng_function_status DECLSPECDLLEXPORT tng_util_particle_data_next_frame_read(str
         i = (i - frame_set->first_frame);
     }
 
-    tng_num_particles_get(tng_data, &n_particles);
-
     *data_type = data->datatype;
 
     switch (*data_type)
@@ -14803,10 +20256,7 @@ tng_function_status DECLSPECDLLEXPORT tng_util_particle_data_next_frame_read(str
         default: size = sizeof(double);
     }
 
-    full_data_len = size * n_particles * data->n_values_per_frame;
-
-    //     fprintf(stderr, "TNG library: TEMP: i = %" PRId64 ", full_data_len = %" PRId64 ", size = %d, n_particles = %" PRId64 ", n_values_per_frame = %" PRId64 "\n",
-    //            i, full_data_len, size, n_particles, data->n_values_per_frame);
+    full_data_len = size * data->n_values_per_frame;
 
     temp = (char*)realloc(*values, full_data_len);
     if (!temp)
@@ -14824,242 +20274,602 @@ tng_function_status DECLSPECDLLEXPORT tng_util_particle_data_next_frame_read(str
     return (TNG_SUCCESS);
 }
 
-tng_function_status DECLSPECDLLEXPORT tng_util_non_particle_data_next_frame_read(struct tng_trajectory* tng_data,
-                                                                                 const int64_t block_id,
-                                                                                 void** values,
-                                                                                 char*  data_type,
-                                                                                 int64_t* retrieved_frame_number,
-                                                                                 double* retrieved_time)
+tng_function_status DECLSPECDLLEXPORT tng_util_pos_read_range(struct tng_trajectory* tng_data,
+                                                              const int64_t          first_frame,
+                                                              const int64_t          last_frame,
+                                                              float**                positions,
+                                                              int64_t*               stride_length)
 {
-    tng_trajectory_frame_set_t frame_set;
-    tng_data_t                 data = 0;
-    tng_function_status        stat;
-    int                        size;
-    int64_t                    i, full_data_len;
-    void*                      temp;
-    int64_t                    file_pos;
+    int64_t             n_particles, n_values_per_frame;
+    char                type;
+    tng_function_status stat;
 
     TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
-    TNG_ASSERT(values, "TNG library: The pointer to the values array must not be a NULL pointer");
-    TNG_ASSERT(data_type,
-               "TNG library: The pointer to the data type of the returned data must not be a NULL "
-               "pointer");
-    TNG_ASSERT(retrieved_frame_number,
-               "TNG library: The pointer to the frame number of the returned data must not be a "
-               "NULL pointer");
-    TNG_ASSERT(
-            retrieved_time,
-            "TNG library: The pointer to the time of the returned data must not be a NULL pointer");
+    TNG_ASSERT(positions, "TNG library: positions must not be a NULL pointer");
+    TNG_ASSERT(first_frame <= last_frame,
+               "TNG library: first_frame must be lower or equal to last_frame.");
+    TNG_ASSERT(stride_length, "TNG library: stride_length must not be a NULL pointer");
 
-    frame_set = &tng_data->current_trajectory_frame_set;
+    stat = tng_particle_data_vector_interval_get(tng_data, TNG_TRAJ_POSITIONS, first_frame, last_frame,
+                                                 TNG_USE_HASH, (void**)positions, &n_particles,
+                                                 stride_length, &n_values_per_frame, &type);
 
-    stat = tng_data_find(tng_data, block_id, &data);
-    if (stat != TNG_SUCCESS)
+    if (stat == TNG_SUCCESS && type != TNG_FLOAT_DATA)
     {
-        stat = tng_frame_set_read_current_only_data_from_block_id(tng_data, TNG_USE_HASH, block_id);
-        file_pos = ftello(tng_data->input_file);
-        while (stat != TNG_SUCCESS && file_pos < tng_data->input_file_len)
+        return (TNG_FAILURE);
+    }
+
+    return (stat);
+}
+
+tng_function_status DECLSPECDLLEXPORT tng_util_vel_read_range(struct tng_trajectory* tng_data,
+                                                              const int64_t          first_frame,
+                                                              const int64_t          last_frame,
+                                                              float**                velocities,
+                                                              int64_t*               stride_length)
+{
+    int64_t             n_particles, n_values_per_frame;
+    char                type;
+    tng_function_status stat;
+
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(velocities, "TNG library: velocities must not be a NULL pointer");
+    TNG_ASSERT(first_frame <= last_frame,
+               "TNG library: first_frame must be lower or equal to last_frame.");
+    TNG_ASSERT(stride_length, "TNG library: stride_length must not be a NULL pointer");
+
+    stat = tng_particle_data_vector_interval_get(tng_data, TNG_TRAJ_VELOCITIES, first_frame, last_frame,
+                                                 TNG_USE_HASH, (void**)velocities, &n_particles,
+                                                 stride_length, &n_values_per_frame, &type);
+
+    if (stat == TNG_SUCCESS && type != TNG_FLOAT_DATA)
+    {
+        return (TNG_FAILURE);
+    }
+
+    return (stat);
+}
+
+tng_function_status DECLSPECDLLEXPORT tng_util_force_read_range(struct tng_trajectory* tng_data,
+                                                                const int64_t          first_frame,
+                                                                const int64_t          last_frame,
+                                                                float**                forces,
+                                                                int64_t* stride_length)
+{
+    int64_t             n_particles, n_values_per_frame;
+    char                type;
+    tng_function_status stat;
+
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(forces, "TNG library: forces must not be a NULL pointer");
+    TNG_ASSERT(first_frame <= last_frame,
+               "TNG library: first_frame must be lower or equal to last_frame.");
+    TNG_ASSERT(stride_length, "TNG library: stride_length must not be a NULL pointer");
+
+    stat = tng_particle_data_vector_interval_get(tng_data, TNG_TRAJ_FORCES, first_frame, last_frame,
+                                                 TNG_USE_HASH, (void**)forces, &n_particles,
+                                                 stride_length, &n_values_per_frame, &type);
+
+    if (stat == TNG_SUCCESS && type != TNG_FLOAT_DATA)
+    {
+        return (TNG_FAILURE);
+    }
+
+    return (stat);
+}
+
+/**
+ * @brief Read the float data of a particle data block from a range of frames
+ * into an array of the caller.
+ * @param tng_data is the trajectory to read from.
+ * @param block_id is the ID number of the particle data block.
+ * @param first_frame is the first frame to read.
+ * @param last_frame is the last frame to read.
+ * @param values is the array to read the data into.
+ * @param n_values is the number of floats that fit in values.
+ * @param frame_stride is the number of floats between the starts of two frames
+ * in values, or 0 if the frames are stored consecutively.
+ * @param stride_length will be set to the writing interval of the stored data.
+ * @return TNG_SUCCESS (0) if successful, TNG_FAILURE (1) if a minor error
+ * has occured (such as the data not fitting in values) or TNG_CRITICAL (2)
+ * if a major error has occured.
+ */
+static tng_function_status tng_util_particle_data_read_range_into(struct tng_trajectory* tng_data,
+                                                                  const int64_t          block_id,
+                                                                  const int64_t          first_frame,
+                                                                  const int64_t          last_frame,
+                                                                  float*                 values,
+                                                                  const int64_t          n_values,
+                                                                  const int64_t          frame_stride,
+                                                                  int64_t*               stride_length)
+{
+    int64_t n_particles, n_values_per_frame;
+    char    type;
+    void*   values_p = values;
+
+    return (tng_gen_data_vector_interval_get(tng_data, block_id, TNG_TRUE, first_frame, last_frame,
+                                             TNG_USE_HASH, &values_p, n_values * sizeof(float),
+                                             frame_stride * sizeof(float), TNG_FLOAT_DATA,
+                                             &n_particles, stride_length, &n_values_per_frame,
+                                             &type));
+}
+
+tng_function_status DECLSPECDLLEXPORT tng_util_pos_read_range_into(struct tng_trajectory* tng_data,
+                                                                   const int64_t          first_frame,
+                                                                   const int64_t          last_frame,
+                                                                   float*                 positions,
+                                                                   const int64_t          n_values,
+                                                                   const int64_t          frame_stride,
+                                                                   int64_t*               stride_length)
+{
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(positions, "TNG library: positions must not be a NULL pointer");
+    TNG_ASSERT(first_frame <= last_frame,
+               "TNG library: first_frame must be lower or equal to last_frame.");
+    TNG_ASSERT(stride_length, "TNG library: stride_length must not be a NULL pointer");
+
+    return (tng_util_particle_data_read_range_into(tng_data, TNG_TRAJ_POSITIONS, first_frame,
+                                                   last_frame, positions, n_values, frame_stride,
+                                                   stride_length));
+}
+
+tng_function_status DECLSPECDLLEXPORT tng_util_vel_read_range_into(struct tng_trajectory* tng_data,
+                                                                   const int64_t          first_frame,
+                                                                   const int64_t          last_frame,
+                                                                   float*                 velocities,
+                                                                   const int64_t          n_values,
+                                                                   const int64_t          frame_stride,
+                                                                   int64_t*               stride_length)
+{
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(velocities, "TNG library: velocities must not be a NULL pointer");
+    TNG_ASSERT(first_frame <= last_frame,
+               "TNG library: first_frame must be lower or equal to last_frame.");
+    TNG_ASSERT(stride_length, "TNG library: stride_length must not be a NULL pointer");
+
+    return (tng_util_particle_data_read_range_into(tng_data, TNG_TRAJ_VELOCITIES, first_frame,
+                                                   last_frame, velocities, n_values, frame_stride,
+                                                   stride_length));
+}
+
+tng_function_status DECLSPECDLLEXPORT tng_util_force_read_range_into(struct tng_trajectory* tng_data,
+                                                                     const int64_t          first_frame,
+                                                                     const int64_t          last_frame,
+                                                                     float*                 forces,
+                                                                     const int64_t          n_values,
+                                                                     const int64_t          frame_stride,
+                                                                     int64_t*               stride_length)
+{
+    TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(forces, "TNG library: forces must not be a NULL pointer");
+    TNG_ASSERT(first_frame <= last_frame,
+               "TNG library: first_frame must be lower or equal to last_frame.");
+    TNG_ASSERT(stride_length, "TNG library: stride_length must not be a NULL pointer");
+
+    return (tng_util_particle_data_read_range_into(tng_data, TNG_TRAJ_FORCES, first_frame,
+                                                   last_frame, forces, n_values, frame_stride,
+                                                   stride_length));
+}
+
+/**
+ * @brief Find a particle in a sorted list of particle numbers.
+ * @param particles is the list of particle numbers, sorted in increasing order.
+ * @param n_particles is the number of particles in the list.
+ * @param particle is the particle number to find.
+ * @return the index of the particle in the list or -1 if it is not in the list.
+ */
+static int64_t tng_sorted_particle_index_get(const int64_t* particles,
+                                             const int64_t  n_particles,
+                                             const int64_t  particle)
+{
+    int64_t low = 0, high = n_particles - 1, mid;
+
+    while (low <= high)
+    {
+        mid = low + (high - low) / 2;
+        if (particles[mid] < particle)
         {
-            stat = tng_frame_set_read_next_only_data_from_block_id(tng_data, TNG_USE_HASH, block_id);
-            file_pos = ftello(tng_data->input_file);
+            low = mid + 1;
         }
-        if (stat != TNG_SUCCESS)
+        else if (particles[mid] > particle)
         {
-            return (stat);
+            high = mid - 1;
         }
-        stat = tng_data_find(tng_data, block_id, &data);
-        if (stat != TNG_SUCCESS)
+        else
         {
-            return (stat);
+            return (mid);
         }
     }
-    if (data->last_retrieved_frame < 0)
+    return (-1);
+}
+
+/**
+ * @brief Read the blocks of a particle data block in the current frame set,
+ * which contain any of a selection of particles. The particle mapping blocks
+ * are read as well. All other blocks are skipped without reading their contents.
+ * @param tng_data is a trajectory data container.
+ * @param block_id is the ID number of the particle data block.
+ * @param particles is the list of selected particles (in real particle
+ * numbering), sorted in increasing order.
+ * @param n_selected is the number of selected particles.
+ * @param local will be set to the number of each selected particle in the
+ * frame set, or -1 if the particle is not in the frame set.
+ * @param block_n will be set to the number of particles of the data block
+ * containing each selected particle, or 0 if its data was not read.
+ * @details local and block_n must have room for n_selected values. The values
+ * of a selected particle in a frame are found at (frame * n_particles + local)
+ * * n_values_per_frame in the data values of the frame set.
+ * @param hash_mode is an option to decide whether to use the md5 hash or not.
+ * @return TNG_SUCCESS (0) if any data was read, TNG_FAILURE (1) if no block
+ * contained the selected particles or TNG_CRITICAL (2) if a major error
+ * has occured.
+ */
+static tng_function_status tng_frame_set_particle_subset_read(struct tng_trajectory* tng_data,
+                                                              const int64_t          block_id,
+                                                              const int64_t*         particles,
+                                                              const int64_t          n_selected,
+                                                              int64_t*               local,
+                                                              int64_t*               block_n,
+                                                              const char             hash_mode)
+{
+    int64_t                    i, j, file_pos, contents_pos, n_values, codec_id, first_frame_with_data;
+    int64_t                    stride_length, n_frames, num_first_particle, block_n_particles;
+    double                     multiplier;
+    char                       datatype, dependency, sparse_data;
+    tng_bool                   found = TNG_FALSE, contains_selected;
+    tng_trajectory_frame_set_t frame_set = &tng_data->current_trajectory_frame_set;
+    tng_particle_mapping_t     mapping;
+    tng_gen_block_t            block;
+    struct tng_hash_state      hash_state;
+    tng_function_status        stat;
+
+    file_pos = tng_data->current_trajectory_frame_set_input_file_pos;
+    if (file_pos <= 0)
+    {
+        return (TNG_FAILURE);
+    }
+    tng_input_file_seek(tng_data, file_pos, SEEK_SET);
+
+    tng_block_init(&block);
+
+    stat = tng_block_header_read(tng_data, block);
+    if (stat == TNG_CRITICAL || block->id != TNG_TRAJECTORY_FRAME_SET)
     {
-        fseeko(tng_data->input_file, tng_data->first_trajectory_frame_set_input_file_pos, SEEK_SET);
-        stat = tng_frame_set_read(tng_data, TNG_USE_HASH);
-        if (stat != TNG_SUCCESS)
-        {
-            return (stat);
-        }
-        stat = tng_frame_set_read_current_only_data_from_block_id(tng_data, TNG_USE_HASH, block_id);
-        if (stat != TNG_SUCCESS)
-        {
-            return (stat);
-        }
+        fprintf(stderr, "TNG library: Cannot read block header at pos %" PRId64 ". %s: %d\n",
+                file_pos, __FILE__, __LINE__);
+        tng_block_destroy(&block);
+        return (TNG_CRITICAL);
+    }
+    /* The frame set block has already been read, but the mapping blocks are read again. */
+    tng_input_file_seek(tng_data, block->block_contents_size, SEEK_CUR);
+    tng_frame_set_particle_mapping_free(tng_data);
 
-        i = data->first_frame_with_data;
+    /* Without mapping blocks the particles are numbered as in the molecular system. */
+    for (i = 0; i < n_selected; i++)
+    {
+        local[i]   = particles[i];
+        block_n[i] = 0;
     }
-    else
+
+    file_pos = tng_input_file_tell(tng_data);
+    stat     = tng_block_header_read(tng_data, block);
+    while (file_pos < tng_data->input_file_len && stat != TNG_CRITICAL
+           && block->id != TNG_TRAJECTORY_FRAME_SET && block->id != -1)
     {
-        if (data->n_frames == 1 && frame_set->n_frames == 1)
-        {
-            i = data->last_retrieved_frame + 1;
-        }
-        else
+        if (block->id == TNG_PARTICLE_MAPPING)
         {
-            i = data->last_retrieved_frame + data->stride_length;
+            if (frame_set->n_mapping_blocks == 0)
+            {
+                for (i = 0; i < n_selected; i++)
+                {
+                    local[i] = -1;
+                }
+            }
+            stat = tng_block_read_next(tng_data, block, hash_mode);
+            if (stat == TNG_SUCCESS)
+            {
+                mapping = &frame_set->mappings[frame_set->n_mapping_blocks - 1];
+                for (j = 0; j < mapping->n_particles; j++)
+                {
+                    i = tng_sorted_particle_index_get(particles, n_selected,
+                                                      mapping->real_particle_numbers[j]);
+                    if (i >= 0)
+                    {
+                        local[i] = mapping->num_first_particle + j;
+                    }
+                }
+            }
         }
-        if (i < frame_set->first_frame || i >= frame_set->first_frame + frame_set->n_frames)
+        else if (block->id == block_id)
         {
-            stat = tng_frame_set_of_frame_find(tng_data, i);
-            if (stat != TNG_SUCCESS)
+            /* Peek at the particle range of the block before reading its contents. */
+            contents_pos = tng_input_file_tell(tng_data);
+            stat         = tng_data_block_meta_information_read(
+                    tng_data, &datatype, &dependency, &sparse_data, &n_values, &codec_id,
+                    &first_frame_with_data, &stride_length, &n_frames, &num_first_particle,
+                    &block_n_particles, &multiplier, TNG_SKIP_HASH, &hash_state);
+            /* Non-particle data blocks are not read. */
+            if (!(dependency & TNG_PARTICLE_DEPENDENT))
             {
-                /* If the frame set search found the frame set after the starting
-                 * frame set there is a gap in the frame sets. So, even if the frame
-                 * was not found the next frame with data is still in the found
-                 * frame set. */
-                if (stat == TNG_CRITICAL)
+                block_n_particles = 0;
+            }
+            contains_selected = TNG_FALSE;
+            for (i = 0; i < n_selected && !contains_selected; i++)
+            {
+                if (local[i] >= num_first_particle && local[i] - num_first_particle < block_n_particles)
                 {
-                    return (stat);
+                    contains_selected = TNG_TRUE;
                 }
-                if (frame_set->first_frame + frame_set->n_frames - 1 < i)
+            }
+            tng_input_file_seek(tng_data, contents_pos, SEEK_SET);
+            if (stat == TNG_SUCCESS && contains_selected)
+            {
+                stat = tng_block_read_next(tng_data, block, hash_mode);
+                if (stat == TNG_SUCCESS)
                 {
-                    return (TNG_FAILURE);
+                    found = TNG_TRUE;
+                    for (i = 0; i < n_selected; i++)
+                    {
+                        if (local[i] >= num_first_particle
+                            && local[i] - num_first_particle < block_n_particles)
+                        {
+                            block_n[i] = block_n_particles;
+                        }
+                    }
                 }
-                i = frame_set->first_frame;
+            }
+            else if (stat != TNG_CRITICAL)
+            {
+                tng_input_file_seek(tng_data, block->block_contents_size, SEEK_CUR);
             }
         }
-        if (data->last_retrieved_frame < frame_set->first_frame)
+        else
         {
-            stat = tng_frame_set_read_current_only_data_from_block_id(tng_data, TNG_USE_HASH, block_id);
-            if (stat != TNG_SUCCESS)
+            tng_input_file_seek(tng_data, block->block_contents_size, SEEK_CUR);
+        }
+        if (stat != TNG_CRITICAL)
+        {
+            file_pos = tng_input_file_tell(tng_data);
+            if (file_pos < tng_data->input_file_len)
             {
-                return (stat);
+                stat = tng_block_header_read(tng_data, block);
             }
         }
     }
-    data->last_retrieved_frame = i;
-    *retrieved_frame_number    = i;
-    if (frame_set->first_frame_time >= 0 && tng_data->time_per_frame >= 0)
+    if (stat == TNG_CRITICAL)
     {
-        *retrieved_time =
-                frame_set->first_frame_time + (i - frame_set->first_frame) * tng_data->time_per_frame;
+        fprintf(stderr, "TNG library: Cannot read block header at pos %" PRId64 ". %s: %d\n",
+                file_pos, __FILE__, __LINE__);
+        tng_block_destroy(&block);
+        return (stat);
     }
-    else
+
+    if (block->id == TNG_TRAJECTORY_FRAME_SET)
     {
-        *retrieved_time = 0;
+        tng_input_file_seek(tng_data, file_pos, SEEK_SET);
     }
 
-    if (data->stride_length > 1)
+    tng_block_destroy(&block);
+
+    return (found ? TNG_SUCCESS : TNG_FAILURE);
+}
+
+/**
+ * @brief Read the float data of a selection of particles from a range of
+ * frames. Only the blocks containing any of the selected particles are read.
+ * @param tng_data is the trajectory to read from.
+ * @param block_id is the ID number of the particle data block.
+ * @param first_frame is the first frame to read.
+ * @param last_frame is the last frame to read.
+ * @param particles is the list of selected particles, sorted in increasing order.
+ * @param n_selected is the number of selected particles.
+ * @param values will be set to point at an array containing the data of the
+ * selected particles, for each frame with data.
+ * @param stride_length will be set to the writing interval of the stored data.
+ * @return TNG_SUCCESS (0) if successful, TNG_FAILURE (1) if a minor error
+ * has occured or TNG_CRITICAL (2) if a major error has occured.
+ */
+static tng_function_status tng_util_particle_data_subset_read_range(struct tng_trajectory* tng_data,
+                                                                    const int64_t          block_id,
+                                                                    const int64_t          first_frame,
+                                                                    const int64_t          last_frame,
+                                                                    const int64_t*         particles,
+                                                                    const int64_t          n_selected,
+                                                                    float**                values,
+                                                                    int64_t*               stride_length)
+{
+    int64_t                    i, j, n_frames_div = 0, n_values_per_frame = 0, tot_n_particles;
+    int64_t                    offset, first, last, file_pos;
+    int64_t *                  local, *block_n;
+    float*                     temp;
+    tng_data_t                 data;
+    tng_trajectory_frame_set_t frame_set = &tng_data->current_trajectory_frame_set;
+    tng_gen_block_t            block;
+    tng_function_status        stat, item_stat;
+
+    if (n_selected <= 0)
     {
-        i = (i - data->first_frame_with_data) / data->stride_length;
+        return (TNG_FAILURE);
     }
-    else
+    for (i = 1; i < n_selected; i++)
     {
-        i = (i - frame_set->first_frame);
+        if (particles[i] <= particles[i - 1])
+        {
+            fprintf(stderr, "TNG library: The selected particles must be sorted in increasing order. %s: %d\n",
+                    __FILE__, __LINE__);
+            return (TNG_FAILURE);
+        }
     }
 
-    *data_type = data->datatype;
-
-    switch (*data_type)
+    local = (int64_t*)malloc(sizeof(int64_t) * n_selected * 2);
+    if (!local)
     {
-        case TNG_CHAR_DATA: return (TNG_FAILURE);
-        case TNG_INT_DATA: size = sizeof(int64_t); break;
-        case TNG_FLOAT_DATA: size = sizeof(float); break;
-        case TNG_DOUBLE_DATA:
-        default: size = sizeof(double);
+        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+        return (TNG_CRITICAL);
     }
+    block_n = local + n_selected;
 
-    full_data_len = size * data->n_values_per_frame;
-
-    temp = (char*)realloc(*values, full_data_len);
-    if (!temp)
+    stat = tng_frame_set_of_frame_find(tng_data, first_frame);
+    while (stat == TNG_SUCCESS)
     {
-        fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
-        free(*values);
-        *values = 0;
-        return (TNG_CRITICAL);
+        /* A frame set without any of the selected particles is skipped. */
+        item_stat = tng_frame_set_particle_subset_read(tng_data, block_id, particles, n_selected,
+                                                       local, block_n, TNG_USE_HASH);
+        if (item_stat == TNG_CRITICAL)
+        {
+            stat = item_stat;
+            break;
+        }
+        if (item_stat == TNG_SUCCESS && tng_particle_data_find(tng_data, block_id, &data) == TNG_SUCCESS)
+        {
+            if (data->datatype != TNG_FLOAT_DATA)
+            {
+                stat = TNG_FAILURE;
+                break;
+            }
+            if (n_frames_div == 0)
+            {
+                *stride_length     = data->stride_length;
+                n_values_per_frame = data->n_values_per_frame;
+                n_frames_div       = (last_frame - first_frame) / *stride_length + 1;
+                temp               = (float*)realloc(*values, sizeof(float) * n_frames_div
+                                                                  * n_selected * n_values_per_frame);
+                if (!temp)
+                {
+                    fprintf(stderr, "TNG library: Cannot allocate memory. %s: %d\n", __FILE__, __LINE__);
+                    free(*values);
+                    *values = 0;
+                    stat    = TNG_CRITICAL;
+                    break;
+                }
+                *values = temp;
+                /* Particles missing from a frame set are left as 0. */
+                memset(*values, 0, sizeof(float) * n_frames_div * n_selected * n_values_per_frame);
+            }
+            if (data->n_values_per_frame != n_values_per_frame || data->stride_length != *stride_length)
+            {
+                stat = TNG_FAILURE;
+                break;
+            }
+            if (tng_data_interval_frames_get(data, n_frames_div, first_frame, last_frame, &offset,
+                                             &first, &last))
+            {
+                tot_n_particles = tng_data->var_num_atoms_flag ? frame_set->n_particles
+                                                               : tng_data->n_particles;
+                for (j = 0; j < n_selected; j++)
+                {
+                    /* Data of particles in blocks that were skipped may be left from an earlier frame set. */
+                    if (block_n[j] == 0)
+                    {
+                        continue;
+                    }
+                    for (i = first; i <= last; i++)
+                    {
+                        memcpy(*values + ((i + offset) * n_selected + j) * n_values_per_frame,
+                               (float*)data->values + (i * tot_n_particles + local[j]) * n_values_per_frame,
+                               sizeof(float) * n_values_per_frame);
+                    }
+                }
+            }
+        }
+
+        if (frame_set->first_frame + frame_set->n_frames > last_frame)
+        {
+            break;
+        }
+
+        /* Continue with the next frame set, only reading its frame set block. */
+        file_pos = frame_set->next_frame_set_file_pos;
+        if (file_pos <= 0)
+        {
+            break;
+        }
+        tng_input_file_seek(tng_data, file_pos, SEEK_SET);
+        tng_block_init(&block);
+        stat = tng_block_header_read(tng_data, block);
+        if (stat != TNG_SUCCESS || block->id != TNG_TRAJECTORY_FRAME_SET)
+        {
+            fprintf(stderr, "TNG library: Cannot read block header at pos %" PRId64 ". %s: %d\n",
+                    file_pos, __FILE__, __LINE__);
+            stat = TNG_CRITICAL;
+        }
+        else
+        {
+            tng_data->current_trajectory_frame_set_input_file_pos = file_pos;
+            stat = tng_block_read_next(tng_data, block, TNG_USE_HASH);
+        }
+        tng_block_destroy(&block);
     }
 
-    *values = temp;
+    free(local);
 
-    memcpy(*values, (char*)data->values + i * full_data_len, full_data_len);
+    if (stat == TNG_SUCCESS && n_frames_div == 0)
+    {
+        /* None of the frame sets contained data of the selected particles. */
+        return (TNG_FAILURE);
+    }
 
-    return (TNG_SUCCESS);
+    return (stat);
 }
 
-tng_function_status DECLSPECDLLEXPORT tng_util_pos_read_range(struct tng_trajectory* tng_data,
-                                                              const int64_t          first_frame,
-                                                              const int64_t          last_frame,
-                                                              float**                positions,
-                                                              int64_t*               stride_length)
+tng_function_status DECLSPECDLLEXPORT tng_util_pos_subset_read_range(struct tng_trajectory* tng_data,
+                                                                     const int64_t first_frame,
+                                                                     const int64_t last_frame,
+                                                                     const int64_t* particles,
+                                                                     const int64_t  n_selected,
+                                                                     float**        positions,
+                                                                     int64_t*       stride_length)
 {
-    int64_t             n_particles, n_values_per_frame;
-    char                type;
-    tng_function_status stat;
-
     TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(particles, "TNG library: particles must not be a NULL pointer");
     TNG_ASSERT(positions, "TNG library: positions must not be a NULL pointer");
     TNG_ASSERT(first_frame <= last_frame,
                "TNG library: first_frame must be lower or equal to last_frame.");
     TNG_ASSERT(stride_length, "TNG library: stride_length must not be a NULL pointer");
 
-    stat = tng_particle_data_vector_interval_get(tng_data, TNG_TRAJ_POSITIONS, first_frame, last_frame,
-                                                 TNG_USE_HASH, (void**)positions, &n_particles,
-                                                 stride_length, &n_values_per_frame, &type);
-
-    if (stat == TNG_SUCCESS && type != TNG_FLOAT_DATA)
-    {
-        return (TNG_FAILURE);
-    }
-
-    return (stat);
+    return (tng_util_particle_data_subset_read_range(tng_data, TNG_TRAJ_POSITIONS, first_frame,
+                                                     last_frame, particles, n_selected, positions,
+                                                     stride_length));
 }
 
-tng_function_status DECLSPECDLLEXPORT tng_util_vel_read_range(struct tng_trajectory* tng_data,
-                                                              const int64_t          first_frame,
-                                                              const int64_t          last_frame,
-                                                              float**                velocities,
-                                                              int64_t*               stride_length)
+tng_function_status DECLSPECDLLEXPORT tng_util_vel_subset_read_range(struct tng_trajectory* tng_data,
+                                                                     const int64_t first_frame,
+                                                                     const int64_t last_frame,
+                                                                     const int64_t* particles,
+                                                                     const int64_t  n_selected,
+                                                                     float**        velocities,
+                                                                     int64_t*       stride_length)
 {
-    int64_t             n_particles, n_values_per_frame;
-    char                type;
-    tng_function_status stat;
-
     TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(particles, "TNG library: particles must not be a NULL pointer");
     TNG_ASSERT(velocities, "TNG library: velocities must not be a NULL pointer");
     TNG_ASSERT(first_frame <= last_frame,
                "TNG library: first_frame must be lower or equal to last_frame.");
     TNG_ASSERT(stride_length, "TNG library: stride_length must not be a NULL pointer");
 
-    stat = tng_particle_data_vector_interval_get(tng_data, TNG_TRAJ_VELOCITIES, first_frame, last_frame,
-                                                 TNG_USE_HASH, (void**)velocities, &n_particles,
-                                                 stride_length, &n_values_per_frame, &type);
-
-    if (stat == TNG_SUCCESS && type != TNG_FLOAT_DATA)
-    {
-        return (TNG_FAILURE);
-    }
-
-    return (stat);
+    return (tng_util_particle_data_subset_read_range(tng_data, TNG_TRAJ_VELOCITIES, first_frame,
+                                                     last_frame, particles, n_selected, velocities,
+                                                     stride_length));
 }
 
-tng_function_status DECLSPECDLLEXPORT tng_util_force_read_range(struct tng_trajectory* tng_data,
-                                                                const int64_t          first_frame,
-                                                                const int64_t          last_frame,
-                                                                float**                forces,
-                                                                int64_t* stride_length)
+tng_function_status DECLSPECDLLEXPORT tng_util_force_subset_read_range(struct tng_trajectory* tng_data,
+                                                                       const int64_t first_frame,
+                                                                       const int64_t last_frame,
+                                                                       const int64_t* particles,
+                                                                       const int64_t  n_selected,
+                                                                       float**        forces,
+                                                                       int64_t*       stride_length)
 {
-    int64_t             n_particles, n_values_per_frame;
-    char                type;
-    tng_function_status stat;
-
     TNG_ASSERT(tng_data, "TNG library: Trajectory container not properly setup.");
+    TNG_ASSERT(particles, "TNG library: particles must not be a NULL pointer");
     TNG_ASSERT(forces, "TNG library: forces must not be a NULL pointer");
     TNG_ASSERT(first_frame <= last_frame,
                "TNG library: first_frame must be lower or equal to last_frame.");
     TNG_ASSERT(stride_length, "TNG library: stride_length must not be a NULL pointer");
 
-    stat = tng_particle_data_vector_interval_get(tng_data, TNG_TRAJ_FORCES, first_frame, last_frame,
-                                                 TNG_USE_HASH, (void**)forces, &n_particles,
-                                                 stride_length, &n_values_per_frame, &type);
-
-    if (stat == TNG_SUCCESS && type != TNG_FLOAT_DATA)
-    {
-        return (TNG_FAILURE);
-    }
-
-    return (stat);
+    return (tng_util_particle_data_subset_read_range(tng_data, TNG_TRAJ_FORCES, first_frame,
+                                                     last_frame, particles, n_selected, forces,
+                                                     stride_length));
 }
 
 tng_function_status DECLSPECDLLEXPORT tng_util_box_shape_read_range(struct tng_trajectory* tng_data,
@@ -15514,20 +21324,13 @@ tng_function_status DECLSPECDLLEXPORT tng_util_generic_write(struct tng_trajecto
         last_frame = frame_set->first_frame + frame_set->n_frames - 1;
         if (frame_nr > last_frame)
         {
-            stat = tng_frame_set_write(tng_data, TNG_USE_HASH);
-            if (stat != TNG_SUCCESS)
-            {
-                fprintf(stderr, "TNG library: Cannot write frame set.  %s: %d\n", __FILE__, __LINE__);
-                return (stat);
-            }
             if (last_frame + tng_data->frame_set_n_frames < frame_nr)
             {
                 last_frame = frame_nr - 1;
             }
-            stat = tng_frame_set_new(tng_data, last_frame + 1, tng_data->frame_set_n_frames);
+            stat = tng_frame_set_write_and_new(tng_data, last_frame + 1, tng_data->frame_set_n_frames);
             if (stat != TNG_SUCCESS)
             {
-                fprintf(stderr, "TNG library: Cannot create frame set.  %s: %d\n", __FILE__, __LINE__);
                 return (stat);
             }
         }
@@ -15726,20 +21529,13 @@ tng_function_status DECLSPECDLLEXPORT tng_util_generic_double_write(struct tng_t
         last_frame = frame_set->first_frame + frame_set->n_frames - 1;
         if (frame_nr > last_frame)
         {
-            stat = tng_frame_set_write(tng_data, TNG_USE_HASH);
-            if (stat != TNG_SUCCESS)
-            {
-                fprintf(stderr, "TNG library: Cannot write frame set.  %s: %d\n", __FILE__, __LINE__);
-                return (stat);
-            }
             if (last_frame + tng_data->frame_set_n_frames < frame_nr)
             {
                 last_frame = frame_nr - 1;
             }
-            stat = tng_frame_set_new(tng_data, last_frame + 1, tng_data->frame_set_n_frames);
+            stat = tng_frame_set_write_and_new(tng_data, last_frame + 1, tng_data->frame_set_n_frames);
             if (stat != TNG_SUCCESS)
             {
-                fprintf(stderr, "TNG library: Cannot create frame set.  %s: %d\n", __FILE__, __LINE__);
                 return (stat);
             }
         }
@@ -16341,7 +22137,7 @@ tng_function_status DECLSPECDLLEXPORT
     /* Check for data blocks only if they have not already been found. */
     if (frame_set->n_particle_data_blocks <= 0 && frame_set->n_data_blocks <= 0)
     {
-        file_pos = ftello(tng_data->input_file);
+        file_pos = tng_input_file_tell(tng_data);
         if (file_pos < tng_data->input_file_len)
         {
             tng_block_init(&block);
@@ -16352,7 +22148,7 @@ tng_function_status DECLSPECDLLEXPORT
                 stat = tng_block_read_next(tng_data, block, TNG_USE_HASH);
                 if (stat != TNG_CRITICAL)
                 {
-                    file_pos = ftello(tng_data->input_file);
+                    file_pos = tng_input_file_tell(tng_data);
                     if (file_pos < tng_data->input_file_len)
                     {
                         stat = tng_block_header_read(tng_data, block);
@@ -16595,15 +22391,15 @@ tng_function_status DECLSPECDLLEXPORT tng_util_num_frames_with_data_of_block_id_
     }
 
     first_frame_set_file_pos = tng_data->first_trajectory_frame_set_input_file_pos;
-    curr_file_pos            = ftello(tng_data->input_file);
-    fseeko(tng_data->input_file, first_frame_set_file_pos, SEEK_SET);
+    curr_file_pos            = tng_input_file_tell(tng_data);
+    tng_input_file_seek(tng_data, first_frame_set_file_pos, SEEK_SET);
 
     stat = tng_frame_set_n_frames_of_data_block_get(tng_data, block_id, &curr_n_frames);
 
     while (stat == TNG_SUCCESS && tng_data->current_trajectory_frame_set.next_frame_set_file_pos != -1)
     {
         *n_frames += curr_n_frames;
-        fseeko(tng_data->input_file, tng_data->current_trajectory_frame_set.next_frame_set_file_pos,
+        tng_input_file_seek(tng_data, tng_data->current_trajectory_frame_set.next_frame_set_file_pos,
                SEEK_SET);
         stat = tng_frame_set_n_frames_of_data_block_get(tng_data, block_id, &curr_n_frames);
     }
@@ -16611,7 +22407,7 @@ tng_function_status DECLSPECDLLEXPORT tng_util_num_frames_with_data_of_block_id_
     {
         *n_frames += curr_n_frames;
     }
-    fseeko(tng_data->input_file, curr_file_pos, SEEK_SET);
+    tng_input_file_seek(tng_data, curr_file_pos, SEEK_SET);
     if (stat == TNG_CRITICAL)
     {
         return (TNG_CRITICAL);
@@ -19,11 +19,16 @@
  */
 
 
+#include <algorithm>
+#include <cstdio>
 #include <iostream>
 #include <fstream>
+#include <string>
+#include <vector>
 
 // is called extern C if __cplusplus is defined, so no need to call it explicitly here //
 #include "tng/tng_io.h"
+#include "compression/tng_compress.h"
 #include "gtest/gtest.h"
 
 #ifdef USE_STD_INTTYPES_H
@@ -926,4 +931,1062 @@ TEST_F(WaterVelsForcesTest, VelValues)
     {
         EXPECT_NEAR(velocities[818100 - 30 + i], frame_100_last_10_values[i], errtol);
     }
-}
\ No newline at end of file
+}
+
+// trajectory written by the tests themselves
+class WrittenTrajectoryTest : public ::testing::Test
+{
+protected:
+    tng_trajectory_t traj        = nullptr;
+    float*           positions   = nullptr;
+    const char*      filename    = "./written_trajectory_test.tng";
+    const int64_t    n_molecules = 10;
+    const int64_t    n_particles = 30;
+    bool             write_behind = false;
+    bool             write_velocities = false;
+    int64_t          n_write_threads  = 1;
+    tng_hash_type    output_hash_type = TNG_MD5;
+
+    static float position_value(int64_t frame, int64_t particle, int64_t dim)
+    {
+        return frame + particle * 0.01f + dim * 0.001f;
+    }
+
+    // write n_frames frames of positions, and optionally velocities with the opposite sign,
+    // starting at first_frame, using frame sets of 10 frames
+    tng_function_status write_frames(char mode, int64_t first_frame, int64_t n_frames)
+    {
+        tng_trajectory_t    out;
+        tng_molecule_t      molecule;
+        tng_chain_t         chain;
+        tng_residue_t       residue;
+        tng_atom_t          atom;
+        tng_function_status stat;
+        std::vector<float>  frame_positions(n_particles * 3);
+
+        stat = tng_util_trajectory_open(filename, mode, &out);
+        if (stat != TNG_SUCCESS)
+        {
+            return stat;
+        }
+        if (write_behind)
+        {
+            tng_write_behind_set(out, TNG_TRUE);
+        }
+        tng_num_write_threads_set(out, n_write_threads);
+        tng_output_hash_type_set(out, output_hash_type);
+        if (mode == 'w')
+        {
+            tng_molecule_add(out, "water", &molecule);
+            tng_molecule_chain_add(out, molecule, "W", &chain);
+            tng_chain_residue_add(out, chain, "WAT", &residue);
+            tng_residue_atom_add(out, residue, "O", "O", &atom);
+            tng_residue_atom_add(out, residue, "HO1", "H", &atom);
+            tng_residue_atom_add(out, residue, "HO2", "H", &atom);
+            tng_molecule_cnt_set(out, molecule, n_molecules);
+            tng_num_frames_per_frame_set_set(out, 10);
+            tng_medium_stride_length_set(out, 3);
+            tng_long_stride_length_set(out, 9);
+            tng_util_pos_write_interval_set(out, 1);
+            if (write_velocities)
+            {
+                tng_util_vel_write_interval_set(out, 1);
+            }
+            tng_file_headers_write(out, TNG_USE_HASH);
+        }
+        for (int64_t frame = first_frame; frame < first_frame + n_frames && stat == TNG_SUCCESS; frame++)
+        {
+            for (int64_t i = 0; i < n_particles * 3; i++)
+            {
+                frame_positions[i] = position_value(frame, i / 3, i % 3);
+            }
+            stat = tng_util_pos_write(out, frame, frame_positions.data());
+            if (write_velocities && stat == TNG_SUCCESS)
+            {
+                for (float& value : frame_positions)
+                {
+                    value = -value;
+                }
+                stat = tng_util_vel_write(out, frame, frame_positions.data());
+            }
+        }
+        tng_util_trajectory_close(&out);
+        return stat;
+    }
+
+    ~WrittenTrajectoryTest() override
+    {
+        tng_util_trajectory_close(&traj);
+        free_float_data_if_present(positions);
+        remove(filename);
+    }
+};
+
+TEST_F(WrittenTrajectoryTest, FrameSetIndexLookup)
+{
+    int64_t                    n_frame_sets, first_frame, last_frame;
+    tng_trajectory_frame_set_t frame_set;
+    ASSERT_EQ(write_frames('w', 0, 95), TNG_SUCCESS);
+    ASSERT_EQ(tng_util_trajectory_open(filename, 'r', &traj), TNG_SUCCESS);
+    EXPECT_EQ(tng_num_frame_sets_get(traj, &n_frame_sets), TNG_SUCCESS);
+    EXPECT_EQ(n_frame_sets, 10);
+    for (int64_t nr = n_frame_sets - 1; nr >= 0; nr -= 3)
+    {
+        EXPECT_EQ(tng_frame_set_nr_find(traj, nr), TNG_SUCCESS);
+        tng_current_frame_set_get(traj, &frame_set);
+        tng_frame_set_frame_range_get(traj, frame_set, &first_frame, &last_frame);
+        EXPECT_EQ(first_frame, nr * 10);
+        EXPECT_EQ(last_frame, std::min<int64_t>(nr * 10 + 9, 94));
+    }
+    EXPECT_EQ(tng_frame_set_nr_find(traj, n_frame_sets), TNG_FAILURE);
+    for (int64_t frame : { 94, 0, 57, 58, 10, 9 })
+    {
+        EXPECT_EQ(tng_frame_set_of_frame_find(traj, frame), TNG_SUCCESS);
+        tng_current_frame_set_get(traj, &frame_set);
+        tng_frame_set_frame_range_get(traj, frame_set, &first_frame, &last_frame);
+        EXPECT_EQ(first_frame, frame / 10 * 10);
+    }
+    EXPECT_EQ(tng_frame_set_of_frame_find(traj, 95), TNG_FAILURE);
+}
+
+TEST_F(WrittenTrajectoryTest, FrameSetIndexAfterAppend)
+{
+    int64_t                    n_frames, stride_length, first_frame, last_frame;
+    tng_trajectory_frame_set_t frame_set;
+    ASSERT_EQ(write_frames('w', 0, 95), TNG_SUCCESS);
+    ASSERT_EQ(write_frames('a', 95, 20), TNG_SUCCESS);
+    ASSERT_EQ(tng_util_trajectory_open(filename, 'r', &traj), TNG_SUCCESS);
+    EXPECT_EQ(tng_num_frames_get(traj, &n_frames), TNG_SUCCESS);
+    EXPECT_EQ(n_frames, 115);
+    EXPECT_EQ(tng_frame_set_of_frame_find(traj, 114), TNG_SUCCESS);
+    tng_current_frame_set_get(traj, &frame_set);
+    tng_frame_set_frame_range_get(traj, frame_set, &first_frame, &last_frame);
+    EXPECT_EQ(last_frame, 114);
+    ASSERT_EQ(tng_util_pos_read_range(traj, 0, n_frames - 1, &positions, &stride_length), TNG_SUCCESS);
+    EXPECT_EQ(stride_length, 1);
+    for (int64_t frame = 0; frame < n_frames; frame += 7)
+    {
+        EXPECT_FLOAT_EQ(positions[(frame * n_particles + 11) * 3 + 2], position_value(frame, 11, 2));
+    }
+}
+
+TEST_F(WrittenTrajectoryTest, FrameCountsAfterReading)
+{
+    int64_t n_frames, n_frame_sets, stride_length;
+    ASSERT_EQ(write_frames('w', 0, 95), TNG_SUCCESS);
+    ASSERT_EQ(tng_util_trajectory_open(filename, 'r', &traj), TNG_SUCCESS);
+    for (int i = 0; i < 2; i++)
+    {
+        EXPECT_EQ(tng_num_frames_get(traj, &n_frames), TNG_SUCCESS);
+        EXPECT_EQ(n_frames, 95);
+        EXPECT_EQ(tng_num_frame_sets_get(traj, &n_frame_sets), TNG_SUCCESS);
+        EXPECT_EQ(n_frame_sets, 10);
+        ASSERT_EQ(tng_util_pos_read_range(traj, 0, 59, &positions, &stride_length), TNG_SUCCESS);
+        EXPECT_FLOAT_EQ(positions[(45 * n_particles + 7) * 3], position_value(45, 7, 0));
+    }
+}
+
+TEST_F(WrittenTrajectoryTest, MemoryMappedRead)
+{
+    int64_t n_frames, stride_length;
+    char    name[TNG_MAX_STR_LEN];
+    ASSERT_EQ(write_frames('w', 0, 95), TNG_SUCCESS);
+    ASSERT_EQ(tng_util_trajectory_open(filename, 'm', &traj), TNG_SUCCESS);
+    EXPECT_EQ(tng_num_frames_get(traj, &n_frames), TNG_SUCCESS);
+    EXPECT_EQ(n_frames, 95);
+    EXPECT_EQ(tng_atom_name_of_particle_nr_get(traj, 28, name, TNG_MAX_STR_LEN), TNG_SUCCESS);
+    EXPECT_STREQ(name, "HO1");
+    ASSERT_EQ(tng_util_pos_read_range(traj, 0, n_frames - 1, &positions, &stride_length), TNG_SUCCESS);
+    for (int64_t frame = 0; frame < n_frames; frame += 5)
+    {
+        EXPECT_FLOAT_EQ(positions[(frame * n_particles + 13) * 3 + 1], position_value(frame, 13, 1));
+    }
+}
+
+TEST_F(WrittenTrajectoryTest, CursorsShareReader)
+{
+    int64_t          stride_length;
+    char             name[TNG_MAX_STR_LEN];
+    tng_trajectory_t cursors[2] = { 0, 0 };
+    float*           cursor_positions[2] = { 0, 0 };
+    ASSERT_EQ(write_frames('w', 0, 95), TNG_SUCCESS);
+    for (char mode : { 'r', 'm' })
+    {
+        ASSERT_EQ(tng_util_trajectory_open(filename, mode, &traj), TNG_SUCCESS);
+        for (int i = 0; i < 2; i++)
+        {
+            ASSERT_EQ(tng_trajectory_cursor_init(traj, &cursors[i]), TNG_SUCCESS);
+        }
+        // interleave reads of different frame sets through the two cursors and the reader
+        EXPECT_EQ(tng_util_pos_read_range(cursors[0], 70, 79, &cursor_positions[0], &stride_length), TNG_SUCCESS);
+        EXPECT_EQ(tng_util_pos_read_range(cursors[1], 20, 29, &cursor_positions[1], &stride_length), TNG_SUCCESS);
+        EXPECT_EQ(tng_util_pos_read_range(traj, 0, 94, &positions, &stride_length), TNG_SUCCESS);
+        for (int64_t frame = 0; frame < 10; frame++)
+        {
+            EXPECT_FLOAT_EQ(cursor_positions[0][(frame * n_particles + 4) * 3], position_value(70 + frame, 4, 0));
+            EXPECT_FLOAT_EQ(cursor_positions[1][(frame * n_particles + 4) * 3], position_value(20 + frame, 4, 0));
+        }
+        EXPECT_FLOAT_EQ(positions[(94 * n_particles + 29) * 3 + 2], position_value(94, 29, 2));
+        EXPECT_EQ(tng_atom_name_of_particle_nr_get(cursors[1], 29, name, TNG_MAX_STR_LEN), TNG_SUCCESS);
+        EXPECT_STREQ(name, "HO2");
+        for (int i = 0; i < 2; i++)
+        {
+            free(cursor_positions[i]);
+            cursor_positions[i] = 0;
+            tng_util_trajectory_close(&cursors[i]);
+        }
+        EXPECT_EQ(tng_atom_name_of_particle_nr_get(traj, 29, name, TNG_MAX_STR_LEN), TNG_SUCCESS);
+        EXPECT_STREQ(name, "HO2");
+        tng_util_trajectory_close(&traj);
+        free(positions);
+        positions = 0;
+    }
+}
+
+TEST_F(WrittenTrajectoryTest, PositionRangeAcrossFrameSets)
+{
+    int64_t n_threads, stride_length;
+    ASSERT_EQ(write_frames('w', 0, 95), TNG_SUCCESS);
+    ASSERT_EQ(tng_util_trajectory_open(filename, 'r', &traj), TNG_SUCCESS);
+    EXPECT_EQ(tng_num_read_threads_set(traj, 0), TNG_FAILURE);
+    // reading with several threads is only available if the library is built with OpenMP
+    for (int64_t threads : { 1, 4 })
+    {
+        if (tng_num_read_threads_set(traj, threads) != TNG_SUCCESS)
+        {
+            continue;
+        }
+        EXPECT_EQ(tng_num_read_threads_get(traj, &n_threads), TNG_SUCCESS);
+        EXPECT_EQ(n_threads, threads);
+        ASSERT_EQ(tng_util_pos_read_range(traj, 7, 83, &positions, &stride_length), TNG_SUCCESS);
+        for (int64_t frame = 7; frame <= 83; frame++)
+        {
+            EXPECT_FLOAT_EQ(positions[((frame - 7) * n_particles + 17) * 3 + 1], position_value(frame, 17, 1));
+        }
+        EXPECT_EQ(tng_util_pos_read_range(traj, 53, 95, &positions, &stride_length), TNG_FAILURE);
+    }
+}
+
+TEST_F(WrittenTrajectoryTest, WriteBehind)
+{
+    int64_t n_frames, n_frame_sets, stride_length;
+    char    flag;
+    ASSERT_EQ(tng_trajectory_init(&traj), TNG_SUCCESS);
+    EXPECT_EQ(tng_write_behind_get(traj, &flag), TNG_SUCCESS);
+    EXPECT_EQ(flag, TNG_FALSE);
+    // writing in the background is only available if the library is built with POSIX threads
+    if (tng_write_behind_set(traj, TNG_TRUE) != TNG_SUCCESS)
+    {
+        GTEST_SKIP();
+    }
+    EXPECT_EQ(tng_write_behind_get(traj, &flag), TNG_SUCCESS);
+    EXPECT_EQ(flag, TNG_TRUE);
+    EXPECT_EQ(tng_write_behind_set(traj, TNG_FALSE), TNG_SUCCESS);
+    tng_trajectory_destroy(&traj);
+
+    write_behind = true;
+    ASSERT_EQ(write_frames('w', 0, 95), TNG_SUCCESS);
+    ASSERT_EQ(write_frames('a', 95, 20), TNG_SUCCESS);
+    ASSERT_EQ(tng_util_trajectory_open(filename, 'r', &traj), TNG_SUCCESS);
+    EXPECT_EQ(tng_num_frames_get(traj, &n_frames), TNG_SUCCESS);
+    EXPECT_EQ(n_frames, 115);
+    EXPECT_EQ(tng_num_frame_sets_get(traj, &n_frame_sets), TNG_SUCCESS);
+    EXPECT_EQ(n_frame_sets, 12);
+    ASSERT_EQ(tng_util_pos_read_range(traj, 0, 114, &positions, &stride_length), TNG_SUCCESS);
+    for (int64_t frame = 0; frame < 115; frame++)
+    {
+        EXPECT_FLOAT_EQ(positions[(frame * n_particles + 29) * 3 + 2], position_value(frame, 29, 2));
+    }
+}
+
+TEST_F(WrittenTrajectoryTest, ParallelCompression)
+{
+    int64_t n_threads, n_frames, stride_length;
+    float*  velocities = nullptr;
+    ASSERT_EQ(tng_trajectory_init(&traj), TNG_SUCCESS);
+    EXPECT_EQ(tng_num_write_threads_get(traj, &n_threads), TNG_SUCCESS);
+    EXPECT_EQ(n_threads, 1);
+    EXPECT_EQ(tng_num_write_threads_set(traj, 0), TNG_FAILURE);
+    // compressing with several threads is only available if the library is built with OpenMP
+    if (tng_num_write_threads_set(traj, 4) != TNG_SUCCESS)
+    {
+        GTEST_SKIP();
+    }
+    tng_trajectory_destroy(&traj);
+
+    n_write_threads  = 4;
+    write_velocities = true;
+    ASSERT_EQ(write_frames('w', 0, 95), TNG_SUCCESS);
+    ASSERT_EQ(write_frames('a', 95, 20), TNG_SUCCESS);
+    ASSERT_EQ(tng_util_trajectory_open(filename, 'r', &traj), TNG_SUCCESS);
+    EXPECT_EQ(tng_num_frames_get(traj, &n_frames), TNG_SUCCESS);
+    EXPECT_EQ(n_frames, 115);
+    ASSERT_EQ(tng_util_pos_read_range(traj, 0, 114, &positions, &stride_length), TNG_SUCCESS);
+    ASSERT_EQ(tng_util_vel_read_range(traj, 0, 114, &velocities, &stride_length), TNG_SUCCESS);
+    for (int64_t frame = 0; frame < 115; frame++)
+    {
+        EXPECT_FLOAT_EQ(positions[(frame * n_particles + 21) * 3], position_value(frame, 21, 0));
+        EXPECT_FLOAT_EQ(velocities[(frame * n_particles + 21) * 3], -position_value(frame, 21, 0));
+    }
+    free(velocities);
+}
+
+TEST_F(WrittenTrajectoryTest, PositionRangeIntoCallerArray)
+{
+    int64_t            stride_length;
+    const int64_t      frame_values = n_particles * 3;
+    const int64_t      frame_stride = frame_values + 5;
+    std::vector<float> packed(77 * frame_values), strided(77 * frame_stride, -1.0f);
+    ASSERT_EQ(write_frames('w', 0, 95), TNG_SUCCESS);
+    ASSERT_EQ(tng_util_trajectory_open(filename, 'r', &traj), TNG_SUCCESS);
+    ASSERT_EQ(tng_util_pos_read_range_into(traj, 7, 83, packed.data(), packed.size(), 0, &stride_length),
+              TNG_SUCCESS);
+    EXPECT_EQ(stride_length, 1);
+    ASSERT_EQ(tng_util_pos_read_range(traj, 7, 83, &positions, &stride_length), TNG_SUCCESS);
+    EXPECT_EQ(memcmp(packed.data(), positions, packed.size() * sizeof(float)), 0);
+    ASSERT_EQ(tng_util_pos_read_range_into(traj, 7, 83, strided.data(), strided.size(), frame_stride,
+                                           &stride_length),
+              TNG_SUCCESS);
+    for (int64_t frame = 7; frame <= 83; frame++)
+    {
+        const float* values = strided.data() + (frame - 7) * frame_stride;
+        EXPECT_FLOAT_EQ(values[29 * 3 + 2], position_value(frame, 29, 2));
+        // the values between the frames are not touched
+        EXPECT_EQ(values[frame_values], -1.0f);
+    }
+    // the array is too small or there are no velocities
+    EXPECT_EQ(tng_util_pos_read_range_into(traj, 7, 84, packed.data(), packed.size(), 0, &stride_length),
+              TNG_FAILURE);
+    EXPECT_EQ(tng_util_vel_read_range_into(traj, 7, 83, packed.data(), packed.size(), 0, &stride_length),
+              TNG_FAILURE);
+}
+
+TEST_F(WrittenTrajectoryTest, ParticleDataValuesInterval)
+{
+    union data_values*** values = 0;
+    int64_t              n_values_per_frame, values_n_particles;
+    char                 type;
+    ASSERT_EQ(write_frames('w', 0, 95), TNG_SUCCESS);
+    ASSERT_EQ(tng_util_trajectory_open(filename, 'r', &traj), TNG_SUCCESS);
+    ASSERT_EQ(tng_particle_data_interval_get(traj, TNG_TRAJ_POSITIONS, 7, 83, TNG_USE_HASH, &values,
+                                             &values_n_particles, &n_values_per_frame, &type),
+              TNG_SUCCESS);
+    ASSERT_EQ(values_n_particles, n_particles);
+    ASSERT_EQ(n_values_per_frame, 3);
+    ASSERT_EQ(type, TNG_FLOAT_DATA);
+    // the values of all frames and particles are stored in one block
+    EXPECT_EQ(values[76][n_particles - 1], values[0][0] + (77 * n_particles - 1) * 3);
+    for (int64_t frame = 7; frame <= 83; frame++)
+    {
+        EXPECT_FLOAT_EQ(values[frame - 7][29][2].f, position_value(frame, 29, 2));
+    }
+    EXPECT_EQ(tng_particle_data_values_free(traj, values, 77, n_particles, n_values_per_frame, type),
+              TNG_SUCCESS);
+}
+
+TEST_F(WrittenTrajectoryTest, PositionSubsetRange)
+{
+    int64_t       stride_length;
+    const int64_t selected[] = { 0, 4, 17, 29 };
+    const int64_t unsorted[] = { 4, 0 };
+    float*        subset     = nullptr;
+    ASSERT_EQ(write_frames('w', 0, 95), TNG_SUCCESS);
+    ASSERT_EQ(tng_util_trajectory_open(filename, 'r', &traj), TNG_SUCCESS);
+    ASSERT_EQ(tng_util_pos_subset_read_range(traj, 7, 83, selected, 4, &subset, &stride_length),
+              TNG_SUCCESS);
+    EXPECT_EQ(stride_length, 1);
+    ASSERT_EQ(tng_util_pos_read_range(traj, 7, 83, &positions, &stride_length), TNG_SUCCESS);
+    for (int64_t frame = 0; frame < 77; frame++)
+    {
+        for (int64_t j = 0; j < 4; j++)
+        {
+            EXPECT_EQ(memcmp(subset + (frame * 4 + j) * 3,
+                             positions + (frame * n_particles + selected[j]) * 3, 3 * sizeof(float)),
+                      0);
+        }
+    }
+    EXPECT_EQ(tng_util_pos_subset_read_range(traj, 7, 83, unsorted, 2, &subset, &stride_length),
+              TNG_FAILURE);
+    EXPECT_EQ(tng_util_vel_subset_read_range(traj, 7, 83, selected, 4, &subset, &stride_length),
+              TNG_FAILURE);
+    free(subset);
+}
+
+TEST_F(WrittenTrajectoryTest, PositionSubsetRangeMappedBlocks)
+{
+    tng_molecule_t       molecule;
+    tng_chain_t          chain;
+    tng_residue_t        residue;
+    tng_atom_t           atom;
+    int64_t              stride_length, header_pos, header_size, contents_size;
+    std::vector<int64_t> mapping(n_particles);
+    std::vector<float>   frame_set_positions(10 * n_particles * 3);
+    std::vector<char>    contents;
+    std::string          errors;
+    const std::string    name("POSITIONS");
+    const int64_t        selected[] = { 0, 7, 21, 29 };
+    const int64_t        odd[]      = { 3, 11 };
+    float*               subset     = nullptr;
+    ASSERT_EQ(tng_trajectory_init(&traj), TNG_SUCCESS);
+    ASSERT_EQ(tng_output_file_set(traj, filename), TNG_SUCCESS);
+    tng_molecule_add(traj, "water", &molecule);
+    tng_molecule_chain_add(traj, molecule, "W", &chain);
+    tng_chain_residue_add(traj, chain, "WAT", &residue);
+    tng_residue_atom_add(traj, residue, "O", "O", &atom);
+    tng_residue_atom_add(traj, residue, "HO1", "H", &atom);
+    tng_residue_atom_add(traj, residue, "HO2", "H", &atom);
+    tng_molecule_cnt_set(traj, molecule, n_molecules);
+    tng_num_frames_per_frame_set_set(traj, 10);
+    ASSERT_EQ(tng_file_headers_write(traj, TNG_USE_HASH), TNG_SUCCESS);
+    // three mapping blocks per frame set: the last ten particles in reverse order,
+    // the even and the odd particles of the first twenty
+    for (int64_t k = 0; k < n_particles; k++)
+    {
+        mapping[k] = k < 10 ? 29 - k : k < 20 ? 2 * (k - 10) : 2 * (k - 20) + 1;
+    }
+    for (int64_t first_frame = 0; first_frame < 30; first_frame += 10)
+    {
+        ASSERT_EQ(tng_frame_set_new(traj, first_frame, 10), TNG_SUCCESS);
+        tng_frame_set_particle_mapping_free(traj);
+        for (int64_t first = 0; first < n_particles; first += 10)
+        {
+            ASSERT_EQ(tng_particle_mapping_add(traj, first, 10, &mapping[first]), TNG_SUCCESS);
+        }
+        for (int64_t i = 0; i < 10 * n_particles * 3; i++)
+        {
+            frame_set_positions[i] = position_value(first_frame + i / (n_particles * 3),
+                                                    mapping[i / 3 % n_particles], i % 3);
+        }
+        ASSERT_EQ(tng_particle_data_block_add(traj, TNG_TRAJ_POSITIONS, "POSITIONS", TNG_FLOAT_DATA,
+                                              TNG_TRAJECTORY_BLOCK, 10, 3, 1, 0, n_particles,
+                                              TNG_UNCOMPRESSED, frame_set_positions.data()),
+                  TNG_SUCCESS);
+        ASSERT_EQ(tng_frame_set_write(traj, TNG_USE_HASH), TNG_SUCCESS);
+    }
+    tng_trajectory_destroy(&traj);
+
+    ASSERT_EQ(tng_util_trajectory_open(filename, 'r', &traj), TNG_SUCCESS);
+    ASSERT_EQ(tng_util_pos_subset_read_range(traj, 4, 25, selected, 4, &subset, &stride_length),
+              TNG_SUCCESS);
+    ASSERT_EQ(tng_util_pos_read_range(traj, 4, 25, &positions, &stride_length), TNG_SUCCESS);
+    for (int64_t frame = 0; frame < 22; frame++)
+    {
+        for (int64_t j = 0; j < 4; j++)
+        {
+            EXPECT_FLOAT_EQ(subset[(frame * 4 + j) * 3 + 1], position_value(frame + 4, selected[j], 1));
+            EXPECT_EQ(memcmp(subset + (frame * 4 + j) * 3,
+                             positions + (frame * n_particles + selected[j]) * 3, 3 * sizeof(float)),
+                      0);
+        }
+    }
+    tng_util_trajectory_close(&traj);
+
+    // corrupt the positions of the reversed and the even particles, which must not be
+    // read when only odd particles are selected
+    std::ifstream in(filename, std::ios::binary);
+    contents.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    in.close();
+    auto name_pos = contents.begin();
+    for (int64_t n_blocks = 0;; n_blocks++)
+    {
+        name_pos = std::search(name_pos, contents.end(), name.c_str(), name.c_str() + name.size() + 1);
+        if (name_pos == contents.end())
+        {
+            EXPECT_EQ(n_blocks, 9);
+            break;
+        }
+        if (n_blocks % 3 != 2)
+        {
+            header_pos = (name_pos - contents.begin()) - 3 * sizeof(int64_t) - TNG_MD5_HASH_LEN;
+            memcpy(&header_size, &contents[header_pos], sizeof(int64_t));
+            memcpy(&contents_size, &contents[header_pos + sizeof(int64_t)], sizeof(int64_t));
+            contents[header_pos + header_size + contents_size - 1] ^= 0x5a;
+        }
+        name_pos++;
+    }
+    std::ofstream out(filename, std::ios::binary);
+    out.write(contents.data(), contents.size());
+    out.close();
+
+    ASSERT_EQ(tng_util_trajectory_open(filename, 'r', &traj), TNG_SUCCESS);
+    testing::internal::CaptureStderr();
+    ASSERT_EQ(tng_util_pos_subset_read_range(traj, 0, 29, odd, 2, &subset, &stride_length),
+              TNG_SUCCESS);
+    errors = testing::internal::GetCapturedStderr();
+    EXPECT_EQ(errors.find("Hashes do not match"), std::string::npos) << errors;
+    EXPECT_FLOAT_EQ(subset[(29 * 2 + 1) * 3 + 2], position_value(29, 11, 2));
+    testing::internal::CaptureStderr();
+    ASSERT_EQ(tng_util_pos_read_range(traj, 0, 29, &positions, &stride_length), TNG_SUCCESS);
+    errors = testing::internal::GetCapturedStderr();
+    EXPECT_NE(errors.find("Hashes do not match"), std::string::npos);
+    free(subset);
+}
+
+TEST_F(WrittenTrajectoryTest, FrameSetReadBlockIds)
+{
+    union data_values*** values = 0;
+    int64_t              n_block_ids, n_frames, values_n_particles, n_values_per_frame;
+    int64_t              n_read   = 0;
+    const int64_t*       block_ids;
+    const int64_t        read_ids[] = { TNG_TRAJ_VELOCITIES };
+    char                 type;
+    write_velocities = true;
+    ASSERT_EQ(write_frames('w', 0, 95), TNG_SUCCESS);
+    ASSERT_EQ(tng_trajectory_init(&traj), TNG_SUCCESS);
+    ASSERT_EQ(tng_input_file_set(traj, filename), TNG_SUCCESS);
+    ASSERT_EQ(tng_file_headers_read(traj, TNG_USE_HASH), TNG_SUCCESS);
+    EXPECT_EQ(tng_frame_set_read_block_ids_get(traj, &n_block_ids, &block_ids), TNG_SUCCESS);
+    EXPECT_EQ(n_block_ids, 0);
+    ASSERT_EQ(tng_frame_set_read_block_ids_set(traj, 1, read_ids), TNG_SUCCESS);
+    EXPECT_EQ(tng_frame_set_read_block_ids_get(traj, &n_block_ids, &block_ids), TNG_SUCCESS);
+    ASSERT_EQ(n_block_ids, 1);
+    EXPECT_EQ(block_ids[0], TNG_TRAJ_VELOCITIES);
+    while (tng_frame_set_read_next(traj, TNG_USE_HASH) == TNG_SUCCESS)
+    {
+        n_read++;
+    }
+    EXPECT_EQ(n_read, 10);
+    // the positions are skipped and the velocities of the last frame set are read
+    EXPECT_NE(tng_particle_data_get(traj, TNG_TRAJ_POSITIONS, &values, &n_frames, &values_n_particles,
+                                    &n_values_per_frame, &type),
+              TNG_SUCCESS);
+    ASSERT_EQ(tng_particle_data_get(traj, TNG_TRAJ_VELOCITIES, &values, &n_frames, &values_n_particles,
+                                    &n_values_per_frame, &type),
+              TNG_SUCCESS);
+    ASSERT_EQ(n_frames, 5);
+    EXPECT_FLOAT_EQ(values[4][13][1].f, -position_value(94, 13, 1));
+    EXPECT_EQ(tng_particle_data_values_free(traj, values, n_frames, values_n_particles,
+                                            n_values_per_frame, type),
+              TNG_SUCCESS);
+    EXPECT_EQ(tng_frame_set_read_block_ids_set(traj, 0, nullptr), TNG_SUCCESS);
+    EXPECT_EQ(tng_frame_set_read_block_ids_get(traj, &n_block_ids, &block_ids), TNG_SUCCESS);
+    EXPECT_EQ(n_block_ids, 0);
+}
+
+TEST_F(WrittenTrajectoryTest, BlockHeadersAndFrameSetFields)
+{
+    tng_trajectory_frame_set_t frame_set;
+    int64_t                    first_frame, last_frame, stride_length;
+    char                       name[TNG_MAX_STR_LEN];
+    ASSERT_EQ(write_frames('w', 0, 95), TNG_SUCCESS);
+    ASSERT_EQ(tng_util_trajectory_open(filename, 'r', &traj), TNG_SUCCESS);
+    ASSERT_EQ(tng_frame_set_nr_find(traj, 9), TNG_SUCCESS);
+    ASSERT_EQ(tng_current_frame_set_get(traj, &frame_set), TNG_SUCCESS);
+    ASSERT_EQ(tng_frame_set_frame_range_get(traj, frame_set, &first_frame, &last_frame), TNG_SUCCESS);
+    EXPECT_EQ(first_frame, 90);
+    EXPECT_EQ(last_frame, 94);
+    ASSERT_EQ(tng_util_pos_read_range(traj, 90, 94, &positions, &stride_length), TNG_SUCCESS);
+    EXPECT_FLOAT_EQ(positions[(4 * n_particles + 3) * 3], position_value(94, 3, 0));
+    ASSERT_EQ(tng_data_block_name_get(traj, TNG_TRAJ_POSITIONS, name, sizeof(name)), TNG_SUCCESS);
+    EXPECT_STREQ(name, "POSITIONS");
+}
+
+TEST_F(WrittenTrajectoryTest, BigEndianUncompressedAndGzippedData)
+{
+    tng_trajectory_t    out;
+    std::vector<double> frame_doubles(4);
+    std::vector<float>  frame_floats(4);
+    void*               values = nullptr;
+    int64_t             stride_length, n_values_per_frame;
+    char                type;
+    ASSERT_EQ(tng_util_trajectory_open(filename, 'w', &out), TNG_SUCCESS);
+    ASSERT_EQ(tng_output_file_endianness_set(out, TNG_BIG_ENDIAN), TNG_SUCCESS);
+    tng_num_frames_per_frame_set_set(out, 10);
+    tng_util_generic_write_interval_double_set(out, 1, 4, TNG_GMX_LAMBDA, "UNCOMPRESSED DOUBLES",
+                                               TNG_NON_PARTICLE_BLOCK_DATA, TNG_UNCOMPRESSED);
+    tng_util_generic_write_interval_set(out, 1, 4, TNG_GMX_ENERGY_ANGLE, "GZIPPED FLOATS",
+                                        TNG_NON_PARTICLE_BLOCK_DATA, TNG_GZIP_COMPRESSION);
+    tng_file_headers_write(out, TNG_USE_HASH);
+    for (int64_t frame = 0; frame < 25; frame++)
+    {
+        for (int64_t i = 0; i < 4; i++)
+        {
+            frame_doubles[i] = position_value(frame, 0, i) * 1e10;
+            frame_floats[i]  = -position_value(frame, 0, i);
+        }
+        ASSERT_EQ(tng_util_generic_double_write(out, frame, frame_doubles.data(), 4, TNG_GMX_LAMBDA,
+                                                "UNCOMPRESSED DOUBLES", TNG_NON_PARTICLE_BLOCK_DATA,
+                                                TNG_UNCOMPRESSED),
+                  TNG_SUCCESS);
+        ASSERT_EQ(tng_util_generic_write(out, frame, frame_floats.data(), 4, TNG_GMX_ENERGY_ANGLE,
+                                         "GZIPPED FLOATS", TNG_NON_PARTICLE_BLOCK_DATA,
+                                         TNG_GZIP_COMPRESSION),
+                  TNG_SUCCESS);
+    }
+    tng_util_trajectory_close(&out);
+
+    // read back both from the file and from a memory mapping of it
+    for (char mode : { 'r', 'm' })
+    {
+        ASSERT_EQ(tng_util_trajectory_open(filename, mode, &traj), TNG_SUCCESS);
+        ASSERT_EQ(tng_data_vector_interval_get(traj, TNG_GMX_LAMBDA, 3, 24, TNG_USE_HASH, &values,
+                                               &stride_length, &n_values_per_frame, &type),
+                  TNG_SUCCESS);
+        ASSERT_EQ(type, TNG_DOUBLE_DATA);
+        ASSERT_EQ(n_values_per_frame, 4);
+        for (int64_t frame = 3; frame < 25; frame++)
+        {
+            for (int64_t i = 0; i < 4; i++)
+            {
+                EXPECT_EQ(static_cast<double*>(values)[(frame - 3) * 4 + i],
+                          position_value(frame, 0, i) * 1e10);
+            }
+        }
+        free(values);
+        values = nullptr;
+        ASSERT_EQ(tng_data_vector_interval_get(traj, TNG_GMX_ENERGY_ANGLE, 3, 24, TNG_USE_HASH,
+                                               &values, &stride_length, &n_values_per_frame, &type),
+                  TNG_SUCCESS);
+        ASSERT_EQ(type, TNG_FLOAT_DATA);
+        for (int64_t frame = 3; frame < 25; frame++)
+        {
+            for (int64_t i = 0; i < 4; i++)
+            {
+                EXPECT_EQ(static_cast<float*>(values)[(frame - 3) * 4 + i],
+                          -position_value(frame, 0, i));
+            }
+        }
+        free(values);
+        values = nullptr;
+        tng_util_trajectory_close(&traj);
+    }
+}
+
+TEST_F(WrittenTrajectoryTest, XXH64BlockHashes)
+{
+    int64_t       n_frames, stride_length;
+    tng_hash_type type;
+    FILE*         file;
+    std::string   errors;
+    output_hash_type = TNG_XXH64;
+    ASSERT_EQ(write_frames('w', 0, 95), TNG_SUCCESS);
+    ASSERT_EQ(tng_util_trajectory_open(filename, 'r', &traj), TNG_SUCCESS);
+    EXPECT_EQ(tng_output_hash_type_set(traj, TNG_SHA256), TNG_FAILURE);
+    EXPECT_EQ(tng_output_hash_type_get(traj, &type), TNG_SUCCESS);
+    EXPECT_EQ(type, TNG_MD5);
+    EXPECT_EQ(tng_num_frames_get(traj, &n_frames), TNG_SUCCESS);
+    EXPECT_EQ(n_frames, 95);
+    testing::internal::CaptureStderr();
+    ASSERT_EQ(tng_util_pos_read_range(traj, 0, n_frames - 1, &positions, &stride_length), TNG_SUCCESS);
+    errors = testing::internal::GetCapturedStderr();
+    EXPECT_EQ(errors.find("Hashes do not match"), std::string::npos) << errors;
+    EXPECT_FLOAT_EQ(positions[(94 * n_particles + 29) * 3 + 2], position_value(94, 29, 2));
+    tng_util_trajectory_close(&traj);
+
+    // corrupt the last byte of the file, in the frame set index block
+    file = fopen(filename, "r+b");
+    ASSERT_NE(file, nullptr);
+    fseek(file, -1, SEEK_END);
+    int last_byte = fgetc(file);
+    fseek(file, -1, SEEK_END);
+    fputc(~last_byte, file);
+    fclose(file);
+    free_float_data_if_present(positions);
+    positions = nullptr;
+    testing::internal::CaptureStderr();
+    ASSERT_EQ(tng_util_trajectory_open(filename, 'r', &traj), TNG_SUCCESS);
+    errors = testing::internal::GetCapturedStderr();
+    EXPECT_NE(errors.find("Hashes do not match"), std::string::npos);
+}
+
+TEST_F(WrittenTrajectoryTest, DeferredHashVerification)
+{
+    int64_t              n_frames, stride_length, n_mismatches, header_pos, header_size, contents_size;
+    int64_t*             mismatches = nullptr;
+    std::vector<int64_t> reported;
+    std::vector<char>    contents;
+    const std::string    name("POSITIONS");
+    char                 flag;
+    ASSERT_EQ(write_frames('w', 0, 95), TNG_SUCCESS);
+    ASSERT_EQ(tng_util_trajectory_open(filename, 'r', &traj), TNG_SUCCESS);
+    // verifying the hashes in the background is only available if the library is built with POSIX threads
+    if (tng_deferred_hash_verification_set(traj, TNG_TRUE) != TNG_SUCCESS)
+    {
+        GTEST_SKIP();
+    }
+    EXPECT_EQ(tng_deferred_hash_verification_get(traj, &flag), TNG_SUCCESS);
+    EXPECT_EQ(flag, TNG_TRUE);
+    EXPECT_EQ(tng_num_frames_get(traj, &n_frames), TNG_SUCCESS);
+    ASSERT_EQ(tng_util_pos_read_range(traj, 0, n_frames - 1, &positions, &stride_length), TNG_SUCCESS);
+    EXPECT_EQ(tng_deferred_hash_verification_wait(traj), TNG_SUCCESS);
+    EXPECT_EQ(tng_hash_mismatches_get(traj, &n_mismatches, &mismatches), TNG_SUCCESS);
+    EXPECT_EQ(n_mismatches, 0);
+    tng_util_trajectory_close(&traj);
+    free_float_data_if_present(positions);
+    positions = nullptr;
+
+    // corrupt the last byte of the positions block of the last frame set
+    std::ifstream in(filename, std::ios::binary);
+    contents.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    in.close();
+    auto name_pos = std::find_end(contents.begin(), contents.end(), name.c_str(),
+                                  name.c_str() + name.size() + 1);
+    ASSERT_NE(name_pos, contents.end());
+    header_pos = (name_pos - contents.begin()) - 3 * sizeof(int64_t) - TNG_MD5_HASH_LEN;
+    memcpy(&header_size, &contents[header_pos], sizeof(int64_t));
+    memcpy(&contents_size, &contents[header_pos + sizeof(int64_t)], sizeof(int64_t));
+    contents[header_pos + header_size + contents_size - 1] ^= 0x5a;
+    std::ofstream out(filename, std::ios::binary);
+    out.write(contents.data(), contents.size());
+    out.close();
+
+    ASSERT_EQ(tng_util_trajectory_open(filename, 'r', &traj), TNG_SUCCESS);
+    ASSERT_EQ(tng_deferred_hash_verification_set(traj, TNG_TRUE), TNG_SUCCESS);
+    tng_hash_mismatch_callback_set(
+            traj,
+            [](int64_t block_id, int64_t file_pos, void* user_data) {
+                EXPECT_EQ(block_id, TNG_TRAJ_POSITIONS);
+                static_cast<std::vector<int64_t>*>(user_data)->push_back(file_pos);
+            },
+            &reported);
+    tng_util_pos_read_range(traj, 0, n_frames - 1, &positions, &stride_length);
+    EXPECT_EQ(tng_deferred_hash_verification_wait(traj), TNG_SUCCESS);
+    EXPECT_EQ(tng_hash_mismatches_get(traj, &n_mismatches, &mismatches), TNG_SUCCESS);
+    ASSERT_EQ(n_mismatches, 1);
+    EXPECT_EQ(mismatches[0], header_pos);
+    EXPECT_EQ(reported, std::vector<int64_t>{ header_pos });
+    free(mismatches);
+}
+
+TEST_F(WrittenTrajectoryTest, FrameSetPrefetch)
+{
+    tng_trajectory_frame_set_t frame_set;
+    void*                      values = nullptr;
+    int64_t                    n_frame_sets, frame, first_frame, last_frame, n_read = 0;
+    double                     time;
+    char                       type;
+    ASSERT_EQ(write_frames('w', 0, 95), TNG_SUCCESS);
+    ASSERT_EQ(tng_util_trajectory_open(filename, 'r', &traj), TNG_SUCCESS);
+    // reading ahead is only available if the library is built with POSIX threads
+    if (tng_frame_set_prefetch_set(traj, 3) != TNG_SUCCESS)
+    {
+        GTEST_SKIP();
+    }
+    EXPECT_EQ(tng_frame_set_prefetch_get(traj, &n_frame_sets), TNG_SUCCESS);
+    EXPECT_EQ(n_frame_sets, 3);
+    for (int64_t expected = 0; expected < 95; expected++)
+    {
+        ASSERT_EQ(tng_util_particle_data_next_frame_read(traj, TNG_TRAJ_POSITIONS, &values, &type,
+                                                         &frame, &time),
+                  TNG_SUCCESS);
+        ASSERT_EQ(frame, expected);
+        ASSERT_EQ(type, TNG_FLOAT_DATA);
+        EXPECT_FLOAT_EQ(static_cast<float*>(values)[29 * 3 + 2], position_value(frame, 29, 2));
+    }
+    EXPECT_NE(tng_util_particle_data_next_frame_read(traj, TNG_TRAJ_POSITIONS, &values, &type,
+                                                     &frame, &time),
+              TNG_SUCCESS);
+    free(values);
+
+    // jumping to another frame set discards the frame sets read ahead
+    ASSERT_EQ(tng_frame_set_nr_find(traj, 2), TNG_SUCCESS);
+    while (tng_frame_set_read_next(traj, TNG_SKIP_HASH) == TNG_SUCCESS)
+    {
+        ASSERT_EQ(tng_current_frame_set_get(traj, &frame_set), TNG_SUCCESS);
+        ASSERT_EQ(tng_frame_set_frame_range_get(traj, frame_set, &first_frame, &last_frame), TNG_SUCCESS);
+        EXPECT_EQ(first_frame, 30 + n_read * 10);
+        n_read++;
+    }
+    EXPECT_EQ(n_read, 7);
+    EXPECT_EQ(tng_frame_set_prefetch_set(traj, 0), TNG_SUCCESS);
+    EXPECT_EQ(tng_frame_set_prefetch_get(traj, &n_frame_sets), TNG_SUCCESS);
+    EXPECT_EQ(n_frame_sets, 0);
+}
+
+TEST_F(WrittenTrajectoryTest, FrameSetCache)
+{
+    int64_t           max_size, stride_length, header_pos, header_size, contents_size;
+    std::vector<char> contents;
+    const std::string name("POSITIONS");
+    std::string       errors;
+    ASSERT_EQ(write_frames('w', 0, 95), TNG_SUCCESS);
+    std::ifstream in(filename, std::ios::binary);
+    contents.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    in.close();
+    auto name_pos = std::find_end(contents.begin(), contents.end(), name.c_str(),
+                                  name.c_str() + name.size() + 1);
+    ASSERT_NE(name_pos, contents.end());
+    header_pos = (name_pos - contents.begin()) - 3 * sizeof(int64_t) - TNG_MD5_HASH_LEN;
+    memcpy(&header_size, &contents[header_pos], sizeof(int64_t));
+    memcpy(&contents_size, &contents[header_pos + sizeof(int64_t)], sizeof(int64_t));
+
+    ASSERT_EQ(tng_util_trajectory_open(filename, 'r', &traj), TNG_SUCCESS);
+    EXPECT_EQ(tng_frame_set_cache_size_set(traj, 1 << 20), TNG_SUCCESS);
+    EXPECT_EQ(tng_frame_set_cache_size_get(traj, &max_size), TNG_SUCCESS);
+    EXPECT_EQ(max_size, 1 << 20);
+    ASSERT_EQ(tng_util_pos_read_range(traj, 0, 94, &positions, &stride_length), TNG_SUCCESS);
+    free_float_data_if_present(positions);
+    positions = nullptr;
+
+    // corrupt the last byte of the cached positions block of the last frame set
+    std::fstream file(filename, std::ios::in | std::ios::out | std::ios::binary);
+    file.seekp(header_pos + header_size + contents_size - 1);
+    file.put(contents[header_pos + header_size + contents_size - 1] ^ 0x5a);
+    file.close();
+    testing::internal::CaptureStderr();
+    ASSERT_EQ(tng_util_pos_read_range(traj, 85, 94, &positions, &stride_length), TNG_SUCCESS);
+    errors = testing::internal::GetCapturedStderr();
+    EXPECT_EQ(errors.find("Hashes do not match"), std::string::npos) << errors;
+    EXPECT_FLOAT_EQ(positions[(9 * n_particles + 29) * 3 + 2], position_value(94, 29, 2));
+    free_float_data_if_present(positions);
+    positions = nullptr;
+
+    // without the cache the block is read from the file again
+    EXPECT_EQ(tng_frame_set_cache_size_set(traj, 0), TNG_SUCCESS);
+    EXPECT_EQ(tng_frame_set_cache_size_get(traj, &max_size), TNG_SUCCESS);
+    EXPECT_EQ(max_size, 0);
+    testing::internal::CaptureStderr();
+    tng_util_pos_read_range(traj, 85, 94, &positions, &stride_length);
+    errors = testing::internal::GetCapturedStderr();
+    EXPECT_NE(errors.find("Hashes do not match"), std::string::npos);
+}
+
+TEST_F(WrittenTrajectoryTest, ManyDataBlocks)
+{
+    tng_trajectory_t    out;
+    const int64_t       n_blocks = 40;
+    const int64_t       first_id = 0x2000000000000000LL;
+    void*               values   = nullptr;
+    int64_t             stride_length, n_values_per_frame;
+    char                type;
+    ASSERT_EQ(tng_util_trajectory_open(filename, 'w', &out), TNG_SUCCESS);
+    tng_num_frames_per_frame_set_set(out, 10);
+    // enough blocks for the block ID index to be rebuilt with more slots a few times
+    for (int64_t block = 0; block < n_blocks; block++)
+    {
+        tng_util_generic_write_interval_double_set(out, 1, 1, first_id + block, "OBSERVABLE",
+                                                   TNG_NON_PARTICLE_BLOCK_DATA, TNG_UNCOMPRESSED);
+    }
+    tng_file_headers_write(out, TNG_USE_HASH);
+    for (int64_t frame = 0; frame < 25; frame++)
+    {
+        for (int64_t block = 0; block < n_blocks; block++)
+        {
+            double value = frame * 1000.0 + block;
+            ASSERT_EQ(tng_util_generic_double_write(out, frame, &value, 1, first_id + block,
+                                                    "OBSERVABLE", TNG_NON_PARTICLE_BLOCK_DATA,
+                                                    TNG_UNCOMPRESSED),
+                      TNG_SUCCESS);
+        }
+    }
+    tng_util_trajectory_close(&out);
+
+    ASSERT_EQ(tng_util_trajectory_open(filename, 'r', &traj), TNG_SUCCESS);
+    for (int64_t block = n_blocks - 1; block >= 0; block--)
+    {
+        ASSERT_EQ(tng_data_vector_interval_get(traj, first_id + block, 3, 24, TNG_USE_HASH,
+                                               &values, &stride_length, &n_values_per_frame, &type),
+                  TNG_SUCCESS);
+        ASSERT_EQ(n_values_per_frame, 1);
+        for (int64_t frame = 3; frame < 25; frame++)
+        {
+            EXPECT_EQ(static_cast<double*>(values)[frame - 3], frame * 1000.0 + block);
+        }
+        free(values);
+        values = nullptr;
+    }
+    EXPECT_NE(tng_data_vector_interval_get(traj, first_id + n_blocks, 3, 24, TNG_USE_HASH,
+                                           &values, &stride_length, &n_values_per_frame, &type),
+              TNG_SUCCESS);
+}
+
+TEST_F(WrittenTrajectoryTest, ParticleMappingTranslation)
+{
+    std::vector<int64_t> mapping(100);
+    int64_t              real, local;
+    ASSERT_EQ(tng_trajectory_init(&traj), TNG_SUCCESS);
+    ASSERT_EQ(tng_output_file_set(traj, filename), TNG_SUCCESS);
+    ASSERT_EQ(tng_frame_set_new(traj, 0, 10), TNG_SUCCESS);
+    // mapping blocks added out of order, the last one reversing its particles
+    for (int64_t first : { 200, 0, 100, 300 })
+    {
+        for (int64_t k = 0; k < 100; k++)
+        {
+            mapping[k] = first == 300 ? 399 - k : (first + 100) % 300 + k;
+        }
+        ASSERT_EQ(tng_particle_mapping_add(traj, first, 100, mapping.data()), TNG_SUCCESS);
+    }
+    for (int64_t local_nr = 0; local_nr < 400; local_nr++)
+    {
+        ASSERT_EQ(tng_particle_mapping_real_particle_get(traj, local_nr, &real), TNG_SUCCESS);
+        EXPECT_EQ(real, local_nr >= 300 ? 699 - local_nr : (local_nr + 100) % 300);
+        ASSERT_EQ(tng_particle_mapping_local_particle_get(traj, real, &local), TNG_SUCCESS);
+        EXPECT_EQ(local, local_nr);
+    }
+    EXPECT_EQ(tng_particle_mapping_real_particle_get(traj, 400, &real), TNG_FAILURE);
+    EXPECT_EQ(tng_particle_mapping_real_particle_get(traj, -1, &real), TNG_FAILURE);
+    EXPECT_EQ(tng_particle_mapping_local_particle_get(traj, 400, &local), TNG_FAILURE);
+
+    // without particle mappings the numbers are the same
+    ASSERT_EQ(tng_frame_set_particle_mapping_free(traj), TNG_SUCCESS);
+    EXPECT_EQ(tng_particle_mapping_real_particle_get(traj, 150, &real), TNG_SUCCESS);
+    EXPECT_EQ(real, 150);
+    EXPECT_EQ(tng_particle_mapping_local_particle_get(traj, 150, &local), TNG_SUCCESS);
+    EXPECT_EQ(local, 150);
+}
+
+TEST_F(WrittenTrajectoryTest, ParticleRangeTopology)
+{
+    tng_molecule_t       molecule;
+    tng_chain_t          chain;
+    tng_residue_t        residue;
+    tng_atom_t           atom;
+    std::vector<char>    names(13 * 8);
+    std::vector<int64_t> ids(13);
+    char                 name[8];
+    int64_t              id;
+    ASSERT_EQ(tng_trajectory_init(&traj), TNG_SUCCESS);
+    // 3 waters, no methane and 2 ions, each ion with two residues of one atom
+    tng_molecule_w_id_add(traj, "water", 1, &molecule);
+    tng_molecule_chain_w_id_add(traj, molecule, "W", 1, &chain);
+    tng_chain_residue_w_id_add(traj, chain, "WAT", 7, &residue);
+    tng_residue_atom_w_id_add(traj, residue, "O", "O", 1, &atom);
+    tng_residue_atom_w_id_add(traj, residue, "HO1", "H", 2, &atom);
+    tng_residue_atom_w_id_add(traj, residue, "HO2", "H", 3, &atom);
+    tng_molecule_cnt_set(traj, molecule, 3);
+    tng_molecule_w_id_add(traj, "methane", 2, &molecule);
+    tng_molecule_chain_w_id_add(traj, molecule, "M", 1, &chain);
+    tng_chain_residue_w_id_add(traj, chain, "MET", 1, &residue);
+    tng_residue_atom_w_id_add(traj, residue, "C", "C", 1, &atom);
+    tng_molecule_w_id_add(traj, "ion", 3, &molecule);
+    tng_molecule_chain_w_id_add(traj, molecule, "I", 1, &chain);
+    tng_chain_residue_w_id_add(traj, chain, "NA", 10, &residue);
+    tng_residue_atom_w_id_add(traj, residue, "NA", "Na", 1, &atom);
+    tng_chain_residue_w_id_add(traj, chain, "CL", 11, &residue);
+    tng_residue_atom_w_id_add(traj, residue, "CL", "Cl", 2, &atom);
+    tng_molecule_cnt_set(traj, molecule, 2);
+
+    EXPECT_EQ(tng_atom_name_of_particle_nr_get(traj, 10, name, sizeof(name)), TNG_SUCCESS);
+    EXPECT_STREQ(name, "CL");
+    EXPECT_EQ(tng_molecule_name_of_particle_nr_get(traj, 9, name, sizeof(name)), TNG_SUCCESS);
+    EXPECT_STREQ(name, "ion");
+    EXPECT_EQ(tng_global_residue_id_of_particle_nr_get(traj, 12, &id), TNG_SUCCESS);
+    EXPECT_EQ(id, 11 + 3 + 2);
+    EXPECT_EQ(tng_atom_name_of_particle_nr_get(traj, 13, name, sizeof(name)), TNG_FAILURE);
+
+    ASSERT_EQ(tng_particle_names_of_particle_range_get(traj, 0, 13, TNG_ATOM_NAME, names.data(), 8),
+              TNG_SUCCESS);
+    const char* atom_names[] = { "O", "HO1", "HO2", "O",  "HO1", "HO2", "O",
+                                 "HO1", "HO2", "NA", "CL", "NA",  "CL" };
+    for (int64_t i = 0; i < 13; i++)
+    {
+        EXPECT_STREQ(&names[i * 8], atom_names[i]);
+        EXPECT_EQ(tng_atom_type_of_particle_nr_get(traj, i, name, sizeof(name)), TNG_SUCCESS);
+        ASSERT_EQ(tng_particle_names_of_particle_range_get(traj, i, 1, TNG_ATOM_TYPE, names.data(),
+                                                           8),
+                  TNG_SUCCESS);
+        EXPECT_STREQ(names.data(), name);
+    }
+    ASSERT_EQ(
+            tng_particle_ids_of_particle_range_get(traj, 2, 11, TNG_GLOBAL_RESIDUE_ID, ids.data()),
+            TNG_SUCCESS);
+    const int64_t residue_ids[] = { 7, 8, 8, 8, 9, 9, 9, 13, 14, 15, 16 };
+    for (int64_t i = 0; i < 11; i++)
+    {
+        EXPECT_EQ(ids[i], residue_ids[i]);
+    }
+    EXPECT_EQ(tng_particle_ids_of_particle_range_get(traj, 2, 12, TNG_MOLECULE_ID, ids.data()),
+              TNG_FAILURE);
+
+    // the index follows changes of the molecule counts
+    tng_molecule_cnt_set(traj, molecule, 3);
+    EXPECT_EQ(tng_particle_ids_of_particle_range_get(traj, 2, 12, TNG_MOLECULE_ID, ids.data()),
+              TNG_SUCCESS);
+    EXPECT_EQ(ids[11], 3);
+}
+
+TEST(CompressionTest, BWLZHPositionsRoundTrip)
+{
+    // Mostly small steps with a few large ones give Huffman codes that need more than one lookup
+    const int           natoms = 200, nframes = 10;
+    std::vector<double> pos(natoms * nframes * 3), decoded(pos.size());
+    unsigned int        seed = 1;
+    for (size_t i = 0; i < pos.size(); i++)
+    {
+        seed     = seed * 1103515245U + 12345U;
+        int step = ((seed >> 16) % 64 == 0) ? (int)((seed >> 4) % 5000) : (int)((seed >> 16) % 3);
+        pos[i]   = 0.001 * step + (double)(i % 3);
+    }
+    int   algo[4] = { TNG_COMPRESS_ALGO_POS_BWLZH_INTRA, 0, TNG_COMPRESS_ALGO_POS_BWLZH_INTER, 0 };
+    int   nitems;
+    char* data = tng_compress_pos(pos.data(), natoms, nframes, 0.001, 5, algo, &nitems);
+    ASSERT_NE(data, nullptr);
+    EXPECT_EQ(tng_compress_uncompress(data, decoded.data()), 0);
+    for (size_t i = 0; i < pos.size(); i++)
+    {
+        EXPECT_NEAR(decoded[i], pos[i], 0.0005);
+    }
+    free(data);
+}
+
+TEST(CompressionTest, BWLZHPeriodicPositionsRoundTrip)
+{
+    // Constant and short repeating inputs are the worst case for the suffix sorting of the BWT
+    const int        natoms = 3000, nframes = 4;
+    const int        periods[] = { 1, 2, 5 };
+    std::vector<int> pos(natoms * nframes * 3), decoded(pos.size());
+    int algo[4] = { TNG_COMPRESS_ALGO_POS_BWLZH_INTRA, 0, TNG_COMPRESS_ALGO_POS_BWLZH_INTER, 0 };
+    for (int period : periods)
+    {
+        for (size_t i = 0; i < pos.size(); i++)
+        {
+            pos[i] = 1000 + 7 * (int)(i % period);
+        }
+        int           nitems;
+        unsigned long prec_hi, prec_lo;
+
+        char* data = tng_compress_pos_int(pos.data(), natoms, nframes, 0, 1000, 5, algo, &nitems);
+        ASSERT_NE(data, nullptr);
+        EXPECT_EQ(tng_compress_uncompress_int(data, decoded.data(), &prec_hi, &prec_lo), 0);
+        EXPECT_EQ(decoded, pos) << "period " << period;
+        free(data);
+    }
+}
+
+TEST(CompressionTest, BWLZHRepeatedMoleculesRoundTrip)
+{
+    // Identical molecules with occasional distortions give long repeats for the LZ77 stage
+    const int           natoms = 700, nframes = 8, molsize = 7;
+    std::vector<double> pos(natoms * nframes * 3), decoded(pos.size());
+    unsigned int        seed = 7;
+    for (size_t i = 0; i < pos.size(); i++)
+    {
+        seed     = seed * 1103515245U + 12345U;
+        int atom = (int)(i / 3) % natoms;
+        int step = (int)((atom % molsize) * 13 + (i % 3) * 5);
+        if ((seed >> 16) % 97 == 0)
+        {
+            step += (int)((seed >> 4) % 50);
+        }
+        pos[i] = 0.001 * step + 0.5 * (atom / molsize);
+    }
+    int   algo[4] = { TNG_COMPRESS_ALGO_POS_BWLZH_INTRA, 0, TNG_COMPRESS_ALGO_POS_BWLZH_INTER, 0 };
+    int   nitems;
+    char* data = tng_compress_pos(pos.data(), natoms, nframes, 0.001, 5, algo, &nitems);
+    ASSERT_NE(data, nullptr);
+    EXPECT_EQ(tng_compress_uncompress(data, decoded.data()), 0);
+    for (size_t i = 0; i < pos.size(); i++)
+    {
+        EXPECT_NEAR(decoded[i], pos[i], 0.0005);
+    }
+    free(data);
+}
+
+TEST(CompressionTest, PositionsTooLargeForPrecision)
+{
+    // A single value that does not fit in an int after quantisation makes compression fail
+    const int           natoms = 50, nframes = 3;
+    std::vector<double> pos(natoms * nframes * 3);
+    std::vector<float>  posf(pos.size());
+    for (size_t i = 0; i < pos.size(); i++)
+    {
+        pos[i]  = 0.01 * (double)i;
+        posf[i] = (float)pos[i];
+    }
+    pos[pos.size() / 2]  = 1e7;
+    posf[pos.size() / 2] = 1e7f;
+    int algo[4] = { -1, -1, -1, -1 };
+    int nitems;
+    EXPECT_EQ(tng_compress_pos(pos.data(), natoms, nframes, 0.001, 1, algo, &nitems), nullptr);
+    EXPECT_EQ(tng_compress_pos_float(posf.data(), natoms, nframes, 0.001f, 1, algo, &nitems), nullptr);
+}
@@ -90,9 +90,10 @@ int main(int argc, char** argv)
                                  fail) firstprivate(local_traj, local_positions, frame_set)    \
             shared(data_type, traj, n_frame_sets, particle_pos, particle, i, tot_n_frames) default(none)
     {
-        /* Each tng_trajectory_t keeps its own file pointers and i/o positions.
-         * Therefore there must be a copy for each thread. */
-        tng_trajectory_init_from_src(traj, &local_traj);
+        /* Each tng_trajectory_t keeps its own current frame set and i/o position.
+         * Therefore each thread uses a cursor, which shares the topology and the
+         * input file of traj. */
+        tng_trajectory_cursor_init(traj, &local_traj);
 #    pragma omp for
         for (i = 0; i < n_frame_sets; i++)
         {